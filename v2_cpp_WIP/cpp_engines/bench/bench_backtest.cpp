@@ -0,0 +1,59 @@
+/**
+ * Macro benchmark: BacktestEngine::run end to end on a generated chain (snapshot apply, strategy
+ * timers, matching, metrics). Peak RSS is process-wide, so run it alone for a clean figure:
+ *   otrader_bench --benchmark_filter=BM_BacktestRun
+ */
+
+#include "../core/engine_log.hpp"
+#include "../runtime/backtest/engine_backtest.hpp"
+#include "synthetic_chain.hpp"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <string>
+
+namespace bench {
+
+namespace {
+
+constexpr const char* kStrategy = "StraddleTestStrategy";
+
+/** args: option count, timesteps. Load is untimed; each iteration runs a freshly loaded engine. */
+void BM_BacktestRun(benchmark::State& state) {
+    const std::string path =
+        chain_parquet(chain_of(static_cast<size_t>(state.range(0)),
+                               static_cast<int>(state.range(1))));
+    int64_t timesteps = 0;
+    int64_t orders = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        backtest::BacktestEngine engine;
+        engine.main_engine()->set_log_level(engines::DISABLED);
+        engine.configure_execution(0.0);
+        engine.load_backtest_data(path, "SPX");
+        engine.add_strategy(kStrategy);
+        state.ResumeTiming();
+
+        const backtest::BacktestResult result = engine.run();
+        if (!result.errors.empty()) {
+            state.SkipWithError(result.errors.front().c_str());
+            return;
+        }
+        timesteps += result.processed_timesteps;
+        orders += result.total_orders;
+    }
+    state.counters["timesteps_per_s"] =
+        benchmark::Counter(static_cast<double>(timesteps), benchmark::Counter::kIsRate);
+    state.counters["orders"] =
+        benchmark::Counter(static_cast<double>(orders), benchmark::Counter::kAvgIterations);
+    state.counters["peak_rss_mb"] = static_cast<double>(peak_rss_bytes()) / (1024.0 * 1024.0);
+}
+BENCHMARK(BM_BacktestRun)
+    ->Args({1000, 390})
+    ->Args({5000, 390})
+    ->Args({20000, 390})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+} // namespace
+
+} // namespace bench
@@ -0,0 +1,85 @@
+/** Data path: parquet load, timestep iteration and snapshot building on a generated chain. */
+
+#include "../core/engine_log.hpp"
+#include "../infra/marketdata/engine_data_historical.hpp"
+#include "../runtime/backtest/engine_backtest.hpp"
+#include "../utilities/parquet_loader.hpp"
+#include "synthetic_chain.hpp"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <string>
+
+namespace bench {
+
+namespace {
+
+/** Generated chain of arg options over 390 one-minute bars. */
+auto chain_file(const benchmark::State& state) -> std::string {
+    return chain_parquet(chain_of(static_cast<size_t>(state.range(0))));
+}
+
+void BM_ParquetLoad(benchmark::State& state) {
+    const std::string path = chain_file(state);
+    int64_t rows = 0;
+    for (auto _ : state) {
+        backtest::ArrowParquetLoader loader;
+        if (!loader.load(path)) {
+            state.SkipWithError("load failed");
+            return;
+        }
+        rows = loader.get_meta().row_count;
+    }
+    state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_ParquetLoad)->Arg(1000)->Arg(5000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/** ArrowParquetLoader::iter_timesteps over a loaded file, reading every row's bid. */
+void BM_IterTimesteps(benchmark::State& state) {
+    backtest::ArrowParquetLoader loader;
+    if (!loader.load(chain_file(state))) {
+        state.SkipWithError("load failed");
+        return;
+    }
+    int64_t rows = 0;
+    for (auto _ : state) {
+        rows = 0;
+        double sum = 0.0;
+        loader.iter_timesteps([&](backtest::TimestepFrameColumnar const& frame) -> bool {
+            const auto* bid = static_cast<const arrow::DoubleArray*>(frame.arr_bid_px);
+            for (int64_t r = 0; r < frame.num_rows; ++r) {
+                sum += bid->Value(frame.row_index(r));
+            }
+            rows += frame.num_rows;
+            return true;
+        });
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_IterTimesteps)->Arg(1000)->Arg(5000)->Unit(benchmark::kMillisecond);
+
+/**
+ * load_backtest_data: parquet load plus portfolio build and one dense snapshot per timestep
+ * (build_snapshot_from_frame); subtract BM_ParquetLoad for the snapshot share.
+ */
+void BM_BuildSnapshots(benchmark::State& state) {
+    const std::string path = chain_file(state);
+    size_t snapshots = 0;
+    for (auto _ : state) {
+        backtest::BacktestEngine engine;
+        engine.main_engine()->set_log_level(engines::DISABLED);
+        engine.load_backtest_data(path, "SPX");
+        const backtest::BacktestDataEngine* data = engine.data_engine();
+        snapshots = data != nullptr ? data->get_precomputed_snapshot_count() : 0;
+    }
+    if (snapshots == 0) {
+        state.SkipWithError("no snapshots built");
+        return;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * snapshots));
+}
+BENCHMARK(BM_BuildSnapshots)->Arg(1000)->Arg(5000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+} // namespace
+
+} // namespace bench
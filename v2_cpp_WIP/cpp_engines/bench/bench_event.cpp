@@ -0,0 +1,53 @@
+/** Live EventEngine queue throughput: enqueue on the caller, drain on the worker thread. */
+
+#include "../runtime/live/engine_event.hpp"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bench {
+
+namespace {
+
+/**
+ * arg Trade events put per iteration, then wait until the worker dispatched them. No MainEngine,
+ * so dispatch stops at process(): this measures the rings, lanes and wakeups only.
+ */
+void BM_LiveEventThroughput(benchmark::State& state) {
+    engines::EventEngine engine(nullptr);
+    engine.start();
+    const auto batch = static_cast<size_t>(state.range(0));
+    std::vector<utilities::Event> events;
+    events.reserve(batch);
+    for (size_t i = 0; i < batch; ++i) {
+        utilities::TradeData trade;
+        trade.symbol = "SPX-20250110-CALL-5000-100";
+        trade.orderid = "bench.order." + std::to_string(i);
+        trade.tradeid = "bench.trade." + std::to_string(i);
+        trade.volume = 1.0;
+        events.emplace_back(utilities::EventType::Trade, std::move(trade));
+    }
+    uint64_t target = 0;
+    for (auto _ : state) {
+        for (const utilities::Event& event : events) {
+            engine.put(event);
+        }
+        target += batch;
+        while (engine.queue_stats().dispatched < target) {
+            std::this_thread::yield();
+        }
+    }
+    const engines::EventQueueStats stats = engine.queue_stats();
+    engine.stop();
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * batch));
+    state.counters["latency_avg_ns"] = static_cast<double>(stats.latency_avg_ns);
+    state.counters["latency_max_ns"] = static_cast<double>(stats.latency_max_ns);
+    state.counters["full_waits"] = static_cast<double>(stats.full_waits);
+}
+BENCHMARK(BM_LiveEventThroughput)->Arg(64)->Arg(1024)->Arg(16384)->UseRealTime();
+
+} // namespace
+
+} // namespace bench
@@ -0,0 +1,120 @@
+/** Pricing hot paths: scalar BS Greeks / IV, PortfolioData::apply_frame, PositionEngine metrics. */
+
+#include "../core/engine_position.hpp"
+#include "../utilities/black_scholes.hpp"
+#include "synthetic_chain.hpp"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+namespace {
+
+constexpr size_t kLanes = 1024;
+
+/** kLanes options around the money, with their model prices at zero rate (IV convention). */
+struct PricingInputs {
+    std::vector<double> strike, tau, sigma, price;
+    std::vector<uint8_t> is_call;
+    double spot = 5000.0;
+
+    PricingInputs() : strike(kLanes), tau(kLanes), sigma(kLanes), price(kLanes), is_call(kLanes) {
+        std::vector<double> spots(kLanes, spot);
+        std::vector<double> vega(kLanes);
+        for (size_t i = 0; i < kLanes; ++i) {
+            strike[i] = spot * (0.8 + (0.4 * static_cast<double>(i) / kLanes));
+            tau[i] = (1.0 + static_cast<double>(i % 60)) / 365.0;
+            sigma[i] = 0.12 + (0.001 * static_cast<double>(i % 100));
+            is_call[i] = strike[i] >= spot ? 1 : 0;
+        }
+        utilities::bs_price_vega_batch(
+            {.spot = spots, .strike = strike, .tau = tau, .sigma = sigma, .is_call = is_call},
+            price, vega);
+    }
+};
+
+void BM_BsGreeks(benchmark::State& state) {
+    const PricingInputs in;
+    for (auto _ : state) {
+        for (size_t i = 0; i < kLanes; ++i) {
+            benchmark::DoNotOptimize(utilities::bs_greeks(in.is_call[i] != 0, in.spot,
+                                                          in.strike[i], in.tau[i], 0.05,
+                                                          in.sigma[i]));
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kLanes));
+}
+BENCHMARK(BM_BsGreeks);
+
+void BM_ImpliedVolatility(benchmark::State& state) {
+    const PricingInputs in;
+    for (auto _ : state) {
+        for (size_t i = 0; i < kLanes; ++i) {
+            benchmark::DoNotOptimize(utilities::implied_volatility_from_price(
+                in.price[i], in.spot, in.strike[i], in.tau[i], in.is_call[i] != 0));
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kLanes));
+}
+BENCHMARK(BM_ImpliedVolatility);
+
+/**
+ * Full apply_frame (IV solve, Greeks, publish) alternating between two consecutive bars so
+ * every frame moves the quotes; arg = option count.
+ */
+void BM_ApplyFrame(benchmark::State& state) {
+    const ChainSpec spec = chain_of(static_cast<size_t>(state.range(0)), 2);
+    const std::unique_ptr<utilities::PortfolioData> portfolio = make_portfolio(spec);
+    const ChainQuotes quotes = make_quotes(spec, *portfolio);
+    const utilities::PortfolioSnapshot frames[2] = {make_snapshot(*portfolio, quotes, 0),
+                                                    make_snapshot(*portfolio, quotes, 1)};
+    size_t step = 0;
+    for (auto _ : state) {
+        portfolio->apply_frame(frames[step++ & 1]);
+    }
+    const size_t options = portfolio->option_apply_order().size();
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * options));
+    state.counters["options"] = static_cast<double>(options);
+}
+BENCHMARK(BM_ApplyFrame)->Arg(1000)->Arg(5000)->Arg(20000)->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+/**
+ * update_metrics over a holding of arg single-leg positions, full revaluation every call (the
+ * incremental path's worst case: every slot changed).
+ */
+void BM_UpdateMetrics(benchmark::State& state) {
+    const ChainSpec spec = chain_of(5000, 1);
+    const std::unique_ptr<utilities::PortfolioData> portfolio = make_portfolio(spec);
+    portfolio->apply_frame(make_snapshot(*portfolio, make_quotes(spec, *portfolio), 0));
+
+    const std::string strategy = "bench";
+    engines::PositionEngine positions;
+    positions.set_full_revalue_interval(1);
+    const std::vector<utilities::OptionData*>& order = portfolio->option_apply_order();
+    const auto n = std::min(static_cast<size_t>(state.range(0)), order.size());
+    for (size_t i = 0; i < n; ++i) {
+        utilities::TradeData trade;
+        trade.symbol = order[i]->symbol;
+        trade.orderid = "bench.order." + std::to_string(i);
+        trade.tradeid = "bench.trade." + std::to_string(i);
+        trade.direction = i % 2 == 0 ? utilities::Direction::LONG : utilities::Direction::SHORT;
+        trade.price = order[i]->mid_price();
+        trade.volume = 1.0;
+        positions.process_trade(strategy, trade);
+    }
+    for (auto _ : state) {
+        positions.update_metrics(strategy, portfolio.get());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n));
+}
+BENCHMARK(BM_UpdateMetrics)->Arg(10)->Arg(100)->Arg(1000);
+
+} // namespace
+
+} // namespace bench
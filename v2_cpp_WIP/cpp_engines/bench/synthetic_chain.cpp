@@ -0,0 +1,277 @@
+#include "synthetic_chain.hpp"
+#include "../utilities/black_scholes.hpp"
+#include <algorithm>
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <cmath>
+#include <ctime>
+#include <filesystem>
+#include <format>
+#include <parquet/arrow/writer.h>
+#include <random>
+#include <stdexcept>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace bench {
+
+namespace {
+
+using utilities::DateTime;
+
+/** Monday 2025-01-06 14:30 UTC (US open). */
+auto session_start() -> DateTime {
+    std::tm tm_utc{};
+    tm_utc.tm_year = 2025 - 1900;
+    tm_utc.tm_mon = 0;
+    tm_utc.tm_mday = 6;
+    tm_utc.tm_hour = 14;
+    tm_utc.tm_min = 30;
+#ifdef _WIN32
+    return std::chrono::system_clock::from_time_t(_mkgmtime(&tm_utc));
+#else
+    return std::chrono::system_clock::from_time_t(timegm(&tm_utc));
+#endif
+}
+
+/** Friday expiries at 21:00 UTC (16:00 ET), like parse_occ_symbol. */
+auto expiry_of(int k) -> DateTime {
+    using namespace std::chrono;
+    return session_start() + days(4 + (7 * k)) + hours(6) + minutes(30);
+}
+
+/** OCC symbol without root, e.g. "250110C05000000". */
+auto occ_symbol(DateTime expiry, double strike, bool call) -> std::string {
+    const std::chrono::year_month_day ymd{std::chrono::floor<std::chrono::days>(expiry)};
+    return std::format("{:02}{:02}{:02}{}{:08}", static_cast<int>(ymd.year()) % 100,
+                       static_cast<unsigned>(ymd.month()), static_cast<unsigned>(ymd.day()),
+                       call ? 'C' : 'P', std::lround(strike * 1000.0));
+}
+
+void check(const arrow::Status& st, std::string const& what) {
+    if (!st.ok()) {
+        throw std::runtime_error(what + ": " + st.ToString());
+    }
+}
+
+} // namespace
+
+auto chain_of(size_t n_options, int timesteps) -> ChainSpec {
+    ChainSpec spec;
+    spec.strikes = std::max(1, static_cast<int>(n_options / (2 * spec.expiries)));
+    spec.timesteps = timesteps;
+    return spec;
+}
+
+auto make_portfolio(ChainSpec const& spec) -> std::unique_ptr<utilities::PortfolioData> {
+    auto portfolio = std::make_unique<utilities::PortfolioData>("bench");
+    portfolio->set_dte_ref(std::chrono::floor<std::chrono::days>(session_start()));
+
+    utilities::ContractData underlying;
+    underlying.gateway_name = "Bench";
+    underlying.symbol = spec.underlying;
+    underlying.name = spec.underlying;
+    underlying.product = utilities::Product::INDEX;
+    portfolio->set_underlying(underlying);
+
+    portfolio->reserve_options(spec.option_count());
+    const double lowest = spec.spot - (spec.strike_step * (spec.strikes / 2));
+    for (int e = 0; e < spec.expiries; ++e) {
+        const DateTime expiry = expiry_of(e);
+        const std::string expiry_str = occ_symbol(expiry, 0.0, true).substr(0, 6);
+        for (int s = 0; s < spec.strikes; ++s) {
+            const double strike = lowest + (spec.strike_step * s);
+            for (const bool call : {true, false}) {
+                utilities::ContractData contract;
+                contract.gateway_name = "Bench";
+                contract.symbol = std::format("{}-20{}-{}-{}-100", spec.underlying, expiry_str,
+                                              call ? "CALL" : "PUT", static_cast<int>(strike));
+                contract.name = occ_symbol(expiry, strike, call);
+                contract.product = utilities::Product::OPTION;
+                contract.size = 100.0;
+                contract.option_strike = strike;
+                contract.option_type = call ? utilities::OptionType::CALL
+                                            : utilities::OptionType::PUT;
+                contract.option_expiry = expiry;
+                contract.option_underlying = spec.underlying;
+                contract.option_index = std::to_string(static_cast<int>(strike));
+                portfolio->add_option(contract);
+            }
+        }
+    }
+    portfolio->finalize_chains();
+    return portfolio;
+}
+
+auto make_quotes(ChainSpec const& spec, utilities::PortfolioData const& portfolio) -> ChainQuotes {
+    const std::vector<utilities::OptionData*>& order = portfolio.option_apply_order();
+    const size_t n = order.size();
+    std::vector<double> strike(n);
+    std::vector<double> sigma(n);
+    std::vector<uint8_t> is_call(n);
+    for (size_t i = 0; i < n; ++i) {
+        strike[i] = order[i]->strike_price.value_or(0.0);
+        is_call[i] = order[i]->option_type > 0 ? 1 : 0;
+    }
+
+    ChainQuotes quotes;
+    quotes.times.resize(spec.timesteps);
+    quotes.spot.resize(spec.timesteps);
+    quotes.bid.assign(spec.timesteps, std::vector<double>(n));
+    quotes.ask.assign(spec.timesteps, std::vector<double>(n));
+
+    std::mt19937_64 rng(spec.seed);
+    std::normal_distribution<double> shock(0.0, 1.0);
+    const double dt_years = static_cast<double>(spec.step.count()) / (252.0 * 6.5 * 3600.0);
+    std::vector<double> spot(n);
+    std::vector<double> tau(n);
+    std::vector<double> price(n);
+    std::vector<double> vega(n);
+    double s = spec.spot;
+    for (int t = 0; t < spec.timesteps; ++t) {
+        const DateTime now = session_start() + (spec.step * t);
+        if (t > 0) {
+            s *= std::exp(spec.vol * std::sqrt(dt_years) * shock(rng));
+        }
+        quotes.times[t] = now;
+        quotes.spot[t] = s;
+        for (size_t i = 0; i < n; ++i) {
+            const double m = std::log(strike[i] / s);
+            spot[i] = s;
+            tau[i] = utilities::years_to_expiry(now, order[i]->option_expiry);
+            sigma[i] = spec.vol - (0.05 * m) + (0.1 * m * m);
+        }
+        utilities::bs_price_vega_batch({.spot = spot,
+                                        .strike = strike,
+                                        .tau = tau,
+                                        .sigma = sigma,
+                                        .is_call = is_call,
+                                        .risk_free_rate = portfolio.risk_free_rate_},
+                                       price, vega);
+        for (size_t i = 0; i < n; ++i) {
+            const double half_spread = std::max(0.05, 0.01 * price[i]);
+            // Nickel ticks, rounded away from the model price.
+            quotes.bid[t][i] = std::max(0.0, std::floor((price[i] - half_spread) * 20.0) / 20.0);
+            quotes.ask[t][i] = std::ceil((price[i] + half_spread) * 20.0) / 20.0;
+        }
+    }
+    return quotes;
+}
+
+auto make_snapshot(utilities::PortfolioData const& portfolio, ChainQuotes const& quotes,
+                   size_t step) -> utilities::PortfolioSnapshot {
+    utilities::PortfolioSnapshot snapshot;
+    snapshot.portfolio_name = portfolio.name;
+    snapshot.datetime = quotes.times[step];
+    snapshot.underlying_bid = quotes.spot[step] - 0.05;
+    snapshot.underlying_ask = quotes.spot[step] + 0.05;
+    snapshot.underlying_last = quotes.spot[step];
+    snapshot.bid = quotes.bid[step];
+    snapshot.ask = quotes.ask[step];
+    snapshot.last.resize(snapshot.bid.size());
+    for (size_t i = 0; i < snapshot.last.size(); ++i) {
+        snapshot.last[i] = (snapshot.bid[i] + snapshot.ask[i]) / 2.0;
+    }
+    return snapshot;
+}
+
+auto chain_parquet(ChainSpec const& spec) -> std::string {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "otrader_bench";
+    std::filesystem::create_directories(dir);
+    const std::filesystem::path path =
+        dir / std::format("backtest_{}_{}x{}_{}_{}.parquet", spec.underlying, spec.expiries,
+                          spec.strikes, spec.timesteps, spec.seed);
+    if (std::filesystem::exists(path)) {
+        return path.string();
+    }
+
+    const std::unique_ptr<utilities::PortfolioData> portfolio = make_portfolio(spec);
+    const ChainQuotes quotes = make_quotes(spec, *portfolio);
+    const std::vector<utilities::OptionData*>& order = portfolio->option_apply_order();
+    std::vector<std::string> symbols;
+    symbols.reserve(order.size());
+    for (const utilities::OptionData* option : order) {
+        symbols.push_back(occ_symbol(option->option_expiry.value(),
+                                     option->strike_price.value_or(0.0), option->option_type > 0));
+    }
+
+    arrow::TimestampBuilder ts(arrow::timestamp(arrow::TimeUnit::NANO, "UTC"),
+                               arrow::default_memory_pool());
+    arrow::StringBuilder symbol;
+    arrow::DoubleBuilder bid_px;
+    arrow::DoubleBuilder ask_px;
+    arrow::Int64Builder bid_sz;
+    arrow::Int64Builder ask_sz;
+    arrow::DoubleBuilder underlying_bid_px;
+    arrow::DoubleBuilder underlying_ask_px;
+    arrow::Int64Builder underlying_bid_sz;
+    arrow::Int64Builder underlying_ask_sz;
+    std::mt19937_64 rng(spec.seed + 1);
+    std::uniform_int_distribution<int64_t> size(1, 200);
+    for (size_t t = 0; t < quotes.times.size(); ++t) {
+        const int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               quotes.times[t].time_since_epoch())
+                               .count();
+        for (size_t i = 0; i < order.size(); ++i) {
+            check(ts.Append(ns), path.string());
+            check(symbol.Append(symbols[i]), path.string());
+            check(bid_px.Append(quotes.bid[t][i]), path.string());
+            check(ask_px.Append(quotes.ask[t][i]), path.string());
+            check(bid_sz.Append(size(rng)), path.string());
+            check(ask_sz.Append(size(rng)), path.string());
+            check(underlying_bid_px.Append(quotes.spot[t] - 0.05), path.string());
+            check(underlying_ask_px.Append(quotes.spot[t] + 0.05), path.string());
+            check(underlying_bid_sz.Append(size(rng)), path.string());
+            check(underlying_ask_sz.Append(size(rng)), path.string());
+        }
+    }
+
+    std::vector<std::shared_ptr<arrow::Array>> columns;
+    for (arrow::ArrayBuilder* builder :
+         std::initializer_list<arrow::ArrayBuilder*>{
+             &ts, &symbol, &bid_px, &ask_px, &bid_sz, &ask_sz, &underlying_bid_px,
+             &underlying_ask_px, &underlying_bid_sz, &underlying_ask_sz}) {
+        std::shared_ptr<arrow::Array> column;
+        check(builder->Finish(&column), path.string());
+        columns.push_back(std::move(column));
+    }
+    const auto f64 = arrow::float64();
+    const auto i64 = arrow::int64();
+    const auto schema = arrow::schema(
+        {arrow::field("ts_recv", arrow::timestamp(arrow::TimeUnit::NANO, "UTC")),
+         arrow::field("symbol", arrow::utf8()), arrow::field("bid_px", f64),
+         arrow::field("ask_px", f64), arrow::field("bid_sz", i64), arrow::field("ask_sz", i64),
+         arrow::field("underlying_bid_px", f64), arrow::field("underlying_ask_px", f64),
+         arrow::field("underlying_bid_sz", i64), arrow::field("underlying_ask_sz", i64)});
+    const auto table = arrow::Table::Make(schema, columns);
+
+    // Written to a temp name first so an interrupted run never leaves a truncated file behind.
+    const std::filesystem::path tmp = path.string() + ".tmp";
+    auto out = arrow::io::FileOutputStream::Open(tmp.string());
+    check(out.status(), tmp.string());
+    check(parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), *out, 128 * 1024),
+          tmp.string());
+    check((*out)->Close(), tmp.string());
+    std::filesystem::rename(tmp, path);
+    return path.string();
+}
+
+auto peak_rss_bytes() -> size_t {
+#ifdef _WIN32
+    return 0;
+#else
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    // ru_maxrss is in kilobytes on Linux (bytes on macOS).
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+} // namespace bench
@@ -0,0 +1,65 @@
+#pragma once
+
+/**
+ * Synthetic option chains for otrader_bench: in-memory portfolios, dense snapshots and backtest
+ * parquet files generated from one deterministic model (Black-Scholes quotes around a spot on a
+ * seeded random walk), so every benchmark sees the same market at a given size.
+ */
+
+#include "../utilities/object.hpp"
+#include "../utilities/portfolio.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+struct ChainSpec {
+    std::string underlying = "SPX";
+    /** Weekly expiries from the first timestamp; calls and puts at every strike. */
+    int expiries = 4;
+    int strikes = 125;
+    double strike_step = 5.0;
+    double spot = 5000.0;
+    double vol = 0.18;
+    int timesteps = 390;
+    std::chrono::seconds step{60};
+    uint64_t seed = 42;
+
+    [[nodiscard]] size_t option_count() const {
+        return static_cast<size_t>(expiries) * static_cast<size_t>(strikes) * 2;
+    }
+};
+
+/** Spec with about n options (4 expiries, strikes centred on the spot). */
+ChainSpec chain_of(size_t n_options, int timesteps = 390);
+
+/** Portfolio "bench" holding every option of spec, chains finalized. */
+std::unique_ptr<utilities::PortfolioData> make_portfolio(ChainSpec const& spec);
+
+/** Quotes of every step: spot and per-option bid/ask in option_apply_order of make_portfolio. */
+struct ChainQuotes {
+    std::vector<utilities::DateTime> times;
+    std::vector<double> spot;
+    /** [step][slot] */
+    std::vector<std::vector<double>> bid, ask;
+};
+ChainQuotes make_quotes(ChainSpec const& spec, utilities::PortfolioData const& portfolio);
+
+/** Dense snapshot of step for portfolio. */
+utilities::PortfolioSnapshot make_snapshot(utilities::PortfolioData const& portfolio,
+                                           ChainQuotes const& quotes, size_t step);
+
+/**
+ * Backtest parquet of spec (ts_recv, symbol in OCC form, bid/ask px and sz, underlying px and
+ * sz), written once under the temp directory and reused; returns its path.
+ */
+std::string chain_parquet(ChainSpec const& spec);
+
+/** Peak resident set size of this process in bytes (0 where not available). */
+size_t peak_rss_bytes();
+
+} // namespace bench
@@ -4,6 +4,7 @@
 
 #include "engine_combo_builder.hpp"
 #include <algorithm>
+#include <mutex>
 #include <ranges>
 #include <span>
 #include <sstream>
@@ -11,15 +12,21 @@
 
 namespace engines {
 
+auto combo_error_name(ComboError error) -> std::string_view {
+    switch (error) {
+        case ComboError::NONE: return "none";
+        case ComboError::LEG_COUNT: return "leg count does not match the combo template";
+        case ComboError::MISSING_OPTION: return "missing option";
+        case ComboError::MISSING_CONTRACT: return "contract not found";
+    }
+    return "unknown";
+}
+
 auto ComboBuilderEngine::create_leg(const utilities::OptionData& option,
     utilities::Direction direction, int volume, std::optional<double> price,
     const ComboGetContractFn& get_contract_fn) -> utilities::Leg {
-    const utilities::ContractData* contract = nullptr;
-    if (get_contract_fn) {
-        contract = get_contract_fn(option.symbol);
-    } else if (current_get_contract_) {
-        contract = current_get_contract_(option.symbol);
-}
+    const utilities::ContractData* contract =
+        get_contract_fn ? get_contract_fn(option.symbol) : nullptr;
     if (contract == nullptr) {
         throw std::runtime_error("Contract not found for option: " + option.symbol);
     }
@@ -35,246 +42,136 @@ auto ComboBuilderEngine::create_leg(const utilities::OptionData& option,
     return leg;
 }
 
-auto ComboBuilderEngine::combo_builder(
-    const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-    utilities::ComboType combo_type, utilities::Direction direction, int volume,
-    ComboGetContractFn get_contract_fn, std::vector<utilities::LogData>* out_logs) -> std::pair<std::vector<utilities::Leg>, std::string> {
-    current_get_contract_ = std::move(get_contract_fn);
-    current_out_logs_ = out_logs;
-    auto result = combo_builder_impl(option_data, combo_type, direction, volume);
-    current_get_contract_ = nullptr;
-    current_out_logs_ = nullptr;
-    return result;
-}
-
-auto ComboBuilderEngine::combo_builder_impl(
-    const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-    utilities::ComboType combo_type, utilities::Direction direction, int volume) -> std::pair<std::vector<utilities::Leg>, std::string> {
-    switch (combo_type) {
-        case utilities::ComboType::SINGLE_LEG: return single_leg(option_data, direction, volume);
-        case utilities::ComboType::STRADDLE: return straddle(option_data, direction, volume);
-        case utilities::ComboType::STRANGLE: return strangle(option_data, direction, volume);
-        case utilities::ComboType::IRON_CONDOR: return iron_condor(option_data, direction, volume);
-        case utilities::ComboType::RISK_REVERSAL: return risk_reversal(option_data, direction, volume);
-        case utilities::ComboType::SPREAD: return spread(option_data, direction, volume);
-        case utilities::ComboType::DIAGONAL_SPREAD: return diagonal_spread(option_data, direction, volume);
-        case utilities::ComboType::RATIO_SPREAD: return ratio_spread(option_data, direction, volume);
-        case utilities::ComboType::BUTTERFLY: return butterfly(option_data, direction, volume);
-        case utilities::ComboType::INVERSE_BUTTERFLY: return inverse_butterfly(option_data, direction, volume);
-        case utilities::ComboType::IRON_BUTTERFLY: return iron_butterfly(option_data, direction, volume);
-        case utilities::ComboType::CONDOR: return condor(option_data, direction, volume);
-        case utilities::ComboType::BOX_SPREAD: return box_spread(option_data, direction, volume);
-        case utilities::ComboType::CUSTOM: return custom(option_data, direction, volume);
-        default: throw std::runtime_error("Unsupported combo type");
+auto ComboBuilderEngine::LegSetHash::operator()(const LegSetKey& key) const -> size_t {
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < key.size; ++i) {
+        h = (h ^ key.ids[i]) * 1099511628211ULL;
     }
+    return static_cast<size_t>(h);
 }
 
-auto ComboBuilderEngine::single_leg(
-    const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-    utilities::Direction direction, int volume) -> std::pair<std::vector<utilities::Leg>, std::string> {
-    if (option_data.size() != 1U) {
-        throw std::runtime_error("single_leg requires exactly one option");
+auto ComboBuilderEngine::leg_set(const LegSetKey& key,
+    std::span<const utilities::OptionData* const> options,
+    const ComboGetContractFn& get_contract_fn) -> const LegSet* {
+    {
+        std::shared_lock lock(cache_mutex_);
+        auto it = cache_.find(key);
+        if (it != cache_.end()) {
+            return &it->second;
+        }
     }
-    auto it = option_data.begin();
-    std::vector<utilities::Leg> legs = { create_leg(*it->second, direction, volume) };
-    return {legs, generate_combo_signature(legs)};
-}
-
-auto ComboBuilderEngine::straddle(
-    const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-    utilities::Direction direction, int volume) -> std::pair<std::vector<utilities::Leg>, std::string> {
-    auto it_c = option_data.find("call");
-    auto it_p = option_data.find("put");
-    if (it_c == option_data.end() || it_p == option_data.end()) {
-        throw std::runtime_error("straddle requires 'call' and 'put'");
-}
-    std::vector<utilities::Leg> legs = {
-        create_leg(*it_c->second, direction, volume),
-        create_leg(*it_p->second, direction, volume)
-    };
-    return {legs, generate_combo_signature(legs)};
-}
-
-auto ComboBuilderEngine::strangle(
-    const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-    utilities::Direction direction, int volume) -> std::pair<std::vector<utilities::Leg>, std::string> {
-    auto it_c = option_data.find("call");
-    auto it_p = option_data.find("put");
-    if (it_c == option_data.end() || it_p == option_data.end()) {
-        throw std::runtime_error("strangle requires 'call' and 'put'");
-}
-    std::vector<utilities::Leg> legs = {
-        create_leg(*it_c->second, direction, volume),
-        create_leg(*it_p->second, direction, volume)
-    };
-    return {legs, generate_combo_signature(legs)};
-}
-
-auto ComboBuilderEngine::iron_condor(
-    const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-    utilities::Direction direction, int volume) -> std::pair<std::vector<utilities::Leg>, std::string> {
-    int sign = (direction == utilities::Direction::SHORT) ? 1 : -1;
-    auto *pl = option_data.at("put_lower");
-    auto *pu = option_data.at("put_upper");
-    auto *cl = option_data.at("call_lower");
-    auto *cu = option_data.at("call_upper");
-    std::vector<utilities::Leg> legs = {
-        create_leg(*pl, sign > 0 ? utilities::Direction::LONG : utilities::Direction::SHORT, volume),
-        create_leg(*pu, sign > 0 ? utilities::Direction::SHORT : utilities::Direction::LONG, volume),
-        create_leg(*cl, sign > 0 ? utilities::Direction::SHORT : utilities::Direction::LONG, volume),
-        create_leg(*cu, sign > 0 ? utilities::Direction::LONG : utilities::Direction::SHORT, volume),
-    };
-    return {legs, generate_combo_signature(legs)};
-}
-
-auto ComboBuilderEngine::risk_reversal(
-    const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-    utilities::Direction direction, int volume) -> std::pair<std::vector<utilities::Leg>, std::string> {
-    int sign = (direction == utilities::Direction::SHORT) ? 1 : -1;
-    auto *ll = option_data.at("long_leg");
-    auto *sl = option_data.at("short_leg");
-    std::vector<utilities::Leg> legs = {
-        create_leg(*ll, sign > 0 ? utilities::Direction::LONG : utilities::Direction::SHORT, volume),
-        create_leg(*sl, sign > 0 ? utilities::Direction::SHORT : utilities::Direction::LONG, volume),
-    };
-    return {legs, generate_combo_signature(legs)};
+    LegSet set;
+    set.legs.reserve(options.size());
+    for (const utilities::OptionData* option : options) {
+        const utilities::ContractData* contract =
+            get_contract_fn ? get_contract_fn(option->symbol) : nullptr;
+        if (contract == nullptr) {
+            return nullptr;
+        }
+        utilities::Leg& leg = set.legs.emplace_back();
+        leg.con_id = contract->con_id.value_or(0);
+        leg.symbol = contract->symbol;
+        leg.exchange = contract->exchange;
+        leg.gateway_name = "IB";
+        leg.trading_class = contract->trading_class;
+    }
+    set.signature = generate_combo_signature(set.legs);
+    std::unique_lock lock(cache_mutex_);
+    // Values are node-stable: the pointer survives later inserts (until clear_cache).
+    return &cache_.try_emplace(key, std::move(set)).first->second;
+}
+
+auto ComboBuilderEngine::build(utilities::ComboType combo_type,
+    std::span<const utilities::OptionData* const> options, utilities::Direction direction,
+    int volume, const ComboGetContractFn& get_contract_fn, ComboOrder& out) -> bool {
+    out.size = 0;
+    out.signature = nullptr;
+    const ComboTemplate tpl = combo_template(combo_type);
+    const bool fixed = tpl.count != 0;
+    if (options.empty() || options.size() > kMaxComboLegs ||
+        (fixed && options.size() != tpl.count)) {
+        out.error = ComboError::LEG_COUNT;
+        return false;
+    }
+    LegSetKey key;
+    key.size = options.size();
+    for (size_t i = 0; i < options.size(); ++i) {
+        if (options[i] == nullptr) {
+            out.error = ComboError::MISSING_OPTION;
+            return false;
+        }
+        key.ids[i] = options[i]->symbol_id != utilities::kNoSymbol
+                         ? options[i]->symbol_id
+                         : utilities::intern_symbol(options[i]->symbol);
+    }
+    const LegSet* set = leg_set(key, options, get_contract_fn);
+    if (set == nullptr) {
+        out.error = ComboError::MISSING_CONTRACT;
+        return false;
+    }
+    for (size_t i = 0; i < key.size; ++i) {
+        const ComboLegSpec spec = fixed ? tpl.legs[i] : ComboLegSpec{};
+        utilities::Leg& leg = out.legs[i];
+        leg = set->legs[i];
+        leg.direction = leg_direction(tpl, spec, direction);
+        leg.ratio = volume * spec.ratio;
+    }
+    out.size = key.size;
+    out.signature = &set->signature;
+    out.error = ComboError::NONE;
+    return true;
 }
 
-auto ComboBuilderEngine::custom(
+auto ComboBuilderEngine::combo_builder(
     const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-    utilities::Direction direction, int volume) -> std::pair<std::vector<utilities::Leg>, std::string> {
-    std::vector<utilities::Leg> legs;
-    for (const auto& kv : option_data) {
-        legs.push_back(create_leg(*kv.second, direction, volume));
-        if (current_out_logs_ != nullptr) {
+    utilities::ComboType combo_type, utilities::Direction direction, int volume,
+    ComboGetContractFn get_contract_fn, std::vector<utilities::LogData>* out_logs)
+    -> std::pair<std::vector<utilities::Leg>, std::string> {
+    const ComboTemplate tpl = combo_template(combo_type);
+    const std::string name = utilities::to_string(combo_type);
+    std::array<const utilities::OptionData*, kMaxComboLegs> options{};
+    size_t count = 0;
+    if (tpl.count == 0 || combo_type == utilities::ComboType::SINGLE_LEG) {
+        if (option_data.size() > kMaxComboLegs || (tpl.count != 0 && option_data.size() != 1U)) {
+            throw std::runtime_error(name + ": " +
+                                     std::string(combo_error_name(ComboError::LEG_COUNT)));
+        }
+        for (const auto& kv : option_data) {
+            options[count++] = kv.second;
+        }
+    } else {
+        for (size_t i = 0; i < tpl.count; ++i) {
+            auto it = option_data.find(std::string(tpl.legs[i].role));
+            if (it == option_data.end()) {
+                throw std::runtime_error(name + " requires '" + std::string(tpl.legs[i].role) +
+                                         "'");
+            }
+            options[count++] = it->second;
+        }
+    }
+    ComboOrder order;
+    if (!build(combo_type, std::span(options.data(), count), direction, volume, get_contract_fn,
+               order)) {
+        throw std::runtime_error(name + ": " + std::string(combo_error_name(order.error)));
+    }
+    if (combo_type == utilities::ComboType::CUSTOM && out_logs != nullptr) {
+        for (const utilities::Leg& leg : order.leg_span()) {
             utilities::LogData log;
-            log.msg = "Custom Combo Leg: " + legs.back().symbol.value_or("") +
-                " | Direction: " + std::to_string(static_cast<int>(direction)) + " | Volume: " + std::to_string(legs.back().ratio);
+            log.msg = "Custom Combo Leg: " + leg.symbol.value_or("") +
+                " | Direction: " + std::to_string(static_cast<int>(direction)) +
+                " | Volume: " + std::to_string(leg.ratio);
             log.level = 10;
             log.gateway_name = "Combo";
-            current_out_logs_->push_back(log);
+            out_logs->push_back(log);
         }
     }
-    return {legs, generate_combo_signature(legs)};
-}
-
-auto ComboBuilderEngine::spread(
-    const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-    utilities::Direction direction, int volume) -> std::pair<std::vector<utilities::Leg>, std::string> {
-    int sign = (direction == utilities::Direction::LONG) ? 1 : -1;
-    auto *ll = option_data.at("long_leg");
-    auto *sl = option_data.at("short_leg");
-    std::vector<utilities::Leg> legs = {
-        create_leg(*ll, sign > 0 ? utilities::Direction::LONG : utilities::Direction::SHORT, volume),
-        create_leg(*sl, sign > 0 ? utilities::Direction::SHORT : utilities::Direction::LONG, volume),
-    };
-    return {legs, generate_combo_signature(legs)};
+    auto legs = order.leg_span();
+    return {std::vector<utilities::Leg>(legs.begin(), legs.end()), *order.signature};
 }
 
-auto ComboBuilderEngine::diagonal_spread(
-    const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-    utilities::Direction direction, int volume) -> std::pair<std::vector<utilities::Leg>, std::string> {
-    int sign = (direction == utilities::Direction::LONG) ? 1 : -1;
-    auto *ll = option_data.at("long_leg");
-    auto *sl = option_data.at("short_leg");
-    std::vector<utilities::Leg> legs = {
-        create_leg(*ll, sign > 0 ? utilities::Direction::LONG : utilities::Direction::SHORT, volume),
-        create_leg(*sl, sign > 0 ? utilities::Direction::SHORT : utilities::Direction::LONG, volume),
-    };
-    return {legs, generate_combo_signature(legs)};
-}
-
-auto ComboBuilderEngine::ratio_spread(
-    const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-    utilities::Direction direction, int volume) -> std::pair<std::vector<utilities::Leg>, std::string> {
-    int sign = (direction == utilities::Direction::LONG) ? 1 : -1;
-    int ratio = 2;  // default 1:2 ratio, same as Python
-    auto *ll = option_data.at("long_leg");
-    auto *sl = option_data.at("short_leg");
-    std::vector<utilities::Leg> legs = {
-        create_leg(*ll, sign > 0 ? utilities::Direction::LONG : utilities::Direction::SHORT, volume),
-        create_leg(*sl, sign > 0 ? utilities::Direction::SHORT : utilities::Direction::LONG, volume * ratio),
-    };
-    return {legs, generate_combo_signature(legs)};
-}
-
-auto ComboBuilderEngine::butterfly(
-    const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-    utilities::Direction direction, int volume) -> std::pair<std::vector<utilities::Leg>, std::string> {
-    int sign = (direction == utilities::Direction::LONG) ? 1 : -1;
-    auto *body = option_data.at("body");
-    auto *w1 = option_data.at("wing1");
-    auto *w2 = option_data.at("wing2");
-    std::vector<utilities::Leg> legs = {
-        create_leg(*body, sign > 0 ? utilities::Direction::LONG : utilities::Direction::SHORT, volume),
-        create_leg(*w1, sign > 0 ? utilities::Direction::SHORT : utilities::Direction::LONG, volume),
-        create_leg(*w2, sign > 0 ? utilities::Direction::SHORT : utilities::Direction::LONG, volume),
-    };
-    return {legs, generate_combo_signature(legs)};
-}
-
-auto ComboBuilderEngine::inverse_butterfly(
-    const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-    utilities::Direction direction, int volume) -> std::pair<std::vector<utilities::Leg>, std::string> {
-    int sign = (direction == utilities::Direction::LONG) ? 1 : -1;
-    auto *body = option_data.at("body");
-    auto *w1 = option_data.at("wing1");
-    auto *w2 = option_data.at("wing2");
-    std::vector<utilities::Leg> legs = {
-        create_leg(*body, sign > 0 ? utilities::Direction::SHORT : utilities::Direction::LONG, volume),
-        create_leg(*w1, sign > 0 ? utilities::Direction::LONG : utilities::Direction::SHORT, volume),
-        create_leg(*w2, sign > 0 ? utilities::Direction::LONG : utilities::Direction::SHORT, volume),
-    };
-    return {legs, generate_combo_signature(legs)};
-}
-
-auto ComboBuilderEngine::iron_butterfly(
-    const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-    utilities::Direction direction, int volume) -> std::pair<std::vector<utilities::Leg>, std::string> {
-    int sign = (direction == utilities::Direction::LONG) ? 1 : -1;
-    auto *pw = option_data.at("put_wing");
-    auto *body = option_data.at("body");
-    auto *cw = option_data.at("call_wing");
-    std::vector<utilities::Leg> legs = {
-        create_leg(*pw, sign > 0 ? utilities::Direction::LONG : utilities::Direction::SHORT, volume),
-        create_leg(*body, sign > 0 ? utilities::Direction::SHORT : utilities::Direction::LONG, volume),
-        create_leg(*cw, sign > 0 ? utilities::Direction::LONG : utilities::Direction::SHORT, volume),
-    };
-    return {legs, generate_combo_signature(legs)};
-}
-
-auto ComboBuilderEngine::condor(
-    const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-    utilities::Direction direction, int volume) -> std::pair<std::vector<utilities::Leg>, std::string> {
-    int sign = (direction == utilities::Direction::LONG) ? 1 : -1;
-    auto *lp = option_data.at("long_put");
-    auto *sp = option_data.at("short_put");
-    auto *sc = option_data.at("short_call");
-    auto *lc = option_data.at("long_call");
-    std::vector<utilities::Leg> legs = {
-        create_leg(*lp, sign > 0 ? utilities::Direction::LONG : utilities::Direction::SHORT, volume),
-        create_leg(*sp, sign > 0 ? utilities::Direction::SHORT : utilities::Direction::LONG, volume),
-        create_leg(*sc, sign > 0 ? utilities::Direction::SHORT : utilities::Direction::LONG, volume),
-        create_leg(*lc, sign > 0 ? utilities::Direction::LONG : utilities::Direction::SHORT, volume),
-    };
-    return {legs, generate_combo_signature(legs)};
-}
-
-auto ComboBuilderEngine::box_spread(
-    const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-    utilities::Direction direction, int volume) -> std::pair<std::vector<utilities::Leg>, std::string> {
-    int sign = (direction == utilities::Direction::LONG) ? 1 : -1;
-    auto *lc = option_data.at("long_call");
-    auto *sc = option_data.at("short_call");
-    auto *sp = option_data.at("short_put");
-    auto *lp = option_data.at("long_put");
-    std::vector<utilities::Leg> legs = {
-        create_leg(*lc, sign > 0 ? utilities::Direction::LONG : utilities::Direction::SHORT, volume),
-        create_leg(*sc, sign > 0 ? utilities::Direction::SHORT : utilities::Direction::LONG, volume),
-        create_leg(*sp, sign > 0 ? utilities::Direction::SHORT : utilities::Direction::LONG, volume),
-        create_leg(*lp, sign > 0 ? utilities::Direction::LONG : utilities::Direction::SHORT, volume),
-    };
-    return {legs, generate_combo_signature(legs)};
+void ComboBuilderEngine::clear_cache() {
+    std::unique_lock lock(cache_mutex_);
+    cache_.clear();
 }
 
 auto ComboBuilderEngine::generate_combo_signature(std::span<const utilities::Leg> legs) -> std::string {
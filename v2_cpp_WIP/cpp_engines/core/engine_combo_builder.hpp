@@ -1,16 +1,26 @@
 #pragma once
 
-/** ComboBuilder: leg construction; get_contract from caller. */
+/**
+ * ComboBuilder: leg construction; get_contract from caller. Each ComboType has a constexpr leg
+ * template (roles, side, ratio); build() fills a caller-owned ComboOrder from option handles and
+ * caches IB leg contracts and the signature per leg set, so re-quoting a combo does not allocate.
+ */
 
 #include "../utilities/base_engine.hpp"
 #include "../utilities/constant.hpp"
 #include "../utilities/object.hpp"
 #include "../utilities/portfolio.hpp"
+#include "../utilities/symbol_table.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <optional>
+#include <shared_mutex>
 #include <span>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -19,76 +29,175 @@ namespace engines {
 
 using ComboGetContractFn = std::function<const utilities::ContractData*(const std::string&)>;
 
+/** Most legs one combo order carries (CUSTOM included). */
+inline constexpr size_t kMaxComboLegs = 8;
+
+/** Leg side: the combo direction as given, or buy/sell when the direction equals the pivot. */
+enum class LegSide : uint8_t {
+    COMBO,
+    BUY,
+    SELL,
+};
+
+struct ComboLegSpec {
+    std::string_view role; ///< option_data key of the map API
+    LegSide side = LegSide::COMBO;
+    int ratio = 1; ///< leg ratio = volume * ratio
+};
+
+/** Leg layout of one ComboType; count 0 = any 1..kMaxComboLegs legs, all COMBO side (CUSTOM). */
+struct ComboTemplate {
+    size_t count = 0;
+    utilities::Direction pivot = utilities::Direction::LONG;
+    std::array<ComboLegSpec, 4> legs{};
+};
+
+constexpr auto combo_template(utilities::ComboType type) -> ComboTemplate {
+    using utilities::ComboType;
+    using utilities::Direction;
+    constexpr LegSide B = LegSide::BUY;
+    constexpr LegSide S = LegSide::SELL;
+    switch (type) {
+    case ComboType::SINGLE_LEG:
+        return {.count = 1, .legs = {{{.role = ""}}}};
+    case ComboType::STRADDLE:
+    case ComboType::STRANGLE:
+        return {.count = 2, .legs = {{{.role = "call"}, {.role = "put"}}}};
+    case ComboType::IRON_CONDOR:
+        return {.count = 4,
+                .pivot = Direction::SHORT,
+                .legs = {{{"put_lower", B},
+                          {"put_upper", S},
+                          {"call_lower", S},
+                          {"call_upper", B}}}};
+    case ComboType::RISK_REVERSAL:
+        return {.count = 2,
+                .pivot = Direction::SHORT,
+                .legs = {{{"long_leg", B}, {"short_leg", S}}}};
+    case ComboType::SPREAD:
+    case ComboType::DIAGONAL_SPREAD:
+        return {.count = 2, .legs = {{{"long_leg", B}, {"short_leg", S}}}};
+    case ComboType::RATIO_SPREAD:
+        return {.count = 2, .legs = {{{"long_leg", B}, {"short_leg", S, 2}}}};
+    case ComboType::BUTTERFLY:
+        return {.count = 3, .legs = {{{"body", B}, {"wing1", S}, {"wing2", S}}}};
+    case ComboType::INVERSE_BUTTERFLY:
+        return {.count = 3, .legs = {{{"body", S}, {"wing1", B}, {"wing2", B}}}};
+    case ComboType::IRON_BUTTERFLY:
+        return {.count = 3, .legs = {{{"put_wing", B}, {"body", S}, {"call_wing", B}}}};
+    case ComboType::CONDOR:
+        return {.count = 4,
+                .legs = {{{"long_put", B}, {"short_put", S}, {"short_call", S}, {"long_call", B}}}};
+    case ComboType::BOX_SPREAD:
+        return {.count = 4,
+                .legs = {{{"long_call", B}, {"short_call", S}, {"short_put", S}, {"long_put", B}}}};
+    case ComboType::CUSTOM:
+    default:
+        return {};
+    }
+}
+
+static_assert(combo_template(utilities::ComboType::IRON_CONDOR).count == 4);
+static_assert(combo_template(utilities::ComboType::RATIO_SPREAD).legs[1].ratio == 2);
+
+/** Leg direction of spec for a combo sent in direction (see LegSide). */
+constexpr auto leg_direction(const ComboTemplate& tpl, const ComboLegSpec& spec,
+                             utilities::Direction direction) -> utilities::Direction {
+    if (spec.side == LegSide::COMBO) {
+        return direction;
+    }
+    const bool buy = (direction == tpl.pivot) == (spec.side == LegSide::BUY);
+    return buy ? utilities::Direction::LONG : utilities::Direction::SHORT;
+}
+
+enum class ComboError : uint8_t {
+    NONE,
+    LEG_COUNT,        ///< handle count does not match the template
+    MISSING_OPTION,   ///< null handle
+    MISSING_CONTRACT, ///< get_contract found no contract for a leg
+};
+
+std::string_view combo_error_name(ComboError error);
+
+/**
+ * Output of build(), owned by the caller. Reused across quotes the leg strings keep their
+ * capacity, so steady-state builds only assign. signature points into the builder's cache.
+ */
+struct ComboOrder {
+    std::array<utilities::Leg, kMaxComboLegs> legs{};
+    size_t size = 0;
+    const std::string* signature = nullptr;
+    ComboError error = ComboError::NONE;
+
+    explicit operator bool() const { return error == ComboError::NONE && size > 0; }
+    [[nodiscard]] std::span<const utilities::Leg> leg_span() const { return {legs.data(), size}; }
+};
+
 class ComboBuilderEngine : public utilities::BaseEngine {
 public:
     ComboBuilderEngine() = default;
     explicit ComboBuilderEngine(utilities::MainEngine* main)
         : BaseEngine(main, "ComboBuilder") {}
 
-    /** Create one leg; get_contract when not from combo_builder. */
+    /** Create one leg; throws when get_contract_fn finds no contract. */
     utilities::Leg create_leg(const utilities::OptionData& option, utilities::Direction direction,
         int volume, std::optional<double> price = std::nullopt,
         const ComboGetContractFn& get_contract_fn = nullptr);
 
-    /** Build combo legs + signature; optional out_logs. */
+    /**
+     * Fill out with the legs of combo_type over options (template leg order). get_contract is
+     * only called the first time a leg set is seen. Never throws; out.error says why it failed.
+     */
+    bool build(utilities::ComboType combo_type,
+        std::span<const utilities::OptionData* const> options, utilities::Direction direction,
+        int volume, const ComboGetContractFn& get_contract_fn, ComboOrder& out);
+
+    /** Fixed-size build: the handle count is checked against the template at compile time. */
+    template <utilities::ComboType Type, size_t N>
+    bool build(std::span<const utilities::OptionData* const, N> options,
+        utilities::Direction direction, int volume, const ComboGetContractFn& get_contract_fn,
+        ComboOrder& out) {
+        static_assert(N != std::dynamic_extent && N <= kMaxComboLegs);
+        static_assert(combo_template(Type).count == 0 || combo_template(Type).count == N,
+                      "option count does not match the combo template");
+        return build(Type, std::span<const utilities::OptionData* const>(options), direction,
+                     volume, get_contract_fn, out);
+    }
+
+    /** Build combo legs + signature from role-keyed options; throws on a missing leg/contract. */
     std::pair<std::vector<utilities::Leg>, std::string> combo_builder(
         const std::unordered_map<std::string, utilities::OptionData*>& option_data,
         utilities::ComboType combo_type, utilities::Direction direction, int volume,
         ComboGetContractFn get_contract_fn, std::vector<utilities::LogData>* out_logs = nullptr);
 
-    // Combo builders
-    std::pair<std::vector<utilities::Leg>, std::string> single_leg(
-        const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-        utilities::Direction direction, int volume);
-    std::pair<std::vector<utilities::Leg>, std::string> straddle(
-        const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-        utilities::Direction direction, int volume);
-    std::pair<std::vector<utilities::Leg>, std::string> strangle(
-        const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-        utilities::Direction direction, int volume);
-    std::pair<std::vector<utilities::Leg>, std::string> iron_condor(
-        const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-        utilities::Direction direction, int volume);
-    std::pair<std::vector<utilities::Leg>, std::string> risk_reversal(
-        const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-        utilities::Direction direction, int volume);
-    std::pair<std::vector<utilities::Leg>, std::string> custom(
-        const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-        utilities::Direction direction, int volume);
-    std::pair<std::vector<utilities::Leg>, std::string> spread(
-        const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-        utilities::Direction direction, int volume);
-    std::pair<std::vector<utilities::Leg>, std::string> diagonal_spread(
-        const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-        utilities::Direction direction, int volume);
-    std::pair<std::vector<utilities::Leg>, std::string> ratio_spread(
-        const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-        utilities::Direction direction, int volume);
-    std::pair<std::vector<utilities::Leg>, std::string> butterfly(
-        const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-        utilities::Direction direction, int volume);
-    std::pair<std::vector<utilities::Leg>, std::string> inverse_butterfly(
-        const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-        utilities::Direction direction, int volume);
-    std::pair<std::vector<utilities::Leg>, std::string> iron_butterfly(
-        const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-        utilities::Direction direction, int volume);
-    std::pair<std::vector<utilities::Leg>, std::string> condor(
-        const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-        utilities::Direction direction, int volume);
-    std::pair<std::vector<utilities::Leg>, std::string> box_spread(
-        const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-        utilities::Direction direction, int volume);
+    /** Forget cached leg contracts (e.g. after a contract reload). */
+    void clear_cache();
 
     static std::string generate_combo_signature(std::span<const utilities::Leg> legs);
 
 private:
-    std::pair<std::vector<utilities::Leg>, std::string> combo_builder_impl(
-        const std::unordered_map<std::string, utilities::OptionData*>& option_data,
-        utilities::ComboType combo_type, utilities::Direction direction, int volume);
+    /** Ordered SymbolIds of one leg set. */
+    struct LegSetKey {
+        std::array<utilities::SymbolId, kMaxComboLegs> ids{};
+        size_t size = 0;
+        bool operator==(const LegSetKey&) const = default;
+    };
+    struct LegSetHash {
+        size_t operator()(const LegSetKey& key) const;
+    };
+    /** Contract fields of each leg (direction/ratio unset) and the set's signature. */
+    struct LegSet {
+        std::vector<utilities::Leg> legs;
+        std::string signature;
+    };
+
+    /** Cached leg set for key, resolving contracts on a miss; nullptr if one is missing. */
+    const LegSet* leg_set(const LegSetKey& key,
+        std::span<const utilities::OptionData* const> options,
+        const ComboGetContractFn& get_contract_fn);
 
-    ComboGetContractFn current_get_contract_;
-    std::vector<utilities::LogData>* current_out_logs_ = nullptr;
+    mutable std::shared_mutex cache_mutex_;
+    std::unordered_map<LegSetKey, LegSet, LegSetHash> cache_;
 };
 
 }  // namespace engines
@@ -1,7 +1,7 @@
 #include "engine_execution.hpp"
 #include "../utilities/utility.hpp"
-#include <iterator>
-#include <ranges>
+#include <algorithm>
+#include <utility>
 
 namespace core {
 
@@ -36,11 +36,149 @@ auto ExecutionEngine::get_account_position(const std::string& symbol) const -> d
 }
 
 auto ExecutionEngine::pre_trade_risk_check(const std::string& strategy_name,
-                                           const utilities::OrderRequest& req) -> bool {
-    (void)strategy_name;
-    (void)req;
-    // Placeholder: risk checks
-    return true;
+                                           const utilities::OrderRequest& req) const -> bool {
+    return !risk_check_ || risk_check_(strategy_name, req);
+}
+
+namespace {
+
+auto is_terminal(utilities::Status status) -> bool {
+    return status == utilities::Status::CANCELLED || status == utilities::Status::REJECTED ||
+           status == utilities::Status::ALLTRADED;
+}
+
+} // namespace
+
+auto ExecutionEngine::find_record(const std::string& orderid) -> OrderRecord* {
+    auto it = order_index_.find(orderid);
+    return (it != order_index_.end()) ? &record(it->second) : nullptr;
+}
+
+auto ExecutionEngine::find_record(const std::string& orderid) const -> const OrderRecord* {
+    auto it = order_index_.find(orderid);
+    if (it == order_index_.end()) {
+        return nullptr;
+    }
+    return it->second.archived ? &archive_[it->second.index - archive_base_]
+                               : &slab_[it->second.index];
+}
+
+auto ExecutionEngine::record(OrderRef ref) -> OrderRecord& {
+    return ref.archived ? archive_[ref.index - archive_base_] : slab_[ref.index];
+}
+
+auto ExecutionEngine::ensure_order(const std::string& orderid) -> OrderRef {
+    auto [it, inserted] = order_index_.try_emplace(orderid);
+    if (!inserted) {
+        return it->second;
+    }
+    OrderHandle handle = 0;
+    if (!free_slots_.empty()) {
+        handle = free_slots_.back();
+        free_slots_.pop_back();
+    } else {
+        handle = static_cast<OrderHandle>(slab_.size());
+        slab_.emplace_back();
+    }
+    it->second = {.index = handle, .archived = false};
+    OrderRecord& rec = slab_[handle];
+    rec = OrderRecord{};
+    rec.data.orderid = orderid;
+    rec.live = true;
+    return it->second;
+}
+
+auto ExecutionEngine::strategy_id(const std::string& strategy_name) -> uint32_t {
+    auto [it, inserted] =
+        strategy_ids_.try_emplace(strategy_name, static_cast<uint32_t>(strategy_names_.size()));
+    if (inserted) {
+        strategy_names_.push_back(strategy_name);
+        strategy_active_.emplace_back();
+    }
+    return it->second;
+}
+
+void ExecutionEngine::activate(OrderHandle handle, uint32_t strategy) {
+    OrderRecord& rec = slab_[handle];
+    if (rec.active_pos != kNone && rec.strategy == strategy) {
+        return;
+    }
+    deactivate(rec);
+    std::vector<OrderHandle>& active = strategy_active_[strategy];
+    rec.strategy = strategy;
+    rec.active_pos = static_cast<uint32_t>(active.size());
+    active.push_back(handle);
+}
+
+void ExecutionEngine::deactivate(OrderRecord& rec) {
+    if (rec.active_pos == kNone) {
+        return;
+    }
+    // Swap-remove: the last handle takes this record's place.
+    std::vector<OrderHandle>& active = strategy_active_[rec.strategy];
+    const OrderHandle moved = active.back();
+    active[rec.active_pos] = moved;
+    slab_[moved].active_pos = rec.active_pos;
+    active.pop_back();
+    rec.active_pos = kNone;
+}
+
+void ExecutionEngine::archive_terminal_orders() {
+    terminal_since_sweep_ = 0;
+    const auto now = std::chrono::steady_clock::now();
+    for (OrderHandle handle = 0; handle < slab_.size(); ++handle) {
+        OrderRecord& rec = slab_[handle];
+        if (!rec.live || rec.active_pos != kNone || (rec.stored && rec.data.is_active())) {
+            continue;
+        }
+        if (rec.stored) {
+            // Keep strategy attribution: trades may still arrive for a filled order.
+            order_index_[rec.data.orderid] = {
+                .index = archive_base_ + static_cast<uint32_t>(archive_.size()),
+                .archived = true};
+            archive_.push_back(std::move(rec));
+            archive_.back().live = false;
+            archive_.back().archived_at = now;
+        } else {
+            order_index_.erase(rec.data.orderid); // registered, then untracked before data
+        }
+        rec = OrderRecord{};
+        free_slots_.push_back(handle);
+    }
+    evict_expired();
+}
+
+void ExecutionEngine::set_archive_retention(std::chrono::seconds window,
+                                            PersistedRowsFn persisted_rows) {
+    retention_ = window;
+    persisted_rows_ = std::move(persisted_rows);
+}
+
+void ExecutionEngine::evict_expired() {
+    if (retention_ == std::chrono::steady_clock::duration::zero()) {
+        return;
+    }
+    const auto cutoff = std::chrono::steady_clock::now() - retention_;
+    const uint64_t persisted = persisted_rows_ ? persisted_rows_() : UINT64_MAX;
+    // Both fronts are oldest first; stop at the first record still inside the window or unwritten.
+    while (!archive_.empty() && archive_.front().archived_at <= cutoff &&
+           archive_.front().persist_ticket <= persisted) {
+        auto it = order_index_.find(archive_.front().data.orderid);
+        if (it != order_index_.end() && it->second.archived && it->second.index == archive_base_) {
+            order_index_.erase(it);
+        }
+        archive_.pop_front();
+        ++archive_base_;
+    }
+    while (!trades_.empty() && trades_.front().stored_at <= cutoff &&
+           trades_.front().persist_ticket <= persisted) {
+        auto it = trade_index_.find(trades_.front().data.tradeid);
+        if (it != trade_index_.end() && it->second == trade_base_) {
+            trade_index_.erase(it);
+        }
+        trades_.pop_front();
+        ++trade_base_;
+    }
 }
 
 void ExecutionEngine::register_active_order(const std::string& strategy_name,
@@ -48,107 +186,168 @@ void ExecutionEngine::register_active_order(const std::string& strategy_name,
     if (orderid.empty()) {
         return;
     }
-    strategy_active_orders_[strategy_name].insert(orderid);
-    orderid_strategy_name_[orderid] = strategy_name;
-    all_active_order_ids_.insert(orderid);
+    const uint32_t strategy = strategy_id(strategy_name);
+    const OrderRef ref = ensure_order(orderid);
+    OrderRecord& rec = record(ref);
+    if (ref.archived || (rec.stored && !rec.data.is_active())) {
+        rec.strategy = strategy; // already terminal
+        return;
+    }
+    activate(ref.index, strategy);
 }
 
 void ExecutionEngine::store_order(const std::string& strategy_name,
-                                  const utilities::OrderData& order) {
-    orders_[order.orderid] = order;
-    if (order.status == utilities::Status::CANCELLED ||
-        order.status == utilities::Status::REJECTED ||
-        order.status == utilities::Status::ALLTRADED) {
-        // Order no longer active; keep orderid→strategy_name for IB combo leg attribution
-        strategy_active_orders_[strategy_name].erase(order.orderid);
-        all_active_order_ids_.erase(order.orderid);
+                                  const utilities::OrderData& order, uint64_t persist_ticket) {
+    OrderRecord& rec = record(ensure_order(order.orderid));
+    rec.data = order;
+    rec.stored = true;
+    rec.persist_ticket = std::max(rec.persist_ticket, persist_ticket);
+    if (rec.strategy == kNone && !strategy_name.empty()) {
+        rec.strategy = strategy_id(strategy_name);
+    }
+    if (is_terminal(order.status)) {
+        // Order no longer active; keep the strategy for IB combo leg attribution
+        deactivate(rec);
+        if (++terminal_since_sweep_ >= kArchiveBatch) {
+            archive_terminal_orders();
+        }
     }
 }
 
 void ExecutionEngine::add_order(const utilities::OrderData& order) {
-    orders_[order.orderid] = order;
+    OrderRecord& rec = record(ensure_order(order.orderid));
+    rec.data = order;
+    rec.stored = true;
+    if (is_terminal(order.status) && ++terminal_since_sweep_ >= kArchiveBatch) {
+        archive_terminal_orders();
+    }
 }
 
-void ExecutionEngine::store_trade(const utilities::TradeData& trade) {
-    trades_[trade.tradeid] = trade;
+void ExecutionEngine::store_trade(const utilities::TradeData& trade, uint64_t persist_ticket) {
+    auto [it, inserted] = trade_index_.try_emplace(
+        trade.tradeid, trade_base_ + static_cast<uint32_t>(trades_.size()));
+    if (!inserted) {
+        TradeRecord& rec = trades_[it->second - trade_base_];
+        rec.data = trade;
+        rec.persist_ticket = std::max(rec.persist_ticket, persist_ticket);
+        return;
+    }
+    trades_.push_back({.data = trade,
+                       .persist_ticket = persist_ticket,
+                       .stored_at = std::chrono::steady_clock::now()});
+    if (++trades_since_sweep_ >= kArchiveBatch) {
+        trades_since_sweep_ = 0;
+        evict_expired();
+    }
 }
 
 auto ExecutionEngine::get_order(const std::string& orderid) -> utilities::OrderData* {
-    auto it = orders_.find(orderid);
-    return (it != orders_.end()) ? &it->second : nullptr;
+    OrderRecord* rec = find_record(orderid);
+    return (rec != nullptr && rec->stored) ? &rec->data : nullptr;
 }
 
 auto ExecutionEngine::get_trade(const std::string& tradeid) -> utilities::TradeData* {
-    auto it = trades_.find(tradeid);
-    return (it != trades_.end()) ? &it->second : nullptr;
+    auto it = trade_index_.find(tradeid);
+    return (it != trade_index_.end()) ? &trades_[it->second - trade_base_].data : nullptr;
 }
 
 auto ExecutionEngine::get_strategy_name_for_order(const std::string& orderid) const -> std::string {
-    auto it = orderid_strategy_name_.find(orderid);
-    return (it != orderid_strategy_name_.end()) ? it->second : std::string{};
+    const OrderRecord* rec = find_record(orderid);
+    return (rec != nullptr && rec->strategy != kNone) ? strategy_names_[rec->strategy]
+                                                      : std::string{};
 }
 
 auto ExecutionEngine::get_all_orders() const -> std::vector<utilities::OrderData> {
     std::vector<utilities::OrderData> out;
-    out.reserve(orders_.size());
-    std::ranges::copy(orders_ | std::views::values, std::back_inserter(out));
+    out.reserve(archive_.size() + slab_.size() - free_slots_.size());
+    for (const OrderRecord& rec : archive_) {
+        out.push_back(rec.data);
+    }
+    for (const OrderRecord& rec : slab_) {
+        if (rec.live && rec.stored) {
+            out.push_back(rec.data);
+        }
+    }
     return out;
 }
 
 auto ExecutionEngine::get_all_trades() const -> std::vector<utilities::TradeData> {
     std::vector<utilities::TradeData> out;
     out.reserve(trades_.size());
-    std::ranges::copy(trades_ | std::views::values, std::back_inserter(out));
+    for (const TradeRecord& rec : trades_) {
+        out.push_back(rec.data);
+    }
     return out;
 }
 
 auto ExecutionEngine::get_all_active_orders() const -> std::vector<utilities::OrderData> {
     std::vector<utilities::OrderData> out;
-    for (const std::string& oid : all_active_order_ids_) {
-        auto it = orders_.find(oid);
-        if (it != orders_.end() && it->second.is_active()) {
-            out.push_back(it->second);
+    for (const std::vector<OrderHandle>& active : strategy_active_) {
+        for (OrderHandle handle : active) {
+            const OrderRecord& rec = slab_[handle];
+            if (rec.stored && rec.data.is_active()) {
+                out.push_back(rec.data);
+            }
         }
     }
     return out;
 }
 
-auto ExecutionEngine::get_strategy_active_orders() const
-    -> const std::unordered_map<std::string, std::set<std::string>>& {
-    return strategy_active_orders_;
+void ExecutionEngine::for_each_active_order(
+    const std::string& strategy_name,
+    const std::function<void(const utilities::OrderData&)>& fn) const {
+    auto it = strategy_ids_.find(strategy_name);
+    if (it == strategy_ids_.end()) {
+        return;
+    }
+    for (OrderHandle handle : strategy_active_[it->second]) {
+        if (slab_[handle].stored) {
+            fn(slab_[handle].data);
+        }
+    }
 }
 
 void ExecutionEngine::remove_order_tracking(const std::string& orderid) {
-    auto it = orderid_strategy_name_.find(orderid);
-    if (it != orderid_strategy_name_.end()) {
-        strategy_active_orders_[it->second].erase(orderid);
-        orderid_strategy_name_.erase(it);
+    OrderRecord* rec = find_record(orderid);
+    if (rec == nullptr) {
+        return;
     }
-    all_active_order_ids_.erase(orderid);
+    deactivate(*rec);
+    rec->strategy = kNone;
 }
 
 void ExecutionEngine::remove_strategy_tracking(const std::string& strategy_name) {
-    auto oit = strategy_active_orders_.find(strategy_name);
-    if (oit != strategy_active_orders_.end()) {
-        for (const std::string& oid : oit->second) {
-            orderid_strategy_name_.erase(oid);
-            all_active_order_ids_.erase(oid);
-        }
-        strategy_active_orders_.erase(oit);
+    auto it = strategy_ids_.find(strategy_name);
+    if (it == strategy_ids_.end()) {
+        return;
+    }
+    std::vector<OrderHandle>& active = strategy_active_[it->second];
+    for (OrderHandle handle : active) {
+        slab_[handle].active_pos = kNone;
+        slab_[handle].strategy = kNone;
     }
+    active.clear();
 }
 
 void ExecutionEngine::ensure_strategy_key(const std::string& strategy_name) {
-    strategy_active_orders_[strategy_name];
+    strategy_id(strategy_name);
 }
 
 void ExecutionEngine::clear() {
-    strategy_active_orders_.clear();
-    orderid_strategy_name_.clear();
-    all_active_order_ids_.clear();
+    strategy_active_.clear();
+    strategy_ids_.clear();
+    strategy_names_.clear();
     account_position_.clear();
-    orders_.clear();
+    order_index_.clear();
+    slab_.clear();
+    free_slots_.clear();
+    archive_.clear();
+    archive_base_ = 0;
+    terminal_since_sweep_ = 0;
     trades_.clear();
+    trade_base_ = 0;
+    trade_index_.clear();
+    trades_since_sweep_ = 0;
 }
 
 } // namespace core
@@ -1,15 +1,23 @@
 #pragma once
 
-/** ExecutionEngine: order/trade cache, active order tracking. */
+/**
+ * ExecutionEngine: order/trade cache, active order tracking. Orders live in a slab of records
+ * addressed by dense integer handles; string orderids are resolved once at the API boundary.
+ * Terminal orders are moved to an append-only archive in batches, so the slab stays the size of
+ * the recent working set. With a retention window set, archived orders and stored trades older
+ * than the window are evicted once their persistence rows are written.
+ */
 
 #include "../utilities/base_engine.hpp"
 #include "../utilities/constant.hpp"
 #include "../utilities/object.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <functional>
-#include <set>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 namespace core {
@@ -37,22 +45,40 @@ class ExecutionEngine : public utilities::BaseEngine {
     void set_account_position(const std::string& symbol, double position);
     double get_account_position(const std::string& symbol) const;
 
-    /** Pre-trade risk check (placeholder, pass). */
-    static bool pre_trade_risk_check(const std::string& strategy_name,
-                                     const utilities::OrderRequest& req);
+    /** Injected pre-trade check (e.g. ScenarioEngine::check_order); false rejects the order. */
+    using RiskCheckFn =
+        std::function<bool(const std::string& strategy_name, const utilities::OrderRequest&)>;
+    void set_risk_check(RiskCheckFn fn) { risk_check_ = std::move(fn); }
+
+    /** Pre-trade risk check: the injected check; passes when none is set. */
+    [[nodiscard]] bool pre_trade_risk_check(const std::string& strategy_name,
+                                            const utilities::OrderRequest& req) const;
 
     /** Register strategy↔orderid (called by strategy after send). */
     void register_active_order(const std::string& strategy_name, const std::string& orderid);
 
-    /** Store order; remove from active if CANCELLED/REJECTED/ALLTRADED. */
-    void store_order(const std::string& strategy_name, const utilities::OrderData& order);
+    /** Persistence rows written so far; monotonic, compared against each record's ticket. */
+    using PersistedRowsFn = std::function<uint64_t()>;
+    /**
+     * Evict archived orders and stored trades once they are older than window and
+     * persisted_rows() has reached their persist ticket. Zero window (default): keep everything.
+     */
+    void set_archive_retention(std::chrono::seconds window, PersistedRowsFn persisted_rows);
+
+    /**
+     * Store order; remove from active if CANCELLED/REJECTED/ALLTRADED. persist_ticket: the
+     * persistence row count once this update's row is queued (0: nothing to wait for).
+     */
+    void store_order(const std::string& strategy_name, const utilities::OrderData& order,
+                     uint64_t persist_ticket = 0);
 
     /** Store order only (backtest add_order; no active update). */
     void add_order(const utilities::OrderData& order);
 
-    /** Store trade. */
-    void store_trade(const utilities::TradeData& trade);
+    /** Store trade; persist_ticket as for store_order. */
+    void store_trade(const utilities::TradeData& trade, uint64_t persist_ticket = 0);
 
+    /** Valid until the next store_order/add_order/store_trade (archival or eviction moves it). */
     utilities::OrderData* get_order(const std::string& orderid);
     utilities::TradeData* get_trade(const std::string& tradeid);
     std::string get_strategy_name_for_order(const std::string& orderid) const;
@@ -61,9 +87,9 @@ class ExecutionEngine : public utilities::BaseEngine {
     std::vector<utilities::TradeData> get_all_trades() const;
     std::vector<utilities::OrderData> get_all_active_orders() const;
 
-    /** strategy_name → active orderids. */
-    const std::unordered_map<std::string, std::set<std::string>>&
-    get_strategy_active_orders() const;
+    /** fn(order) for each stored active order of strategy_name. */
+    void for_each_active_order(const std::string& strategy_name,
+                               const std::function<void(const utilities::OrderData&)>& fn) const;
 
     /** Remove orderid from tracking. */
     void remove_order_tracking(const std::string& orderid);
@@ -71,12 +97,6 @@ class ExecutionEngine : public utilities::BaseEngine {
     /** Clear strategy's active orders (remove_strategy). */
     void remove_strategy_tracking(const std::string& strategy_name);
 
-    /** Backtest: insert orderid after append_order. */
-    std::unordered_set<std::string>& active_order_ids() { return all_active_order_ids_; }
-    const std::unordered_set<std::string>& active_order_ids() const {
-        return all_active_order_ids_;
-    }
-
     /** Ensure strategy key (add_strategy). */
     void ensure_strategy_key(const std::string& strategy_name);
 
@@ -85,15 +105,76 @@ class ExecutionEngine : public utilities::BaseEngine {
 
     void close() override { clear(); }
 
+    /** Terminal orders that turn over before a sweep moves them to the archive. */
+    static constexpr size_t kArchiveBatch = 4096;
+
   private:
+    using OrderHandle = uint32_t;
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    struct OrderRecord {
+        utilities::OrderData data;
+        /** Index into strategy_names_ (kNone: unattributed). */
+        uint32_t strategy = kNone;
+        /** Position in strategy_active_[strategy] (kNone: not active). */
+        uint32_t active_pos = kNone;
+        /** False for a registered orderid whose first OrderData has not arrived yet. */
+        bool stored = false;
+        bool live = false; // slab slot in use (false in archive_)
+        uint64_t persist_ticket = 0;
+        std::chrono::steady_clock::time_point archived_at{};
+    };
+    /** Index entry: slab handle, or absolute archive position (archive_base_ + offset). */
+    struct OrderRef {
+        uint32_t index = 0;
+        bool archived = false;
+    };
+
+    OrderRecord* find_record(const std::string& orderid);
+    [[nodiscard]] const OrderRecord* find_record(const std::string& orderid) const;
+    OrderRecord& record(OrderRef ref);
+    /** Index entry for orderid, allocating a slab slot on first sight. */
+    OrderRef ensure_order(const std::string& orderid);
+    uint32_t strategy_id(const std::string& strategy_name);
+    void activate(OrderHandle handle, uint32_t strategy);
+    void deactivate(OrderRecord& record);
+    /** Move stored, inactive slab records to the archive and recycle their slots. */
+    void archive_terminal_orders();
+    /** Pop expired, persisted records off the archive and trade fronts, with their index keys. */
+    void evict_expired();
+
     SendOrderFn send_impl_;
     CancelImplFn cancel_impl_;
+    RiskCheckFn risk_check_;
     std::unordered_map<std::string, double> account_position_;
-    std::unordered_map<std::string, utilities::OrderData> orders_;
-    std::unordered_map<std::string, utilities::TradeData> trades_;
-    std::unordered_map<std::string, std::string> orderid_strategy_name_;
-    std::unordered_map<std::string, std::set<std::string>> strategy_active_orders_;
-    std::unordered_set<std::string> all_active_order_ids_;
+
+    /** Order slab (deque: stable addresses as it grows) and its recycled slots. */
+    std::deque<OrderRecord> slab_;
+    std::vector<OrderHandle> free_slots_;
+    std::deque<OrderRecord> archive_;
+    /** Absolute position of archive_.front(); positions wrap with uint32_t arithmetic. */
+    uint32_t archive_base_ = 0;
+    std::unordered_map<std::string, OrderRef> order_index_;
+    size_t terminal_since_sweep_ = 0;
+
+    std::chrono::steady_clock::duration retention_{};
+    PersistedRowsFn persisted_rows_;
+
+    /** Interned strategy names; strategy_active_[id] holds that strategy's active handles. */
+    std::vector<std::string> strategy_names_;
+    std::unordered_map<std::string, uint32_t> strategy_ids_;
+    std::vector<std::vector<OrderHandle>> strategy_active_;
+
+    struct TradeRecord {
+        utilities::TradeData data;
+        uint64_t persist_ticket = 0;
+        std::chrono::steady_clock::time_point stored_at{};
+    };
+    std::deque<TradeRecord> trades_;
+    /** Absolute position of trades_.front(), as archive_base_. */
+    uint32_t trade_base_ = 0;
+    std::unordered_map<std::string, uint32_t> trade_index_;
+    size_t trades_since_sweep_ = 0;
 };
 
 } // namespace core
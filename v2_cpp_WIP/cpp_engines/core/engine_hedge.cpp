@@ -6,13 +6,82 @@
 
 #include "engine_hedge.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <functional>
 #include <math.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace engines {
 
 static constexpr const char* APP_NAME = "Hedge";
 
+namespace {
+
+auto hedge_request(const utilities::ContractData& contract, utilities::Direction direction,
+                   double volume, std::string reference) -> utilities::OrderRequest {
+    utilities::OrderRequest req;
+    req.symbol = contract.symbol;
+    req.exchange = contract.exchange;
+    req.direction = direction;
+    req.type = utilities::OrderType::MARKET;
+    req.volume = volume;
+    req.price = 0.0;
+    req.reference = std::move(reference);
+    req.trading_class = contract.trading_class;
+    return req;
+}
+
+constexpr int kHedgeLogLevel = 0;
+
+auto hedge_log(std::string msg) -> utilities::LogData {
+    utilities::LogData log;
+    log.msg = std::move(msg);
+    log.level = kHedgeLogLevel;
+    log.gateway_name = APP_NAME;
+    return log;
+}
+
+auto direction_name(utilities::Direction direction) -> const char* {
+    return direction == utilities::Direction::LONG ? "LONG" : "SHORT";
+}
+
+/**
+ * total whole shares split pro rata over weights by largest remainder (ties to the earlier
+ * weight), so the shares are whole and sum to exactly total.
+ */
+auto split_whole_shares(double total, const std::vector<double>& weights) -> std::vector<double> {
+    std::vector<double> shares(weights.size(), 0.0);
+    double weight_sum = 0.0;
+    for (const double w : weights) {
+        weight_sum += std::max(w, 0.0);
+    }
+    if (shares.empty() || total <= 0 || weight_sum <= 0) {
+        return shares;
+    }
+    std::vector<std::pair<double, size_t>> remainders;
+    remainders.reserve(weights.size());
+    double assigned = 0.0;
+    for (size_t i = 0; i < weights.size(); ++i) {
+        const double exact = total * std::max(weights[i], 0.0) / weight_sum;
+        shares[i] = std::floor(exact);
+        assigned += shares[i];
+        remainders.emplace_back(exact - shares[i], i);
+    }
+    std::ranges::stable_sort(remainders, std::greater<>{},
+                             &std::pair<double, size_t>::first);
+    auto left = static_cast<size_t>(std::llround(total - assigned));
+    for (size_t k = 0; left > 0; k = (k + 1) % remainders.size(), --left) {
+        shares[remainders[k].second] += 1.0;
+    }
+    return shares;
+}
+
+} // namespace
+
 void HedgeEngine::register_strategy(const std::string& strategy_name, int timer_trigger,
                                     int delta_target, int delta_range) {
     HedgeConfig config;
@@ -27,10 +96,22 @@ void HedgeEngine::unregister_strategy(const std::string& strategy_name) {
     registered_strategies_.erase(strategy_name);
 }
 
+auto HedgeEngine::new_session_id() -> std::string {
+    return std::to_string(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::system_clock::now().time_since_epoch())
+                              .count());
+}
+
+auto HedgeEngine::log_sink(std::pmr::vector<utilities::LogData>* out_logs) const
+    -> std::pmr::vector<utilities::LogData>* {
+    return (log_filter_ && !log_filter_(kHedgeLogLevel)) ? nullptr : out_logs;
+}
+
 void HedgeEngine::process_hedging(const std::string& strategy_name, const HedgeParams& params,
-                                  std::vector<utilities::OrderRequest>* out_orders,
-                                  std::vector<utilities::CancelRequest>* out_cancels,
-                                  std::vector<utilities::LogData>* out_logs) {
+                                  std::pmr::vector<utilities::OrderRequest>* out_orders,
+                                  std::pmr::vector<utilities::CancelRequest>* out_cancels,
+                                  std::pmr::vector<utilities::LogData>* out_logs) {
+    out_logs = log_sink(out_logs);
     if ((out_orders == nullptr) && (out_cancels == nullptr) && (out_logs == nullptr)) {
         return;
     }
@@ -44,8 +125,9 @@ void HedgeEngine::process_hedging(const std::string& strategy_name, const HedgeP
 
 void HedgeEngine::run_strategy_hedging_with_params(
     const std::string& strategy_name, HedgeConfig& config, const HedgeParams& params,
-    std::vector<utilities::OrderRequest>* out_orders,
-    std::vector<utilities::CancelRequest>* out_cancels, std::vector<utilities::LogData>* out_logs) {
+    std::pmr::vector<utilities::OrderRequest>* out_orders,
+    std::pmr::vector<utilities::CancelRequest>* out_cancels,
+    std::pmr::vector<utilities::LogData>* out_logs) {
     if (!check_strategy_orders_finished(strategy_name, params)) {
         cancel_strategy_orders(strategy_name, params, out_cancels);
         return;
@@ -100,8 +182,8 @@ auto HedgeEngine::compute_hedge_plan(const std::string& strategy_name, HedgeConf
 void HedgeEngine::execute_hedge_orders(const std::string& strategy_name, const std::string& symbol,
                                        utilities::Direction direction, double available,
                                        double order_volume, const HedgeParams& params,
-                                       std::vector<utilities::OrderRequest>* out_orders,
-                                       std::vector<utilities::LogData>* out_logs) {
+                                       std::pmr::vector<utilities::OrderRequest>* out_orders,
+                                       std::pmr::vector<utilities::LogData>* out_logs) {
     if ((out_orders == nullptr) && (out_logs == nullptr)) {
         return;
     }
@@ -121,8 +203,8 @@ void HedgeEngine::execute_hedge_orders(const std::string& strategy_name, const s
 void HedgeEngine::submit_hedge_order(const std::string& strategy_name, const std::string& symbol,
                                      utilities::Direction direction, double volume,
                                      const HedgeParams& params,
-                                     std::vector<utilities::OrderRequest>* out_orders,
-                                     std::vector<utilities::LogData>* out_logs) {
+                                     std::pmr::vector<utilities::OrderRequest>* out_orders,
+                                     std::pmr::vector<utilities::LogData>* out_logs) {
     if (!params.get_contract) {
         return;
     }
@@ -130,65 +212,262 @@ void HedgeEngine::submit_hedge_order(const std::string& strategy_name, const std
     if (contract == nullptr) {
         return;
     }
-    utilities::OrderRequest req;
-    req.symbol = contract->symbol;
-    req.exchange = contract->exchange;
-    req.direction = direction;
-    req.type = utilities::OrderType::MARKET;
-    req.volume = volume;
-    req.price = 0.0;
-    req.reference = std::string("Hedge_") + strategy_name;
-    req.trading_class = contract->trading_class;
     if (out_orders != nullptr) {
-        out_orders->push_back(req);
+        out_orders->push_back(
+            hedge_request(*contract, direction, volume, std::string("Hedge_") + strategy_name));
     }
 
     if (out_logs != nullptr) {
-        utilities::LogData log;
-        log.msg = std::string("Hedge sending order: dir=") +
-                  (direction == utilities::Direction::LONG ? "LONG" : "SHORT") +
-                  ", vol=" + std::to_string(volume) + ", symbol=" + symbol;
-        log.level = 0;
-        log.gateway_name = APP_NAME;
-        out_logs->push_back(log);
+        out_logs->push_back(hedge_log(std::string("Hedge sending order: dir=") +
+                                      direction_name(direction) +
+                                      ", vol=" + std::to_string(volume) + ", symbol=" + symbol));
     }
 }
 
 auto HedgeEngine::check_strategy_orders_finished(const std::string& strategy_name,
                                                  const HedgeParams& params) -> bool {
-    if (!params.get_strategy_active_orders || !params.get_order) {
-        return true;
-    }
-    const auto& active_map = params.get_strategy_active_orders();
-    auto it = active_map.find(strategy_name);
-    if (it == active_map.end()) {
+    if (!params.for_each_active_order) {
         return true;
     }
-    for (const auto& orderid : it->second) {
-        utilities::OrderData* order = params.get_order(orderid);
-        if ((order != nullptr) && order->reference.find(APP_NAME) != std::string::npos) {
-            return false;
+    bool finished = true;
+    params.for_each_active_order(strategy_name, [&finished](const utilities::OrderData& order) {
+        if (order.reference.find(APP_NAME) != std::string::npos) {
+            finished = false;
         }
-    }
-    return true;
+    });
+    return finished;
 }
 
 void HedgeEngine::cancel_strategy_orders(const std::string& strategy_name,
                                          const HedgeParams& params,
-                                         std::vector<utilities::CancelRequest>* out_cancels) {
-    if ((out_cancels == nullptr) || !params.get_strategy_active_orders || !params.get_order) {
+                                         std::pmr::vector<utilities::CancelRequest>* out_cancels) {
+    if ((out_cancels == nullptr) || !params.for_each_active_order) {
         return;
     }
-    const auto& active_map = params.get_strategy_active_orders();
-    auto it = active_map.find(strategy_name);
-    if (it == active_map.end()) {
-        return;
+    params.for_each_active_order(strategy_name, [out_cancels](const utilities::OrderData& order) {
+        if (order.reference.find(APP_NAME) != std::string::npos) {
+            out_cancels->push_back(order.create_cancel_request());
+        }
+    });
+}
+
+auto HedgeEngine::has_pending_allocation(const std::string& strategy_name) const -> bool {
+    return std::ranges::any_of(netted_orders_, [&strategy_name](const auto& kv) -> bool {
+        return std::ranges::any_of(kv.second.allocations,
+                                   [&strategy_name](const HedgeAllocation& a) -> bool {
+                                       return a.strategy_name == strategy_name;
+                                   });
+    });
+}
+
+void HedgeEngine::process_netted_hedging(
+    const std::vector<std::pair<std::string, HedgeParams>>& strategies,
+    std::pmr::vector<NettedHedgeOrder>* out_orders,
+    std::pmr::vector<utilities::CancelRequest>* out_cancels,
+    std::pmr::vector<HedgeFill>* out_crosses,
+    std::pmr::vector<utilities::LogData>* out_logs) {
+    out_logs = log_sink(out_logs);
+    struct Request {
+        const std::string* strategy_name;
+        double volume; // signed: > 0 buys the underlying
+    };
+    struct Group {
+        const HedgeParams* params = nullptr;
+        std::vector<Request> requests;
+    };
+    std::unordered_map<std::string, Group> groups;
+    std::vector<std::string> symbols; // first-seen order, so rounds are deterministic
+    for (const auto& [name, params] : strategies) {
+        auto it = registered_strategies_.find(name);
+        if (it == registered_strategies_.end()) {
+            continue;
+        }
+        if (!check_strategy_orders_finished(name, params)) {
+            cancel_strategy_orders(name, params, out_cancels);
+            continue;
+        }
+        if (has_pending_allocation(name)) {
+            continue;
+        }
+        auto plan = compute_hedge_plan(name, it->second, params);
+        if (!plan.has_value()) {
+            continue;
+        }
+        const auto& [symbol, direction, available, volume] = *plan;
+        auto [git, inserted] = groups.try_emplace(symbol);
+        if (inserted) {
+            symbols.push_back(symbol);
+            git->second.params = &params;
+        }
+        // Whole shares: fills are booked as integer position changes.
+        const double shares = std::floor(volume);
+        git->second.requests.push_back(
+            {.strategy_name = &name,
+             .volume = direction == utilities::Direction::LONG ? shares : -shares});
+    }
+
+    for (const std::string& symbol : symbols) {
+        const Group& group = groups[symbol];
+        const utilities::ContractData* contract = group.params->get_contract(symbol);
+        const utilities::UnderlyingData& underlying = *group.params->portfolio->underlying;
+        double buy = 0.0;
+        double sell = 0.0;
+        for (const Request& r : group.requests) {
+            (r.volume > 0 ? buy : sell) += std::abs(r.volume);
+        }
+        const double crossed = std::min(buy, sell);
+        if (crossed > 0 && underlying.mid_price <= 0) {
+            if (out_logs != nullptr) {
+                out_logs->push_back(hedge_log("Hedge netting skipped, no mid: symbol=" + symbol));
+            }
+            continue;
+        }
+        // The larger side keeps a residual for the market; the smaller side is crossed in full.
+        const bool net_long = buy >= sell;
+        const double side_total = net_long ? buy : sell;
+        const double residual = side_total - crossed;
+        const auto on_net_side = [net_long](const Request& r) -> bool {
+            return (r.volume > 0) == net_long;
+        };
+
+        // Net side weights: each request's whole-share part of crossed (and later of residual).
+        std::vector<double> net_weights;
+        for (const Request& r : group.requests) {
+            if (on_net_side(r)) {
+                net_weights.push_back(std::abs(r.volume));
+            }
+        }
+
+        if (crossed > 0 && out_crosses != nullptr) {
+            const uint64_t seq = ++cross_seq_;
+            const std::vector<double> net_crossed = split_whole_shares(crossed, net_weights);
+            size_t leg = 0;
+            size_t net_index = 0;
+            for (const Request& r : group.requests) {
+                const double share =
+                    on_net_side(r) ? net_crossed[net_index++] : std::abs(r.volume);
+                if (share <= 0) {
+                    continue;
+                }
+                utilities::TradeData trade;
+                trade.gateway_name = APP_NAME;
+                trade.symbol = symbol;
+                trade.exchange = contract->exchange;
+                trade.tradeid = "hedge_cross_" + session_ + "_" + std::to_string(seq) + "_" +
+                                std::to_string(leg++);
+                trade.direction =
+                    r.volume > 0 ? utilities::Direction::LONG : utilities::Direction::SHORT;
+                trade.price = underlying.mid_price;
+                trade.volume = share;
+                trade.datetime = std::chrono::system_clock::now();
+                out_crosses->push_back({.strategy_name = *r.strategy_name, .trade = trade});
+            }
+            if (out_logs != nullptr) {
+                out_logs->push_back(hedge_log("Hedge crossed internally: vol=" +
+                                              std::to_string(crossed) + ", symbol=" + symbol));
+            }
+        }
+
+        if (residual < 1 || out_orders == nullptr) {
+            continue;
+        }
+        NettedHedgeOrder order;
+        const std::vector<double> net_residual = split_whole_shares(residual, net_weights);
+        double largest = 0.0;
+        size_t net_index = 0;
+        for (const Request& r : group.requests) {
+            if (!on_net_side(r)) {
+                continue;
+            }
+            const double share = net_residual[net_index++];
+            if (share <= 0) {
+                continue;
+            }
+            order.allocations.push_back({.strategy_name = *r.strategy_name, .volume = share});
+            if (share > largest) {
+                largest = share;
+                order.owner = *r.strategy_name;
+            }
+        }
+        const utilities::Direction direction =
+            net_long ? utilities::Direction::LONG : utilities::Direction::SHORT;
+        order.req = hedge_request(*contract, direction, residual, "Hedge_net_" + symbol);
+        if (out_logs != nullptr) {
+            out_logs->push_back(hedge_log(std::string("Hedge sending netted order: dir=") +
+                                          direction_name(direction) +
+                                          ", vol=" + std::to_string(residual) +
+                                          ", symbol=" + symbol + ", strategies=" +
+                                          std::to_string(order.allocations.size())));
+        }
+        out_orders->push_back(std::move(order));
+    }
+}
+
+void HedgeEngine::track_netted_order(const std::string& orderid,
+                                     std::vector<HedgeAllocation> allocations) {
+    NettedOrderState state;
+    for (const HedgeAllocation& a : allocations) {
+        state.total += a.volume;
+    }
+    state.expected = state.total;
+    state.allocations = std::move(allocations);
+    netted_orders_[orderid] = std::move(state);
+}
+
+auto HedgeEngine::allocate_fill(const utilities::TradeData& trade,
+                                std::vector<HedgeFill>* out_fills) -> bool {
+    auto it = netted_orders_.find(trade.orderid);
+    if (it == netted_orders_.end()) {
+        return false;
     }
-    for (const auto& orderid : it->second) {
-        utilities::OrderData* order = params.get_order(orderid);
-        if ((order != nullptr) && order->reference.find(APP_NAME) != std::string::npos) {
-            out_cancels->push_back(order->create_cancel_request());
+    NettedOrderState& state = it->second;
+    if (state.total > 0 && !state.allocations.empty()) {
+        // Weighted by what is still owed, so the last fill completes every allocation exactly.
+        std::vector<double> owed;
+        owed.reserve(state.allocations.size());
+        double owed_sum = 0.0;
+        for (const HedgeAllocation& a : state.allocations) {
+            owed.push_back(std::max(a.volume - a.filled, 0.0));
+            owed_sum += owed.back();
         }
+        const double volume = std::round(trade.volume);
+        std::vector<double> shares = split_whole_shares(std::min(volume, owed_sum), owed);
+        if (volume > owed_sum) {
+            // Overfill beyond the allocations: the largest one (the order's owner) takes it.
+            const auto largest = std::ranges::max_element(
+                state.allocations, {}, [](const HedgeAllocation& a) -> double { return a.volume; });
+            shares[static_cast<size_t>(largest - state.allocations.begin())] += volume - owed_sum;
+        }
+        size_t leg = 0;
+        for (size_t i = 0; i < state.allocations.size(); ++i) {
+            HedgeAllocation& a = state.allocations[i];
+            a.filled += shares[i];
+            if (shares[i] <= 0 || out_fills == nullptr) {
+                continue;
+            }
+            HedgeFill fill{.strategy_name = a.strategy_name, .trade = trade};
+            fill.trade.tradeid =
+                trade.tradeid + "_alloc_" + session_ + "_" + std::to_string(leg++);
+            fill.trade.volume = shares[i];
+            out_fills->push_back(std::move(fill));
+        }
+    }
+    state.allocated += trade.volume;
+    if (state.allocated >= state.expected - 1e-9) {
+        netted_orders_.erase(it);
+    }
+    return true;
+}
+
+void HedgeEngine::on_order(const utilities::OrderData& order) {
+    auto it = netted_orders_.find(order.orderid);
+    if (it == netted_orders_.end() || order.is_active()) {
+        return;
+    }
+    // Fills may still be in flight behind the final status; wait for the traded volume.
+    it->second.expected = order.traded;
+    if (it->second.allocated >= it->second.expected - 1e-9) {
+        netted_orders_.erase(it);
     }
 }
 
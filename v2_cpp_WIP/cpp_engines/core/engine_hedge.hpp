@@ -1,16 +1,22 @@
 #pragma once
 
-/** HedgeEngine: delta hedging; returns intents (orders/cancels/logs). */
+/**
+ * HedgeEngine: delta hedging; returns intents (orders/cancels/logs). Per strategy by default; in
+ * netting mode the requests of all strategies on one underlying are crossed with each other at
+ * mid and only the residual goes to market as one parent order, whose fills are split back.
+ */
 
 #include "../utilities/base_engine.hpp"
 #include "../utilities/constant.hpp"
 #include "../utilities/object.hpp"
 #include "../utilities/portfolio.hpp"
+#include <cstdint>
 #include <functional>
+#include <memory_resource>
 #include <optional>
-#include <set>
 #include <string>
 #include <tuple>
+#include <utility>
 #include <unordered_map>
 #include <vector>
 
@@ -21,19 +27,43 @@ struct HedgeParams {
     utilities::PortfolioData* portfolio = nullptr;
     utilities::StrategyHolding* holding = nullptr;
     std::function<const utilities::ContractData*(const std::string&)> get_contract;
-    std::function<const std::unordered_map<std::string, std::set<std::string>>&()>
-        get_strategy_active_orders;
-    std::function<utilities::OrderData*(const std::string&)> get_order;
+    /** fn(order) for each active order of a strategy. */
+    std::function<void(const std::string&,
+                       const std::function<void(const utilities::OrderData&)>&)>
+        for_each_active_order;
 };
 
 /** Per-strategy config (Python HedgeConfig). */
 struct HedgeConfig {
     std::string strategy_name;
+    /** Hedging period in runtime timer ticks (the runtime's timer wheel schedules it). */
     int timer_trigger = 5;
     int delta_target = 0;
     int delta_range = 0;
 };
 
+/** Part of a netted parent order owed to a strategy (same direction as the parent). */
+struct HedgeAllocation {
+    std::string strategy_name;
+    /** Whole shares owed. */
+    double volume = 0.0;
+    /** Whole shares booked so far from parent fills. */
+    double filled = 0.0;
+};
+
+/** Trade to book on a strategy's holding (internal cross, or its share of a parent fill). */
+struct HedgeFill {
+    std::string strategy_name;
+    utilities::TradeData trade;
+};
+
+/** Netted parent order: sent under owner, fills split over allocations in whole shares. */
+struct NettedHedgeOrder {
+    std::string owner;
+    utilities::OrderRequest req;
+    std::vector<HedgeAllocation> allocations;
+};
+
 class HedgeEngine : public utilities::BaseEngine {
   public:
     HedgeEngine() = default;
@@ -43,41 +73,105 @@ class HedgeEngine : public utilities::BaseEngine {
                            int delta_target = 0, int delta_range = 0);
     void unregister_strategy(const std::string& strategy_name);
 
-    /** Run hedging; append OrderRequest/CancelRequest/LogData to caller vectors. */
+    /**
+     * Run hedging; append OrderRequest/CancelRequest/LogData to caller vectors (the runtimes back
+     * them with their per-cycle FrameArena).
+     */
     void process_hedging(const std::string& strategy_name, const HedgeParams& params,
-                         std::vector<utilities::OrderRequest>* out_orders,
-                         std::vector<utilities::CancelRequest>* out_cancels,
-                         std::vector<utilities::LogData>* out_logs);
+                         std::pmr::vector<utilities::OrderRequest>* out_orders,
+                         std::pmr::vector<utilities::CancelRequest>* out_cancels,
+                         std::pmr::vector<utilities::LogData>* out_logs);
 
     const std::unordered_map<std::string, HedgeConfig>& registered_strategies() const {
         return registered_strategies_;
     }
 
+    /**
+     * Level pre-check for hedge log lines (e.g. LogEngine::accepts). When it rejects them,
+     * process_* skip out_logs entirely, so no message is built. Unset: always build them.
+     */
+    using LogFilterFn = std::function<bool(int level)>;
+    void set_log_filter(LogFilterFn fn) { log_filter_ = std::move(fn); }
+
+    /** Netting mode: the runtime calls process_netted_hedging for all strategies at once. */
+    void set_netting(bool enabled) { netting_ = enabled; }
+    [[nodiscard]] bool netting() const { return netting_; }
+
+    /**
+     * One netting round over (strategy, params): strategies out of their band are grouped by
+     * underlying; opposite requests are crossed at the underlying mid (out_crosses, to book
+     * directly) and the residual becomes one parent order per underlying. Strategies with a
+     * pending hedge are skipped (their unfinished hedge orders are cancelled, as per strategy).
+     */
+    void process_netted_hedging(const std::vector<std::pair<std::string, HedgeParams>>& strategies,
+                                std::pmr::vector<NettedHedgeOrder>* out_orders,
+                                std::pmr::vector<utilities::CancelRequest>* out_cancels,
+                                std::pmr::vector<HedgeFill>* out_crosses,
+                                std::pmr::vector<utilities::LogData>* out_logs);
+    /** Remember the allocations of a parent order the runtime sent as orderid. */
+    void track_netted_order(const std::string& orderid, std::vector<HedgeAllocation> allocations);
+    [[nodiscard]] bool is_netted_order(const std::string& orderid) const {
+        return netted_orders_.contains(orderid);
+    }
+    /**
+     * Split a parent fill into whole-share per-strategy fills (largest remainder over what each
+     * allocation is still owed; they sum to the fill); false if trade is not of a netted order.
+     */
+    bool allocate_fill(const utilities::TradeData& trade, std::vector<HedgeFill>* out_fills);
+    /** Order update: a terminal parent is forgotten once its traded volume is allocated. */
+    void on_order(const utilities::OrderData& order);
+
   private:
-    static void run_strategy_hedging_with_params(const std::string& strategy_name,
-                                                 HedgeConfig& config, const HedgeParams& params,
-                                                 std::vector<utilities::OrderRequest>* out_orders,
-                                                 std::vector<utilities::CancelRequest>* out_cancels,
-                                                 std::vector<utilities::LogData>* out_logs);
+    struct NettedOrderState {
+        std::vector<HedgeAllocation> allocations;
+        double total = 0.0;
+        double allocated = 0.0;
+        /** Volume still expected to fill: total until the order is terminal, then its traded. */
+        double expected = 0.0;
+    };
+
+    /** Strategy owed part of a parent order that has not fully filled yet. */
+    [[nodiscard]] bool has_pending_allocation(const std::string& strategy_name) const;
+
+    static void
+    run_strategy_hedging_with_params(const std::string& strategy_name, HedgeConfig& config,
+                                     const HedgeParams& params,
+                                     std::pmr::vector<utilities::OrderRequest>* out_orders,
+                                     std::pmr::vector<utilities::CancelRequest>* out_cancels,
+                                     std::pmr::vector<utilities::LogData>* out_logs);
     static std::optional<std::tuple<std::string, utilities::Direction, double, double>>
     compute_hedge_plan(const std::string& strategy_name, HedgeConfig& config,
                        const HedgeParams& params);
     static void execute_hedge_orders(const std::string& strategy_name, const std::string& symbol,
                                      utilities::Direction direction, double available,
                                      double order_volume, const HedgeParams& params,
-                                     std::vector<utilities::OrderRequest>* out_orders,
-                                     std::vector<utilities::LogData>* out_logs);
+                                     std::pmr::vector<utilities::OrderRequest>* out_orders,
+                                     std::pmr::vector<utilities::LogData>* out_logs);
     static void submit_hedge_order(const std::string& strategy_name, const std::string& symbol,
                                    utilities::Direction direction, double volume,
                                    const HedgeParams& params,
-                                   std::vector<utilities::OrderRequest>* out_orders,
-                                   std::vector<utilities::LogData>* out_logs);
+                                   std::pmr::vector<utilities::OrderRequest>* out_orders,
+                                   std::pmr::vector<utilities::LogData>* out_logs);
+    /** out_logs, or nullptr when the log filter rejects hedge log lines. */
+    [[nodiscard]] std::pmr::vector<utilities::LogData>*
+    log_sink(std::pmr::vector<utilities::LogData>* out_logs) const;
     static bool check_strategy_orders_finished(const std::string& strategy_name,
                                                const HedgeParams& params);
     static void cancel_strategy_orders(const std::string& strategy_name, const HedgeParams& params,
-                                       std::vector<utilities::CancelRequest>* out_cancels);
+                                       std::pmr::vector<utilities::CancelRequest>* out_cancels);
 
     std::unordered_map<std::string, HedgeConfig> registered_strategies_;
+    bool netting_ = false;
+    LogFilterFn log_filter_;
+    std::unordered_map<std::string, NettedOrderState> netted_orders_;
+    /**
+     * Start time of this engine (ns since epoch) in every synthetic tradeid, so a restart's
+     * cross and allocation rows never upsert over a previous session's.
+     */
+    std::string session_ = new_session_id();
+    uint64_t cross_seq_ = 0;
+
+    static std::string new_session_id();
 };
 
 } // namespace engines
@@ -1,32 +1,51 @@
 /**
- * Log engine (shared): consumes LogIntent via process_log_intent (no event subscription).
- * write_log builds LogData, pushes to stream buffer, and processes intent.
+ * Log engine (shared): callers check the level and push LogRecords onto their thread's ring; the
+ * log thread (started on the first record) formats them in time order and feeds the sinks.
  */
 
 #include "engine_log.hpp"
-#include <chrono>
-#include <format>
+#include "../utilities/mpsc_ring.hpp"
+#include <algorithm>
+#include <ctime>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
 
 namespace engines {
 
+/** One producer thread's queue for one LogEngine (single producer, drained by the log thread). */
+struct LogEngine::ThreadRing {
+    utilities::MpscRing<LogRecord> ring{1024};
+};
+
 namespace {
 
-auto format_time() -> std::string {
-    auto now = std::chrono::system_clock::now();
-    auto t = std::chrono::system_clock::to_time_t(now);
+constexpr size_t kMaxOverflow = 10000;
+constexpr auto kIdleWait = std::chrono::milliseconds(1);
+
+std::atomic<uint64_t> g_next_engine_id{1};
+
+/** This thread's rings, keyed by engine id (ids are never reused, unlike addresses). */
+struct ThreadRingRef {
+    uint64_t engine_id = 0;
+    std::shared_ptr<LogEngine::ThreadRing> ring;
+};
+thread_local std::vector<ThreadRingRef> t_rings;
+
+auto format_time(std::chrono::system_clock::time_point tp) -> std::string {
+    auto t = std::chrono::system_clock::to_time_t(tp);
     std::ostringstream os;
     // Format: yy-mm-dd HH:MM:SS
     os << std::put_time(std::localtime(&t), "%y-%m-%d %H:%M:%S");
     return os.str();
 }
 
-void default_sink(const utilities::LogData& log) {
-    const std::string ts = log.time.empty() ? format_time() : log.time;
-    std::cout << std::format("{} | {} | {} | {}\n", ts, level_to_string(log.level),
-                             log.gateway_name, log.msg);
+auto format_line(const utilities::LogData& log) -> std::string {
+    const std::string ts =
+        log.time.empty() ? format_time(std::chrono::system_clock::now()) : log.time;
+    return std::format("{} | {} | {} | {}\n", ts, level_to_string(log.level), log.gateway_name,
+                       log.msg);
 }
 
 } // namespace
@@ -47,51 +66,171 @@ auto level_to_string(int level) -> std::string {
     return "CRITICAL";
 }
 
-LogEngine::LogEngine(utilities::MainEngine* main_engine) : BaseEngine(main_engine, "log") {
-    active_ = true;
+auto stdout_log_sink() -> LogSink {
+    return [](const utilities::LogData& log) -> void { std::cout << format_line(log); };
 }
 
-void LogEngine::write_log(const std::string& msg, int level, const std::string& gateway) {
-    utilities::LogData log;
-    log.msg = msg;
-    log.level = level;
-    log.gateway_name = gateway.empty() ? "Main" : gateway;
-    log.time = format_time();
-    {
-        std::scoped_lock lk(stream_mutex_);
-        stream_buffer_.push_back(log);
-        if (stream_buffer_.size() > kMaxStreamBuffer) {
-            stream_buffer_.pop_front();
+auto file_log_sink(const std::string& path) -> LogSink {
+    auto out = std::make_shared<std::ofstream>(path, std::ios::app);
+    return [out](const utilities::LogData& log) -> void {
+        if (*out) {
+            *out << format_line(log);
+            out->flush();
         }
+    };
+}
+
+LogEngine::LogEngine(utilities::MainEngine* main_engine)
+    : BaseEngine(main_engine, "log"), id_(g_next_engine_id.fetch_add(1)) {
+    sinks_.push_back(stdout_log_sink());
+}
+
+LogEngine::~LogEngine() { LogEngine::close(); }
+
+void LogEngine::set_sink(LogSink sink) {
+    std::scoped_lock lk(sinks_mutex_);
+    sinks_.clear();
+    if (sink) {
+        sinks_.push_back(std::move(sink));
+    }
+}
+
+void LogEngine::add_sink(LogSink sink) {
+    if (sink) {
+        std::scoped_lock lk(sinks_mutex_);
+        sinks_.push_back(std::move(sink));
+    }
+}
+
+void LogEngine::write_log(const std::string& msg, int level, const std::string& gateway) {
+    if (accepts(level)) {
+        enqueue(LogRecord(level, gateway.empty() ? "Main" : gateway, msg));
     }
-    stream_cv_.notify_all();
-    process_log_intent(log);
 }
 
 void LogEngine::process_log_intent(const utilities::LogData& data) {
-    if (!active_ || data.level < level_) {
-        return;
+    if (accepts(data.level)) {
+        enqueue(LogRecord(data.level, data.gateway_name, data.msg));
     }
-    if (sink_) {
-        utilities::LogData copy = data;
-        if (copy.time.empty()) {
-            copy.time = format_time();
+}
+
+auto LogEngine::thread_ring() -> ThreadRing& {
+    for (const ThreadRingRef& ref : t_rings) {
+        if (ref.engine_id == id_) {
+            return *ref.ring;
         }
-        sink_(copy);
+    }
+    // First record from this thread: drop refs of destroyed engines, register a new ring.
+    std::erase_if(t_rings, [](const ThreadRingRef& r) -> bool { return r.ring.use_count() == 1; });
+    auto ring = std::make_shared<ThreadRing>();
+    {
+        std::scoped_lock lk(rings_mutex_);
+        rings_.push_back(ring);
+    }
+    t_rings.push_back({.engine_id = id_, .ring = ring});
+    return *ring;
+}
+
+void LogEngine::enqueue(LogRecord&& record) {
+    std::call_once(writer_once_, [this]() -> void {
+        writer_ = std::jthread([this](std::stop_token st) { writer_loop(st); });
+    });
+    queued_.fetch_add(1, std::memory_order_relaxed);
+    if (thread_ring().ring.try_push(std::move(record))) {
+        return;
+    }
+    std::scoped_lock lk(overflow_mutex_);
+    if (overflow_.size() < kMaxOverflow) {
+        overflow_.push_back(std::move(record));
+        has_overflow_.store(true, std::memory_order_release);
     } else {
-        default_sink(data);
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void LogEngine::writer_loop(const std::stop_token& st) {
+    while (!st.stop_requested()) {
+        if (!drain()) {
+            std::this_thread::sleep_for(kIdleWait);
+        }
+    }
+    while (drain()) {
     }
 }
 
-auto LogEngine::pop_log_for_stream(utilities::LogData& out, int timeout_ms) -> bool {
-    std::unique_lock<std::mutex> lk(stream_mutex_);
-    if (!stream_cv_.wait_for(lk, std::chrono::milliseconds(timeout_ms),
-                             [this]() -> bool { return !stream_buffer_.empty(); })) {
+auto LogEngine::drain() -> bool {
+    std::vector<LogRecord> batch;
+    {
+        std::scoped_lock lk(rings_mutex_);
+        for (const auto& r : rings_) {
+            r->ring.pop_batch([&](LogRecord&& rec) -> void { batch.push_back(std::move(rec)); },
+                              r->ring.capacity());
+        }
+        // Only rings_ still holds the ring of an exited thread; drop it once it is empty.
+        std::erase_if(rings_, [](const std::shared_ptr<ThreadRing>& r) -> bool {
+            return r.use_count() == 1 && !r->ring.ready();
+        });
+    }
+    if (has_overflow_.load(std::memory_order_acquire)) {
+        std::scoped_lock lk(overflow_mutex_);
+        std::ranges::move(overflow_, std::back_inserter(batch));
+        overflow_.clear();
+        has_overflow_.store(false, std::memory_order_release);
+    }
+    const uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+    if (batch.empty() && dropped == 0) {
         return false;
     }
-    out = stream_buffer_.front();
-    stream_buffer_.pop_front();
+    // Rings are drained one thread at a time; restore the cross-thread order.
+    std::ranges::stable_sort(batch, {}, &LogRecord::time);
+    for (const LogRecord& rec : batch) {
+        emit(rec);
+    }
+    if (dropped != 0) {
+        emit(LogRecord(WARNING, "log",
+                       std::format("{} log records dropped (queue full)", dropped)));
+    }
+    {
+        std::scoped_lock lk(done_mutex_);
+        done_ += batch.size() + dropped;
+    }
+    done_cv_.notify_all();
     return true;
 }
 
+void LogEngine::emit(const LogRecord& record) {
+    const auto sec = std::chrono::duration_cast<std::chrono::seconds>(
+                         record.time().time_since_epoch())
+                         .count();
+    if (sec != time_sec_) {
+        time_sec_ = sec;
+        time_str_ = format_time(record.time());
+    }
+    utilities::LogData log;
+    log.msg = record.message();
+    log.level = record.level();
+    log.gateway_name = record.gateway();
+    log.time = time_str_;
+    {
+        std::scoped_lock lk(sinks_mutex_);
+        for (const LogSink& sink : sinks_) {
+            sink(log);
+        }
+    }
+}
+
+void LogEngine::flush() {
+    const uint64_t target = queued_.load(std::memory_order_relaxed);
+    std::unique_lock lk(done_mutex_);
+    done_cv_.wait(lk, [&]() -> bool { return done_ >= target || !writer_.joinable(); });
+}
+
+void LogEngine::close() {
+    writer_.request_stop();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+    done_cv_.notify_all();
+}
+
 } // namespace engines
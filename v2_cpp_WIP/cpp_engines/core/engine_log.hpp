@@ -1,15 +1,30 @@
 #pragma once
 
-/** LogEngine: process_log_intent, format, stdout sink. */
+/**
+ * LogEngine: level check on the calling thread, then a per-thread lock-free ring; one log thread
+ * formats and hands LogData to the sinks (stdout by default, file, gRPC broadcast hub).
+ */
 
 #include "../utilities/base_engine.hpp"
 #include "../utilities/object.hpp"
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstddef>
 #include <cstdint>
-#include <deque>
+#include <format>
 #include <functional>
+#include <memory>
 #include <mutex>
+#include <new>
+#include <stop_token>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace engines {
 
@@ -25,37 +40,198 @@ inline constexpr int DISABLED = 99;
 /** Level to string. */
 std::string level_to_string(int level);
 
-/** Log sink; default stdout. */
+/** Log sink; called on the log thread with the formatted record. */
 using LogSink = std::function<void(const utilities::LogData&)>;
 
+/** "time | LEVEL | gateway | msg" lines on stdout (the default sink). */
+LogSink stdout_log_sink();
+/** Same lines appended to path (opened once; records are dropped if it cannot open). */
+LogSink file_log_sink(const std::string& path);
+
+/**
+ * One deferred log statement: level, timestamp, gateway and the arguments by value, formatted on
+ * the log thread. Arguments live inline up to kInline bytes; bigger sets format eagerly.
+ */
+class LogRecord {
+  public:
+    LogRecord() = default;
+    /** Preformatted message. */
+    LogRecord(int level, std::string_view gateway, std::string msg)
+        : level_(level), time_(std::chrono::system_clock::now()), gateway_(gateway),
+          text_(std::move(msg)) {}
+
+    template <typename... Args>
+    LogRecord(int level, std::string_view gateway, std::format_string<Args...> fmt,
+              Args&&... args)
+        : level_(level), time_(std::chrono::system_clock::now()), gateway_(gateway) {
+        using Tuple = std::tuple<Capture<Args>...>;
+        if constexpr (sizeof(Tuple) <= kInline && alignof(Tuple) <= alignof(std::max_align_t)) {
+            ::new (static_cast<void*>(storage_)) Tuple(std::forward<Args>(args)...);
+            fmt_ = fmt.get();
+            ops_ = &kOps<Tuple>;
+        } else {
+            text_ = std::format(fmt, std::forward<Args>(args)...);
+        }
+    }
+
+    LogRecord(LogRecord&& other) noexcept { take(other); }
+    LogRecord& operator=(LogRecord&& other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+    LogRecord(const LogRecord&) = delete;
+    LogRecord& operator=(const LogRecord&) = delete;
+    ~LogRecord() { reset(); }
+
+    [[nodiscard]] int level() const { return level_; }
+    [[nodiscard]] std::chrono::system_clock::time_point time() const { return time_; }
+    [[nodiscard]] const std::string& gateway() const { return gateway_; }
+    /** Message text (formats captured arguments). */
+    [[nodiscard]] std::string message() const {
+        return ops_ != nullptr ? ops_->format(fmt_, storage_) : text_;
+    }
+
+  private:
+    static constexpr size_t kInline = 128;
+
+    /** Strings and string views are copied; everything else is stored decayed. */
+    template <typename T>
+    using Capture =
+        std::conditional_t<std::is_convertible_v<const std::decay_t<T>&, std::string_view>,
+                           std::string, std::decay_t<T>>;
+
+    struct Ops {
+        void (*move)(std::byte* dst, std::byte* src);
+        void (*destroy)(std::byte* p);
+        std::string (*format)(std::string_view fmt, const std::byte* p);
+    };
+    template <typename Tuple>
+    static constexpr Ops kOps{
+        .move =
+            [](std::byte* dst, std::byte* src) -> void {
+                auto* s = std::launder(reinterpret_cast<Tuple*>(src));
+                ::new (static_cast<void*>(dst)) Tuple(std::move(*s));
+                s->~Tuple();
+            },
+        .destroy =
+            [](std::byte* p) -> void { std::launder(reinterpret_cast<Tuple*>(p))->~Tuple(); },
+        .format = [](std::string_view fmt, const std::byte* p) -> std::string {
+            const auto& t = *std::launder(reinterpret_cast<const Tuple*>(p));
+            return std::apply(
+                [fmt](const auto&... a) -> std::string {
+                    return std::vformat(fmt, std::make_format_args(a...));
+                },
+                t);
+        }};
+
+    void take(LogRecord& other) {
+        level_ = other.level_;
+        time_ = other.time_;
+        gateway_ = std::move(other.gateway_);
+        text_ = std::move(other.text_);
+        fmt_ = other.fmt_;
+        ops_ = std::exchange(other.ops_, nullptr);
+        if (ops_ != nullptr) {
+            ops_->move(storage_, other.storage_);
+        }
+    }
+    void reset() {
+        if (ops_ != nullptr) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    int level_ = INFO;
+    std::chrono::system_clock::time_point time_{};
+    std::string gateway_;
+    std::string text_;
+    std::string_view fmt_;
+    const Ops* ops_ = nullptr;
+    alignas(std::max_align_t) std::byte storage_[kInline]{};
+};
+
 class LogEngine : public utilities::BaseEngine {
   public:
     explicit LogEngine(utilities::MainEngine* main_engine);
+    ~LogEngine() override;
 
-    void set_sink(LogSink sink) { sink_ = std::move(sink); }
+    /** Replace every sink (default: stdout). */
+    void set_sink(LogSink sink);
+    /** Add a sink next to the current ones (e.g. file_log_sink). */
+    void add_sink(LogSink sink);
     void set_active(bool active) { active_ = active; }
     /** Output when level >= threshold; DISABLED = suppress. */
     void set_level(int level) { level_ = level; }
-    int level() const { return level_; }
+    int level() const { return level_.load(std::memory_order_relaxed); }
+    /** Cheap pre-check for callers that build messages themselves. */
+    [[nodiscard]] bool accepts(int level) const {
+        return active_.load(std::memory_order_relaxed) &&
+               level >= level_.load(std::memory_order_relaxed);
+    }
 
-    /** Format, buffer, process_log_intent. */
+    /**
+     * Hot-path log: returns after the level check when filtered; otherwise captures args by value
+     * and queues them, formatting happens on the log thread.
+     */
+    template <typename... Args>
+    void log(int level, std::string_view gateway, std::format_string<Args...> fmt,
+             Args&&... args) {
+        if (accepts(level)) {
+            enqueue(LogRecord(level, gateway, fmt, std::forward<Args>(args)...));
+        }
+    }
+
+    /** Queue a preformatted message (gateway empty => "Main"). */
     void write_log(const std::string& msg, int level = INFO, const std::string& gateway = "");
 
     /** Consume LogIntent. */
     void process_log_intent(const utilities::LogData& data);
 
-    /** Pop log for gRPC stream. */
-    bool pop_log_for_stream(utilities::LogData& out, int timeout_ms);
+    /** Block until records queued before the call reached the sinks. */
+    void flush();
+    /** Stop the log thread after draining what is queued. */
+    void close() override;
+
+    struct ThreadRing;
 
   private:
-    static constexpr size_t kMaxStreamBuffer = 1000;
+    void enqueue(LogRecord&& record);
+    ThreadRing& thread_ring();
+    void writer_loop(const std::stop_token& st);
+    /** Drain every ring into the sinks; false if nothing was queued. */
+    bool drain();
+    void emit(const LogRecord& record);
 
-    bool active_ = true;
-    int level_ = INFO;
-    LogSink sink_;
-    std::deque<utilities::LogData> stream_buffer_;
-    std::mutex stream_mutex_;
-    std::condition_variable stream_cv_;
+    const uint64_t id_;
+    std::atomic<bool> active_{true};
+    std::atomic<int> level_{INFO};
+
+    std::mutex sinks_mutex_;
+    std::vector<LogSink> sinks_;
+
+    /** Registered producer rings; the log thread drains them in turn. */
+    std::mutex rings_mutex_;
+    std::vector<std::shared_ptr<ThreadRing>> rings_;
+    /** A thread's ring was full: oldest-first spill, bounded; beyond it records are counted. */
+    std::mutex overflow_mutex_;
+    std::vector<LogRecord> overflow_;
+    std::atomic<bool> has_overflow_{false};
+    std::atomic<uint64_t> dropped_{0};
+
+    std::atomic<uint64_t> queued_{0};
+    std::mutex done_mutex_;
+    std::condition_variable done_cv_;
+    uint64_t done_ = 0;
+
+    std::once_flag writer_once_;
+    std::jthread writer_;
+    /** Log thread: cached "%y-%m-%d %H:%M:%S" of the last second formatted. */
+    int64_t time_sec_ = -1;
+    std::string time_str_;
 };
 
 } // namespace engines
@@ -2,18 +2,34 @@
 #include "../strategy/strategy_registry.hpp"
 #include "../strategy/template.hpp"
 #include "../utilities/event.hpp"
+#include "../utilities/intent.hpp"
+#include "../utilities/thread_pool.hpp"
 #include "../utilities/utility.hpp"
+#include <algorithm>
+#include <exception>
 #include <format>
 #include <fstream>
 #include <iterator>
 #include <nlohmann/json.hpp>
+#include <optional>
 #include <ranges>
 #include <stdexcept>
 #include <string>
 #include <utility>
+#include <variant>
 
 namespace {
 
+/** What one strategy emitted during a parallel timer round, replayed afterwards. */
+struct TimerBatch {
+    /** Intents and deferred effects, in the order the strategy issued them. */
+    std::vector<std::variant<utilities::Intent, std::function<void()>>> work;
+    std::optional<std::string> error;
+};
+
+/** Batch of the strategy running on this thread; nullptr outside a parallel round. */
+thread_local TimerBatch* t_timer_batch = nullptr;
+
 auto extract_class_name(const std::string& strategy_name) -> std::string {
     std::size_t pos = strategy_name.find('_');
     if (pos == std::string::npos) {
@@ -101,10 +117,60 @@ void OptionStrategyEngine::process_trade(const utilities::TradeData& trade) {
         auto* s = get_strategy(strategy_name);
         if (s != nullptr) {
             s->on_trade(trade);
+            // A fill outside the active chains makes its chain held: it gets Greeks from now on.
+            const utilities::PortfolioData* portfolio = s->portfolio();
+            const utilities::OptionData* option =
+                portfolio != nullptr ? portfolio->find_option(trade.symbol) : nullptr;
+            if (option != nullptr && option->chain != nullptr &&
+                !portfolio->is_chain_active(option->chain->chain_symbol)) {
+                refresh_active_chains(s->portfolio_name());
+            }
         }
     }
 }
 
+void OptionStrategyEngine::refresh_active_chains(const std::string& portfolio_name) {
+    utilities::PortfolioData* portfolio = get_portfolio(portfolio_name);
+    if (portfolio == nullptr) {
+        return;
+    }
+    std::vector<std::string> active;
+    const auto add_held = [portfolio, &active](const std::string& symbol) -> void {
+        const utilities::OptionData* option = portfolio->find_option(symbol);
+        if (option != nullptr && option->chain != nullptr) {
+            active.push_back(option->chain->chain_symbol);
+        }
+    };
+    for (const auto& [name, strategy] : strategies_) {
+        if (!strategy || strategy->portfolio_name() != portfolio_name) {
+            continue;
+        }
+        // A strategy that never subscribed may read any chain.
+        if (strategy->subscribed_chains().empty()) {
+            portfolio->set_active_chains({});
+            return;
+        }
+        std::ranges::copy(strategy->subscribed_chains(), std::back_inserter(active));
+        const utilities::StrategyHolding* holding = get_strategy_holding(name);
+        if (holding == nullptr) {
+            continue;
+        }
+        for (const auto& [_, position] : holding->optionPositions) {
+            if (position.quantity == 0) {
+                continue;
+            }
+            if (position.legs.empty()) {
+                add_held(position.symbol);
+            }
+            for (const utilities::OptionPositionData& leg : position.legs) {
+                add_held(leg.symbol);
+            }
+        }
+    }
+    // No strategy left on the portfolio: back to every chain.
+    portfolio->set_active_chains(std::move(active));
+}
+
 auto OptionStrategyEngine::get_strategy(const std::string& strategy_name)
     -> strategy_cpp::OptionStrategyTemplate* {
     auto it = strategies_.find(strategy_name);
@@ -149,16 +215,19 @@ auto OptionStrategyEngine::get_contract(const std::string& symbol) const
 }
 
 void OptionStrategyEngine::write_log(const std::string& msg, int level) const {
-    if (api_.system.write_log) {
-        utilities::LogData log;
-        log.msg = msg;
-        log.level = level;
-        log.gateway_name = "Strategy";
-        api_.system.write_log(log);
-    }
+    utilities::LogData log;
+    log.msg = msg;
+    log.level = level;
+    log.gateway_name = "Strategy";
+    write_log(log);
 }
 
 void OptionStrategyEngine::write_log(const utilities::LogData& log) const {
+    if (t_timer_batch != nullptr) {
+        t_timer_batch->work.emplace_back(std::in_place_type<utilities::Intent>,
+                                         utilities::IntentLog{log});
+        return;
+    }
     if (api_.system.write_log) {
         api_.system.write_log(log);
     }
@@ -169,6 +238,11 @@ auto OptionStrategyEngine::send_order(const std::string& strategy_name,
     if (!api_.execution.send_order) {
         return {};
     }
+    if (t_timer_batch != nullptr) {
+        t_timer_batch->work.emplace_back(std::in_place_type<utilities::Intent>,
+                                         utilities::IntentSendOrder{strategy_name, req});
+        return {};
+    }
     return api_.execution.send_order ? api_.execution.send_order(strategy_name, req)
                                      : std::string{};
 }
@@ -312,10 +386,12 @@ auto OptionStrategyEngine::remove_strategy(const std::string& strategy_name) ->
     if (api_.execution.remove_strategy_tracking) {
         api_.execution.remove_strategy_tracking(strategy_name);
     }
+    const std::string portfolio_name = it->second ? it->second->portfolio_name() : std::string{};
     strategies_.erase(it);
     if (api_.portfolio.remove_strategy_holding) {
         api_.portfolio.remove_strategy_holding(strategy_name);
     }
+    refresh_active_chains(portfolio_name);
     if (api_.system.put_strategy_event) {
         utilities::StrategyUpdateData u;
         u.strategy_name = strategy_name;
@@ -385,14 +461,6 @@ void OptionStrategyEngine::add_strategy(const std::string& class_name,
     }
 }
 
-void OptionStrategyEngine::on_timer() {
-    for (auto& [_, s] : strategies_) {
-        if (s) {
-            s->on_timer();
-        }
-    }
-}
-
 auto OptionStrategyEngine::get_order(const std::string& orderid) const -> utilities::OrderData* {
     return api_.execution.get_order ? api_.execution.get_order(orderid) : nullptr;
 }
@@ -423,11 +491,12 @@ auto OptionStrategyEngine::get_all_active_orders() const -> std::vector<utilitie
                                                 : std::vector<utilities::OrderData>{};
 }
 
-auto OptionStrategyEngine::get_strategy_active_orders() const
-    -> const std::unordered_map<std::string, std::set<std::string>>& {
-    static const std::unordered_map<std::string, std::set<std::string>> empty;
-    return api_.execution.get_strategy_active_orders ? api_.execution.get_strategy_active_orders()
-                                                     : empty;
+void OptionStrategyEngine::for_each_active_order(
+    const std::string& strategy_name,
+    const std::function<void(const utilities::OrderData&)>& fn) const {
+    if (api_.execution.for_each_active_order) {
+        api_.execution.for_each_active_order(strategy_name, fn);
+    }
 }
 
 auto OptionStrategyEngine::get_strategy_names() const -> std::vector<std::string> {
@@ -446,6 +515,67 @@ void OptionStrategyEngine::close() {
     strategies_.clear();
 }
 
+void OptionStrategyEngine::on_timer(std::span<const std::string> strategy_names) {
+    std::vector<strategy_cpp::OptionStrategyTemplate*> strategies;
+    strategies.reserve(strategy_names.size());
+    for (const std::string& name : strategy_names) {
+        if (auto* s = get_strategy(name)) {
+            strategies.push_back(s);
+        }
+    }
+    if (!parallel_timers_ || strategies.size() < 2) {
+        for (auto* s : strategies) {
+            s->on_timer();
+        }
+        return;
+    }
+    std::vector<TimerBatch> batches(strategies.size());
+    utilities::ThreadPool::shared().parallel_for(
+        strategies.size(),
+        [&strategies, &batches](size_t begin, size_t end) -> void {
+            for (size_t i = begin; i < end; ++i) {
+                t_timer_batch = &batches[i];
+                try {
+                    strategies[i]->on_timer();
+                } catch (const std::exception& e) {
+                    batches[i].error = e.what();
+                }
+                t_timer_batch = nullptr;
+            }
+        },
+        1);
+    // Replay each strategy's work in issue order: the round then acts like the serial path.
+    for (size_t i = 0; i < strategies.size(); ++i) {
+        for (const auto& item : batches[i].work) {
+            if (const auto* effect = std::get_if<std::function<void()>>(&item)) {
+                (*effect)();
+                continue;
+            }
+            const utilities::Intent& intent = std::get<utilities::Intent>(item);
+            if (const auto* order = std::get_if<utilities::IntentSendOrder>(&intent)) {
+                send_order(order->strategy_name, order->req);
+            } else if (const auto* log = std::get_if<utilities::IntentLog>(&intent)) {
+                write_log(log->log);
+            } else if (const auto* cancel = std::get_if<utilities::IntentCancelOrder>(&intent)) {
+                if (api_.execution.cancel_order) {
+                    api_.execution.cancel_order(cancel->req);
+                }
+            }
+        }
+        if (batches[i].error) {
+            strategies[i]->set_error(*batches[i].error);
+        }
+    }
+}
+
+void OptionStrategyEngine::run_or_defer(std::function<void()> fn) const {
+    if (t_timer_batch != nullptr) {
+        t_timer_batch->work.emplace_back(std::move(fn));
+        return;
+    }
+    fn();
+}
+
 auto OptionStrategyEngine::combo_builder_engine() const -> engines::ComboBuilderEngine* {
     return api_.system.get_combo_builder_engine ? api_.system.get_combo_builder_engine() : nullptr;
 }
@@ -14,11 +14,9 @@
 #include "runtime_api.hpp"
 #include <functional>
 #include <memory>
-#include <set>
 #include <span>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 namespace strategy_cpp {
@@ -78,8 +76,6 @@ class OptionStrategyEngine : public utilities::BaseEngine {
     /** Remove strategy and clear holding; returns success. */
     bool remove_strategy(const std::string& strategy_name);
 
-    /** Call on_timer for all strategies (event-driven). */
-    void on_timer();
     utilities::OrderData* get_order(const std::string& orderid) const;
     utilities::TradeData* get_trade(const std::string& tradeid) const;
     /** Get strategy_name by orderid for save_order_data. */
@@ -87,21 +83,35 @@ class OptionStrategyEngine : public utilities::BaseEngine {
     std::vector<utilities::OrderData> get_all_orders() const;
     std::vector<utilities::TradeData> get_all_trades() const;
     std::vector<utilities::OrderData> get_all_active_orders() const;
-    const std::unordered_map<std::string, std::set<std::string>>&
-    get_strategy_active_orders() const;
+    void for_each_active_order(const std::string& strategy_name,
+                               const std::function<void(const utilities::OrderData&)>& fn) const;
+    /**
+     * Active chains of portfolio_name: the union of its strategies' subscribed chains and their
+     * held options' chains, or every chain while one of them has not subscribed.
+     */
+    void refresh_active_chains(const std::string& portfolio_name);
     /** Loaded strategy names (for hedge iteration). */
     std::vector<std::string> get_strategy_names() const;
 
+    /**
+     * Run on_timer of the named strategies, in order. With parallel timers on they run at once
+     * on the shared pool; the portfolios must not change meanwhile (the runtime holds them) and
+     * each strategy's orders, logs and deferred effects are buffered in issue order, then
+     * replayed strategy by strategy in names order, so the outcome does not depend on
+     * scheduling. In such a round send_order returns no orderid: the order is sent at replay
+     * and reported through on_order.
+     */
+    void on_timer(std::span<const std::string> strategy_names);
+    void set_parallel_timers(bool parallel) { parallel_timers_ = parallel; }
+    [[nodiscard]] bool parallel_timers() const { return parallel_timers_; }
+    /** Run fn now, or at replay when called from a strategy inside a parallel timer round. */
+    void run_or_defer(std::function<void()> fn) const;
+
     void close() override;
 
     engines::ComboBuilderEngine* combo_builder_engine() const;
     engines::HedgeEngine* hedge_engine() const;
 
-    /** Backtest: insert orderid after append_order. */
-    std::unordered_set<std::string>& active_order_ids() {
-        return api_.execution.get_active_order_ids ? api_.execution.get_active_order_ids()
-                                                   : dummy_active_order_ids_;
-    }
     /** Remove orderid tracking on cancel. */
     void remove_order_tracking(const std::string& orderid) const;
 
@@ -110,11 +120,11 @@ class OptionStrategyEngine : public utilities::BaseEngine {
     load_strategy_defaults(const std::string& class_name) const;
 
     RuntimeAPI api_;
+    bool parallel_timers_ = false;
     bool strategy_config_loaded_ = false;
     std::unordered_map<std::string, std::unordered_map<std::string, double>> strategy_defaults_;
     std::unordered_map<std::string, std::unique_ptr<strategy_cpp::OptionStrategyTemplate>>
         strategies_;
-    std::unordered_set<std::string> dummy_active_order_ids_;
 
     // Order assembly
     bool assemble_order_request(const std::string& strategy_name, const std::string& symbol,
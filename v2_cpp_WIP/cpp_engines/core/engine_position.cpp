@@ -1,12 +1,18 @@
 /**
  * Shared PositionEngine (from engines/engine_position.py).
  * Same logic: holdings, process_order/process_trade, apply_position_change, update_metrics.
- * Serialize/load_serialized_holding use protobuf (StrategyHoldingMsg) for binary schema.
+ * Serialize/load_serialized_holding use protobuf (StrategyHoldingMsg) for binary schema; the
+ * holding journal frames HoldingJournalRecord messages built on the same per-thread arena.
  */
 
 #include "engine_position.hpp"
 #include "otrader_engine.pb.h"
+#include <algorithm>
+#include <bit>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <google/protobuf/arena.h>
 #include <sstream>
 #include <stdexcept>
 
@@ -166,21 +172,134 @@ void option_msg_to_option_position(const otrader::OptionPositionMsg& om,
         opt->legs.push_back(std::move(leg));
     }
 }
+
+void option_position_to_msg(const utilities::OptionPositionData& o,
+                            otrader::OptionPositionMsg* om) {
+    base_position_to_option_msg(o, om);
+    om->set_combo_type(
+        combo_type_to_enum_name(o.combo_type.value_or(utilities::ComboType::SINGLE_LEG)));
+    for (const auto& leg : o.legs) {
+        base_position_to_msg(leg, om->add_legs());
+    }
+}
+
+void holding_to_msg(const utilities::StrategyHolding& holding, otrader::StrategyHoldingMsg* msg) {
+    base_position_to_msg(holding.underlyingPosition, msg->mutable_underlying());
+    for (const auto& kv : holding.optionPositions) {
+        option_position_to_msg(kv.second, &(*msg->mutable_options())[kv.first]);
+    }
+    otrader::PortfolioSummaryMsg* sm = msg->mutable_summary();
+    sm->set_total_cost(holding.summary.total_cost);
+    sm->set_current_value(holding.summary.current_value);
+    sm->set_unrealized_pnl(holding.summary.unrealized_pnl);
+    sm->set_realized_pnl(holding.summary.realized_pnl);
+    sm->set_pnl(holding.summary.pnl);
+    sm->set_delta(holding.summary.delta);
+    sm->set_gamma(holding.summary.gamma);
+    sm->set_theta(holding.summary.theta);
+    sm->set_vega(holding.summary.vega);
+}
+
+/** Positions (and summary) msg carries into holding; replace also drops options it lacks. */
+void msg_to_holding(const otrader::StrategyHoldingMsg& msg, utilities::StrategyHolding& holding,
+                    bool replace) {
+    if (msg.has_underlying()) {
+        msg_to_base_position(msg.underlying(), &holding.underlyingPosition);
+    }
+    if (replace) {
+        holding.optionPositions.clear();
+    }
+    holding.valued_portfolio = nullptr; // running totals no longer match
+    for (const auto& [sym, optMsg] : msg.options()) {
+        utilities::OptionPositionData opt(sym);
+        option_msg_to_option_position(optMsg, &opt);
+        holding.optionPositions[sym] = std::move(opt);
+    }
+    if (msg.has_summary()) {
+        const otrader::PortfolioSummaryMsg& sm = msg.summary();
+        holding.summary.total_cost = sm.total_cost();
+        holding.summary.current_value = sm.current_value();
+        holding.summary.unrealized_pnl = sm.unrealized_pnl();
+        holding.summary.realized_pnl = sm.realized_pnl();
+        holding.summary.pnl = sm.pnl();
+        holding.summary.delta = sm.delta();
+        holding.summary.gamma = sm.gamma();
+        holding.summary.theta = sm.theta();
+        holding.summary.vega = sm.vega();
+    }
+}
+
+/**
+ * Per-thread arena for holding messages. Reset() keeps only the initial block, so the block is
+ * regrown to the largest message built so far; from then on building one does not touch the heap.
+ */
+class MessageArena {
+  public:
+    /** Arena emptied for the next message (messages created on it before are gone). */
+    auto fresh() -> google::protobuf::Arena& {
+        if (arena_.has_value()) {
+            const uint64_t used = arena_->SpaceAllocated();
+            if (used <= block_.size()) {
+                arena_->Reset();
+                return *arena_;
+            }
+            arena_.reset();
+            block_.resize(std::bit_ceil(static_cast<size_t>(used)));
+        }
+        google::protobuf::ArenaOptions options;
+        options.initial_block = block_.data();
+        options.initial_block_size = block_.size();
+        return arena_.emplace(options);
+    }
+
+  private:
+    static constexpr size_t kInitialBlock = size_t{16} << 10;
+
+    std::vector<char> block_ = std::vector<char>(kInitialBlock);
+    std::optional<google::protobuf::Arena> arena_;
+};
+
+auto holding_arena() -> google::protobuf::Arena& {
+    thread_local MessageArena arena;
+    return arena.fresh();
+}
+
+auto new_journal_record(const std::string& strategy_name,
+                        otrader::HoldingJournalRecord::Kind kind)
+    -> otrader::HoldingJournalRecord* {
+    auto* rec = google::protobuf::Arena::Create<otrader::HoldingJournalRecord>(&holding_arena());
+    rec->set_strategy_name(strategy_name);
+    rec->set_kind(kind);
+    return rec;
+}
+
+/** rec behind a host-order uint32 length; the journal never leaves the machine that wrote it. */
+void append_record(const otrader::HoldingJournalRecord& rec, std::string& out) {
+    const auto len = static_cast<uint32_t>(rec.ByteSizeLong());
+    const size_t at = out.size();
+    out.resize(at + sizeof(len) + len);
+    std::memcpy(out.data() + at, &len, sizeof(len));
+    rec.SerializeWithCachedSizesToArray(
+        reinterpret_cast<uint8_t*>(out.data() + at + sizeof(len)));
+}
 } // namespace
 
+auto PositionEngine::portfolio_name(const std::string& strategy_name) -> std::string {
+    size_t p = strategy_name.find('_');
+    if (p != std::string::npos && p + 1 < strategy_name.size()) {
+        return strategy_name.substr(p + 1);
+    }
+    return strategy_name;
+}
+
 void PositionEngine::process_timer_event(const GetPortfolioFn& get_portfolio,
-                                         std::vector<utilities::LogData>* out_logs) {
+                                         std::pmr::vector<utilities::LogData>* out_logs) {
     if (!get_portfolio) {
         return;
     }
     for (auto& kv : strategy_holdings_) {
         try {
-            std::string portfolio_name = kv.first;
-            size_t p = kv.first.find('_');
-            if (p != std::string::npos && p + 1 < kv.first.size()) {
-                portfolio_name = kv.first.substr(p + 1);
-            }
-            utilities::PortfolioData* portfolio = get_portfolio(portfolio_name);
+            utilities::PortfolioData* portfolio = get_portfolio(portfolio_name(kv.first));
             if (portfolio != nullptr) {
                 update_metrics(kv.first, portfolio);
             }
@@ -198,24 +317,33 @@ void PositionEngine::process_timer_event(const GetPortfolioFn& get_portfolio,
 
 void PositionEngine::process_order(const std::string& strategy_name,
                                    const utilities::OrderData& order) {
-    OrderMeta meta;
-    meta.is_combo = order.is_combo;
-    meta.symbol = order.symbol;
-    if (order.combo_type.has_value()) {
-        meta.combo_type = utilities::to_string(order.combo_type.value());
-    }
-    if (order.is_combo && order.legs.has_value()) {
-        for (const auto& leg : order.legs.value()) {
-            std::map<std::string, std::string> m;
-            m["symbol"] = leg.symbol.value_or("N/A");
-            m["con_id"] = std::to_string(leg.con_id);
-            m["ratio"] = std::to_string(leg.ratio);
-            m["direction"] = utilities::to_string(leg.direction);
-            meta.legs.push_back(m);
+    auto [it, inserted] = order_meta_.try_emplace(order.orderid);
+    OrderMeta& meta = it->second;
+    if (inserted) {
+        meta.is_combo = order.is_combo;
+        meta.symbol = order.symbol;
+        meta.combo_type = order.combo_type;
+        if (order.is_combo && order.legs.has_value()) {
+            meta.legs.reserve(order.legs->size());
+            for (const auto& leg : order.legs.value()) {
+                meta.legs.push_back({.symbol = leg.symbol.value_or("N/A"),
+                                     .con_id = leg.con_id,
+                                     .ratio = leg.ratio,
+                                     .direction = leg.direction});
+            }
+        }
+    }
+    if (meta.strategy_name.empty()) {
+        meta.strategy_name = strategy_name;
+    }
+    if (!order.is_active() && !meta.retired) {
+        meta.retired = true;
+        retired_orders_.push_back(order.orderid);
+        while (retired_orders_.size() > kRetiredOrderWindow) {
+            order_meta_.erase(retired_orders_.front());
+            retired_orders_.pop_front();
         }
     }
-    meta.strategy_name = strategy_name;
-    order_meta_[order.orderid] = std::move(meta);
 
     // Debug log
     if (order.is_combo && has_main()) {
@@ -228,10 +356,9 @@ void PositionEngine::process_order(const std::string& strategy_name,
 
 void PositionEngine::process_trade(const std::string& strategy_name,
                                    const utilities::TradeData& trade) {
-    if (static_cast<unsigned int>(trade_seen_.contains(trade.tradeid)) != 0U) {
+    if (!trade_seen_.insert(trade.tradeid)) {
         return;
     }
-    trade_seen_.insert(trade.tradeid);
 
     std::string eff_strategy_name = strategy_name;
     auto meta_for_strategy = order_meta_.find(trade.orderid);
@@ -250,15 +377,18 @@ void PositionEngine::process_trade(const std::string& strategy_name,
 
     get_create_strategy_holding(eff_strategy_name);
     utilities::StrategyHolding& holding = strategy_holdings_[eff_strategy_name];
+    HoldingChanges* changes = changes_for(eff_strategy_name);
 
     auto meta_it = order_meta_.find(trade.orderid);
     if (meta_it != order_meta_.end() && meta_it->second.is_combo) {
         const OrderMeta& meta = meta_it->second;
-        utilities::ComboType combo_type = meta.combo_type.has_value()
-                                              ? combo_type_from_string(meta.combo_type.value())
-                                              : utilities::ComboType::CUSTOM;
+        utilities::ComboType combo_type = meta.combo_type.value_or(utilities::ComboType::CUSTOM);
         utilities::OptionPositionData* opt =
             get_or_create_option_position(holding, meta.symbol, combo_type, &meta.legs);
+        opt->revalue = true;
+        if (changes != nullptr) {
+            changes->options.insert(opt->symbol);
+        }
         if (trade.symbol == meta.symbol) {
             apply_position_change(opt, trade);
             if (has_main()) {
@@ -281,10 +411,16 @@ void PositionEngine::process_trade(const std::string& strategy_name,
 
     if (trade.symbol.size() >= 4 && trade.symbol.substr(trade.symbol.size() - 4) == ".STK") {
         apply_underlying_trade(holding, trade);
+        if (changes != nullptr) {
+            changes->underlying = true;
+        }
         return;
     }
 
     apply_single_leg_option_trade(holding, trade);
+    if (changes != nullptr) {
+        changes->options.insert(trade.symbol);
+    }
 }
 
 void PositionEngine::get_create_strategy_holding(const std::string& strategy_name) {
@@ -295,12 +431,23 @@ void PositionEngine::get_create_strategy_holding(const std::string& strategy_nam
 
 void PositionEngine::remove_strategy_holding(const std::string& strategy_name) {
     strategy_holdings_.erase(strategy_name);
+    if (track_changes_) {
+        journal_changes_.erase(strategy_name);
+        journal_removed_.push_back(strategy_name);
+    }
 }
 
 auto PositionEngine::get_holding(const std::string& strategy_name) -> utilities::StrategyHolding& {
     return strategy_holdings_.at(strategy_name);
 }
 
+void PositionEngine::for_each_holding(
+    const std::function<void(const std::string&, const utilities::StrategyHolding&)>& fn) const {
+    for (const auto& [name, holding] : strategy_holdings_) {
+        fn(name, holding);
+    }
+}
+
 void PositionEngine::apply_underlying_trade(utilities::StrategyHolding& holding,
                                             const utilities::TradeData& trade) {
     utilities::UnderlyingPositionData& pos = holding.underlyingPosition;
@@ -317,12 +464,13 @@ void PositionEngine::apply_single_leg_option_trade(utilities::StrategyHolding& h
         holding.optionPositions[trade.symbol] = utilities::OptionPositionData(trade.symbol);
         it = holding.optionPositions.find(trade.symbol);
     }
+    it->second.revalue = true;
     apply_position_change(&it->second, trade);
 }
 
 auto PositionEngine::get_or_create_option_position(
     utilities::StrategyHolding& holding, const std::string& symbol, utilities::ComboType combo_type,
-    const std::vector<std::map<std::string, std::string>>* legs_meta)
+    const std::vector<OrderLegMeta>* legs_meta)
     -> utilities::OptionPositionData* {
     auto it = holding.optionPositions.find(symbol);
     if (it != holding.optionPositions.end()) {
@@ -341,8 +489,7 @@ auto PositionEngine::get_or_create_option_position(
     opt.combo_type = combo_type;
     if (legs_meta != nullptr) {
         for (const auto& m : *legs_meta) {
-            auto sym_it = m.find("symbol");
-            opt.legs.emplace_back(sym_it != m.end() ? sym_it->second : "");
+            opt.legs.emplace_back(m.symbol);
         }
     }
     return &opt;
@@ -411,40 +558,56 @@ void PositionEngine::apply_position_change(utilities::BasePosition* pos,
     }
 }
 
-auto PositionEngine::accumulate_position(utilities::BasePosition* pos,
-                                         const utilities::OptionData* option_snapshot)
-    -> std::map<std::string, double> {
+auto PositionEngine::resolve_option(utilities::BasePosition& pos,
+                                    const utilities::PortfolioData* portfolio)
+    -> const utilities::OptionData* {
+    // Unresolved handles retry: the contract may be loaded after the holding.
+    if (pos.instrument_owner != portfolio || pos.instrument == nullptr) {
+        pos.instrument = portfolio->find_option(pos.symbol);
+        pos.instrument_owner = portfolio;
+    }
+    return pos.instrument;
+}
+
+namespace {
+/** Per-position metrics from pos after its market fields were refreshed. */
+inline auto position_metrics(const utilities::BasePosition& pos) -> utilities::PositionMetrics {
+    return {.current_value = round_digits(pos.current_value(), 2),
+            .total_cost = round_digits(pos.cost_value, 2),
+            .realized_pnl = round_digits(pos.realized_pnl, 2),
+            .delta = round_digits(pos.quantity * pos.delta, 4),
+            .gamma = round_digits(pos.quantity * pos.gamma, 4),
+            .theta = round_digits(pos.quantity * pos.theta, 4),
+            .vega = round_digits(pos.quantity * pos.vega, 4)};
+}
+} // namespace
+
+void PositionEngine::accumulate_position(utilities::BasePosition* pos,
+                                         const utilities::OptionData* option_snapshot,
+                                         PositionMetrics& totals) {
     double delta = 0;
     double gamma = 0;
     double theta = 0;
     double vega = 0;
     double mid_price = 0;
     if (option_snapshot != nullptr) {
-        delta = option_snapshot->delta;
-        gamma = option_snapshot->gamma;
-        theta = option_snapshot->theta;
-        vega = option_snapshot->vega;
-        mid_price = option_snapshot->mid_price;
+        delta = option_snapshot->delta();
+        gamma = option_snapshot->gamma();
+        theta = option_snapshot->theta();
+        vega = option_snapshot->vega();
+        mid_price = option_snapshot->mid_price();
     }
     pos->delta = round_digits(delta, 4);
     pos->gamma = round_digits(gamma, 4);
     pos->theta = round_digits(theta, 4);
     pos->vega = round_digits(vega, 4);
     pos->mid_price = round_digits(mid_price, 2);
-    std::map<std::string, double> m;
-    m["cv"] = round_digits(pos->current_value(), 2);
-    m["tc"] = round_digits(pos->cost_value, 2);
-    m["rlz"] = round_digits(pos->realized_pnl, 2);
-    m["delta"] = round_digits(pos->quantity * pos->delta, 4);
-    m["gamma"] = round_digits(pos->quantity * pos->gamma, 4);
-    m["theta"] = round_digits(pos->quantity * pos->theta, 4);
-    m["vega"] = round_digits(pos->quantity * pos->vega, 4);
-    return m;
-}
-
-auto PositionEngine::accumulate_position(utilities::BasePosition* pos,
-                                         const utilities::UnderlyingData* underlying_snapshot)
-    -> std::map<std::string, double> {
+    totals += position_metrics(*pos);
+}
+
+void PositionEngine::accumulate_position(utilities::BasePosition* pos,
+                                         const utilities::UnderlyingData* underlying_snapshot,
+                                         PositionMetrics& totals) {
     double delta = 1.0;
     double mid_price = 0;
     if (underlying_snapshot != nullptr) {
@@ -453,76 +616,62 @@ auto PositionEngine::accumulate_position(utilities::BasePosition* pos,
     }
     pos->delta = round_digits(delta, 4);
     pos->mid_price = round_digits(mid_price, 2);
-    std::map<std::string, double> m;
-    m["cv"] = round_digits(pos->current_value(), 2);
-    m["tc"] = round_digits(pos->cost_value, 2);
-    m["rlz"] = round_digits(pos->realized_pnl, 2);
-    m["delta"] = round_digits(pos->quantity * pos->delta, 4);
-    m["gamma"] = round_digits(pos->quantity * pos->gamma, 4);
-    m["theta"] = round_digits(pos->quantity * pos->theta, 4);
-    m["vega"] = round_digits(pos->quantity * pos->vega, 4);
-    return m;
-}
-
-auto PositionEngine::accumulate_option_position(utilities::OptionPositionData& opt,
-                                                utilities::PortfolioData* portfolio)
-    -> std::map<std::string, double> {
-    opt.delta = opt.gamma = opt.theta = opt.vega = 0.0;
-    opt.cost_value = 0.0;
-    opt.realized_pnl = 0.0;
-    double current_value = 0.0;
-
-    std::vector<utilities::BasePosition*> components;
-    if (opt.legs.empty()) {
-        components.push_back(&opt);
-    } else {
-        for (auto& leg : opt.legs) {
-            components.push_back(&leg);
+    totals += position_metrics(*pos);
+}
+
+auto PositionEngine::needs_revalue(utilities::OptionPositionData& opt,
+                                   const utilities::PortfolioData* portfolio) -> bool {
+    if (opt.revalue) {
+        return true;
+    }
+    const auto stale = [&opt, portfolio](utilities::BasePosition& pos) -> bool {
+        const bool resolved = pos.instrument != nullptr && pos.instrument_owner == portfolio;
+        const utilities::OptionData* inst = resolve_option(pos, portfolio);
+        if (inst == nullptr) {
+            return false; // still unknown: values stay zero
         }
+        return !resolved || portfolio->slot_frame(inst->slot) > opt.valued_frame;
+    };
+    if (opt.legs.empty()) {
+        return stale(opt);
     }
+    return std::ranges::any_of(opt.legs, stale);
+}
 
-    for (auto* leg : components) {
-        const utilities::OptionData* inst = nullptr;
-        auto it = portfolio->options.find(leg->symbol);
-        if (it != portfolio->options.end()) {
-            inst = &it->second;
+void PositionEngine::accumulate_option_position(utilities::OptionPositionData& opt,
+                                                const utilities::PortfolioData* portfolio,
+                                                PositionMetrics& totals) {
+    PositionMetrics acc;
+    if (opt.legs.empty()) {
+        accumulate_position(&opt, resolve_option(opt, portfolio), acc);
+    } else {
+        for (auto& leg : opt.legs) {
+            accumulate_position(&leg, resolve_option(leg, portfolio), acc);
         }
-        auto acc = accumulate_position(leg, inst);
-        current_value += acc["cv"];
-        opt.cost_value += acc["tc"];
-        opt.realized_pnl += acc["rlz"];
-        opt.delta += acc["delta"];
-        opt.gamma += acc["gamma"];
-        opt.theta += acc["theta"];
-        opt.vega += acc["vega"];
     }
+    opt.cost_value = acc.total_cost;
+    opt.realized_pnl = acc.realized_pnl;
+    opt.delta = acc.delta;
+    opt.gamma = acc.gamma;
+    opt.theta = acc.theta;
+    opt.vega = acc.vega;
 
     if (opt.quantity != 0) {
-        opt.mid_price = round_digits(current_value / (std::abs(opt.quantity) * opt.multiplier), 2);
+        opt.mid_price =
+            round_digits(acc.current_value / (std::abs(opt.quantity) * opt.multiplier), 2);
         if (opt.cost_value > 0) {
             opt.avg_cost =
                 round_digits(opt.cost_value / (std::abs(opt.quantity) * opt.multiplier), 2);
         }
     }
 
-    std::map<std::string, double> m;
-    m["cv"] = round_digits(current_value, 2);
-    m["tc"] = round_digits(opt.cost_value, 2);
-    m["rlz"] = round_digits(opt.realized_pnl, 2);
-    m["delta"] = round_digits(opt.delta, 4);
-    m["gamma"] = round_digits(opt.gamma, 4);
-    m["theta"] = round_digits(opt.theta, 4);
-    m["vega"] = round_digits(opt.vega, 4);
-    return m;
-}
-
-void PositionEngine::add_totals(std::map<std::string, double>& totals,
-                                const std::map<std::string, double>& metrics) {
-    for (auto& kv : totals) {
-        kv.second += (static_cast<unsigned int>(metrics.contains(kv.first)) != 0U)
-                         ? metrics.at(kv.first)
-                         : 0.0;
-    }
+    totals.current_value += round_digits(acc.current_value, 2);
+    totals.total_cost += round_digits(opt.cost_value, 2);
+    totals.realized_pnl += round_digits(opt.realized_pnl, 2);
+    totals.delta += round_digits(opt.delta, 4);
+    totals.gamma += round_digits(opt.gamma, 4);
+    totals.theta += round_digits(opt.theta, 4);
+    totals.vega += round_digits(opt.vega, 4);
 }
 
 auto PositionEngine::normalize_combo_symbol(const std::string& symbol) -> std::string {
@@ -538,73 +687,104 @@ auto PositionEngine::normalize_combo_symbol(const std::string& symbol) -> std::s
     return symbol.substr(0, i1) + "_" + symbol.substr(i2 + 1);
 }
 
+auto PositionEngine::valuation_portfolio(utilities::OptionPositionData& opt,
+                                         const utilities::PortfolioData* portfolio,
+                                         std::span<const utilities::PortfolioData* const> others)
+    -> const utilities::PortfolioData* {
+    if (others.empty()) {
+        return portfolio;
+    }
+    utilities::BasePosition& probe =
+        opt.legs.empty() ? static_cast<utilities::BasePosition&>(opt) : opt.legs.front();
+    if (probe.instrument != nullptr && (probe.instrument_owner == portfolio ||
+                                        std::ranges::find(others, probe.instrument_owner) !=
+                                            others.end())) {
+        return probe.instrument_owner;
+    }
+    // Listed on portfolio: resolution is left to needs_revalue, which revalues it as new.
+    if (portfolio->find_option(probe.symbol) != nullptr) {
+        return portfolio;
+    }
+    for (const utilities::PortfolioData* other : others) {
+        if (other != portfolio && resolve_option(probe, other) != nullptr) {
+            return other;
+        }
+    }
+    return portfolio;
+}
+
 void PositionEngine::update_metrics(const std::string& strategy_name,
-                                    utilities::PortfolioData* portfolio) {
+                                    utilities::PortfolioData* portfolio,
+                                    std::span<const utilities::PortfolioData* const> others) {
     if (portfolio == nullptr) {
         return;
     }
     utilities::StrategyHolding& holding = strategy_holdings_.at(strategy_name);
 
-    std::map<std::string, double> totals{{"cv", 0.0},    {"tc", 0.0},    {"rlz", 0.0},
-                                         {"delta", 0.0}, {"gamma", 0.0}, {"theta", 0.0},
-                                         {"vega", 0.0}};
-
+    const bool full = holding.valued_portfolio != portfolio ||
+                      ++holding.updates_since_full >= full_revalue_interval_;
+    if (full) {
+        holding.option_totals = {};
+        holding.valued_portfolio = portfolio;
+        holding.updates_since_full = 0;
+    }
     for (auto& kv : holding.optionPositions) {
-        add_totals(totals, accumulate_option_position(kv.second, portfolio));
+        utilities::OptionPositionData& opt = kv.second;
+        const utilities::PortfolioData* owner = valuation_portfolio(opt, portfolio, others);
+        if (!full) {
+            // Frame tracking follows portfolio only; positions valued elsewhere always revalue.
+            if (owner == portfolio && !needs_revalue(opt, portfolio)) {
+                continue;
+            }
+            holding.option_totals -= opt.valuation;
+        }
+        opt.valuation = {};
+        accumulate_option_position(opt, owner, opt.valuation);
+        holding.option_totals += opt.valuation;
+        opt.valued_frame = owner->frame_seq();
+        opt.revalue = false;
+        opt.clear_fields();
     }
 
+    PositionMetrics totals = holding.option_totals;
     if (holding.underlyingPosition.quantity != 0 || holding.underlyingPosition.realized_pnl != 0) {
-        add_totals(totals,
-                   accumulate_position(&holding.underlyingPosition, portfolio->underlying.get()));
+        accumulate_position(&holding.underlyingPosition, portfolio->underlying.get(), totals);
     }
 
-    double unreal = totals["cv"] - totals["tc"];
-    holding.summary.current_value = round_digits(totals["cv"], 2);
-    holding.summary.total_cost = round_digits(totals["tc"], 2);
+    double unreal = totals.current_value - totals.total_cost;
+    holding.summary.current_value = round_digits(totals.current_value, 2);
+    holding.summary.total_cost = round_digits(totals.total_cost, 2);
     holding.summary.unrealized_pnl = round_digits(unreal, 2);
-    holding.summary.realized_pnl = round_digits(totals["rlz"], 2);
+    holding.summary.realized_pnl = round_digits(totals.realized_pnl, 2);
     holding.summary.pnl = holding.summary.unrealized_pnl + holding.summary.realized_pnl;
-    holding.summary.delta = round_digits(totals["delta"], 4);
-    holding.summary.gamma = round_digits(totals["gamma"], 4);
-    holding.summary.theta = round_digits(totals["theta"], 4);
-    holding.summary.vega = round_digits(totals["vega"], 4);
+    holding.summary.delta = round_digits(totals.delta, 4);
+    holding.summary.gamma = round_digits(totals.gamma, 4);
+    holding.summary.theta = round_digits(totals.theta, 4);
+    holding.summary.vega = round_digits(totals.vega, 4);
 
-    for (auto& kv : holding.optionPositions) {
-        kv.second.clear_fields();
-    }
     holding.underlyingPosition.clear_fields();
 }
 
 auto PositionEngine::serialize_holding(const std::string& strategy_name) const -> std::string {
+    std::string out;
+    serialize_holding(strategy_name, out);
+    return out;
+}
+
+auto PositionEngine::serialize_holding(const std::string& strategy_name,
+                                       std::string& out) const -> bool {
+    out.clear();
     auto it = strategy_holdings_.find(strategy_name);
     if (it == strategy_holdings_.end()) {
-        return "";
+        return false;
     }
-    const utilities::StrategyHolding& holding = it->second;
-    otrader::StrategyHoldingMsg msg;
-    base_position_to_msg(holding.underlyingPosition, msg.mutable_underlying());
-    for (const auto& kv : holding.optionPositions) {
-        const utilities::OptionPositionData& o = kv.second;
-        otrader::OptionPositionMsg* om = &(*msg.mutable_options())[kv.first];
-        base_position_to_option_msg(o, om);
-        om->set_combo_type(
-            combo_type_to_enum_name(o.combo_type.value_or(utilities::ComboType::SINGLE_LEG)));
-        for (const auto& leg : o.legs) {
-            base_position_to_msg(leg, om->add_legs());
-        }
+    auto* msg = google::protobuf::Arena::Create<otrader::StrategyHoldingMsg>(&holding_arena());
+    holding_to_msg(it->second, msg);
+    if (!msg->SerializeToString(&out)) {
+        out.clear();
+        return false;
     }
-    otrader::PortfolioSummaryMsg* sm = msg.mutable_summary();
-    sm->set_total_cost(holding.summary.total_cost);
-    sm->set_current_value(holding.summary.current_value);
-    sm->set_unrealized_pnl(holding.summary.unrealized_pnl);
-    sm->set_realized_pnl(holding.summary.realized_pnl);
-    sm->set_pnl(holding.summary.pnl);
-    sm->set_delta(holding.summary.delta);
-    sm->set_gamma(holding.summary.gamma);
-    sm->set_theta(holding.summary.theta);
-    sm->set_vega(holding.summary.vega);
-    std::string out;
-    return msg.SerializeToString(&out) ? out : "";
+    return true;
 }
 
 void PositionEngine::load_serialized_holding(const std::string& strategy_name,
@@ -612,34 +792,104 @@ void PositionEngine::load_serialized_holding(const std::string& strategy_name,
     if (data.empty()) {
         return;
     }
-    otrader::StrategyHoldingMsg msg;
-    if (!msg.ParseFromString(data)) {
+    auto* msg = google::protobuf::Arena::Create<otrader::StrategyHoldingMsg>(&holding_arena());
+    if (!msg->ParseFromString(data)) {
         return;
     }
     get_create_strategy_holding(strategy_name);
-    utilities::StrategyHolding& holding = strategy_holdings_[strategy_name];
+    msg_to_holding(*msg, strategy_holdings_[strategy_name], true);
+    if (HoldingChanges* changes = changes_for(strategy_name)) {
+        changes->full = true;
+    }
+}
 
-    if (msg.has_underlying()) {
-        msg_to_base_position(msg.underlying(), &holding.underlyingPosition);
+auto PositionEngine::changes_for(const std::string& strategy_name) -> HoldingChanges* {
+    return track_changes_ ? &journal_changes_[strategy_name] : nullptr;
+}
+
+void PositionEngine::set_change_tracking(bool enabled) {
+    track_changes_ = enabled;
+    if (!enabled) {
+        journal_changes_.clear();
+        journal_removed_.clear();
     }
-    holding.optionPositions.clear();
-    for (const auto& [sym, optMsg] : msg.options()) {
-        utilities::OptionPositionData opt(sym);
-        option_msg_to_option_position(optMsg, &opt);
-        holding.optionPositions[sym] = std::move(opt);
+}
+
+auto PositionEngine::drain_journal(std::string& out) -> size_t {
+    size_t records = 0;
+    for (const std::string& name : journal_removed_) {
+        append_record(*new_journal_record(name, otrader::HoldingJournalRecord::REMOVED), out);
+        ++records;
+    }
+    journal_removed_.clear();
+    for (const auto& [name, changes] : journal_changes_) {
+        auto it = strategy_holdings_.find(name);
+        if (it == strategy_holdings_.end()) {
+            continue;
+        }
+        const utilities::StrategyHolding& holding = it->second;
+        otrader::HoldingJournalRecord* rec = new_journal_record(
+            name, changes.full ? otrader::HoldingJournalRecord::SNAPSHOT
+                               : otrader::HoldingJournalRecord::DELTA);
+        otrader::StrategyHoldingMsg* msg = rec->mutable_holding();
+        if (changes.full) {
+            holding_to_msg(holding, msg);
+        } else {
+            if (changes.underlying) {
+                base_position_to_msg(holding.underlyingPosition, msg->mutable_underlying());
+            }
+            for (const std::string& key : changes.options) {
+                auto pos = holding.optionPositions.find(key);
+                if (pos != holding.optionPositions.end()) {
+                    option_position_to_msg(pos->second, &(*msg->mutable_options())[key]);
+                }
+            }
+        }
+        append_record(*rec, out);
+        ++records;
     }
-    if (msg.has_summary()) {
-        const otrader::PortfolioSummaryMsg& sm = msg.summary();
-        holding.summary.total_cost = sm.total_cost();
-        holding.summary.current_value = sm.current_value();
-        holding.summary.unrealized_pnl = sm.unrealized_pnl();
-        holding.summary.realized_pnl = sm.realized_pnl();
-        holding.summary.pnl = sm.pnl();
-        holding.summary.delta = sm.delta();
-        holding.summary.gamma = sm.gamma();
-        holding.summary.theta = sm.theta();
-        holding.summary.vega = sm.vega();
+    journal_changes_.clear();
+    return records;
+}
+
+void PositionEngine::append_journal_snapshot(std::string& out) const {
+    for (const auto& [name, holding] : strategy_holdings_) {
+        otrader::HoldingJournalRecord* rec =
+            new_journal_record(name, otrader::HoldingJournalRecord::SNAPSHOT);
+        holding_to_msg(holding, rec->mutable_holding());
+        append_record(*rec, out);
+    }
+}
+
+auto PositionEngine::replay_journal(std::string_view records) -> size_t {
+    size_t applied = 0;
+    uint32_t len = 0;
+    while (records.size() >= sizeof(len)) {
+        std::memcpy(&len, records.data(), sizeof(len));
+        if (records.size() - sizeof(len) < len) {
+            break;
+        }
+        auto* rec =
+            google::protobuf::Arena::Create<otrader::HoldingJournalRecord>(&holding_arena());
+        if (!rec->ParseFromArray(records.data() + sizeof(len), static_cast<int>(len))) {
+            break;
+        }
+        records.remove_prefix(sizeof(len) + len);
+        const std::string& name = rec->strategy_name();
+        if (rec->kind() == otrader::HoldingJournalRecord::REMOVED) {
+            // Reset in place: a strategy of this session may already reference the holding.
+            auto it = strategy_holdings_.find(name);
+            if (it != strategy_holdings_.end()) {
+                it->second = utilities::StrategyHolding();
+            }
+        } else {
+            get_create_strategy_holding(name);
+            msg_to_holding(rec->holding(), strategy_holdings_[name],
+                           rec->kind() == otrader::HoldingJournalRecord::SNAPSHOT);
+        }
+        ++applied;
     }
+    return applied;
 }
 
 } // namespace engines
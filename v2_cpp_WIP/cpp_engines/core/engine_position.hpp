@@ -6,27 +6,42 @@
 #include "../utilities/constant.hpp"
 #include "../utilities/object.hpp"
 #include "../utilities/portfolio.hpp"
+#include "../utilities/recent_id_set.hpp"
 #include "../utilities/utility.hpp"
+#include <cstddef>
+#include <deque>
 #include <functional>
-#include <map>
+#include <memory_resource>
 #include <memory>
 #include <optional>
-#include <set>
+#include <span>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace engines {
 
 using GetPortfolioFn = std::function<utilities::PortfolioData*(const std::string&)>;
 
-/** Order meta stored when process_order is called (same shape as Python). */
+/** Combo leg as recorded by process_order. */
+struct OrderLegMeta {
+    std::string symbol;
+    int con_id = 0;
+    int ratio = 0;
+    utilities::Direction direction = utilities::Direction::LONG;
+};
+
+/** Order meta stored when process_order is called; retired some orders after it is terminal. */
 struct OrderMeta {
     bool is_combo = false;
     std::string symbol;
-    std::optional<std::string> combo_type;
-    std::vector<std::map<std::string, std::string>> legs;
+    std::optional<utilities::ComboType> combo_type;
+    std::vector<OrderLegMeta> legs;
     std::string strategy_name;
+    /** Terminal status seen; queued in retired_orders_. */
+    bool retired = false;
 };
 
 class PositionEngine : public utilities::BaseEngine {
@@ -37,23 +52,65 @@ class PositionEngine : public utilities::BaseEngine {
     /** Caller invokes each tick; pass get_portfolio. Optional out_logs: append LogIntent (LogData)
      * for caller to put_intent(IntentLog{...}). */
     void process_timer_event(const GetPortfolioFn& get_portfolio,
-                             std::vector<utilities::LogData>* out_logs = nullptr);
+                             std::pmr::vector<utilities::LogData>* out_logs = nullptr);
     void process_order(const std::string& strategy_name, const utilities::OrderData& order);
     void process_trade(const std::string& strategy_name, const utilities::TradeData& trade);
 
     void get_create_strategy_holding(const std::string& strategy_name);
     void remove_strategy_holding(const std::string& strategy_name);
     utilities::StrategyHolding& get_holding(const std::string& strategy_name);
+    /** fn(strategy_name, holding) for every strategy holding. */
+    void for_each_holding(
+        const std::function<void(const std::string&, const utilities::StrategyHolding&)>& fn)
+        const;
+    /** Portfolio a strategy trades: the part of its name after the first '_' (or the name). */
+    static std::string portfolio_name(const std::string& strategy_name);
 
-    /** Update metrics. */
-    void update_metrics(const std::string& strategy_name, utilities::PortfolioData* portfolio);
+    /**
+     * Update metrics incrementally: revalue only positions that traded or whose option slots
+     * changed since their last valuation (PortfolioData::slot_frame), keeping running totals.
+     * Every full_revalue_interval calls per holding everything is revalued and re-summed.
+     * Option positions portfolio does not list are valued on the first of others that does
+     * (multi-underlying backtest) and revalued on every call.
+     */
+    void update_metrics(const std::string& strategy_name, utilities::PortfolioData* portfolio,
+                        std::span<const utilities::PortfolioData* const> others = {});
+    /** Updates between full revaluations; <= 1 revalues everything every time. */
+    void set_full_revalue_interval(int updates) { full_revalue_interval_ = updates; }
 
-    /** Serialize strategy holding to JSON (same shape as Python serialize_holding dict). */
+    /** Serialize strategy holding to a binary StrategyHoldingMsg; empty if unknown. */
     std::string serialize_holding(const std::string& strategy_name) const;
-    /** Load holding from JSON. */
+    /**
+     * Same into out (cleared, capacity reused): the message is built on a per-thread arena
+     * that keeps its block between calls. False if unknown or serialization failed.
+     */
+    bool serialize_holding(const std::string& strategy_name, std::string& out) const;
+    /** Load holding from a serialized StrategyHoldingMsg (replaces the holding). */
     void load_serialized_holding(const std::string& strategy_name, const std::string& data);
 
+    /**
+     * Record which positions trades touch (and which holdings are loaded or removed) for
+     * drain_journal. Off by default; turning it off drops what was recorded.
+     */
+    void set_change_tracking(bool enabled);
+    /**
+     * Append journal records (length-prefixed HoldingJournalRecord) for what changed since the
+     * last drain: removals, full snapshots of loaded holdings, else one delta per strategy with
+     * only its touched positions. Returns the number of records appended.
+     */
+    size_t drain_journal(std::string& out);
+    /** Append one snapshot record per holding (journal compaction). */
+    void append_journal_snapshot(std::string& out) const;
+    /**
+     * Apply records written by drain_journal / append_journal_snapshot in order. Stops at the
+     * first truncated or unparsable record (a torn tail); not recorded as changes. A removed
+     * holding is reset in place, since a strategy may reference it. Returns the records applied.
+     */
+    size_t replay_journal(std::string_view records);
+
   private:
+    using PositionMetrics = utilities::PositionMetrics;
+
     static void apply_underlying_trade(utilities::StrategyHolding& holding,
                                        const utilities::TradeData& trade);
     static void apply_single_leg_option_trade(utilities::StrategyHolding& holding,
@@ -61,7 +118,7 @@ class PositionEngine : public utilities::BaseEngine {
     static utilities::OptionPositionData*
     get_or_create_option_position(utilities::StrategyHolding& holding, const std::string& symbol,
                                   utilities::ComboType combo_type,
-                                  const std::vector<std::map<std::string, std::string>>* legs_meta);
+                                  const std::vector<OrderLegMeta>* legs_meta);
     static utilities::OptionPositionData*
     get_or_create_option_leg(utilities::OptionPositionData& opt, const utilities::TradeData& trade);
     static void apply_position_change(utilities::OptionPositionData* pos,
@@ -69,22 +126,60 @@ class PositionEngine : public utilities::BaseEngine {
     static void apply_position_change(utilities::BasePosition* pos,
                                       const utilities::TradeData& trade);
 
-    static std::map<std::string, double>
-    accumulate_position(utilities::BasePosition* position,
-                        const utilities::OptionData* option_snapshot);
-    static std::map<std::string, double>
-    accumulate_position(utilities::BasePosition* position,
-                        const utilities::UnderlyingData* underlying_snapshot);
-    static std::map<std::string, double>
-    accumulate_option_position(utilities::OptionPositionData& opt,
-                               utilities::PortfolioData* portfolio);
-    static void add_totals(std::map<std::string, double>& totals,
-                           const std::map<std::string, double>& metrics);
+    /** Option behind position in portfolio; cached on the position after the first lookup. */
+    static const utilities::OptionData* resolve_option(utilities::BasePosition& position,
+                                                       const utilities::PortfolioData* portfolio);
+    static void accumulate_position(utilities::BasePosition* position,
+                                    const utilities::OptionData* option_snapshot,
+                                    PositionMetrics& totals);
+    static void accumulate_position(utilities::BasePosition* position,
+                                    const utilities::UnderlyingData* underlying_snapshot,
+                                    PositionMetrics& totals);
+    static void accumulate_option_position(utilities::OptionPositionData& opt,
+                                           const utilities::PortfolioData* portfolio,
+                                           PositionMetrics& totals);
+    /** portfolio, or the first of others listing opt (its first leg) when portfolio does not. */
+    static const utilities::PortfolioData*
+    valuation_portfolio(utilities::OptionPositionData& opt,
+                        const utilities::PortfolioData* portfolio,
+                        std::span<const utilities::PortfolioData* const> others);
+    /** Traded, newly resolved, or a leg's slot changed after opt.valued_frame. */
+    static bool needs_revalue(utilities::OptionPositionData& opt,
+                              const utilities::PortfolioData* portfolio);
     static std::string normalize_combo_symbol(const std::string& symbol);
 
+    /** Positions touched since the last drain_journal, per strategy. */
+    struct HoldingChanges {
+        /** Loaded wholesale: journal a snapshot instead of a delta. */
+        bool full = false;
+        bool underlying = false;
+        /** optionPositions keys. */
+        std::unordered_set<std::string> options;
+    };
+    /** Change set of strategy_name, or nullptr when tracking is off. */
+    HoldingChanges* changes_for(const std::string& strategy_name);
+
     std::unordered_map<std::string, utilities::StrategyHolding> strategy_holdings_;
+    bool track_changes_ = false;
+    std::unordered_map<std::string, HoldingChanges> journal_changes_;
+    /** Holdings removed since the last drain_journal, in removal order. */
+    std::vector<std::string> journal_removed_;
+    /**
+     * Trades applied; a redelivered trade id is ignored. Remembered for at least this many later
+     * trades (bounded memory in long sessions).
+     */
+    static constexpr size_t kTradeDedupWindow = size_t{1} << 16;
+    /**
+     * Terminal orders whose meta is kept for late fills (TWS may report executions after the final
+     * status); older ones are dropped. The orders themselves are persisted by the runtime.
+     */
+    static constexpr size_t kRetiredOrderWindow = 4096;
+
     std::unordered_map<std::string, OrderMeta> order_meta_;
-    std::set<std::string> trade_seen_;
+    /** Terminal orderids, oldest first. */
+    std::deque<std::string> retired_orders_;
+    utilities::RecentIdSet trade_seen_{kTradeDedupWindow};
+    int full_revalue_interval_ = 60;
 };
 
 } // namespace engines
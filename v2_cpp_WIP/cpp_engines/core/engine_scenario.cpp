@@ -0,0 +1,336 @@
+#include "engine_scenario.hpp"
+#include "../utilities/black_scholes.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace engines {
+
+namespace {
+
+/** Shocked vols are floored here instead of dropping the grid point. */
+constexpr double kMinShockedVol = 0.01;
+
+auto worst(std::span<const double> pnl) -> double {
+    return pnl.empty() ? 0.0 : *std::ranges::min_element(pnl);
+}
+
+auto is_underlying_symbol(const std::string& symbol, const utilities::PortfolioData& portfolio)
+    -> bool {
+    return symbol == portfolio.underlying_symbol || symbol.ends_with(".STK");
+}
+
+auto signed_units(utilities::Direction direction, double volume) -> double {
+    return direction == utilities::Direction::SHORT ? -volume : volume;
+}
+
+} // namespace
+
+void ScenarioEngine::set_grid(ScenarioGrid grid) {
+    std::scoped_lock lock(mutex_);
+    grid_ = std::move(grid);
+    rows_.clear();
+    strategies_.clear();
+}
+
+auto ScenarioEngine::grid() const -> ScenarioGrid {
+    std::scoped_lock lock(mutex_);
+    return grid_;
+}
+
+void ScenarioEngine::set_loss_limit(double limit) {
+    std::scoped_lock lock(mutex_);
+    loss_limit_ = limit;
+}
+
+auto ScenarioEngine::loss_limit() const -> double {
+    std::scoped_lock lock(mutex_);
+    return loss_limit_;
+}
+
+void ScenarioEngine::collect_exposures(const utilities::StrategyHolding& holding,
+                                       const utilities::PortfolioData& portfolio,
+                                       std::vector<Exposure>& out) {
+    const auto add = [&out, &portfolio](const utilities::BasePosition& pos) {
+        if (pos.quantity == 0) {
+            return;
+        }
+        const utilities::OptionData* option = pos.instrument_owner == &portfolio
+                                                  ? pos.instrument
+                                                  : portfolio.find_option(pos.symbol);
+        if (option != nullptr) {
+            out.push_back({.slot = option->slot, .units = pos.quantity * pos.multiplier});
+        }
+    };
+    for (const auto& kv : holding.optionPositions) {
+        const utilities::OptionPositionData& opt = kv.second;
+        if (opt.legs.empty()) {
+            add(opt);
+        } else {
+            for (const auto& leg : opt.legs) {
+                add(leg);
+            }
+        }
+    }
+}
+
+auto ScenarioEngine::order_exposures(const utilities::OrderRequest& req,
+                                     const utilities::PortfolioData& portfolio,
+                                     std::vector<Exposure>& out, double& underlying_units)
+    -> bool {
+    const auto add = [&](const std::string& symbol, double units) -> bool {
+        if (is_underlying_symbol(symbol, portfolio)) {
+            underlying_units += units;
+            return true;
+        }
+        const utilities::OptionData* option = portfolio.find_option(symbol);
+        if (option == nullptr) {
+            return false;
+        }
+        out.push_back({.slot = option->slot, .units = units * option->size});
+        return true;
+    };
+    if (req.is_combo && req.legs.has_value()) {
+        // Leg direction and ratio are final (volume included, see ComboBuilderEngine::build).
+        for (const utilities::Leg& leg : *req.legs) {
+            if (!add(leg.symbol.value_or(""), signed_units(leg.direction, leg.ratio))) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return add(req.symbol, signed_units(req.direction, req.volume));
+}
+
+auto ScenarioEngine::rows_for(const utilities::PortfolioData& portfolio, size_t slots)
+    -> PortfolioRows& {
+    PortfolioRows& rows = rows_[&portfolio];
+    if (rows.stamp.size() < slots) {
+        rows.rows.resize(slots * grid_.points());
+        rows.inputs.resize(slots);
+        rows.stamp.resize(slots);
+        rows.priced.resize(slots);
+    }
+    return rows;
+}
+
+void ScenarioEngine::refresh_rows(const utilities::PortfolioData& portfolio,
+                                  const utilities::MarketView& view, PortfolioRows& rows,
+                                  std::span<const Exposure> exposures) {
+    const double spot = view.underlying_mid();
+    stale_.clear();
+    for (const Exposure& e : exposures) {
+        if (e.slot >= rows.stamp.size()) {
+            continue;
+        }
+        const RowInputs now{.spot = spot,
+                            .iv = view.at(&utilities::OptionColumns::iv, e.slot),
+                            .tau = view.at(&utilities::OptionColumns::tau, e.slot)};
+        if (rows.stamp[e.slot] == 0 || rows.inputs[e.slot] != now) {
+            stale_.push_back(e.slot);
+        }
+    }
+    if (stale_.empty()) {
+        return;
+    }
+    std::ranges::sort(stale_);
+    stale_.erase(std::ranges::unique(stale_).begin(), stale_.end());
+
+    // Lane 0 of each option is the unshocked price; lanes 1..points follow the grid.
+    const size_t points = grid_.points();
+    const size_t lanes = points + 1;
+    const size_t nv = grid_.vol_shocks.size();
+    spot_lanes_.resize(lanes);
+    spot_lanes_[0] = spot;
+    for (size_t g = 0; g < points; ++g) {
+        spot_lanes_[g + 1] = spot * (1.0 + grid_.spot_shocks[g / nv]);
+    }
+    const size_t n = stale_.size() * lanes;
+    for (auto* v : {&lane_spot_, &lane_strike_, &lane_tau_, &lane_sigma_, &lane_price_,
+                    &lane_vega_}) {
+        v->resize(n);
+    }
+    lane_call_.resize(n);
+    const std::vector<utilities::OptionData*>& options = portfolio.option_apply_order();
+    for (size_t k = 0; k < stale_.size(); ++k) {
+        const size_t slot = stale_[k];
+        const double iv = view.at(&utilities::OptionColumns::iv, slot);
+        const double strike = view.at(&utilities::OptionColumns::strike, slot);
+        const double tau = view.at(&utilities::OptionColumns::tau, slot);
+        const uint8_t call = slot < options.size() && options[slot]->option_type > 0 ? 1 : 0;
+        const size_t base = k * lanes;
+        std::copy(spot_lanes_.begin(), spot_lanes_.end(), lane_spot_.begin() + base);
+        std::fill_n(lane_strike_.begin() + base, lanes, strike);
+        std::fill_n(lane_tau_.begin() + base, lanes, tau);
+        std::fill_n(lane_call_.begin() + base, lanes, call);
+        lane_sigma_[base] = iv;
+        for (size_t g = 0; g < points; ++g) {
+            lane_sigma_[base + g + 1] = std::max(iv + grid_.vol_shocks[g % nv], kMinShockedVol);
+        }
+    }
+    const utilities::BsBatchInput in{.spot = lane_spot_,
+                                     .strike = lane_strike_,
+                                     .tau = lane_tau_,
+                                     .sigma = lane_sigma_,
+                                     .is_call = lane_call_,
+                                     .risk_free_rate = portfolio.risk_free_rate_};
+    utilities::bs_price_vega_batch(in, lane_price_, lane_vega_);
+
+    ++stamp_;
+    for (size_t k = 0; k < stale_.size(); ++k) {
+        const size_t slot = stale_[k];
+        const size_t base = k * lanes;
+        const bool ok = spot > 0.0 && lane_sigma_[base] > 0.0 && lane_tau_[base] > 0.0 &&
+                        lane_strike_[base] > 0.0;
+        double* row = rows.rows.data() + (slot * points);
+        for (size_t g = 0; g < points; ++g) {
+            row[g] = ok ? lane_price_[base + g + 1] - lane_price_[base] : 0.0;
+        }
+        rows.inputs[slot] = {.spot = spot, .iv = lane_sigma_[base], .tau = lane_tau_[base]};
+        rows.stamp[slot] = stamp_;
+        rows.priced[slot] = ok ? 1 : 0;
+    }
+}
+
+auto ScenarioEngine::accumulate(const PortfolioRows& rows, std::span<const Exposure> exposures,
+                                double underlying_units, double spot,
+                                std::span<double> out) const -> bool {
+    const size_t points = grid_.points();
+    const size_t nv = grid_.vol_shocks.size();
+    bool priced = true;
+    for (const Exposure& e : exposures) {
+        if (e.slot >= rows.stamp.size() || rows.priced[e.slot] == 0) {
+            priced = false;
+            continue;
+        }
+        const double* row = rows.rows.data() + (e.slot * points);
+        for (size_t g = 0; g < points; ++g) {
+            out[g] += e.units * row[g];
+        }
+    }
+    if (underlying_units != 0.0) {
+        for (size_t g = 0; g < points; ++g) {
+            out[g] += underlying_units * spot * grid_.spot_shocks[g / nv];
+        }
+    }
+    return priced;
+}
+
+void ScenarioEngine::process_timer_event(const PositionEngine& positions,
+                                         const GetPortfolioFn& get_portfolio) {
+    if (!get_portfolio) {
+        return;
+    }
+    std::scoped_lock lock(mutex_);
+    for (auto& kv : strategies_) {
+        kv.second.seen = false;
+    }
+    positions.for_each_holding([&](const std::string& name,
+                                   const utilities::StrategyHolding& holding) {
+        const utilities::PortfolioData* portfolio =
+            get_portfolio(PositionEngine::portfolio_name(name));
+        if (portfolio == nullptr) {
+            return;
+        }
+        utilities::MarketView view = portfolio->pin();
+        if (!view) {
+            return;
+        }
+        StrategyGrid& sg = strategies_[name];
+        sg.seen = true;
+        exposure_scratch_.clear();
+        collect_exposures(holding, *portfolio, exposure_scratch_);
+        const double underlying_units =
+            holding.underlyingPosition.quantity * holding.underlyingPosition.multiplier;
+        bool dirty = sg.portfolio != portfolio || sg.exposures != exposure_scratch_ ||
+                     sg.underlying_units != underlying_units || sg.pnl.size() != grid_.points();
+        if (dirty) {
+            sg.portfolio = portfolio;
+            sg.exposures.swap(exposure_scratch_);
+            sg.underlying_units = underlying_units;
+        }
+
+        PortfolioRows& rows = rows_for(*portfolio, view.columns().size());
+        refresh_rows(*portfolio, view, rows, sg.exposures);
+        const double spot = view.underlying_mid();
+        dirty = dirty || (underlying_units != 0.0 && sg.spot != spot) ||
+                std::ranges::any_of(sg.exposures, [&rows, &sg](const Exposure& e) -> bool {
+                    return e.slot < rows.stamp.size() && rows.stamp[e.slot] > sg.stamp;
+                });
+        if (!dirty) {
+            return;
+        }
+        sg.pnl.assign(grid_.points(), 0.0);
+        accumulate(rows, sg.exposures, sg.underlying_units, spot, sg.pnl);
+        sg.spot = spot;
+        sg.stamp = stamp_;
+    });
+    std::erase_if(strategies_, [](const auto& kv) -> bool { return !kv.second.seen; });
+}
+
+auto ScenarioEngine::strategy_pnl(const std::string& strategy_name) const
+    -> std::vector<double> {
+    std::scoped_lock lock(mutex_);
+    auto it = strategies_.find(strategy_name);
+    return it != strategies_.end() ? it->second.pnl : std::vector<double>{};
+}
+
+auto ScenarioEngine::order_impact(const std::string& strategy_name,
+                                  const utilities::OrderRequest& req) -> OrderImpact {
+    std::scoped_lock lock(mutex_);
+    OrderImpact impact;
+    auto it = strategies_.find(strategy_name);
+    if (it == strategies_.end() || it->second.portfolio == nullptr) {
+        return impact;
+    }
+    StrategyGrid& sg = it->second;
+    utilities::MarketView view = sg.portfolio->pin();
+    if (!view) {
+        return impact;
+    }
+    impact.worst_before = worst(sg.pnl);
+
+    exposure_scratch_.clear();
+    double underlying_units = 0.0;
+    if (!order_exposures(req, *sg.portfolio, exposure_scratch_, underlying_units)) {
+        return impact;
+    }
+    PortfolioRows& rows = rows_for(*sg.portfolio, view.columns().size());
+    refresh_rows(*sg.portfolio, view, rows, exposure_scratch_);
+    after_ = sg.pnl;
+    after_.resize(grid_.points(), 0.0);
+    impact.priced = accumulate(rows, exposure_scratch_, underlying_units,
+                               view.underlying_mid(), after_);
+    impact.worst_after = worst(after_);
+    return impact;
+}
+
+auto ScenarioEngine::check_order(const std::string& strategy_name,
+                                 const utilities::OrderRequest& req) -> bool {
+    const double limit = loss_limit();
+    if (limit <= 0.0) {
+        return true;
+    }
+    const OrderImpact impact = order_impact(strategy_name, req);
+    if (!impact.priced) {
+        write_log("[ScenarioEngine] rejected " + req.symbol + " for " + strategy_name +
+                      ": no grid valuation for the strategy or an order leg",
+                  30);
+        return false;
+    }
+    if (-impact.worst_after <= limit || impact.worst_after >= impact.worst_before) {
+        return true;
+    }
+    write_log("[ScenarioEngine] rejected " + req.symbol + " for " + strategy_name +
+                  ": worst grid PnL " + std::to_string(impact.worst_after) + " exceeds limit -" +
+                  std::to_string(limit),
+              30);
+    return false;
+}
+
+void ScenarioEngine::close() {
+    std::scoped_lock lock(mutex_);
+    rows_.clear();
+    strategies_.clear();
+}
+
+} // namespace engines
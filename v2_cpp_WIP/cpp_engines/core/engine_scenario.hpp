@@ -0,0 +1,136 @@
+#pragma once
+
+/**
+ * ScenarioEngine: strategy PnL over a spot x vol shock grid. Each held option is repriced at all
+ * grid points in one batch-kernel pass (strike, tau, type and IV loaded once per option, shocked
+ * spots once per pass); per-unit rows are cached per portfolio slot and repriced only when the
+ * pinned frame moved that option's inputs, strategy grids only when their exposure or a row
+ * changed. check_order prices a request's legs against the cached grid (pre-trade check).
+ */
+
+#include "../utilities/base_engine.hpp"
+#include "../utilities/object.hpp"
+#include "../utilities/portfolio.hpp"
+#include "engine_position.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace engines {
+
+/** Spot shocks are relative (0.05 = +5%), vol shocks absolute (0.05 = +5 vol points). */
+struct ScenarioGrid {
+    std::vector<double> spot_shocks{-0.10, -0.075, -0.05, -0.025, 0.0, 0.025, 0.05, 0.075, 0.10};
+    std::vector<double> vol_shocks{-0.10, -0.05, 0.0, 0.05, 0.10};
+
+    /** Grid points; point (s, v) is at s * vol_shocks.size() + v. */
+    [[nodiscard]] size_t points() const { return spot_shocks.size() * vol_shocks.size(); }
+};
+
+/** Worst grid PnL of a strategy without and with a proposed order filled. */
+struct OrderImpact {
+    bool priced = false; ///< false: unknown strategy, or a leg without market state (IV, tau)
+    double worst_before = 0.0;
+    double worst_after = 0.0;
+};
+
+class ScenarioEngine : public utilities::BaseEngine {
+  public:
+    ScenarioEngine() = default;
+    explicit ScenarioEngine(utilities::MainEngine* main) : BaseEngine(main, "Scenario") {}
+
+    /** Replace the grid; every row and strategy grid is rebuilt on the next refresh. */
+    void set_grid(ScenarioGrid grid);
+    [[nodiscard]] ScenarioGrid grid() const;
+    /** Largest grid loss (positive) check_order lets a strategy reach; <= 0 turns it off. */
+    void set_loss_limit(double limit);
+    [[nodiscard]] double loss_limit() const;
+
+    /** Position timer, after PositionEngine: refresh the grids of every strategy holding. */
+    void process_timer_event(const PositionEngine& positions, const GetPortfolioFn& get_portfolio);
+
+    /** Grid PnL of strategy at the last refresh (ScenarioGrid point order); empty if unknown. */
+    [[nodiscard]] std::vector<double> strategy_pnl(const std::string& strategy_name) const;
+
+    /** Marginal grid impact of req on strategy's last refreshed grid. Any thread. */
+    OrderImpact order_impact(const std::string& strategy_name, const utilities::OrderRequest& req);
+    /**
+     * Pre-trade check (ExecutionEngine risk check): passes when the limit is off, when the worst
+     * loss after req stays within it, or when req does not make the worst loss larger.
+     */
+    bool check_order(const std::string& strategy_name, const utilities::OrderRequest& req);
+
+    void close() override;
+
+  private:
+    /** Signed units (quantity * multiplier) held in one option slot. */
+    struct Exposure {
+        size_t slot = 0;
+        double units = 0.0;
+        bool operator==(const Exposure&) const = default;
+    };
+    /** Market inputs a row was priced from; any change reprices it. */
+    struct RowInputs {
+        double spot = 0.0;
+        double iv = 0.0;
+        double tau = 0.0;
+        bool operator==(const RowInputs&) const = default;
+    };
+    /** Per-unit grid PnL rows (slot * points) of the slots held in one portfolio. */
+    struct PortfolioRows {
+        std::vector<double> rows;
+        std::vector<RowInputs> inputs;
+        /** Refresh that last repriced the slot; 0 = never. */
+        std::vector<uint64_t> stamp;
+        /** False: the slot had no IV/tau when repriced (row is zero). */
+        std::vector<uint8_t> priced;
+    };
+    struct StrategyGrid {
+        const utilities::PortfolioData* portfolio = nullptr;
+        std::vector<Exposure> exposures;
+        double underlying_units = 0.0;
+        /** Spot the underlying term was taken at. */
+        double spot = 0.0;
+        std::vector<double> pnl;
+        /** Refresh the pnl was summed at; rows repriced later make it stale. */
+        uint64_t stamp = 0;
+        bool seen = false;
+    };
+
+    /** Append the option exposure of holding in portfolio (unresolved symbols skipped). */
+    static void collect_exposures(const utilities::StrategyHolding& holding,
+                                  const utilities::PortfolioData& portfolio,
+                                  std::vector<Exposure>& out);
+    /** Exposure req adds when filled; false if a leg is not an option of portfolio. */
+    static bool order_exposures(const utilities::OrderRequest& req,
+                                const utilities::PortfolioData& portfolio,
+                                std::vector<Exposure>& out, double& underlying_units);
+    PortfolioRows& rows_for(const utilities::PortfolioData& portfolio, size_t slots);
+    /** Reprice the rows of exposures whose inputs moved in view (one batch). */
+    void refresh_rows(const utilities::PortfolioData& portfolio, const utilities::MarketView& view,
+                      PortfolioRows& rows, std::span<const Exposure> exposures);
+    /** out[g] += exposures and underlying units at grid point g; false if a row is unpriced. */
+    bool accumulate(const PortfolioRows& rows, std::span<const Exposure> exposures,
+                    double underlying_units, double spot, std::span<double> out) const;
+
+    mutable std::mutex mutex_;
+    ScenarioGrid grid_;
+    double loss_limit_ = 0.0;
+    uint64_t stamp_ = 0;
+    std::unordered_map<const utilities::PortfolioData*, PortfolioRows> rows_;
+    std::unordered_map<std::string, StrategyGrid> strategies_;
+
+    /** Scratch reused across refreshes and checks (guarded by mutex_). */
+    std::vector<Exposure> exposure_scratch_;
+    std::vector<size_t> stale_;
+    std::vector<double> spot_lanes_;
+    std::vector<double> lane_spot_, lane_strike_, lane_tau_, lane_sigma_, lane_price_, lane_vega_;
+    std::vector<uint8_t> lane_call_;
+    std::vector<double> after_;
+};
+
+} // namespace engines
@@ -14,10 +14,8 @@
 #include "../utilities/portfolio.hpp"
 
 #include <functional>
-#include <set>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 namespace engines {
@@ -42,12 +40,13 @@ struct ExecutionAPI {
     std::function<std::vector<utilities::OrderData>()> get_all_orders;
     std::function<std::vector<utilities::TradeData>()> get_all_trades;
     std::function<std::vector<utilities::OrderData>()> get_all_active_orders;
-    std::function<const std::unordered_map<std::string, std::set<std::string>>&()>
-        get_strategy_active_orders;
+    // Visit a strategy's active orders (hedge checks)
+    std::function<void(const std::string&,
+                       const std::function<void(const utilities::OrderData&)>&)>
+        for_each_active_order;
 
     // Cleanup on cancel/strategy remove
     std::function<void(const std::string&)> remove_order_tracking;
-    std::function<std::unordered_set<std::string>&()> get_active_order_ids;
     std::function<void(const std::string&)> ensure_strategy_key;
     std::function<void(const std::string&)> remove_strategy_tracking;
 };
@@ -3,20 +3,25 @@
 #include "engine_backtest.hpp"
 #include "engine_data_historical.hpp"
 #include "engine_main.hpp"
+#include "replay.hpp"
+#include "result_writer.hpp"
+#include "scheduler.hpp"
+#include "utilities/thread_pool.hpp"
 
 #include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <functional>
 #include <cmath>
 #include <ctime>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <numeric>
+#include <optional>
 #include <sstream>
-#include <stop_token>
 #include <string>
-#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -139,18 +144,447 @@ std::string ts_to_iso(backtest::Timestamp ts) {
     return os.str();
 }
 
+/** UTC calendar day of ts (days since epoch), the day ts_to_iso would print. */
+int64_t utc_day(backtest::Timestamp ts) {
+    return std::chrono::floor<std::chrono::days>(ts).time_since_epoch().count();
+}
+
+/** "YYYY-MM-DD" or "YYYY-MM-DDTHH:MM[:SS]" as UTC; nullopt if malformed. */
+std::optional<backtest::Timestamp> parse_iso_utc(const std::string& s) {
+    std::tm tm{};
+    std::istringstream is(s);
+    is >> std::get_time(&tm, "%Y-%m-%d");
+    if (is.fail()) {
+        return std::nullopt;
+    }
+    if (is.peek() == 'T' || is.peek() == ' ') {
+        is.get();
+        is >> std::get_time(&tm, "%H:%M");
+        if (is.fail()) {
+            return std::nullopt;
+        }
+        if (is.peek() == ':') {
+            is.get();
+            is >> tm.tm_sec;
+        }
+    }
+    tm.tm_isdst = 0;
+#if defined(_WIN32)
+    const std::time_t t = _mkgmtime(&tm);
+#else
+    const std::time_t t = timegm(&tm);
+#endif
+    if (t == -1) {
+        return std::nullopt;
+    }
+    return std::chrono::system_clock::from_time_t(t);
+}
+
 void print_error_json(const std::string& msg) {
     std::cout << "{\"status\":\"error\",\"error\":\"" << json_escape(msg) << "\"}" << std::flush;
 }
 
+/** Annualized Sharpe of per-day net PnL (0 with fewer than two days or no variance). */
+double daily_sharpe(const std::vector<double>& daily_returns) {
+    if (daily_returns.size() < 2) {
+        return 0.0;
+    }
+    double mean = 0.0;
+    for (double ret : daily_returns)
+        mean += ret;
+    mean /= static_cast<double>(daily_returns.size());
+    double var = 0.0;
+    for (double ret : daily_returns) {
+        const double d = ret - mean;
+        var += d * d;
+    }
+    var /= static_cast<double>(daily_returns.size() - 1);
+    const double stdv = std::sqrt(var);
+    return stdv > 1e-12 ? mean / stdv * std::sqrt(252.0) : 0.0;
+}
+
+/** Bar length "250ms", "1s", "1m", "5m", "1h" (bare number = seconds); nullopt if malformed. */
+std::optional<std::chrono::nanoseconds> parse_bar_interval(const std::string& s) {
+    size_t pos = 0;
+    double value = 0.0;
+    try {
+        value = std::stod(s, &pos);
+    } catch (...) {
+        return std::nullopt;
+    }
+    const std::string unit = s.substr(pos);
+    double scale = 0.0;
+    if (unit == "ms") {
+        scale = 1e6;
+    } else if (unit.empty() || unit == "s") {
+        scale = 1e9;
+    } else if (unit == "m") {
+        scale = 60e9;
+    } else if (unit == "h") {
+        scale = 3600e9;
+    }
+    if (scale == 0.0 || !(value >= 0.0)) {
+        return std::nullopt;
+    }
+    return std::chrono::nanoseconds(static_cast<int64_t>(std::llround(value * scale)));
+}
+
+/** Sweep values: "a,b,c" list or "start:stop:step" inclusive range; empty if malformed. */
+std::vector<double> parse_sweep_values(const std::string& s) {
+    std::vector<double> values;
+    try {
+        if (s.find(':') != std::string::npos) {
+            std::istringstream is(s);
+            std::string a, b, c;
+            std::getline(is, a, ':');
+            std::getline(is, b, ':');
+            std::getline(is, c, ':');
+            const double start = std::stod(a);
+            const double stop = std::stod(b);
+            const double step = c.empty() ? 1.0 : std::stod(c);
+            if (step <= 0.0 || stop < start) {
+                return {};
+            }
+            // Index-based so accumulated rounding never drops the last point.
+            const auto n = static_cast<size_t>(std::floor((stop - start) / step + 1e-9)) + 1;
+            for (size_t i = 0; i < n; ++i) {
+                values.push_back(start + static_cast<double>(i) * step);
+            }
+            return values;
+        }
+        std::istringstream is(s);
+        std::string item;
+        while (std::getline(is, item, ',')) {
+            values.push_back(std::stod(item));
+        }
+    } catch (...) {
+        return {};
+    }
+    return values;
+}
+
+/** Cartesian product of per-key values (keys in argument order, last key varies fastest). */
+std::vector<backtest::StrategySetting>
+expand_sweep_grid(const std::vector<std::pair<std::string, std::vector<double>>>& grid) {
+    std::vector<backtest::StrategySetting> settings(1);
+    for (const auto& [key, values] : grid) {
+        std::vector<backtest::StrategySetting> next;
+        next.reserve(settings.size() * values.size());
+        for (const auto& base : settings) {
+            for (double v : values) {
+                next.push_back(base);
+                next.back()[key] = v;
+            }
+        }
+        settings = std::move(next);
+    }
+    return settings;
+}
+
+/** Command-line state a sweep needs; configure applies loader/pricing flags before a load. */
+struct SweepOptions {
+    std::vector<std::string> files;
+    std::string strategy_name;
+    double fee_rate = 0.0;
+    double slippage_bps = 0.0;
+    int log_level = 0;
+    unsigned int n_workers = 0;
+    std::function<void(backtest::BacktestEngine&)> configure;
+};
+
+/** One parameter set accumulated over the files it has been run on. */
+struct SweepAggregate {
+    backtest::StrategySetting setting;
+    double pnl = 0.0;
+    double fees = 0.0;
+    /** Drawdown of the per-file PnL paths laid end to end. */
+    double max_drawdown = 0.0;
+    /** Running peak of that stitched path. */
+    double peak_pnl = 0.0;
+    int total_orders = 0;
+    int processed_timesteps = 0;
+    std::vector<double> daily_net_pnl{};
+    std::vector<std::string> errors{};
+    /** Still in the running (successive halving prunes the rest). */
+    bool survivor = true;
+
+    [[nodiscard]] double net_pnl() const { return pnl - fees; }
+};
+
+/** BacktestResult-derived ranking metric for successive halving. */
+enum class HalvingMetric { PNL, NET_PNL, DRAWDOWN, SHARPE };
+
+std::optional<HalvingMetric> parse_halving_metric(const std::string& s) {
+    if (s == "pnl")
+        return HalvingMetric::PNL;
+    if (s == "net_pnl")
+        return HalvingMetric::NET_PNL;
+    if (s == "drawdown")
+        return HalvingMetric::DRAWDOWN;
+    if (s == "sharpe")
+        return HalvingMetric::SHARPE;
+    return std::nullopt;
+}
+
+/** Higher is better. */
+double halving_score(const SweepAggregate& a, HalvingMetric metric) {
+    switch (metric) {
+        using enum HalvingMetric;
+    case PNL:
+        return a.pnl;
+    case DRAWDOWN:
+        return -a.max_drawdown;
+    case SHARPE:
+        return daily_sharpe(a.daily_net_pnl);
+    case NET_PNL:
+    default:
+        return a.net_pnl();
+    }
+}
+
+/**
+ * Run every aggregate's setting over files[file_begin, file_end) in order: each file is loaded
+ * once and shared by all settings. Emits one progress line per file.
+ */
+void run_sweep_files(const SweepOptions& opts, std::vector<SweepAggregate>& aggs,
+                     size_t file_begin, size_t file_end) {
+    std::vector<backtest::StrategySetting> settings;
+    settings.reserve(aggs.size());
+    for (const auto& a : aggs)
+        settings.push_back(a.setting);
+    for (size_t f = file_begin; f < file_end; ++f) {
+        backtest::BacktestEngine source;
+        source.configure_execution(opts.fee_rate, opts.slippage_bps);
+        source.main_engine()->set_log_level(opts.log_level);
+        opts.configure(source);
+        source.load_backtest_data(opts.files[f]);
+        std::vector<backtest::SweepResult> results =
+            source.run_sweep(opts.strategy_name, settings, opts.n_workers);
+        for (size_t i = 0; i < results.size(); ++i) {
+            SweepAggregate& a = aggs[i];
+            const backtest::BacktestResult& r = results[i].result;
+            // This file's path starts where the previous files' PnL left off: the drawdown is
+            // either inside the file or from the earlier running peak down to its trough.
+            const double offset = a.pnl;
+            a.max_drawdown = std::max(a.max_drawdown, r.max_drawdown);
+            if (a.daily_net_pnl.empty()) {
+                a.peak_pnl = offset + results[i].peak_pnl;
+            } else {
+                a.max_drawdown =
+                    std::max(a.max_drawdown, a.peak_pnl - (offset + results[i].trough_pnl));
+                a.peak_pnl = std::max(a.peak_pnl, offset + results[i].peak_pnl);
+            }
+            a.pnl += r.final_pnl;
+            a.fees += results[i].fees;
+            a.total_orders += r.total_orders;
+            a.processed_timesteps += r.processed_timesteps;
+            a.daily_net_pnl.push_back(r.final_pnl - results[i].fees);
+            a.errors.insert(a.errors.end(), r.errors.begin(), r.errors.end());
+        }
+        const size_t completed = f + 1;
+        const size_t total = opts.files.size();
+        std::ostringstream line;
+        line << "{\"type\":\"progress\",\"completed\":" << completed << ",\"total\":" << total
+             << ",\"progress\":" << (completed * 100) / total << ",\"file\":\""
+             << json_escape(opts.files[f]) << "\"}\n";
+        std::cerr << line.str() << std::flush;
+    }
+}
+
+void write_setting_json(std::ostream& out, const backtest::StrategySetting& setting) {
+    out << "{";
+    std::vector<std::pair<std::string, double>> kv(setting.begin(), setting.end());
+    std::ranges::sort(kv);
+    for (size_t k = 0; k < kv.size(); ++k) {
+        out << (k > 0 ? "," : "") << "\"" << json_escape(kv[k].first) << "\":" << kv[k].second;
+    }
+    out << "}";
+}
+
+/**
+ * Successive halving: run the survivors on the next slice of files (first_slice files, doubling
+ * each round), rank by metric over every file seen so far, keep the top keep_fraction (at least
+ * one) and repeat until the files run out. Rankings go to stderr as {"type":"halving"} lines.
+ */
+void run_successive_halving(const SweepOptions& opts, std::vector<SweepAggregate>& aggs,
+                            HalvingMetric metric, double keep_fraction, size_t first_slice) {
+    std::vector<size_t> alive(aggs.size());
+    std::iota(alive.begin(), alive.end(), size_t{0});
+    size_t file_begin = 0;
+    size_t slice = std::max<size_t>(first_slice, 1);
+    for (int round = 1; file_begin < opts.files.size() && !alive.empty(); ++round) {
+        // The last survivor takes all remaining files at once.
+        const size_t file_end =
+            alive.size() == 1 ? opts.files.size() : std::min(opts.files.size(), file_begin + slice);
+        std::vector<SweepAggregate> batch;
+        batch.reserve(alive.size());
+        for (size_t i : alive)
+            batch.push_back(std::move(aggs[i]));
+        run_sweep_files(opts, batch, file_begin, file_end);
+        for (size_t k = 0; k < alive.size(); ++k)
+            aggs[alive[k]] = std::move(batch[k]);
+        file_begin = file_end;
+        slice *= 2;
+
+        std::ranges::stable_sort(alive, std::greater<>{}, [&aggs, metric](size_t i) {
+            return halving_score(aggs[i], metric);
+        });
+        const size_t keep =
+            file_begin < opts.files.size()
+                ? std::max<size_t>(1, static_cast<size_t>(std::ceil(
+                                          static_cast<double>(alive.size()) * keep_fraction)))
+                : alive.size();
+        std::ostringstream line;
+        line << "{\"type\":\"halving\",\"round\":" << round << ",\"files_done\":" << file_begin
+             << ",\"candidates\":" << alive.size() << ",\"kept\":" << keep << ",\"ranking\":[";
+        for (size_t k = 0; k < alive.size(); ++k) {
+            line << (k > 0 ? "," : "") << "{\"setting\":";
+            write_setting_json(line, aggs[alive[k]].setting);
+            line << ",\"score\":" << halving_score(aggs[alive[k]], metric) << "}";
+        }
+        line << "]}\n";
+        std::cerr << line.str() << std::flush;
+        for (size_t k = keep; k < alive.size(); ++k)
+            aggs[alive[k]].survivor = false;
+        alive.resize(keep);
+    }
+}
+
+void write_sweep_result_json(std::ostream& out, const SweepAggregate& a) {
+    out << "{\"setting\":";
+    write_setting_json(out, a.setting);
+    out << ",";
+    out << "\"survivor\":" << (a.survivor ? "true" : "false") << ",";
+    out << "\"final_pnl\":" << a.pnl << ",";
+    out << "\"total_fees\":" << a.fees << ",";
+    out << "\"net_pnl\":" << a.net_pnl() << ",";
+    out << "\"max_drawdown\":" << a.max_drawdown << ",";
+    out << "\"daily_sharpe\":" << daily_sharpe(a.daily_net_pnl) << ",";
+    out << "\"total_orders\":" << a.total_orders << ",";
+    out << "\"processed_timesteps\":" << a.processed_timesteps << ",";
+    out << "\"num_days\":" << a.daily_net_pnl.size() << ",";
+    out << "\"errors\":[";
+    for (size_t e = 0; e < a.errors.size(); ++e) {
+        out << (e > 0 ? "," : "") << "\"" << json_escape(a.errors[e]) << "\"";
+    }
+    out << "]}";
+}
+
+/**
+ * --replay <journal> <strategy_name> [--portfolio name] [--pace max|recorded] [--speed x] [--log]
+ * [key=value ...]: push a live event journal through the backtest engines and report how the
+ * strategy's orders compare with the live ones.
+ */
+int run_replay(int argc, char* argv[]) {
+    if (argc < 4) {
+        print_error_json("Usage: backtest_entry --replay <journal> <strategy_name> "
+                         "[--portfolio name] [--pace max|recorded] [--speed x] [--log] "
+                         "[key=value ...]");
+        return 1;
+    }
+    const std::string journal_path = argv[2];
+    const std::string strategy_name = argv[3];
+    std::string portfolio;
+    backtest::ReplayPace pace = backtest::ReplayPace::Max;
+    double speed = 1.0;
+    int log_level = engines::DISABLED;
+    std::unordered_map<std::string, double> strategy_setting;
+    for (int i = 4; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--portfolio" && i + 1 < argc) {
+            portfolio = argv[++i];
+            continue;
+        }
+        if (arg == "--pace" && i + 1 < argc) {
+            pace = std::string(argv[++i]) == "recorded" ? backtest::ReplayPace::Recorded
+                                                        : backtest::ReplayPace::Max;
+            continue;
+        }
+        if (arg == "--speed" && i + 1 < argc) {
+            try {
+                speed = std::stod(argv[++i]);
+            } catch (...) {
+                // Keep default if invalid.
+            }
+            continue;
+        }
+        if (arg == "--log") {
+            log_level = engines::INFO;
+            continue;
+        }
+        const auto pos = arg.find('=');
+        if (pos == std::string::npos || pos == 0 || pos == arg.size() - 1)
+            continue;
+        try {
+            strategy_setting[arg.substr(0, pos)] = std::stod(arg.substr(pos + 1));
+        } catch (...) {
+            // Ignore non-numeric strategy settings in C++ runner.
+        }
+    }
+
+    try {
+        backtest::JournalReplay replay;
+        replay.main_engine()->set_log_level(log_level);
+        replay.open(journal_path);
+        replay.add_strategy(strategy_name, portfolio, strategy_setting);
+        replay.set_pace(pace, speed);
+        const backtest::ReplayResult r = replay.run();
+
+        std::ostringstream out;
+        out << "{\"status\":\"ok\",\"mode\":\"replay\",";
+        out << "\"journal\":\"" << json_escape(journal_path) << "\",";
+        out << "\"strategy_name\":\"" << json_escape(r.strategy_name) << "\",";
+        out << "\"portfolio_name\":\"" << json_escape(r.portfolio_name) << "\",";
+        out << "\"records\":" << r.records << ",";
+        out << "\"snapshots\":" << r.snapshots << ",";
+        out << "\"orders\":" << r.orders << ",";
+        out << "\"trades\":" << r.trades << ",";
+        out << "\"timers\":" << r.timers << ",";
+        out << "\"orders_sent\":" << r.orders_sent << ",";
+        out << "\"orders_matched\":" << r.orders_matched << ",";
+        out << "\"orders_diverged\":" << r.orders_diverged << ",";
+        out << "\"orders_missing\":" << r.orders_missing << ",";
+        out << "\"cancels_matched\":" << r.cancels_matched << ",";
+        out << "\"cancels_diverged\":" << r.cancels_diverged << ",";
+        out << "\"cancels_missing\":" << r.cancels_missing << ",";
+        out << "\"first_divergence\":\"" << json_escape(r.first_divergence) << "\",";
+        out << "\"truncated\":" << (r.truncated ? "true" : "false") << ",";
+        out << "\"final_pnl\":" << r.final_pnl << ",";
+        out << "\"errors\":[";
+        for (size_t e = 0; e < r.errors.size(); ++e) {
+            out << (e > 0 ? "," : "") << "\"" << json_escape(r.errors[e]) << "\"";
+        }
+        out << "],";
+        out << "\"duration_seconds\":" << std::fixed << std::setprecision(3) << r.wall_seconds
+            << "}";
+        std::cout << out.str() << std::flush;
+    } catch (const std::exception& e) {
+        print_error_json(e.what());
+        return 1;
+    }
+    return 0;
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
+    if (argc >= 2 && std::string(argv[1]) == "--replay") {
+        return run_replay(argc, argv);
+    }
     if (argc < 3) {
         print_error_json(
             "Usage: backtest_entry <parquet_path>|<--files file1 file2 ...> <strategy_name> "
-            "[--fee-rate number] [--slippage-bps number] "
-            "[--risk-free-rate number] [--iv-price-mode mid|bid|ask] [--log] [key=value ...]");
+            "[--fee-rate number] [--slippage-bps number] [--fill-model top|depth] "
+            "[--fill-participation fraction] [--queue-ahead fraction] "
+            "[--output json|arrow|parquet] [--output-dir dir] [--chart-points n] "
+            "[--risk-free-rate number] [--iv-price-mode mid|bid|ask] "
+            "[--incremental-eps number] [--incremental-tau-eps years] [--precompute-greeks] "
+            "[--stream] [--stream-ring n] [--sparse-snapshots] [--start iso] [--end iso] "
+            "[--bar 1s|1m|5m] [--persist-sort-index] [--snapshot-cache dir] [--workers n] "
+            "[--sweep] [--halving pnl|net_pnl|drawdown|sharpe] [--halving-keep fraction] "
+            "[--halving-files n] [--sync] [--log] "
+            "[key=value ...] (with --sweep: key=a,b,c or key=start:stop:step) | "
+            "--replay <journal> <strategy_name> [...]");
         return 1;
     }
 
@@ -158,8 +592,34 @@ int main(int argc, char* argv[]) {
     std::string strategy_name;
     double fee_rate = 0.35;
     double slippage_bps = 5.0;
+    backtest::FillModel fill_model = backtest::FillModel::TopOfBook;
+    double fill_participation = 1.0;
+    double queue_ahead = 0.0;
+    backtest::ResultFormat output = backtest::ResultFormat::Json;
+    std::string output_dir = "backtest_output";
+    std::optional<size_t> chart_points;
     double risk_free_rate = 0.05;
     std::string iv_price_mode = "mid";
+    bool incremental = false;
+    double incremental_eps = 0.0;
+    double incremental_tau_eps = utilities::PortfolioData::kDefaultTauEpsilon;
+    bool precompute_greeks = false;
+    bool stream = false;
+    size_t stream_ring = 4;
+    bool sparse_snapshots = false;
+    std::string bar_arg;
+    std::chrono::nanoseconds bar{0};
+    std::optional<backtest::Timestamp> range_start;
+    std::optional<backtest::Timestamp> range_end;
+    bool persist_sort_index = false;
+    std::string snapshot_cache_dir;
+    unsigned int n_workers = 0;
+    bool sweep = false;
+    std::optional<HalvingMetric> halving_metric;
+    double halving_keep = 0.5;
+    size_t halving_files = 1;
+    bool sync = false;
+    std::vector<std::pair<std::string, std::string>> setting_args;
     int log_level = engines::DISABLED;
     {
         const char* log_env = std::getenv("BACKTEST_LOG");
@@ -177,7 +637,18 @@ int main(int argc, char* argv[]) {
             const std::string arg = argv[arg_idx];
             // Stop if we hit a flag or key=value (strategy_name should come before these)
             if (arg == "--fee-rate" || arg == "--slippage-bps" || arg == "--risk-free-rate" ||
-                arg == "--iv-price-mode" || arg == "--log" || arg.find('=') != std::string::npos) {
+                arg == "--iv-price-mode" || arg == "--incremental-eps" ||
+                arg == "--incremental-tau-eps" || arg == "--precompute-greeks" ||
+                arg == "--stream" || arg == "--stream-ring" || arg == "--sparse-snapshots" ||
+                arg == "--bar" ||
+                arg == "--start" || arg == "--end" || arg == "--persist-sort-index" ||
+                arg == "--snapshot-cache" || arg == "--workers" || arg == "--sweep" ||
+                arg == "--halving" || arg == "--halving-keep" || arg == "--halving-files" ||
+                arg == "--sync" || arg == "--log" || arg == "--fill-model" ||
+                arg == "--fill-participation" ||
+                arg == "--queue-ahead" || arg == "--output" || arg == "--output-dir" ||
+                arg == "--chart-points" ||
+                arg.find('=') != std::string::npos) {
                 break;
             }
             // Check if it looks like a strategy name (no slash, no dot)
@@ -229,6 +700,47 @@ int main(int argc, char* argv[]) {
             }
             continue;
         }
+        if (arg == "--output" && i + 1 < argc) {
+            const std::string fmt = argv[++i];
+            if (auto f = backtest::parse_result_format(fmt)) {
+                output = *f;
+            } else {
+                print_error_json("Invalid --output: " + fmt + " (use json|arrow|parquet)");
+                return 1;
+            }
+            continue;
+        }
+        if (arg == "--output-dir" && i + 1 < argc) {
+            output_dir = argv[++i];
+            continue;
+        }
+        if (arg == "--chart-points" && i + 1 < argc) {
+            try {
+                chart_points = static_cast<size_t>(std::max(0, std::stoi(argv[++i])));
+            } catch (...) {
+                // Keep default if invalid.
+            }
+            continue;
+        }
+        if (arg == "--fill-model" && i + 1 < argc) {
+            // Unknown model keeps top of book.
+            fill_model = std::string(argv[++i]) == "depth" ? backtest::FillModel::Depth
+                                                           : backtest::FillModel::TopOfBook;
+            continue;
+        }
+        if ((arg == "--fill-participation" || arg == "--queue-ahead") && i + 1 < argc) {
+            try {
+                const double v = std::stod(argv[++i]);
+                if (arg == "--queue-ahead") {
+                    queue_ahead = std::max(0.0, v);
+                } else if (v > 0.0 && v <= 1.0) {
+                    fill_participation = v;
+                }
+            } catch (...) {
+                // Keep default if invalid.
+            }
+            continue;
+        }
         if (arg == "--risk-free-rate" && i + 1 < argc) {
             try {
                 risk_free_rate = std::stod(argv[++i]);
@@ -241,10 +753,105 @@ int main(int argc, char* argv[]) {
             iv_price_mode = argv[++i];
             continue;
         }
+        if ((arg == "--incremental-eps" || arg == "--incremental-tau-eps") && i + 1 < argc) {
+            try {
+                const double eps = std::max(0.0, std::stod(argv[++i]));
+                (arg == "--incremental-eps" ? incremental_eps : incremental_tau_eps) = eps;
+                incremental = true;
+            } catch (...) {
+                // Keep full recompute if invalid.
+            }
+            continue;
+        }
+        if (arg == "--precompute-greeks") {
+            precompute_greeks = true;
+            continue;
+        }
+        if ((arg == "--start" || arg == "--end") && i + 1 < argc) {
+            // Unparseable bound stays unbounded.
+            (arg == "--start" ? range_start : range_end) = parse_iso_utc(argv[++i]);
+            continue;
+        }
+        if (arg == "--persist-sort-index") {
+            persist_sort_index = true;
+            continue;
+        }
+        if (arg == "--workers" && i + 1 < argc) {
+            try {
+                n_workers = static_cast<unsigned int>(std::max(0, std::stoi(argv[++i])));
+            } catch (...) {
+                // Keep the default (core count) if invalid.
+            }
+            continue;
+        }
+        if (arg == "--snapshot-cache" && i + 1 < argc) {
+            snapshot_cache_dir = argv[++i];
+            continue;
+        }
+        if (arg == "--bar" && i + 1 < argc) {
+            // Unparseable bar keeps every timestamp.
+            if (auto b = parse_bar_interval(argv[++i])) {
+                bar_arg = argv[i];
+                bar = *b;
+            }
+            continue;
+        }
+        if (arg == "--sparse-snapshots") {
+            sparse_snapshots = true;
+            continue;
+        }
+        if (arg == "--stream") {
+            stream = true;
+            continue;
+        }
+        if (arg == "--stream-ring" && i + 1 < argc) {
+            try {
+                stream_ring = static_cast<size_t>(std::max(2, std::stoi(argv[++i])));
+                stream = true;
+            } catch (...) {
+                // Keep default ring size if invalid.
+            }
+            continue;
+        }
         if (arg == "--log") {
             log_level = engines::INFO;
             continue;
         }
+        if (arg == "--sync") {
+            sync = true;
+            continue;
+        }
+        if (arg == "--sweep") {
+            sweep = true;
+            continue;
+        }
+        if (arg == "--halving" && i + 1 < argc) {
+            const std::string metric = argv[++i];
+            halving_metric = parse_halving_metric(metric);
+            if (!halving_metric) {
+                print_error_json("Invalid --halving: " + metric +
+                                 " (use pnl|net_pnl|drawdown|sharpe)");
+                return 1;
+            }
+            sweep = true;
+            continue;
+        }
+        if (arg == "--halving-keep" && i + 1 < argc) {
+            try {
+                halving_keep = std::clamp(std::stod(argv[++i]), 0.0, 1.0);
+            } catch (...) {
+                // Keep default if invalid.
+            }
+            continue;
+        }
+        if (arg == "--halving-files" && i + 1 < argc) {
+            try {
+                halving_files = static_cast<size_t>(std::max(1, std::stoi(argv[++i])));
+            } catch (...) {
+                // Keep default if invalid.
+            }
+            continue;
+        }
 
         std::string kv = argv[i];
         auto pos = kv.find('=');
@@ -252,6 +859,7 @@ int main(int argc, char* argv[]) {
             continue;
         std::string key = kv.substr(0, pos);
         std::string val = kv.substr(pos + 1);
+        setting_args.emplace_back(key, val);
         try {
             strategy_setting[key] = std::stod(val);
         } catch (...) {
@@ -259,30 +867,97 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    try {
-        struct Metric {
-            int timestep = 0;
-            std::string timestamp;
-            double pnl = 0.0;
-            double delta = 0.0;
-            double theta = 0.0;
-            double gamma = 0.0;
-            double fees = 0.0;
+    // Sizes the pool shared by file workers and apply_frame before anything first uses it.
+    utilities::ThreadPool::configure_shared(n_workers, false);
+
+    // --sync: the files are one run, one underlying each, merged onto one clock.
+    std::vector<std::string> sync_files;
+    if (sync) {
+        if (sweep) {
+            print_error_json("--sync does not support --sweep");
+            return 1;
+        }
+        sync_files = parquet_files;
+        parquet_files.resize(1);
+    }
+
+    if (sweep) {
+        std::vector<std::pair<std::string, std::vector<double>>> grid;
+        for (const auto& [key, val] : setting_args) {
+            std::vector<double> values = parse_sweep_values(val);
+            if (values.empty()) {
+                print_error_json("Invalid sweep values for " + key + ": " + val);
+                return 1;
+            }
+            grid.emplace_back(key, std::move(values));
+        }
+        SweepOptions opts;
+        opts.files = parquet_files;
+        opts.strategy_name = strategy_name;
+        opts.fee_rate = fee_rate;
+        opts.slippage_bps = slippage_bps;
+        opts.log_level = log_level;
+        opts.n_workers = n_workers;
+        // Sweeps replay materialized snapshots, so streaming is forced off.
+        opts.configure = [&](backtest::BacktestEngine& engine) {
+            engine.configure_fill_model(fill_model, fill_participation, queue_ahead);
+            engine.configure_snapshots(false, stream_ring, sparse_snapshots, bar);
+            engine.configure_loader(range_start, range_end, persist_sort_index,
+                                    snapshot_cache_dir);
+            engine.configure_pricing(risk_free_rate, iv_price_mode, incremental, incremental_eps,
+                                     incremental_tau_eps, precompute_greeks);
         };
+        try {
+            const auto t0 = std::chrono::steady_clock::now();
+            std::vector<SweepAggregate> aggs;
+            for (auto& setting : expand_sweep_grid(grid)) {
+                aggs.push_back(SweepAggregate{.setting = std::move(setting)});
+            }
+            if (halving_metric) {
+                run_successive_halving(opts, aggs, *halving_metric, halving_keep, halving_files);
+            } else {
+                run_sweep_files(opts, aggs, 0, opts.files.size());
+            }
+            const double duration_seconds =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+            std::ostringstream out;
+            out << "{\"status\":\"ok\",\"mode\":\"sweep\",";
+            out << "\"strategy_name\":\"" << json_escape(strategy_name) << "\",";
+            out << "\"num_files\":" << opts.files.size() << ",";
+            out << "\"num_settings\":" << aggs.size() << ",";
+            out << "\"halving\":" << (halving_metric ? "true" : "false") << ",";
+            out << "\"results\":[";
+            for (size_t i = 0; i < aggs.size(); ++i) {
+                if (i > 0)
+                    out << ",";
+                write_sweep_result_json(out, aggs[i]);
+            }
+            out << "],";
+            out << "\"duration_seconds\":" << std::fixed << std::setprecision(3)
+                << duration_seconds << "}";
+            std::cout << out.str() << std::flush;
+        } catch (const std::exception& e) {
+            print_error_json(e.what());
+            return 1;
+        }
+        return 0;
+    }
 
+    try {
         struct DailyResult {
             std::string file_path;
             backtest::BacktestResult result;
             double daily_pnl = 0.0;
             double daily_fees = 0.0;
             size_t file_index = 0;
-            /** Per-file timestep metrics (multi-file: merged in file_index order to avoid sort). */
-            std::vector<Metric> file_metrics;
+            /** Per-file timestep metrics (multi-file: joined in file_index order, no sort). */
+            backtest::MetricsRecorder file_metrics;
+            /** Orders/trades, kept only until written by the columnar output. */
+            backtest::FillRecorder fills;
         };
 
-        std::vector<Metric> metrics;
-        size_t estimated_total_metrics = parquet_files.size() * 390;
-        metrics.reserve(estimated_total_metrics + estimated_total_metrics / 5);
+        backtest::MetricsSeries metrics;
 
         std::vector<DailyResult> daily_results(parquet_files.size());
         std::vector<double> daily_returns(parquet_files.size());
@@ -290,36 +965,53 @@ int main(int argc, char* argv[]) {
         auto overall_start_time = std::chrono::system_clock::now();
         std::chrono::system_clock::time_point overall_end_time;
 
-        auto run_one_file = [&](backtest::BacktestEngine& file_engine, size_t file_idx,
-                                std::vector<Metric>* out_metrics, int* base_timestep_val) {
+        // Columnar output: a file's tables go out as soon as every earlier file has been written,
+        // so the streams stay in file (chronological) order while workers finish out of order.
+        std::unique_ptr<backtest::ResultWriter> writer;
+        if (output != backtest::ResultFormat::Json)
+            writer = std::make_unique<backtest::ResultWriter>(output, output_dir);
+        std::mutex writer_mutex;
+        std::vector<uint8_t> file_done(parquet_files.size(), 0);
+        size_t next_to_write = 0;
+        auto stream_results = [&](size_t file_idx) {
+            if (!writer)
+                return;
+            std::scoped_lock lk(writer_mutex);
+            file_done[file_idx] = 1;
+            for (; next_to_write < file_done.size() && file_done[next_to_write] != 0;
+                 ++next_to_write) {
+                DailyResult& d = daily_results[next_to_write];
+                backtest::DailySummary summary{.file_index = d.file_index,
+                                               .file = d.file_path,
+                                               .start_time = d.result.start_time,
+                                               .end_time = d.result.end_time,
+                                               .pnl = d.daily_pnl,
+                                               .fees = d.daily_fees,
+                                               .orders = d.result.total_orders,
+                                               .timesteps = d.result.processed_timesteps,
+                                               .rows = d.result.total_rows};
+                writer->write_file(summary, d.file_metrics, d.fills);
+                d.fills = {};
+            }
+        };
+
+        auto run_one_file = [&](backtest::BacktestEngine& file_engine, size_t file_idx) {
             file_engine.reset();
-            std::vector<Metric> file_metrics;
-            file_metrics.reserve(400);
-            file_engine.register_timestep_callback([&](int timestep, backtest::Timestamp ts) {
-                Metric m;
-                m.timestep = timestep;
-                m.timestamp = ts_to_iso(ts);
-                m.fees = file_engine.get_cumulative_fees();
-                auto* me = file_engine.main_engine();
-                if (me && me->option_strategy_engine()) {
-                    auto* holding = me->option_strategy_engine()->get_strategy_holding();
-                    if (holding) {
-                        m.pnl = holding->summary.pnl;
-                        m.delta = holding->summary.delta;
-                        m.gamma = holding->summary.gamma;
-                        m.theta = holding->summary.theta;
-                    }
-                }
-                file_metrics.push_back(m);
-            });
-            file_engine.load_backtest_data(parquet_files[file_idx]);
-            file_engine.add_strategy(strategy_name, strategy_setting);
-            if (auto* me = file_engine.main_engine()) {
-                if (auto* de = me->get_data_engine()) {
-                    de->set_risk_free_rate(risk_free_rate);
-                    de->set_iv_price_mode(iv_price_mode);
-                }
+            file_engine.record_metrics(true);
+            file_engine.record_fills(writer != nullptr);
+            file_engine.configure_fill_model(fill_model, fill_participation, queue_ahead);
+            file_engine.configure_snapshots(stream, stream_ring, sparse_snapshots, bar);
+            file_engine.configure_loader(range_start, range_end, persist_sort_index,
+                                         snapshot_cache_dir);
+            file_engine.configure_pricing(risk_free_rate, iv_price_mode, incremental,
+                                          incremental_eps, incremental_tau_eps,
+                                          precompute_greeks);
+            if (sync_files.empty()) {
+                file_engine.load_backtest_data(parquet_files[file_idx]);
+            } else {
+                file_engine.load_synchronized_data(sync_files);
             }
+            file_engine.add_strategy(strategy_name, strategy_setting);
             backtest::BacktestResult file_result = file_engine.run();
 
             DailyResult daily;
@@ -328,138 +1020,76 @@ int main(int argc, char* argv[]) {
             daily.daily_pnl = file_result.final_pnl;
             daily.daily_fees = file_engine.get_cumulative_fees();
             daily.file_index = file_idx;
+            daily.file_metrics = file_engine.take_metrics();
+            daily.fills = file_engine.take_fills();
             double daily_net_pnl = daily.daily_pnl - daily.daily_fees;
 
-            daily_results[file_idx] = daily;
             daily_returns[file_idx] = daily_net_pnl;
-
-            if (out_metrics && base_timestep_val) {
-                for (auto& m : file_metrics) {
-                    m.timestep = *base_timestep_val + m.timestep;
-                    out_metrics->push_back(std::move(m));
-                }
-                if (!file_metrics.empty())
-                    *base_timestep_val += file_metrics.back().timestep + 1;
-            }
+            daily_results[file_idx] = std::move(daily);
+            stream_results(file_idx);
         };
 
         if (parquet_files.size() == 1) {
             backtest::BacktestEngine engine;
             engine.configure_execution(fee_rate, slippage_bps);
             engine.main_engine()->set_log_level(log_level);
-            int base = 0;
-            run_one_file(engine, 0, &metrics, &base);
+            run_one_file(engine, 0);
             overall_end_time = std::chrono::system_clock::now();
         } else {
-            std::mutex results_mutex;
+            // Largest files first, work stealing across per-worker deques; file workers run on
+            // the shared pool sized by --workers, so apply_frame chunks share the same budget.
+            backtest::BacktestScheduler scheduler(
+                backtest::BacktestScheduler::file_weights(parquet_files), n_workers);
             std::atomic<int> completed_count{0};
-            constexpr int num_engines = 4;
-            std::queue<size_t> file_queue;
-            for (size_t i = 0; i < parquet_files.size(); ++i)
-                file_queue.push(i);
-
-            std::stop_source
-                stop_src; // one worker can request_stop() to signal others (e.g. fatal error)
-            auto worker = [&](std::stop_token jthread_token, int engine_id) {
-                (void)engine_id; // Thread ID only, no shared engine index
-                std::stop_token shared_token = stop_src.get_token();
-                while (!jthread_token.stop_requested() && !shared_token.stop_requested()) {
-                    size_t file_idx;
-                    {
-                        std::lock_guard<std::mutex> lock(results_mutex);
-                        if (file_queue.empty())
-                            break;
-                        file_idx = file_queue.front();
-                        file_queue.pop();
-                    }
-                    if (jthread_token.stop_requested() || shared_token.stop_requested())
-                        break;
-                    // Per-file BacktestEngine (isolate state)
-                    backtest::BacktestEngine file_engine;
-                    file_engine.configure_execution(fee_rate, slippage_bps);
-                    file_engine.main_engine()->set_log_level(log_level);
-
-                    std::vector<Metric> file_metrics;
-                    file_metrics.reserve(400);
-                    file_engine.reset();
-                    file_engine.register_timestep_callback([&](int timestep,
-                                                               backtest::Timestamp ts) {
-                        Metric m;
-                        m.timestep = timestep;
-                        m.timestamp = ts_to_iso(ts);
-                        m.fees = file_engine.get_cumulative_fees();
-                        auto* me = file_engine.main_engine();
-                        if (me && me->option_strategy_engine()) {
-                            auto* holding = me->option_strategy_engine()->get_strategy_holding();
-                            if (holding) {
-                                m.pnl = holding->summary.pnl;
-                                m.delta = holding->summary.delta;
-                                m.gamma = holding->summary.gamma;
-                                m.theta = holding->summary.theta;
-                            }
-                        }
-                        file_metrics.push_back(m);
-                    });
-                    file_engine.load_backtest_data(parquet_files[file_idx]);
-                    file_engine.add_strategy(strategy_name, strategy_setting);
-                    if (auto* me = file_engine.main_engine()) {
-                        if (auto* de = me->get_data_engine()) {
-                            de->set_risk_free_rate(risk_free_rate);
-                            de->set_iv_price_mode(iv_price_mode);
-                        }
-                    }
-                    backtest::BacktestResult file_result = file_engine.run();
-
-                    DailyResult daily;
-                    daily.file_path = parquet_files[file_idx];
-                    daily.result = file_result;
-                    daily.daily_pnl = file_result.final_pnl;
-                    daily.daily_fees = file_engine.get_cumulative_fees();
-                    daily.file_index = file_idx;
-                    daily.file_metrics = std::move(file_metrics);
-                    double daily_net_pnl = daily.daily_pnl - daily.daily_fees;
-
-                    {
-                        std::lock_guard<std::mutex> lock(results_mutex);
-                        daily_results[file_idx] = std::move(daily);
-                        daily_returns[file_idx] = daily_net_pnl;
-                        int completed = completed_count.fetch_add(1) + 1;
-                        int total = static_cast<int>(parquet_files.size());
-                        int progress_pct = total > 0 ? (completed * 100) / total : 0;
-                        std::cerr << "{\"type\":\"progress\",\"completed\":" << completed
-                                  << ",\"total\":" << total << ",\"progress\":" << progress_pct
-                                  << ",\"file\":\"" << json_escape(parquet_files[file_idx])
-                                  << "\"}\n"
-                                  << std::flush;
-                    }
-                }
-            };
+            const int total = static_cast<int>(parquet_files.size());
+            scheduler.run([&](unsigned int /*worker*/, size_t file_idx) {
+                // Per-file BacktestEngine (isolate state)
+                backtest::BacktestEngine file_engine;
+                file_engine.configure_execution(fee_rate, slippage_bps);
+                file_engine.main_engine()->set_log_level(log_level);
 
-            {
-                std::vector<std::jthread> threads;
-                threads.reserve(num_engines);
-                for (int i = 0; i < num_engines; ++i)
-                    threads.emplace_back(worker, i);
-                // jthreads join when vector is destroyed
-            }
-            overall_end_time = std::chrono::system_clock::now();
+                file_engine.reset();
+                file_engine.record_metrics(true);
+                file_engine.record_fills(writer != nullptr);
+                file_engine.configure_fill_model(fill_model, fill_participation, queue_ahead);
+                file_engine.configure_snapshots(stream, stream_ring, sparse_snapshots, bar);
+                file_engine.configure_loader(range_start, range_end, persist_sort_index,
+                                             snapshot_cache_dir);
+                file_engine.configure_pricing(risk_free_rate, iv_price_mode, incremental,
+                                              incremental_eps, incremental_tau_eps,
+                                              precompute_greeks);
+                file_engine.load_backtest_data(parquet_files[file_idx]);
+                file_engine.add_strategy(strategy_name, strategy_setting);
+                backtest::BacktestResult file_result = file_engine.run();
 
-            // Merge per-file metrics in file_index order (chronological); avoids sort
-            size_t reserve_total = 0;
-            for (const auto& daily : daily_results)
-                reserve_total += daily.file_metrics.size();
-            metrics.clear();
-            metrics.reserve(reserve_total);
-            int base = 0;
-            for (size_t i = 0; i < daily_results.size(); ++i) {
-                for (auto& m : daily_results[i].file_metrics) {
-                    m.timestep += base;
-                    metrics.push_back(std::move(m));
-                }
-                if (!daily_results[i].file_metrics.empty())
-                    base += static_cast<int>(daily_results[i].file_metrics.size());
-            }
+                DailyResult daily;
+                daily.file_path = parquet_files[file_idx];
+                daily.result = file_result;
+                daily.daily_pnl = file_result.final_pnl;
+                daily.daily_fees = file_engine.get_cumulative_fees();
+                daily.file_index = file_idx;
+                daily.file_metrics = file_engine.take_metrics();
+                daily.fills = file_engine.take_fills();
+                // Each file owns its slot, so results need no lock.
+                daily_returns[file_idx] = daily.daily_pnl - daily.daily_fees;
+                daily_results[file_idx] = std::move(daily);
+                stream_results(file_idx);
+
+                const int completed = completed_count.fetch_add(1) + 1;
+                std::ostringstream line;
+                line << "{\"type\":\"progress\",\"completed\":" << completed
+                     << ",\"total\":" << total << ",\"progress\":" << (completed * 100) / total
+                     << ",\"file\":\"" << json_escape(parquet_files[file_idx]) << "\"}\n";
+                // One write per line so concurrent workers never interleave within a line.
+                std::cerr << line.str() << std::flush;
+            });
+            overall_end_time = std::chrono::system_clock::now();
         }
+        if (writer)
+            writer->close();
+        // Join per-file metrics in file_index order (chronological); moves, no sort or copy
+        for (auto& daily : daily_results)
+            metrics.append(std::move(daily.file_metrics));
 
         auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(overall_end_time -
                                                                                  overall_start_time)
@@ -509,37 +1139,38 @@ int main(int argc, char* argv[]) {
             }
         }
 
-        // Compute max drawdown over the same cross-day PnL path that we use for chart_data.
-        // Backtest engine is responsible for the *intra-day* PnL path; here we only stitch
-        // days together by shifting each day's curve by the previous day's close.
-        double max_drawdown = 0.0;
-        if (!metrics.empty()) {
-            std::string prev_date;
+        // Cross-day PnL path shared by max drawdown and chart_data. Backtest engine is
+        // responsible for the *intra-day* PnL path; here we only stitch days together by
+        // shifting each day's curve by the previous day's close (UTC days from raw timestamps).
+        std::vector<double> full_pnl;
+        std::vector<int> day_boundaries;
+        full_pnl.reserve(metrics.size());
+        {
+            std::optional<int64_t> prev_day;
             double cumulative_offset = 0.0; // accumulated previous days' net PnL
             double day_start_pnl = 0.0;
-            bool have_value = false;
-            double peak = 0.0;
-
-            for (size_t i = 0; i < metrics.size(); ++i) {
-                std::string date_str;
-                if (metrics[i].timestamp.size() >= 10) {
-                    date_str = metrics[i].timestamp.substr(0, 10);
-                }
-                if (date_str != prev_date) {
-                    if (!prev_date.empty() && i > 0) {
-                        // Shift next day's curve by previous day's close (relative to its own
-                        // start).
-                        cumulative_offset += metrics[i - 1].pnl - day_start_pnl;
+            double prev_pnl = 0.0;
+            for (const backtest::MetricsRecorder& part : metrics.parts()) {
+                for (size_t r = 0; r < part.size(); ++r) {
+                    const int64_t day = utc_day(part.timestamps[r]);
+                    if (day != prev_day) {
+                        if (prev_day) {
+                            cumulative_offset += prev_pnl - day_start_pnl;
+                            day_boundaries.push_back(static_cast<int>(full_pnl.size()));
+                        }
+                        prev_day = day;
+                        day_start_pnl = part.pnl[r];
                     }
-                    prev_date = date_str;
-                    day_start_pnl = metrics[i].pnl;
-                }
-                // Intra-day PnL relative to this day's start, then shifted by prior days' closes.
-                double value = (metrics[i].pnl - day_start_pnl) + cumulative_offset;
-                if (!have_value) {
-                    peak = value;
-                    have_value = true;
+                    // Intra-day PnL relative to this day's start, shifted by prior days' closes.
+                    full_pnl.push_back(part.pnl[r] - day_start_pnl + cumulative_offset);
+                    prev_pnl = part.pnl[r];
                 }
+            }
+        }
+        double max_drawdown = 0.0;
+        if (!full_pnl.empty()) {
+            double peak = full_pnl.front();
+            for (const double value : full_pnl) {
                 peak = std::max(peak, value);
                 max_drawdown = std::max(max_drawdown, peak - value);
             }
@@ -549,22 +1180,7 @@ int main(int argc, char* argv[]) {
         backtest::BacktestResult result = aggregated_result;
 
         // Daily Sharpe from daily_returns (net PnL per file, already in file_index order)
-        double daily_sharpe = 0.0;
-        if (daily_returns.size() > 1) {
-            double mean = 0.0;
-            for (double ret : daily_returns)
-                mean += ret;
-            mean /= static_cast<double>(daily_returns.size());
-            double var = 0.0;
-            for (double ret : daily_returns) {
-                const double d = ret - mean;
-                var += d * d;
-            }
-            var /= static_cast<double>(daily_returns.size() - 1);
-            const double stdv = std::sqrt(var);
-            if (stdv > 1e-12)
-                daily_sharpe = mean / stdv * std::sqrt(252.0);
-        }
+        const double sharpe = daily_sharpe(daily_returns);
 
         std::ostringstream out;
         out << "{\"status\":\"ok\",";
@@ -582,12 +1198,17 @@ int main(int argc, char* argv[]) {
         out << "\"max_gamma\":" << result.max_gamma << ",";
         out << "\"max_theta\":" << result.max_theta << ",";
         out << "\"max_drawdown\":" << result.max_drawdown << ",";
-        out << "\"daily_sharpe\":" << daily_sharpe << ",";
+        out << "\"daily_sharpe\":" << sharpe << ",";
         out << "\"total_fees\":" << total_fees << ",";
         out << "\"fill_mode\":\"buy=ask,sell=bid\",";
         out << "\"fee_rate\":" << fee_rate << ",";
         out << "\"risk_free_rate\":" << risk_free_rate << ",";
         out << "\"iv_price_mode\":\"" << json_escape(iv_price_mode) << "\",";
+        out << "\"incremental\":" << (incremental ? "true" : "false") << ",";
+        out << "\"precompute_greeks\":" << (precompute_greeks ? "true" : "false") << ",";
+        out << "\"stream\":" << (stream ? "true" : "false") << ",";
+        out << "\"sparse_snapshots\":" << (sparse_snapshots ? "true" : "false") << ",";
+        out << "\"bar\":\"" << json_escape(bar_arg) << "\",";
         out << "\"final_pnl\":" << result.final_pnl << ",";
         double net_pnl = result.final_pnl - total_fees;
         out << "\"net_pnl\":" << net_pnl << ",";
@@ -597,63 +1218,48 @@ int main(int argc, char* argv[]) {
         out << "\"duration_ms\":" << duration_ms;
         out << "},";
 
-        // Add daily results array (already sorted by file_index)
-        out << "\"daily_results\":[";
-        for (size_t i = 0; i < sorted_daily_results.size(); ++i) {
-            const auto& daily = sorted_daily_results[i];
-            if (i > 0)
-                out << ",";
-            double daily_net_pnl = daily.daily_pnl - daily.daily_fees;
-            out << "{";
-            out << "\"file\":\"" << json_escape(daily.file_path) << "\",";
-            out << "\"pnl\":" << daily.daily_pnl << ",";
-            out << "\"net_pnl\":" << daily_net_pnl << ",";
-            out << "\"fees\":" << daily.daily_fees << ",";
-            out << "\"orders\":" << daily.result.total_orders << ",";
-            out << "\"timesteps\":" << daily.result.processed_timesteps << ",";
-            out << "\"rows\":" << daily.result.total_rows;
-            out << "}";
+        // Daily results inline for JSON output; columnar output has them in its daily table.
+        if (!writer) {
+            out << "\"daily_results\":[";
+            for (size_t i = 0; i < sorted_daily_results.size(); ++i) {
+                const auto& daily = sorted_daily_results[i];
+                if (i > 0)
+                    out << ",";
+                double daily_net_pnl = daily.daily_pnl - daily.daily_fees;
+                out << "{";
+                out << "\"file\":\"" << json_escape(daily.file_path) << "\",";
+                out << "\"pnl\":" << daily.daily_pnl << ",";
+                out << "\"net_pnl\":" << daily_net_pnl << ",";
+                out << "\"fees\":" << daily.daily_fees << ",";
+                out << "\"orders\":" << daily.result.total_orders << ",";
+                out << "\"timesteps\":" << daily.result.processed_timesteps << ",";
+                out << "\"rows\":" << daily.result.total_rows;
+                out << "}";
+            }
+            out << "],";
+        } else {
+            out << "\"outputs\":{";
+            const auto paths = writer->paths();
+            for (size_t i = 0; i < paths.size(); ++i) {
+                if (i > 0)
+                    out << ",";
+                out << "\"" << paths[i].first << "\":\"" << json_escape(paths[i].second)
+                    << "\"";
+            }
+            out << "},";
         }
-        out << "],";
 
         // Chart-ready data: cumulative PnL (per-day reset) + Greeks so Python only draws.
         // All four series (PnL / Delta / Theta / Gamma) share the same LTTB downsample indices.
+        // A derived view: on by default for JSON output, opt-in (--chart-points) for columnar.
+        const size_t max_chart_points = chart_points.value_or(writer ? 0 : 1000);
         std::vector<double> chart_pnl;
         std::vector<int> chart_x_greek;
         std::vector<double> chart_delta, chart_theta, chart_gamma;
-        std::vector<int> day_boundaries;
-        const size_t n_metrics = metrics.size();
-        if (n_metrics > 0) {
-            // Build full PnL path with per-day reset + cross-day stacking (same as before)
-            std::vector<double> full_pnl;
-            full_pnl.reserve(n_metrics);
-            std::string prev_date;
-            double cumulative_offset = 0.0;
-            double day_start_pnl = 0.0;
-            for (size_t i = 0; i < n_metrics; ++i) {
-                std::string date_str;
-                if (metrics[i].timestamp.size() >= 10) {
-                    date_str = metrics[i].timestamp.substr(0, 10);
-                }
-                if (date_str != prev_date) {
-                    if (!prev_date.empty() && i > 0) {
-                        // metrics[i-1].pnl is cumulative from start; day_start_pnl was start of
-                        // previous day So previous day's total PnL = metrics[i-1].pnl -
-                        // day_start_pnl
-                        cumulative_offset += metrics[i - 1].pnl - day_start_pnl;
-                        day_boundaries.push_back(static_cast<int>(i));
-                    }
-                    prev_date = date_str;
-                    day_start_pnl = metrics[i].pnl;
-                }
-                // metrics[i].pnl is cumulative from start; subtract day_start_pnl to get relative
-                // to day start, then add cumulative_offset to stack days
-                full_pnl.push_back(metrics[i].pnl - day_start_pnl + cumulative_offset);
-            }
-
+        const size_t n_metrics = full_pnl.size();
+        if (n_metrics > 0 && max_chart_points > 0) {
             // LTTB downsample indices based on PnL path; share for Greeks
-            constexpr size_t kMaxChartPoints = 1000;
-            std::vector<size_t> idxs = lttb_downsample_indices(full_pnl, kMaxChartPoints);
+            std::vector<size_t> idxs = lttb_downsample_indices(full_pnl, max_chart_points);
 
             const size_t m = idxs.size();
             chart_pnl.reserve(m);
@@ -665,49 +1271,52 @@ int main(int argc, char* argv[]) {
                 const size_t idx = idxs[k];
                 chart_pnl.push_back(full_pnl[idx]);
                 chart_x_greek.push_back(static_cast<int>(idx));
-                chart_delta.push_back(metrics[idx].delta);
-                chart_theta.push_back(metrics[idx].theta);
-                chart_gamma.push_back(metrics[idx].gamma);
+                const auto [part, row] = metrics.locate(idx);
+                chart_delta.push_back(part->delta[row]);
+                chart_theta.push_back(part->theta[row]);
+                chart_gamma.push_back(part->gamma[row]);
             }
         }
-        out << "\"chart_data\":{";
-        out << "\"pnl\":[";
-        for (size_t i = 0; i < chart_pnl.size(); ++i) {
-            if (i > 0)
-                out << ",";
-            out << std::fixed << chart_pnl[i];
-        }
-        out << "],\"x_greek\":[";
-        for (size_t i = 0; i < chart_x_greek.size(); ++i) {
-            if (i > 0)
-                out << ",";
-            out << chart_x_greek[i];
-        }
-        out << "],\"delta\":[";
-        for (size_t i = 0; i < chart_delta.size(); ++i) {
-            if (i > 0)
-                out << ",";
-            out << chart_delta[i];
-        }
-        out << "],\"theta\":[";
-        for (size_t i = 0; i < chart_theta.size(); ++i) {
-            if (i > 0)
-                out << ",";
-            out << chart_theta[i];
-        }
-        out << "],\"gamma\":[";
-        for (size_t i = 0; i < chart_gamma.size(); ++i) {
-            if (i > 0)
-                out << ",";
-            out << chart_gamma[i];
-        }
-        out << "],\"day_boundaries\":[";
-        for (size_t i = 0; i < day_boundaries.size(); ++i) {
-            if (i > 0)
-                out << ",";
-            out << day_boundaries[i];
+        if (max_chart_points > 0) {
+            out << "\"chart_data\":{";
+            out << "\"pnl\":[";
+            for (size_t i = 0; i < chart_pnl.size(); ++i) {
+                if (i > 0)
+                    out << ",";
+                out << std::fixed << chart_pnl[i];
+            }
+            out << "],\"x_greek\":[";
+            for (size_t i = 0; i < chart_x_greek.size(); ++i) {
+                if (i > 0)
+                    out << ",";
+                out << chart_x_greek[i];
+            }
+            out << "],\"delta\":[";
+            for (size_t i = 0; i < chart_delta.size(); ++i) {
+                if (i > 0)
+                    out << ",";
+                out << chart_delta[i];
+            }
+            out << "],\"theta\":[";
+            for (size_t i = 0; i < chart_theta.size(); ++i) {
+                if (i > 0)
+                    out << ",";
+                out << chart_theta[i];
+            }
+            out << "],\"gamma\":[";
+            for (size_t i = 0; i < chart_gamma.size(); ++i) {
+                if (i > 0)
+                    out << ",";
+                out << chart_gamma[i];
+            }
+            out << "],\"day_boundaries\":[";
+            for (size_t i = 0; i < day_boundaries.size(); ++i) {
+                if (i > 0)
+                    out << ",";
+                out << day_boundaries[i];
+            }
+            out << "]},";
         }
-        out << "]},";
 
         out << "\"errors\":[";
         for (size_t i = 0; i < result.errors.size(); ++i) {
@@ -7,14 +7,82 @@
 
 #include "engine_grpc.hpp"
 #include "engine_main.hpp"
+#include "utilities/latency.hpp"
 
 #include <grpcpp/grpcpp.h>
 
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
 int main(int argc, char* argv[]) {
-    (void)argc;
-    (void)argv;
+    // --event-shards n: apply portfolio snapshots on n workers (default 1 = single worker)
+    // --stream-quotes ms: Tradier streaming, one conflated snapshot per portfolio every ms
+    // --spot-refresh: chains a snapshot does not carry get Greeks at the new spot (last IV)
+    // --surface-fit: illiquid strikes take IV/Greeks from a per-chain SVI fit of the liquid ones
+    // --net-hedges: net delta hedges of strategies sharing an underlying into one parent order
+    // --parallel-strategies: strategies due on the same timer tick run concurrently
+    // --risk-limit x: reject orders that take a strategy's worst spot/vol grid loss beyond x
+    // --holding-journal path: restore holdings from path, then journal changed positions to it
+    // --trace-latency: per-stage tick-to-order latency histograms (GetLatency RPC)
+    // --event-journal path: record dispatched events and order intents for backtest --replay
+    unsigned int event_shards = 1;
+    long stream_cadence_ms = 0;
+    bool spot_refresh = false;
+    bool surface_fit = false;
+    bool net_hedges = false;
+    bool parallel_strategies = false;
+    double risk_limit = 0.0;
+    std::string holding_journal;
+    bool trace_latency = false;
+    std::string event_journal;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--event-shards" && i + 1 < argc) {
+            event_shards = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--stream-quotes" && i + 1 < argc) {
+            stream_cadence_ms = std::strtol(argv[++i], nullptr, 10);
+        } else if (arg == "--spot-refresh") {
+            spot_refresh = true;
+        } else if (arg == "--surface-fit") {
+            surface_fit = true;
+        } else if (arg == "--net-hedges") {
+            net_hedges = true;
+        } else if (arg == "--parallel-strategies") {
+            parallel_strategies = true;
+        } else if (arg == "--risk-limit" && i + 1 < argc) {
+            risk_limit = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--holding-journal" && i + 1 < argc) {
+            holding_journal = argv[++i];
+        } else if (arg == "--trace-latency") {
+            trace_latency = true;
+        } else if (arg == "--event-journal" && i + 1 < argc) {
+            event_journal = argv[++i];
+        } else {
+            std::fprintf(stderr,
+                         "Usage: %s [--event-shards n] [--stream-quotes ms] [--spot-refresh] "
+                         "[--surface-fit] [--net-hedges] [--parallel-strategies] "
+                         "[--risk-limit x] [--holding-journal path] [--trace-latency] "
+                         "[--event-journal path]\n",
+                         argv[0]);
+            return 1;
+        }
+    }
 
-    engines::MainEngine main_engine;
+    utilities::LatencyTracer::set_enabled(trace_latency);
+    engines::MainEngine main_engine(event_shards);
+    main_engine.market_data_engine()->set_spot_refresh(spot_refresh);
+    main_engine.market_data_engine()->set_surface_fit(surface_fit);
+    main_engine.hedge_engine()->set_netting(net_hedges);
+    main_engine.option_strategy_engine()->set_parallel_timers(parallel_strategies);
+    main_engine.scenario_engine()->set_loss_limit(risk_limit);
+    main_engine.set_holding_journal(holding_journal);
+    main_engine.set_event_journal(event_journal);
+    if (stream_cadence_ms > 0) {
+        main_engine.market_data_engine()->set_market_data_streaming(
+            true, std::chrono::milliseconds(stream_cadence_ms));
+    }
 
     // Build gRPC service, holds MainEngine*
     engines::GrpcLiveEngineService service(&main_engine);
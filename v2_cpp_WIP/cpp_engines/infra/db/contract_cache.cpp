@@ -0,0 +1,206 @@
+#include "contract_cache.hpp"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+
+namespace engines {
+
+namespace {
+
+constexpr std::array<char, 8> kMagic{'O', 'T', 'C', 'N', 'T', 'R', '0', '1'};
+
+/** Little-endian-as-host field encoding; the cache never leaves the machine that wrote it. */
+class Writer {
+  public:
+    template <typename T> void value(T v) {
+        out_.append(reinterpret_cast<const char*>(&v), sizeof(v));
+    }
+    void str(std::string_view s) {
+        value(static_cast<uint32_t>(s.size()));
+        out_.append(s);
+    }
+    template <typename T> void opt(const std::optional<T>& v) {
+        value(static_cast<uint8_t>(v.has_value()));
+        if (v) {
+            put(*v);
+        }
+    }
+    void contract(const utilities::ContractData& c) {
+        str(c.gateway_name);
+        str(c.symbol);
+        value(static_cast<uint8_t>(c.exchange));
+        str(c.name);
+        value(static_cast<uint8_t>(c.product));
+        value(c.size);
+        value(c.pricetick);
+        value(c.min_volume);
+        opt(c.max_volume);
+        value(static_cast<uint8_t>((c.stop_supported ? 1 : 0) | (c.net_position ? 2 : 0) |
+                                   (c.history_data ? 4 : 0)));
+        opt(c.con_id);
+        opt(c.trading_class);
+        opt(c.option_strike);
+        opt(c.option_underlying);
+        opt(c.option_type);
+        opt(c.option_listed);
+        opt(c.option_expiry);
+        opt(c.option_portfolio);
+        opt(c.option_index);
+    }
+    [[nodiscard]] const std::string& bytes() const { return out_; }
+
+  private:
+    void put(double v) { value(v); }
+    void put(int v) { value(static_cast<int32_t>(v)); }
+    void put(const std::string& v) { str(v); }
+    void put(utilities::OptionType v) { value(static_cast<uint8_t>(v)); }
+    void put(utilities::DateTime v) {
+        value(static_cast<int64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(v.time_since_epoch()).count()));
+    }
+
+    std::string out_;
+};
+
+/** Bounds-checked reader; ok() turns false on the first short read. */
+class Reader {
+  public:
+    explicit Reader(std::string_view in) : in_(in) {}
+
+    template <typename T> T value() {
+        T v{};
+        if (in_.size() < sizeof(T)) {
+            ok_ = false;
+            return v;
+        }
+        std::memcpy(&v, in_.data(), sizeof(T));
+        in_.remove_prefix(sizeof(T));
+        return v;
+    }
+    std::string str() {
+        const auto n = value<uint32_t>();
+        if (!ok_ || in_.size() < n) {
+            ok_ = false;
+            return {};
+        }
+        std::string s(in_.substr(0, n));
+        in_.remove_prefix(n);
+        return s;
+    }
+    template <typename T> void opt(std::optional<T>& v) {
+        if (value<uint8_t>() != 0) {
+            T x{};
+            get(x);
+            v = std::move(x);
+        }
+    }
+    auto contract() -> utilities::ContractData {
+        utilities::ContractData c;
+        c.gateway_name = str();
+        c.symbol = str();
+        c.exchange = static_cast<utilities::Exchange>(value<uint8_t>());
+        c.name = str();
+        c.product = static_cast<utilities::Product>(value<uint8_t>());
+        c.size = value<double>();
+        c.pricetick = value<double>();
+        c.min_volume = value<double>();
+        opt(c.max_volume);
+        const auto flags = value<uint8_t>();
+        c.stop_supported = (flags & 1) != 0;
+        c.net_position = (flags & 2) != 0;
+        c.history_data = (flags & 4) != 0;
+        opt(c.con_id);
+        opt(c.trading_class);
+        opt(c.option_strike);
+        opt(c.option_underlying);
+        opt(c.option_type);
+        opt(c.option_listed);
+        opt(c.option_expiry);
+        opt(c.option_portfolio);
+        opt(c.option_index);
+        return c;
+    }
+    [[nodiscard]] bool ok() const { return ok_; }
+    [[nodiscard]] bool done() const { return ok_ && in_.empty(); }
+
+  private:
+    void get(double& v) { v = value<double>(); }
+    void get(int& v) { v = value<int32_t>(); }
+    void get(std::string& v) { v = str(); }
+    void get(utilities::OptionType& v) { v = static_cast<utilities::OptionType>(value<uint8_t>()); }
+    void get(utilities::DateTime& v) {
+        v = utilities::DateTime{std::chrono::duration_cast<utilities::DateTime::duration>(
+            std::chrono::nanoseconds(value<int64_t>()))};
+    }
+
+    std::string_view in_;
+    bool ok_ = true;
+};
+
+} // namespace
+
+auto read_contract_cache(const std::string& path, const std::string& checksum)
+    -> std::optional<ContractUniverse> {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return std::nullopt;
+    }
+    const std::string bytes{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    Reader r(bytes);
+    std::array<char, 8> magic{};
+    for (char& ch : magic) {
+        ch = r.value<char>();
+    }
+    if (!r.ok() || magic != kMagic || r.str() != checksum) {
+        return std::nullopt;
+    }
+    ContractUniverse u;
+    for (auto* list : {&u.options, &u.equities}) {
+        const auto n = r.value<uint64_t>();
+        // Each contract takes well over one byte; reject counts the file cannot hold.
+        if (!r.ok() || n > bytes.size()) {
+            return std::nullopt;
+        }
+        list->reserve(n);
+        for (uint64_t i = 0; i < n && r.ok(); ++i) {
+            list->push_back(r.contract());
+        }
+    }
+    if (!r.done()) {
+        return std::nullopt;
+    }
+    return u;
+}
+
+auto write_contract_cache(const std::string& path, const std::string& checksum,
+                          const ContractUniverse& universe) -> bool {
+    Writer w;
+    for (const char ch : kMagic) {
+        w.value(ch);
+    }
+    w.str(checksum);
+    for (const auto* list : {&universe.options, &universe.equities}) {
+        w.value(static_cast<uint64_t>(list->size()));
+        for (const utilities::ContractData& c : *list) {
+            w.contract(c);
+        }
+    }
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(w.bytes().data(), static_cast<std::streamsize>(w.bytes().size()));
+        if (!out) {
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    return !ec;
+}
+
+} // namespace engines
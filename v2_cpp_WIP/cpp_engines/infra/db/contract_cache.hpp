@@ -0,0 +1,29 @@
+#pragma once
+
+/**
+ * Contract cache: DatabaseEngine's on-disk copy of the contract tables, tagged with the DB
+ * checksum it was read under, so a restart with an unchanged universe skips the table scan.
+ */
+
+#include "../../utilities/object.hpp"
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace engines {
+
+/** contract_option and contract_equity rows, in table order. */
+struct ContractUniverse {
+    std::vector<utilities::ContractData> options;
+    std::vector<utilities::ContractData> equities;
+};
+
+/** Read path; nullopt if missing, corrupt or written under another checksum. */
+std::optional<ContractUniverse> read_contract_cache(const std::string& path,
+                                                    const std::string& checksum);
+
+/** Write via a temp file + rename; false on I/O failure. */
+bool write_contract_cache(const std::string& path, const std::string& checksum,
+                          const ContractUniverse& universe);
+
+} // namespace engines
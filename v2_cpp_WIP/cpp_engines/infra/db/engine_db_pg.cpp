@@ -4,13 +4,18 @@
  */
 
 #include "engine_db_pg.hpp"
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <cstdlib>
 #include <format>
+#include <fstream>
 #include <iomanip>
 #include <pqxx/pqxx>
+#include <span>
 #include <sstream>
 #include <stdexcept>
+#include <unordered_set>
 
 namespace engines {
 
@@ -184,11 +189,122 @@ auto str_to_datetime(const std::string& s) -> std::chrono::system_clock::time_po
     return {};
 }
 
+// Writer thread: flush cadence, rows per INSERT, retry pacing, and the in-memory retry cap
+// beyond which failed rows go to the spill file.
+constexpr auto kFlushInterval = std::chrono::milliseconds(20);
+constexpr size_t kRowsPerInsert = 500;
+constexpr auto kRetryDelay = std::chrono::seconds(1);
+constexpr size_t kMaxRetryRows = 10000;
+
+constexpr std::array<const char*, 16> kOrderColumns = {
+    "timestamp", "strategy_name", "orderid", "symbol", "exchange", "trading_class",
+    "type", "direction", "price", "volume", "traded", "status",
+    "datetime", "reference", "is_combo", "legs_info"};
+constexpr std::array<const char*, 10> kTradeColumns = {
+    "timestamp", "strategy_name", "tradeid", "symbol", "exchange",
+    "orderid", "direction", "price", "volume", "datetime"};
+
+auto default_spill_path() -> std::string {
+    const char* env = std::getenv("DATABASE_SPILL_FILE");
+    if ((env != nullptr) && env[0] != '\0') {
+        return env;
+    }
+    return "otrader_db_spill.sql";
+}
+
+// Column values as text; Postgres infers the column types of untyped parameters.
+auto order_fields(const std::string& ts, const std::string& strategy_name,
+                  const utilities::OrderData& order) -> std::vector<std::string> {
+    std::string legs_info;
+    if (order.is_combo && order.legs) {
+        for (size_t i = 0; i < order.legs->size(); ++i) {
+            if (i != 0U) {
+                legs_info += "|";
+            }
+            const auto& leg = (*order.legs)[i];
+            legs_info += std::format("con_id:{},ratio:{},dir:{},symbol:{}", leg.con_id, leg.ratio,
+                                     utilities::to_string(leg.direction),
+                                     leg.symbol.value_or("N/A"));
+        }
+    }
+    std::string dir = order.direction ? utilities::to_string(*order.direction) : "N/A";
+    std::string dt = order.datetime ? datetime_to_str(*order.datetime) : "N/A";
+    return {ts,
+            strategy_name,
+            order.orderid,
+            order.symbol,
+            utilities::to_string(order.exchange),
+            order.trading_class.value_or(""),
+            utilities::to_string(order.type),
+            std::move(dir),
+            std::format("{}", order.price),
+            std::format("{}", order.volume),
+            std::format("{}", order.traded),
+            utilities::to_string(order.status),
+            std::move(dt),
+            order.reference,
+            order.is_combo ? "1" : "0",
+            std::move(legs_info)};
+}
+
+auto trade_fields(const std::string& ts, const std::string& strategy_name,
+                  const utilities::TradeData& trade) -> std::vector<std::string> {
+    std::string dir = trade.direction ? utilities::to_string(*trade.direction) : "N/A";
+    std::string dt = trade.datetime ? datetime_to_str(*trade.datetime) : "";
+    return {ts,
+            strategy_name,
+            trade.tradeid,
+            trade.symbol,
+            utilities::to_string(trade.exchange),
+            trade.orderid,
+            std::move(dir),
+            std::format("{}", trade.price),
+            std::format("{}", trade.volume),
+            std::move(dt)};
+}
+
+// "INSERT INTO t (cols) VALUES " ... " ON CONFLICT (key) DO UPDATE SET col=EXCLUDED.col, ..."
+auto upsert_head(const char* table, std::span<const char* const> columns) -> std::string {
+    std::string sql = std::format("INSERT INTO {} (", table);
+    for (size_t i = 0; i < columns.size(); ++i) {
+        sql += (i != 0U) ? ", " : "";
+        sql += columns[i];
+    }
+    return sql + ") VALUES ";
+}
+
+auto upsert_tail(std::span<const char* const> columns, const char* key) -> std::string {
+    std::string sql = std::format(" ON CONFLICT ({}) DO UPDATE SET ", key);
+    bool first = true;
+    for (const char* c : columns) {
+        if (std::string_view(c) == key) {
+            continue;
+        }
+        sql += first ? "" : ", ";
+        sql += std::format("{0}=EXCLUDED.{0}", c);
+        first = false;
+    }
+    return sql;
+}
+
+// Standard-conforming string literal (quotes doubled).
+auto sql_literal(std::string_view s) -> std::string {
+    std::string out = "'";
+    for (const char c : s) {
+        out += c;
+        if (c == '\'') {
+            out += '\'';
+        }
+    }
+    return out + "'";
+}
+
 } // namespace
 
 DatabaseEngine::DatabaseEngine(utilities::MainEngine* main_engine, const std::string& conninfo)
     : BaseEngine(main_engine, "Database"),
-      conninfo_(conninfo.empty() ? default_conninfo() : conninfo) {
+      conninfo_(conninfo.empty() ? default_conninfo() : conninfo),
+      spill_path_(default_spill_path()) {
     try {
         conn_ = std::make_unique<pqxx::connection>(conninfo_);
         bool created = false;
@@ -208,6 +324,8 @@ DatabaseEngine::DatabaseEngine(utilities::MainEngine* main_engine, const std::st
             cleanup_expired_options();
         }
         write_log("Database engine initialized (PostgreSQL)", INFO);
+        persist_enabled_ = true;
+        writer_ = std::jthread([this](std::stop_token st) { writer_loop(st); });
     } catch (const std::exception& e) {
         write_log(std::format("Database init failed: {}", e.what()), ERROR);
         conn_.reset();
@@ -275,6 +393,128 @@ void DatabaseEngine::load_contracts(
     }
 }
 
+void DatabaseEngine::load_contracts_bulk(
+    const std::function<void(std::vector<utilities::ContractData>&&)>& apply_options,
+    const std::function<void(const utilities::ContractData&)>& apply_underlying) {
+    const auto t0 = std::chrono::steady_clock::now();
+    const char* cache_env = std::getenv("CONTRACT_CACHE_FILE");
+    const std::string cache_path = (cache_env != nullptr) ? cache_env : "";
+    const std::string checksum = cache_path.empty() ? "" : contracts_checksum();
+    std::optional<ContractUniverse> universe;
+    bool from_cache = false;
+    if (!checksum.empty()) {
+        universe = read_contract_cache(cache_path, checksum);
+        from_cache = universe.has_value();
+    }
+    if (!universe) {
+        universe = stream_contracts();
+        if (!universe) {
+            return;
+        }
+        if (!checksum.empty() && !write_contract_cache(cache_path, checksum, *universe)) {
+            write_log("Failed to write contract cache " + cache_path, WARNING);
+        }
+    }
+    const size_t total = universe->options.size() + universe->equities.size();
+    apply_options(std::move(universe->options));
+    for (const utilities::ContractData& c : universe->equities) {
+        apply_underlying(c);
+    }
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now() - t0)
+                        .count();
+    write_log(std::format("Loaded {} contracts ({}) in {} ms", total,
+                          from_cache ? "contract cache" : "database", ms),
+              INFO);
+}
+
+auto DatabaseEngine::contracts_checksum() -> std::string {
+    std::scoped_lock lock(db_mutex_);
+    if (!conn_) {
+        return {};
+    }
+    try {
+        pqxx::work w(*conn_);
+        const pqxx::result r = w.exec(
+            "SELECT (SELECT count(*) FROM contract_option) || ':' || "
+            "(SELECT coalesce(md5(string_agg(t::text, E'\\n' ORDER BY t.symbol)), '') "
+            "FROM contract_option t) || ':' || "
+            "(SELECT count(*) FROM contract_equity) || ':' || "
+            "(SELECT coalesce(md5(string_agg(t::text, E'\\n' ORDER BY t.symbol)), '') "
+            "FROM contract_equity t)");
+        w.commit();
+        return r.empty() ? std::string{} : r[0][0].as<std::string>();
+    } catch (const std::exception& e) {
+        write_log(std::string("Contract checksum failed: ") + e.what(), WARNING);
+        return {};
+    }
+}
+
+auto DatabaseEngine::stream_contracts() -> std::optional<ContractUniverse> {
+    std::scoped_lock lock(db_mutex_);
+    if (!conn_) {
+        return std::nullopt;
+    }
+    // Columns 0..13 are shared by both tables.
+    const auto common = [](const auto& row) -> utilities::ContractData {
+        utilities::ContractData c;
+        c.symbol = std::get<0>(row);
+        c.exchange = exchange_from_string(std::get<1>(row));
+        c.product = product_from_string(std::get<2>(row));
+        c.size = std::get<3>(row);
+        c.pricetick = std::get<4>(row);
+        c.min_volume = std::get<5>(row);
+        c.net_position = std::get<6>(row) != 0;
+        c.history_data = std::get<7>(row) != 0;
+        c.stop_supported = std::get<8>(row) != 0;
+        c.gateway_name = std::get<9>(row);
+        c.con_id = std::get<10>(row).value_or(0);
+        c.trading_class = std::get<11>(row);
+        c.name = std::get<12>(row).value_or("");
+        c.max_volume = std::get<13>(row);
+        return c;
+    };
+    ContractUniverse u;
+    try {
+        pqxx::work w(*conn_);
+        using OptStr = std::optional<std::string>;
+        for (const auto& row :
+             w.stream<std::string, std::string, std::string, double, double, double, int, int,
+                      int, std::string, std::optional<int>, OptStr, OptStr, std::optional<double>,
+                      OptStr, OptStr, std::optional<double>, OptStr, OptStr, OptStr>(
+                 "SELECT symbol, exchange, product, size, pricetick, min_volume, net_position, "
+                 "history_data, stop_supported, gateway_name, con_id, trading_class, name, "
+                 "max_volume, portfolio, type, strike, strike_index, expiry, underlying "
+                 "FROM contract_option")) {
+            utilities::ContractData c = common(row);
+            c.option_portfolio = std::get<14>(row);
+            if (std::get<15>(row)) {
+                c.option_type = option_type_from_string(*std::get<15>(row));
+            }
+            c.option_strike = std::get<16>(row);
+            c.option_index = std::get<17>(row);
+            if (std::get<18>(row)) {
+                c.option_expiry = str_to_datetime(*std::get<18>(row));
+            }
+            c.option_underlying = std::get<19>(row);
+            u.options.push_back(std::move(c));
+        }
+        for (const auto& row :
+             w.stream<std::string, std::string, std::string, double, double, double, int, int,
+                      int, std::string, std::optional<int>, OptStr, OptStr, std::optional<double>>(
+                 "SELECT symbol, exchange, product, size, pricetick, min_volume, net_position, "
+                 "history_data, stop_supported, gateway_name, con_id, trading_class, name, "
+                 "max_volume FROM contract_equity")) {
+            u.equities.push_back(common(row));
+        }
+        w.commit();
+    } catch (const std::exception& e) {
+        write_log(std::string("Failed to stream ContractData: ") + e.what(), ERROR);
+        return std::nullopt;
+    }
+    return u;
+}
+
 auto DatabaseEngine::load_option_contract_data(const std::string* symbol_key)
     -> std::unordered_map<std::string, utilities::ContractData> {
     std::scoped_lock lock(db_mutex_);
@@ -390,78 +630,219 @@ auto DatabaseEngine::load_equity_contract_data(const std::string* symbol_key)
     return out;
 }
 
-void DatabaseEngine::save_order_data(const std::string& strategy_name,
-                                     const utilities::OrderData& order) {
-    std::scoped_lock lock(db_mutex_);
-    if (!conn_) {
-        return;
+auto DatabaseEngine::save_order_data(const std::string& strategy_name,
+                                     const utilities::OrderData& order) -> uint64_t {
+    if (!persist_enabled_.load(std::memory_order_relaxed)) {
+        return 0;
+    }
+    return enqueue({.queued_at = std::chrono::system_clock::now(),
+                    .strategy_name = strategy_name,
+                    .data = order});
+}
+
+auto DatabaseEngine::save_trade_data(const std::string& strategy_name,
+                                     const utilities::TradeData& trade) -> uint64_t {
+    if (!persist_enabled_.load(std::memory_order_relaxed)) {
+        return 0;
+    }
+    return enqueue({.queued_at = std::chrono::system_clock::now(),
+                    .strategy_name = strategy_name,
+                    .data = trade});
+}
+
+auto DatabaseEngine::enqueue(PersistRow row) -> uint64_t {
+    row.seq = queued_.fetch_add(1, std::memory_order_relaxed);
+    const uint64_t ticket = row.seq + 1;
+    // Once rows overflow, later ones follow them there until the writer drains it.
+    if (!has_overflow_.load(std::memory_order_acquire) && rows_.try_push(std::move(row))) {
+        return ticket;
+    }
+    std::scoped_lock lock(overflow_mutex_);
+    overflow_.push_back(std::move(row));
+    has_overflow_.store(true, std::memory_order_release);
+    return ticket;
+}
+
+auto DatabaseEngine::persisted_rows() -> uint64_t {
+    std::scoped_lock lock(done_mutex_);
+    return done_;
+}
+
+auto DatabaseEngine::flush(std::chrono::milliseconds timeout) -> bool {
+    const uint64_t target = queued_.load(std::memory_order_acquire);
+    std::unique_lock lock(done_mutex_);
+    return done_cv_.wait_for(lock, timeout, [&]() -> bool { return done_ >= target; });
+}
+
+void DatabaseEngine::mark_done(size_t rows) {
+    {
+        std::scoped_lock lock(done_mutex_);
+        done_ += rows;
     }
-    try {
-        std::string legs_info;
-        if (order.is_combo && order.legs) {
-            for (size_t i = 0; i < order.legs->size(); ++i) {
-                if (i != 0U) {
-                    legs_info += "|";
-                }
-                const auto& leg = (*order.legs)[i];
-                legs_info +=
-                    std::format("con_id:{},ratio:{},dir:{},symbol:{}", leg.con_id, leg.ratio,
-                                utilities::to_string(leg.direction), leg.symbol.value_or("N/A"));
-            }
+    done_cv_.notify_all();
+}
+
+void DatabaseEngine::writer_loop(const std::stop_token& st) {
+    while (!st.stop_requested()) {
+        if (!write_pending()) {
+            std::this_thread::sleep_for(kFlushInterval);
         }
-        std::string ts = datetime_to_str(std::chrono::system_clock::now());
-        std::string dir = order.direction ? utilities::to_string(*order.direction) : "N/A";
-        std::string dt = order.datetime ? datetime_to_str(*order.datetime) : "N/A";
+    }
+    // Shutdown: one last attempt, then keep whatever still failed in the spill file.
+    retry_at_ = {};
+    write_pending();
+    if (!retry_.empty()) {
+        spill_rows(retry_);
+        mark_done(retry_queued_);
+        retry_.clear();
+        retry_queued_ = 0;
+    }
+}
 
-        pqxx::work w(*conn_);
-        w.exec(pqxx::zview(
-                   "INSERT INTO orders (timestamp, strategy_name, orderid, symbol, exchange, "
-                   "trading_class, type, direction, "
-                   "price, volume, traded, status, datetime, reference, is_combo, legs_info) "
-                   "VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12, $13, $14, $15, $16) "
-                   "ON CONFLICT (orderid) DO UPDATE SET timestamp=$1, strategy_name=$2, symbol=$4, "
-                   "exchange=$5, trading_class=$6, "
-                   "type=$7, direction=$8, price=$9, volume=$10, traded=$11, status=$12, "
-                   "datetime=$13, reference=$14, is_combo=$15, legs_info=$16"),
-               pqxx::params{ts, strategy_name, order.orderid, order.symbol,
-                            utilities::to_string(order.exchange), order.trading_class.value_or(""),
-                            utilities::to_string(order.type), dir, order.price, order.volume,
-                            order.traded, utilities::to_string(order.status), dt, order.reference,
-                            order.is_combo ? 1 : 0, legs_info});
-        w.commit();
-    } catch (const std::exception& e) {
-        write_log(std::string("Failed to save order: ") + e.what(), ERROR);
+auto DatabaseEngine::write_pending() -> bool {
+    if (!retry_.empty() && std::chrono::steady_clock::now() < retry_at_) {
+        return false;
+    }
+    std::vector<PersistRow> batch = std::move(retry_);
+    retry_.clear();
+    uint64_t queued = retry_queued_;
+    queued += rows_.pop_batch([&](PersistRow&& r) -> void { batch.push_back(std::move(r)); },
+                              rows_.capacity());
+    if (has_overflow_.load(std::memory_order_acquire)) {
+        std::scoped_lock lock(overflow_mutex_);
+        queued += overflow_.size();
+        std::ranges::move(overflow_, std::back_inserter(batch));
+        overflow_.clear();
+        has_overflow_.store(false, std::memory_order_release);
+    }
+    if (batch.empty()) {
+        return false;
+    }
+    // Overflowed rows interleave with ring rows; restore queue order, then keep only the latest
+    // row per orderid / tradeid (one upsert may not touch the same key twice).
+    std::ranges::stable_sort(batch, {}, &PersistRow::seq);
+    std::unordered_set<std::string_view> seen_orders;
+    std::unordered_set<std::string_view> seen_trades;
+    std::vector<uint8_t> keep(batch.size(), 0);
+    for (size_t i = batch.size(); i-- > 0;) {
+        const PersistRow& r = batch[i];
+        if (const auto* order = std::get_if<utilities::OrderData>(&r.data)) {
+            keep[i] = seen_orders.insert(order->orderid).second ? 1 : 0;
+        } else {
+            keep[i] = seen_trades.insert(std::get<utilities::TradeData>(r.data).tradeid).second
+                          ? 1
+                          : 0;
+        }
+    }
+    std::vector<PersistRow> rows;
+    rows.reserve(batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (keep[i] != 0) {
+            rows.push_back(std::move(batch[i]));
+        }
     }
+    if (write_rows(rows)) {
+        retry_queued_ = 0;
+        mark_done(queued);
+        return true;
+    }
+    retry_ = std::move(rows);
+    retry_queued_ = queued;
+    retry_at_ = std::chrono::steady_clock::now() + kRetryDelay;
+    if (retry_.size() > kMaxRetryRows) {
+        spill_rows(retry_);
+        mark_done(retry_queued_);
+        retry_.clear();
+        retry_queued_ = 0;
+    }
+    return false;
 }
 
-void DatabaseEngine::save_trade_data(const std::string& strategy_name,
-                                     const utilities::TradeData& trade) {
-    std::scoped_lock lock(db_mutex_);
-    if (!conn_) {
-        return;
+auto DatabaseEngine::write_rows(const std::vector<PersistRow>& rows) -> bool {
+    std::vector<std::vector<std::string>> orders;
+    std::vector<std::vector<std::string>> trades;
+    for (const PersistRow& r : rows) {
+        const std::string ts = datetime_to_str(r.queued_at);
+        if (const auto* order = std::get_if<utilities::OrderData>(&r.data)) {
+            orders.push_back(order_fields(ts, r.strategy_name, *order));
+        } else {
+            trades.push_back(
+                trade_fields(ts, r.strategy_name, std::get<utilities::TradeData>(r.data)));
+        }
     }
+    std::scoped_lock lock(db_mutex_);
     try {
-        std::string ts = datetime_to_str(std::chrono::system_clock::now());
-        std::string dir = trade.direction ? utilities::to_string(*trade.direction) : "N/A";
-        std::string dt = trade.datetime ? datetime_to_str(*trade.datetime) : "";
-
+        if (!conn_ || !conn_->is_open()) {
+            conn_ = std::make_unique<pqxx::connection>(conninfo_);
+        }
         pqxx::work w(*conn_);
-        w.exec(pqxx::zview(
-                   "INSERT INTO trades (timestamp, strategy_name, tradeid, symbol, exchange, "
-                   "orderid, direction, price, volume, datetime) "
-                   "VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10) "
-                   "ON CONFLICT (tradeid) DO UPDATE SET timestamp=$1, strategy_name=$2, symbol=$4, "
-                   "exchange=$5, orderid=$6, direction=$7, price=$8, volume=$9, datetime=$10"),
-               pqxx::params{ts, strategy_name, trade.tradeid, trade.symbol,
-                            utilities::to_string(trade.exchange), trade.orderid, dir, trade.price,
-                            trade.volume, dt});
+        const auto upsert = [&](const std::vector<std::vector<std::string>>& table_rows,
+                                const char* table, std::span<const char* const> columns,
+                                const char* key) -> void {
+            const std::string head = upsert_head(table, columns);
+            const std::string tail = upsert_tail(columns, key);
+            for (size_t begin = 0; begin < table_rows.size(); begin += kRowsPerInsert) {
+                const size_t end = std::min(table_rows.size(), begin + kRowsPerInsert);
+                std::string sql = head;
+                pqxx::params params;
+                size_t n = 0;
+                for (size_t i = begin; i < end; ++i) {
+                    sql += (i != begin) ? ",(" : "(";
+                    for (size_t c = 0; c < columns.size(); ++c) {
+                        sql += std::format("{}${}", c != 0U ? ", " : "", ++n);
+                        params.append(table_rows[i][c]);
+                    }
+                    sql += ")";
+                }
+                w.exec(pqxx::zview(sql + tail), params);
+            }
+        };
+        upsert(orders, "orders", kOrderColumns, "orderid");
+        upsert(trades, "trades", kTradeColumns, "tradeid");
         w.commit();
     } catch (const std::exception& e) {
-        write_log(std::string("Failed to save trade: ") + e.what(), ERROR);
+        write_log(std::format("Failed to save {} order/trade rows (retrying): {}", rows.size(),
+                              e.what()),
+                  ERROR);
+        return false;
+    }
+    return true;
+}
+
+void DatabaseEngine::spill_rows(const std::vector<PersistRow>& rows) {
+    std::ofstream out(spill_path_, std::ios::app);
+    const auto spill = [&](const std::vector<std::string>& fields, const char* table,
+                           std::span<const char* const> columns, const char* key) -> void {
+        out << upsert_head(table, columns) << '(';
+        for (size_t c = 0; c < fields.size(); ++c) {
+            out << (c != 0U ? ", " : "") << sql_literal(fields[c]);
+        }
+        out << ')' << upsert_tail(columns, key) << ";\n";
+    };
+    for (const PersistRow& r : rows) {
+        const std::string ts = datetime_to_str(r.queued_at);
+        if (const auto* order = std::get_if<utilities::OrderData>(&r.data)) {
+            spill(order_fields(ts, r.strategy_name, *order), "orders", kOrderColumns, "orderid");
+        } else {
+            spill(trade_fields(ts, r.strategy_name, std::get<utilities::TradeData>(r.data)),
+                  "trades", kTradeColumns, "tradeid");
+        }
+    }
+    out.flush();
+    if (out) {
+        write_log(std::format("Database unavailable: spilled {} order/trade rows to {} (replay "
+                              "with psql -f)",
+                              rows.size(), spill_path_),
+                  ERROR);
+    } else {
+        write_log(std::format("Failed to spill {} order/trade rows to {}; rows lost",
+                              rows.size(), spill_path_),
+                  ERROR);
     }
 }
 
 auto DatabaseEngine::get_all_history_orders() -> std::vector<std::vector<std::string>> {
+    flush();
     std::scoped_lock lock(db_mutex_);
     std::vector<std::vector<std::string>> out;
     if (!conn_) {
@@ -485,6 +866,7 @@ auto DatabaseEngine::get_all_history_orders() -> std::vector<std::vector<std::st
 }
 
 auto DatabaseEngine::get_all_history_trades() -> std::vector<std::vector<std::string>> {
+    flush();
     std::scoped_lock lock(db_mutex_);
     std::vector<std::vector<std::string>> out;
     if (!conn_) {
@@ -508,6 +890,7 @@ auto DatabaseEngine::get_all_history_trades() -> std::vector<std::vector<std::st
 }
 
 void DatabaseEngine::wipe_trading_data() {
+    flush();
     std::scoped_lock lock(db_mutex_);
     if (!conn_) {
         return;
@@ -524,6 +907,12 @@ void DatabaseEngine::wipe_trading_data() {
 }
 
 void DatabaseEngine::close() {
+    // Stop the writer first; its shutdown pass commits or spills what is still queued.
+    persist_enabled_ = false;
+    writer_.request_stop();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
     std::scoped_lock lock(db_mutex_);
     conn_.reset();
 }
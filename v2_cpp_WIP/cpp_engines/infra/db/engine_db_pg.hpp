@@ -3,18 +3,29 @@
 /**
  * DatabaseEngine (live): PostgreSQL contract/order/trade persistence (libpqxx).
  * load_contracts(apply_option, apply_underlying) two-phase load; caller finalize_all_chains after.
+ * save_order_data / save_trade_data only enqueue; a writer thread upserts them in batches.
  */
 
 #include "../../core/engine_log.hpp"
 #include "../../utilities/base_engine.hpp"
 #include "../../utilities/constant.hpp"
 #include "../../utilities/event.hpp"
+#include "../../utilities/mpsc_ring.hpp"
 #include "../../utilities/object.hpp"
+#include "contract_cache.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <stop_token>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <variant>
 #include <vector>
 
 namespace pqxx {
@@ -36,9 +47,26 @@ class DatabaseEngine : public utilities::BaseEngine {
     void
     load_contracts(const std::function<void(const utilities::ContractData&)>& apply_option,
                    const std::function<void(const utilities::ContractData&)>& apply_underlying);
+    /**
+     * Startup path: all options in one apply_options call (COPY-streamed), then each equity.
+     * With CONTRACT_CACHE_FILE set, reuses the cached universe while the table checksum matches.
+     */
+    void load_contracts_bulk(
+        const std::function<void(std::vector<utilities::ContractData>&&)>& apply_options,
+        const std::function<void(const utilities::ContractData&)>& apply_underlying);
 
-    void save_order_data(const std::string& strategy_name, const utilities::OrderData& order);
-    void save_trade_data(const std::string& strategy_name, const utilities::TradeData& trade);
+    /**
+     * Non-blocking: queue the order row for the writer thread (upsert by orderid). Returns its
+     * ticket: the row is written once persisted_rows() reaches it (0: persistence is off).
+     */
+    uint64_t save_order_data(const std::string& strategy_name, const utilities::OrderData& order);
+    /** Non-blocking: queue the trade row for the writer thread (upsert by tradeid); as above. */
+    uint64_t save_trade_data(const std::string& strategy_name, const utilities::TradeData& trade);
+    /** Rows committed or spilled so far; the writer completes rows in queue order. */
+    uint64_t persisted_rows();
+    /** Wait until rows queued before the call are committed (or spilled); false on timeout. */
+    bool flush(std::chrono::milliseconds timeout = std::chrono::seconds(5));
+    /** Flushes first, so rows saved earlier are visible. */
     std::vector<std::vector<std::string>> get_all_history_orders();
     std::vector<std::vector<std::string>> get_all_history_trades();
     void wipe_trading_data();
@@ -46,16 +74,57 @@ class DatabaseEngine : public utilities::BaseEngine {
     void close() override;
 
   private:
+    /** Queued order/trade; seq orders rows across the ring and its overflow. */
+    struct PersistRow {
+        uint64_t seq = 0;
+        std::chrono::system_clock::time_point queued_at{};
+        std::string strategy_name;
+        std::variant<utilities::OrderData, utilities::TradeData> data;
+    };
+
+    /** Returns the row's ticket (seq + 1). */
+    uint64_t enqueue(PersistRow row);
+    void writer_loop(const std::stop_token& st);
+    /** Drain queued rows (plus earlier failures) and upsert them; false if nothing was pending. */
+    bool write_pending();
+    /** Upsert one batch in a single transaction; false (logged) on failure. */
+    bool write_rows(const std::vector<PersistRow>& rows);
+    /** Append rows as replayable SQL upserts to spill_path_ (DB unavailable for too long). */
+    void spill_rows(const std::vector<PersistRow>& rows);
+    void mark_done(size_t rows);
     void create_tables();
     void cleanup_expired_options();
     std::unordered_map<std::string, utilities::ContractData>
     load_option_contract_data(const std::string* symbol_key);
     std::unordered_map<std::string, utilities::ContractData>
     load_equity_contract_data(const std::string* symbol_key);
+    /** Both contract tables via COPY TO STDOUT streams; nullopt (logged) on failure. */
+    std::optional<ContractUniverse> stream_contracts();
+    /** Row count + md5 of both contract tables, computed server side; empty on failure. */
+    std::string contracts_checksum();
 
     std::string conninfo_;
     std::unique_ptr<pqxx::connection> conn_;
     std::mutex db_mutex_;
+
+    /** Set once the connection is up; saves are dropped without it, as before. */
+    std::atomic<bool> persist_enabled_{false};
+    utilities::MpscRing<PersistRow> rows_{4096};
+    /** Ring full: rows wait here instead of blocking the event thread. */
+    std::mutex overflow_mutex_;
+    std::vector<PersistRow> overflow_;
+    std::atomic<bool> has_overflow_{false};
+    std::atomic<uint64_t> queued_{0};
+    /** Writer only: rows whose batch failed, retried after retry_at_. */
+    std::vector<PersistRow> retry_;
+    /** Queued rows folded into retry_ (before per-key dedupe), for flush accounting. */
+    uint64_t retry_queued_ = 0;
+    std::chrono::steady_clock::time_point retry_at_{};
+    std::string spill_path_;
+    std::mutex done_mutex_;
+    std::condition_variable done_cv_;
+    uint64_t done_ = 0;
+    std::jthread writer_;
 };
 
 } // namespace engines
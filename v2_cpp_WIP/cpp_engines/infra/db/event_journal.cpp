@@ -0,0 +1,686 @@
+#include "event_journal.hpp"
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+#include <variant>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace engines {
+
+namespace {
+
+constexpr std::array<char, 8> kMagic{'O', 'T', 'R', 'E', 'V', 'J', 'N', 'L'};
+constexpr uint32_t kVersion = 1;
+/** stdio buffer: a busy session writes many small records between Timer flushes. */
+constexpr size_t kWriteBuffer = size_t{1} << 20;
+constexpr std::array<char, 8> kZeros{};
+
+auto padded(size_t n) -> size_t { return (n + 7) & ~size_t{7}; }
+
+auto ns_of(utilities::DateTime t) -> int64_t {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+auto from_ns(int64_t ns) -> utilities::DateTime {
+    return utilities::DateTime{std::chrono::duration_cast<utilities::DateTime::duration>(
+        std::chrono::nanoseconds(ns))};
+}
+
+auto valid_kind(JournalRecord kind) -> bool {
+    const auto k = static_cast<uint8_t>(kind);
+    return k >= static_cast<uint8_t>(JournalRecord::Portfolio) &&
+           k <= static_cast<uint8_t>(JournalRecord::CancelOrder);
+}
+
+/** Appends the payload encoding (see event_journal.hpp) to a reused buffer. */
+class Encoder {
+  public:
+    explicit Encoder(std::string& out) : out_(out) {}
+
+    template <typename T>
+        requires std::is_arithmetic_v<T>
+    void put(T v) {
+        out_.append(reinterpret_cast<const char*>(&v), sizeof(v));
+    }
+    template <typename T>
+        requires std::is_enum_v<T>
+    void put(T v) {
+        put(static_cast<uint8_t>(v));
+    }
+    void put(const std::string& s) {
+        put(static_cast<uint32_t>(s.size()));
+        out_.append(s);
+    }
+    void put(utilities::DateTime t) { put(ns_of(t)); }
+    template <typename T> void put(const std::optional<T>& v) {
+        put(static_cast<uint8_t>(v.has_value()));
+        if (v) {
+            put(*v);
+        }
+    }
+    template <typename T> void put(const std::vector<T>& v) {
+        put(static_cast<uint32_t>(v.size()));
+        if constexpr (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>) {
+            out_.append(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(T));
+        } else {
+            for (const T& x : v) {
+                put(x);
+            }
+        }
+    }
+    void put(const utilities::Leg& leg) {
+        put(leg.gateway_name);
+        put(static_cast<int32_t>(leg.con_id));
+        put(leg.exchange);
+        put(static_cast<int32_t>(leg.ratio));
+        put(leg.direction);
+        put(leg.price);
+        put(leg.symbol);
+        put(leg.trading_class);
+    }
+
+  private:
+    std::string& out_;
+};
+
+/** Bounds-checked reader over one payload; ok() turns false on the first overrun. */
+class Decoder {
+  public:
+    Decoder(const std::byte* data, size_t size) : cur_(data), end_(data + size) {}
+
+    [[nodiscard]] bool ok() const { return ok_; }
+    [[nodiscard]] size_t remaining() const { return static_cast<size_t>(end_ - cur_); }
+
+    template <typename T>
+        requires(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>)
+    void get(T& v) {
+        if (!take(sizeof(T))) {
+            v = T{};
+            return;
+        }
+        std::memcpy(&v, cur_ - sizeof(T), sizeof(T));
+    }
+    void get(bool& v) {
+        uint8_t b = 0;
+        get(b);
+        v = b != 0;
+    }
+    template <typename T>
+        requires std::is_enum_v<T>
+    void get(T& v) {
+        uint8_t b = 0;
+        get(b);
+        v = static_cast<T>(b);
+    }
+    void get(std::string& s) {
+        uint32_t n = 0;
+        get(n);
+        if (!take(n)) {
+            s.clear();
+            return;
+        }
+        s.assign(reinterpret_cast<const char*>(cur_ - n), n);
+    }
+    void get(utilities::DateTime& t) {
+        int64_t ns = 0;
+        get(ns);
+        t = from_ns(ns);
+    }
+    template <typename T> void get(std::optional<T>& v) {
+        bool has = false;
+        get(has);
+        if (!has || !ok_) {
+            v.reset();
+            return;
+        }
+        get(v.emplace());
+    }
+    template <typename T> void get(std::vector<T>& v) {
+        uint32_t n = 0;
+        get(n);
+        if constexpr (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>) {
+            if (!take(size_t{n} * sizeof(T))) {
+                v.clear();
+                return;
+            }
+            v.resize(n);
+            std::memcpy(v.data(), cur_ - size_t{n} * sizeof(T), size_t{n} * sizeof(T));
+        } else {
+            // Every element takes at least one byte: a count past the payload is corrupt.
+            if (n > remaining()) {
+                ok_ = false;
+                v.clear();
+                return;
+            }
+            v.resize(n);
+            for (T& x : v) {
+                get(x);
+            }
+        }
+    }
+    void get(utilities::Leg& leg) {
+        int32_t con_id = 0;
+        int32_t ratio = 0;
+        get(leg.gateway_name);
+        get(con_id);
+        get(leg.exchange);
+        get(ratio);
+        get(leg.direction);
+        get(leg.price);
+        get(leg.symbol);
+        get(leg.trading_class);
+        leg.con_id = con_id;
+        leg.ratio = ratio;
+    }
+
+  private:
+    bool take(size_t n) {
+        if (!ok_ || n > static_cast<size_t>(end_ - cur_)) {
+            ok_ = false;
+            return false;
+        }
+        cur_ += n;
+        return true;
+    }
+
+    const std::byte* cur_;
+    const std::byte* end_;
+    bool ok_ = true;
+};
+
+void encode(Encoder& e, const utilities::PortfolioSnapshot& s) {
+    e.put(s.portfolio_name);
+    e.put(s.datetime);
+    e.put(s.underlying_bid);
+    e.put(s.underlying_ask);
+    e.put(s.underlying_last);
+    e.put(s.underlying_bid_sz);
+    e.put(s.underlying_ask_sz);
+    e.put(s.sparse);
+    e.put(s.slots);
+    e.put(s.bid);
+    e.put(s.ask);
+    e.put(s.last);
+    e.put(s.bid_sz);
+    e.put(s.ask_sz);
+    e.put(s.delta);
+    e.put(s.gamma);
+    e.put(s.theta);
+    e.put(s.vega);
+    e.put(s.iv);
+    e.put(s.has_greeks);
+    e.put(s.chains);
+}
+
+void decode(Decoder& d, utilities::PortfolioSnapshot& s) {
+    d.get(s.portfolio_name);
+    d.get(s.datetime);
+    d.get(s.underlying_bid);
+    d.get(s.underlying_ask);
+    d.get(s.underlying_last);
+    d.get(s.underlying_bid_sz);
+    d.get(s.underlying_ask_sz);
+    d.get(s.sparse);
+    d.get(s.slots);
+    d.get(s.bid);
+    d.get(s.ask);
+    d.get(s.last);
+    d.get(s.bid_sz);
+    d.get(s.ask_sz);
+    d.get(s.delta);
+    d.get(s.gamma);
+    d.get(s.theta);
+    d.get(s.vega);
+    d.get(s.iv);
+    d.get(s.has_greeks);
+    d.get(s.chains);
+    s.trace_tsc = 0;
+}
+
+void encode(Encoder& e, const utilities::OrderData& o) {
+    e.put(o.gateway_name);
+    e.put(o.symbol);
+    e.put(o.exchange);
+    e.put(o.orderid);
+    e.put(o.trading_class);
+    e.put(o.type);
+    e.put(o.direction);
+    e.put(o.price);
+    e.put(o.volume);
+    e.put(o.traded);
+    e.put(o.status);
+    e.put(o.datetime);
+    e.put(o.reference);
+    e.put(o.is_combo);
+    e.put(o.legs);
+    e.put(o.combo_type);
+}
+
+void decode(Decoder& d, utilities::OrderData& o) {
+    d.get(o.gateway_name);
+    d.get(o.symbol);
+    d.get(o.exchange);
+    d.get(o.orderid);
+    d.get(o.trading_class);
+    d.get(o.type);
+    d.get(o.direction);
+    d.get(o.price);
+    d.get(o.volume);
+    d.get(o.traded);
+    d.get(o.status);
+    d.get(o.datetime);
+    d.get(o.reference);
+    d.get(o.is_combo);
+    d.get(o.legs);
+    d.get(o.combo_type);
+}
+
+void encode(Encoder& e, const utilities::TradeData& t) {
+    e.put(t.gateway_name);
+    e.put(t.symbol);
+    e.put(t.exchange);
+    e.put(t.orderid);
+    e.put(t.tradeid);
+    e.put(t.direction);
+    e.put(t.price);
+    e.put(t.volume);
+    e.put(t.datetime);
+}
+
+void decode(Decoder& d, utilities::TradeData& t) {
+    d.get(t.gateway_name);
+    d.get(t.symbol);
+    d.get(t.exchange);
+    d.get(t.orderid);
+    d.get(t.tradeid);
+    d.get(t.direction);
+    d.get(t.price);
+    d.get(t.volume);
+    d.get(t.datetime);
+}
+
+void encode(Encoder& e, const utilities::OrderRequest& r) {
+    e.put(r.symbol);
+    e.put(r.exchange);
+    e.put(r.direction);
+    e.put(r.type);
+    e.put(r.volume);
+    e.put(r.price);
+    e.put(r.reference);
+    e.put(r.trading_class);
+    e.put(r.is_combo);
+    e.put(r.legs);
+    e.put(r.combo_type);
+}
+
+void decode(Decoder& d, utilities::OrderRequest& r) {
+    d.get(r.symbol);
+    d.get(r.exchange);
+    d.get(r.direction);
+    d.get(r.type);
+    d.get(r.volume);
+    d.get(r.price);
+    d.get(r.reference);
+    d.get(r.trading_class);
+    d.get(r.is_combo);
+    d.get(r.legs);
+    d.get(r.combo_type);
+    r.trace_tsc = 0;
+}
+
+void encode(Encoder& e, const utilities::CancelRequest& c) {
+    e.put(c.orderid);
+    e.put(c.symbol);
+    e.put(c.exchange);
+    e.put(c.is_combo);
+    e.put(c.legs);
+}
+
+void decode(Decoder& d, utilities::CancelRequest& c) {
+    d.get(c.orderid);
+    d.get(c.symbol);
+    d.get(c.exchange);
+    d.get(c.is_combo);
+    d.get(c.legs);
+}
+
+/** Portfolio contracts carry what OptionData/UnderlyingData keep (all that pricing uses). */
+void decode(Decoder& d, JournalPortfolio& p) {
+    d.get(p.name);
+    d.get(p.risk_free_rate);
+    d.get(p.iv_price_mode);
+    d.get(p.greeks_enabled);
+    d.get(p.incremental);
+    d.get(p.price_epsilon);
+    d.get(p.tau_epsilon);
+    d.get(p.spot_refresh);
+    d.get(p.surface_fit);
+    d.get(p.surface_band);
+    d.get(p.surface_max_spread);
+
+    bool has_underlying = false;
+    d.get(has_underlying);
+    p.underlying.reset();
+    if (has_underlying) {
+        utilities::ContractData& u = p.underlying.emplace();
+        d.get(u.symbol);
+        d.get(u.exchange);
+        d.get(u.size);
+        u.product = utilities::Product::EQUITY;
+    }
+
+    uint32_t n = 0;
+    d.get(n);
+    p.options.clear();
+    if (!d.ok() || n > d.remaining()) {
+        return;
+    }
+    p.options.reserve(n);
+    for (uint32_t i = 0; i < n && d.ok(); ++i) {
+        utilities::ContractData& c = p.options.emplace_back();
+        int8_t option_type = 1;
+        d.get(c.symbol);
+        d.get(c.exchange);
+        d.get(c.size);
+        d.get(c.option_strike);
+        d.get(option_type);
+        d.get(c.option_expiry);
+        d.get(c.option_index);
+        c.product = utilities::Product::OPTION;
+        c.option_type = option_type > 0 ? utilities::OptionType::CALL : utilities::OptionType::PUT;
+        c.option_portfolio = p.name;
+        if (p.underlying) {
+            c.option_underlying = p.underlying->symbol;
+        }
+    }
+}
+
+} // namespace
+
+// -------- EventJournalWriter --------
+
+EventJournalWriter::EventJournalWriter(const std::string& path,
+                                       std::chrono::milliseconds timer_tick) {
+    // "x": a journal is one session; never append to or truncate an earlier one.
+    file_ = std::fopen(path.c_str(), "wbx");
+    if (file_ == nullptr) {
+        return;
+    }
+    std::setvbuf(file_, nullptr, _IOFBF, kWriteBuffer);
+    JournalFileHeader h;
+    h.magic = kMagic;
+    h.version = kVersion;
+    h.timer_tick_ms = static_cast<uint32_t>(timer_tick.count());
+    h.created_ns = ns_of(std::chrono::system_clock::now());
+    failed_ = std::fwrite(&h, sizeof(h), 1, file_) != 1;
+}
+
+EventJournalWriter::~EventJournalWriter() {
+    if (file_ != nullptr) {
+        std::fclose(file_);
+    }
+}
+
+auto EventJournalWriter::failed() const -> bool {
+    std::scoped_lock lock(mutex_);
+    return failed_;
+}
+
+auto EventJournalWriter::records() const -> uint64_t {
+    std::scoped_lock lock(mutex_);
+    return records_;
+}
+
+void EventJournalWriter::record_event(const utilities::Event& event, int64_t arrival_ns,
+                                      const utilities::PortfolioData* portfolio) {
+    std::scoped_lock lock(mutex_);
+    if (file_ == nullptr || failed_) {
+        return;
+    }
+    payload_.clear();
+    Encoder e(payload_);
+    switch (event.type) {
+    case utilities::EventType::Snapshot: {
+        const utilities::PortfolioSnapshot* snapshot = event.snapshot();
+        if (snapshot == nullptr) {
+            return;
+        }
+        if (portfolio != nullptr) {
+            const size_t n_options = portfolio->option_apply_order().size();
+            const auto it = portfolios_.find(portfolio->name);
+            if (it == portfolios_.end() || it->second != n_options) {
+                encode_portfolio(*portfolio);
+                write_record(JournalRecord::Portfolio, arrival_ns);
+                portfolios_[portfolio->name] = n_options;
+                payload_.clear();
+            }
+        }
+        encode(e, *snapshot);
+        write_record(JournalRecord::Snapshot, arrival_ns);
+        break;
+    }
+    case utilities::EventType::Order:
+        if (const auto* order = std::get_if<utilities::OrderData>(&event.data)) {
+            encode(e, *order);
+            write_record(JournalRecord::Order, arrival_ns);
+        }
+        break;
+    case utilities::EventType::Trade:
+        if (const auto* trade = std::get_if<utilities::TradeData>(&event.data)) {
+            encode(e, *trade);
+            write_record(JournalRecord::Trade, arrival_ns);
+        }
+        break;
+    case utilities::EventType::Timer:
+        write_record(JournalRecord::Timer, arrival_ns);
+        // Once per tick: a crash loses at most the last tick's records.
+        if (!failed_ && std::fflush(file_) != 0) {
+            failed_ = true;
+        }
+        break;
+    }
+}
+
+void EventJournalWriter::record_send_order(const std::string& strategy_name,
+                                           const utilities::OrderRequest& req,
+                                           const std::string& orderid) {
+    const int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::steady_clock::now().time_since_epoch())
+                               .count();
+    std::scoped_lock lock(mutex_);
+    if (file_ == nullptr || failed_) {
+        return;
+    }
+    payload_.clear();
+    Encoder e(payload_);
+    e.put(strategy_name);
+    encode(e, req);
+    e.put(orderid);
+    write_record(JournalRecord::SendOrder, now_ns);
+}
+
+void EventJournalWriter::record_cancel(const utilities::CancelRequest& req) {
+    const int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::steady_clock::now().time_since_epoch())
+                               .count();
+    std::scoped_lock lock(mutex_);
+    if (file_ == nullptr || failed_) {
+        return;
+    }
+    payload_.clear();
+    Encoder e(payload_);
+    encode(e, req);
+    write_record(JournalRecord::CancelOrder, now_ns);
+}
+
+void EventJournalWriter::flush() {
+    std::scoped_lock lock(mutex_);
+    if (file_ != nullptr && !failed_ && std::fflush(file_) != 0) {
+        failed_ = true;
+    }
+}
+
+void EventJournalWriter::write_record(JournalRecord kind, int64_t arrival_ns) {
+    JournalRecordHeader h;
+    h.size = static_cast<uint32_t>(payload_.size());
+    h.kind = kind;
+    h.wall_ns = ns_of(std::chrono::system_clock::now());
+    h.arrival_ns = arrival_ns;
+    const size_t pad = padded(payload_.size()) - payload_.size();
+    const bool ok = std::fwrite(&h, sizeof(h), 1, file_) == 1 &&
+                    std::fwrite(payload_.data(), 1, payload_.size(), file_) == payload_.size() &&
+                    std::fwrite(kZeros.data(), 1, pad, file_) == pad;
+    if (!ok) {
+        // A partial record ends the readable journal; stop rather than write past it.
+        failed_ = true;
+        return;
+    }
+    ++records_;
+}
+
+void EventJournalWriter::encode_portfolio(const utilities::PortfolioData& portfolio) {
+    Encoder e(payload_);
+    e.put(portfolio.name);
+    e.put(portfolio.risk_free_rate_);
+    e.put(portfolio.iv_price_mode_);
+    e.put(portfolio.greeks_enabled_);
+    e.put(portfolio.incremental_);
+    e.put(portfolio.price_epsilon_);
+    e.put(portfolio.tau_epsilon_);
+    e.put(portfolio.spot_refresh_);
+    e.put(portfolio.surface_fit_);
+    e.put(portfolio.surface_band_);
+    e.put(portfolio.surface_max_spread_);
+
+    e.put(static_cast<uint8_t>(portfolio.underlying != nullptr));
+    if (portfolio.underlying) {
+        e.put(portfolio.underlying->symbol);
+        e.put(portfolio.underlying->exchange);
+        e.put(portfolio.underlying->size);
+    }
+
+    const auto& order = portfolio.option_apply_order();
+    e.put(static_cast<uint32_t>(order.size()));
+    for (const utilities::OptionData* option : order) {
+        e.put(option->symbol);
+        e.put(option->exchange);
+        e.put(option->size);
+        e.put(option->strike_price);
+        e.put(static_cast<int8_t>(option->option_type));
+        e.put(option->option_expiry);
+        e.put(option->chain_index);
+    }
+}
+
+// -------- EventJournalReader --------
+
+auto EventJournalReader::open(const std::string& path) -> std::unique_ptr<EventJournalReader> {
+    std::unique_ptr<EventJournalReader> reader(new EventJournalReader());
+#ifdef _WIN32
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        return nullptr;
+    }
+    reader->buffer_.resize(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char*>(reader->buffer_.data()),
+                 static_cast<std::streamsize>(reader->buffer_.size()))) {
+        return nullptr;
+    }
+    reader->data_ = reader->buffer_.data();
+    reader->size_ = reader->buffer_.size();
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(JournalFileHeader))) {
+        ::close(fd);
+        return nullptr;
+    }
+    void* p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        return nullptr;
+    }
+    ::madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+    reader->data_ = static_cast<const std::byte*>(p);
+    reader->size_ = static_cast<size_t>(st.st_size);
+#endif
+    if (reader->size_ < sizeof(JournalFileHeader)) {
+        return nullptr;
+    }
+    std::memcpy(&reader->header_, reader->data_, sizeof(JournalFileHeader));
+    if (reader->header_.magic != kMagic || reader->header_.version != kVersion) {
+        return nullptr;
+    }
+    return reader;
+}
+
+EventJournalReader::~EventJournalReader() {
+#ifndef _WIN32
+    if (data_ != nullptr && buffer_.empty()) {
+        ::munmap(const_cast<std::byte*>(data_), size_);
+    }
+#endif
+}
+
+auto EventJournalReader::peek(size_t offset) const -> std::optional<JournalRecordHeader> {
+    if (offset < begin() || offset > size_ || size_ - offset < sizeof(JournalRecordHeader)) {
+        return std::nullopt;
+    }
+    JournalRecordHeader h;
+    std::memcpy(&h, data_ + offset, sizeof(h));
+    if (!valid_kind(h.kind) ||
+        padded(h.size) > size_ - offset - sizeof(JournalRecordHeader)) {
+        return std::nullopt;
+    }
+    return h;
+}
+
+auto EventJournalReader::next(size_t offset, const JournalRecordHeader& header) -> size_t {
+    return offset + sizeof(JournalRecordHeader) + padded(header.size);
+}
+
+auto EventJournalReader::read(size_t offset, JournalEntry& entry) const -> bool {
+    const auto header = peek(offset);
+    if (!header) {
+        return false;
+    }
+    entry.header = *header;
+    Decoder d(data_ + offset + sizeof(JournalRecordHeader), header->size);
+    switch (header->kind) {
+    case JournalRecord::Portfolio:
+        decode(d, entry.portfolio);
+        break;
+    case JournalRecord::Snapshot:
+        decode(d, entry.snapshot);
+        break;
+    case JournalRecord::Order:
+        decode(d, entry.order);
+        break;
+    case JournalRecord::Trade:
+        decode(d, entry.trade);
+        break;
+    case JournalRecord::Timer:
+        break;
+    case JournalRecord::SendOrder:
+        d.get(entry.strategy_name);
+        decode(d, entry.request);
+        d.get(entry.orderid);
+        break;
+    case JournalRecord::CancelOrder:
+        decode(d, entry.cancel);
+        break;
+    }
+    return d.ok();
+}
+
+} // namespace engines
@@ -0,0 +1,177 @@
+#pragma once
+
+/**
+ * Event journal: append-only binary log of a live session, as the live EventEngine dispatched it
+ * (Snapshot, Order, Trade, Timer), interleaved with the order/cancel intents each dispatch
+ * produced. The replay runner (backtest::JournalReplay) pushes it back through the backtest
+ * engines and compares the decisions against the recorded intents.
+ *
+ * Layout: JournalFileHeader, then records. Each record is a JournalRecordHeader followed by size
+ * payload bytes, padded to 8. A Portfolio record (the layout snapshots index into) precedes the
+ * first Snapshot of each portfolio, and the first one after its option set changed. A journal
+ * cut off mid-record (crash) reads up to its last whole record. Payloads are little-endian
+ * scalars, strings as u32 length + bytes, arrays as u32 count + elements, optionals as a u8 flag
+ * + value.
+ */
+
+#include "../../utilities/object.hpp"
+#include "../../utilities/portfolio.hpp"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace engines {
+
+enum class JournalRecord : uint8_t {
+    Portfolio = 1,
+    Snapshot = 2,
+    Order = 3,
+    Trade = 4,
+    Timer = 5,
+    /** Intent out: strategy, request and the orderid send_order returned. */
+    SendOrder = 6,
+    /** Intent out: the cancel request. */
+    CancelOrder = 7,
+};
+
+struct JournalFileHeader {
+    std::array<char, 8> magic{};
+    uint32_t version = 0;
+    /** Live EventEngine timer tick (strategy/hedge periods are multiples of it). */
+    uint32_t timer_tick_ms = 0;
+    /** System clock when recording started (ns since epoch). */
+    int64_t created_ns = 0;
+};
+
+struct JournalRecordHeader {
+    uint32_t size = 0;
+    JournalRecord kind = JournalRecord::Timer;
+    std::array<uint8_t, 3> reserved{};
+    /** System clock at dispatch (ns since epoch); the replay's timer clock. */
+    int64_t wall_ns = 0;
+    /** Steady clock when the event entered the engine (put); intents: when produced. */
+    int64_t arrival_ns = 0;
+};
+
+/** Contracts and pricing settings a portfolio is rebuilt from (options in apply order). */
+struct JournalPortfolio {
+    std::string name;
+    double risk_free_rate = 0.05;
+    utilities::IvPriceMode iv_price_mode = utilities::IvPriceMode::MID;
+    bool greeks_enabled = true;
+    bool incremental = false;
+    double price_epsilon = 0.0;
+    double tau_epsilon = 0.0;
+    bool spot_refresh = false;
+    bool surface_fit = false;
+    double surface_band = 0.15;
+    double surface_max_spread = 0.5;
+    std::optional<utilities::ContractData> underlying;
+    std::vector<utilities::ContractData> options;
+};
+
+/** One decoded record; only the members of its kind are meaningful. */
+struct JournalEntry {
+    JournalRecordHeader header;
+    JournalPortfolio portfolio;
+    utilities::PortfolioSnapshot snapshot;
+    utilities::OrderData order;
+    utilities::TradeData trade;
+    std::string strategy_name;
+    utilities::OrderRequest request;
+    std::string orderid;
+    utilities::CancelRequest cancel;
+};
+
+/**
+ * Live recorder. Thread-safe (main worker, snapshot shards); each record is encoded and written
+ * under one mutex into a buffered file, flushed to the OS at every Timer and on close.
+ */
+class EventJournalWriter {
+  public:
+    /** Create path (never overwrites an existing file); is_open() false on failure. */
+    EventJournalWriter(const std::string& path, std::chrono::milliseconds timer_tick);
+    ~EventJournalWriter();
+    EventJournalWriter(const EventJournalWriter&) = delete;
+    EventJournalWriter& operator=(const EventJournalWriter&) = delete;
+
+    [[nodiscard]] bool is_open() const { return file_ != nullptr; }
+    /** A write failed; recording stopped. */
+    [[nodiscard]] bool failed() const;
+    [[nodiscard]] uint64_t records() const;
+
+    /**
+     * event as dispatched, arrival_ns its steady enqueue time. A Snapshot writes the layout of
+     * portfolio first if this journal has not seen it at its current size (portfolio must be
+     * its target).
+     */
+    void record_event(const utilities::Event& event, int64_t arrival_ns,
+                      const utilities::PortfolioData* portfolio);
+    void record_send_order(const std::string& strategy_name, const utilities::OrderRequest& req,
+                           const std::string& orderid);
+    void record_cancel(const utilities::CancelRequest& req);
+    void flush();
+
+  private:
+    /** Caller holds mutex_; payload_ holds the encoded body. */
+    void write_record(JournalRecord kind, int64_t arrival_ns);
+    void encode_portfolio(const utilities::PortfolioData& portfolio);
+
+    mutable std::mutex mutex_;
+    std::FILE* file_ = nullptr;
+    std::string payload_;
+    /** Option count of each portfolio's last Portfolio record. */
+    std::unordered_map<std::string, size_t> portfolios_;
+    uint64_t records_ = 0;
+    bool failed_ = false;
+};
+
+/** Memory-mapped journal; records are decoded on demand by offset. */
+class EventJournalReader {
+  public:
+    /** Map path; nullptr if missing or not an event journal. */
+    static std::unique_ptr<EventJournalReader> open(const std::string& path);
+
+    ~EventJournalReader();
+    EventJournalReader(const EventJournalReader&) = delete;
+    EventJournalReader& operator=(const EventJournalReader&) = delete;
+
+    [[nodiscard]] const JournalFileHeader& header() const { return header_; }
+    [[nodiscard]] std::chrono::milliseconds timer_tick() const {
+        return std::chrono::milliseconds(header_.timer_tick_ms);
+    }
+    [[nodiscard]] size_t size() const { return size_; }
+    /** Offset of the first record. */
+    [[nodiscard]] static size_t begin() { return sizeof(JournalFileHeader); }
+    /**
+     * Header of the whole record at offset (payload not decoded); nullopt at the end or at a
+     * truncated or corrupt record.
+     */
+    [[nodiscard]] std::optional<JournalRecordHeader> peek(size_t offset) const;
+    /** Offset of the record after the one at offset (call after a successful peek). */
+    [[nodiscard]] static size_t next(size_t offset, const JournalRecordHeader& header);
+    /**
+     * Decode the record at offset into entry, reusing its buffers; false at the end or on a
+     * truncated or corrupt record.
+     */
+    bool read(size_t offset, JournalEntry& entry) const;
+
+  private:
+    EventJournalReader() = default;
+
+    const std::byte* data_ = nullptr;
+    size_t size_ = 0;
+    /** Fallback buffer where mmap is unavailable (Windows). */
+    std::vector<std::byte> buffer_;
+    JournalFileHeader header_;
+};
+
+} // namespace engines
@@ -0,0 +1,65 @@
+#include "holding_journal.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <iterator>
+#include <utility>
+
+namespace engines {
+
+HoldingJournal::HoldingJournal(std::string path) : path_(std::move(path)) {}
+
+auto HoldingJournal::read() const -> std::string {
+    std::ifstream in(path_, std::ios::binary);
+    if (!in) {
+        return {};
+    }
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+auto HoldingJournal::append(std::string_view records) -> bool {
+    if (records.empty()) {
+        return true;
+    }
+    if (!out_.is_open()) {
+        out_.open(path_, std::ios::binary | std::ios::app);
+    }
+    out_.write(records.data(), static_cast<std::streamsize>(records.size()));
+    out_.flush();
+    if (!out_) {
+        // The records are lost from the file; the next compaction writes the full state again.
+        out_.close();
+        out_.clear();
+        failed_ = true;
+        return false;
+    }
+    appended_bytes_ += records.size();
+    return true;
+}
+
+auto HoldingJournal::compact(std::string_view snapshot) -> bool {
+    const std::string tmp = path_ + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(snapshot.data(), static_cast<std::streamsize>(snapshot.size()));
+        if (!out) {
+            return false;
+        }
+    }
+    out_.close();
+    out_.clear();
+    std::error_code ec;
+    std::filesystem::rename(tmp, path_, ec);
+    if (ec) {
+        return false;
+    }
+    snapshot_bytes_ = snapshot.size();
+    appended_bytes_ = 0;
+    failed_ = false;
+    return true;
+}
+
+auto HoldingJournal::needs_compaction() const -> bool {
+    return failed_ || appended_bytes_ > std::max(snapshot_bytes_, kMinCompactBytes);
+}
+
+} // namespace engines
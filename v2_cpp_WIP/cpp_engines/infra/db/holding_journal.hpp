@@ -0,0 +1,41 @@
+#pragma once
+
+/**
+ * Holding journal: append-only file of PositionEngine journal records. Checkpoints append only
+ * the positions that changed; compact() rewrites the file as one snapshot per holding once the
+ * appended records outgrow the last snapshot, so the file stays proportional to the book.
+ */
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+namespace engines {
+
+class HoldingJournal {
+  public:
+    explicit HoldingJournal(std::string path);
+
+    [[nodiscard]] const std::string& path() const { return path_; }
+    /** Whole file for PositionEngine::replay_journal; empty if missing. */
+    [[nodiscard]] std::string read() const;
+    /** Append records and flush them to the OS; false on I/O failure (and compaction is due). */
+    bool append(std::string_view records);
+    /** Replace the file with snapshot via a temp file + rename; appends continue after it. */
+    bool compact(std::string_view snapshot);
+    /** Appended bytes exceed the last snapshot (and a floor), or an append failed. */
+    [[nodiscard]] bool needs_compaction() const;
+
+  private:
+    /** Journals smaller than this are never worth rewriting. */
+    static constexpr size_t kMinCompactBytes = size_t{1} << 20;
+
+    std::string path_;
+    std::ofstream out_;
+    size_t snapshot_bytes_ = 0;
+    size_t appended_bytes_ = 0;
+    bool failed_ = false;
+};
+
+} // namespace engines
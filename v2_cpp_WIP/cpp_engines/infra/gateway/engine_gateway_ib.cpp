@@ -1,7 +1,9 @@
-/** IbGateway: TWS C++ API. */
+/** IbGateway: TWS C++ API; one gateway I/O thread owns the socket (see IbApiTws). */
 
 #include "engine_gateway_ib.hpp"
 #include "../../utilities/constant.hpp"
+#include "../../utilities/latency.hpp"
+#include "../../utilities/mpsc_ring.hpp"
 #include "engine_main.hpp"
 #include "ib_mapping.hpp"
 
@@ -19,15 +21,22 @@
 #include "OrderState.h"
 
 #include <array>
+#include <atomic>
+#include <charconv>
 #include <ctime>
 #include <format>
 #include <iomanip>
+#include <iterator>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <span>
 #include <sstream>
+#include <stop_token>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
+#include <variant>
 #include <vector>
 
 namespace engines {
@@ -139,14 +148,52 @@ static auto build_ib_combo_contract(std::span<const utilities::Leg> legs,
 
 // IbApiTws
 
+/** Contract cache key of a single-leg order: symbol plus trading class. */
+static auto single_contract_key(const std::string& symbol, const std::string* trading_class)
+    -> std::string {
+    std::string key = symbol;
+    key += '|';
+    if (trading_class != nullptr) {
+        key += *trading_class;
+    }
+    return key;
+}
+
+/** Contract cache key of a combo: trading class plus (con_id, ratio, side) per leg. */
+static auto combo_contract_key(std::span<const utilities::Leg> legs,
+                               const std::string* trading_class) -> std::string {
+    std::string key = "BAG|";
+    if (trading_class != nullptr) {
+        key += *trading_class;
+    }
+    for (const auto& leg : legs) {
+        std::format_to(std::back_inserter(key), "|{}:{}:{}", leg.con_id, std::abs(leg.ratio),
+                       leg.direction == utilities::Direction::LONG ? 'B' : 'S');
+    }
+    return key;
+}
+
+/**
+ * Every EClientSocket call and every EWrapper callback runs on one gateway I/O thread. Callers
+ * (event worker, gRPC threads) only build the order, record it and push a command onto a
+ * lock-free ring; the I/O thread is woken through the EReader signal, so it serves outgoing
+ * commands and incoming TWS messages from the same wait.
+ */
 class IbApiTws : public IbApi, public DefaultEWrapper {
   public:
     explicit IbApiTws(IbGateway* gateway)
         : gateway_(gateway),
           engine_name((gateway != nullptr) ? gateway->gateway_name() : "IBGateway"),
-          os_signal_(2000), client_(new EClientSocket(this, &os_signal_)) {}
+          os_signal_(2000), client_(new EClientSocket(this, &os_signal_)) {
+        io_thread_ = std::jthread([this](std::stop_token st) { run_io(st); });
+    }
 
     ~IbApiTws() override {
+        io_thread_.request_stop();
+        os_signal_.issueSignal();
+        if (io_thread_.joinable()) {
+            io_thread_.join();
+        }
         if (reader_) {
             reader_.reset();
         }
@@ -157,77 +204,25 @@ class IbApiTws : public IbApi, public DefaultEWrapper {
         }
     }
 
+    IbApiTws(const IbApiTws&) = delete;
+    IbApiTws& operator=(const IbApiTws&) = delete;
+
     void connect(const std::string& host, int port, int client_id,
                  const std::string& account) override {
-        if (status_) {
-            return;
-        }
-        host_ = host;
-        port_ = port;
-        client_id_ = client_id;
-        account_ = account;
-        if (client_ == nullptr) {
-            client_ = new EClientSocket(this, &os_signal_);
-        }
-        bool ok = client_->eConnect(host.c_str(), port, client_id, false);
-        if (!ok) {
-            if (gateway_ != nullptr) {
-                gateway_->write_log("IB eConnect failed", ERROR);
-            }
-            return;
-        }
-        reader_ = std::make_unique<EReader>(client_, &os_signal_);
-        reader_->start();
-        if (gateway_ != nullptr) {
-            gateway_->write_log("IB TWS connecting (wait for nextValidId)...", INFO);
-        }
+        submit(ConnectCmd{.host = host, .port = port, .client_id = client_id, .account = account});
     }
 
     auto is_connected() const -> bool override {
-        return status_ && (client_ != nullptr) && client_->isConnected();
+        return status_.load(std::memory_order_acquire) &&
+               socket_connected_.load(std::memory_order_acquire);
     }
 
-    void close() override {
-        if (client_ == nullptr || (!status_ && !client_->isConnected())) {
-            return;
-        }
-        if (reader_) {
-            reader_.reset();
-        }
-        if (client_ != nullptr) {
-            client_->eDisconnect();
-        }
-        clear_account_data();
-        status_ = false;
-        if (gateway_ != nullptr) {
-            gateway_->write_log("IB TWS disconnected", WARNING);
-        }
-    }
+    void close() override { submit(CloseCmd{}); }
 
-    void check_connection() override {
-        // Auto-reconnect only after prior success
-        if ((client_ == nullptr) || !client_->isConnected()) {
-            if (!status_) {
-                // Never connected; wait for explicit connect
-                return;
-            }
-            // Was connected; close then reconnect
-            close();
-            if (!host_.empty() && (gateway_ != nullptr)) {
-                gateway_->write_log("IB reconnecting...", INFO);
-                connect(host_, port_, client_id_, account_);
-            }
-        }
-    }
-
-    void process_pending_messages() override {
-        if (reader_) {
-            reader_->processMsgs();
-        }
-    }
+    void check_connection() override { submit(CheckConnectionCmd{}); }
 
     auto send_order(const utilities::OrderRequest& req) -> std::string override {
-        if ((gateway_ == nullptr) || !client_->isConnected()) {
+        if ((gateway_ == nullptr) || !socket_connected_.load(std::memory_order_acquire)) {
             if (gateway_ != nullptr) {
                 gateway_->write_log("IB send_order failed: gateway null or not connected", ERROR);
             }
@@ -241,88 +236,63 @@ class IbApiTws : public IbApi, public DefaultEWrapper {
             gateway_->write_log("IB send_order failed: combo order requires legs", ERROR);
             return "";
         }
-        Contract contract;
-        if (req.is_combo) {
-            build_ib_combo_contract(
-                *req.legs, req.trading_class.has_value() ? &*req.trading_class : nullptr, contract);
-        } else if (!build_ib_single_contract(
-                       req.symbol, req.trading_class.has_value() ? &*req.trading_class : nullptr,
-                       contract)) {
+        std::shared_ptr<const Contract> contract = cached_contract(req);
+        if (!contract) {
             gateway_->write_log(
                 "IB send_order failed: contract build failed for symbol=" + req.symbol, ERROR);
             return "";
         }
-        order_id_++;
-        OrderId oid = order_id_;
-        Order order;
+        const OrderId oid = order_id_.fetch_add(1, std::memory_order_relaxed) + 1;
+        PlaceOrderCmd place{.oid = oid, .contract = std::move(contract)};
+        if (utilities::LatencyTracer::enabled()) {
+            place.submitted_tsc = utilities::trace_now();
+            place.trace_tsc = req.trace_tsc;
+        }
+        Order& order = place.order;
         order.orderId = oid;
-        order.clientId = client_id_;
+        order.clientId = client_id_.load(std::memory_order_relaxed);
         order.action = req.is_combo ? "BUY" : direction_vt2ib(req.direction);
         order.orderType = ordertype_vt2ib(req.type);
         order.totalQuantity =
             DecimalFunctions::stringToDecimal(std::to_string(static_cast<long long>(req.volume)));
-        order.account = account_;
+        {
+            std::scoped_lock lock(account_mutex_);
+            order.account = account_;
+        }
         if (req.type == utilities::OrderType::LIMIT) {
             order.lmtPrice = req.price;
         }
         std::string orderid = std::to_string(oid);
-        gateway_->write_log(
-            "IB placing order: id=" + orderid + " symbol=" +
-                (req.is_combo ? std::string("COMBO(") + contract.symbol + ")" : req.symbol) +
-                " vol=" + std::to_string(req.volume),
-            INFO);
         utilities::OrderData od = req.create_order_data(orderid, engine_name);
         {
-            std::scoped_lock lock(mutex_);
-            orders_[orderid] = od;
-            last_order_status_[orderid] = {utilities::Status::SUBMITTING, 0.0};
-            pending_orders_.insert(orderid);
+            std::scoped_lock lock(orders_mutex_);
+            orders_[oid] = OrderEntry{.data = od};
         }
+        // SUBMITTING goes out before placeOrder so TWS status updates cannot overtake it.
         gateway_->on_order(od);
-        client_->placeOrder(oid, contract, order);
+        submit(std::move(place));
         return orderid;
     }
 
     void cancel_order(const utilities::CancelRequest& req) override {
-        if (!client_->isConnected()) {
+        OrderId oid = 0;
+        const char* end = req.orderid.data() + req.orderid.size();
+        if (std::from_chars(req.orderid.data(), end, oid).ptr != end || oid <= 0) {
+            if (gateway_ != nullptr) {
+                gateway_->write_log("IB cancel_order failed: bad orderid " + req.orderid, ERROR);
+            }
             return;
         }
-        OrderCancel oc;
-        time_t now = std::time(nullptr);
-        struct tm t;
-#ifdef _WIN32
-        gmtime_s(&t, &now);
-#else
-        gmtime_r(&now, &t);
-#endif
-        std::array<char, 32> buf{};
-        std::snprintf(buf.data(), buf.size(), "%04d%02d%02d-%02d:%02d:%02d", t.tm_year + 1900,
-                      t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec);
-        oc.manualOrderCancelTime = buf.data();
-        client_->cancelOrder(std::stol(req.orderid), oc);
+        submit(CancelOrderCmd{.oid = oid});
     }
 
-    void query_account() override {
-        if (!client_->isConnected()) {
-            return;
-        }
-        std::scoped_lock lock(mutex_);
-        req_id_counter_++;
-        client_->reqAccountSummary(req_id_counter_, "All",
-                                   "NetLiquidation,AvailableFunds,MaintMarginReq,UnrealizedPnL");
-    }
+    void query_account() override { submit(QueryAccountCmd{}); }
 
-    void query_position() override {
-        if (!client_->isConnected()) {
-            return;
-        }
-        client_->reqPositions();
-    }
+    void query_position() override { submit(QueryPositionCmd{}); }
 
-    // EWrapper callbacks
+    // EWrapper callbacks (I/O thread)
     void connectAck() override {
-        if (!status_) {
-            status_ = true;
+        if (!status_.exchange(true)) {
             if (gateway_ != nullptr) {
                 gateway_->write_log("IB TWS connection successful", INFO);
             }
@@ -332,18 +302,20 @@ class IbApiTws : public IbApi, public DefaultEWrapper {
     void connectionClosed() override {
         clear_account_data();
         status_ = false;
+        socket_connected_.store(false, std::memory_order_release);
         if (gateway_ != nullptr) {
             gateway_->write_log("IB TWS connection closed", WARNING);
         }
     }
 
     void nextValidId(OrderId orderId) override {
-        if (order_id_ <= 0) {
-            order_id_ = orderId;
-        }
+        // Only the first id TWS hands out seeds the counter.
+        OrderId expected = 0;
+        order_id_.compare_exchange_strong(expected, orderId);
     }
 
     void managedAccounts(const std::string& accountsList) override {
+        std::scoped_lock lock(account_mutex_);
         if (account_.empty()) {
             std::istringstream ss(accountsList);
             std::string a;
@@ -375,41 +347,41 @@ class IbApiTws : public IbApi, public DefaultEWrapper {
                      double avgFillPrice, long long /*permId*/, int /*parentId*/,
                      double /*lastFillPrice*/, int /*clientId*/, const std::string& /*whyHeld*/,
                      double /*mktCapPrice*/) override {
-        std::string orderid = std::to_string(orderId);
         utilities::Status st = status_ib2vt(status);
         double fill = DecimalFunctions::decimalToDouble(filled);
-        std::scoped_lock lock(mutex_);
-        auto it = orders_.find(orderid);
-        if (it == orders_.end()) {
-            return;
-        }
-        auto& last = last_order_status_[orderid];
-        if (std::make_pair(st, fill) == last) {
-            return;
-        }
-        it->second.traded = fill;
-        it->second.status = st;
-        last = {st, fill};
-        gateway_->on_order(it->second);
-        if (st == utilities::Status::ALLTRADED || st == utilities::Status::CANCELLED ||
-            st == utilities::Status::REJECTED) {
-            last_order_status_.erase(orderid);
-            orders_.erase(it);
-            completed_orders_.insert(orderid);
+        utilities::OrderData od;
+        {
+            std::scoped_lock lock(orders_mutex_);
+            auto it = orders_.find(orderId);
+            if (it == orders_.end()) {
+                return;
+            }
+            OrderEntry& entry = it->second;
+            if (entry.last_status == st && entry.last_traded == fill) {
+                return;
+            }
+            entry.data.traded = fill;
+            entry.data.status = st;
+            entry.last_status = st;
+            entry.last_traded = fill;
+            if (st == utilities::Status::ALLTRADED || st == utilities::Status::CANCELLED ||
+                st == utilities::Status::REJECTED) {
+                od = std::move(entry.data);
+                orders_.erase(it);
+                completed_orders_.insert(orderId);
+            } else {
+                od = entry.data;
+            }
         }
+        gateway_->on_order(od);
     }
 
     void openOrder(OrderId orderId, const Contract& contract, const Order& order,
                    const OrderState& /*unused*/) override {
-        std::string orderid = std::to_string(orderId);
         {
-            std::scoped_lock lock(mutex_);
-            if (static_cast<unsigned int>(pending_orders_.contains(orderid)) != 0U) {
-                pending_orders_.erase(orderid);
-                return;
-            }
-            if ((static_cast<unsigned int>(completed_orders_.contains(orderid)) != 0U) ||
-                (static_cast<unsigned int>(orders_.contains(orderid)) != 0U)) {
+            // Orders sent from here (or already seen) are tracked by orderStatus.
+            std::scoped_lock lock(orders_mutex_);
+            if (orders_.contains(orderId) || completed_orders_.contains(orderId)) {
                 return;
             }
         }
@@ -417,31 +389,29 @@ class IbApiTws : public IbApi, public DefaultEWrapper {
         od.gateway_name = engine_name;
         od.symbol = contract_to_formatted_symbol(contract);
         od.exchange = utilities::Exchange::SMART;
-        od.orderid = orderid;
+        od.orderid = std::to_string(orderId);
         od.type = ordertype_ib2vt(order.orderType);
         od.direction = direction_ib2vt(order.action);
         od.volume = DecimalFunctions::decimalToDouble(order.totalQuantity);
         od.price = (order.orderType == "LMT") ? order.lmtPrice : 0;
         od.status = utilities::Status::SUBMITTING;
         {
-            std::scoped_lock lock(mutex_);
-            orders_[orderid] = od;
-            last_order_status_[orderid] = {utilities::Status::SUBMITTING, 0.0};
+            std::scoped_lock lock(orders_mutex_);
+            orders_[orderId] = OrderEntry{.data = od};
         }
         gateway_->on_order(od);
     }
 
     void execDetails(int /*reqId*/, const Contract& contract, const Execution& execution) override {
-        std::string orderid = std::to_string(execution.orderId);
         std::string symbol;
         utilities::Direction dir = direction_ib2vt(execution.side);
         {
-            std::scoped_lock lock(mutex_);
-            auto it = orders_.find(orderid);
+            std::scoped_lock lock(orders_mutex_);
+            auto it = orders_.find(execution.orderId);
             if (it != orders_.end()) {
-                symbol = it->second.symbol;
-                if (it->second.is_combo && it->second.direction.has_value()) {
-                    dir = it->second.direction.value();
+                symbol = it->second.data.symbol;
+                if (it->second.data.is_combo && it->second.data.direction.has_value()) {
+                    dir = it->second.data.direction.value();
                 }
             } else {
                 symbol = contract_to_formatted_symbol(contract);
@@ -487,7 +457,7 @@ class IbApiTws : public IbApi, public DefaultEWrapper {
         td.gateway_name = engine_name;
         td.symbol = symbol;
         td.exchange = utilities::Exchange::SMART;
-        td.orderid = orderid;
+        td.orderid = std::to_string(execution.orderId);
         td.tradeid = execution.execId;
         td.direction = dir;
         td.price = execution.price;
@@ -502,12 +472,13 @@ class IbApiTws : public IbApi, public DefaultEWrapper {
             tag != "UnrealizedPnL") {
             return;
         }
-        std::scoped_lock lock(mutex_);
+        std::scoped_lock lock(account_mutex_);
         account_values_[account][tag] = value;
     }
 
     void accountSummaryEnd(int reqId) override {
         (void)reqId;
+        std::scoped_lock lock(account_mutex_);
         account_values_.clear();
     }
 
@@ -521,19 +492,259 @@ class IbApiTws : public IbApi, public DefaultEWrapper {
     void positionEnd() override {}
 
   private:
+    struct ConnectCmd {
+        std::string host;
+        int port = 7497;
+        int client_id = 0;
+        std::string account;
+    };
+    struct CloseCmd {};
+    struct CheckConnectionCmd {};
+    struct PlaceOrderCmd {
+        OrderId oid = 0;
+        std::shared_ptr<const Contract> contract;
+        Order order;
+        /** Latency tracing: send_order hand-off and market data arrival; 0 = untraced. */
+        uint64_t submitted_tsc = 0;
+        uint64_t trace_tsc = 0;
+    };
+    struct CancelOrderCmd {
+        OrderId oid = 0;
+    };
+    struct QueryAccountCmd {};
+    struct QueryPositionCmd {};
+    using IoCommand = std::variant<ConnectCmd, CloseCmd, CheckConnectionCmd, PlaceOrderCmd,
+                                   CancelOrderCmd, QueryAccountCmd, QueryPositionCmd>;
+
+    /** Gateway-side state of one live order (orders_mutex_). */
+    struct OrderEntry {
+        utilities::OrderData data;
+        utilities::Status last_status = utilities::Status::SUBMITTING;
+        double last_traded = 0.0;
+    };
+
+    static constexpr size_t kIoBatch = 64;
+    static constexpr int kIoIdleSpins = 512;
+
+    /** Any thread: queue for the I/O thread (yields while the ring is full) and wake it. */
+    template <typename Cmd> void submit(Cmd&& cmd) {
+        IoCommand item(std::forward<Cmd>(cmd));
+        while (!commands_.try_push(std::move(item))) {
+            std::this_thread::yield();
+        }
+        os_signal_.issueSignal();
+    }
+
+    /** Prebuilt IB contract for req, built once per symbol or combo signature. */
+    auto cached_contract(const utilities::OrderRequest& req) -> std::shared_ptr<const Contract> {
+        const std::string* trading_class =
+            req.trading_class.has_value() ? &*req.trading_class : nullptr;
+        std::string key = req.is_combo ? combo_contract_key(*req.legs, trading_class)
+                                       : single_contract_key(req.symbol, trading_class);
+        {
+            std::shared_lock lock(contracts_mutex_);
+            auto it = contracts_.find(key);
+            if (it != contracts_.end()) {
+                return it->second;
+            }
+        }
+        auto contract = std::make_shared<Contract>();
+        if (req.is_combo) {
+            build_ib_combo_contract(*req.legs, trading_class, *contract);
+        } else if (!build_ib_single_contract(req.symbol, trading_class, *contract)) {
+            return nullptr;
+        }
+        std::unique_lock lock(contracts_mutex_);
+        return contracts_.try_emplace(std::move(key), std::move(contract)).first->second;
+    }
+
+    void run_io(const std::stop_token& st) {
+        std::vector<IoCommand> batch;
+        batch.reserve(kIoBatch);
+        int idle = 0;
+        while (!st.stop_requested()) {
+            batch.clear();
+            commands_.pop_batch([&batch](IoCommand&& c) -> void { batch.push_back(std::move(c)); },
+                                kIoBatch);
+            for (IoCommand& cmd : batch) {
+                std::visit([this](auto& c) -> void { execute(c); }, cmd);
+            }
+            if (reader_) {
+                reader_->processMsgs();
+            }
+            socket_connected_.store(client_ != nullptr && client_->isConnected(),
+                                    std::memory_order_release);
+            if (!batch.empty()) {
+                idle = 0;
+                continue;
+            }
+            // Spin briefly for the next order, then sleep until TWS data or a command arrives.
+            if (++idle < kIoIdleSpins) {
+                utilities::cpu_relax();
+                continue;
+            }
+            idle = 0;
+            os_signal_.waitForSignal();
+        }
+    }
+
+    void execute(ConnectCmd& cmd) {
+        if (status_) {
+            return;
+        }
+        host_ = cmd.host;
+        port_ = cmd.port;
+        client_id_ = cmd.client_id;
+        {
+            std::scoped_lock lock(account_mutex_);
+            account_ = cmd.account;
+        }
+        if (client_ == nullptr) {
+            client_ = new EClientSocket(this, &os_signal_);
+        }
+        bool ok = client_->eConnect(cmd.host.c_str(), cmd.port, cmd.client_id, false);
+        if (!ok) {
+            if (gateway_ != nullptr) {
+                gateway_->write_log("IB eConnect failed", ERROR);
+            }
+            return;
+        }
+        reader_ = std::make_unique<EReader>(client_, &os_signal_);
+        reader_->start();
+        if (gateway_ != nullptr) {
+            gateway_->write_log("IB TWS connecting (wait for nextValidId)...", INFO);
+        }
+    }
+
+    void execute(CloseCmd& /*unused*/) {
+        if (client_ == nullptr || (!status_ && !client_->isConnected())) {
+            return;
+        }
+        if (reader_) {
+            reader_.reset();
+        }
+        if (client_ != nullptr) {
+            client_->eDisconnect();
+        }
+        clear_account_data();
+        status_ = false;
+        if (gateway_ != nullptr) {
+            gateway_->write_log("IB TWS disconnected", WARNING);
+        }
+    }
+
+    void execute(CheckConnectionCmd& /*unused*/) {
+        // Auto-reconnect only after prior success
+        if ((client_ == nullptr) || !client_->isConnected()) {
+            if (!status_) {
+                // Never connected; wait for explicit connect
+                return;
+            }
+            // Was connected; close then reconnect
+            CloseCmd close;
+            execute(close);
+            if (!host_.empty() && (gateway_ != nullptr)) {
+                gateway_->write_log("IB reconnecting...", INFO);
+                ConnectCmd reconnect{.host = host_, .port = port_, .client_id = client_id_};
+                {
+                    std::scoped_lock lock(account_mutex_);
+                    reconnect.account = account_;
+                }
+                execute(reconnect);
+            }
+        }
+    }
+
+    void execute(PlaceOrderCmd& cmd) {
+        if ((client_ == nullptr) || !client_->isConnected()) {
+            gateway_->write_log("IB placeOrder rejected: not connected, id=" +
+                                    std::to_string(cmd.oid),
+                                ERROR);
+            // TWS never sees this order: finish it here so the strategy gets a terminal status.
+            utilities::OrderData od;
+            {
+                std::scoped_lock lock(orders_mutex_);
+                auto it = orders_.find(cmd.oid);
+                if (it == orders_.end()) {
+                    return;
+                }
+                od = std::move(it->second.data);
+                orders_.erase(it);
+                completed_orders_.insert(cmd.oid);
+            }
+            od.status = utilities::Status::REJECTED;
+            gateway_->on_order(od);
+            return;
+        }
+        if (cmd.submitted_tsc != 0) {
+            utilities::LatencyTracer& tracer = utilities::LatencyTracer::instance();
+            const uint64_t now = utilities::trace_now();
+            tracer.record(utilities::LatencyStage::GatewayQueue, cmd.submitted_tsc, now);
+            if (cmd.trace_tsc != 0) {
+                tracer.record(utilities::LatencyStage::TickToOrder, cmd.trace_tsc, now);
+            }
+        }
+        client_->placeOrder(cmd.oid, *cmd.contract, cmd.order);
+        const bool combo = cmd.contract->secType == "BAG";
+        gateway_->write_log(std::format("IB placed order: id={} symbol={} vol={}", cmd.oid,
+                                        combo ? "COMBO(" + cmd.contract->symbol + ")"
+                                              : contract_to_formatted_symbol(*cmd.contract),
+                                        DecimalFunctions::decimalToDouble(
+                                            cmd.order.totalQuantity)),
+                            INFO);
+    }
+
+    void execute(CancelOrderCmd& cmd) {
+        if (!client_->isConnected()) {
+            return;
+        }
+        OrderCancel oc;
+        time_t now = std::time(nullptr);
+        struct tm t;
+#ifdef _WIN32
+        gmtime_s(&t, &now);
+#else
+        gmtime_r(&now, &t);
+#endif
+        std::array<char, 32> buf{};
+        std::snprintf(buf.data(), buf.size(), "%04d%02d%02d-%02d:%02d:%02d", t.tm_year + 1900,
+                      t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec);
+        oc.manualOrderCancelTime = buf.data();
+        client_->cancelOrder(cmd.oid, oc);
+    }
+
+    void execute(QueryAccountCmd& /*unused*/) {
+        if (!client_->isConnected()) {
+            return;
+        }
+        req_id_counter_++;
+        client_->reqAccountSummary(req_id_counter_, "All",
+                                   "NetLiquidation,AvailableFunds,MaintMarginReq,UnrealizedPnL");
+    }
+
+    void execute(QueryPositionCmd& /*unused*/) {
+        if (!client_->isConnected()) {
+            return;
+        }
+        client_->reqPositions();
+    }
+
     void clear_account_data() {
-        std::scoped_lock lock(mutex_);
+        std::scoped_lock lock(account_mutex_);
         account_values_.clear();
     }
 
     IbGateway* gateway_ = nullptr;
     std::string engine_name;
-    bool status_ = false;
-    OrderId order_id_ = 0;
-    int req_id_ = 0;
+    std::atomic<bool> status_{false};
+    /** client_->isConnected() as of the last I/O loop pass; read by other threads instead. */
+    std::atomic<bool> socket_connected_{false};
+    /** Last allocated order id (send_order takes ++); seeded by nextValidId. */
+    std::atomic<OrderId> order_id_{0};
+    std::atomic<int> client_id_{0};
+
+    // I/O thread only
     int req_id_counter_ = 9000;
-    int client_id_ = 0;
-    std::string account_;
     std::string host_;
     int port_ = 7497;
 
@@ -541,12 +752,22 @@ class IbApiTws : public IbApi, public DefaultEWrapper {
     EClientSocket* client_ = nullptr;
     std::unique_ptr<EReader> reader_;
 
-    mutable std::mutex mutex_;
-    std::unordered_map<std::string, utilities::OrderData> orders_;
-    std::unordered_map<std::string, std::pair<utilities::Status, double>> last_order_status_;
-    std::unordered_set<std::string> pending_orders_;
-    std::unordered_set<std::string> completed_orders_;
+    utilities::MpscRing<IoCommand> commands_{1024};
+
+    std::shared_mutex contracts_mutex_;
+    std::unordered_map<std::string, std::shared_ptr<const Contract>> contracts_;
+
+    /** Held only around table lookups, never across callbacks or socket calls. */
+    std::mutex orders_mutex_;
+    std::unordered_map<OrderId, OrderEntry> orders_;
+    std::unordered_set<OrderId> completed_orders_;
+
+    std::mutex account_mutex_;
+    std::string account_;
     std::unordered_map<std::string, std::unordered_map<std::string, std::string>> account_values_;
+
+    /** Last member: started once everything it touches is constructed, joined first. */
+    std::jthread io_thread_;
 };
 
 // IbGateway
@@ -597,16 +818,10 @@ void IbGateway::query_account() { api_->query_account(); }
 
 void IbGateway::query_position() { api_->query_position(); }
 
-void IbGateway::process_timer_event(const utilities::Event& /*unused*/) {
+void IbGateway::check_connection() {
     if (api_) {
-        api_->process_pending_messages();
-    }
-    count_++;
-    if (count_ < 10) {
-        return;
+        api_->check_connection();
     }
-    count_ = 0;
-    api_->check_connection();
 }
 
 } // namespace engines
@@ -3,7 +3,8 @@
 /**
  * C++ equivalent of engines/engine_gateway.py (IbGateway).
  * Interface: connect, disconnect, send_order, cancel_order, query_account, query_position.
- * Actual IB connectivity via IbApi implementation (stub or TWS).
+ * Actual IB connectivity via IbApi implementation (stub or TWS). The TWS implementation runs its
+ * own I/O thread; every IbApi call except send_order's bookkeeping only queues a command.
  */
 
 #include "../../core/engine_log.hpp"
@@ -31,8 +32,6 @@ class IbApi {
     virtual void cancel_order(const utilities::CancelRequest& req) = 0;
     virtual void query_account() = 0;
     virtual void query_position() = 0;
-    /** Call periodically when connected to drain TWS message queue (no-op for stub). */
-    virtual void process_pending_messages() {}
 };
 
 class IbGateway : public utilities::BaseEngine {
@@ -50,7 +49,8 @@ class IbGateway : public utilities::BaseEngine {
     void query_account();
     void query_position();
 
-    void process_timer_event(const utilities::Event& event);
+    /** Reconnect when TWS dropped the session (scheduled on a slower timer). */
+    void check_connection();
 
     void close() override { disconnect(); }
 
@@ -73,7 +73,6 @@ class IbGateway : public utilities::BaseEngine {
     void on_trade(const utilities::TradeData& trade);
 
     Setting default_setting_;
-    int count_ = 0;
     std::unique_ptr<IbApi> api_;
 };
 
@@ -3,16 +3,24 @@
 #include "event.hpp"
 #include "object.hpp"
 #include "occ_utils.hpp"
+#include "thread_pool.hpp"
 #include <algorithm>
 #include <arrow/api.h>
 #include <cctype>
 #include <chrono>
 #include <cmath>
 #include <concepts>
+#include <condition_variable>
 #include <ctime>
+#include <exception>
+#include <filesystem>
+#include <format>
 #include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <mutex>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -34,37 +42,221 @@ template <std::integral T> auto get_int64(const Array* arr, int64_t i) -> T {
     }
     return static_cast<T>(static_cast<const Int64Array*>(arr)->Value(i));
 }
-auto get_symbol(const Array* arr_sym, int64_t i) -> std::string {
-    if ((arr_sym == nullptr) || arr_sym->type_id() != Type::STRING || arr_sym->IsNull(i)) {
-        return {};
+/** Quote size cell (int32, int64 or double column); 0 when absent or null. */
+auto get_size(const Array* arr, int64_t i) -> double {
+    if (!arr || arr->IsNull(i)) {
+        return 0.0;
+    }
+    switch (arr->type_id()) {
+    case Type::INT32:
+        return static_cast<double>(static_cast<const Int32Array*>(arr)->Value(i));
+    case Type::INT64:
+        return static_cast<double>(static_cast<const Int64Array*>(arr)->Value(i));
+    case Type::DOUBLE:
+        return static_cast<const DoubleArray*>(arr)->Value(i);
+    default:
+        return 0.0;
     }
-    return static_cast<const StringArray*>(arr_sym)->GetString(i);
 }
 
+/** One streamed timestep: snapshot buffer reused across laps of the ring. */
+struct StreamSlot {
+    Timestamp timestamp{};
+    int64_t num_rows = 0;
+    utilities::PortfolioSnapshot snapshot;
+};
+
+/** Bounded single-producer / single-consumer ring of StreamSlots. */
+class SnapshotRing {
+  public:
+    explicit SnapshotRing(size_t capacity) : slots_(std::max<size_t>(capacity, 2)) {}
+
+    /** Next slot to fill; blocks while full; nullptr once cancelled. */
+    auto begin_write() -> StreamSlot* {
+        std::unique_lock lk(mutex_);
+        cv_.wait(lk, [this] { return cancelled_ || written_ - read_ < slots_.size(); });
+        return cancelled_ ? nullptr : &slots_[written_ % slots_.size()];
+    }
+    /** Most recently published slot (carry-forward source); nullptr before the first. */
+    auto last_written() -> const StreamSlot* {
+        std::scoped_lock lk(mutex_);
+        return written_ == 0 ? nullptr : &slots_[(written_ - 1) % slots_.size()];
+    }
+    void end_write() {
+        {
+            std::scoped_lock lk(mutex_);
+            ++written_;
+        }
+        cv_.notify_all();
+    }
+    /** Oldest published slot; blocks while empty; nullptr once closed and drained or cancelled. */
+    auto begin_read() -> const StreamSlot* {
+        std::unique_lock lk(mutex_);
+        cv_.wait(lk, [this] { return cancelled_ || closed_ || read_ < written_; });
+        if (cancelled_ || read_ == written_) {
+            return nullptr;
+        }
+        return &slots_[read_ % slots_.size()];
+    }
+    void end_read() {
+        {
+            std::scoped_lock lk(mutex_);
+            ++read_;
+        }
+        cv_.notify_all();
+    }
+    /** Producer finished (no more writes). */
+    void close() {
+        {
+            std::scoped_lock lk(mutex_);
+            closed_ = true;
+        }
+        cv_.notify_all();
+    }
+    /** Consumer stopped; unblocks the producer. */
+    void cancel() {
+        {
+            std::scoped_lock lk(mutex_);
+            cancelled_ = true;
+        }
+        cv_.notify_all();
+    }
+
+  private:
+    std::vector<StreamSlot> slots_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    size_t written_ = 0;
+    size_t read_ = 0;
+    bool closed_ = false;
+    bool cancelled_ = false;
+};
+
 } // namespace
 
 BacktestDataEngine::BacktestDataEngine(MainEngine* main_engine)
     : utilities::BaseEngine(main_engine, "BacktestDataEngine"), loader_(make_parquet_loader()) {}
 
+void BacktestDataEngine::set_time_range(std::optional<Timestamp> start,
+                                        std::optional<Timestamp> end) {
+    range_start_ = start;
+    range_end_ = end;
+    loader_->set_time_range(start, end);
+}
+
+void BacktestDataEngine::set_persist_sort_index(bool enabled) {
+    persist_sort_index_ = enabled;
+    loader_->set_persist_sort_index(enabled);
+}
+
+void BacktestDataEngine::configure_like(BacktestDataEngine const& other) {
+    set_time_range(other.range_start_, other.range_end_);
+    set_persist_sort_index(other.persist_sort_index_);
+    snapshot_cache_dir_ = other.snapshot_cache_dir_;
+    set_streaming(other.streaming_, other.stream_ring_size_);
+    set_sparse_snapshots(other.sparse_snapshots_);
+    set_bar_interval(other.bar_);
+    set_risk_free_rate(other.risk_free_rate_);
+    set_iv_price_mode(other.iv_price_mode_);
+    set_incremental(other.incremental_, other.incremental_price_eps_,
+                    other.incremental_tau_eps_);
+    set_precompute_greeks(other.precompute_greeks_);
+}
+
 void BacktestDataEngine::set_risk_free_rate(double rate) {
-    if (std::isfinite(rate)) {
+    if (std::isfinite(rate) && rate != risk_free_rate_) {
         risk_free_rate_ = rate;
+        invalidate_greeks();
     }
     if (portfolio_data_) {
         portfolio_data_->set_risk_free_rate(risk_free_rate_);
     }
+    precompute_greeks();
 }
 
 void BacktestDataEngine::set_iv_price_mode(std::string mode) {
     std::ranges::transform(mode, mode.begin(), [](unsigned char c) -> char {
         return static_cast<char>(std::tolower(c));
     });
-    if (mode == "mid" || mode == "bid" || mode == "ask") {
+    if ((mode == "mid" || mode == "bid" || mode == "ask") && mode != iv_price_mode_) {
         iv_price_mode_ = std::move(mode);
+        invalidate_greeks();
     }
     if (portfolio_data_) {
         portfolio_data_->set_iv_price_mode(iv_price_mode_);
     }
+    precompute_greeks();
+}
+
+void BacktestDataEngine::set_incremental(bool enabled, double price_epsilon, double tau_epsilon) {
+    incremental_ = enabled;
+    incremental_price_eps_ = price_epsilon;
+    incremental_tau_eps_ = tau_epsilon;
+    if (portfolio_data_) {
+        portfolio_data_->set_incremental(incremental_, incremental_price_eps_,
+                                         incremental_tau_eps_);
+    }
+}
+
+void BacktestDataEngine::set_precompute_greeks(bool enabled) {
+    precompute_greeks_ = enabled;
+    if (!enabled) {
+        invalidate_greeks();
+        return;
+    }
+    precompute_greeks();
+}
+
+void BacktestDataEngine::set_streaming(bool enabled, size_t ring_size) {
+    stream_ring_size_ = std::max<size_t>(ring_size, 2);
+    if (enabled == streaming_) {
+        return;
+    }
+    streaming_ = enabled;
+    if (streaming_) {
+        std::vector<utilities::PortfolioSnapshot>().swap(snapshots_);
+    } else {
+        precompute_snapshots();
+    }
+}
+
+void BacktestDataEngine::set_bar_interval(std::chrono::nanoseconds bar) {
+    bar = std::max(bar, std::chrono::nanoseconds::zero());
+    if (bar == bar_) {
+        return;
+    }
+    bar_ = bar;
+    precompute_snapshots();
+}
+
+auto BacktestDataEngine::bar_start(Timestamp t) const -> Timestamp {
+    if (bar_.count() <= 0) {
+        return t;
+    }
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch());
+    // Floor division so pre-epoch timestamps bucket consistently.
+    const int64_t q = ns.count() / bar_.count();
+    const int64_t bucket = (ns.count() % bar_.count() < 0) ? q - 1 : q;
+    return Timestamp{std::chrono::duration_cast<Timestamp::duration>(bar_ * bucket)};
+}
+
+auto BacktestDataEngine::same_bar(Timestamp a, Timestamp b) const -> bool {
+    return bar_.count() > 0 && bar_start(a) == bar_start(b);
+}
+
+void BacktestDataEngine::set_sparse_snapshots(bool enabled) {
+    if (enabled == sparse_snapshots_) {
+        return;
+    }
+    sparse_snapshots_ = enabled;
+    precompute_snapshots();
+}
+
+void BacktestDataEngine::invalidate_greeks() {
+    cache_greeks_valid_ = false;
+    for (auto& snap : snapshots_) {
+        snap.has_greeks = false;
+    }
 }
 
 void BacktestDataEngine::load_parquet(std::string const& rel_path, std::string const& time_column,
@@ -72,15 +264,38 @@ void BacktestDataEngine::load_parquet(std::string const& rel_path, std::string c
     loaded_ = false;
     portfolio_ = std::nullopt;
     portfolio_data_.reset();
-    occ_to_standard_symbol_.clear();
+    occ_to_standard_.clear();
     option_apply_index_.clear();
     occ_to_option_.clear();
+    cache_.reset();
+    cache_greeks_valid_ = false;
+    source_ = nullptr;
+    symbols_.clear();
+    dte_ref_.reset();
     time_column_ = time_column;
     underlying_symbol_ = underlying_symbol;
     if (underlying_symbol_.empty()) {
         underlying_symbol_ = infer_underlying_from_filename(rel_path);
     }
 
+    // Sparse frames and the streaming producer never materialize the dense arrays the cache holds.
+    std::string cache_path;
+    uint64_t cache_key = 0;
+    if (!snapshot_cache_dir_.empty() && !streaming_ && !sparse_snapshots_ &&
+        main_engine != nullptr) {
+        cache_key = snapshot_cache_key(rel_path, time_column, underlying_symbol_, risk_free_rate_,
+                                       iv_price_mode_, precompute_greeks_, bar_, range_start_,
+                                       range_end_);
+        if (cache_key != 0) {
+            cache_path = (std::filesystem::path(snapshot_cache_dir_) /
+                          std::format("{:016x}.otsnap", cache_key))
+                             .string();
+            if (load_from_snapshot_cache(cache_path, cache_key)) {
+                return;
+            }
+        }
+    }
+
     if (!loader_->load(rel_path, time_column)) {
         return;
     }
@@ -93,7 +308,6 @@ void BacktestDataEngine::load_parquet(std::string const& rel_path, std::string c
 
     // Derive a reference "today" from the first timestamp string (UTC date at 00:00),
     // so DTE / chain selection in backtest is relative to data start rather than wall-clock now.
-    std::optional<utilities::DateTime> dte_ref;
     if (!m.ts_start.empty() && m.ts_start.size() >= 10) {
         try {
             std::string d = m.ts_start.substr(0, 10); // "YYYY-MM-DD"
@@ -115,7 +329,7 @@ void BacktestDataEngine::load_parquet(std::string const& rel_path, std::string c
             t = timegm(&tm_utc);
 #endif
             if (t != -1) {
-                dte_ref = std::chrono::system_clock::from_time_t(t);
+                dte_ref_ = std::chrono::system_clock::from_time_t(t);
             }
         } catch (...) {
             if (has_main()) {
@@ -126,24 +340,112 @@ void BacktestDataEngine::load_parquet(std::string const& rel_path, std::string c
 
     std::unordered_set<std::string> symbols_set;
     loader_->collect_symbols(symbols_set);
-    std::vector<std::string> symbols;
-    symbols.reserve(symbols_set.size());
-    std::ranges::copy(symbols_set, std::back_inserter(symbols));
-    std::ranges::sort(symbols);
-    build_portfolio_from_symbols(symbols);
+    symbols_.reserve(symbols_set.size());
+    std::ranges::copy(symbols_set, std::back_inserter(symbols_));
+    std::ranges::sort(symbols_);
+    build_portfolio_from_symbols(symbols_);
 
     if (main_engine != nullptr) {
-        create_portfolio_data(symbols, dte_ref);
-        portfolio_data_->finalize_chains();
-        build_option_apply_index();
-        build_occ_to_option(symbols_set);
-        portfolio_data_->set_risk_free_rate(risk_free_rate_);
-        portfolio_data_->set_iv_price_mode(iv_price_mode_);
+        build_portfolio_state();
+        build_occ_to_option();
+        resolve_row_slots();
         precompute_snapshots();
+        if (!cache_path.empty()) {
+            write_snapshot_cache(cache_path, cache_key, m);
+        }
+    }
+}
+
+void BacktestDataEngine::build_portfolio_state() {
+    create_portfolio_data(symbols_, dte_ref_);
+    portfolio_data_->finalize_chains();
+    build_option_apply_index();
+    portfolio_data_->set_risk_free_rate(risk_free_rate_);
+    portfolio_data_->set_iv_price_mode(iv_price_mode_);
+    portfolio_data_->set_incremental(incremental_, incremental_price_eps_,
+                                     incremental_tau_eps_);
+}
+
+void BacktestDataEngine::attach(BacktestDataEngine const& source) {
+    loaded_ = false;
+    portfolio_ = std::nullopt;
+    portfolio_data_.reset();
+    occ_to_standard_.clear();
+    option_apply_index_.clear();
+    occ_to_option_.clear();
+    cache_.reset();
+    snapshots_.clear();
+    snapshot_rows_.clear();
+    source_ = &source;
+    time_column_ = source.time_column_;
+    underlying_symbol_ = source.underlying_symbol_;
+    symbols_ = source.symbols_;
+    dte_ref_ = source.dte_ref_;
+    risk_free_rate_ = source.risk_free_rate_;
+    iv_price_mode_ = source.iv_price_mode_;
+    incremental_ = source.incremental_;
+    incremental_price_eps_ = source.incremental_price_eps_;
+    incremental_tau_eps_ = source.incremental_tau_eps_;
+    if (!source.loaded_) {
+        return;
+    }
+    loaded_ = true;
+    build_portfolio_from_symbols(symbols_);
+    if (main_engine != nullptr) {
+        build_portfolio_state();
+    }
+}
+
+auto BacktestDataEngine::load_from_snapshot_cache(std::string const& path, uint64_t key) -> bool {
+    std::unique_ptr<SnapshotCache> cache = SnapshotCache::open(path, key);
+    if (!cache) {
+        return false;
+    }
+    SnapshotCacheContents const& c = cache->contents();
+    underlying_symbol_ = c.underlying_symbol;
+    symbols_ = c.symbols;
+    dte_ref_ = c.dte_ref;
+    build_portfolio_from_symbols(symbols_);
+    build_portfolio_state();
+    if (portfolio_data_->option_apply_order().size() != cache->option_count()) {
+        // Apply order changed since the cache was written (e.g. contract parsing); rebuild.
+        portfolio_ = std::nullopt;
+        portfolio_data_.reset();
+        occ_to_standard_.clear();
+        option_apply_index_.clear();
+        symbols_.clear();
+        dte_ref_.reset();
+        return false;
+    }
+    cache_greeks_valid_ = precompute_greeks_ && cache->has_greeks();
+    cache_ = std::move(cache);
+    snapshots_.clear();
+    snapshot_rows_.clear();
+    loaded_ = true;
+    if (has_main()) {
+        write_log("Snapshot cache hit: " + path, 20);
+    }
+    return true;
+}
+
+void BacktestDataEngine::write_snapshot_cache(std::string const& path, uint64_t key,
+                                              DataMeta const& meta) const {
+    SnapshotCacheContents contents{.underlying_symbol = underlying_symbol_,
+                                   .meta = meta,
+                                   .dte_ref = dte_ref_,
+                                   .symbols = symbols_};
+    if (!SnapshotCache::write(path, key, contents, snapshots_, snapshot_rows_) && has_main()) {
+        write_log("Snapshot cache not written: " + path, 30);
     }
 }
 
 auto BacktestDataEngine::get_meta() const -> DataMeta {
+    if (source_ != nullptr) {
+        return source_->get_meta();
+    }
+    if (cache_) {
+        return cache_->contents().meta;
+    }
     if (loader_) {
         return loader_->get_meta();
     }
@@ -162,74 +464,109 @@ void BacktestDataEngine::build_option_apply_index() {
     }
 }
 
-void BacktestDataEngine::build_occ_to_option(std::unordered_set<std::string> const& occ_symbols) {
+void BacktestDataEngine::build_occ_to_option() {
     occ_to_option_.clear();
     if (!portfolio_data_) {
         return;
     }
-    const std::string under = underlying_symbol_.empty() ? "UNKNOWN" : underlying_symbol_;
-    for (std::string const& occ_sym : occ_symbols) {
-        if (occ_sym.empty()) {
-            continue;
-        }
-        std::string std_sym;
-        auto occ_it = occ_to_standard_symbol_.find(occ_sym);
-        if (occ_it != occ_to_standard_symbol_.end()) {
-            std_sym = occ_it->second;
-        } else {
-            auto [expiry, strike, opt_type] = parse_occ_symbol(occ_sym);
-            if (!expiry || !strike || !opt_type) {
-                continue;
-            }
-            std::string expiry_str = format_expiry_yyyymmdd(*expiry);
-            std::string opt_type_str = (*opt_type == utilities::OptionType::CALL) ? "CALL" : "PUT";
-            int multiplier = 100;
-            std_sym = under;
-            std_sym += "-";
-            std_sym += expiry_str;
-            std_sym += "-";
-            std_sym += opt_type_str;
-            std_sym += "-";
-            std_sym += std::to_string(static_cast<int>(*strike));
-            std_sym += "-";
-            std_sym += std::to_string(multiplier);
-            occ_to_standard_symbol_[occ_sym] = std_sym;
-        }
-        auto opt_it = portfolio_data_->options.find(std_sym);
-        if (opt_it == portfolio_data_->options.end()) {
-            continue;
+    // create_portfolio_data interned every parsable OCC symbol; the rest have no option.
+    occ_to_option_.reserve(occ_to_standard_.size());
+    for (auto const& [occ_id, standard_id] : occ_to_standard_) {
+        if (utilities::OptionData* opt = portfolio_data_->find_option(standard_id)) {
+            occ_to_option_[occ_id] = opt;
         }
-        occ_to_option_[occ_sym] = &opt_it->second;
     }
 }
 
+void BacktestDataEngine::resolve_row_slots() {
+    loader_->resolve_row_slots([this](std::string_view occ_sym) -> int32_t {
+        auto opt_it = occ_to_option_.find(utilities::find_symbol(occ_sym));
+        if (opt_it == occ_to_option_.end()) {
+            return -1;
+        }
+        auto idx_it = option_apply_index_.find(opt_it->second);
+        return idx_it == option_apply_index_.end() ? -1 : static_cast<int32_t>(idx_it->second);
+    });
+}
+
 auto BacktestDataEngine::build_snapshot_from_frame(TimestepFrameColumnar const& frame,
                                                    utilities::PortfolioSnapshot const* prev)
     -> utilities::PortfolioSnapshot {
     utilities::PortfolioSnapshot snapshot;
+    fill_snapshot_from_frame(frame, prev, snapshot);
+    return snapshot;
+}
+
+void BacktestDataEngine::fill_snapshot_from_frame(TimestepFrameColumnar const& frame,
+                                                  utilities::PortfolioSnapshot const* prev,
+                                                  utilities::PortfolioSnapshot& snapshot) const {
+    snapshot.has_greeks = false;
+    snapshot.sparse = false;
+    snapshot.slots.clear();
+    snapshot.datetime = frame.timestamp;
     if (frame.num_rows <= 0 || !portfolio_data_) {
-        return snapshot;
+        for (auto* v : {&snapshot.bid, &snapshot.ask, &snapshot.last, &snapshot.bid_sz,
+                        &snapshot.ask_sz, &snapshot.delta, &snapshot.gamma, &snapshot.theta,
+                        &snapshot.vega, &snapshot.iv}) {
+            v->clear();
+        }
+        snapshot.underlying_bid = snapshot.underlying_ask = snapshot.underlying_last = 0.0;
+        snapshot.underlying_bid_sz = snapshot.underlying_ask_sz = 0.0;
+        return;
     }
     const size_t n_opt = portfolio_data_->option_apply_order().size();
     snapshot.portfolio_name = portfolio_data_->name;
-    snapshot.datetime = frame.timestamp;
-    snapshot.bid.resize(n_opt, 0.0);
-    snapshot.ask.resize(n_opt, 0.0);
-    snapshot.last.resize(n_opt, 0.0);
-    snapshot.delta.resize(n_opt, 0.0);
-    snapshot.gamma.resize(n_opt, 0.0);
-    snapshot.theta.resize(n_opt, 0.0);
-    snapshot.vega.resize(n_opt, 0.0);
-    snapshot.iv.resize(n_opt, 0.0);
-
-    if ((prev != nullptr) && prev->bid.size() == n_opt) {
+    if (sparse_snapshots_) {
+        // Only this frame's rows; Greek vectors stay empty (apply_frame computes them).
+        snapshot.sparse = true;
+        for (auto* v : {&snapshot.bid, &snapshot.ask, &snapshot.last, &snapshot.bid_sz,
+                        &snapshot.ask_sz, &snapshot.delta, &snapshot.gamma, &snapshot.theta,
+                        &snapshot.vega, &snapshot.iv}) {
+            v->clear();
+        }
+        for (auto* v : {&snapshot.bid, &snapshot.ask, &snapshot.last, &snapshot.bid_sz,
+                        &snapshot.ask_sz}) {
+            v->reserve(static_cast<size_t>(frame.num_rows));
+        }
+        snapshot.slots.reserve(static_cast<size_t>(frame.num_rows));
+    } else if ((prev != nullptr) && !prev->sparse && prev->bid.size() == n_opt &&
+               prev->bid_sz.size() == n_opt) {
         snapshot.bid = prev->bid;
         snapshot.ask = prev->ask;
         snapshot.last = prev->last;
+        snapshot.bid_sz = prev->bid_sz;
+        snapshot.ask_sz = prev->ask_sz;
+    } else {
+        for (auto* v : {&snapshot.bid, &snapshot.ask, &snapshot.last, &snapshot.bid_sz,
+                        &snapshot.ask_sz}) {
+            v->assign(n_opt, 0.0);
+        }
+    }
+    if (!snapshot.sparse) {
+        snapshot.delta.assign(n_opt, 0.0);
+        snapshot.gamma.assign(n_opt, 0.0);
+        snapshot.theta.assign(n_opt, 0.0);
+        snapshot.vega.assign(n_opt, 0.0);
+        snapshot.iv.assign(n_opt, 0.0);
     }
 
-    double u_bid = 0.0;
-    double u_ask = 0.0;
+    snapshot.underlying_bid_sz = snapshot.underlying_ask_sz = 0.0;
+    apply_frame_rows(frame, 0.0, 0.0, snapshot);
+}
+
+void BacktestDataEngine::merge_frame_into_snapshot(TimestepFrameColumnar const& frame,
+                                                   utilities::PortfolioSnapshot& snapshot) const {
+    if (frame.num_rows <= 0 || !portfolio_data_) {
+        return;
+    }
+    // Later quotes in the bar overwrite earlier ones (sparse: appended, applied in order).
+    snapshot.datetime = frame.timestamp;
+    snapshot.has_greeks = false;
+    apply_frame_rows(frame, snapshot.underlying_bid, snapshot.underlying_ask, snapshot);
+}
+
+void BacktestDataEngine::apply_frame_rows(TimestepFrameColumnar const& frame, double u_bid,
+                                          double u_ask, utilities::PortfolioSnapshot& snapshot) {
     for (int64_t r = 0; r < frame.num_rows; ++r) {
         const int64_t i = frame.row_index(r);
         if ((frame.arr_underlying_bid_px != nullptr) && !frame.arr_underlying_bid_px->IsNull(i)) {
@@ -238,49 +575,220 @@ auto BacktestDataEngine::build_snapshot_from_frame(TimestepFrameColumnar const&
         if ((frame.arr_underlying_ask_px != nullptr) && !frame.arr_underlying_ask_px->IsNull(i)) {
             u_ask = get_double<double>(frame.arr_underlying_ask_px, i);
         }
-        std::string symbol = get_symbol(frame.arr_sym, i);
-        if (symbol.empty()) {
-            continue;
+        if ((frame.arr_underlying_bid_sz != nullptr) && !frame.arr_underlying_bid_sz->IsNull(i)) {
+            snapshot.underlying_bid_sz = get_size(frame.arr_underlying_bid_sz, i);
         }
-        auto opt_it = occ_to_option_.find(symbol);
-        if (opt_it == occ_to_option_.end()) {
-            continue;
+        if ((frame.arr_underlying_ask_sz != nullptr) && !frame.arr_underlying_ask_sz->IsNull(i)) {
+            snapshot.underlying_ask_sz = get_size(frame.arr_underlying_ask_sz, i);
         }
-        utilities::OptionData* opt = opt_it->second;
-        auto idx_it = option_apply_index_.find(opt);
-        if (idx_it == option_apply_index_.end()) {
+        const int32_t slot = frame.row_slot != nullptr ? frame.row_slot[i] : -1;
+        if (slot < 0) {
             continue;
         }
-        const size_t idx = idx_it->second;
+        const auto idx = static_cast<size_t>(slot);
         const double bid = ((frame.arr_bid_px != nullptr) && !frame.arr_bid_px->IsNull(i))
                                ? get_double<double>(frame.arr_bid_px, i)
                                : 0.0;
         const double ask = ((frame.arr_ask_px != nullptr) && !frame.arr_ask_px->IsNull(i))
                                ? get_double<double>(frame.arr_ask_px, i)
                                : 0.0;
+        const double last = (bid > 0.0 && ask > 0.0) ? 0.5 * (bid + ask) : (bid > 0.0 ? bid : ask);
+        const double bid_sz = get_size(frame.arr_bid_sz, i);
+        const double ask_sz = get_size(frame.arr_ask_sz, i);
+        if (snapshot.sparse) {
+            snapshot.slots.push_back(static_cast<uint32_t>(idx));
+            snapshot.bid.push_back(bid);
+            snapshot.ask.push_back(ask);
+            snapshot.last.push_back(last);
+            snapshot.bid_sz.push_back(bid_sz);
+            snapshot.ask_sz.push_back(ask_sz);
+            continue;
+        }
         snapshot.bid[idx] = bid;
         snapshot.ask[idx] = ask;
-        snapshot.last[idx] = (bid > 0.0 && ask > 0.0) ? 0.5 * (bid + ask) : (bid > 0.0 ? bid : ask);
+        snapshot.last[idx] = last;
+        snapshot.bid_sz[idx] = bid_sz;
+        snapshot.ask_sz[idx] = ask_sz;
     }
 
     snapshot.underlying_bid = u_bid;
     snapshot.underlying_ask = u_ask;
     snapshot.underlying_last =
         (u_bid > 0.0 && u_ask > 0.0) ? 0.5 * (u_bid + u_ask) : (u_bid > 0.0 ? u_bid : u_ask);
-    return snapshot;
 }
 
 void BacktestDataEngine::precompute_snapshots() {
     snapshots_.clear();
-    if (!loader_ || !loaded_ || !portfolio_data_) {
+    snapshot_rows_.clear();
+    if (!loader_ || !loaded_ || !portfolio_data_ || streaming_ || cache_ || source_ != nullptr) {
         return;
     }
     loader_->iter_timesteps([this](TimestepFrameColumnar const& frame) -> bool {
+        if (!snapshots_.empty() && same_bar(snapshots_.back().datetime, frame.timestamp)) {
+            merge_frame_into_snapshot(frame, snapshots_.back());
+            snapshot_rows_.back() += frame.num_rows;
+            return true;
+        }
         utilities::PortfolioSnapshot const* prev =
             snapshots_.empty() ? nullptr : &snapshots_.back();
         snapshots_.push_back(build_snapshot_from_frame(frame, prev));
+        snapshot_rows_.push_back(frame.num_rows);
         return true;
     });
+    precompute_greeks();
+}
+
+void BacktestDataEngine::precompute_greeks() {
+    if (!precompute_greeks_ || sparse_snapshots_ || !portfolio_data_ ||
+        std::ranges::all_of(snapshots_, &utilities::PortfolioSnapshot::has_greeks)) {
+        return;
+    }
+    // Consecutive timesteps per chunk so each chunk's IV warm start carries frame to frame.
+    const utilities::PortfolioData& pd = *portfolio_data_;
+    utilities::ThreadPool::shared().parallel_for(
+        snapshots_.size(),
+        [this, &pd](size_t begin, size_t end) -> void {
+            utilities::SnapshotIvWarm warm;
+            for (size_t i = begin; i < end; ++i) {
+                pd.compute_snapshot_greeks(snapshots_[i], warm);
+            }
+        },
+        16);
+}
+
+void BacktestDataEngine::for_each_snapshot(SnapshotCallback const& fn) {
+    if (!loaded_) {
+        return;
+    }
+    if (source_ != nullptr) {
+        source_->replay_snapshots(fn);
+        return;
+    }
+    if (streaming_ && portfolio_data_) {
+        stream_snapshots(fn);
+        return;
+    }
+    replay_snapshots(fn);
+}
+
+void BacktestDataEngine::replay_snapshots(SnapshotCallback const& fn) const {
+    if (cache_) {
+        // One reusable snapshot filled from the mapping per frame; Greeks only while still valid.
+        utilities::PortfolioSnapshot snapshot;
+        for (size_t i = 0; i < cache_->frame_count(); ++i) {
+            cache_->fill(i, portfolio_data_->name, cache_greeks_valid_, snapshot);
+            if (!fn(cache_->timestamp(i), cache_->num_rows(i), snapshot)) {
+                break;
+            }
+        }
+        return;
+    }
+    for (size_t i = 0; i < snapshots_.size(); ++i) {
+        if (!fn(snapshots_[i].datetime, snapshot_rows_[i], snapshots_[i])) {
+            break;
+        }
+    }
+}
+
+void BacktestDataEngine::stream_snapshots(SnapshotCallback const& fn) {
+    // The producer only reads portfolio state fixed at load (apply order, strikes, expiries), so
+    // it can run alongside apply_frame on the consumer side.
+    // Greeks only for the chains active when the run starts (strategies subscribe in on_init);
+    // apply_frame solves a chain that becomes active later itself.
+    const utilities::ChainScope scope =
+        portfolio_data_->chain_scope(portfolio_data_->active_chains());
+    SnapshotRing ring(stream_ring_size_);
+    std::exception_ptr producer_error;
+    std::jthread producer([this, &ring, &producer_error, &scope] {
+        try {
+            utilities::SnapshotIvWarm warm;
+            // With bars the open slot keeps absorbing frames until one lands in the next bucket.
+            StreamSlot* open = nullptr;
+            const auto publish = [this, &ring, &warm, &open, &scope] {
+                portfolio_data_->compute_snapshot_greeks(open->snapshot, warm, &scope);
+                ring.end_write();
+                open = nullptr;
+            };
+            loader_->iter_timesteps(
+                [this, &ring, &open, &publish](TimestepFrameColumnar const& frame) -> bool {
+                    if (open != nullptr && same_bar(open->timestamp, frame.timestamp)) {
+                        merge_frame_into_snapshot(frame, open->snapshot);
+                        open->timestamp = frame.timestamp;
+                        open->num_rows += frame.num_rows;
+                        return true;
+                    }
+                    if (open != nullptr) {
+                        publish();
+                    }
+                    const StreamSlot* prev = ring.last_written();
+                    open = ring.begin_write();
+                    if (open == nullptr) {
+                        return false;
+                    }
+                    open->timestamp = frame.timestamp;
+                    open->num_rows = frame.num_rows;
+                    fill_snapshot_from_frame(frame, prev != nullptr ? &prev->snapshot : nullptr,
+                                             open->snapshot);
+                    if (bar_.count() <= 0) {
+                        publish();
+                    }
+                    return true;
+                });
+            if (open != nullptr) {
+                publish();
+            }
+        } catch (...) {
+            producer_error = std::current_exception();
+        }
+        ring.close();
+    });
+    try {
+        while (const StreamSlot* slot = ring.begin_read()) {
+            const bool more = fn(slot->timestamp, slot->num_rows, slot->snapshot);
+            ring.end_read();
+            if (!more) {
+                break;
+            }
+        }
+    } catch (...) {
+        ring.cancel();
+        throw;
+    }
+    ring.cancel();
+    producer.join();
+    if (producer_error) {
+        std::rethrow_exception(producer_error);
+    }
+}
+
+BacktestDataEngine::SnapshotCursor::SnapshotCursor(BacktestDataEngine const& engine)
+    : engine_(&engine) {
+    if (engine.loader_ && engine.loaded_ && engine.source_ == nullptr && !engine.cache_) {
+        frames_.emplace(*engine.loader_);
+        pending_ = frames_->next();
+    }
+}
+
+auto BacktestDataEngine::SnapshotCursor::peek() const -> std::optional<Timestamp> {
+    return pending_ != nullptr ? std::optional<Timestamp>(pending_->timestamp) : std::nullopt;
+}
+
+auto BacktestDataEngine::SnapshotCursor::advance() -> bool {
+    if (pending_ == nullptr) {
+        return false;
+    }
+    engine_->fill_snapshot_from_frame(*pending_, built_ ? &snapshot_ : nullptr, snapshot_);
+    built_ = true;
+    timestamp_ = pending_->timestamp;
+    num_rows_ = pending_->num_rows;
+    // With bars the step keeps absorbing frames until one lands in the next bucket.
+    while ((pending_ = frames_->next()) != nullptr &&
+           engine_->same_bar(timestamp_, pending_->timestamp)) {
+        engine_->merge_frame_into_snapshot(*pending_, snapshot_);
+        timestamp_ = pending_->timestamp;
+        num_rows_ += pending_->num_rows;
+    }
+    return true;
 }
 
 void BacktestDataEngine::apply_precomputed_snapshot(size_t i) {
@@ -303,9 +811,8 @@ void BacktestDataEngine::build_portfolio_from_symbols(std::vector<std::string> c
 void BacktestDataEngine::create_portfolio_data(std::vector<std::string> const& symbols,
                                                std::optional<utilities::DateTime> dte_ref) {
     std::string under = underlying_symbol_.empty() ? "UNKNOWN" : underlying_symbol_;
-    // Portfolio name "backtest", avoid filename/underlying inference
-    std::string name = "backtest";
-    portfolio_data_ = std::make_unique<utilities::PortfolioData>(name);
+    // Portfolio name "backtest" unless set (multi-source runs name theirs by underlying).
+    portfolio_data_ = std::make_unique<utilities::PortfolioData>(portfolio_name_);
     if (dte_ref.has_value()) {
         portfolio_data_->set_dte_ref(*dte_ref);
     }
@@ -326,44 +833,73 @@ void BacktestDataEngine::create_portfolio_data(std::vector<std::string> const& s
         static_cast<MainEngine*>(main_engine)->register_contract(underlying_contract);
     }
 
-    int option_count = 0;
+    // One pass over the universe: packed keys sort by expiry, so each chain is one run.
+    std::vector<std::pair<OccKey, std::string const*>> keyed;
+    keyed.reserve(symbols.size());
     for (auto const& sym : symbols) {
-        auto [expiry, strike, opt_type] = parse_occ_symbol(sym);
-        if (!expiry || !strike || !opt_type) {
-            continue;
+        if (const std::optional<OccKey> key = parse_occ_key(sym)) {
+            keyed.emplace_back(*key, &sym);
+        }
+    }
+    std::ranges::sort(keyed, {}, &std::pair<OccKey, std::string const*>::first);
+    std::vector<std::pair<size_t, size_t>> runs;
+    for (size_t i = 0; i < keyed.size();) {
+        size_t j = i + 1;
+        while (j < keyed.size() &&
+               keyed[j].first.expiry_yyyymmdd() == keyed[i].first.expiry_yyyymmdd()) {
+            ++j;
+        }
+        runs.emplace_back(i, j);
+        i = j;
+    }
+
+    // Contracts of each chain built in parallel; symbol interning is thread-safe.
+    constexpr int multiplier = 100;
+    std::vector<std::vector<utilities::ContractData>> groups(runs.size());
+    std::vector<std::vector<std::pair<utilities::SymbolId, utilities::SymbolId>>> occ_ids(
+        runs.size());
+    utilities::ThreadPool::shared().parallel_for(
+        runs.size(),
+        [&](size_t begin, size_t end) -> void {
+            for (size_t g = begin; g < end; ++g) {
+                const auto [first, last] = runs[g];
+                groups[g].reserve(last - first);
+                occ_ids[g].reserve(last - first);
+                for (size_t i = first; i < last; ++i) {
+                    const OccKey key = keyed[i].first;
+                    std::string const& sym = *keyed[i].second;
+                    utilities::ContractData& option_contract = groups[g].emplace_back();
+                    option_contract.gateway_name = "BacktestData";
+                    option_contract.symbol = occ_standard_symbol(under, key, multiplier);
+                    option_contract.exchange = utilities::Exchange::LOCAL;
+                    option_contract.name = sym;
+                    option_contract.product = utilities::Product::OPTION;
+                    option_contract.size = static_cast<double>(multiplier);
+                    option_contract.pricetick = 0.01;
+                    option_contract.option_strike = key.strike();
+                    option_contract.option_type = key.option_type();
+                    option_contract.option_expiry = key.expiry();
+                    option_contract.option_underlying = under;
+                    option_contract.option_index = std::to_string(key.strike_thousandths() / 1000);
+                    occ_ids[g].emplace_back(utilities::intern_symbol(sym),
+                                            utilities::intern_symbol(option_contract.symbol));
+                }
+            }
+        },
+        1);
+
+    portfolio_data_->add_chain_options(groups);
+    occ_to_standard_.reserve(occ_to_standard_.size() + keyed.size());
+    for (size_t g = 0; g < groups.size(); ++g) {
+        for (auto const& [occ_id, standard_id] : occ_ids[g]) {
+            occ_to_standard_[occ_id] = standard_id;
         }
-        std::string expiry_str = format_expiry_yyyymmdd(*expiry);
-        std::string opt_type_str = (*opt_type == utilities::OptionType::CALL) ? "CALL" : "PUT";
-        int multiplier = 100;
-        std::string standard_symbol = under;
-        standard_symbol += "-";
-        standard_symbol += expiry_str;
-        standard_symbol += "-";
-        standard_symbol += opt_type_str;
-        standard_symbol += "-";
-        standard_symbol += std::to_string(static_cast<int>(*strike));
-        standard_symbol += "-";
-        standard_symbol += std::to_string(multiplier);
-
-        utilities::ContractData option_contract;
-        option_contract.gateway_name = "BacktestData";
-        option_contract.symbol = standard_symbol;
-        option_contract.exchange = utilities::Exchange::LOCAL;
-        option_contract.name = sym;
-        option_contract.product = utilities::Product::OPTION;
-        option_contract.size = static_cast<double>(multiplier);
-        option_contract.pricetick = 0.01;
-        option_contract.option_strike = strike.value();
-        option_contract.option_type = opt_type.value();
-        option_contract.option_expiry = *expiry;
-        option_contract.option_underlying = under;
-        option_contract.option_index = std::to_string(static_cast<int>(*strike));
-        portfolio_data_->add_option(option_contract);
         if (main_engine != nullptr) {
-            static_cast<MainEngine*>(main_engine)->register_contract(option_contract);
+            for (utilities::ContractData& option_contract : groups[g]) {
+                static_cast<MainEngine*>(main_engine)->register_contract(
+                    std::move(option_contract));
+            }
         }
-        occ_to_standard_symbol_[sym] = standard_symbol;
-        option_count++;
     }
 }
 
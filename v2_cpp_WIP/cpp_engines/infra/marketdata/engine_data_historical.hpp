@@ -5,10 +5,14 @@
 #include "object.hpp"
 #include "parquet_loader.hpp"
 #include "portfolio.hpp"
+#include "snapshot_cache.hpp"
 #include "types.hpp"
+#include <chrono>
 #include <concepts>
+#include <functional>
 #include <memory>
 #include <optional>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -28,10 +32,44 @@ class BacktestDataEngine : public utilities::BaseEngine {
 
     [[nodiscard]] DataMeta get_meta() const;
 
-    // Iterate timesteps; callback returns false to stop
+    /** Name the next load registers its portfolio under (default "backtest"). */
+    void set_portfolio_name(std::string name) { portfolio_name_ = std::move(name); }
+    /**
+     * Take other's pricing, snapshot and loader settings (rate, IV mode, incremental, precompute,
+     * sparse, bar, time range, sort index, cache directory); loaded data is not touched.
+     */
+    void configure_like(BacktestDataEngine const& other);
+
+    /** [start, end) for the next load_parquet; row groups outside it are never decoded. */
+    void set_time_range(std::optional<Timestamp> start, std::optional<Timestamp> end);
+    /** Keep the unsorted-file time index as <file>.tsidx across loads. */
+    void set_persist_sort_index(bool enabled);
+    /**
+     * Directory for mmap snapshot caches (empty = off). A load whose file, time range, rate,
+     * IV mode and precompute setting match a cache skips parquet decode and pricing; a miss
+     * writes one. Set the pricing config before load_parquet. Not used when streaming or sparse.
+     */
+    void set_snapshot_cache_dir(std::string dir) { snapshot_cache_dir_ = std::move(dir); }
+    /** Last load was served from the snapshot cache. */
+    [[nodiscard]] bool snapshot_cache_hit() const { return cache_ != nullptr; }
+
+    /**
+     * Iterate raw timestep frames; callback returns false to stop. A load served from the
+     * snapshot cache has no parquet table behind it: throws std::logic_error then (iterate
+     * for_each_snapshot instead) rather than silently yielding no frames.
+     */
     template <typename F>
         requires backtest::TimestepFramePredicate<F>
     void iter_timesteps(F&& fn) const {
+        if (source_ != nullptr) {
+            source_->iter_timesteps(std::forward<F>(fn));
+            return;
+        }
+        if (cache_) {
+            throw std::logic_error(
+                "iter_timesteps: load was served from the snapshot cache (no raw frames); "
+                "use for_each_snapshot");
+        }
         if (!loader_ || !loaded_) {
             return;
         }
@@ -42,14 +80,58 @@ class BacktestDataEngine : public utilities::BaseEngine {
 
     void set_risk_free_rate(double rate);
     void set_iv_price_mode(std::string mode);
+    /** Forwarded to PortfolioData::set_incremental (dirty-tracked apply_frame). */
+    void set_incremental(bool enabled, double price_epsilon, double tau_epsilon);
+    /**
+     * Fill snapshot IV/Greeks once, parallel across timesteps, so apply_frame only copies them.
+     * Re-run on load and when the rate or IV mode changes while enabled.
+     */
+    void set_precompute_greeks(bool enabled);
+    /**
+     * Streaming: no snapshots_ kept; for_each_snapshot builds each snapshot (with Greeks) on a
+     * producer thread into a ring of ring_size reusable buffers (min 2), so memory stays flat.
+     * Set before load_parquet to avoid materializing at load; switching after load frees or
+     * rebuilds snapshots_.
+     */
+    void set_streaming(bool enabled, size_t ring_size = 4);
+    [[nodiscard]] bool streaming() const { return streaming_; }
+    /**
+     * Sparse snapshots: each frame carries only its (slot, bid, ask, last) updates instead of the
+     * full carried-forward quote vectors. No precomputed Greeks; apply_frame computes them.
+     */
+    void set_sparse_snapshots(bool enabled);
+    [[nodiscard]] bool sparse_snapshots() const { return sparse_snapshots_; }
+    /**
+     * Resample to bars of this length (0 = every distinct timestamp): frames in one bucket merge
+     * into a single snapshot holding each contract's last quote, stamped with the bucket's last
+     * timestamp, so steps and Greeks scale with the bar count. Set before load_parquet.
+     */
+    void set_bar_interval(std::chrono::nanoseconds bar);
+    [[nodiscard]] std::chrono::nanoseconds bar_interval() const { return bar_; }
     [[nodiscard]] double risk_free_rate() const { return risk_free_rate_; }
     [[nodiscard]] const std::string& iv_price_mode() const { return iv_price_mode_; }
 
     [[nodiscard]] std::optional<BacktestPortfolio> const& portfolio() const { return portfolio_; }
-    [[nodiscard]] bool has_data() const { return loader_ != nullptr && loaded_; }
+    [[nodiscard]] bool has_data() const { return loaded_; }
     utilities::PortfolioData* portfolio_data() const { return portfolio_data_.get(); }
 
-    /** Precomputed snapshots (one per frame). */
+    using SnapshotCallback = std::function<bool(Timestamp, int64_t num_rows,
+                                                utilities::PortfolioSnapshot const&)>;
+    /**
+     * Each timestep with its snapshot (precomputed, or streamed one ring ahead); fn returns false
+     * to stop. The snapshot reference is only valid during the call.
+     */
+    void for_each_snapshot(SnapshotCallback const& fn);
+    /**
+     * Share source's loaded data instead of loading: own PortfolioData built from the same
+     * universe and pricing config, snapshots replayed read-only from source (which must outlive
+     * this engine and not be streaming). Used by parameter sweeps.
+     */
+    void attach(BacktestDataEngine const& source);
+    /** Replay materialized snapshots (precomputed or cached) without touching engine state. */
+    void replay_snapshots(SnapshotCallback const& fn) const;
+
+    /** Precomputed snapshots (one per frame; none while streaming or served from cache). */
     [[nodiscard]] size_t get_precomputed_snapshot_count() const { return snapshots_.size(); }
     [[nodiscard]] utilities::PortfolioSnapshot const& get_precomputed_snapshot(size_t i) const {
         return snapshots_.at(i);
@@ -57,31 +139,109 @@ class BacktestDataEngine : public utilities::BaseEngine {
     /** Apply precomputed snapshot. */
     void apply_precomputed_snapshot(size_t i);
 
+    /**
+     * Pull-side snapshot building for a multi-source merge (MultiSourceDataEngine): advance()
+     * builds the next timestep, or bar, into one reused snapshot on the calling thread, carrying
+     * quotes forward like the streaming producer. Needs a parquet load (not attached or cached);
+     * Greeks are left to apply_frame.
+     */
+    class SnapshotCursor {
+      public:
+        explicit SnapshotCursor(BacktestDataEngine const& engine);
+        /** Time of the next frame; nullopt once exhausted. */
+        [[nodiscard]] std::optional<Timestamp> peek() const;
+        /** Build the next step into snapshot(); false once exhausted. */
+        bool advance();
+        [[nodiscard]] utilities::PortfolioSnapshot const& snapshot() const { return snapshot_; }
+        /** Last frame time and total rows of the step built by advance(). */
+        [[nodiscard]] Timestamp timestamp() const { return timestamp_; }
+        [[nodiscard]] int64_t num_rows() const { return num_rows_; }
+
+      private:
+        BacktestDataEngine const* engine_;
+        std::optional<ArrowParquetLoader::FrameCursor> frames_;
+        TimestepFrameColumnar const* pending_ = nullptr;
+        utilities::PortfolioSnapshot snapshot_;
+        bool built_ = false;
+        Timestamp timestamp_{};
+        int64_t num_rows_ = 0;
+    };
+    /** Start of the bar t falls in (t itself when not resampling). */
+    [[nodiscard]] Timestamp bar_start(Timestamp t) const;
+
   private:
     void build_portfolio_from_symbols(std::vector<std::string> const& symbols);
     void create_portfolio_data(std::vector<std::string> const& symbols,
                                std::optional<utilities::DateTime> dte_ref = std::nullopt);
     void build_option_apply_index();
-    /** OCC symbol -> OptionData*. */
-    void build_occ_to_option(std::unordered_set<std::string> const& occ_symbols);
+    /** OCC symbol -> OptionData* (from occ_to_standard_). */
+    void build_occ_to_option();
+    /** Loader row -> apply-order slot column, so snapshot building does no string work. */
+    void resolve_row_slots();
     /** Build snapshot from frame; prev keeps last state. */
     utilities::PortfolioSnapshot
     build_snapshot_from_frame(TimestepFrameColumnar const& frame,
                               utilities::PortfolioSnapshot const* prev = nullptr);
+    /** build_snapshot_from_frame into out, reusing its buffers; prev may be &out. */
+    void fill_snapshot_from_frame(TimestepFrameColumnar const& frame,
+                                  utilities::PortfolioSnapshot const* prev,
+                                  utilities::PortfolioSnapshot& out) const;
+    /** Rows of frame merged onto snapshot (a later frame of the same bar). */
+    void merge_frame_into_snapshot(TimestepFrameColumnar const& frame,
+                                   utilities::PortfolioSnapshot& snapshot) const;
+    /** Write frame's quotes into snapshot; underlying starts from (u_bid, u_ask). */
+    static void apply_frame_rows(TimestepFrameColumnar const& frame, double u_bid, double u_ask,
+                                 utilities::PortfolioSnapshot& snapshot);
+    /** a and b fall in the same bar (false when not resampling). */
+    [[nodiscard]] bool same_bar(Timestamp a, Timestamp b) const;
+    /** Producer thread + ring behind for_each_snapshot in streaming mode. */
+    void stream_snapshots(SnapshotCallback const& fn);
     void precompute_snapshots();
+    /** Fill snapshots lacking has_greeks (no-op unless enabled). */
+    void precompute_greeks();
+    void invalidate_greeks();
+    /** Serve load_parquet from the snapshot cache; false on miss or mismatch. */
+    bool load_from_snapshot_cache(std::string const& path, uint64_t key);
+    void write_snapshot_cache(std::string const& path, uint64_t key, DataMeta const& meta) const;
+    /** PortfolioData for symbols_ / dte_ref_ with the current pricing config. */
+    void build_portfolio_state();
 
     std::unique_ptr<ArrowParquetLoader> loader_;
     bool loaded_ = false;
+    /** attach() source; snapshots come from there. */
+    BacktestDataEngine const* source_ = nullptr;
+    /** Sorted OCC universe and DTE reference of the last load (for attach and the cache). */
+    std::vector<std::string> symbols_;
+    std::optional<utilities::DateTime> dte_ref_;
     std::string time_column_;
     std::string underlying_symbol_;
+    std::string portfolio_name_ = "backtest";
     std::optional<BacktestPortfolio> portfolio_;
     std::unique_ptr<utilities::PortfolioData> portfolio_data_;
-    std::unordered_map<std::string, std::string> occ_to_standard_symbol_;
-    /** OCC -> OptionData* (load). */
-    std::unordered_map<std::string, utilities::OptionData*> occ_to_option_;
+    /** Interned OCC symbol -> interned standard symbol (create_portfolio_data). */
+    std::unordered_map<utilities::SymbolId, utilities::SymbolId> occ_to_standard_;
+    /** Interned OCC symbol -> OptionData* (load). */
+    std::unordered_map<utilities::SymbolId, utilities::OptionData*> occ_to_option_;
     double risk_free_rate_ = 0.05;
     std::string iv_price_mode_ = "mid";
+    bool incremental_ = false;
+    double incremental_price_eps_ = 0.0;
+    double incremental_tau_eps_ = utilities::PortfolioData::kDefaultTauEpsilon;
+    bool precompute_greeks_ = false;
+    bool sparse_snapshots_ = false;
+    bool streaming_ = false;
+    size_t stream_ring_size_ = 4;
+    std::chrono::nanoseconds bar_{0};
     std::vector<utilities::PortfolioSnapshot> snapshots_;
+    /** Row count per snapshots_ frame (kept for the snapshot cache). */
+    std::vector<int64_t> snapshot_rows_;
+    std::optional<Timestamp> range_start_;
+    std::optional<Timestamp> range_end_;
+    bool persist_sort_index_ = false;
+    std::string snapshot_cache_dir_;
+    std::unique_ptr<SnapshotCache> cache_;
+    /** Cached Greeks match the current rate / IV mode. */
+    bool cache_greeks_valid_ = false;
     std::unordered_map<utilities::OptionData*, size_t> option_apply_index_;
 };
 
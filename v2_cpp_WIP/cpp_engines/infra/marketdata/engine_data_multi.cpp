@@ -0,0 +1,114 @@
+#include "engine_data_multi.hpp"
+#include "engine_main.hpp"
+#include "occ_utils.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+
+namespace backtest {
+
+MultiSourceDataEngine::MultiSourceDataEngine(MainEngine* main_engine)
+    : utilities::BaseEngine(main_engine, "MultiSourceDataEngine") {}
+
+void MultiSourceDataEngine::load(std::vector<std::string> const& paths,
+                                 BacktestDataEngine const& config,
+                                 std::vector<std::string> const& underlyings) {
+    sources_.clear();
+    portfolios_.clear();
+    std::vector<std::string> names;
+    std::unordered_set<std::string> seen;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        std::string underlying = i < underlyings.size() ? underlyings[i] : std::string{};
+        if (underlying.empty()) {
+            underlying = infer_underlying_from_filename(paths[i]);
+        }
+        if (!seen.insert(underlying).second) {
+            throw std::runtime_error("Synchronized backtest needs one file per underlying; " +
+                                     underlying + " appears twice");
+        }
+        names.push_back(std::move(underlying));
+    }
+    auto* main = static_cast<MainEngine*>(main_engine);
+    for (size_t i = 0; i < paths.size(); ++i) {
+        auto source = std::make_unique<BacktestDataEngine>(main);
+        source->configure_like(config);
+        // Snapshots are built step by step from cursors, so nothing is materialized at load.
+        source->set_streaming(true);
+        source->set_portfolio_name(i == 0 ? std::string("backtest") : names[i]);
+        source->load_parquet(paths[i], "ts_recv", names[i]);
+        if (utilities::PortfolioData* portfolio = source->portfolio_data()) {
+            portfolios_.push_back(portfolio);
+        }
+        if (has_main()) {
+            write_log("Synchronized source " + names[i] + " loaded from: " + paths[i], 20);
+        }
+        sources_.push_back(std::move(source));
+    }
+}
+
+auto MultiSourceDataEngine::has_data() const -> bool {
+    return !sources_.empty() && portfolios_.size() == sources_.size() &&
+           std::ranges::all_of(sources_, [](const auto& s) { return s->has_data(); });
+}
+
+void MultiSourceDataEngine::for_each_step(StepCallback const& fn) {
+    if (!has_data()) {
+        return;
+    }
+    // Deque: cursors hold pointers into themselves, so they must never move.
+    std::deque<BacktestDataEngine::SnapshotCursor> cursors;
+    using Key = std::pair<Timestamp, size_t>;
+    std::priority_queue<Key, std::vector<Key>, std::greater<>> heap;
+    for (size_t i = 0; i < sources_.size(); ++i) {
+        cursors.emplace_back(*sources_[i]);
+        if (const auto t = cursors.back().peek()) {
+            heap.emplace(sources_[i]->bar_start(*t), i);
+        }
+    }
+    std::vector<size_t> due;
+    std::vector<const utilities::PortfolioSnapshot*> snapshots;
+    due.reserve(sources_.size());
+    snapshots.reserve(sources_.size());
+    while (!heap.empty()) {
+        const Timestamp key = heap.top().first;
+        due.clear();
+        while (!heap.empty() && heap.top().first == key) {
+            due.push_back(heap.top().second);
+            heap.pop();
+        }
+        // Each source builds from its own loader into its own snapshot: nothing shared.
+        if (due.size() == 1) {
+            cursors[due.front()].advance();
+        } else {
+            utilities::ThreadPool::shared().parallel_for(
+                due.size(),
+                [&cursors, &due](size_t begin, size_t end) -> void {
+                    for (size_t k = begin; k < end; ++k) {
+                        cursors[due[k]].advance();
+                    }
+                },
+                1);
+        }
+        Timestamp ts = cursors[due.front()].timestamp();
+        int64_t num_rows = 0;
+        snapshots.clear();
+        for (const size_t i : due) {
+            ts = std::max(ts, cursors[i].timestamp());
+            num_rows += cursors[i].num_rows();
+            snapshots.push_back(&cursors[i].snapshot());
+            if (const auto t = cursors[i].peek()) {
+                heap.emplace(sources_[i]->bar_start(*t), i);
+            }
+        }
+        if (!fn(ts, num_rows, snapshots)) {
+            break;
+        }
+    }
+}
+
+} // namespace backtest
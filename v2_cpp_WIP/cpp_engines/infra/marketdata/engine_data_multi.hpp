@@ -0,0 +1,63 @@
+#pragma once
+
+/**
+ * MultiSourceDataEngine: several parquet files, one underlying each, replayed on one clock for
+ * cross-underlying backtests. Every file gets its own BacktestDataEngine and PortfolioData: the
+ * first is the strategy's portfolio ("backtest", as in a single-file run), the others register
+ * under their underlying symbol. Timesteps are merged across files with a k-way heap on frame
+ * time (bar start when resampling); the files with data at a timestep build their snapshots in
+ * parallel, and a file without data there keeps its last quotes.
+ */
+
+#include "../../utilities/base_engine.hpp"
+#include "engine_data_historical.hpp"
+#include "object.hpp"
+#include "portfolio.hpp"
+#include "types.hpp"
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace backtest {
+
+class MainEngine;
+
+class MultiSourceDataEngine : public utilities::BaseEngine {
+  public:
+    explicit MultiSourceDataEngine(MainEngine* main_engine = nullptr);
+
+    /**
+     * Load paths with config's pricing, snapshot and loader settings; underlyings (same order,
+     * empty = infer from the file name) name the portfolios after the first. Snapshots are
+     * always built as the run goes (no precompute, snapshot cache or sweeps). Throws
+     * std::runtime_error if two files share an underlying.
+     */
+    void load(std::vector<std::string> const& paths, BacktestDataEngine const& config,
+              std::vector<std::string> const& underlyings = {});
+    /** Every file loaded with rows. */
+    [[nodiscard]] bool has_data() const;
+    [[nodiscard]] size_t source_count() const { return sources_.size(); }
+    [[nodiscard]] BacktestDataEngine* source(size_t i) const { return sources_.at(i).get(); }
+    /** Portfolio of each source, the strategy's first. */
+    [[nodiscard]] std::span<const utilities::PortfolioData* const> portfolios() const {
+        return portfolios_;
+    }
+
+    using StepCallback =
+        std::function<bool(Timestamp, int64_t num_rows,
+                           std::span<const utilities::PortfolioSnapshot* const> snapshots)>;
+    /**
+     * Each merged timestep with the snapshots of the sources that had data at it, stamped with
+     * the latest of their frame times; fn returns false to stop. Snapshots are valid only during
+     * the call.
+     */
+    void for_each_step(StepCallback const& fn);
+
+  private:
+    std::vector<std::unique_ptr<BacktestDataEngine>> sources_;
+    std::vector<const utilities::PortfolioData*> portfolios_;
+};
+
+} // namespace backtest
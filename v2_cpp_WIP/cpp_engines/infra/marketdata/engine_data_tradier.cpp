@@ -2,10 +2,14 @@
 
 #include "engine_data_tradier.hpp"
 #include "../../utilities/event.hpp"
+#include "../../utilities/latency.hpp"
+#include "../../utilities/thread_pool.hpp"
+#include "http_multi.hpp"
 #include <algorithm>
+#include <array>
+#include <charconv>
 #include <chrono>
 #include <cmath>
-#include <curl/curl.h>
 #include <format>
 #include <iomanip>
 #include <iterator>
@@ -14,6 +18,7 @@
 #include <span>
 #include <sstream>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 using json = nlohmann::json;
@@ -73,39 +78,9 @@ auto underlying_symbol_for_quote(const std::string& symbol_part) -> std::string
 // Tradier API; token from TRADIER_TOKEN
 const std::string kTradierBaseUrl = "https://api.tradier.com/v1/";
 
-// HTTP
-auto curl_write_cb(char* ptr, size_t size, size_t nmemb, void* userdata) -> size_t {
-    auto* out = static_cast<std::string*>(userdata);
-    std::span<const char> bytes(ptr, size * nmemb);
-    out->append(bytes.data(), bytes.size());
-    return bytes.size();
-}
-
-auto http_get(const std::string& url, const std::string& auth_header) -> std::string {
-    std::string body;
-    CURL* curl = curl_easy_init();
-    if (curl == nullptr) {
-        return body;
-    }
-    struct curl_slist* headers = nullptr;
-    if (!auth_header.empty()) {
-        headers = curl_slist_append(headers, auth_header.c_str());
-        headers = curl_slist_append(headers, "Accept: application/json");
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    }
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, curl_write_cb);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &body);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
-    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING,
-                     ""); // auto-decompress gzip/deflate (Python requests does this)
-    CURLcode res = curl_easy_perform(curl);
-    if (headers != nullptr) {
-        curl_slist_free_all(headers);
-    }
-    curl_easy_cleanup(curl);
-    return (res == CURLE_OK) ? body : "";
-}
+// Concurrent Tradier requests per poll cycle; one keep-alive connection pool for the loop.
+constexpr size_t kTradierMaxInflight = 8;
+constexpr std::chrono::milliseconds kTradierTimeout{10000};
 
 // Safe double (null handling)
 auto json_safe_double(const json& j, const std::string& key, double def) -> double {
@@ -123,50 +98,203 @@ auto json_safe_double(const json& j, const std::string& key, double def) -> doub
     }
 }
 
-// --- Tradier JSON parsing (nlohmann) ---
-auto parse_tradier_chain_json(const std::string& body) -> std::vector<TradierOptionRaw> {
-    std::vector<TradierOptionRaw> out;
-    json data = json::parse(body);
-    json opts = data.value("options", json::object());
-    json opt_arr = opts.value("option", json::array());
-    if (!opt_arr.is_array()) {
-        if (opt_arr.is_object()) {
-            json arr = json::array();
-            for (const auto& [_, v] : opt_arr.items()) {
-                arr.push_back(v);
-            }
-            opt_arr = std::move(arr);
-        } else {
-            return out;
-        }
-    }
-    for (auto& o : opt_arr) {
-        TradierOptionRaw raw;
-        raw.symbol = o.value("symbol", std::string{});
-        raw.root_symbol = o.value("root_symbol", o.value("underlying", std::string{}));
-        raw.strike = json_safe_double(o, "strike", 0.0);
-        raw.option_type = o.value("option_type", "call");
-        raw.contract_size = static_cast<int>(json_safe_double(o, "contract_size", 100.0));
-        raw.bid = json_safe_double(o, "bid", 0.0);
-        raw.ask = json_safe_double(o, "ask", 0.0);
-        raw.last = json_safe_double(o, "last", 0.0);
-        raw.volume = json_safe_double(o, "volume", 0.0);
-        raw.open_interest = json_safe_double(o, "open_interest", 0.0);
-        out.push_back(raw);
+// Platform option symbol (ROOT-YYYYMMDD-C-2800.0-100-USD-OPT) -> OCC (ROOT YYMMDD C 02800000).
+auto occ_from_platform_symbol(std::string_view sym) -> std::string {
+    std::array<std::string_view, 4> parts;
+    size_t start = 0;
+    for (std::string_view& part : parts) {
+        const size_t dash = sym.find('-', start);
+        if (dash == std::string_view::npos) {
+            return {};
+        }
+        part = sym.substr(start, dash - start);
+        start = dash + 1;
     }
-    return out;
+    const auto& [root, date, type, strike] = parts;
+    if (root.empty() || date.size() != 8U || type.size() != 1U) {
+        return {};
+    }
+    double strike_value = 0.0;
+    if (std::from_chars(strike.data(), strike.data() + strike.size(), strike_value).ec !=
+        std::errc{}) {
+        return {};
+    }
+    const long long milli = std::llround(strike_value * 1000.0);
+    if (milli < 0 || milli > 99'999'999) {
+        return {};
+    }
+    return std::format("{}{}{}{:08d}", root, date.substr(2), type, milli);
+}
+
+auto build_occ_index(const utilities::PortfolioData& portfolio) -> OccSlotMap {
+    const std::vector<utilities::OptionData*>& order = portfolio.option_apply_order();
+    OccSlotMap index;
+    index.reserve(order.size());
+    for (size_t slot = 0; slot < order.size(); ++slot) {
+        if (order[slot] == nullptr) {
+            continue;
+        }
+        std::string occ = occ_from_platform_symbol(order[slot]->symbol);
+        if (!occ.empty()) {
+            index.emplace(std::move(occ), static_cast<uint32_t>(slot));
+        }
+    }
+    return index;
 }
 
-// Underlying quote parse
-auto parse_tradier_quote_json(const std::string& body) -> std::pair<double, double> {
+// Rounded quote; last falls back to mid (or the quoted side) when zero.
+void append_quote(TradierQuoteBuffer& out, uint32_t slot, double bid, double ask, double last) {
+    bid = round2(bid);
+    ask = round2(ask);
+    last = round2(last);
+    if (last == 0.0 && (bid != 0.0 || ask != 0.0)) {
+        last = (bid != 0.0 && ask != 0.0) ? round2(0.5 * (bid + ask))
+                                          : round2((bid != 0.0) ? bid : ask);
+    }
+    out.slots.push_back(slot);
+    out.bid.push_back(bid);
+    out.ask.push_back(ask);
+    out.last.push_back(last);
+}
+
+/**
+ * SAX handler for a chains response: reads only symbol/bid/ask/last of each
+ * {"options":{"option":[{...}]}} element (array or single object) and appends indexed options to
+ * the buffer; no DOM is built.
+ */
+class ChainQuoteSax : public nlohmann::json_sax<json> {
+  public:
+    ChainQuoteSax(const OccSlotMap& index, TradierQuoteBuffer& out) : index_(index), out_(out) {}
+
+    [[nodiscard]] size_t options_seen() const { return options_seen_; }
+
+    bool null() override { return set_number(0.0); }
+    bool boolean(bool /*val*/) override { return true; }
+    bool number_integer(number_integer_t val) override {
+        return set_number(static_cast<double>(val));
+    }
+    bool number_unsigned(number_unsigned_t val) override {
+        return set_number(static_cast<double>(val));
+    }
+    bool number_float(number_float_t val, const string_t& /*s*/) override {
+        return set_number(val);
+    }
+    bool string(string_t& val) override {
+        if (in_option_ && field_ == Field::Symbol) {
+            symbol_.swap(val);
+        }
+        return true;
+    }
+    bool binary(binary_t& /*val*/) override { return true; }
+    bool start_object(size_t /*elements*/) override {
+        ++depth_;
+        if (depth_ == kOptionDepth && in_option_list_) {
+            in_option_ = true;
+            symbol_.clear();
+            bid_ = ask_ = last_ = 0.0;
+        }
+        field_ = Field::Other;
+        return true;
+    }
+    bool key(string_t& val) override {
+        if (depth_ == 1) {
+            in_options_ = val == "options";
+        } else if (depth_ == 2) {
+            in_option_list_ = in_options_ && val == "option";
+        } else if (depth_ == kOptionDepth && in_option_) {
+            field_ = val == "symbol" ? Field::Symbol
+                     : val == "bid"  ? Field::Bid
+                     : val == "ask"  ? Field::Ask
+                     : val == "last" ? Field::Last
+                                     : Field::Other;
+        }
+        return true;
+    }
+    bool end_object() override {
+        if (depth_ == kOptionDepth && in_option_) {
+            in_option_ = false;
+            ++options_seen_;
+            if (auto it = index_.find(std::string_view(symbol_)); it != index_.end()) {
+                append_quote(out_, it->second, bid_, ask_, last_);
+            }
+        }
+        --depth_;
+        field_ = Field::Other;
+        return true;
+    }
+    bool start_array(size_t /*elements*/) override {
+        field_ = Field::Other;
+        return true;
+    }
+    bool end_array() override { return true; }
+    bool parse_error(size_t /*position*/, const std::string& /*last_token*/,
+                     const nlohmann::detail::exception& ex) override {
+        error_ = ex.what();
+        return false;
+    }
+
+    [[nodiscard]] const std::string& error() const { return error_; }
+
+  private:
+    enum class Field : uint8_t { Other, Symbol, Bid, Ask, Last };
+    /** root = 1, "options" = 2, each option = 3. */
+    static constexpr int kOptionDepth = 3;
+
+    bool set_number(double v) {
+        if (!in_option_ || depth_ != kOptionDepth) {
+            return true;
+        }
+        switch (field_) {
+            using enum Field;
+        case Bid:
+            bid_ = v;
+            break;
+        case Ask:
+            ask_ = v;
+            break;
+        case Last:
+            last_ = v;
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
+
+    const OccSlotMap& index_;
+    TradierQuoteBuffer& out_;
+    int depth_ = 0;
+    bool in_options_ = false;
+    bool in_option_list_ = false;
+    bool in_option_ = false;
+    Field field_ = Field::Other;
+    std::string symbol_;
+    double bid_ = 0.0;
+    double ask_ = 0.0;
+    double last_ = 0.0;
+    size_t options_seen_ = 0;
+    std::string error_;
+};
+
+// Underlying quotes parse (one request for all symbols): symbol -> (bid, ask)
+auto parse_tradier_quotes_json(const std::string& body)
+    -> std::unordered_map<std::string, std::pair<double, double>> {
+    std::unordered_map<std::string, std::pair<double, double>> out;
     json data = json::parse(body);
     json q = data["quotes"]["quote"];
-    if (q.is_array() && !q.empty()) {
-        q = q[0];
+    if (q.is_object()) {
+        json arr = json::array();
+        arr.push_back(std::move(q));
+        q = std::move(arr);
+    }
+    if (!q.is_array()) {
+        return out;
+    }
+    for (const auto& item : q) {
+        out[item.value("symbol", std::string{})] = {json_safe_double(item, "bid", 0.0),
+                                                    json_safe_double(item, "ask", 0.0)};
     }
-    double bid = q["bid"].get<double>();
-    double ask = q["ask"].get<double>();
-    return {bid, ask};
+    return out;
 }
 
 } // namespace
@@ -177,6 +305,46 @@ MarketDataEngine::MarketDataEngine(utilities::MainEngine* main_engine)
 void MarketDataEngine::process_option(const utilities::ContractData& contract) {
     process_contract(contract, true);
 }
+void MarketDataEngine::process_options(std::vector<utilities::ContractData>&& contracts) {
+    // Portfolio name per option, as in process_contract, resolved once per distinct name.
+    std::unordered_map<std::string, std::vector<size_t>> by_name;
+    for (size_t i = 0; i < contracts.size(); ++i) {
+        const utilities::ContractData& c = contracts[i];
+        std::string name = (c.trading_class.has_value() && !c.trading_class->empty())
+                               ? *c.trading_class
+                               : c.symbol.substr(0, c.symbol.find('-'));
+        by_name[std::move(name)].push_back(i);
+    }
+    std::vector<std::pair<utilities::PortfolioData*, const std::vector<size_t>*>> groups;
+    for (const auto& [name, idx] : by_name) {
+        if (utilities::PortfolioData* port = get_portfolio(name)) {
+            groups.emplace_back(port, &idx);
+        } else {
+            write_log(std::format("Option portfolio \"{}\" not created (skip {} options).", name,
+                                  idx.size()),
+                      30);
+        }
+    }
+    // Portfolios share no state, so each one is built on its own pool task.
+    utilities::ThreadPool::shared().parallel_for(
+        groups.size(),
+        [&](size_t begin, size_t end) -> void {
+            for (size_t g = begin; g < end; ++g) {
+                auto [port, idx] = groups[g];
+                port->reserve_options(idx->size());
+                for (const size_t i : *idx) {
+                    port->add_option(contracts[i]);
+                }
+            }
+        },
+        1);
+    contracts_.reserve(contracts_.size() + contracts.size());
+    for (utilities::ContractData& c : contracts) {
+        std::string symbol = c.symbol;
+        contracts_.insert_or_assign(std::move(symbol), std::move(c));
+    }
+}
+
 void MarketDataEngine::ensure_portfolios_created() {
     for (const std::string& name : kPortfolioNamesToCreate) {
         get_or_create_portfolio(name);
@@ -221,6 +389,7 @@ void MarketDataEngine::finalize_all_chains() {
     for (auto& kv : portfolios_) {
         if (kv.second) {
             kv.second->finalize_chains();
+            occ_slots_[kv.first] = build_occ_index(*kv.second);
         }
     }
 }
@@ -302,6 +471,24 @@ void MarketDataEngine::set_tradier_rate_limit(int requests_per_minute) {
     tradier_requests_per_minute_ = (requests_per_minute > 0) ? requests_per_minute : 60;
 }
 
+void MarketDataEngine::set_spot_refresh(bool enabled) {
+    for (auto& [_, portfolio] : portfolios_) {
+        portfolio->set_spot_refresh(enabled);
+    }
+}
+
+void MarketDataEngine::set_surface_fit(bool enabled) {
+    for (auto& [_, portfolio] : portfolios_) {
+        portfolio->set_surface_fit(enabled);
+    }
+}
+
+void MarketDataEngine::set_market_data_streaming(bool enabled,
+                                                 std::chrono::milliseconds cadence) {
+    streaming_ = enabled;
+    stream_cadence_ = std::max(cadence, std::chrono::milliseconds(1));
+}
+
 auto MarketDataEngine::get_fixed_chains_to_query() const -> std::vector<std::string> {
     std::vector<std::string> chains;
     auto joined = active_chains_ | std::views::values | std::views::join;
@@ -342,16 +529,27 @@ void MarketDataEngine::poll_market_data_loop(const std::stop_token& st) {
         ++tradier_requests_used_;
     };
 
+    HttpMultiClient client(kTradierMaxInflight);
+    const std::vector<std::string> headers = {auth, "Accept: application/json"};
+    client.set_headers(headers);
+
+    struct ChainRequest {
+        std::string chain_key;
+        std::string quote_symbol;
+    };
     while (!st.stop_requested()) {
         std::vector<std::string> chains = get_fixed_chains_to_query();
         if (chains.empty()) {
             std::this_thread::sleep_for(std::chrono::seconds(1));
             continue;
         }
+        // One chain request per chain plus a single quotes request for the distinct underlyings,
+        // all in flight together.
+        std::vector<ChainRequest> requests;
+        std::vector<std::string> urls;
+        std::vector<std::string> quote_symbols;
+        std::unordered_set<std::string> seen_quotes;
         for (const std::string& chain_key : chains) {
-            if (st.stop_requested()) {
-                break;
-            }
             auto [symbol_part, date_part] = parse_chain_key(chain_key);
             if (symbol_part.empty() || date_part.size() < 8U) {
                 std::string msg;
@@ -375,45 +573,62 @@ void MarketDataEngine::poll_market_data_loop(const std::stop_token& st) {
             chain_url += api_symbol;
             chain_url += "&expiration=";
             chain_url += expiration;
+            urls.push_back(std::move(chain_url));
+            if (seen_quotes.insert(api_symbol).second) {
+                quote_symbols.push_back(api_symbol);
+            }
+            requests.push_back({.chain_key = chain_key, .quote_symbol = std::move(api_symbol)});
+        }
+        if (requests.empty()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            continue;
+        }
+        std::string quote_url = tradier_base_url_ + "markets/quotes?symbols=";
+        for (size_t i = 0; i < quote_symbols.size(); ++i) {
+            quote_url += (i == 0 ? "" : ",") + quote_symbols[i];
+        }
+        urls.push_back(std::move(quote_url));
 
+        for (size_t i = 0; i < urls.size() && !st.stop_requested(); ++i) {
             ensure_quota();
-            std::string chain_body = http_get(chain_url, auth);
-            if (chain_body.empty()) {
-                write_log(std::format("chain API response empty url={}", chain_url), 30);
-                continue;
-            }
-            std::vector<TradierOptionRaw> options;
+        }
+        if (st.stop_requested()) {
+            break;
+        }
+        std::vector<HttpResponse> responses = client.get_all(urls, kTradierTimeout);
+        trace_arrival_ = utilities::LatencyTracer::enabled() ? utilities::trace_now() : 0;
+
+        std::unordered_map<std::string, std::pair<double, double>> quotes;
+        const HttpResponse& quote_resp = responses.back();
+        if (!quote_resp.ok()) {
+            write_log(std::format("underlying quotes request failed url={} status={} {}",
+                                  urls.back(), quote_resp.status, quote_resp.error),
+                      30);
+        } else {
             try {
-                options = parse_tradier_chain_json(chain_body);
-            } catch (const json::exception& e) {
-                write_log("chain JSON parse error: " + std::string(e.what()), 40);
+                quotes = parse_tradier_quotes_json(quote_resp.body);
             } catch (const std::exception& e) {
-                write_log("chain parse error: " + std::string(e.what()), 40);
+                write_log(std::format("underlying quote parse error: {}", e.what()), 40);
             }
-            if (options.empty() && chain_body.size() > 10) {
-                write_log(std::format("chain API returned non-empty body but options_parsed=0 "
-                                      "(check JSON format or symbol/expiration)"),
+        }
+
+        for (size_t i = 0; i < requests.size() && !st.stop_requested(); ++i) {
+            const HttpResponse& resp = responses[i];
+            if (!resp.ok() || resp.body.empty()) {
+                write_log(std::format("chain API response empty url={} status={} {}", urls[i],
+                                      resp.status, resp.error),
                           30);
+                continue;
             }
-
-            std::string quote_symbol = underlying_symbol_for_quote(symbol_part);
-            std::string quote_url = tradier_base_url_ + "markets/quotes?symbols=" + quote_symbol;
-
-            ensure_quota();
-            std::string quote_body = http_get(quote_url, auth);
             double quote_bid = 0.0;
             double quote_ask = 0.0;
-            if (!quote_body.empty()) {
-                try {
-                    auto [b, a] = parse_tradier_quote_json(quote_body);
-                    quote_bid = b;
-                    quote_ask = a;
-                } catch (const std::exception& e) {
-                    write_log(std::format("underlying quote parse error: {}", e.what()), 40);
-                }
+            if (auto it = quotes.find(requests[i].quote_symbol); it != quotes.end()) {
+                quote_bid = it->second.first;
+                quote_ask = it->second.second;
             }
-            inject_tradier_chain(chain_key, options, quote_bid, quote_ask);
+            inject_tradier_chain_body(requests[i].chain_key, resp.body, quote_bid, quote_ask);
         }
+        trace_arrival_ = 0;
         std::this_thread::sleep_for(std::chrono::milliseconds(500));
     }
 }
@@ -429,10 +644,155 @@ void MarketDataEngine::start_market_data_update() {
         tradier_base_url_ = kTradierBaseUrl;
     }
     started_ = true;
+    if (streaming_) {
+        poll_thread_ =
+            std::jthread([this](std::stop_token st) { stream_market_data_loop(std::move(st)); });
+        write_log("Market data update started (Tradier stream)", INFO);
+        return;
+    }
     poll_thread_ = std::jthread([this](std::stop_token st) { poll_market_data_loop(std::move(st)); });
     write_log("Market data update started (Tradier poll)", INFO);
 }
 
+void MarketDataEngine::stream_market_data_loop(const std::stop_token& st) {
+    if (tradier_base_url_.empty() || tradier_token_.empty()) {
+        write_log("Tradier config missing (base_url or token); stream loop idle", 30);
+        return;
+    }
+    TradierStream stream(
+        tradier_base_url_, tradier_token_,
+        [this](const TradierStreamEvent& event) { on_stream_event(event); },
+        [this](const std::string& msg, int level) { write_log(msg, level); });
+    std::vector<std::string> chains;
+    while (!st.stop_requested()) {
+        std::vector<std::string> now_chains = get_fixed_chains_to_query();
+        std::ranges::sort(now_chains);
+        if (now_chains != chains) {
+            // Subscriptions changed: new session with the new symbol set.
+            chains = std::move(now_chains);
+            stream.stop();
+            stream.start(build_stream_routes(chains));
+        }
+        emit_stream_snapshots();
+        std::this_thread::sleep_for(stream_cadence_);
+    }
+    stream.stop();
+}
+
+auto MarketDataEngine::build_stream_routes(std::span<const std::string> chains)
+    -> std::vector<std::string> {
+    std::scoped_lock lock(stream_mutex_);
+    stream_routes_.clear();
+    stream_books_.clear();
+    std::vector<std::string> symbols;
+    for (const std::string& chain_key : chains) {
+        utilities::PortfolioData* portfolio = chain_portfolio(chain_key);
+        if (portfolio == nullptr) {
+            continue;
+        }
+        auto& book = stream_books_[portfolio->name];
+        if (!book) {
+            const size_t n = portfolio->option_apply_order().size();
+            book = std::make_unique<StreamBook>();
+            book->portfolio = portfolio;
+            book->bid.resize(n);
+            book->ask.resize(n);
+            book->last.resize(n);
+            book->dirty.assign(n, 0);
+            // Seeded from the published state: an event carrying only a trade (or the first
+            // quote of a slot) must not scatter zeros over quotes the portfolio already has.
+            const utilities::MarketView view = portfolio->pin();
+            for (size_t i = 0; i < n; ++i) {
+                book->bid[i] = view ? view.at(&utilities::OptionColumns::bid, i) : 0.0;
+                book->ask[i] = view ? view.at(&utilities::OptionColumns::ask, i) : 0.0;
+                book->last[i] = view ? view.at(&utilities::OptionColumns::mid, i) : 0.0;
+            }
+            if (view) {
+                book->underlying_bid = view.underlying_bid();
+                book->underlying_ask = view.underlying_ask();
+            }
+        }
+        book->chains.push_back(chain_key);
+        auto [symbol_part, date_part] = parse_chain_key(chain_key);
+        std::string underlying = underlying_symbol_for_quote(symbol_part);
+        if (stream_routes_.emplace(underlying, StreamRoute{.book = book.get(), .slot = -1})
+                .second) {
+            symbols.push_back(std::move(underlying));
+        }
+        // OCC root + YYMMDD selects this expiration's options.
+        const std::string prefix = symbol_part + date_part.substr(2);
+        for (const auto& [occ, slot] : occ_index(*portfolio)) {
+            if (occ.starts_with(prefix) &&
+                stream_routes_
+                    .emplace(occ, StreamRoute{.book = book.get(),
+                                              .slot = static_cast<int32_t>(slot)})
+                    .second) {
+                symbols.push_back(occ);
+            }
+        }
+    }
+    return symbols;
+}
+
+void MarketDataEngine::on_stream_event(const TradierStreamEvent& event) {
+    std::scoped_lock lock(stream_mutex_);
+    auto it = stream_routes_.find(event.symbol);
+    if (it == stream_routes_.end()) {
+        return;
+    }
+    StreamBook& book = *it->second.book;
+    const int32_t slot = it->second.slot;
+    if (slot < 0) {
+        if (event.has_quote) {
+            book.underlying_bid = event.bid;
+            book.underlying_ask = event.ask;
+        }
+        return;
+    }
+    const auto i = static_cast<size_t>(slot);
+    if (event.has_quote) {
+        book.bid[i] = event.bid;
+        book.ask[i] = event.ask;
+    }
+    if (event.has_trade) {
+        book.last[i] = event.last;
+    }
+    if (book.dirty[i] == 0) {
+        book.dirty[i] = 1;
+        book.dirty_slots.push_back(static_cast<uint32_t>(i));
+    }
+}
+
+void MarketDataEngine::emit_stream_snapshots() {
+    std::vector<StreamBook*> books;
+    {
+        std::scoped_lock lock(stream_mutex_);
+        books.reserve(stream_books_.size());
+        for (const auto& kv : stream_books_) {
+            books.push_back(kv.second.get());
+        }
+    }
+    for (StreamBook* book : books) {
+        double u_bid = 0.0;
+        double u_ask = 0.0;
+        {
+            std::scoped_lock lock(stream_mutex_);
+            if (book->dirty_slots.empty()) {
+                continue;
+            }
+            quote_buffer_.clear();
+            for (const uint32_t i : book->dirty_slots) {
+                append_quote(quote_buffer_, i, book->bid[i], book->ask[i], book->last[i]);
+                book->dirty[i] = 0;
+            }
+            book->dirty_slots.clear();
+            u_bid = book->underlying_bid;
+            u_ask = book->underlying_ask;
+        }
+        emit_chain_snapshot(*book->portfolio, u_bid, u_ask, book->chains);
+    }
+}
+
 void MarketDataEngine::stop_market_data_update() {
     started_ = false;
     poll_thread_.request_stop();
@@ -442,69 +802,92 @@ void MarketDataEngine::stop_market_data_update() {
     write_log("Market data update stopped (Tradier poll)", INFO);
 }
 
-void MarketDataEngine::inject_tradier_chain(const std::string& chain_key,
-                                            std::span<const TradierOptionRaw> options,
-                                            double quote_bid, double quote_ask) {
+auto MarketDataEngine::chain_portfolio(const std::string& chain_key)
+    -> utilities::PortfolioData* {
     auto [symbol_part, date_part] = parse_chain_key(chain_key);
     if (symbol_part.empty() || date_part.empty()) {
         write_log(std::format("Invalid chain_key: {}", chain_key), 40); // ERROR
-        return;
+        return nullptr;
     }
-    std::string expiration = expiration_from_date_part(date_part);
-    if (expiration.empty()) {
-        return;
+    if (expiration_from_date_part(date_part).empty()) {
+        return nullptr;
     }
-
     std::string portfolio_name = portfolio_name_for_underlying(symbol_part);
     utilities::PortfolioData* portfolio = get_portfolio(portfolio_name);
     if (portfolio == nullptr) {
         write_log("inject skip: no portfolio chain_key=" + chain_key +
                       " symbol_part=" + symbol_part + " portfolio_name=" + portfolio_name,
                   30);
+    }
+    return portfolio;
+}
+
+auto MarketDataEngine::occ_index(const utilities::PortfolioData& portfolio) -> const OccSlotMap& {
+    auto it = occ_slots_.find(portfolio.name);
+    if (it == occ_slots_.end()) {
+        it = occ_slots_.emplace(portfolio.name, build_occ_index(portfolio)).first;
+    }
+    return it->second;
+}
+
+void MarketDataEngine::inject_tradier_chain(const std::string& chain_key,
+                                            std::span<const TradierOptionRaw> options,
+                                            double quote_bid, double quote_ask) {
+    utilities::PortfolioData* portfolio = chain_portfolio(chain_key);
+    if (portfolio == nullptr) {
         return;
     }
-    const std::vector<utilities::OptionData*>& order = portfolio->option_apply_order();
-    const size_t n_opt = order.size();
-    std::unordered_map<std::string, size_t> symbol_to_index;
-    size_t idx = 0;
-    for (utilities::OptionData* opt : order) {
-        if (opt != nullptr) {
-            symbol_to_index[opt->symbol] = idx;
+    const OccSlotMap& index = occ_index(*portfolio);
+    quote_buffer_.clear();
+    for (const TradierOptionRaw& opt : options) {
+        if (auto it = index.find(std::string_view(opt.symbol)); it != index.end()) {
+            append_quote(quote_buffer_, it->second, opt.bid, opt.ask, opt.last);
         }
-        ++idx;
     }
+    emit_chain_snapshot(*portfolio, quote_bid, quote_ask, std::span(&chain_key, 1));
+}
 
+void MarketDataEngine::inject_tradier_chain_body(const std::string& chain_key,
+                                                 std::string_view body, double quote_bid,
+                                                 double quote_ask) {
+    utilities::PortfolioData* portfolio = chain_portfolio(chain_key);
+    if (portfolio == nullptr) {
+        return;
+    }
+    quote_buffer_.clear();
+    ChainQuoteSax sax(occ_index(*portfolio), quote_buffer_);
+    if (!json::sax_parse(body.begin(), body.end(), &sax)) {
+        write_log("chain JSON parse error: " + sax.error(), 40);
+        return;
+    }
+    if (sax.options_seen() == 0 && body.size() > 10) {
+        write_log(std::format("chain API returned non-empty body but options_parsed=0 "
+                              "(check JSON format or symbol/expiration)"),
+                  30);
+    }
+    emit_chain_snapshot(*portfolio, quote_bid, quote_ask, std::span(&chain_key, 1));
+}
+
+void MarketDataEngine::emit_chain_snapshot(const utilities::PortfolioData& portfolio,
+                                           double quote_bid, double quote_ask,
+                                           std::span<const std::string> chains) {
     utilities::PortfolioSnapshot snapshot;
-    snapshot.portfolio_name = portfolio->name;
+    snapshot.portfolio_name = portfolio.name;
     snapshot.datetime = std::chrono::system_clock::now();
-    snapshot.underlying_bid = round2(quote_bid);
-    snapshot.underlying_ask = round2(quote_ask);
-    snapshot.underlying_last = (quote_bid > 0.0 && quote_ask > 0.0)
-                                   ? round2(0.5 * (quote_bid + quote_ask))
-                                   : round2((quote_bid > 0.0) ? quote_bid : quote_ask);
-    snapshot.bid.resize(n_opt, 0.0);
-    snapshot.ask.resize(n_opt, 0.0);
-    snapshot.last.resize(n_opt, 0.0);
-    snapshot.delta.resize(n_opt, 0.0);
-    snapshot.gamma.resize(n_opt, 0.0);
-    snapshot.theta.resize(n_opt, 0.0);
-    snapshot.vega.resize(n_opt, 0.0);
-    snapshot.iv.resize(n_opt, 0.0);
-
-    // Init from portfolio state
-    if (portfolio->underlying) {
-        snapshot.underlying_bid = portfolio->underlying->bid_price;
-        snapshot.underlying_ask = portfolio->underlying->ask_price;
-        snapshot.underlying_last = portfolio->underlying->mid_price;
-    }
-    idx = 0;
-    for (utilities::OptionData* opt : order) {
-        if (opt != nullptr) {
-            snapshot.bid[idx] = opt->bid_price;
-            snapshot.ask[idx] = opt->ask_price;
-            snapshot.last[idx] = opt->mid_price;
-        }
-        ++idx;
+    // Sparse: only the quoted options; the rest keep their state in the portfolio columns.
+    snapshot.sparse = true;
+    snapshot.slots = quote_buffer_.slots;
+    snapshot.bid = quote_buffer_.bid;
+    snapshot.ask = quote_buffer_.ask;
+    snapshot.last = quote_buffer_.last;
+    snapshot.chains.assign(chains.begin(), chains.end());
+
+    // Init from the last published frame (a shard may be applying the next one meanwhile)
+    if (portfolio.underlying) {
+        const utilities::MarketView view = portfolio.pin();
+        snapshot.underlying_bid = view.underlying_bid();
+        snapshot.underlying_ask = view.underlying_ask();
+        snapshot.underlying_last = view.underlying_mid();
     }
     // Overwrite with quote when provided
     if (quote_bid > 0.0 || quote_ask > 0.0) {
@@ -514,50 +897,21 @@ void MarketDataEngine::inject_tradier_chain(const std::string& chain_key,
                                        ? round2(0.5 * (quote_bid + quote_ask))
                                        : round2((quote_bid > 0.0) ? quote_bid : quote_ask);
     }
-    for (const TradierOptionRaw& opt : options) {
-        // OCC -> platform symbol
-        if (opt.symbol.size() < 19U) {
-            continue;
-        }
-        std::string root = opt.symbol.substr(0, 4);
-        std::string yy = opt.symbol.substr(4, 2);
-        std::string mm = opt.symbol.substr(6, 2);
-        std::string dd = opt.symbol.substr(8, 2);
-        char opt_type = static_cast<char>(std::toupper(static_cast<unsigned char>(opt.symbol[10])));
-        if (opt_type != 'C' && opt_type != 'P') {
-            continue;
-        }
-        int strike_raw = 0;
-        try {
-            strike_raw = std::stoi(opt.symbol.substr(11, 8));
-        } catch (...) {
-            continue;
-        }
-        double strike = strike_raw / 1000.0;
-        std::string strike_str = std::format("{:.1f}", strike);
-        std::string platform_sym = std::format("{}-20{}{}{}-{}-{}-100-USD-OPT", root, yy, mm, dd,
-                                               std::string(1, opt_type), strike_str);
 
-        double bid = round2(opt.bid);
-        double ask = round2(opt.ask);
-        double last = round2(opt.last);
-        if (last == 0.0 && (bid != 0.0 || ask != 0.0)) {
-            last = (bid != 0.0 && ask != 0.0) ? round2(0.5 * (bid + ask))
-                                              : round2((bid != 0.0) ? bid : ask);
-        }
-        auto it = symbol_to_index.find(platform_sym);
-        if (it == symbol_to_index.end()) {
-            continue;
-        }
-        const size_t idx = it->second;
-        snapshot.bid[idx] = bid;
-        snapshot.ask[idx] = ask;
-        snapshot.last[idx] = last;
+    // Polled chains date from their response; pushed quotes from this flush.
+    const bool tracing = utilities::LatencyTracer::enabled();
+    if (tracing) {
+        snapshot.trace_tsc = trace_arrival_ != 0 ? trace_arrival_ : utilities::trace_now();
     }
-
+    const uint64_t arrival = snapshot.trace_tsc;
     if (main_engine != nullptr) {
         main_engine->put_event(
-            utilities::Event(utilities::EventType::Snapshot, std::move(snapshot)));
+            utilities::Event(utilities::EventType::Snapshot,
+                             utilities::share_snapshot(std::move(snapshot))));
+    }
+    if (tracing) {
+        utilities::LatencyTracer::instance().record(utilities::LatencyStage::MarketData, arrival,
+                                                    utilities::trace_now());
     }
 }
 
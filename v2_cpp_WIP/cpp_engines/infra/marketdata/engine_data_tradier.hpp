@@ -11,13 +11,18 @@
 #include "../../utilities/event.hpp"
 #include "../../utilities/object.hpp"
 #include "../../utilities/portfolio.hpp"
+#include "tradier_stream.hpp"
 #include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <span>
 #include <stop_token>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <unordered_map>
 #include <vector>
@@ -41,6 +46,31 @@ struct TradierOptionRaw {
     double open_interest = 0.0;
 };
 
+/** Hash for string-keyed maps looked up by string_view without building a key. */
+struct TransparentStringHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+};
+
+/** Tradier OCC symbol (e.g. SPXW260302C02800000) → option_apply_order slot of one portfolio. */
+using OccSlotMap =
+    std::unordered_map<std::string, uint32_t, TransparentStringHash, std::equal_to<>>;
+
+/** Reusable per-chain parse output: quoted slots with rounded bid/ask/last. */
+struct TradierQuoteBuffer {
+    std::vector<uint32_t> slots;
+    std::vector<double> bid;
+    std::vector<double> ask;
+    std::vector<double> last;
+
+    void clear() {
+        slots.clear();
+        bid.clear();
+        ask.clear();
+        last.clear();
+    }
+};
+
 class MarketDataEngine : public utilities::BaseEngine {
   public:
     explicit MarketDataEngine(utilities::MainEngine* main_engine);
@@ -48,6 +78,8 @@ class MarketDataEngine : public utilities::BaseEngine {
     /** Create all portfolios from hardcoded list; call before load_contracts. */
     void ensure_portfolios_created();
     void process_option(const utilities::ContractData& contract);
+    /** Bulk process_option: contracts grouped by portfolio, portfolios built in parallel. */
+    void process_options(std::vector<utilities::ContractData>&& contracts);
     void process_underlying(const utilities::ContractData& contract);
     void finalize_all_chains();
 
@@ -62,6 +94,17 @@ class MarketDataEngine : public utilities::BaseEngine {
 
     void set_tradier_config(std::string base_url, std::string token);
     void set_tradier_rate_limit(int requests_per_minute);
+    /** Spot-only Greeks refresh of chains a snapshot does not cover (every portfolio). */
+    void set_spot_refresh(bool enabled);
+    /** Per-chain SVI surface for illiquid strikes (every portfolio; see set_surface_fit). */
+    void set_surface_fit(bool enabled);
+    /**
+     * Push mode (call before start_market_data_update): stream quotes for the subscribed chains
+     * instead of polling REST, and emit one conflated sparse Snapshot per changed portfolio every
+     * cadence.
+     */
+    void set_market_data_streaming(bool enabled, std::chrono::milliseconds cadence =
+                                                     std::chrono::milliseconds(250));
 
     void start_market_data_update();
     void stop_market_data_update();
@@ -77,13 +120,67 @@ class MarketDataEngine : public utilities::BaseEngine {
   private:
     utilities::PortfolioData* get_or_create_portfolio(const std::string& portfolio_name);
     void process_contract(const utilities::ContractData& contract, bool is_option);
+    /** Resolve chain_key to its finalized portfolio; nullptr (logged) when unusable. */
+    utilities::PortfolioData* chain_portfolio(const std::string& chain_key);
+    /** OCC→slot map of portfolio; built here if finalize_all_chains has not built it. */
+    const OccSlotMap& occ_index(const utilities::PortfolioData& portfolio);
+    /** Chain response body → SAX parse straight into quote_buffer_ → sparse Snapshot event. */
+    void inject_tradier_chain_body(const std::string& chain_key, std::string_view body,
+                                   double quote_bid, double quote_ask);
+    /**
+     * Emit a sparse Snapshot of quote_buffer_ with the underlying quote (or portfolio state),
+     * scoped to chains so apply_frame re-solves only those.
+     */
+    void emit_chain_snapshot(const utilities::PortfolioData& portfolio, double quote_bid,
+                             double quote_ask, std::span<const std::string> chains);
     void poll_market_data_loop(const std::stop_token& st);
+
+    /**
+     * Latest quotes of one portfolio: seeded from its published state, then updated by the
+     * stream; dirty slots are emitted at the next snapshot.
+     */
+    struct StreamBook {
+        utilities::PortfolioData* portfolio = nullptr;
+        /** Chain keys streamed into this book (the snapshot's chains). */
+        std::vector<std::string> chains;
+        std::vector<double> bid;
+        std::vector<double> ask;
+        std::vector<double> last;
+        std::vector<uint8_t> dirty;
+        std::vector<uint32_t> dirty_slots;
+        double underlying_bid = 0.0;
+        double underlying_ask = 0.0;
+    };
+    /** Streamed symbol → book and slot (-1 = the portfolio's underlying). */
+    struct StreamRoute {
+        StreamBook* book = nullptr;
+        int32_t slot = -1;
+    };
+    void stream_market_data_loop(const std::stop_token& st);
+    /** Rebuild books/routes for chains; returns the symbols to stream. */
+    std::vector<std::string> build_stream_routes(std::span<const std::string> chains);
+    /** Stream thread: fold one update into its book. */
+    void on_stream_event(const TradierStreamEvent& event);
+    /** Emit dirty slots of every book as sparse Snapshots (via quote_buffer_). */
+    void emit_stream_snapshots();
     std::vector<std::string> get_fixed_chains_to_query() const;
 
     std::unordered_map<std::string, std::unique_ptr<utilities::PortfolioData>> portfolios_;
     std::unordered_map<std::string, utilities::ContractData> contracts_;
     std::unordered_map<std::string, std::set<std::string>> active_chains_;
     std::unordered_map<std::string, std::set<std::string>> strategy_chains_;
+    /** portfolio name → OCC index (finalize_all_chains, or lazily on first inject). */
+    std::unordered_map<std::string, OccSlotMap> occ_slots_;
+    /** Poll thread in poll mode, stream emitter in push mode (never both). */
+    TradierQuoteBuffer quote_buffer_;
+    /** Poll thread: trace_now() when the current poll's responses arrived (0 = not tracing). */
+    uint64_t trace_arrival_ = 0;
+    bool streaming_ = false;
+    std::chrono::milliseconds stream_cadence_{250};
+    std::mutex stream_mutex_;
+    std::unordered_map<std::string, std::unique_ptr<StreamBook>> stream_books_;
+    std::unordered_map<std::string, StreamRoute, TransparentStringHash, std::equal_to<>>
+        stream_routes_;
     std::string tradier_base_url_;
     std::string tradier_token_;
     int tradier_requests_per_minute_ = 60;
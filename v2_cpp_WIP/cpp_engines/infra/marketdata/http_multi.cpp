@@ -0,0 +1,129 @@
+/** HttpMultiClient: curl_multi GET batches over pooled easy handles. */
+
+#include "http_multi.hpp"
+#include <algorithm>
+
+namespace engines {
+
+namespace {
+
+auto write_cb(char* ptr, size_t size, size_t nmemb, void* userdata) -> size_t {
+    auto* out = static_cast<std::string*>(userdata);
+    out->append(ptr, size * nmemb);
+    return size * nmemb;
+}
+
+} // namespace
+
+HttpMultiClient::HttpMultiClient(size_t max_inflight)
+    : multi_(curl_multi_init()), max_inflight_(std::max<size_t>(max_inflight, 1)) {
+    if (multi_ != nullptr) {
+        curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+        curl_multi_setopt(multi_, CURLMOPT_MAX_HOST_CONNECTIONS,
+                          static_cast<long>(max_inflight_));
+    }
+}
+
+HttpMultiClient::~HttpMultiClient() {
+    for (CURL* easy : idle_) {
+        curl_easy_cleanup(easy);
+    }
+    if (headers_ != nullptr) {
+        curl_slist_free_all(headers_);
+    }
+    if (multi_ != nullptr) {
+        curl_multi_cleanup(multi_);
+    }
+}
+
+void HttpMultiClient::set_headers(std::span<const std::string> headers) {
+    if (headers_ != nullptr) {
+        curl_slist_free_all(headers_);
+        headers_ = nullptr;
+    }
+    for (const std::string& h : headers) {
+        headers_ = curl_slist_append(headers_, h.c_str());
+    }
+}
+
+auto HttpMultiClient::acquire_handle() -> CURL* {
+    if (!idle_.empty()) {
+        CURL* easy = idle_.back();
+        idle_.pop_back();
+        return easy;
+    }
+    CURL* easy = curl_easy_init();
+    if (easy != nullptr) {
+        curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, write_cb);
+        curl_easy_setopt(easy, CURLOPT_ACCEPT_ENCODING, ""); // gzip/deflate, as Python requests
+        curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_2TLS));
+        // Wait for a multiplexable connection rather than opening a parallel one.
+        curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+        curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+    }
+    return easy;
+}
+
+auto HttpMultiClient::get_all(std::span<const std::string> urls,
+                              std::chrono::milliseconds timeout) -> std::vector<HttpResponse> {
+    std::vector<HttpResponse> out(urls.size());
+    if (multi_ == nullptr) {
+        for (HttpResponse& r : out) {
+            r.error = "curl_multi_init failed";
+        }
+        return out;
+    }
+    size_t next = 0;
+    size_t inflight = 0;
+    const auto start_next = [&]() -> void {
+        while (next < urls.size() && inflight < max_inflight_) {
+            HttpResponse& r = out[next];
+            CURL* easy = acquire_handle();
+            if (easy == nullptr) {
+                r.error = "curl_easy_init failed";
+                ++next;
+                continue;
+            }
+            curl_easy_setopt(easy, CURLOPT_URL, urls[next].c_str());
+            curl_easy_setopt(easy, CURLOPT_HTTPHEADER, headers_);
+            curl_easy_setopt(easy, CURLOPT_WRITEDATA, &r.body);
+            curl_easy_setopt(easy, CURLOPT_PRIVATE, &r);
+            curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, static_cast<long>(timeout.count()));
+            curl_multi_add_handle(multi_, easy);
+            ++next;
+            ++inflight;
+        }
+    };
+
+    start_next();
+    while (inflight > 0) {
+        int running = 0;
+        curl_multi_perform(multi_, &running);
+        int left = 0;
+        while (CURLMsg* msg = curl_multi_info_read(multi_, &left)) {
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+            CURL* easy = msg->easy_handle;
+            void* priv = nullptr;
+            curl_easy_getinfo(easy, CURLINFO_PRIVATE, &priv);
+            auto* r = static_cast<HttpResponse*>(priv);
+            curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &r->status);
+            if (msg->data.result != CURLE_OK) {
+                r->error = curl_easy_strerror(msg->data.result);
+                r->body.clear();
+            }
+            curl_multi_remove_handle(multi_, easy);
+            idle_.push_back(easy);
+            --inflight;
+        }
+        start_next();
+        if (inflight > 0) {
+            curl_multi_poll(multi_, nullptr, 0, 100, nullptr);
+        }
+    }
+    return out;
+}
+
+} // namespace engines
@@ -0,0 +1,52 @@
+#pragma once
+
+/**
+ * HttpMultiClient: concurrent GETs on one curl_multi handle. Easy handles and the connection cache
+ * persist across calls, so repeat polls reuse keep-alive (HTTP/2 multiplexed where the server
+ * supports it) connections instead of reconnecting per request.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <curl/curl.h>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace engines {
+
+struct HttpResponse {
+    long status = 0;
+    std::string body;
+    /** curl error text; empty on transport success. */
+    std::string error;
+
+    [[nodiscard]] bool ok() const { return error.empty() && status >= 200 && status < 300; }
+};
+
+class HttpMultiClient {
+  public:
+    /** max_inflight: transfers running at once (also the per-host connection cap). */
+    explicit HttpMultiClient(size_t max_inflight = 8);
+    ~HttpMultiClient();
+
+    HttpMultiClient(const HttpMultiClient&) = delete;
+    HttpMultiClient& operator=(const HttpMultiClient&) = delete;
+
+    /** Request headers sent with every GET, e.g. "Authorization: Bearer ...". */
+    void set_headers(std::span<const std::string> headers);
+
+    /** GET every url concurrently and block until all finish; responses are in url order. */
+    std::vector<HttpResponse> get_all(std::span<const std::string> urls,
+                                      std::chrono::milliseconds timeout);
+
+  private:
+    CURL* acquire_handle();
+
+    CURLM* multi_ = nullptr;
+    curl_slist* headers_ = nullptr;
+    std::vector<CURL*> idle_;
+    size_t max_inflight_ = 8;
+};
+
+} // namespace engines
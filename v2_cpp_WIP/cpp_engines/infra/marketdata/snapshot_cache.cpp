@@ -0,0 +1,332 @@
+#include "snapshot_cache.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace backtest {
+
+namespace {
+
+constexpr std::array<char, 8> kMagic{'O', 'T', 'S', 'N', 'A', 'P', '0', '2'};
+/** Footer bytes hashed into the key (parquet metadata lives at the end of the file). */
+constexpr size_t kFooterBytes = size_t{1} << 20;
+
+struct Header {
+    std::array<char, 8> magic = kMagic;
+    uint64_t key = 0;
+    int64_t n_frames = 0;
+    int64_t n_opt = 0;
+    int64_t row_count = 0;
+    int64_t dte_ref_ns = 0;
+    uint32_t has_dte_ref = 0;
+    uint32_t has_greeks = 0;
+    /** NUL-separated strings: underlying, time_column, ts_start, ts_end, then symbols. */
+    int64_t strings_bytes = 0;
+    int64_t n_symbols = 0;
+};
+
+/** Per frame: underlying bid, ask, last, bid_sz, ask_sz. */
+constexpr size_t kUnderlyingFields = 5;
+/** Option columns: bid, ask, last, bid_sz, ask_sz, then iv and the four Greeks. */
+constexpr size_t kQuoteColumns = 5;
+constexpr size_t kGreekColumns = 10;
+
+auto padded(size_t n) -> size_t { return (n + 7) & ~size_t{7}; }
+
+auto expected_size(const Header& h) -> size_t {
+    const auto frames = static_cast<size_t>(h.n_frames);
+    const size_t n_cols = h.has_greeks != 0 ? kGreekColumns : kQuoteColumns;
+    return sizeof(Header) + padded(static_cast<size_t>(h.strings_bytes)) +
+           frames * (2 * sizeof(int64_t) + kUnderlyingFields * sizeof(double)) +
+           n_cols * frames * static_cast<size_t>(h.n_opt) * sizeof(double);
+}
+
+struct Fnv1a {
+    uint64_t h = 14695981039346656037ULL;
+    void bytes(const void* p, size_t n) {
+        const auto* b = static_cast<const unsigned char*>(p);
+        for (size_t i = 0; i < n; ++i) {
+            h = (h ^ b[i]) * 1099511628211ULL;
+        }
+    }
+    void str(std::string_view s) {
+        bytes(s.data(), s.size());
+        bytes("", 1);
+    }
+    template <typename T> void value(T v) { bytes(&v, sizeof(v)); }
+};
+
+auto ns_of(utilities::DateTime t) -> int64_t {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+auto from_ns(int64_t ns) -> utilities::DateTime {
+    return utilities::DateTime{std::chrono::duration_cast<utilities::DateTime::duration>(
+        std::chrono::nanoseconds(ns))};
+}
+
+template <typename T> void put(std::ofstream& out, const T* p, size_t n) {
+    out.write(reinterpret_cast<const char*>(p), static_cast<std::streamsize>(n * sizeof(T)));
+}
+
+} // namespace
+
+auto snapshot_cache_key(std::string const& parquet_path, std::string const& time_column,
+                        std::string const& underlying_symbol, double risk_free_rate,
+                        std::string const& iv_price_mode, bool with_greeks,
+                        std::chrono::nanoseconds bar, std::optional<Timestamp> range_start,
+                        std::optional<Timestamp> range_end)
+    -> uint64_t {
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(parquet_path, ec);
+    if (ec) {
+        return 0;
+    }
+    std::ifstream in(parquet_path, std::ios::binary);
+    const size_t tail = std::min<size_t>(size, kFooterBytes);
+    std::vector<char> footer(tail);
+    in.seekg(static_cast<std::streamoff>(size - tail));
+    if (!in.read(footer.data(), static_cast<std::streamsize>(tail))) {
+        return 0;
+    }
+    Fnv1a f;
+    f.bytes(kMagic.data(), kMagic.size());
+    f.value(static_cast<uint64_t>(size));
+    f.bytes(footer.data(), footer.size());
+    f.str(time_column);
+    f.str(underlying_symbol);
+    f.value(std::bit_cast<uint64_t>(risk_free_rate));
+    f.str(iv_price_mode);
+    f.value(static_cast<uint8_t>(with_greeks));
+    f.value(static_cast<int64_t>(bar.count()));
+    f.value(range_start ? ns_of(*range_start) : INT64_MIN);
+    f.value(range_end ? ns_of(*range_end) : INT64_MAX);
+    return f.h == 0 ? 1 : f.h;
+}
+
+auto SnapshotCache::open(std::string const& path, uint64_t key) -> std::unique_ptr<SnapshotCache> {
+    std::unique_ptr<SnapshotCache> cache(new SnapshotCache());
+#ifdef _WIN32
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        return nullptr;
+    }
+    cache->buffer_.resize(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char*>(cache->buffer_.data()),
+                 static_cast<std::streamsize>(cache->buffer_.size()))) {
+        return nullptr;
+    }
+    cache->data_ = cache->buffer_.data();
+    cache->size_ = cache->buffer_.size();
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(Header))) {
+        ::close(fd);
+        return nullptr;
+    }
+    void* p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        return nullptr;
+    }
+    cache->data_ = static_cast<const std::byte*>(p);
+    cache->size_ = static_cast<size_t>(st.st_size);
+#endif
+    if (cache->size_ < sizeof(Header)) {
+        return nullptr;
+    }
+    Header h;
+    std::memcpy(&h, cache->data_, sizeof(h));
+    if (h.magic != kMagic || h.key != key || h.n_frames < 0 || h.n_opt < 0 ||
+        h.strings_bytes < 0 || h.n_symbols < 0 || expected_size(h) != cache->size_) {
+        return nullptr;
+    }
+
+    const std::byte* cur = cache->data_ + sizeof(Header);
+    std::string_view strings(reinterpret_cast<const char*>(cur),
+                             static_cast<size_t>(h.strings_bytes));
+    const auto next = [&strings]() -> std::string {
+        const size_t end = strings.find('\0');
+        std::string s(strings.substr(0, end));
+        strings.remove_prefix(end == std::string_view::npos ? strings.size() : end + 1);
+        return s;
+    };
+    SnapshotCacheContents& c = cache->contents_;
+    c.underlying_symbol = next();
+    c.meta.time_column = next();
+    c.meta.ts_start = next();
+    c.meta.ts_end = next();
+    c.meta.row_count = h.row_count;
+    if (h.has_dte_ref != 0) {
+        c.dte_ref = from_ns(h.dte_ref_ns);
+    }
+    c.symbols.reserve(static_cast<size_t>(h.n_symbols));
+    for (int64_t i = 0; i < h.n_symbols; ++i) {
+        c.symbols.push_back(next());
+    }
+    cur += padded(static_cast<size_t>(h.strings_bytes));
+
+    // Sections are 8-byte aligned (page-aligned mapping, padded strings), so direct views are safe.
+    const auto n_frames = static_cast<size_t>(h.n_frames);
+    const auto cells = n_frames * static_cast<size_t>(h.n_opt);
+    cache->n_frames_ = n_frames;
+    cache->n_opt_ = static_cast<size_t>(h.n_opt);
+    cache->has_greeks_ = h.has_greeks != 0;
+    cache->ts_ns_ = {reinterpret_cast<const int64_t*>(cur), n_frames};
+    cur += n_frames * sizeof(int64_t);
+    cache->rows_ = {reinterpret_cast<const int64_t*>(cur), n_frames};
+    cur += n_frames * sizeof(int64_t);
+    cache->underlying_ = {reinterpret_cast<const double*>(cur), kUnderlyingFields * n_frames};
+    cur += kUnderlyingFields * n_frames * sizeof(double);
+    const size_t n_cols = cache->has_greeks_ ? kGreekColumns : kQuoteColumns;
+    for (size_t k = 0; k < n_cols; ++k) {
+        cache->columns_.emplace_back(reinterpret_cast<const double*>(cur), cells);
+        cur += cells * sizeof(double);
+    }
+    return cache;
+}
+
+auto SnapshotCache::write(std::string const& path, uint64_t key,
+                          SnapshotCacheContents const& contents,
+                          std::vector<utilities::PortfolioSnapshot> const& snapshots,
+                          std::vector<int64_t> const& rows) -> bool {
+    if (key == 0 || snapshots.empty() || rows.size() != snapshots.size()) {
+        return false;
+    }
+    const size_t n_opt = snapshots.front().bid.size();
+    bool greeks = true;
+    for (const auto& s : snapshots) {
+        if (s.sparse || s.bid.size() != n_opt || s.ask.size() != n_opt || s.last.size() != n_opt ||
+            s.bid_sz.size() != n_opt || s.ask_sz.size() != n_opt) {
+            return false;
+        }
+        greeks = greeks && s.has_greeks && s.iv.size() == n_opt && s.delta.size() == n_opt &&
+                 s.gamma.size() == n_opt && s.theta.size() == n_opt && s.vega.size() == n_opt;
+    }
+
+    std::string strings;
+    for (std::string const* s : {&contents.underlying_symbol, &contents.meta.time_column,
+                                 &contents.meta.ts_start, &contents.meta.ts_end}) {
+        strings += *s;
+        strings += '\0';
+    }
+    for (std::string const& s : contents.symbols) {
+        strings += s;
+        strings += '\0';
+    }
+
+    Header h;
+    h.key = key;
+    h.n_frames = static_cast<int64_t>(snapshots.size());
+    h.n_opt = static_cast<int64_t>(n_opt);
+    h.row_count = contents.meta.row_count;
+    h.has_dte_ref = contents.dte_ref ? 1 : 0;
+    h.dte_ref_ns = contents.dte_ref ? ns_of(*contents.dte_ref) : 0;
+    h.has_greeks = greeks ? 1 : 0;
+    h.strings_bytes = static_cast<int64_t>(strings.size());
+    h.n_symbols = static_cast<int64_t>(contents.symbols.size());
+    strings.resize(padded(strings.size()), '\0');
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        put(out, &h, 1);
+        put(out, strings.data(), strings.size());
+        for (const auto& s : snapshots) {
+            const int64_t ns = ns_of(s.datetime);
+            put(out, &ns, 1);
+        }
+        put(out, rows.data(), rows.size());
+        for (const auto& s : snapshots) {
+            const std::array<double, kUnderlyingFields> u{s.underlying_bid, s.underlying_ask,
+                                                          s.underlying_last, s.underlying_bid_sz,
+                                                          s.underlying_ask_sz};
+            put(out, u.data(), u.size());
+        }
+        using Column = std::vector<double> utilities::PortfolioSnapshot::*;
+        constexpr std::array<Column, kGreekColumns> kColumns{
+            &utilities::PortfolioSnapshot::bid,    &utilities::PortfolioSnapshot::ask,
+            &utilities::PortfolioSnapshot::last,   &utilities::PortfolioSnapshot::bid_sz,
+            &utilities::PortfolioSnapshot::ask_sz, &utilities::PortfolioSnapshot::iv,
+            &utilities::PortfolioSnapshot::delta,  &utilities::PortfolioSnapshot::gamma,
+            &utilities::PortfolioSnapshot::theta,  &utilities::PortfolioSnapshot::vega};
+        const size_t n_cols = greeks ? kGreekColumns : kQuoteColumns;
+        for (size_t k = 0; k < n_cols; ++k) {
+            for (const auto& s : snapshots) {
+                put(out, (s.*kColumns[k]).data(), n_opt);
+            }
+        }
+        if (!out) {
+            std::filesystem::remove(tmp, ec);
+            return false;
+        }
+    }
+    std::filesystem::rename(tmp, path, ec);
+    return !ec;
+}
+
+SnapshotCache::~SnapshotCache() {
+#ifndef _WIN32
+    if (data_ != nullptr && buffer_.empty()) {
+        ::munmap(const_cast<std::byte*>(data_), size_);
+    }
+#endif
+}
+
+auto SnapshotCache::timestamp(size_t frame) const -> Timestamp { return from_ns(ts_ns_[frame]); }
+
+void SnapshotCache::fill(size_t frame, std::string const& portfolio_name, bool with_greeks,
+                         utilities::PortfolioSnapshot& out) const {
+    out.portfolio_name = portfolio_name;
+    out.datetime = timestamp(frame);
+    const size_t u = kUnderlyingFields * frame;
+    out.underlying_bid = underlying_[u];
+    out.underlying_ask = underlying_[u + 1];
+    out.underlying_last = underlying_[u + 2];
+    out.underlying_bid_sz = underlying_[u + 3];
+    out.underlying_ask_sz = underlying_[u + 4];
+    out.sparse = false;
+    out.slots.clear();
+    const auto assign = [this, frame](std::vector<double>& dst, size_t col) {
+        const auto src = columns_[col].subspan(frame * n_opt_, n_opt_);
+        dst.assign(src.begin(), src.end());
+    };
+    assign(out.bid, 0);
+    assign(out.ask, 1);
+    assign(out.last, 2);
+    assign(out.bid_sz, 3);
+    assign(out.ask_sz, 4);
+    out.has_greeks = with_greeks && has_greeks_;
+    if (out.has_greeks) {
+        assign(out.iv, 5);
+        assign(out.delta, 6);
+        assign(out.gamma, 7);
+        assign(out.theta, 8);
+        assign(out.vega, 9);
+    } else {
+        for (auto* v : {&out.iv, &out.delta, &out.gamma, &out.theta, &out.vega}) {
+            v->assign(n_opt_, 0.0);
+        }
+    }
+}
+
+} // namespace backtest
@@ -0,0 +1,88 @@
+#pragma once
+
+/**
+ * SnapshotCache: BacktestDataEngine's on-disk cache of one parquet load (contract universe + dense
+ * snapshot columns, optionally with Greeks), memory-mapped so a rerun skips decode and pricing.
+ */
+
+#include "object.hpp"
+#include "types.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace backtest {
+
+/** Everything besides the snapshots needed to rebuild the data engine state. */
+struct SnapshotCacheContents {
+    std::string underlying_symbol;
+    DataMeta meta;
+    std::optional<utilities::DateTime> dte_ref;
+    /** Sorted OCC symbols (the universe create_portfolio_data was built from). */
+    std::vector<std::string> symbols;
+};
+
+/**
+ * Cache key: parquet size and footer bytes (row-group layout and statistics), plus every input
+ * that changes the snapshots. 0 if the file cannot be read.
+ */
+uint64_t snapshot_cache_key(std::string const& parquet_path, std::string const& time_column,
+                            std::string const& underlying_symbol, double risk_free_rate,
+                            std::string const& iv_price_mode, bool with_greeks,
+                            std::chrono::nanoseconds bar, std::optional<Timestamp> range_start,
+                            std::optional<Timestamp> range_end);
+
+class SnapshotCache {
+  public:
+    /** Map path; nullptr if missing, truncated or written under another key. */
+    static std::unique_ptr<SnapshotCache> open(std::string const& path, uint64_t key);
+    /**
+     * Write snapshots (all dense, one per frame, rows[i] rows each) via a temp file + rename.
+     * Greeks are stored when every snapshot has_greeks. False if nothing was written.
+     */
+    static bool write(std::string const& path, uint64_t key, SnapshotCacheContents const& contents,
+                      std::vector<utilities::PortfolioSnapshot> const& snapshots,
+                      std::vector<int64_t> const& rows);
+
+    ~SnapshotCache();
+    SnapshotCache(const SnapshotCache&) = delete;
+    SnapshotCache& operator=(const SnapshotCache&) = delete;
+
+    [[nodiscard]] SnapshotCacheContents const& contents() const { return contents_; }
+    [[nodiscard]] size_t frame_count() const { return n_frames_; }
+    [[nodiscard]] size_t option_count() const { return n_opt_; }
+    [[nodiscard]] bool has_greeks() const { return has_greeks_; }
+    [[nodiscard]] Timestamp timestamp(size_t frame) const;
+    [[nodiscard]] int64_t num_rows(size_t frame) const { return rows_[frame]; }
+    /** Copy frame into out (reusing its buffers); Greeks only when with_greeks and cached. */
+    void fill(size_t frame, std::string const& portfolio_name, bool with_greeks,
+              utilities::PortfolioSnapshot& out) const;
+
+  private:
+    SnapshotCache() = default;
+
+    const std::byte* data_ = nullptr;
+    size_t size_ = 0;
+    /** Fallback buffer where mmap is unavailable (Windows). */
+    std::vector<std::byte> buffer_;
+    SnapshotCacheContents contents_;
+    size_t n_frames_ = 0;
+    size_t n_opt_ = 0;
+    bool has_greeks_ = false;
+    std::span<const int64_t> ts_ns_;
+    std::span<const int64_t> rows_;
+    /** underlying bid, ask, last, bid_sz, ask_sz per frame. */
+    std::span<const double> underlying_;
+    /**
+     * bid, ask, last, bid_sz, ask_sz[, iv, delta, gamma, theta, vega], each frame-major
+     * n_frames x n_opt.
+     */
+    std::vector<std::span<const double>> columns_;
+};
+
+} // namespace backtest
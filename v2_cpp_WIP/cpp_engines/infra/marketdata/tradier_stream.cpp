@@ -0,0 +1,224 @@
+/** TradierStream: session + newline-delimited event stream over libcurl, with reconnect. */
+
+#include "tradier_stream.hpp"
+#include <algorithm>
+#include <chrono>
+#include <curl/curl.h>
+#include <format>
+#include <nlohmann/json.hpp>
+#include <utility>
+
+using json = nlohmann::json;
+
+namespace engines {
+
+namespace {
+
+constexpr auto kReconnectMin = std::chrono::seconds(1);
+constexpr auto kReconnectMax = std::chrono::seconds(30);
+
+auto append_cb(char* ptr, size_t size, size_t nmemb, void* userdata) -> size_t {
+    static_cast<std::string*>(userdata)->append(ptr, size * nmemb);
+    return size * nmemb;
+}
+
+// Abort the transfer once stop is requested (curl calls this about once a second when idle).
+auto stop_cb(void* userdata, curl_off_t /*dltotal*/, curl_off_t /*dlnow*/, curl_off_t /*ultotal*/,
+             curl_off_t /*ulnow*/) -> int {
+    return static_cast<const std::stop_token*>(userdata)->stop_requested() ? 1 : 0;
+}
+
+// Tradier sends prices as numbers or numeric strings.
+auto json_number(const json& j, const char* key, double& out) -> bool {
+    auto it = j.find(key);
+    if (it == j.end() || it->is_null()) {
+        return false;
+    }
+    if (it->is_number()) {
+        out = it->get<double>();
+        return true;
+    }
+    if (it->is_string()) {
+        try {
+            out = std::stod(it->get_ref<const std::string&>());
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+    return false;
+}
+
+void sleep_unless_stopped(const std::stop_token& st, std::chrono::milliseconds d) {
+    const auto until = std::chrono::steady_clock::now() + d;
+    while (!st.stop_requested() && std::chrono::steady_clock::now() < until) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+}
+
+struct StreamSink {
+    TradierStream* stream = nullptr;
+    std::string pending{};
+};
+
+} // namespace
+
+TradierStream::TradierStream(std::string api_base_url, std::string token, EventFn on_event,
+                             LogFn log)
+    : api_base_url_(std::move(api_base_url)), token_(std::move(token)),
+      on_event_(std::move(on_event)), log_(std::move(log)) {}
+
+TradierStream::~TradierStream() { stop(); }
+
+void TradierStream::start(std::vector<std::string> symbols) {
+    stop();
+    symbols_ = std::move(symbols);
+    if (symbols_.empty()) {
+        return;
+    }
+    thread_ = std::jthread([this](std::stop_token st) { run(st); });
+}
+
+void TradierStream::stop() {
+    thread_.request_stop();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    connected_ = false;
+}
+
+auto TradierStream::create_session(std::string& stream_url, std::string& session_id) -> bool {
+    CURL* curl = curl_easy_init();
+    if (curl == nullptr) {
+        return false;
+    }
+    const std::string auth = "Authorization: Bearer " + token_;
+    curl_slist* headers = curl_slist_append(nullptr, auth.c_str());
+    headers = curl_slist_append(headers, "Accept: application/json");
+    const std::string url = api_base_url_ + "markets/events/session";
+    std::string body;
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, "");
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, append_cb);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &body);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    const CURLcode res = curl_easy_perform(curl);
+    curl_slist_free_all(headers);
+    curl_easy_cleanup(curl);
+    if (res != CURLE_OK) {
+        log_(std::format("stream session request failed: {}", curl_easy_strerror(res)), 30);
+        return false;
+    }
+    try {
+        const json data = json::parse(body);
+        const json& stream = data.at("stream");
+        stream_url = stream.value("url", std::string{});
+        session_id = stream.value("sessionid", std::string{});
+    } catch (const std::exception& e) {
+        log_(std::format("stream session parse error: {}", e.what()), 40);
+        return false;
+    }
+    return !stream_url.empty() && !session_id.empty();
+}
+
+void TradierStream::stream_once(const std::string& stream_url, const std::string& session_id,
+                                const std::stop_token& st) {
+    CURL* curl = curl_easy_init();
+    if (curl == nullptr) {
+        return;
+    }
+    std::string symbols;
+    for (const std::string& s : symbols_) {
+        symbols += symbols.empty() ? s : "," + s;
+    }
+    const std::string form = "sessionid=" + session_id + "&symbols=" + symbols +
+                             "&filter=quote,trade&linebreak=true";
+    curl_slist* headers = curl_slist_append(nullptr, "Accept: application/json");
+    StreamSink sink{.stream = this};
+    curl_easy_setopt(curl, CURLOPT_URL, stream_url.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, form.c_str());
+    curl_easy_setopt(
+        curl, CURLOPT_WRITEFUNCTION,
+        +[](char* ptr, size_t size, size_t nmemb, void* userdata) -> size_t {
+            auto* s = static_cast<StreamSink*>(userdata);
+            s->pending.append(ptr, size * nmemb);
+            size_t begin = 0;
+            for (size_t nl = s->pending.find('\n'); nl != std::string::npos;
+                 nl = s->pending.find('\n', begin)) {
+                s->stream->handle_line(std::string_view(s->pending).substr(begin, nl - begin));
+                begin = nl + 1;
+            }
+            s->pending.erase(0, begin);
+            return size * nmemb;
+        });
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &sink);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, stop_cb);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &st);
+    // Treat a silent stream (no bytes, heartbeats included, for 30 s) as dropped.
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, 30L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    connected_ = true;
+    const CURLcode res = curl_easy_perform(curl);
+    connected_ = false;
+    curl_slist_free_all(headers);
+    curl_easy_cleanup(curl);
+    if (!st.stop_requested()) {
+        log_(std::format("market data stream ended: {}", curl_easy_strerror(res)), 30);
+    }
+}
+
+void TradierStream::handle_line(std::string_view line) {
+    if (line.empty() || line.front() != '{') {
+        return;
+    }
+    json data;
+    try {
+        data = json::parse(line);
+    } catch (const json::exception&) {
+        return;
+    }
+    const std::string type = data.value("type", std::string{});
+    const std::string symbol = data.value("symbol", std::string{});
+    if (symbol.empty()) {
+        return;
+    }
+    TradierStreamEvent event{.symbol = symbol};
+    if (type == "quote") {
+        const bool has_bid = json_number(data, "bid", event.bid);
+        const bool has_ask = json_number(data, "ask", event.ask);
+        event.has_quote = has_bid && has_ask;
+    } else if (type == "trade") {
+        event.has_trade = json_number(data, "last", event.last) ||
+                          json_number(data, "price", event.last);
+    }
+    if ((event.has_quote || event.has_trade) && on_event_) {
+        on_event_(event);
+    }
+}
+
+void TradierStream::run(const std::stop_token& st) {
+    auto backoff = std::chrono::duration_cast<std::chrono::milliseconds>(kReconnectMin);
+    while (!st.stop_requested()) {
+        std::string stream_url;
+        std::string session_id;
+        if (create_session(stream_url, session_id)) {
+            const auto began = std::chrono::steady_clock::now();
+            stream_once(stream_url, session_id, st);
+            // A stream that stayed up a while was healthy; reconnect quickly.
+            if (std::chrono::steady_clock::now() - began > kReconnectMax) {
+                backoff = std::chrono::duration_cast<std::chrono::milliseconds>(kReconnectMin);
+            }
+        }
+        sleep_unless_stopped(st, backoff);
+        backoff = std::min(backoff * 2,
+                           std::chrono::duration_cast<std::chrono::milliseconds>(kReconnectMax));
+    }
+}
+
+} // namespace engines
@@ -0,0 +1,68 @@
+#pragma once
+
+/**
+ * TradierStream: push quotes from Tradier's streaming API. Creates a market session
+ * (POST markets/events/session), then holds one long-lived HTTP stream of newline-delimited quote
+ * and trade events on a background thread, reconnecting with a fresh session on drop.
+ */
+
+#include <atomic>
+#include <functional>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace engines {
+
+/** One streamed update; quote carries bid/ask, trade carries last. */
+struct TradierStreamEvent {
+    std::string_view symbol;
+    bool has_quote = false;
+    double bid = 0.0;
+    double ask = 0.0;
+    bool has_trade = false;
+    double last = 0.0;
+};
+
+class TradierStream {
+  public:
+    /** Called on the stream thread for every quote/trade event. */
+    using EventFn = std::function<void(const TradierStreamEvent&)>;
+    /** (message, level) with write_log levels. */
+    using LogFn = std::function<void(const std::string&, int)>;
+
+    /** api_base_url e.g. "https://api.tradier.com/v1/" (session endpoint). */
+    TradierStream(std::string api_base_url, std::string token, EventFn on_event, LogFn log);
+    ~TradierStream();
+
+    TradierStream(const TradierStream&) = delete;
+    TradierStream& operator=(const TradierStream&) = delete;
+
+    /** (Re)start streaming symbols (OCC options and underlyings); stops any running stream. */
+    void start(std::vector<std::string> symbols);
+    void stop();
+
+    [[nodiscard]] bool connected() const { return connected_.load(std::memory_order_relaxed); }
+
+  private:
+    void run(const std::stop_token& st);
+    /** Session POST; false (logged) on failure. */
+    bool create_session(std::string& stream_url, std::string& session_id);
+    /** Stream until disconnect or stop. */
+    void stream_once(const std::string& stream_url, const std::string& session_id,
+                     const std::stop_token& st);
+    /** Parse one event line and forward quote/trade updates. */
+    void handle_line(std::string_view line);
+
+    std::string api_base_url_;
+    std::string token_;
+    EventFn on_event_;
+    LogFn log_;
+    std::vector<std::string> symbols_;
+    std::atomic<bool> connected_{false};
+    std::jthread thread_;
+};
+
+} // namespace engines
@@ -2,17 +2,98 @@
 #include "../../core/engine_option_strategy.hpp"
 #include "../../strategy/template.hpp"
 #include "../../utilities/event.hpp"
+#include "engine_data_multi.hpp"
 #include "engine_main.hpp"
+#include "scheduler.hpp"
 #include <algorithm>
+#include <array>
+#include <charconv>
 #include <chrono>
 #include <cmath>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <stdexcept>
+#include <string_view>
 #include <utility>
 
 namespace backtest {
 
+void MetricsRecorder::reserve(size_t n) {
+    timestamps.reserve(n);
+    for (auto* c : {&pnl, &delta, &gamma, &theta, &fees}) {
+        c->reserve(n);
+    }
+}
+
+void MetricsRecorder::clear() {
+    timestamps.clear();
+    for (auto* c : {&pnl, &delta, &gamma, &theta, &fees}) {
+        c->clear();
+    }
+}
+
+void MetricsRecorder::push(Timestamp ts, double step_pnl, double step_delta, double step_gamma,
+                           double step_theta, double step_fees) {
+    timestamps.push_back(ts);
+    pnl.push_back(step_pnl);
+    delta.push_back(step_delta);
+    gamma.push_back(step_gamma);
+    theta.push_back(step_theta);
+    fees.push_back(step_fees);
+}
+
+void FillRecorder::clear() {
+    for (auto* c : {&order_ts, &trade_ts}) {
+        c->clear();
+    }
+    for (auto* c : {&order_id, &order_symbol, &trade_id, &trade_orderid, &trade_symbol}) {
+        c->clear();
+    }
+    for (auto* c : {&order_price, &order_volume, &order_traded, &trade_price, &trade_volume}) {
+        c->clear();
+    }
+    order_direction.clear();
+    order_status.clear();
+    trade_direction.clear();
+}
+
+void FillRecorder::add_order(Timestamp ts, const utilities::OrderData& order) {
+    order_ts.push_back(ts);
+    order_id.push_back(order.orderid);
+    order_symbol.push_back(order.symbol);
+    order_direction.push_back(order.direction.value_or(utilities::Direction::NET));
+    order_status.push_back(order.status);
+    order_price.push_back(order.price);
+    order_volume.push_back(order.volume);
+    order_traded.push_back(order.traded);
+}
+
+void FillRecorder::add_trade(Timestamp ts, const utilities::TradeData& trade) {
+    trade_ts.push_back(ts);
+    trade_id.push_back(trade.tradeid);
+    trade_orderid.push_back(trade.orderid);
+    trade_symbol.push_back(trade.symbol);
+    trade_direction.push_back(trade.direction.value_or(utilities::Direction::NET));
+    trade_price.push_back(trade.price);
+    trade_volume.push_back(trade.volume);
+}
+
+void MetricsSeries::append(MetricsRecorder&& part) {
+    if (part.size() == 0) {
+        return;
+    }
+    offsets_.push_back(offsets_.back() + part.size());
+    parts_.push_back(std::move(part));
+}
+
+auto MetricsSeries::locate(size_t i) const -> std::pair<const MetricsRecorder*, size_t> {
+    // First offset past i, minus one, is the part that starts at or before i.
+    const auto it = std::upper_bound(offsets_.begin(), offsets_.end(), i);
+    const auto k = static_cast<size_t>(it - offsets_.begin()) - 1;
+    return {&parts_[k], i - offsets_[k]};
+}
+
 BacktestEngine::BacktestEngine() {
     main_engine_ = std::make_unique<MainEngine>();
     // Orders queued for next timestep
@@ -30,29 +111,59 @@ void BacktestEngine::configure_execution(double fee_rate, double slippage_bps) {
     slippage_bps_ = slippage_bps;
 }
 
-auto BacktestEngine::get_market_bid_ask(const std::string& symbol) const
-    -> std::pair<double, double> {
-    if (!main_engine_ || (main_engine_->option_strategy_engine() == nullptr)) {
-        return {0.0, 0.0};
+void BacktestEngine::configure_fill_model(FillModel model, double participation,
+                                          double queue_ahead) {
+    if (!(participation > 0.0) || participation > 1.0) {
+        throw std::runtime_error("fill participation must be in (0, 1]");
     }
-    auto* strategy = main_engine_->option_strategy_engine()->get_strategy();
-    if (strategy == nullptr) {
-        return {0.0, 0.0};
-    }
-    utilities::PortfolioData* portfolio = main_engine_->get_portfolio(strategy->portfolio_name());
+    fill_model_ = model;
+    fill_participation_ = participation;
+    queue_ahead_ = std::max(queue_ahead, 0.0);
+}
+
+void BacktestEngine::PendingBook::clear() {
+    orderids.clear();
+    requests.clear();
+    portfolios.clear();
+    combo.clear();
+    broken.clear();
+    leg_begin.assign(1, 0);
+    legs.clear();
+    remaining.clear();
+    traded.clear();
+    queue.clear();
+    carried.clear();
+}
+
+void BacktestEngine::PendingBook::append(const PendingBook& src, size_t i) {
+    orderids.push_back(src.orderids[i]);
+    requests.push_back(src.requests[i]);
+    portfolios.push_back(src.portfolios[i]);
+    combo.push_back(src.combo[i]);
+    broken.push_back(src.broken[i]);
+    legs.insert(legs.end(), src.legs.begin() + src.leg_begin[i],
+                src.legs.begin() + src.leg_begin[i + 1]);
+    leg_begin.push_back(static_cast<uint32_t>(legs.size()));
+    remaining.push_back(src.remaining[i]);
+    traded.push_back(src.traded[i]);
+    queue.push_back(src.queue[i]);
+    carried.push_back(src.carried[i]);
+}
+
+auto BacktestEngine::resolve_quote(const utilities::PortfolioData* portfolio,
+                                   utilities::SymbolId id, double quantity,
+                                   bool buy) -> QuoteHandle {
+    QuoteHandle handle{.quantity = quantity, .buy = static_cast<uint8_t>(buy)};
     if (portfolio == nullptr) {
-        return {0.0, 0.0};
+        return handle;
     }
-    auto it = portfolio->options.find(symbol);
-    if (it != portfolio->options.end()) {
-        const auto& opt = it->second;
-        return {opt.bid_price, opt.ask_price};
+    if (const utilities::OptionData* opt = portfolio->find_option(id)) {
+        handle.slot = static_cast<uint32_t>(opt->slot);
+    } else if (id != utilities::kNoSymbol && portfolio->underlying &&
+               portfolio->underlying->symbol_id == id) {
+        handle.slot = QuoteHandle::kUnderlying;
     }
-    if (portfolio->underlying && portfolio->underlying->symbol == symbol) {
-        const auto& und = *portfolio->underlying;
-        return {und.bid_price, und.ask_price};
-    }
-    return {0.0, 0.0};
+    return handle;
 }
 
 auto BacktestEngine::default_contract_size(const std::string& symbol) -> double {
@@ -60,7 +171,7 @@ auto BacktestEngine::default_contract_size(const std::string& symbol) -> double
 }
 
 auto BacktestEngine::calculate_order_fee(const utilities::OrderRequest& req,
-                                         double fill_price) const -> double {
+                                         double volume) const -> double {
     if (fee_rate_ <= 0.0 || !main_engine_) {
         return 0.0;
     }
@@ -72,12 +183,11 @@ auto BacktestEngine::calculate_order_fee(const utilities::OrderRequest& req,
             if (!leg.symbol) {
                 continue;
             }
-            const double leg_volume =
-                std::abs(req.volume * std::abs(static_cast<double>(leg.ratio)));
+            const double leg_volume = std::abs(volume * std::abs(static_cast<double>(leg.ratio)));
             total_contracts += leg_volume;
         }
     } else {
-        total_contracts = std::abs(req.volume);
+        total_contracts = std::abs(volume);
     }
 
     // Fee = contracts * fee_rate
@@ -86,126 +196,272 @@ auto BacktestEngine::calculate_order_fee(const utilities::OrderRequest& req,
 
 auto BacktestEngine::submit_order(const utilities::OrderRequest& req) -> std::string {
     order_counter_++;
-    std::string orderid = "backtest_order_" + std::to_string(order_counter_);
-    pending_orders_.emplace_back(orderid, req);
+    // The id outlives the timestep (pending book, execution engine): build it in one allocation.
+    constexpr std::string_view kPrefix = "backtest_order_";
+    std::array<char, 16> digits{};
+    const size_t n_digits = static_cast<size_t>(
+        std::to_chars(digits.data(), digits.data() + digits.size(), order_counter_).ptr -
+        digits.data());
+    std::string orderid;
+    orderid.reserve(kPrefix.size() + n_digits);
+    orderid.append(kPrefix).append(digits.data(), n_digits);
+    const utilities::PortfolioData* portfolio = nullptr;
+    if (main_engine_ && (main_engine_->option_strategy_engine() != nullptr)) {
+        if (auto* strategy = main_engine_->option_strategy_engine()->get_strategy()) {
+            portfolio = main_engine_->get_portfolio(strategy->portfolio_name());
+        }
+    }
+    PendingBook& book = pending_orders_;
+    const bool combo = req.is_combo && req.legs && !req.legs->empty();
+    const bool buy = req.direction == utilities::Direction::LONG;
+    // Multi-underlying: an order on another underlying trades on the portfolio listing it.
+    if (const auto synced = main_engine_->synced_portfolios(); !synced.empty()) {
+        const utilities::SymbolId id = utilities::find_symbol(
+            combo && req.legs->front().symbol ? *req.legs->front().symbol : req.symbol);
+        const auto lists = [id](const utilities::PortfolioData* p) -> bool {
+            return p->find_option(id) != nullptr ||
+                   (id != utilities::kNoSymbol && p->underlying && p->underlying->symbol_id == id);
+        };
+        if (portfolio == nullptr || !lists(portfolio)) {
+            if (const auto it = std::ranges::find_if(synced, lists); it != synced.end()) {
+                portfolio = *it;
+            }
+        }
+    }
+    bool broken = false;
+    if (combo) {
+        for (const auto& leg : *req.legs) {
+            if (!leg.symbol) {
+                broken = true;
+                continue;
+            }
+            // Selling the combo reverses every leg.
+            const bool leg_buy = (leg.direction == utilities::Direction::LONG) == buy;
+            book.legs.push_back(resolve_quote(portfolio, utilities::find_symbol(*leg.symbol),
+                                              std::abs(static_cast<double>(leg.ratio)), leg_buy));
+        }
+    } else {
+        book.legs.push_back(
+            resolve_quote(portfolio, utilities::find_symbol(req.symbol), 1.0, buy));
+    }
+    book.orderids.push_back(orderid);
+    book.requests.push_back(req);
+    book.portfolios.push_back(portfolio);
+    book.combo.push_back(static_cast<uint8_t>(combo));
+    book.broken.push_back(static_cast<uint8_t>(broken));
+    book.leg_begin.push_back(static_cast<uint32_t>(book.legs.size()));
+    book.remaining.push_back(req.volume);
+    book.traded.push_back(0.0);
+    book.queue.push_back(-1.0);
+    book.carried.push_back(0);
     return orderid;
 }
 
-void BacktestEngine::execute_order_impl(const utilities::OrderRequest& req,
-                                        const std::string& orderid) {
+void BacktestEngine::price_pending_orders(PendingBook& book,
+                                          const std::vector<QuoteDepth>* depth) {
+    const size_t n = book.size();
+    book.leg_bid.assign(book.legs.size(), 0.0);
+    book.leg_ask.assign(book.legs.size(), 0.0);
+    // Gather: backtest applies frames on this thread, so the columns are the current bar.
+    for (size_t i = 0; i < n; ++i) {
+        const utilities::PortfolioData* portfolio = book.portfolios[i];
+        if (portfolio == nullptr) {
+            continue;
+        }
+        const double* bid = portfolio->columns.bid.data();
+        const double* ask = portfolio->columns.ask.data();
+        const size_t slots = portfolio->columns.size();
+        const utilities::UnderlyingData* und = portfolio->underlying.get();
+        for (uint32_t l = book.leg_begin[i]; l < book.leg_begin[i + 1]; ++l) {
+            const uint32_t slot = book.legs[l].slot;
+            if (slot < slots) {
+                book.leg_bid[l] = bid[slot];
+                book.leg_ask[l] = ask[slot];
+            } else if (slot == QuoteHandle::kUnderlying && und != nullptr) {
+                book.leg_bid[l] = und->bid_price;
+                book.leg_ask[l] = und->ask_price;
+            }
+        }
+    }
+    book.total_bid.assign(n, 0.0);
+    book.total_ask.assign(n, 0.0);
+    book.priced.assign(n, 0);
+    for (size_t i = 0; i < n; ++i) {
+        bool ok = book.broken[i] == 0;
+        double total_bid = 0.0;
+        double total_ask = 0.0;
+        for (uint32_t l = book.leg_begin[i]; l < book.leg_begin[i + 1]; ++l) {
+            // A combo leg with no quote on either side leaves the combo unpriced.
+            if (book.combo[i] != 0 && book.leg_bid[l] <= 0 && book.leg_ask[l] <= 0) {
+                ok = false;
+            }
+            total_bid += book.leg_bid[l] * book.legs[l].quantity;
+            total_ask += book.leg_ask[l] * book.legs[l].quantity;
+        }
+        book.total_bid[i] = total_bid;
+        book.total_ask[i] = total_ask;
+        book.priced[i] = static_cast<uint8_t>(ok);
+    }
+    if (depth == nullptr) {
+        return;
+    }
+    // Size at the side each leg takes on its order's portfolio; 0 (unknown or unresolved) does
+    // not cap.
+    book.leg_size.assign(book.legs.size(), 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        const auto d = std::ranges::find(*depth, book.portfolios[i], &QuoteDepth::portfolio);
+        if (book.portfolios[i] == nullptr || d == depth->end()) {
+            continue;
+        }
+        const size_t sized = std::min(d->bid_sz.size(), d->ask_sz.size());
+        for (uint32_t l = book.leg_begin[i]; l < book.leg_begin[i + 1]; ++l) {
+            const QuoteHandle& leg = book.legs[l];
+            if (leg.slot < sized) {
+                book.leg_size[l] = leg.buy != 0 ? d->ask_sz[leg.slot] : d->bid_sz[leg.slot];
+            } else if (leg.slot == QuoteHandle::kUnderlying) {
+                book.leg_size[l] = leg.buy != 0 ? d->underlying_ask_sz : d->underlying_bid_sz;
+            }
+        }
+    }
+    constexpr double kUnlimited = std::numeric_limits<double>::infinity();
+    book.capacity.assign(n, kUnlimited);
+    for (size_t i = 0; i < n; ++i) {
+        double capacity = kUnlimited;
+        for (uint32_t l = book.leg_begin[i]; l < book.leg_begin[i + 1]; ++l) {
+            const double size = book.leg_size[l];
+            const double quantity = book.legs[l].quantity;
+            capacity = std::min(capacity,
+                                size > 0.0 && quantity > 0.0 ? size / quantity : kUnlimited);
+        }
+        book.capacity[i] = capacity;
+    }
+}
+
+void BacktestEngine::size_pending_orders(PendingBook& book, double participation,
+                                         double queue_ahead) {
+    const size_t n = book.size();
+    book.fill_volume.resize(n);
+    const double* capacity = book.capacity.data();
+    const double* remaining = book.remaining.data();
+    double* queue = book.queue.data();
+    double* fill = book.fill_volume.data();
+    for (size_t i = 0; i < n; ++i) {
+        const double cap = capacity[i] * participation;
+        // Joining the book: the displayed size ahead of us at that bar (none if unknown).
+        const double joined = std::isfinite(cap) ? queue_ahead * capacity[i] : 0.0;
+        const double ahead = queue[i] < 0.0 ? joined : queue[i];
+        const double worked = std::min(ahead, cap);
+        queue[i] = ahead - worked;
+        fill[i] = std::min(remaining[i], std::floor(cap - worked));
+    }
+}
+
+void BacktestEngine::track_depth(const utilities::PortfolioSnapshot& snapshot) {
+    auto it = std::ranges::find_if(depth_, [&snapshot](const QuoteDepth& d) -> bool {
+        return d.portfolio->name == snapshot.portfolio_name;
+    });
+    if (it == depth_.end()) {
+        const utilities::PortfolioData* portfolio =
+            main_engine_->get_portfolio(snapshot.portfolio_name);
+        if (portfolio == nullptr) {
+            return;
+        }
+        it = depth_.insert(depth_.end(), QuoteDepth{.portfolio = portfolio});
+    }
+    QuoteDepth& depth = *it;
+    depth.underlying_bid_sz = snapshot.underlying_bid_sz;
+    depth.underlying_ask_sz = snapshot.underlying_ask_sz;
+    if (!snapshot.sparse) {
+        // Dense: read in place; the snapshot outlives this timestep's matching.
+        const bool sized = snapshot.bid_sz.size() == snapshot.bid.size() &&
+                           snapshot.ask_sz.size() == snapshot.bid.size();
+        depth.bid_sz = snapshot.bid_sz;
+        depth.ask_sz = snapshot.ask_sz;
+        if (!sized) {
+            depth.bid_sz = depth.ask_sz = {};
+        }
+        return;
+    }
+    const size_t m = snapshot.slots.size();
+    if (snapshot.bid_sz.size() == m && snapshot.ask_sz.size() == m) {
+        for (size_t k = 0; k < m; ++k) {
+            const size_t slot = snapshot.slots[k];
+            if (slot >= depth.scattered_bid_sz.size()) {
+                depth.scattered_bid_sz.resize(slot + 1, 0.0);
+                depth.scattered_ask_sz.resize(slot + 1, 0.0);
+            }
+            depth.scattered_bid_sz[slot] = snapshot.bid_sz[k];
+            depth.scattered_ask_sz[slot] = snapshot.ask_sz[k];
+        }
+    }
+    depth.bid_sz = depth.scattered_bid_sz;
+    depth.ask_sz = depth.scattered_ask_sz;
+}
+
+auto BacktestEngine::fill_pending_order(const PendingBook& book, size_t i) -> bool {
+    const utilities::OrderRequest& req = book.requests[i];
+    const std::string& orderid = book.orderids[i];
     const double limit = req.price;
     const bool is_limit_order = (req.type == utilities::OrderType::LIMIT && limit > 0.0);
+    const bool is_buy = req.direction == utilities::Direction::LONG;
+    const bool carried = book.carried[i] != 0;
+    const double bid = book.total_bid[i];
+    const double ask = book.total_ask[i];
 
     double fill_price = 0.0;
-    bool filled = false;
-
-    if (is_limit_order) {
-        // LIMIT: buy fill at ask iff limit>=ask; sell at bid iff limit<=bid
-        if (req.is_combo && req.legs && !req.legs->empty()) {
-            double total_bid = 0.0;
-            double total_ask = 0.0;
-            bool ok = true;
-            for (const auto& leg : *req.legs) {
-                if (!leg.symbol) {
-                    ok = false;
-                    break;
-                }
-                auto [bid, ask] = get_market_bid_ask(*leg.symbol);
-                if (bid <= 0 && ask <= 0) {
-                    ok = false;
-                    break;
-                }
-                const double q = std::abs(static_cast<double>(leg.ratio));
-                total_bid += bid * q;
-                total_ask += ask * q;
-            }
-            if (ok) {
-                if (req.direction == utilities::Direction::LONG) {
-                    if (limit >= total_ask && total_ask > 0.0) {
-                        fill_price = total_ask;
-                        filled = true;
-                    }
-                } else {
-                    if (limit <= total_bid && total_bid > 0.0) {
-                        fill_price = total_bid;
-                        filled = true;
-                    }
-                }
-            }
-        } else {
-            auto [bid, ask] = get_market_bid_ask(req.symbol);
-            if (req.direction == utilities::Direction::LONG) {
+    bool marketable = false;
+
+    if (book.priced[i] != 0) {
+        if (is_limit_order) {
+            // LIMIT: buy fill at ask iff limit>=ask; sell at bid iff limit<=bid
+            if (is_buy) {
                 if (limit >= ask && ask > 0.0) {
                     fill_price = ask;
-                    filled = true;
+                    marketable = true;
                 }
-            } else {
-                if (limit <= bid && bid > 0.0) {
-                    fill_price = bid;
-                    filled = true;
-                }
-            }
-        }
-    } else {
-        // MARKET: buy at ask, sell at bid
-        if (req.is_combo && req.legs && !req.legs->empty()) {
-            double total_bid = 0.0;
-            double total_ask = 0.0;
-            bool ok = true;
-            for (const auto& leg : *req.legs) {
-                if (!leg.symbol) {
-                    ok = false;
-                    break;
-                }
-                auto [bid, ask] = get_market_bid_ask(*leg.symbol);
-                if (bid <= 0 && ask <= 0) {
-                    ok = false;
-                    break;
-                }
-                const double q = std::abs(static_cast<double>(leg.ratio));
-                total_bid += bid * q;
-                total_ask += ask * q;
-            }
-            if (ok) {
-                if (req.direction == utilities::Direction::LONG) {
-                    fill_price = total_ask;
-                    filled = total_ask > 0.0;
-                } else {
-                    fill_price = total_bid;
-                    filled = total_bid > 0.0;
-                }
-            }
-        } else {
-            auto [bid, ask] = get_market_bid_ask(req.symbol);
-            if (req.direction == utilities::Direction::LONG) {
-                fill_price = ask;
-                filled = ask > 0.0;
-            } else {
+            } else if (limit <= bid && bid > 0.0) {
                 fill_price = bid;
-                filled = bid > 0.0;
+                marketable = true;
             }
-        }
-        // Slippage (market only)
-        if (filled && slippage_bps_ > 0.0 && fill_price > 0.0) {
-            const double mult = 1.0 + (slippage_bps_ / 10000.0);
-            if (req.direction == utilities::Direction::LONG) {
-                fill_price *= mult;
-            } else {
-                fill_price *= (2.0 - mult);
+        } else {
+            // MARKET: buy at ask, sell at bid
+            fill_price = is_buy ? ask : bid;
+            marketable = fill_price > 0.0;
+            // Slippage (market only)
+            if (marketable && slippage_bps_ > 0.0) {
+                const double mult = 1.0 + (slippage_bps_ / 10000.0);
+                fill_price *= is_buy ? mult : (2.0 - mult);
             }
         }
     }
 
+    // Top of book takes the whole remainder; depth takes what the sizing kernel allowed.
+    const double volume =
+        !marketable ? 0.0
+                    : (fill_model_ == FillModel::Depth ? book.fill_volume[i] : book.remaining[i]);
+    const bool filled = volume > 0.0;
+    const double traded = book.traded[i] + volume;
+    const bool working = marketable && book.remaining[i] - volume > 0.0;
+
+    // A working order with nothing new this bar has no update to report.
+    if (carried && working && !filled) {
+        return true;
+    }
     utilities::OrderData order = req.create_order_data(orderid, "Backtest");
-    if (filled) {
+    order.traded = traded;
+    if (working) {
+        order.status = traded > 0.0 ? utilities::Status::PARTTRADED : utilities::Status::NOTTRADED;
+    } else if (marketable) {
         order.status = utilities::Status::ALLTRADED;
-        order.traded = order.volume;
     } else {
-        order.status = utilities::Status::NOTTRADED;
-        order.traded = 0;
+        // Not fillable at this bar: dropped (a carried remainder is cancelled).
+        order.status = carried ? utilities::Status::CANCELLED : utilities::Status::NOTTRADED;
     }
 
     main_engine_->add_order(orderid, order);
+    if (record_fills_) {
+        fills_.add_order(current_ts_, order);
+    }
     main_engine_->put_event(utilities::Event(utilities::EventType::Order, order));
 
     if (filled) {
@@ -218,19 +474,24 @@ void BacktestEngine::execute_order_impl(const utilities::OrderRequest& req,
         trade.orderid = orderid;
         trade.direction = req.direction;
         trade.price = fill_price;
-        trade.volume = req.volume;
+        trade.volume = volume;
         trade.datetime = std::chrono::system_clock::now();
+        if (record_fills_) {
+            fills_.add_trade(current_ts_, trade);
+        }
         main_engine_->put_event(utilities::Event(utilities::EventType::Trade, trade));
 
-        if (req.is_combo && req.legs) {
-            int i = 0;
+        if (book.combo[i] != 0) {
+            int n = 0;
+            uint32_t l = book.leg_begin[i];
             for (const auto& leg : *req.legs) {
                 if (!leg.symbol) {
                     continue;
                 }
-                auto [leg_bid, leg_ask] = get_market_bid_ask(*leg.symbol);
-                double leg_price =
-                    (leg.direction == utilities::Direction::LONG) ? leg_ask : leg_bid;
+                double leg_price = (leg.direction == utilities::Direction::LONG)
+                                       ? book.leg_ask[l]
+                                       : book.leg_bid[l];
+                ++l;
                 if (leg_price <= 0.0) {
                     leg_price = fill_price; // fallback for combo aggregate
                 }
@@ -239,27 +500,89 @@ void BacktestEngine::execute_order_impl(const utilities::OrderRequest& req,
                 leg_trade.symbol = *leg.symbol;
                 leg_trade.exchange = leg.exchange;
                 leg_trade.tradeid = "backtest_trade_" + std::to_string(trade_counter_) + "_leg_" +
-                                    std::to_string(i++);
+                                    std::to_string(n++);
                 leg_trade.orderid = orderid;
                 leg_trade.direction = leg.direction;
                 leg_trade.price = leg_price;
-                leg_trade.volume = req.volume * std::abs(static_cast<double>(leg.ratio));
+                leg_trade.volume = volume * std::abs(static_cast<double>(leg.ratio));
                 leg_trade.datetime = std::chrono::system_clock::now();
+                if (record_fills_) {
+                    fills_.add_trade(current_ts_, leg_trade);
+                }
                 main_engine_->put_event(utilities::Event(utilities::EventType::Trade, leg_trade));
             }
         }
-        const double fee = calculate_order_fee(req, fill_price);
+        const double fee = calculate_order_fee(req, volume);
         if (fee > 0.0) {
             cumulative_fees_ += fee;
         }
     }
+    return working;
 }
 
 void BacktestEngine::execute_pending_orders() {
-    for (auto& [orderid, req] : pending_orders_) {
-        execute_order_impl(req, orderid);
+    if (pending_orders_.size() == 0) {
+        return;
     }
+    // Orders sent from fill callbacks queue into the fresh book for the next timestep.
+    std::swap(matching_orders_, pending_orders_);
     pending_orders_.clear();
+    const bool depth = fill_model_ == FillModel::Depth;
+    price_pending_orders(matching_orders_, depth ? &depth_ : nullptr);
+    if (depth) {
+        size_pending_orders(matching_orders_, fill_participation_, queue_ahead_);
+    }
+    for (size_t i = 0; i < matching_orders_.size(); ++i) {
+        if (!fill_pending_order(matching_orders_, i)) {
+            continue;
+        }
+        // Remainder keeps its queue position, ahead of orders sent this timestep.
+        carried_orders_.append(matching_orders_, i);
+        carried_orders_.remaining.back() -= matching_orders_.fill_volume[i];
+        carried_orders_.traded.back() += matching_orders_.fill_volume[i];
+        carried_orders_.carried.back() = 1;
+    }
+    matching_orders_.clear();
+    if (carried_orders_.size() != 0) {
+        for (size_t i = 0; i < pending_orders_.size(); ++i) {
+            carried_orders_.append(pending_orders_, i);
+        }
+        std::swap(pending_orders_, carried_orders_);
+        carried_orders_.clear();
+    }
+}
+
+void BacktestEngine::configure_snapshots(bool streaming, size_t ring_size, bool sparse,
+                                         std::chrono::nanoseconds bar) {
+    if (main_engine_) {
+        BacktestDataEngine* de = main_engine_->ensure_data_engine();
+        de->set_streaming(streaming, ring_size);
+        de->set_sparse_snapshots(sparse);
+        de->set_bar_interval(bar);
+    }
+}
+
+void BacktestEngine::configure_loader(std::optional<Timestamp> start,
+                                      std::optional<Timestamp> end, bool persist_sort_index,
+                                      std::string snapshot_cache_dir) {
+    if (main_engine_) {
+        BacktestDataEngine* de = main_engine_->ensure_data_engine();
+        de->set_time_range(start, end);
+        de->set_persist_sort_index(persist_sort_index);
+        de->set_snapshot_cache_dir(std::move(snapshot_cache_dir));
+    }
+}
+
+void BacktestEngine::configure_pricing(double risk_free_rate, std::string const& iv_price_mode,
+                                       bool incremental, double incremental_eps,
+                                       double incremental_tau_eps, bool precompute_greeks) {
+    if (main_engine_) {
+        BacktestDataEngine* de = main_engine_->ensure_data_engine();
+        de->set_risk_free_rate(risk_free_rate);
+        de->set_iv_price_mode(iv_price_mode);
+        de->set_incremental(incremental, incremental_eps, incremental_tau_eps);
+        de->set_precompute_greeks(precompute_greeks);
+    }
 }
 
 void BacktestEngine::load_backtest_data(std::string const& parquet_path,
@@ -269,6 +592,51 @@ void BacktestEngine::load_backtest_data(std::string const& parquet_path,
     }
 }
 
+void BacktestEngine::load_synchronized_data(std::vector<std::string> const& parquet_paths) {
+    if (main_engine_) {
+        main_engine_->load_synchronized_data(parquet_paths);
+    }
+}
+
+void BacktestEngine::attach_backtest_data(BacktestEngine const& source) {
+    const BacktestDataEngine* src =
+        source.main_engine_ ? source.main_engine_->get_data_engine() : nullptr;
+    if (main_engine_ && src != nullptr) {
+        main_engine_->ensure_data_engine()->attach(*src);
+    }
+}
+
+auto BacktestEngine::run_sweep(std::string const& strategy_name,
+                               std::vector<StrategySetting> const& settings,
+                               unsigned int n_workers) const -> std::vector<SweepResult> {
+    std::vector<SweepResult> results(settings.size());
+    const BacktestDataEngine* src = main_engine_ ? main_engine_->get_data_engine() : nullptr;
+    if ((src == nullptr) || !src->has_data() || src->streaming()) {
+        for (size_t i = 0; i < settings.size(); ++i) {
+            results[i].setting = settings[i];
+            results[i].result.strategy_name = strategy_name;
+            results[i].result.errors.emplace_back(
+                "Sweep needs loaded, non-streaming data. Call load_backtest_data() first.");
+        }
+        return results;
+    }
+    BacktestScheduler scheduler(std::vector<uint64_t>(settings.size(), 1), n_workers);
+    scheduler.run([this, &strategy_name, &settings, &results](unsigned int, size_t i) {
+        BacktestEngine engine;
+        engine.configure_execution(fee_rate_, slippage_bps_);
+        engine.configure_fill_model(fill_model_, fill_participation_, queue_ahead_);
+        engine.main_engine()->set_log_level(main_engine_->log_level());
+        engine.attach_backtest_data(*this);
+        engine.add_strategy(strategy_name, settings[i]);
+        results[i].setting = settings[i];
+        results[i].result = engine.run();
+        results[i].fees = engine.get_cumulative_fees();
+        results[i].peak_pnl = engine.get_peak_pnl();
+        results[i].trough_pnl = engine.get_trough_pnl();
+    });
+    return results;
+}
+
 void BacktestEngine::add_strategy(std::string const& strategy_name,
                                   std::unordered_map<std::string, double> const& setting) {
     strategy_name_ = strategy_name;
@@ -306,7 +674,12 @@ auto BacktestEngine::run() -> BacktestResult {
     result.errors = errors_;
 
     BacktestDataEngine* data_engine = main_engine_ ? main_engine_->get_data_engine() : nullptr;
-    if ((data_engine == nullptr) || !data_engine->has_data()) {
+    MultiSourceDataEngine* synced_data =
+        main_engine_ ? main_engine_->get_multi_data_engine() : nullptr;
+    if ((synced_data != nullptr) && !synced_data->has_data()) {
+        synced_data = nullptr;
+    }
+    if ((synced_data == nullptr) && ((data_engine == nullptr) || !data_engine->has_data())) {
         result.errors.emplace_back("No data loaded. Call main_engine.load_backtest_data() first.");
         return result;
     }
@@ -337,51 +710,106 @@ auto BacktestEngine::run() -> BacktestResult {
     Timestamp end_time = start_time;
     int step_count = 0;
     int64_t total_rows = 0;
+    metrics_.clear();
+    fills_.clear();
+    if (record_metrics_) {
+        // One row per bar; streaming and synchronized runs do not know the count up front.
+        const size_t n =
+            synced_data != nullptr ? 0 : data_engine->get_precomputed_snapshot_count();
+        metrics_.reserve(n > 0 ? n : 512);
+    }
 
-    data_engine->iter_timesteps(
-        [this, &result, &start_time, &end_time, &step_count, &total_rows, data_engine,
-         strategy_engine](Timestamp ts, TimestepFrameColumnar const& frame) -> bool {
+    // Timer wheel: exactly one tick per timestep, the bar when resampling (so timer_interval_ms
+    // is bar time) and kTimerTick for raw timesteps; timer_trigger then counts timesteps.
+    EventEngine* event_engine = main_engine_->event_engine();
+    const std::chrono::nanoseconds bar = synced_data != nullptr
+                                             ? synced_data->source(0)->bar_interval()
+                                             : data_engine->bar_interval();
+    const auto tick = bar >= std::chrono::milliseconds(1)
+                          ? std::chrono::duration_cast<std::chrono::milliseconds>(bar)
+                          : EventEngine::kTimerTick;
+    event_engine->set_timer_tick(tick);
+
+    // One timestep: the snapshots of every portfolio with data at ts (one unless synchronized).
+    using Snapshots = std::span<const utilities::PortfolioSnapshot* const>;
+    const auto step = [this, &result, &start_time, &end_time, &step_count, &total_rows,
+                       strategy_engine, event_engine, tick](Timestamp ts, int64_t num_rows,
+                                                            Snapshots snapshots) -> bool {
+        if (step_count == 0) {
+            start_time = ts;
+        }
+        end_time = ts;
+        current_ts_ = ts;
+        // Snapshot(step_count) = end-of-bar for this minute; portfolio gets bar's BBO.
+        // Borrowed: dispatch is synchronous and the frame outlives this callback.
+        if (snapshots.size() == 1) {
+            main_engine_->put_event(utilities::Event(
+                utilities::EventType::Snapshot, utilities::borrow_snapshot(*snapshots[0])));
+        } else {
+            main_engine_->event_engine()->put_snapshots(snapshots);
+        }
+        current_timestep_ = step_count + 1;
+        total_rows += num_rows;
+
+        // Execute pending (next-bar)
+        if (fill_model_ == FillModel::Depth) {
+            for (const utilities::PortfolioSnapshot* snapshot : snapshots) {
+                track_depth(*snapshot);
+            }
+        }
+        execute_pending_orders();
+
+        // Timer: strategy runs, may send orders
+        // Wheel time counts timesteps, not data time: gaps (overnight, halts) and sub-tick
+        // spacing would otherwise skip or stall periods.
+        event_engine->set_clock(start_time + tick * step_count);
+        main_engine_->put_event(utilities::Event(utilities::EventType::Timer));
+
+        auto* holding = strategy_engine->get_strategy_holding();
+        if (holding) {
+            current_pnl_ = holding->summary.pnl;
+            current_delta_ = holding->summary.delta;
+            max_delta_ = std::max(std::abs(holding->summary.delta), max_delta_);
+            max_gamma_ = std::max(std::abs(holding->summary.gamma), max_gamma_);
+            max_theta_ = std::max(std::abs(holding->summary.theta), max_theta_);
+
+            // Peak PnL, drawdown
             if (step_count == 0) {
-                start_time = ts;
+                peak_pnl_ = current_pnl_;
+                trough_pnl_ = current_pnl_;
+            } else {
+                peak_pnl_ = std::max(current_pnl_, peak_pnl_);
+                trough_pnl_ = std::min(current_pnl_, trough_pnl_);
             }
-            end_time = ts;
-            // Snapshot(step_count) = end-of-bar for this minute; portfolio gets bar's BBO.
-            main_engine_->put_event(utilities::Event(
-                utilities::EventType::Snapshot, data_engine->get_precomputed_snapshot(step_count)));
-            current_timestep_ = step_count + 1;
-            total_rows += frame.num_rows;
-
-            // Execute pending (next-bar)
-            execute_pending_orders();
-
-            // Timer: strategy runs, may send orders
-            main_engine_->put_event(utilities::Event(utilities::EventType::Timer));
-
-            auto* holding = strategy_engine->get_strategy_holding();
-            if (holding) {
-                current_pnl_ = holding->summary.pnl;
-                current_delta_ = holding->summary.delta;
-                max_delta_ = std::max(std::abs(holding->summary.delta), max_delta_);
-                max_gamma_ = std::max(std::abs(holding->summary.gamma), max_gamma_);
-                max_theta_ = std::max(std::abs(holding->summary.theta), max_theta_);
-
-                // Peak PnL, drawdown
-                if (step_count == 0) {
-                    peak_pnl_ = current_pnl_;
-                } else {
-                    peak_pnl_ = std::max(current_pnl_, peak_pnl_);
-                }
-                double drawdown = peak_pnl_ - current_pnl_;
-                max_drawdown_ = std::max(drawdown, max_drawdown_);
+            double drawdown = peak_pnl_ - current_pnl_;
+            max_drawdown_ = std::max(drawdown, max_drawdown_);
+        }
+        if (record_metrics_) {
+            if (holding != nullptr) {
+                const auto& sum = holding->summary;
+                metrics_.push(ts, sum.pnl, sum.delta, sum.gamma, sum.theta, cumulative_fees_);
+            } else {
+                metrics_.push(ts, 0.0, 0.0, 0.0, 0.0, cumulative_fees_);
             }
+        }
 
-            for (auto const& cb : timestep_callbacks_) {
-                cb(current_timestep_, ts);
-            }
-            step_count++;
-            result.processed_timesteps = step_count;
-            return true;
-        });
+        for (auto const& cb : timestep_callbacks_) {
+            cb(current_timestep_, ts);
+        }
+        step_count++;
+        result.processed_timesteps = step_count;
+        return true;
+    };
+    if (synced_data != nullptr) {
+        synced_data->for_each_step(step);
+    } else {
+        data_engine->for_each_snapshot(
+            [&step](Timestamp ts, int64_t num_rows,
+                    utilities::PortfolioSnapshot const& snapshot) -> bool {
+                const utilities::PortfolioSnapshot* one = &snapshot;
+                return step(ts, num_rows, Snapshots(&one, 1));
+            });
+    }
 
     result.start_time = start_time;
     result.end_time = end_time;
@@ -414,14 +842,19 @@ void BacktestEngine::reset() {
     max_gamma_ = 0.0;
     max_theta_ = 0.0;
     peak_pnl_ = 0.0;
+    trough_pnl_ = 0.0;
     max_drawdown_ = 0.0;
     total_orders_ = 0;
     cumulative_fees_ = 0.0;
     errors_.clear();
     timestep_callbacks_.clear();
+    metrics_.clear();
+    fills_.clear();
     strategy_name_.clear();
     strategy_setting_.clear();
     pending_orders_.clear();
+    carried_orders_.clear();
+    depth_.clear();
     order_counter_ = 0;
     trade_counter_ = 0;
 
@@ -4,9 +4,14 @@
 #include "engine_data_historical.hpp"
 #include "engine_main.hpp"
 #include "object.hpp"
+#include "symbol_table.hpp"
 #include "types.hpp"
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <optional>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -14,6 +19,81 @@
 
 namespace backtest {
 
+using StrategySetting = std::unordered_map<std::string, double>;
+
+/** One parameter set of a sweep and how it did. */
+struct SweepResult {
+    StrategySetting setting;
+    BacktestResult result;
+    double fees = 0.0;
+    /** Highest and lowest PnL of the run, to stitch drawdowns across consecutive files. */
+    double peak_pnl = 0.0;
+    double trough_pnl = 0.0;
+};
+
+/**
+ * Per-timestep run metrics as columns (BacktestEngine::record_metrics). Timestamps stay raw;
+ * formatting is left to whoever writes the output.
+ */
+struct MetricsRecorder {
+    std::vector<Timestamp> timestamps;
+    std::vector<double> pnl, delta, gamma, theta, fees;
+
+    [[nodiscard]] size_t size() const { return timestamps.size(); }
+    void reserve(size_t n);
+    void clear();
+    void push(Timestamp ts, double step_pnl, double step_delta, double step_gamma,
+              double step_theta, double step_fees);
+};
+
+/**
+ * Order updates and trades of a run as columns (BacktestEngine::record_fills), stamped with the
+ * bar they happened at. Enums stay raw; combo leg trades get a row each.
+ */
+struct FillRecorder {
+    std::vector<Timestamp> order_ts;
+    std::vector<std::string> order_id, order_symbol;
+    std::vector<utilities::Direction> order_direction;
+    std::vector<utilities::Status> order_status;
+    std::vector<double> order_price, order_volume, order_traded;
+
+    std::vector<Timestamp> trade_ts;
+    std::vector<std::string> trade_id, trade_orderid, trade_symbol;
+    std::vector<utilities::Direction> trade_direction;
+    std::vector<double> trade_price, trade_volume;
+
+    void clear();
+    void add_order(Timestamp ts, const utilities::OrderData& order);
+    void add_trade(Timestamp ts, const utilities::TradeData& trade);
+};
+
+/** Recorders of consecutive runs (one per file) joined by moving them in; columns not copied. */
+class MetricsSeries {
+  public:
+    void append(MetricsRecorder&& part);
+    [[nodiscard]] size_t size() const { return offsets_.back(); }
+    [[nodiscard]] bool empty() const { return size() == 0; }
+    [[nodiscard]] std::span<const MetricsRecorder> parts() const { return parts_; }
+    /** Part holding global step i (< size()) and the row within it. */
+    [[nodiscard]] std::pair<const MetricsRecorder*, size_t> locate(size_t i) const;
+
+  private:
+    std::vector<MetricsRecorder> parts_;
+    /** offsets_[k] = global index of parts_[k]'s first row; back() = size(). */
+    std::vector<size_t> offsets_{0};
+};
+
+/** How pending orders meet the book at the next bar. */
+enum class FillModel {
+    /** Whole order at the touch; displayed sizes ignored. */
+    TopOfBook,
+    /**
+     * Fill capped by displayed size at the touch (bid_sz/ask_sz, min over combo legs); the rest
+     * keeps working at later bars behind an estimated queue. Unknown (0) sizes do not cap.
+     */
+    Depth,
+};
+
 class BacktestEngine {
   public:
     using TimestepCallback = std::function<void(int timestep, Timestamp)>;
@@ -22,15 +102,66 @@ class BacktestEngine {
 
     void load_backtest_data(std::string const& parquet_path,
                             std::string const& underlying_symbol = "");
+    /** Use source's loaded data (shared read-only snapshots) instead of loading; source must
+     * outlive this engine's runs. */
+    void attach_backtest_data(BacktestEngine const& source);
+    /**
+     * Multi-underlying run: parquet_paths (one underlying each) merged onto one clock; the first
+     * is the strategy's portfolio, the others are reachable by underlying symbol and tradable
+     * (orders fill against the portfolio listing their symbol). Loader, snapshot and pricing
+     * settings come from configure_*; streaming and the snapshot cache do not apply.
+     */
+    void load_synchronized_data(std::vector<std::string> const& parquet_paths);
 
     void add_strategy(std::string const& strategy_name,
                       std::unordered_map<std::string, double> const& setting = {});
 
     void register_timestep_callback(TimestepCallback cb);
+    /** Record pnl/Greeks/fees per timestep into the built-in columnar recorder during run(). */
+    void record_metrics(bool enabled) { record_metrics_ = enabled; }
+    [[nodiscard]] MetricsRecorder const& metrics() const { return metrics_; }
+    /** Move the last run's recorded metrics out (e.g. into a MetricsSeries). */
+    MetricsRecorder take_metrics() { return std::move(metrics_); }
+    /** Record every order update and trade of run() into a FillRecorder. */
+    void record_fills(bool enabled) { record_fills_ = enabled; }
+    [[nodiscard]] FillRecorder const& fills() const { return fills_; }
+    FillRecorder take_fills() { return std::move(fills_); }
     void configure_execution(double fee_rate, double slippage_bps = 5.0);
+    /**
+     * Fill model. Depth: an order takes at most participation of the displayed size per bar,
+     * after queue_ahead x the size displayed when it first reached the book has been worked off.
+     */
+    void configure_fill_model(FillModel model, double participation = 1.0,
+                              double queue_ahead = 0.0);
+    /** Snapshot storage (streamed through a ring, sparse updates, bar resampling with 0 = every
+     * timestamp); call before load. */
+    void configure_snapshots(bool streaming, size_t ring_size = 4, bool sparse = false,
+                             std::chrono::nanoseconds bar = std::chrono::nanoseconds::zero());
+    /**
+     * Parquet loading: backtest only [start, end), persist the sort index, mmap snapshot cache
+     * directory (empty = off); call before load.
+     */
+    void configure_loader(std::optional<Timestamp> start, std::optional<Timestamp> end,
+                          bool persist_sort_index = false, std::string snapshot_cache_dir = "");
+    /** Snapshot pricing (rate, IV mode, incremental, precomputed Greeks); call before load. */
+    void configure_pricing(double risk_free_rate, std::string const& iv_price_mode,
+                           bool incremental = false, double incremental_eps = 0.0,
+                           double incremental_tau_eps =
+                               utilities::PortfolioData::kDefaultTauEpsilon,
+                           bool precompute_greeks = false);
     double get_cumulative_fees() const { return cumulative_fees_; }
+    double get_peak_pnl() const { return peak_pnl_; }
+    double get_trough_pnl() const { return trough_pnl_; }
 
     BacktestResult run();
+    /**
+     * Parameter sweep over this engine's loaded data: one isolated engine (own portfolio,
+     * position and execution state) per setting, run in parallel on the shared pool against
+     * the same snapshots. Needs materialized snapshots (not streaming). Results in input order.
+     */
+    std::vector<SweepResult> run_sweep(std::string const& strategy_name,
+                                       std::vector<StrategySetting> const& settings,
+                                       unsigned int n_workers = 0) const;
 
     std::unordered_map<std::string, double> get_current_state() const;
 
@@ -46,21 +177,96 @@ class BacktestEngine {
     void close();
 
   private:
-    /** Queue order for next timestep; returns orderid. */
+    /** Quote source of one order leg, resolved at submit_order. */
+    struct QuoteHandle {
+        static constexpr uint32_t kUnresolved = UINT32_MAX;
+        static constexpr uint32_t kUnderlying = UINT32_MAX - 1;
+        /** OptionColumns slot, kUnderlying, or kUnresolved (quotes 0). */
+        uint32_t slot = kUnresolved;
+        /** |ratio| of a combo leg; 1 for a single-leg order. */
+        double quantity = 1.0;
+        /** Leg lifts the ask (else hits the bid), after the order's direction. */
+        uint8_t buy = 1;
+    };
+    /** Displayed sizes of one portfolio's current bar by OptionColumns slot; empty = unknown. */
+    struct QuoteDepth {
+        const utilities::PortfolioData* portfolio = nullptr;
+        std::span<const double> bid_sz{}, ask_sz{};
+        double underlying_bid_sz = 0.0;
+        double underlying_ask_sz = 0.0;
+        /** Sparse snapshots: sizes scattered across bars. */
+        std::vector<double> scattered_bid_sz{}, scattered_ask_sz{};
+    };
+    /**
+     * Orders sent during a timestep, flattened for one matching pass: order i owns legs
+     * [leg_begin[i], leg_begin[i + 1]) (one leg for a single-leg order).
+     */
+    struct PendingBook {
+        std::vector<std::string> orderids;
+        std::vector<utilities::OrderRequest> requests;
+        std::vector<const utilities::PortfolioData*> portfolios;
+        /** Priced from its legs (every leg must have a quote); else from the order symbol. */
+        std::vector<uint8_t> combo;
+        /** Combo with a leg lacking a symbol: never fills. */
+        std::vector<uint8_t> broken;
+        std::vector<uint32_t> leg_begin{0};
+        std::vector<QuoteHandle> legs;
+        /** Working state: volume left, volume traded, queue ahead (< 0 = not yet at the book). */
+        std::vector<double> remaining, traded, queue;
+        /** Carried from an earlier bar (its Order was already emitted). */
+        std::vector<uint8_t> carried;
+        /** Per-leg quotes and per-order totals, filled by price_pending_orders. */
+        std::vector<double> leg_bid, leg_ask, total_bid, total_ask;
+        std::vector<uint8_t> priced;
+        /** Depth only: per-leg size at the taken side, per-order capacity and this bar's fill. */
+        std::vector<double> leg_size, capacity, fill_volume;
+
+        [[nodiscard]] size_t size() const { return orderids.size(); }
+        void clear();
+        /** Append order i of src with its legs and working state. */
+        void append(const PendingBook& src, size_t i);
+    };
+
+    /** Queue order for next timestep, legs resolved to quote handles; returns orderid. */
     std::string submit_order(const utilities::OrderRequest& req);
-    /** Execute one order (drain pending). */
-    void execute_order_impl(const utilities::OrderRequest& req, const std::string& orderid);
+    /** Quote source of id in portfolio (option slot or the underlying). */
+    static QuoteHandle resolve_quote(const utilities::PortfolioData* portfolio,
+                                     utilities::SymbolId id, double quantity, bool buy);
+    /**
+     * Gather every leg's bid/ask from the current portfolio columns and sum them per order in
+     * one pass over the book (no per-order strategy, portfolio or symbol lookups). With depth
+     * (one entry per portfolio), also gather each leg's size and the order's capacity (units the
+     * book can take).
+     */
+    static void price_pending_orders(PendingBook& book, const std::vector<QuoteDepth>* depth);
+    /**
+     * Depth kernel: this bar's fill_volume per order from capacity, working off the queue first;
+     * straight-line over the book (min/max, no per-order branching).
+     */
+    static void size_pending_orders(PendingBook& book, double participation,
+                                    double queue_ahead);
+    /** Point snapshot's portfolio depth at its sizes (dense) or scatter its updates (sparse). */
+    void track_depth(const utilities::PortfolioSnapshot& snapshot);
+    /**
+     * Match order i of a priced book and emit its Order (and Trade) events; true if it keeps
+     * working (Depth partial fill).
+     */
+    bool fill_pending_order(const PendingBook& book, size_t i);
     /** Run all pending orders (sent in previous timestep) with current step's market. */
     void execute_pending_orders();
-    /** (bid, ask) for symbol; (0,0) if not found. */
-    std::pair<double, double> get_market_bid_ask(const std::string& symbol) const;
     static double default_contract_size(const std::string& symbol);
-    double calculate_order_fee(const utilities::OrderRequest& req, double fill_price) const;
+    double calculate_order_fee(const utilities::OrderRequest& req, double volume) const;
 
     std::unique_ptr<MainEngine> main_engine_;
     std::string strategy_name_;
     std::unordered_map<std::string, double> strategy_setting_;
     std::vector<TimestepCallback> timestep_callbacks_;
+    bool record_metrics_ = false;
+    MetricsRecorder metrics_;
+    bool record_fills_ = false;
+    FillRecorder fills_;
+    /** Bar being run (stamps recorded fills). */
+    Timestamp current_ts_{};
     int current_timestep_ = 0;
     double current_pnl_ = 0.0;
     double current_delta_ = 0.0;
@@ -68,15 +274,25 @@ class BacktestEngine {
     double max_gamma_ = 0.0;
     double max_theta_ = 0.0;
     double peak_pnl_ = 0.0;
+    double trough_pnl_ = 0.0;
     double max_drawdown_ = 0.0;
     int total_orders_ = 0;
     std::vector<std::string> errors_;
     double fee_rate_ = 0.0;
     double slippage_bps_ = 5.0;
     double cumulative_fees_ = 0.0;
+    FillModel fill_model_ = FillModel::TopOfBook;
+    double fill_participation_ = 1.0;
+    double queue_ahead_ = 0.0;
+    /** Depth: one entry per portfolio (several in a multi-underlying run). */
+    std::vector<QuoteDepth> depth_;
 
     /** Orders sent this timestep; executed at start of next timestep. */
-    std::vector<std::pair<std::string, utilities::OrderRequest>> pending_orders_;
+    PendingBook pending_orders_;
+    /** Book being matched (swapped with pending_orders_, so fills may queue new orders). */
+    PendingBook matching_orders_;
+    /** Depth: partially filled orders, ahead of new ones at the next bar. */
+    PendingBook carried_orders_;
     int order_counter_ = 0;
     int trade_counter_ = 0;
 };
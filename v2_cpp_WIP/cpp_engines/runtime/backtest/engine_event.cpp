@@ -4,8 +4,11 @@
 #include "../../core/engine_option_strategy.hpp"
 #include "../../strategy/template.hpp"
 #include "../../utilities/intent.hpp"
+#include "../../utilities/thread_pool.hpp"
 #include "engine_main.hpp"
+#include <algorithm>
 #include <chrono>
+#include <memory_resource>
 #include <variant>
 
 namespace backtest {
@@ -45,31 +48,14 @@ void EventEngine::put_event(const utilities::Event& event) {
     if (main == nullptr) {
         return;
     }
-    std::vector<utilities::OrderRequest> orders;
-    std::vector<utilities::CancelRequest> cancels;
-    std::vector<utilities::LogData> logs;
     switch (event.type) {
         using enum utilities::EventType;
     case Snapshot:
         dispatch_snapshot(event);
         break;
-    case Timer: {
-        dispatch_timer(&orders, &cancels, &logs);
-        core::OptionStrategyEngine* se = main->option_strategy_engine();
-        std::string strategy_name = (se != nullptr && se->get_strategy() != nullptr)
-                                        ? se->get_strategy()->strategy_name()
-                                        : std::string{};
-        for (const auto& o : orders) {
-            put_intent(utilities::IntentSendOrder{strategy_name, o});
-        }
-        for (const auto& c : cancels) {
-            put_intent(utilities::IntentCancelOrder{c});
-        }
-        for (const auto& l : logs) {
-            put_intent(utilities::IntentLog{l});
-        }
+    case Timer:
+        dispatch_timer();
         break;
-    }
     case Order:
         dispatch_order(event);
         break;
@@ -86,7 +72,7 @@ void EventEngine::dispatch_snapshot(const utilities::Event& event) {
     if (main == nullptr) {
         return;
     }
-    if (const auto* snap = std::get_if<utilities::PortfolioSnapshot>(&event.data)) {
+    if (const utilities::PortfolioSnapshot* snap = event.snapshot()) {
         utilities::PortfolioData* portfolio = main->get_portfolio(snap->portfolio_name);
         if (portfolio != nullptr) {
             portfolio->apply_frame(*snap);
@@ -94,43 +80,121 @@ void EventEngine::dispatch_snapshot(const utilities::Event& event) {
     }
 }
 
-void EventEngine::dispatch_timer(std::vector<utilities::OrderRequest>* out_orders,
-                                 std::vector<utilities::CancelRequest>* out_cancels,
-                                 std::vector<utilities::LogData>* out_logs) {
+void EventEngine::put_snapshots(std::span<const utilities::PortfolioSnapshot* const> snapshots) {
     auto* main = static_cast<MainEngine*>(main_engine);
     if (main == nullptr) {
         return;
     }
+    // apply_frame touches only its own portfolio, so distinct portfolios apply side by side.
+    std::pmr::vector<std::pair<utilities::PortfolioData*, const utilities::PortfolioSnapshot*>>
+        work(frame_arena_.resource());
+    work.reserve(snapshots.size());
+    for (const utilities::PortfolioSnapshot* snap : snapshots) {
+        if (utilities::PortfolioData* portfolio = main->get_portfolio(snap->portfolio_name)) {
+            work.emplace_back(portfolio, snap);
+        }
+    }
+    utilities::ThreadPool::shared().parallel_for(
+        work.size(),
+        [&work](size_t begin, size_t end) -> void {
+            for (size_t i = begin; i < end; ++i) {
+                work[i].first->apply_frame(*work[i].second);
+            }
+        },
+        1);
+}
+
+void EventEngine::dispatch_timer() {
+    sync_timers();
+    const auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        clock_.time_since_epoch());
+    if (!anchored_) {
+        // Origin one tick before the first bar: a timer of N ticks first fires on bar N.
+        anchored_ = true;
+        timers_.advance(now - timer_tick_);
+    }
+    timers_.advance(now);
+    frame_arena_.reset();
+}
+
+void EventEngine::sync_timers() {
+    auto* main = static_cast<MainEngine*>(main_engine);
     core::OptionStrategyEngine* se = main->option_strategy_engine();
     if ((se == nullptr) || (se->get_strategy() == nullptr)) {
         return;
     }
-    se->get_strategy()->on_timer();
-    engines::PositionEngine* pos = main->position_engine();
-    if ((pos != nullptr) && (se->get_strategy() != nullptr)) {
-        auto* portfolio = main->get_portfolio(se->get_strategy()->portfolio_name());
-        if (portfolio != nullptr) {
-            pos->update_metrics(se->get_strategy()->strategy_name(), portfolio);
+    if (!strategy_timers_) {
+        strategy_timers_ = true;
+        // Registration order = firing order on a shared bar: strategy, metrics, then hedging.
+        timers_.add(se->get_strategy()->timer_period(timer_tick_), [se]() {
+            if (se->get_strategy() != nullptr) {
+                se->get_strategy()->on_timer();
+            }
+        });
+        timers_.add(timer_tick_, [main, se]() {
+            engines::PositionEngine* pos = main->position_engine();
+            if ((pos == nullptr) || (se->get_strategy() == nullptr)) {
+                return;
+            }
+            auto* portfolio = main->get_portfolio(se->get_strategy()->portfolio_name());
+            if (portfolio != nullptr) {
+                pos->update_metrics(se->get_strategy()->strategy_name(), portfolio,
+                                    main->synced_portfolios());
+            }
+        });
+    }
+    engines::HedgeEngine* hedge = main->hedge_engine();
+    int trigger = 0;
+    if (hedge != nullptr) {
+        const auto it = hedge->registered_strategies().find(se->get_strategy()->strategy_name());
+        if (it != hedge->registered_strategies().end()) {
+            trigger = std::max(it->second.timer_trigger, 1);
         }
     }
+    if (trigger == hedge_trigger_) {
+        return;
+    }
+    if (hedge_timer_) {
+        timers_.cancel(*hedge_timer_);
+        hedge_timer_.reset();
+    }
+    hedge_trigger_ = trigger;
+    if (trigger > 0) {
+        hedge_timer_ = timers_.add(timer_tick_ * trigger, [this]() { run_hedging(); });
+    }
+}
+
+void EventEngine::run_hedging() {
+    auto* main = static_cast<MainEngine*>(main_engine);
+    core::OptionStrategyEngine* se = main->option_strategy_engine();
     engines::HedgeEngine* hedge = main->hedge_engine();
-    if ((hedge != nullptr) && (se->get_strategy() != nullptr) &&
-        ((out_orders != nullptr) || (out_cancels != nullptr) || (out_logs != nullptr))) {
-        engines::HedgeParams params;
-        params.portfolio = main->get_portfolio(se->get_strategy()->portfolio_name());
-        params.holding = main->get_holding(se->get_strategy()->strategy_name());
-        params.get_contract = [main](const std::string& sym) -> const utilities::ContractData* {
-            return main->get_contract(sym);
-        };
-        params.get_strategy_active_orders =
-            [se]() -> const std::unordered_map<std::string, std::set<std::string>>& {
-            return se->get_strategy_active_orders();
-        };
-        params.get_order = [se](const std::string& oid) -> utilities::OrderData* {
-            return se->get_order(oid);
-        };
-        hedge->process_hedging(se->get_strategy()->strategy_name(), params, out_orders, out_cancels,
-                               out_logs);
+    if ((hedge == nullptr) || (se == nullptr) || (se->get_strategy() == nullptr)) {
+        return;
+    }
+    const std::string& strategy_name = se->get_strategy()->strategy_name();
+    engines::HedgeParams params;
+    params.portfolio = main->get_portfolio(se->get_strategy()->portfolio_name());
+    params.holding = main->get_holding(strategy_name);
+    params.get_contract = [main](const std::string& sym) -> const utilities::ContractData* {
+        return main->get_contract(sym);
+    };
+    params.for_each_active_order =
+        [se](const std::string& name,
+             const std::function<void(const utilities::OrderData&)>& fn) -> void {
+        se->for_each_active_order(name, fn);
+    };
+    std::pmr::vector<utilities::OrderRequest> orders(frame_arena_.resource());
+    std::pmr::vector<utilities::CancelRequest> cancels(frame_arena_.resource());
+    std::pmr::vector<utilities::LogData> logs(frame_arena_.resource());
+    hedge->process_hedging(strategy_name, params, &orders, &cancels, &logs);
+    for (const auto& o : orders) {
+        put_intent(utilities::IntentSendOrder{strategy_name, o});
+    }
+    for (const auto& c : cancels) {
+        put_intent(utilities::IntentCancelOrder{c});
+    }
+    for (const auto& l : logs) {
+        put_intent(utilities::IntentLog{l});
     }
 }
 
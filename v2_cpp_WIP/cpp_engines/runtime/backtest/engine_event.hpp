@@ -1,12 +1,27 @@
 #pragma once
 
-/** EventEngine: dispatch by event type and fixed order; no engines held; access via Main. */
+/**
+ * EventEngine: dispatch by event type and fixed order; no engines held; access via Main.
+ * put_event dispatches synchronously. Each timestep BacktestEngine emits the bar's Snapshot, then
+ * Order/Trade from matching pending orders, then Timer, so (as with the live priority lanes)
+ * fills reach PositionEngine before the Timer that runs strategies and hedging.
+ * Strategy, metrics and hedge timers share a timer wheel driven by set_clock. BacktestEngine
+ * advances it exactly one timer tick per timestep (the bar interval when resampling, else
+ * kTimerTick), so timer_trigger counts timesteps; a journal replay drives it by wall time.
+ * Intent out-vectors of the timers come from a FrameArena reset after each Timer.
+ * A multi-underlying run hands the timestep's snapshots over together (put_snapshots); they are
+ * applied in parallel, one portfolio each, before the Timer.
+ */
 
 #include "../../utilities/base_engine.hpp"
 #include "../../utilities/event.hpp"
+#include "../../utilities/frame_arena.hpp"
 #include "../../utilities/intent.hpp"
 #include "../../utilities/portfolio.hpp"
+#include "../../utilities/timer_wheel.hpp"
+#include <chrono>
 #include <optional>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -27,14 +42,41 @@ class EventEngine : public utilities::BaseEngine {
     /** Intent entry; SendOrder→orderid, others→nullopt. */
     std::optional<std::string> put_intent(const utilities::Intent& intent);
     void put_event(const utilities::Event& event);
+    /** Snapshots of one timestep for distinct portfolios, applied in parallel (blocks). */
+    void put_snapshots(std::span<const utilities::PortfolioSnapshot* const> snapshots);
+
+    /** Wheel time the next Timer advances to. */
+    void set_clock(std::chrono::system_clock::time_point now) { clock_ = now; }
+    utilities::TimerWheel& timers() { return timers_; }
+    /** Memory for containers that die with the current timestep (reset after its Timer). */
+    utilities::FrameArena& frame_arena() { return frame_arena_; }
+
+    /** Timer tick of raw (not resampled) timesteps: one notional minute per timestep. */
+    static constexpr std::chrono::milliseconds kTimerTick = std::chrono::seconds(60);
+    /**
+     * Tick the strategy, metrics and hedge periods are multiples of; a journal replay uses the
+     * live engine's tick. Set before the first Timer.
+     */
+    void set_timer_tick(std::chrono::milliseconds tick) { timer_tick_ = tick; }
+    [[nodiscard]] std::chrono::milliseconds timer_tick() const { return timer_tick_; }
 
   private:
     void dispatch_snapshot(const utilities::Event& event);
-    void dispatch_timer(std::vector<utilities::OrderRequest>* out_orders,
-                        std::vector<utilities::CancelRequest>* out_cancels,
-                        std::vector<utilities::LogData>* out_logs);
+    void dispatch_timer();
+    /** Strategy and metrics timers once the strategy exists; hedge timer follows registration. */
+    void sync_timers();
+    void run_hedging();
     void dispatch_order(const utilities::Event& event);
     void dispatch_trade(const utilities::Event& event);
+
+    utilities::TimerWheel timers_;
+    utilities::FrameArena frame_arena_;
+    std::chrono::system_clock::time_point clock_{};
+    std::chrono::milliseconds timer_tick_ = kTimerTick;
+    bool anchored_ = false;
+    bool strategy_timers_ = false;
+    std::optional<utilities::TimerWheel::TimerId> hedge_timer_;
+    int hedge_trigger_ = 0;
 };
 
 } // namespace backtest
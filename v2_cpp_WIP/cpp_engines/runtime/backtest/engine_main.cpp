@@ -5,6 +5,7 @@
 #include "../../utilities/intent.hpp"
 #include "../../utilities/utility.hpp"
 #include "engine_data_historical.hpp"
+#include "engine_data_multi.hpp"
 #include <stdexcept>
 
 namespace backtest {
@@ -58,19 +59,18 @@ MainEngine::MainEngine() {
         return execution_engine_ ? execution_engine_->get_all_active_orders()
                                  : std::vector<utilities::OrderData>{};
     };
-    api.execution.get_strategy_active_orders =
-        [this]() -> const std::unordered_map<std::string, std::set<std::string>>& {
-        static const std::unordered_map<std::string, std::set<std::string>> empty;
-        return execution_engine_ ? execution_engine_->get_strategy_active_orders() : empty;
+    api.execution.for_each_active_order =
+        [this](const std::string& name,
+               const std::function<void(const utilities::OrderData&)>& fn) -> void {
+        if (execution_engine_) {
+            execution_engine_->for_each_active_order(name, fn);
+        }
     };
     api.execution.remove_order_tracking = [this](const std::string& oid) -> void {
         if (execution_engine_) {
             execution_engine_->remove_order_tracking(oid);
         }
     };
-    api.execution.get_active_order_ids = [this]() -> std::unordered_set<std::string>& {
-        return execution_engine_ ? execution_engine_->active_order_ids() : dummy_active_ids_;
-    };
     api.execution.ensure_strategy_key = [this](const std::string& name) -> void {
         if (execution_engine_) {
             execution_engine_->ensure_strategy_key(name);
@@ -139,16 +139,37 @@ auto MainEngine::get_contract(const std::string& symbol) const -> const utilitie
     return (it != contracts_.end()) ? &it->second : nullptr;
 }
 
-auto MainEngine::load_backtest_data(const std::string& parquet_path,
-                                    const std::string& underlying_symbol) -> BacktestDataEngine* {
+auto MainEngine::ensure_data_engine() -> BacktestDataEngine* {
     if (!data_engine_) {
         data_engine_ = std::make_unique<BacktestDataEngine>(this);
     }
-    data_engine_->load_parquet(parquet_path, "ts_recv", underlying_symbol);
+    return data_engine_.get();
+}
+
+auto MainEngine::load_backtest_data(const std::string& parquet_path,
+                                    const std::string& underlying_symbol) -> BacktestDataEngine* {
+    ensure_data_engine()->load_parquet(parquet_path, "ts_recv", underlying_symbol);
     put_log_intent("Backtest data loaded from: " + parquet_path, INFO);
     return data_engine_.get();
 }
 
+auto MainEngine::load_synchronized_data(const std::vector<std::string>& parquet_paths)
+    -> MultiSourceDataEngine* {
+    if (!multi_data_engine_) {
+        multi_data_engine_ = std::make_unique<MultiSourceDataEngine>(this);
+    }
+    multi_data_engine_->load(parquet_paths, *ensure_data_engine());
+    put_log_intent("Synchronized backtest data loaded: " + std::to_string(parquet_paths.size()) +
+                       " files",
+                   INFO);
+    return multi_data_engine_.get();
+}
+
+auto MainEngine::synced_portfolios() const -> std::span<const utilities::PortfolioData* const> {
+    return multi_data_engine_ ? multi_data_engine_->portfolios()
+                              : std::span<const utilities::PortfolioData* const>{};
+}
+
 void MainEngine::put_event(const utilities::Event& e) { event_engine_->put_event(e); }
 
 auto MainEngine::send_order(const utilities::OrderRequest& req) -> std::string {
@@ -246,6 +267,8 @@ auto MainEngine::combo_builder_engine() -> engines::ComboBuilderEngine* {
 auto MainEngine::hedge_engine() -> engines::HedgeEngine* {
     if (!hedge_engine_) {
         hedge_engine_ = std::make_unique<engines::HedgeEngine>(this);
+        hedge_engine_->set_log_filter(
+            [this](int level) -> bool { return log_engine_ && log_engine_->accepts(level); });
     }
     return hedge_engine_.get();
 }
@@ -16,13 +16,15 @@
 #include "engine_event.hpp"
 #include <functional>
 #include <memory>
+#include <span>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
+#include <vector>
 
 namespace backtest {
 
 class BacktestDataEngine;
+class MultiSourceDataEngine;
 
 class MainEngine : public utilities::MainEngine {
   public:
@@ -40,6 +42,16 @@ class MainEngine : public utilities::MainEngine {
     BacktestDataEngine* load_backtest_data(const std::string& parquet_path,
                                            const std::string& underlying_symbol = "");
     BacktestDataEngine* get_data_engine() const { return data_engine_.get(); }
+    /** Data engine, created if needed so it can be configured before load_backtest_data. */
+    BacktestDataEngine* ensure_data_engine();
+    /**
+     * Multi-underlying run: parquet_paths (one underlying each) on one merged clock, loaded with
+     * the data engine's settings; the first file is the strategy's portfolio ("backtest").
+     */
+    MultiSourceDataEngine* load_synchronized_data(const std::vector<std::string>& parquet_paths);
+    MultiSourceDataEngine* get_multi_data_engine() const { return multi_data_engine_.get(); }
+    /** Portfolios of a multi-underlying run, the strategy's first; empty otherwise. */
+    std::span<const utilities::PortfolioData* const> synced_portfolios() const;
 
     std::string send_order(const utilities::OrderRequest& req);
     void add_order(std::string orderid, utilities::OrderData order);
@@ -101,11 +113,11 @@ class MainEngine : public utilities::MainEngine {
     std::unique_ptr<core::ExecutionEngine> execution_engine_;
     std::unique_ptr<core::OptionStrategyEngine> option_strategy_engine_;
     std::unique_ptr<BacktestDataEngine> data_engine_;
+    std::unique_ptr<MultiSourceDataEngine> multi_data_engine_;
     std::unique_ptr<engines::PositionEngine> position_engine_;
     std::unique_ptr<engines::ComboBuilderEngine> combo_builder_engine_;
     std::unique_ptr<engines::HedgeEngine> hedge_engine_;
     std::unique_ptr<engines::LogEngine> log_engine_;
-    std::unordered_set<std::string> dummy_active_ids_;
 };
 
 } // namespace backtest
@@ -0,0 +1,355 @@
+#include "replay.hpp"
+#include "../../core/engine_option_strategy.hpp"
+#include "../../strategy/template.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <stdexcept>
+#include <thread>
+
+namespace backtest {
+
+namespace {
+
+auto from_ns(int64_t ns) -> Timestamp {
+    return Timestamp{
+        std::chrono::duration_cast<Timestamp::duration>(std::chrono::nanoseconds(ns))};
+}
+
+/** Same order as far as the market is concerned (reference and routing fields aside). */
+auto same_order(const utilities::OrderRequest& a, const utilities::OrderRequest& b) -> bool {
+    if (a.symbol != b.symbol || a.direction != b.direction || a.type != b.type ||
+        a.is_combo != b.is_combo || std::abs(a.volume - b.volume) > 1e-9 ||
+        std::abs(a.price - b.price) > 1e-9) {
+        return false;
+    }
+    const size_t n_a = a.legs ? a.legs->size() : 0;
+    const size_t n_b = b.legs ? b.legs->size() : 0;
+    if (n_a != n_b) {
+        return false;
+    }
+    for (size_t i = 0; i < n_a; ++i) {
+        const utilities::Leg& la = (*a.legs)[i];
+        const utilities::Leg& lb = (*b.legs)[i];
+        if (la.symbol != lb.symbol || la.ratio != lb.ratio || la.direction != lb.direction) {
+            return false;
+        }
+    }
+    return true;
+}
+
+auto describe(const utilities::OrderRequest& req) -> std::string {
+    return std::format("{} {} {} {} @ {}", utilities::to_string(req.type),
+                       utilities::to_string(req.direction), req.volume, req.symbol, req.price);
+}
+
+} // namespace
+
+JournalReplay::JournalReplay() : main_engine_(std::make_unique<MainEngine>()) {
+    main_engine_->set_order_executor(
+        [this](const utilities::OrderRequest& req) -> std::string { return on_send_order(req); });
+    // Replaces the synthetic CANCELLED: the live Order update follows in the journal.
+    main_engine_->execution_engine()->set_cancel_impl(
+        [this](const utilities::CancelRequest& req) { on_cancel_order(req); });
+}
+
+JournalReplay::~JournalReplay() {
+    if (main_engine_) {
+        main_engine_->close();
+    }
+}
+
+void JournalReplay::open(const std::string& path) {
+    reader_ = engines::EventJournalReader::open(path);
+    if (!reader_) {
+        throw std::runtime_error("Not an event journal: " + path);
+    }
+    if (reader_->timer_tick().count() > 0) {
+        main_engine_->event_engine()->set_timer_tick(reader_->timer_tick());
+    }
+    // Layouts as of each portfolio's first snapshot; later records are applied in run().
+    for (size_t offset = engines::EventJournalReader::begin();;) {
+        const auto header = reader_->peek(offset);
+        if (!header) {
+            break;
+        }
+        if (header->kind == engines::JournalRecord::Portfolio && reader_->read(offset, scratch_) &&
+            main_engine_->get_portfolio(scratch_.portfolio.name) == nullptr) {
+            apply_portfolio(scratch_.portfolio);
+        }
+        offset = engines::EventJournalReader::next(offset, *header);
+    }
+}
+
+void JournalReplay::apply_portfolio(const engines::JournalPortfolio& recorded) {
+    utilities::PortfolioData* portfolio = main_engine_->get_portfolio(recorded.name);
+    if (portfolio == nullptr) {
+        auto owned = std::make_unique<utilities::PortfolioData>(recorded.name);
+        portfolio = owned.get();
+        portfolio->set_risk_free_rate(recorded.risk_free_rate);
+        portfolio->iv_price_mode_ = recorded.iv_price_mode;
+        portfolio->set_greeks_enabled(recorded.greeks_enabled);
+        portfolio->set_incremental(recorded.incremental, recorded.price_epsilon,
+                                   recorded.tau_epsilon);
+        portfolio->set_spot_refresh(recorded.spot_refresh);
+        portfolio->set_surface_fit(recorded.surface_fit, recorded.surface_band,
+                                   recorded.surface_max_spread);
+        main_engine_->register_portfolio(portfolio);
+        portfolio_data_.push_back(std::move(owned));
+        portfolio_names_.push_back(recorded.name);
+    }
+    if (recorded.underlying && !portfolio->underlying) {
+        portfolio->set_underlying(*recorded.underlying);
+        main_engine_->register_contract(*recorded.underlying);
+    }
+    if (recorded.options.size() == portfolio->option_apply_order().size()) {
+        return;
+    }
+    if (recorded.options.size() > portfolio->options.size()) {
+        portfolio->reserve_options(recorded.options.size() - portfolio->options.size());
+    }
+    for (const utilities::ContractData& contract : recorded.options) {
+        if (!portfolio->options.contains(contract.symbol)) {
+            portfolio->add_option(contract);
+            main_engine_->register_contract(contract);
+        }
+    }
+    portfolio->finalize_chains();
+    const auto& order = portfolio->option_apply_order();
+    const bool same = order.size() == recorded.options.size() &&
+                      std::ranges::equal(order, recorded.options,
+                                         [](const utilities::OptionData* option,
+                                            const utilities::ContractData& contract) -> bool {
+                                             return option->symbol == contract.symbol;
+                                         });
+    if (!same) {
+        throw std::runtime_error("Journal portfolio " + recorded.name +
+                                 ": rebuilt option order differs from the recorded one");
+    }
+}
+
+void JournalReplay::add_strategy(const std::string& class_name, const std::string& portfolio_name,
+                                 const std::unordered_map<std::string, double>& setting) {
+    std::string name = portfolio_name;
+    if (name.empty()) {
+        if (portfolio_names_.size() != 1) {
+            throw std::runtime_error(std::format(
+                "Journal has {} portfolios; name the one to replay", portfolio_names_.size()));
+        }
+        name = portfolio_names_.front();
+    }
+    if (main_engine_->get_portfolio(name) == nullptr) {
+        throw std::runtime_error("Portfolio not in journal: " + name);
+    }
+    main_engine_->option_strategy_engine()->add_strategy(class_name, name, setting);
+    strategy_name_ = class_name + "_" + name;
+    portfolio_name_ = name;
+}
+
+void JournalReplay::set_pace(ReplayPace pace, double speed) {
+    pace_ = pace;
+    speed_ = speed > 0.0 ? speed : 1.0;
+}
+
+auto JournalReplay::run() -> ReplayResult {
+    result_ = ReplayResult{};
+    result_.strategy_name = strategy_name_;
+    result_.portfolio_name = portfolio_name_;
+    if (!reader_) {
+        result_.errors.emplace_back("No journal opened. Call open() first.");
+        return result_;
+    }
+    core::OptionStrategyEngine* strategy_engine = main_engine_->option_strategy_engine();
+    auto* strategy = strategy_engine->get_strategy();
+    if (strategy == nullptr) {
+        result_.errors.emplace_back("No strategy added. Call add_strategy() first.");
+        return result_;
+    }
+    if (!strategy->inited()) {
+        strategy->on_init();
+        strategy->on_start();
+    }
+    recorded_orderids_.clear();
+    bound_orderids_.clear();
+    expected_.clear();
+    replay_counter_ = 0;
+
+    const auto t0 = std::chrono::steady_clock::now();
+    int64_t first_arrival_ns = -1;
+    bool started = false;
+    engines::JournalEntry entry;
+    size_t offset = engines::EventJournalReader::begin();
+    for (;;) {
+        const auto header = reader_->peek(offset);
+        if (!header) {
+            result_.truncated = offset != reader_->size();
+            break;
+        }
+        const size_t next = engines::EventJournalReader::next(offset, *header);
+        ++result_.records;
+        using enum engines::JournalRecord;
+        if (header->kind == SendOrder || header->kind == CancelOrder) {
+            // Read ahead by collect_expected for the dispatch that produced them.
+            offset = next;
+            continue;
+        }
+        if (!reader_->read(offset, entry)) {
+            result_.truncated = true;
+            break;
+        }
+        offset = next;
+        if (header->kind == Portfolio) {
+            try {
+                apply_portfolio(entry.portfolio);
+            } catch (const std::exception& e) {
+                result_.errors.emplace_back(e.what());
+                break;
+            }
+            continue;
+        }
+
+        if (pace_ == ReplayPace::Recorded) {
+            if (first_arrival_ns < 0) {
+                first_arrival_ns = header->arrival_ns;
+            }
+            const auto offset_ns = static_cast<int64_t>(
+                static_cast<double>(header->arrival_ns - first_arrival_ns) / speed_);
+            std::this_thread::sleep_until(t0 + std::chrono::nanoseconds(offset_ns));
+        }
+        dispatch_wall_ns_ = header->wall_ns;
+        if (!started) {
+            started = true;
+            result_.start_time = from_ns(header->wall_ns);
+        }
+        result_.end_time = from_ns(header->wall_ns);
+
+        switch (header->kind) {
+        case Snapshot:
+            ++result_.snapshots;
+            // Borrowed: dispatch is synchronous and entry outlives it.
+            main_engine_->put_event(utilities::Event(utilities::EventType::Snapshot,
+                                                     utilities::borrow_snapshot(entry.snapshot)));
+            break;
+        case Order:
+            ++result_.orders;
+            collect_expected(offset);
+            if (bound_orderids_.contains(entry.order.orderid)) {
+                main_engine_->put_event(utilities::Event(utilities::EventType::Order, entry.order));
+            }
+            settle_expected();
+            break;
+        case Trade:
+            ++result_.trades;
+            collect_expected(offset);
+            if (bound_orderids_.contains(entry.trade.orderid)) {
+                main_engine_->put_event(utilities::Event(utilities::EventType::Trade, entry.trade));
+            }
+            settle_expected();
+            break;
+        case Timer:
+            ++result_.timers;
+            collect_expected(offset);
+            main_engine_->event_engine()->set_clock(from_ns(header->wall_ns));
+            main_engine_->put_event(utilities::Event(utilities::EventType::Timer));
+            settle_expected();
+            break;
+        default:
+            break;
+        }
+    }
+
+    result_.wall_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    if (const auto* holding = strategy_engine->get_strategy_holding()) {
+        result_.final_pnl = holding->summary.pnl;
+    }
+    if (!strategy->error_msg().empty()) {
+        result_.errors.push_back(strategy->error_msg());
+    }
+    return result_;
+}
+
+void JournalReplay::collect_expected(size_t offset) {
+    expected_.clear();
+    for (;;) {
+        const auto header = reader_->peek(offset);
+        if (!header) {
+            return;
+        }
+        using enum engines::JournalRecord;
+        if (header->kind == Order || header->kind == Trade || header->kind == Timer) {
+            // Next main-worker dispatch. Shard snapshots may interleave; they send nothing.
+            return;
+        }
+        if (header->kind == SendOrder && reader_->read(offset, scratch_) &&
+            scratch_.strategy_name == strategy_name_) {
+            if (!scratch_.orderid.empty()) {
+                recorded_orderids_.insert(scratch_.orderid);
+            }
+            expected_.push_back(
+                ExpectedIntent{.req = scratch_.request, .orderid = scratch_.orderid});
+        } else if (header->kind == CancelOrder && reader_->read(offset, scratch_) &&
+                   recorded_orderids_.contains(scratch_.cancel.orderid)) {
+            expected_.push_back(ExpectedIntent{.cancel = true, .orderid = scratch_.cancel.orderid});
+        }
+        offset = engines::EventJournalReader::next(offset, *header);
+    }
+}
+
+auto JournalReplay::on_send_order(const utilities::OrderRequest& req) -> std::string {
+    ++result_.orders_sent;
+    const auto it = std::ranges::find_if(expected_, [&req](const ExpectedIntent& e) -> bool {
+        return !e.cancel && !e.consumed && same_order(e.req, req);
+    });
+    if (it == expected_.end()) {
+        ++result_.orders_diverged;
+        diverge("unexpected order " + describe(req));
+        // Never bound to a live order, so no recorded update ever reaches it.
+        return "replay_order_" + std::to_string(++replay_counter_);
+    }
+    it->consumed = true;
+    ++result_.orders_matched;
+    if (!it->orderid.empty()) {
+        bound_orderids_.insert(it->orderid);
+    }
+    // Empty when the live send was rejected: the replayed strategy sees the same rejection.
+    return it->orderid;
+}
+
+void JournalReplay::on_cancel_order(const utilities::CancelRequest& req) {
+    const auto it = std::ranges::find_if(expected_, [&req](const ExpectedIntent& e) -> bool {
+        return e.cancel && !e.consumed && e.orderid == req.orderid;
+    });
+    if (it == expected_.end()) {
+        ++result_.cancels_diverged;
+        diverge("unexpected cancel of " + req.orderid);
+        return;
+    }
+    it->consumed = true;
+    ++result_.cancels_matched;
+}
+
+void JournalReplay::settle_expected() {
+    for (const ExpectedIntent& e : expected_) {
+        if (e.consumed) {
+            continue;
+        }
+        if (e.cancel) {
+            ++result_.cancels_missing;
+            diverge("missing cancel of " + e.orderid);
+        } else {
+            ++result_.orders_missing;
+            diverge("missing order " + describe(e.req));
+        }
+    }
+    expected_.clear();
+}
+
+void JournalReplay::diverge(const std::string& what) {
+    if (result_.first_divergence.empty()) {
+        result_.first_divergence = std::to_string(dispatch_wall_ns_) + ": " + what;
+    }
+}
+
+} // namespace backtest
@@ -0,0 +1,135 @@
+#pragma once
+
+/**
+ * JournalReplay: push a live event journal (engines::EventJournalWriter) through the backtest
+ * MainEngine/EventEngine, as fast as possible or at the recorded pace, with one strategy rebuilt
+ * from its class and setting. The live session's portfolios are rebuilt from the journal's
+ * Portfolio records. Each order or cancel the replayed strategy sends during a dispatch is checked
+ * against what the live strategy sent during the same dispatch; a matching order takes the live
+ * orderid, so the recorded Order/Trade events of that order reach the replayed strategy as they
+ * reached the live one. Any other recorded order flow is not dispatched.
+ */
+
+#include "../../infra/db/event_journal.hpp"
+#include "engine_main.hpp"
+#include "types.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace backtest {
+
+enum class ReplayPace {
+    /** Dispatch back to back. */
+    Max,
+    /** Sleep so events are dispatched at their recorded arrival spacing (divided by speed). */
+    Recorded,
+};
+
+struct ReplayResult {
+    std::string strategy_name;
+    std::string portfolio_name;
+    /** Wall time of the first and last dispatched event as recorded. */
+    Timestamp start_time{};
+    Timestamp end_time{};
+    int64_t records = 0;
+    int64_t snapshots = 0;
+    int64_t orders = 0;
+    int64_t trades = 0;
+    int64_t timers = 0;
+    /** Orders the replayed strategy sent, and how they compared with the live ones. */
+    int64_t orders_sent = 0;
+    int64_t orders_matched = 0;
+    int64_t orders_diverged = 0;
+    /** Sent live during a dispatch but not by the replay. */
+    int64_t orders_missing = 0;
+    int64_t cancels_matched = 0;
+    int64_t cancels_diverged = 0;
+    int64_t cancels_missing = 0;
+    /** First mismatch, as "<wall time ns>: <what>"; empty when the replay matched. */
+    std::string first_divergence;
+    double final_pnl = 0.0;
+    /** Replay wall time (excludes open). */
+    double wall_seconds = 0.0;
+    /** The journal ended in a partial record (e.g. the live process died mid-write). */
+    bool truncated = false;
+    std::vector<std::string> errors;
+};
+
+class JournalReplay {
+  public:
+    JournalReplay();
+    ~JournalReplay();
+    JournalReplay(const JournalReplay&) = delete;
+    JournalReplay& operator=(const JournalReplay&) = delete;
+
+    /**
+     * Map the journal and rebuild its portfolios and contracts in the main engine; throws
+     * std::runtime_error if path is not a readable event journal.
+     */
+    void open(const std::string& path);
+    /** Portfolio names in the journal, in first-seen order. */
+    [[nodiscard]] const std::vector<std::string>& portfolios() const { return portfolio_names_; }
+
+    /**
+     * Strategy class_name on portfolio_name (empty: the journal's only portfolio); named
+     * "<class>_<portfolio>" like the live one it is compared against. Throws if the portfolio is
+     * not in the journal. Call after open().
+     */
+    void add_strategy(const std::string& class_name, const std::string& portfolio_name = "",
+                      const std::unordered_map<std::string, double>& setting = {});
+    /** speed scales Recorded pace (2 = twice as fast); ignored for Max. */
+    void set_pace(ReplayPace pace, double speed = 1.0);
+
+    ReplayResult run();
+
+    MainEngine* main_engine() { return main_engine_.get(); }
+
+  private:
+    /** An order or cancel the live strategy sent during the dispatch being replayed. */
+    struct ExpectedIntent {
+        bool cancel = false;
+        utilities::OrderRequest req{};
+        /** Live orderid of the order, or of the order the cancel targets. */
+        std::string orderid{};
+        bool consumed = false;
+    };
+
+    /**
+     * Build portfolio (first record) or add the options it gained; throws if the rebuilt apply
+     * order differs from the recorded one (snapshots would land on the wrong slots).
+     */
+    void apply_portfolio(const engines::JournalPortfolio& portfolio);
+    /** Collect the live intents of our strategy recorded after the event at offset. */
+    void collect_expected(size_t offset);
+    /** Order executor: a matching expected order hands out its live orderid. */
+    std::string on_send_order(const utilities::OrderRequest& req);
+    void on_cancel_order(const utilities::CancelRequest& req);
+    /** Count what the dispatch did not send; record the first divergence. */
+    void settle_expected();
+    void diverge(const std::string& what);
+
+    std::unique_ptr<MainEngine> main_engine_;
+    std::unique_ptr<engines::EventJournalReader> reader_;
+    std::vector<std::unique_ptr<utilities::PortfolioData>> portfolio_data_;
+    std::vector<std::string> portfolio_names_;
+    std::string strategy_name_;
+    std::string portfolio_name_;
+    ReplayPace pace_ = ReplayPace::Max;
+    double speed_ = 1.0;
+
+    /** Live orderids of our strategy (seen in its SendOrder records). */
+    std::unordered_set<std::string> recorded_orderids_;
+    /** Live orderids the replayed strategy was handed: their Order/Trade events are dispatched. */
+    std::unordered_set<std::string> bound_orderids_;
+    std::vector<ExpectedIntent> expected_;
+    engines::JournalEntry scratch_;
+    int64_t dispatch_wall_ns_ = 0;
+    int replay_counter_ = 0;
+    ReplayResult result_;
+};
+
+} // namespace backtest
@@ -0,0 +1,249 @@
+#include "result_writer.hpp"
+#include "../../utilities/constant.hpp"
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/writer.h>
+#include <chrono>
+#include <filesystem>
+#include <parquet/arrow/writer.h>
+#include <stdexcept>
+
+namespace backtest {
+
+namespace {
+
+void check(const arrow::Status& st, std::string const& what) {
+    if (!st.ok()) {
+        throw std::runtime_error(what + ": " + st.ToString());
+    }
+}
+
+template <typename T> auto value(arrow::Result<T> result, std::string const& what) -> T {
+    check(result.status(), what);
+    return std::move(result).ValueOrDie();
+}
+
+auto ts_type() -> std::shared_ptr<arrow::DataType> {
+    return arrow::timestamp(arrow::TimeUnit::NANO, "UTC");
+}
+
+/** Zero-copy view of a numeric column; v must outlive the batch write. */
+template <typename ArrayT, typename T>
+auto wrap(const std::vector<T>& v) -> std::shared_ptr<arrow::Array> {
+    return std::make_shared<ArrayT>(static_cast<int64_t>(v.size()), arrow::Buffer::Wrap(v));
+}
+
+auto nanos(const std::vector<Timestamp>& ts) -> std::vector<int64_t> {
+    std::vector<int64_t> out;
+    out.reserve(ts.size());
+    for (const Timestamp t : ts) {
+        out.push_back(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count());
+    }
+    return out;
+}
+
+auto timestamps(const std::vector<int64_t>& ns) -> std::shared_ptr<arrow::Array> {
+    return std::make_shared<arrow::TimestampArray>(
+        ts_type(), static_cast<int64_t>(ns.size()), arrow::Buffer::Wrap(ns));
+}
+
+auto strings(const std::vector<std::string>& v, std::string const& what)
+    -> std::shared_ptr<arrow::Array> {
+    arrow::StringBuilder builder;
+    check(builder.AppendValues(v), what);
+    return value(builder.Finish(), what);
+}
+
+/** Enum column formatted at output time. */
+template <typename E>
+auto enum_strings(const std::vector<E>& v, std::string const& what)
+    -> std::shared_ptr<arrow::Array> {
+    arrow::StringBuilder builder;
+    check(builder.Reserve(static_cast<int64_t>(v.size())), what);
+    for (const E e : v) {
+        check(builder.Append(utilities::to_string(e)), what);
+    }
+    return value(builder.Finish(), what);
+}
+
+} // namespace
+
+auto parse_result_format(std::string_view s) -> std::optional<ResultFormat> {
+    if (s == "json") {
+        return ResultFormat::Json;
+    }
+    if (s == "arrow") {
+        return ResultFormat::Arrow;
+    }
+    if (s == "parquet") {
+        return ResultFormat::Parquet;
+    }
+    return std::nullopt;
+}
+
+/** One table's output: an IPC stream writer or a Parquet writer on a file. */
+struct ResultWriter::Sink {
+    std::string name;
+    std::string path;
+    std::shared_ptr<arrow::Schema> schema;
+    std::shared_ptr<arrow::io::FileOutputStream> out;
+    std::shared_ptr<arrow::ipc::RecordBatchWriter> ipc;
+    std::unique_ptr<parquet::arrow::FileWriter> parquet;
+
+    Sink(ResultFormat format, std::filesystem::path const& dir, std::string table,
+         std::shared_ptr<arrow::Schema> table_schema)
+        : name(std::move(table)), schema(std::move(table_schema)) {
+        path = (dir / (name + (format == ResultFormat::Parquet ? ".parquet" : ".arrow"))).string();
+        out = value(arrow::io::FileOutputStream::Open(path), path);
+        if (format == ResultFormat::Parquet) {
+            parquet = value(parquet::arrow::FileWriter::Open(*schema, arrow::default_memory_pool(),
+                                                             out),
+                            path);
+        } else {
+            ipc = value(arrow::ipc::MakeStreamWriter(out, schema), path);
+        }
+    }
+
+    void write(int64_t rows, std::vector<std::shared_ptr<arrow::Array>> columns) const {
+        if (rows == 0) {
+            return;
+        }
+        const auto batch = arrow::RecordBatch::Make(schema, rows, std::move(columns));
+        check(ipc ? ipc->WriteRecordBatch(*batch) : parquet->WriteRecordBatch(*batch), path);
+    }
+
+    void close() const {
+        check(ipc ? ipc->Close() : parquet->Close(), path);
+        check(out->Close(), path);
+    }
+};
+
+ResultWriter::ResultWriter(ResultFormat format, std::string const& dir) {
+    if (format == ResultFormat::Json) {
+        throw std::runtime_error("ResultWriter needs arrow or parquet format");
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (ec) {
+        throw std::runtime_error("Cannot create output directory " + dir + ": " + ec.message());
+    }
+    const auto f64 = arrow::float64();
+    const auto i32 = arrow::int32();
+    const auto utf8 = arrow::utf8();
+    metrics_ = std::make_unique<Sink>(
+        format, dir, "metrics",
+        arrow::schema({arrow::field("step", arrow::int64()), arrow::field("file_index", i32),
+                       arrow::field("ts", ts_type()), arrow::field("pnl", f64),
+                       arrow::field("delta", f64), arrow::field("gamma", f64),
+                       arrow::field("theta", f64), arrow::field("fees", f64)}));
+    orders_ = std::make_unique<Sink>(
+        format, dir, "orders",
+        arrow::schema({arrow::field("file_index", i32), arrow::field("ts", ts_type()),
+                       arrow::field("orderid", utf8), arrow::field("symbol", utf8),
+                       arrow::field("direction", utf8), arrow::field("status", utf8),
+                       arrow::field("price", f64), arrow::field("volume", f64),
+                       arrow::field("traded", f64)}));
+    trades_ = std::make_unique<Sink>(
+        format, dir, "trades",
+        arrow::schema({arrow::field("file_index", i32), arrow::field("ts", ts_type()),
+                       arrow::field("tradeid", utf8), arrow::field("orderid", utf8),
+                       arrow::field("symbol", utf8), arrow::field("direction", utf8),
+                       arrow::field("price", f64), arrow::field("volume", f64)}));
+    daily_ = std::make_unique<Sink>(
+        format, dir, "daily",
+        arrow::schema({arrow::field("file_index", i32), arrow::field("file", utf8),
+                       arrow::field("start_time", ts_type()), arrow::field("end_time", ts_type()),
+                       arrow::field("pnl", f64), arrow::field("net_pnl", f64),
+                       arrow::field("fees", f64), arrow::field("orders", i32),
+                       arrow::field("timesteps", i32), arrow::field("rows", arrow::int64())}));
+}
+
+ResultWriter::~ResultWriter() {
+    try {
+        close();
+    } catch (...) {
+        // Destructor must not throw; call close() to see write errors.
+    }
+}
+
+void ResultWriter::write_file(DailySummary const& daily, MetricsRecorder const& metrics,
+                              FillRecorder const& fills) {
+    const auto file_index = static_cast<int32_t>(daily.file_index);
+
+    const size_t n = metrics.size();
+    std::vector<int64_t> steps(n);
+    for (size_t i = 0; i < n; ++i) {
+        steps[i] = steps_ + static_cast<int64_t>(i);
+    }
+    const std::vector<int32_t> metric_files(n, file_index);
+    const std::vector<int64_t> metric_ts = nanos(metrics.timestamps);
+    metrics_->write(static_cast<int64_t>(n),
+                    {wrap<arrow::Int64Array>(steps), wrap<arrow::Int32Array>(metric_files),
+                     timestamps(metric_ts), wrap<arrow::DoubleArray>(metrics.pnl),
+                     wrap<arrow::DoubleArray>(metrics.delta),
+                     wrap<arrow::DoubleArray>(metrics.gamma),
+                     wrap<arrow::DoubleArray>(metrics.theta),
+                     wrap<arrow::DoubleArray>(metrics.fees)});
+    steps_ += static_cast<int64_t>(n);
+
+    const size_t n_orders = fills.order_ts.size();
+    const std::vector<int32_t> order_files(n_orders, file_index);
+    const std::vector<int64_t> order_ts = nanos(fills.order_ts);
+    orders_->write(static_cast<int64_t>(n_orders),
+                   {wrap<arrow::Int32Array>(order_files), timestamps(order_ts),
+                    strings(fills.order_id, orders_->path),
+                    strings(fills.order_symbol, orders_->path),
+                    enum_strings(fills.order_direction, orders_->path),
+                    enum_strings(fills.order_status, orders_->path),
+                    wrap<arrow::DoubleArray>(fills.order_price),
+                    wrap<arrow::DoubleArray>(fills.order_volume),
+                    wrap<arrow::DoubleArray>(fills.order_traded)});
+
+    const size_t n_trades = fills.trade_ts.size();
+    const std::vector<int32_t> trade_files(n_trades, file_index);
+    const std::vector<int64_t> trade_ts = nanos(fills.trade_ts);
+    trades_->write(static_cast<int64_t>(n_trades),
+                   {wrap<arrow::Int32Array>(trade_files), timestamps(trade_ts),
+                    strings(fills.trade_id, trades_->path),
+                    strings(fills.trade_orderid, trades_->path),
+                    strings(fills.trade_symbol, trades_->path),
+                    enum_strings(fills.trade_direction, trades_->path),
+                    wrap<arrow::DoubleArray>(fills.trade_price),
+                    wrap<arrow::DoubleArray>(fills.trade_volume)});
+
+    const std::vector<int32_t> day_file{file_index};
+    const std::vector<int64_t> day_start = nanos({daily.start_time});
+    const std::vector<int64_t> day_end = nanos({daily.end_time});
+    const std::vector<double> day_pnl{daily.pnl};
+    const std::vector<double> day_net{daily.pnl - daily.fees};
+    const std::vector<double> day_fees{daily.fees};
+    const std::vector<int32_t> day_orders{daily.orders};
+    const std::vector<int32_t> day_steps{daily.timesteps};
+    const std::vector<int64_t> day_rows{daily.rows};
+    daily_->write(1, {wrap<arrow::Int32Array>(day_file), strings({daily.file}, daily_->path),
+                      timestamps(day_start), timestamps(day_end),
+                      wrap<arrow::DoubleArray>(day_pnl), wrap<arrow::DoubleArray>(day_net),
+                      wrap<arrow::DoubleArray>(day_fees), wrap<arrow::Int32Array>(day_orders),
+                      wrap<arrow::Int32Array>(day_steps), wrap<arrow::Int64Array>(day_rows)});
+}
+
+void ResultWriter::close() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+    for (const Sink* sink : {metrics_.get(), orders_.get(), trades_.get(), daily_.get()}) {
+        sink->close();
+    }
+}
+
+auto ResultWriter::paths() const -> std::vector<std::pair<std::string, std::string>> {
+    std::vector<std::pair<std::string, std::string>> out;
+    for (const Sink* sink : {metrics_.get(), orders_.get(), trades_.get(), daily_.get()}) {
+        out.emplace_back(sink->name, sink->path);
+    }
+    return out;
+}
+
+} // namespace backtest
@@ -0,0 +1,69 @@
+#pragma once
+
+/**
+ * ResultWriter: columnar backtest output (entry_backtest --output arrow|parquet). One Arrow IPC
+ * stream or Parquet file per table (metrics, orders, trades, daily) under a directory; each
+ * finished file of a run is appended as one record batch per table, in file order, so output
+ * grows while the run progresses instead of being built as one document at the end.
+ */
+
+#include "engine_backtest.hpp"
+#include "types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace backtest {
+
+enum class ResultFormat { Json, Arrow, Parquet };
+
+/** "json" | "arrow" | "parquet"; nullopt otherwise. */
+std::optional<ResultFormat> parse_result_format(std::string_view s);
+
+/** One backtested file as written to the daily table. */
+struct DailySummary {
+    size_t file_index = 0;
+    std::string file;
+    Timestamp start_time{};
+    Timestamp end_time{};
+    double pnl = 0.0;
+    double fees = 0.0;
+    int orders = 0;
+    int timesteps = 0;
+    int64_t rows = 0;
+};
+
+class ResultWriter {
+  public:
+    /** Create dir and open every table's output; throws std::runtime_error on failure. */
+    ResultWriter(ResultFormat format, std::string const& dir);
+    ~ResultWriter();
+    ResultWriter(const ResultWriter&) = delete;
+    ResultWriter& operator=(const ResultWriter&) = delete;
+
+    /**
+     * Append one file's rows to every table (metrics columns are wrapped, not copied). Metrics
+     * steps continue across calls. Not thread-safe; throws std::runtime_error on write failure.
+     */
+    void write_file(DailySummary const& daily, MetricsRecorder const& metrics,
+                    FillRecorder const& fills);
+    /** Finish every output (stream end markers, Parquet footers); idempotent. */
+    void close();
+    /** (table, path) per output, for the JSON summary. */
+    [[nodiscard]] std::vector<std::pair<std::string, std::string>> paths() const;
+
+  private:
+    struct Sink;
+
+    std::unique_ptr<Sink> metrics_, orders_, trades_, daily_;
+    /** Metrics rows written so far (global step of the next row). */
+    int64_t steps_ = 0;
+    bool closed_ = false;
+};
+
+} // namespace backtest
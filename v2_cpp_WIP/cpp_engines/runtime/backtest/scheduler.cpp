@@ -0,0 +1,103 @@
+#include "scheduler.hpp"
+#include "../../utilities/thread_pool.hpp"
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <latch>
+#include <numeric>
+
+namespace backtest {
+
+BacktestScheduler::BacktestScheduler(std::vector<uint64_t> const& weights, unsigned int n_workers) {
+    if (n_workers == 0) {
+        n_workers = utilities::ThreadPool::shared().size();
+    }
+    n_workers = static_cast<unsigned int>(
+        std::clamp<size_t>(n_workers, 1, std::max<size_t>(weights.size(), 1)));
+    lanes_.reserve(n_workers);
+    for (unsigned int w = 0; w < n_workers; ++w) {
+        lanes_.push_back(std::make_unique<Lane>());
+    }
+
+    order_.resize(weights.size());
+    std::iota(order_.begin(), order_.end(), size_t{0});
+    std::ranges::stable_sort(order_, std::greater<>{}, [&weights](size_t i) { return weights[i]; });
+}
+
+void BacktestScheduler::deal() {
+    for (const auto& lane : lanes_) {
+        lane->items.clear();
+    }
+    // Round-robin deal keeps each lane sorted largest-first.
+    for (size_t k = 0; k < order_.size(); ++k) {
+        lanes_[k % lanes_.size()]->items.push_back(order_[k]);
+    }
+}
+
+auto BacktestScheduler::next(unsigned int worker) -> std::optional<size_t> {
+    {
+        Lane& own = *lanes_[worker];
+        std::scoped_lock lk(own.mutex);
+        if (!own.items.empty()) {
+            const size_t item = own.items.front();
+            own.items.pop_front();
+            return item;
+        }
+    }
+    const auto n = static_cast<unsigned int>(lanes_.size());
+    for (unsigned int k = 1; k < n; ++k) {
+        Lane& victim = *lanes_[(worker + k) % n];
+        std::scoped_lock lk(victim.mutex);
+        if (!victim.items.empty()) {
+            const size_t item = victim.items.back();
+            victim.items.pop_back();
+            return item;
+        }
+    }
+    return std::nullopt;
+}
+
+void BacktestScheduler::run(Task const& task) {
+    // Every run starts from the full deal: a previous run drained the lanes or stopped early.
+    deal();
+    stop_.store(false, std::memory_order_relaxed);
+    utilities::ThreadPool& pool = utilities::ThreadPool::shared();
+    std::exception_ptr error;
+    std::once_flag error_once;
+    std::latch done(static_cast<std::ptrdiff_t>(lanes_.size()));
+    for (unsigned int w = 0; w < lanes_.size(); ++w) {
+        pool.submit([this, &task, &error, &error_once, &done, w]() {
+            try {
+                while (!stop_.load(std::memory_order_relaxed)) {
+                    const std::optional<size_t> item = next(w);
+                    if (!item) {
+                        break;
+                    }
+                    task(w, *item);
+                }
+            } catch (...) {
+                std::call_once(error_once, [&error]() { error = std::current_exception(); });
+                stop_.store(true, std::memory_order_relaxed);
+            }
+            done.count_down();
+        });
+    }
+    done.wait();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+auto BacktestScheduler::file_weights(std::vector<std::string> const& paths)
+    -> std::vector<uint64_t> {
+    std::vector<uint64_t> weights;
+    weights.reserve(paths.size());
+    for (std::string const& p : paths) {
+        std::error_code ec;
+        const auto size = std::filesystem::file_size(p, ec);
+        weights.push_back(ec ? 0 : static_cast<uint64_t>(size));
+    }
+    return weights;
+}
+
+} // namespace backtest
@@ -0,0 +1,60 @@
+#pragma once
+
+/**
+ * BacktestScheduler: runs weighted work items (files, sweep cells) on the shared ThreadPool.
+ * Items are dealt largest-first into per-worker deques; a worker takes the front of its own
+ * deque and, once empty, steals the back (smallest) of another, so big items start early and the
+ * tail stays short. Item workers and apply_frame chunks share the pool, so its size is the
+ * whole CPU budget; workers freed at the tail pick up other workers' apply_frame chunks.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace backtest {
+
+class BacktestScheduler {
+  public:
+    /** task(worker, item); worker is in [0, worker_count()). */
+    using Task = std::function<void(unsigned int worker, size_t item)>;
+
+    /** One item per weight; n_workers = 0 → shared pool size (clamped to the item count). */
+    explicit BacktestScheduler(std::vector<uint64_t> const& weights, unsigned int n_workers = 0);
+
+    /** Run task for every item and block until done; the first exception stops new items and
+     * is rethrown here. Each call runs every item again. */
+    void run(Task const& task);
+
+    [[nodiscard]] unsigned int worker_count() const {
+        return static_cast<unsigned int>(lanes_.size());
+    }
+
+    /** File sizes in bytes as weights (0 when unreadable). */
+    static std::vector<uint64_t> file_weights(std::vector<std::string> const& paths);
+
+  private:
+    struct Lane {
+        std::mutex mutex;
+        std::deque<size_t> items;
+    };
+
+    /** Refill the lanes from order_ (not thread-safe: before the workers start). */
+    void deal();
+    /** Own front, else steal another lane's back; nullopt when all lanes are empty. */
+    std::optional<size_t> next(unsigned int worker);
+
+    /** Items largest weight first. */
+    std::vector<size_t> order_;
+    std::vector<std::unique_ptr<Lane>> lanes_;
+    std::atomic<bool> stop_{false};
+};
+
+} // namespace backtest
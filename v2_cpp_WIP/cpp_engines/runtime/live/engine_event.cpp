@@ -1,24 +1,157 @@
 /**
- * Live event engine: queue + worker thread; dispatch control in Event (same as backtest).
+ * Live event engine: producers push into bounded lock-free MPSC rings, one per priority lane
+ * (Order/Trade > Timer > Snapshot); one worker drains the highest non-empty lane and spins,
+ * yields, then parks (atomic wait) when idle. Dispatch control in Event (same as backtest).
+ * Optional snapshot shards apply portfolios in parallel; see EventEngine in the header.
+ * Timers: the timer thread sleeps until the wheel's next deadline and queues one Timer event; its
+ * dispatch advances the wheel, which runs only the timers that came due.
  */
 
 #include "engine_event.hpp"
 #include "../../core/engine_execution.hpp"
 #include "../../core/engine_hedge.hpp"
 #include "../../core/engine_option_strategy.hpp"
+#include "../../infra/db/event_journal.hpp"
+#include "../../strategy/template.hpp"
 #include "../../utilities/event.hpp"
 #include "../../utilities/intent.hpp"
+#include "../../utilities/latency.hpp"
 #include "engine_main.hpp"
+#include <algorithm>
 #include <chrono>
 #include <format>
+#include <memory_resource>
 #include <thread>
 #include <utility>
 #include <variant>
 
 namespace engines {
 
-EventEngine::EventEngine(utilities::MainEngine* main, int interval)
-    : BaseEngine(main, "Event"), interval_(interval) {}
+namespace {
+
+constexpr int kIdleSpins = 256;
+constexpr int kIdleYields = 16;
+
+/** Engine whose worker runs on this thread (re-entrant put detection). */
+thread_local const EventEngine* t_worker_engine = nullptr;
+
+/** pending made writable: taken over when the slot is its only owner, else copied once. */
+auto writable(utilities::SnapshotHandle& pending) -> utilities::PortfolioSnapshot& {
+    if (pending.use_count() != 1) {
+        pending = std::make_shared<utilities::PortfolioSnapshot>(*pending);
+    }
+    // Sole owner of a share_snapshot / make_shared frame, which was created non-const.
+    return const_cast<utilities::PortfolioSnapshot&>(*pending);
+}
+
+/**
+ * Fold next into pending (both for one portfolio, next is newer). Dense next replaces (no copy);
+ * sparse next is appended to a sparse pending or scattered into a dense one. Greeks of a dense
+ * pending are dropped once any quote changes. The merge keeps the oldest trace_tsc and covers the
+ * chains of both.
+ */
+void merge_snapshot(utilities::SnapshotHandle& pending_handle,
+                    utilities::SnapshotHandle&& next_handle) {
+    const uint64_t trace_tsc =
+        pending_handle->trace_tsc != 0 ? pending_handle->trace_tsc : next_handle->trace_tsc;
+    if (!next_handle->sparse) {
+        pending_handle = std::move(next_handle);
+        if (pending_handle->trace_tsc != trace_tsc) {
+            writable(pending_handle).trace_tsc = trace_tsc;
+        }
+        return;
+    }
+    utilities::PortfolioSnapshot& pending = writable(pending_handle);
+    const utilities::PortfolioSnapshot& next = *next_handle;
+    pending.trace_tsc = trace_tsc;
+    pending.datetime = next.datetime;
+    pending.underlying_bid = next.underlying_bid;
+    pending.underlying_ask = next.underlying_ask;
+    pending.underlying_last = next.underlying_last;
+    // The merge carries both producers' chains: union of the lists, empty (all) if either is.
+    if (next.chains.empty()) {
+        pending.chains.clear();
+    } else if (!pending.chains.empty()) {
+        pending.chains.insert(pending.chains.end(), next.chains.begin(), next.chains.end());
+        std::ranges::sort(pending.chains);
+        const auto [first, last] = std::ranges::unique(pending.chains);
+        pending.chains.erase(first, last);
+    }
+    const size_t m = std::min({next.slots.size(), next.bid.size(), next.ask.size(),
+                               next.last.size()});
+    if (pending.sparse) {
+        pending.slots.insert(pending.slots.end(), next.slots.begin(), next.slots.begin() + m);
+        pending.bid.insert(pending.bid.end(), next.bid.begin(), next.bid.begin() + m);
+        pending.ask.insert(pending.ask.end(), next.ask.begin(), next.ask.begin() + m);
+        pending.last.insert(pending.last.end(), next.last.begin(), next.last.begin() + m);
+        return;
+    }
+    pending.has_greeks = false;
+    const size_t n = std::min({pending.bid.size(), pending.ask.size(), pending.last.size()});
+    for (size_t k = 0; k < m; ++k) {
+        const size_t i = next.slots[k];
+        if (i >= n) {
+            continue;
+        }
+        pending.bid[i] = next.bid[k];
+        pending.ask[i] = next.ask[k];
+        pending.last[i] = next.last[k];
+    }
+}
+
+/** Strategy names are "<class>_<portfolio>"; the name itself when there is no suffix. */
+auto strategy_portfolio(const std::string& strategy_name) -> std::string {
+    const size_t p = strategy_name.find('_');
+    if (p != std::string::npos && p + 1 < strategy_name.size()) {
+        return strategy_name.substr(p + 1);
+    }
+    return strategy_name;
+}
+
+auto steady_ns() -> int64_t {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/** Timer wheel time. */
+auto steady_ms() -> std::chrono::milliseconds {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch());
+}
+
+/** IbGateway::check_connection runs every this many ticks. */
+constexpr int kConnectionCheckTicks = 10;
+/** hedge_timers_ key of the shared timer in netting mode. */
+constexpr const char* kNettedHedgeTimer = "*netted*";
+
+} // namespace
+
+EventEngine::EventEngine(utilities::MainEngine* main, int interval, unsigned int shards)
+    : BaseEngine(main, "Event"), interval_(interval) {
+    // Conflation keeps the Snapshot lane at about one marker per portfolio; Timer is one a tick.
+    lanes_[static_cast<size_t>(EventLane::Execution)] = std::make_unique<Lane>(kRingCapacity);
+    lanes_[static_cast<size_t>(EventLane::Timer)] = std::make_unique<Lane>(64);
+    lanes_[static_cast<size_t>(EventLane::Snapshot)] = std::make_unique<Lane>(1024);
+    batch_.reserve(kDrainBatch);
+    for (unsigned int i = 0; shards > 1 && i < shards; ++i) {
+        shards_.push_back(std::make_unique<Shard>(1024));
+    }
+}
+
+auto EventEngine::lane_of(utilities::EventType type) -> EventLane {
+    switch (type) {
+        using enum utilities::EventType;
+    case Order:
+    case Trade:
+        return EventLane::Execution;
+    case Snapshot:
+        return EventLane::Snapshot;
+    case Timer:
+        break;
+    }
+    return EventLane::Timer;
+}
 
 EventEngine::~EventEngine() { EventEngine::stop(); }
 
@@ -26,7 +159,16 @@ void EventEngine::start() {
     if (active_.exchange(true)) {
         return;
     }
+    if (!timers_registered_) {
+        timers_registered_ = true;
+        register_timers();
+    }
+    timers_.advance(steady_ms()); // anchors the wheel on the first start
     thread_ = std::jthread([this](std::stop_token st) { run(std::move(st)); });
+    for (const auto& shard : shards_) {
+        shard->thread = std::jthread(
+            [this, s = shard.get()](std::stop_token st) { run_shard(*s, std::move(st)); });
+    }
     timer_thread_ = std::jthread([this](std::stop_token st) { run_timer(std::move(st)); });
 }
 
@@ -34,17 +176,264 @@ void EventEngine::stop() {
     if (!active_.exchange(false)) {
         return;
     }
-    queue_cv_.notify_all();
+    wake_.wake();
+    for (const auto& shard : shards_) {
+        shard->wake.wake();
+    }
     if (timer_thread_.joinable()) {
+        timer_thread_.request_stop();
         timer_thread_.join();
     }
+    timer_pending_ = false;
     if (thread_.joinable()) {
         thread_.join();
     }
+    for (const auto& shard : shards_) {
+        if (shard->thread.joinable()) {
+            shard->thread.join();
+        }
+    }
+    if (EventJournalWriter* journal = journal_.load(std::memory_order_acquire)) {
+        journal->flush();
+    }
 }
 
 void EventEngine::close() { stop(); }
 
+auto EventEngine::add_timer(std::chrono::milliseconds period, utilities::TimerWheel::Callback fn)
+    -> utilities::TimerWheel::TimerId {
+    return schedule(period, [this, fn = std::move(fn)]() {
+        flush_strategy_timers();
+        fn();
+    });
+}
+
+auto EventEngine::schedule(std::chrono::milliseconds period, utilities::TimerWheel::Callback fn)
+    -> utilities::TimerWheel::TimerId {
+    const utilities::TimerWheel::TimerId id = timers_.add(period, std::move(fn));
+    {
+        std::scoped_lock lock(timer_mutex_);
+        timer_rescan_ = true;
+    }
+    timer_cv_.notify_one();
+    return id;
+}
+
+void EventEngine::register_timers() {
+    auto* main = static_cast<MainEngine*>(main_engine);
+    if (main == nullptr) {
+        return;
+    }
+    const std::chrono::milliseconds tick = std::chrono::seconds(std::max(interval_, 1));
+    // start() runs before MainEngine creates the gateway: look it up on every firing.
+    add_timer(tick * kConnectionCheckTicks, [main]() {
+        if (engines::IbGateway* gateway = main->ib_gateway(); gateway != nullptr) {
+            gateway->check_connection();
+        }
+    });
+    add_timer(tick, [this, main]() {
+        engines::PositionEngine* pos = main->position_engine();
+        if (pos == nullptr) {
+            return;
+        }
+        std::pmr::vector<utilities::LogData> pos_logs(frame_arena_.resource());
+        const engines::GetPortfolioFn get_portfolio =
+            [main](const std::string& name) -> utilities::PortfolioData* {
+            return main->get_portfolio(name);
+        };
+        pos->process_timer_event(get_portfolio, &pos_logs);
+        if (main->scenario_engine() != nullptr) {
+            main->scenario_engine()->process_timer_event(*pos, get_portfolio);
+        }
+        for (const auto& l : pos_logs) {
+            main->put_log_intent(l);
+        }
+        main->publish_holdings();
+        main->checkpoint_holdings();
+    });
+    // Strategies and hedging registrations come and go at runtime; follow them every tick.
+    add_timer(tick, [this]() { sync_strategy_timers(); });
+}
+
+void EventEngine::sync_strategy_timers() {
+    auto* main = static_cast<MainEngine*>(main_engine);
+    core::OptionStrategyEngine* se = main->option_strategy_engine();
+    engines::HedgeEngine* hedge = main->hedge_engine();
+    const std::chrono::milliseconds tick = std::chrono::seconds(std::max(interval_, 1));
+
+    // Re-add when the period changed; cancel what is gone.
+    const auto sync = [this](std::unordered_map<std::string, TimerEntry>& timers,
+                             const std::string& name, std::chrono::milliseconds period,
+                             utilities::TimerWheel::Callback fn) -> void {
+        auto it = timers.find(name);
+        if (it != timers.end() && it->second.period == period) {
+            return;
+        }
+        if (it != timers.end()) {
+            timers_.cancel(it->second.id);
+        }
+        timers[name] = TimerEntry{.id = schedule(period, std::move(fn)), .period = period};
+    };
+    const auto prune = [this](std::unordered_map<std::string, TimerEntry>& timers,
+                              const auto& keep) -> void {
+        std::erase_if(timers, [this, &keep](const auto& kv) -> bool {
+            if (keep(kv.first)) {
+                return false;
+            }
+            timers_.cancel(kv.second.id);
+            return true;
+        });
+    };
+
+    if (se != nullptr) {
+        for (const std::string& name : se->get_strategy_names()) {
+            const strategy_cpp::OptionStrategyTemplate* s = se->get_strategy(name);
+            if (s == nullptr) {
+                continue;
+            }
+            sync(strategy_timers_, name, s->timer_period(tick), [this, se, name]() {
+                if (se->parallel_timers()) {
+                    due_strategies_.push_back(name);
+                } else if (strategy_cpp::OptionStrategyTemplate* st = se->get_strategy(name)) {
+                    st->on_timer();
+                }
+            });
+        }
+    }
+    prune(strategy_timers_, [se](const std::string& name) -> bool {
+        return se != nullptr && se->get_strategy(name) != nullptr;
+    });
+
+    const bool netting = hedge != nullptr && hedge->netting();
+    if (hedge != nullptr && se != nullptr && netting) {
+        // One round for all strategies, at the shortest registered period.
+        int trigger = 0;
+        for (const auto& [name, config] : hedge->registered_strategies()) {
+            const int t = std::max(config.timer_trigger, 1);
+            trigger = trigger == 0 ? t : std::min(trigger, t);
+        }
+        if (trigger > 0) {
+            sync(hedge_timers_, kNettedHedgeTimer, tick * trigger, [this]() {
+                flush_strategy_timers();
+                run_netted_hedging();
+            });
+        }
+    } else if (hedge != nullptr && se != nullptr) {
+        for (const auto& [name, config] : hedge->registered_strategies()) {
+            sync(hedge_timers_, name, tick * std::max(config.timer_trigger, 1), [this, name]() {
+                flush_strategy_timers();
+                run_hedging(name);
+            });
+        }
+    }
+    prune(hedge_timers_, [hedge, se, netting](const std::string& name) -> bool {
+        if (hedge == nullptr || se == nullptr) {
+            return false;
+        }
+        return netting ? name == kNettedHedgeTimer && !hedge->registered_strategies().empty()
+                       : hedge->registered_strategies().contains(name);
+    });
+}
+
+void EventEngine::flush_strategy_timers() {
+    if (due_strategies_.empty()) {
+        return;
+    }
+    auto* main = static_cast<MainEngine*>(main_engine);
+    std::vector<std::string> due = std::exchange(due_strategies_, {});
+    if (core::OptionStrategyEngine* se = main->option_strategy_engine()) {
+        se->on_timer(due);
+    }
+}
+
+auto EventEngine::hedge_params(const std::string& strategy_name) -> engines::HedgeParams {
+    auto* main = static_cast<MainEngine*>(main_engine);
+    core::OptionStrategyEngine* se = main->option_strategy_engine();
+    engines::HedgeParams params;
+    params.portfolio = main->get_portfolio(strategy_portfolio(strategy_name));
+    params.holding = main->get_holding(strategy_name);
+    params.get_contract = [main](const std::string& sym) -> const utilities::ContractData* {
+        return main->get_contract(sym);
+    };
+    params.for_each_active_order =
+        [se](const std::string& name,
+             const std::function<void(const utilities::OrderData&)>& fn) -> void {
+        se->for_each_active_order(name, fn);
+    };
+    return params;
+}
+
+void EventEngine::run_hedging(const std::string& strategy_name) {
+    auto* main = static_cast<MainEngine*>(main_engine);
+    engines::HedgeEngine* hedge = main->hedge_engine();
+    core::OptionStrategyEngine* se = main->option_strategy_engine();
+    if ((hedge == nullptr) || (se == nullptr)) {
+        return;
+    }
+    const utilities::LatencyProbe probe(utilities::LatencyStage::Hedge);
+    const engines::HedgeParams params = hedge_params(strategy_name);
+    std::pmr::vector<utilities::OrderRequest> orders(frame_arena_.resource());
+    std::pmr::vector<utilities::CancelRequest> cancels(frame_arena_.resource());
+    std::pmr::vector<utilities::LogData> logs(frame_arena_.resource());
+    hedge->process_hedging(strategy_name, params, &orders, &cancels, &logs);
+    for (const auto& o : orders) {
+        put_intent(utilities::IntentSendOrder{strategy_name, o});
+    }
+    for (const auto& c : cancels) {
+        put_intent(utilities::IntentCancelOrder{c});
+    }
+    for (const auto& l : logs) {
+        put_intent(utilities::IntentLog{l});
+    }
+}
+
+void EventEngine::run_netted_hedging() {
+    auto* main = static_cast<MainEngine*>(main_engine);
+    engines::HedgeEngine* hedge = main->hedge_engine();
+    if ((hedge == nullptr) || (main->option_strategy_engine() == nullptr)) {
+        return;
+    }
+    const utilities::LatencyProbe probe(utilities::LatencyStage::Hedge);
+    std::vector<std::pair<std::string, engines::HedgeParams>> strategies;
+    for (const auto& [name, config] : hedge->registered_strategies()) {
+        strategies.emplace_back(name, hedge_params(name));
+    }
+    std::pmr::vector<engines::NettedHedgeOrder> orders(frame_arena_.resource());
+    std::pmr::vector<utilities::CancelRequest> cancels(frame_arena_.resource());
+    std::pmr::vector<engines::HedgeFill> crosses(frame_arena_.resource());
+    std::pmr::vector<utilities::LogData> logs(frame_arena_.resource());
+    hedge->process_netted_hedging(strategies, &orders, &cancels, &crosses, &logs);
+    for (const engines::HedgeFill& cross : crosses) {
+        const uint64_t ticket = book_hedge_fill(cross);
+        if (main->execution_engine() != nullptr) {
+            main->execution_engine()->store_trade(cross.trade, ticket);
+        }
+    }
+    for (engines::NettedHedgeOrder& o : orders) {
+        // Worker thread: no fill of this order can be dispatched before it is tracked.
+        const std::optional<std::string> orderid =
+            put_intent(utilities::IntentSendOrder{o.owner, o.req});
+        if (orderid && !orderid->empty()) {
+            hedge->track_netted_order(*orderid, std::move(o.allocations));
+        }
+    }
+    for (const auto& c : cancels) {
+        put_intent(utilities::IntentCancelOrder{c});
+    }
+    for (const auto& l : logs) {
+        put_intent(utilities::IntentLog{l});
+    }
+}
+
+auto EventEngine::book_hedge_fill(const engines::HedgeFill& fill) -> uint64_t {
+    auto* main = static_cast<MainEngine*>(main_engine);
+    const uint64_t ticket = main->save_trade_data(fill.strategy_name, fill.trade);
+    if (main->position_engine() != nullptr) {
+        main->position_engine()->process_trade(fill.strategy_name, fill.trade);
+    }
+    return ticket;
+}
+
 auto EventEngine::put_intent(const utilities::Intent& intent) -> std::optional<std::string> {
     auto* main = static_cast<MainEngine*>(main_engine);
     switch (static_cast<utilities::IntentType>(intent.index())) {
@@ -52,37 +441,52 @@ auto EventEngine::put_intent(const utilities::Intent& intent) -> std::optional<s
     case SendOrder: {
         const auto& arg = std::get<utilities::IntentSendOrder>(intent);
         if (main == nullptr || main->execution_engine() == nullptr) {
-            if (main != nullptr) {
-                utilities::LogData log;
-                log.msg = std::format(
+            if (main != nullptr && main->log_engine() != nullptr) {
+                main->log_engine()->log(
+                    ERROR, "Event",
                     "[EventEngine] send_order failed: execution_engine is null for strategy {}",
                     arg.strategy_name);
-                log.level = ERROR;
-                log.gateway_name = "Event";
-                main->put_log_intent(log);
             }
             return std::nullopt;
         }
         auto* ex = main->execution_engine();
-        std::string orderid = ex->send_order(arg.strategy_name, arg.req);
-        if (orderid.empty()) {
+        std::string orderid;
+        if (!utilities::LatencyTracer::enabled()) {
+            orderid = ex->send_order(arg.strategy_name, arg.req);
+        } else {
+            // Carry the arrival stamp of the data the strategy last saw to the gateway.
+            utilities::OrderRequest req = arg.req;
+            if (req.trace_tsc == 0) {
+                if (const utilities::PortfolioData* portfolio =
+                        main->get_portfolio(strategy_portfolio(arg.strategy_name))) {
+                    req.trace_tsc = portfolio->trace_tsc_;
+                }
+            }
+            const utilities::LatencyProbe probe(utilities::LatencyStage::SendOrder);
+            orderid = ex->send_order(arg.strategy_name, req);
+        }
+        if (EventJournalWriter* journal = journal_.load(std::memory_order_acquire)) {
+            journal->record_send_order(arg.strategy_name, arg.req, orderid);
+        }
+        if (orderid.empty() && main->log_engine() != nullptr &&
+            main->log_engine()->accepts(ERROR)) {
             std::string combo_str =
                 arg.req.combo_type.has_value() ? utilities::to_string(*arg.req.combo_type) : "";
-            utilities::LogData log;
-            log.msg = std::format("[EventEngine] send_order returned empty orderid strategy={} "
-                                  "symbol={} is_combo={} type={} dir={} vol={}{}",
-                                  arg.strategy_name, arg.req.symbol, arg.req.is_combo ? 1 : 0,
-                                  utilities::to_string(arg.req.type),
-                                  utilities::to_string(arg.req.direction), arg.req.volume,
-                                  combo_str.empty() ? "" : " combo_type=" + combo_str);
-            log.level = ERROR;
-            log.gateway_name = "Event";
-            main->put_log_intent(log);
+            main->log_engine()->log(ERROR, "Event",
+                                    "[EventEngine] send_order returned empty orderid strategy={} "
+                                    "symbol={} is_combo={} type={} dir={} vol={}{}",
+                                    arg.strategy_name, arg.req.symbol, arg.req.is_combo ? 1 : 0,
+                                    utilities::to_string(arg.req.type),
+                                    utilities::to_string(arg.req.direction), arg.req.volume,
+                                    combo_str.empty() ? "" : " combo_type=" + combo_str);
         }
         return orderid;
     }
     case CancelOrder: {
         const auto& arg = std::get<utilities::IntentCancelOrder>(intent);
+        if (EventJournalWriter* journal = journal_.load(std::memory_order_acquire)) {
+            journal->record_cancel(arg.req);
+        }
         if (main != nullptr && main->execution_engine() != nullptr) {
             main->execution_engine()->cancel_order(arg.req);
         }
@@ -103,22 +507,237 @@ auto EventEngine::put_intent(const utilities::Intent& intent) -> std::optional<s
 void EventEngine::put_event(const utilities::Event& event) { put(event); }
 
 void EventEngine::put(const utilities::Event& event) {
-    {
-        std::scoped_lock lock(queue_mutex_);
-        queue_.push(event);
+    if (const auto* snap = std::get_if<utilities::SnapshotHandle>(&event.data);
+        snap != nullptr && *snap && event.type == utilities::EventType::Snapshot) {
+        put_snapshot(utilities::SnapshotHandle(*snap));
+        return;
     }
-    queue_cv_.notify_one();
+    enqueue(lane_of(event.type), QueuedEvent{.event = event, .enqueued_ns = steady_ns()});
 }
 
 void EventEngine::put(utilities::Event&& event) {
+    if (auto* snap = std::get_if<utilities::SnapshotHandle>(&event.data);
+        snap != nullptr && *snap && event.type == utilities::EventType::Snapshot) {
+        put_snapshot(std::move(*snap));
+        return;
+    }
+    const EventLane lane = lane_of(event.type);
+    enqueue(lane, QueuedEvent{.event = std::move(event), .enqueued_ns = steady_ns()});
+}
+
+auto EventEngine::conflation_slot(const std::string& portfolio_name) -> ConflationSlot& {
     {
-        std::scoped_lock lock(queue_mutex_);
-        queue_.push(std::move(event));
+        std::shared_lock lock(conflation_mutex_);
+        if (auto it = conflation_.find(portfolio_name); it != conflation_.end()) {
+            return *it->second;
+        }
     }
-    queue_cv_.notify_one();
+    std::scoped_lock lock(conflation_mutex_);
+    auto& slot = conflation_[portfolio_name];
+    if (!slot) {
+        slot = std::make_unique<ConflationSlot>();
+    }
+    return *slot;
 }
 
-void EventEngine::process(const utilities::Event& event) {
+void EventEngine::put_snapshot(utilities::SnapshotHandle&& snapshot) {
+    if (snapshot.use_count() == 0) {
+        // Borrowed: its owner only guarantees a synchronous dispatch.
+        snapshot = std::make_shared<utilities::PortfolioSnapshot>(*snapshot);
+    }
+    const std::string& portfolio_name = snapshot->portfolio_name;
+    ConflationSlot& slot = conflation_slot(portfolio_name);
+    Shard* shard = shards_.empty() ? nullptr : shards_[shard_of(portfolio_name)].get();
+    {
+        std::scoped_lock lock(slot.mutex);
+        if (slot.pending) {
+            // Marker already queued; the worker will dispatch the merged state in its place.
+            merge_snapshot(slot.pending, std::move(snapshot));
+            conflated_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        slot.pending = std::move(snapshot);
+    }
+    QueuedEvent marker{.event = utilities::Event(utilities::EventType::Snapshot),
+                       .enqueued_ns = steady_ns(),
+                       .slot = &slot};
+    const bool queued = shard == nullptr
+                            ? enqueue(EventLane::Snapshot, std::move(marker))
+                            : push(shard->ring, nullptr, shard->wake, std::move(marker));
+    if (!queued) {
+        std::scoped_lock lock(slot.mutex);
+        slot.pending.reset();
+    }
+}
+
+auto EventEngine::enqueue(EventLane lane, QueuedEvent&& item) -> bool {
+    Lane& target = *lanes_[static_cast<size_t>(lane)];
+    return push(target.ring, &target.overflow, wake_, std::move(item));
+}
+
+auto EventEngine::push(utilities::MpscRing<QueuedEvent>& ring,
+                       std::vector<QueuedEvent>* overflow, WakeSignal& wake, QueuedEvent&& item)
+    -> bool {
+    bool waited = false;
+    while (!ring.try_push(std::move(item))) {
+        if (t_worker_engine == this) {
+            // The main worker cannot wait on its own ring, nor on a shard it may hold locked.
+            if (overflow == nullptr) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            overflow->push_back(std::move(item));
+            break;
+        }
+        if (!active_.load(std::memory_order_relaxed)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (!waited) {
+            full_waits_.fetch_add(1, std::memory_order_relaxed);
+            waited = true;
+        }
+        std::this_thread::yield();
+    }
+    enqueued_.fetch_add(1, std::memory_order_relaxed);
+    wake.notify_if_parked();
+    return true;
+}
+
+void EventEngine::WakeSignal::notify_if_parked() {
+    // Pairs with the fence in idle_wait: either the worker sees the item or we see parked.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (parked.load(std::memory_order_relaxed)) {
+        wake();
+    }
+}
+
+void EventEngine::WakeSignal::wake() {
+    signal.fetch_add(1, std::memory_order_release);
+    signal.notify_one();
+}
+
+auto EventEngine::shard_of(const std::string& portfolio_name) const -> size_t {
+    return std::hash<std::string>{}(portfolio_name) % shards_.size();
+}
+
+auto EventEngine::portfolio_of_order(const std::string& orderid) const -> std::string {
+    auto* main = static_cast<MainEngine*>(main_engine);
+    if (main == nullptr || main->execution_engine() == nullptr) {
+        return {};
+    }
+    const std::string strategy_name =
+        main->execution_engine()->get_strategy_name_for_order(orderid);
+    return strategy_name.empty() ? std::string{} : strategy_portfolio(strategy_name);
+}
+
+template <typename F>
+void EventEngine::with_shards_locked(const std::string& portfolio_name, F&& fn) {
+    if (shards_.empty()) {
+        fn();
+        return;
+    }
+    if (!portfolio_name.empty()) {
+        Shard& shard = *shards_[shard_of(portfolio_name)];
+        shard.exclusive_waiters.fetch_add(1, std::memory_order_acq_rel);
+        {
+            std::scoped_lock lock(shard.apply_mutex);
+            fn();
+        }
+        shard.exclusive_waiters.fetch_sub(1, std::memory_order_acq_rel);
+        return;
+    }
+    // Shard workers only ever take their own mutex, so locking all in index order cannot deadlock.
+    for (const auto& shard : shards_) {
+        shard->exclusive_waiters.fetch_add(1, std::memory_order_acq_rel);
+    }
+    {
+        std::vector<std::unique_lock<std::mutex>> locks;
+        locks.reserve(shards_.size());
+        for (const auto& shard : shards_) {
+            locks.emplace_back(shard->apply_mutex);
+        }
+        fn();
+    }
+    for (const auto& shard : shards_) {
+        shard->exclusive_waiters.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+void EventEngine::record_dispatch(const std::vector<QueuedEvent>& batch) {
+    const int64_t now = steady_ns();
+    const bool tracing = utilities::LatencyTracer::enabled();
+    int64_t sum = 0;
+    int64_t max = 0;
+    for (const QueuedEvent& item : batch) {
+        const int64_t latency = now - item.enqueued_ns;
+        sum += latency;
+        max = std::max(max, latency);
+        if (tracing) {
+            utilities::LatencyTracer::instance().record_ns(
+                utilities::LatencyStage::EventQueue,
+                static_cast<uint64_t>(std::max<int64_t>(latency, 0)));
+        }
+    }
+    latency_sum_ns_.fetch_add(sum, std::memory_order_relaxed);
+    dispatched_.fetch_add(batch.size(), std::memory_order_relaxed);
+    int64_t seen = latency_max_ns_.load(std::memory_order_relaxed);
+    while (max > seen &&
+           !latency_max_ns_.compare_exchange_weak(seen, max, std::memory_order_relaxed)) {
+    }
+}
+
+auto EventEngine::resolve_snapshot(QueuedEvent& item) -> bool {
+    if (item.slot == nullptr) {
+        return true;
+    }
+    std::scoped_lock lock(item.slot->mutex);
+    if (!item.slot->pending) {
+        return false;
+    }
+    item.event.data = std::move(item.slot->pending);
+    item.slot->pending.reset();
+    return true;
+}
+
+void EventEngine::set_journal(std::unique_ptr<EventJournalWriter> journal) {
+    EventJournalWriter* previous = journal_.exchange(journal.get(), std::memory_order_acq_rel);
+    if (previous != nullptr) {
+        previous->flush();
+    }
+    if (journal) {
+        journals_.push_back(std::move(journal));
+    }
+}
+
+auto EventEngine::queue_stats() const -> EventQueueStats {
+    const uint64_t dispatched = dispatched_.load(std::memory_order_relaxed);
+    const int64_t sum = latency_sum_ns_.load(std::memory_order_relaxed);
+    EventQueueStats stats{
+        .enqueued = enqueued_.load(std::memory_order_relaxed),
+        .dispatched = dispatched,
+        .full_waits = full_waits_.load(std::memory_order_relaxed),
+        .dropped = dropped_.load(std::memory_order_relaxed),
+        .conflated = conflated_.load(std::memory_order_relaxed),
+        .latency_avg_ns = dispatched > 0 ? sum / static_cast<int64_t>(dispatched) : 0,
+        .latency_max_ns = latency_max_ns_.load(std::memory_order_relaxed),
+    };
+    for (size_t i = 0; i < kEventLaneCount; ++i) {
+        stats.lane_depth[i] = lanes_[i]->ring.size_approx();
+        stats.capacity += lanes_[i]->ring.capacity();
+    }
+    for (const auto& shard : shards_) {
+        stats.lane_depth[static_cast<size_t>(EventLane::Snapshot)] += shard->ring.size_approx();
+        stats.capacity += shard->ring.capacity();
+    }
+    for (const size_t depth : stats.lane_depth) {
+        stats.depth += depth;
+    }
+    stats.shards = static_cast<unsigned int>(shards_.size());
+    return stats;
+}
+
+void EventEngine::process(const utilities::Event& event, int64_t enqueued_ns) {
     auto* main = static_cast<MainEngine*>(main_engine);
     if (main == nullptr) {
         return;
@@ -126,82 +745,55 @@ void EventEngine::process(const utilities::Event& event) {
     switch (event.type) {
         using enum utilities::EventType;
     case Snapshot:
+        journal_event(event, enqueued_ns);
         dispatch_snapshot(event);
         break;
     case Timer:
-        dispatch_timer();
+        with_shards_locked({}, [this, &event, enqueued_ns]() {
+            journal_event(event, enqueued_ns);
+            dispatch_timer();
+        });
         break;
-    case Order:
-        dispatch_order(event);
+    case Order: {
+        const auto* order = std::get_if<utilities::OrderData>(&event.data);
+        const std::string portfolio = (shards_.empty() || order == nullptr)
+                                          ? std::string{}
+                                          : portfolio_of_order(order->orderid);
+        with_shards_locked(portfolio, [this, &event, enqueued_ns]() {
+            journal_event(event, enqueued_ns);
+            dispatch_order(event);
+        });
         break;
-    case Trade:
-        dispatch_trade(event);
+    }
+    case Trade: {
+        const auto* trade = std::get_if<utilities::TradeData>(&event.data);
+        // A netted hedge fill is booked on several strategies: lock every shard.
+        const bool netted = trade != nullptr && main->hedge_engine() != nullptr &&
+                            main->hedge_engine()->is_netted_order(trade->orderid);
+        const std::string portfolio = (shards_.empty() || trade == nullptr || netted)
+                                          ? std::string{}
+                                          : portfolio_of_order(trade->orderid);
+        with_shards_locked(portfolio, [this, &event, enqueued_ns]() {
+            journal_event(event, enqueued_ns);
+            dispatch_trade(event);
+        });
         break;
+    }
     default:
         break;
     }
 }
 
 void EventEngine::dispatch_timer() {
-    auto* main = static_cast<MainEngine*>(main_engine);
-    if (main == nullptr) {
-        return;
-    }
-    if (main->ib_gateway() != nullptr) {
-        main->ib_gateway()->process_timer_event(utilities::Event(utilities::EventType::Timer));
-    }
-    engines::PositionEngine* pos = main->position_engine();
-    if (pos != nullptr) {
-        std::vector<utilities::LogData> pos_logs;
-        pos->process_timer_event(
-            [main](const std::string& name) -> utilities::PortfolioData* {
-                return main->get_portfolio(name);
-            },
-            &pos_logs);
-        for (const auto& l : pos_logs) {
-            main->put_log_intent(l);
-        }
-    }
-    engines::HedgeEngine* hedge = main->hedge_engine();
-    core::OptionStrategyEngine* se = main->option_strategy_engine();
-    if ((hedge != nullptr) && (se != nullptr)) {
-        for (const std::string& strategy_name : se->get_strategy_names()) {
-            std::string portfolio_name = strategy_name;
-            size_t p = strategy_name.find('_');
-            if (p != std::string::npos && p + 1 < strategy_name.size()) {
-                portfolio_name = strategy_name.substr(p + 1);
-            }
-            engines::HedgeParams params;
-            params.portfolio = main->get_portfolio(portfolio_name);
-            params.holding = main->get_holding(strategy_name);
-            params.get_contract = [main](const std::string& sym) -> const utilities::ContractData* {
-                return main->get_contract(sym);
-            };
-            params.get_strategy_active_orders =
-                [se]() -> const std::unordered_map<std::string, std::set<std::string>>& {
-                return se->get_strategy_active_orders();
-            };
-            params.get_order = [se](const std::string& oid) -> utilities::OrderData* {
-                return se->get_order(oid);
-            };
-            std::vector<utilities::OrderRequest> orders;
-            std::vector<utilities::CancelRequest> cancels;
-            std::vector<utilities::LogData> logs;
-            hedge->process_hedging(strategy_name, params, &orders, &cancels, &logs);
-            for (const auto& o : orders) {
-                put_intent(utilities::IntentSendOrder{strategy_name, o});
-            }
-            for (const auto& c : cancels) {
-                put_intent(utilities::IntentCancelOrder{c});
-            }
-            for (const auto& l : logs) {
-                put_intent(utilities::IntentLog{l});
-            }
-        }
-    }
-    if (se != nullptr) {
-        se->on_timer();
+    timers_.advance(steady_ms());
+    flush_strategy_timers();
+    frame_arena_.reset();
+    {
+        std::scoped_lock lock(timer_mutex_);
+        timer_pending_ = false;
+        timer_rescan_ = true;
     }
+    timer_cv_.notify_one();
 }
 
 void EventEngine::dispatch_order(const utilities::Event& event) {
@@ -215,10 +807,13 @@ void EventEngine::dispatch_order(const utilities::Event& event) {
         std::string strategy_name;
         if (ex != nullptr) {
             strategy_name = ex->get_strategy_name_for_order(order.orderid);
-            ex->store_order(strategy_name, order);
-            if (!strategy_name.empty()) {
-                main->save_order_data(strategy_name, order);
-            }
+            // Save first: the ticket tells the execution cache when the record may be evicted.
+            const uint64_t ticket =
+                strategy_name.empty() ? 0 : main->save_order_data(strategy_name, order);
+            ex->store_order(strategy_name, order, ticket);
+        }
+        if (main->hedge_engine() != nullptr) {
+            main->hedge_engine()->on_order(order);
         }
         if (main->position_engine() != nullptr) {
             main->position_engine()->process_order(strategy_name, order);
@@ -237,15 +832,23 @@ void EventEngine::dispatch_trade(const utilities::Event& event) {
     if (const auto* pd = std::get_if<utilities::TradeData>(&event.data)) {
         utilities::TradeData trade = *pd;
         core::ExecutionEngine* ex = main->execution_engine();
+        // A netted hedge fill is booked as its per-strategy shares instead of on the owner.
+        std::vector<engines::HedgeFill> fills;
+        const bool netted =
+            main->hedge_engine() != nullptr && main->hedge_engine()->allocate_fill(trade, &fills);
         std::string strategy_name;
         if (ex != nullptr) {
-            ex->store_trade(trade);
             strategy_name = ex->get_strategy_name_for_order(trade.orderid);
-            if (!strategy_name.empty()) {
-                main->save_trade_data(strategy_name, trade);
-            }
+            const uint64_t ticket = (netted || strategy_name.empty())
+                                        ? 0
+                                        : main->save_trade_data(strategy_name, trade);
+            ex->store_trade(trade, ticket);
         }
-        if (main->position_engine() != nullptr) {
+        if (netted) {
+            for (const engines::HedgeFill& fill : fills) {
+                book_hedge_fill(fill);
+            }
+        } else if (main->position_engine() != nullptr) {
             main->position_engine()->process_trade(strategy_name, trade);
         }
         if (main->option_strategy_engine() != nullptr) {
@@ -259,44 +862,155 @@ void EventEngine::dispatch_snapshot(const utilities::Event& event) {
     if (main == nullptr) {
         return;
     }
-    if (const auto* snap = std::get_if<utilities::PortfolioSnapshot>(&event.data)) {
+    if (const utilities::PortfolioSnapshot* snap = event.snapshot()) {
         utilities::PortfolioData* portfolio = main->get_portfolio(snap->portfolio_name);
-        if (portfolio != nullptr) {
+        if (portfolio == nullptr) {
+            return;
+        }
+        if (!utilities::LatencyTracer::enabled()) {
             portfolio->apply_frame(*snap);
+        } else {
+            utilities::LatencyTracer& tracer = utilities::LatencyTracer::instance();
+            const uint64_t start = utilities::trace_now();
+            portfolio->apply_frame(*snap);
+            const uint64_t end = utilities::trace_now();
+            tracer.record(utilities::LatencyStage::ApplyFrame, start, end);
+            if (snap->trace_tsc != 0) {
+                tracer.record(utilities::LatencyStage::TickToApply, snap->trace_tsc, end);
+                portfolio->trace_tsc_ = snap->trace_tsc;
+            }
         }
+        main->publish_chain_greeks(*portfolio, snap->chains);
     }
 }
 
+void EventEngine::journal_event(const utilities::Event& event, int64_t enqueued_ns) {
+    EventJournalWriter* journal = journal_.load(std::memory_order_acquire);
+    if (journal == nullptr) {
+        return;
+    }
+    const utilities::PortfolioData* portfolio = nullptr;
+    if (const utilities::PortfolioSnapshot* snap = event.snapshot()) {
+        if (auto* main = static_cast<MainEngine*>(main_engine)) {
+            portfolio = main->get_portfolio(snap->portfolio_name);
+        }
+    }
+    journal->record_event(event, enqueued_ns, portfolio);
+}
+
 void EventEngine::run_timer(const std::stop_token& st) {
+    const std::chrono::milliseconds max_sleep = std::chrono::seconds(std::max(interval_, 1));
+    std::unique_lock lock(timer_mutex_);
+    while (!st.stop_requested() && active_) {
+        timer_rescan_ = false;
+        const std::optional<std::chrono::milliseconds> due = timers_.next_due();
+        const std::chrono::milliseconds now = steady_ms();
+        if (due && *due <= now) {
+            // One Timer in flight: a late worker sees every due timer in a single advance.
+            if (!timer_pending_.exchange(true)) {
+                lock.unlock();
+                put(utilities::Event(utilities::EventType::Timer));
+                lock.lock();
+            }
+        }
+        // While a Timer is pending, its dispatch wakes us to compute the next deadline.
+        const std::chrono::milliseconds delay = (!timer_pending_ && due && *due > now)
+                                                    ? std::min(*due - now, max_sleep)
+                                                    : max_sleep;
+        timer_cv_.wait_for(lock, st, delay, [this]() -> bool { return timer_rescan_; });
+    }
+}
+
+auto EventEngine::any_ready() const -> bool {
+    return std::ranges::any_of(lanes_, [](const std::unique_ptr<Lane>& lane) -> bool {
+        return lane->ring.ready() || !lane->overflow.empty();
+    });
+}
+
+auto EventEngine::take_batch() -> bool {
+    batch_.clear();
+    for (size_t i = 0; i < kEventLaneCount; ++i) {
+        Lane& lane = *lanes_[i];
+        const size_t max = i == static_cast<size_t>(EventLane::Execution) ? kDrainBatch : 1;
+        lane.ring.pop_batch([this](QueuedEvent&& item) { batch_.push_back(std::move(item)); },
+                            max);
+        if (batch_.empty() && !lane.overflow.empty()) {
+            // The worker's own puts made while this ring was full: newer than the ring's items
+            // at that time, so they run once the ring is drained.
+            batch_.swap(lane.overflow);
+        }
+        if (!batch_.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename Ready>
+void EventEngine::idle_wait(WakeSignal& wake, const Ready& ready, const std::stop_token& st) {
+    for (int i = 0; i < kIdleSpins; ++i) {
+        if (ready() || !active_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        utilities::cpu_relax();
+    }
+    for (int i = 0; i < kIdleYields; ++i) {
+        if (ready() || !active_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        std::this_thread::yield();
+    }
+    const uint32_t seen = wake.signal.load(std::memory_order_acquire);
+    wake.parked.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!ready() && active_.load(std::memory_order_relaxed) && !st.stop_requested()) {
+        wake.signal.wait(seen, std::memory_order_acquire);
+    }
+    wake.parked.store(false, std::memory_order_relaxed);
+}
+
+void EventEngine::run_shard(Shard& shard, const std::stop_token& st) {
     while (!st.stop_requested() && active_) {
-        std::this_thread::sleep_for(std::chrono::seconds(interval_));
-        if (!st.stop_requested() && active_) {
-            put(utilities::Event(utilities::EventType::Timer));
+        if (shard.exclusive_waiters.load(std::memory_order_acquire) > 0) {
+            std::this_thread::yield();
+            continue;
         }
+        shard.batch.clear();
+        shard.ring.pop_batch(
+            [&shard](QueuedEvent&& item) { shard.batch.push_back(std::move(item)); }, 1);
+        if (shard.batch.empty()) {
+            idle_wait(shard.wake, [&shard]() -> bool { return shard.ring.ready(); }, st);
+            continue;
+        }
+        record_dispatch(shard.batch);
+        QueuedEvent& item = shard.batch.front();
+        if (!active_ || !resolve_snapshot(item)) {
+            continue;
+        }
+        std::scoped_lock lock(shard.apply_mutex);
+        journal_event(item.event, item.enqueued_ns);
+        dispatch_snapshot(item.event);
     }
 }
 
 void EventEngine::run(const std::stop_token& st) {
+    t_worker_engine = this;
     while (!st.stop_requested() && active_) {
-        utilities::Event event;
-        bool got = false;
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            queue_cv_.wait(lock, st, [this, &got, &event]() -> bool {
-                if (!active_) {
-                    return true;
-                }
-                if (queue_.empty()) {
-                    return false;
-                }
-                event = std::move(queue_.front());
-                queue_.pop();
-                got = true;
-                return true;
-            });
+        // Re-pick the lane after every batch so a fill never waits behind more than one
+        // Timer or Snapshot dispatch.
+        if (!take_batch()) {
+            idle_wait(wake_, [this]() -> bool { return any_ready(); }, st);
+            continue;
         }
-        if (got && active_) {
-            process(event);
+        record_dispatch(batch_);
+        for (QueuedEvent& item : batch_) {
+            if (!active_) {
+                break;
+            }
+            if (!resolve_snapshot(item)) {
+                continue;
+            }
+            process(item.event, item.enqueued_ns);
         }
     }
 }
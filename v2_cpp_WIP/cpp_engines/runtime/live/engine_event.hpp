@@ -1,30 +1,88 @@
 #pragma once
 
-/** EventEngine: dispatch by type/order; queue + worker thread. */
+/**
+ * EventEngine: dispatch by type/order; one lock-free MPSC ring per priority lane + worker thread.
+ * Snapshots are conflated per portfolio while pending; Order/Trade/Timer events are always queued.
+ * With shards > 1, Snapshot apply_frame runs on that many shard workers keyed by portfolio.
+ * Periodic work (gateway polling, metrics, strategy and hedge timers) lives on a timer wheel; the
+ * timer thread sleeps until the next deadline and a Timer event fires only what is due. With
+ * parallel strategy timers, strategies due together run as one OptionStrategyEngine::on_timer
+ * round (all shards are locked, so portfolios hold still). Intent out-vectors of the metrics and
+ * hedge timers come from a worker-owned FrameArena reset after each Timer.
+ */
 
 #include "../../utilities/base_engine.hpp"
+#include "../../utilities/frame_arena.hpp"
 #include "../../utilities/intent.hpp"
+#include "../../utilities/mpsc_ring.hpp"
 #include "../../utilities/portfolio.hpp" // Event, EventType, OrderRequest, CancelRequest, LogData
+#include "../../utilities/timer_wheel.hpp"
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <optional>
+#include <shared_mutex>
 #include <stop_token>
+#include <string>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace engines {
 
 class MainEngine;
+class EventJournalWriter;
+struct HedgeFill;
+struct HedgeParams;
 
 /** Alias so callers can use engines::Event (same as utilities::Event). */
 using Event = utilities::Event;
 
-/** process(Event): dispatch by type; Snapshot→apply_frame. */
+/**
+ * Dispatch priority, highest first: Order/Trade, then Timer, then Snapshot. The worker always
+ * serves the highest non-empty lane; each lane is FIFO, so order within a lane is deterministic.
+ */
+enum class EventLane : uint8_t { Execution, Timer, Snapshot };
+inline constexpr size_t kEventLaneCount = 3;
+
+/** Ring depth and enqueue→dispatch latency (steady clock), readable from any thread. */
+struct EventQueueStats {
+    /** Sum over lanes; lane_depth is indexed by EventLane. */
+    size_t depth = 0;
+    size_t capacity = 0;
+    std::array<size_t, kEventLaneCount> lane_depth{};
+    /** Snapshot shard workers (0: snapshots run on the main worker). */
+    unsigned int shards = 0;
+    uint64_t enqueued = 0;
+    uint64_t dispatched = 0;
+    /** put() calls that found the ring full and had to wait. */
+    uint64_t full_waits = 0;
+    /** Events dropped because the ring was full while stopping. */
+    uint64_t dropped = 0;
+    /** Snapshots folded into one already pending for the same portfolio. */
+    uint64_t conflated = 0;
+    int64_t latency_avg_ns = 0;
+    int64_t latency_max_ns = 0;
+};
+
+/**
+ * process(Event): dispatch by type; Snapshot→apply_frame.
+ * Sharding: each portfolio hashes to one shard worker, which alone applies its snapshots under
+ * the shard's apply mutex. The main worker keeps Order/Trade/Timer: an Order/Trade locks the shard
+ * of its strategy's portfolio (resolved via ExecutionEngine's orderid→strategy lookup), a Timer
+ * locks every shard. Strategies, holdings and core engines are only touched by the main worker.
+ */
 class EventEngine : public utilities::BaseEngine {
   public:
-    explicit EventEngine(utilities::MainEngine* main, int interval = 1);
+    /** shards ≤ 1 keeps snapshot dispatch on the main worker. */
+    explicit EventEngine(utilities::MainEngine* main, int interval = 1, unsigned int shards = 1);
     ~EventEngine() override;
 
     EventEngine(const EventEngine&) = delete;
@@ -46,20 +104,170 @@ class EventEngine : public utilities::BaseEngine {
     }
     void unregister_handler(utilities::EventType, uint64_t) {}
 
+    /**
+     * Periodic fn on the worker thread (all shards locked), steady-clock time. Wakes the timer
+     * thread so a period shorter than the current sleep takes effect at once.
+     */
+    utilities::TimerWheel::TimerId add_timer(std::chrono::milliseconds period,
+                                             utilities::TimerWheel::Callback fn);
+    utilities::TimerWheel& timers() { return timers_; }
+    /** Timer wheel tick: strategy and hedge periods are multiples of it. */
+    [[nodiscard]] std::chrono::milliseconds timer_tick() const {
+        return std::chrono::seconds(std::max(interval_, 1));
+    }
+
+    [[nodiscard]] EventQueueStats queue_stats() const;
+    /**
+     * Record every dispatched event, in dispatch order, and the intents it produced; events are
+     * written under the locks they are applied under. Safe while running (control thread); a
+     * replaced journal is flushed and stays open until the engine is destroyed.
+     */
+    void set_journal(std::unique_ptr<EventJournalWriter> journal);
+    [[nodiscard]] unsigned int shard_count() const {
+        return static_cast<unsigned int>(shards_.size());
+    }
+
+    static constexpr size_t kRingCapacity = 4096;
+    /** Order/Trade events per batch; Timer and Snapshot go one at a time so fills can cut in. */
+    static constexpr size_t kDrainBatch = 64;
+
+    static EventLane lane_of(utilities::EventType type);
+
   private:
+    /** Latest not-yet-dispatched snapshot of one portfolio. */
+    struct ConflationSlot {
+        std::mutex mutex;
+        /** Shared with its producer until a merge writes it (see merge_snapshot). */
+        utilities::SnapshotHandle pending;
+    };
+
+    struct QueuedEvent {
+        utilities::Event event;
+        int64_t enqueued_ns = 0;
+        /** Set for Snapshot markers: the payload is taken from slot->pending at dispatch. */
+        ConflationSlot* slot = nullptr;
+    };
+
+    /** One lane: its ring plus the worker's re-entrant puts made while the ring was full. */
+    struct Lane {
+        explicit Lane(size_t capacity) : ring(capacity) {}
+        utilities::MpscRing<QueuedEvent> ring;
+        std::vector<QueuedEvent> overflow;
+    };
+
+    /** Worker park/wake state; producers signal only while parked is set. */
+    struct WakeSignal {
+        std::atomic<bool> parked{false};
+        std::atomic<uint32_t> signal{0};
+        void notify_if_parked();
+        void wake();
+    };
+
+    /** Snapshot worker for the portfolios hashed to it. */
+    struct Shard {
+        explicit Shard(size_t capacity) : ring(capacity) {}
+        utilities::MpscRing<QueuedEvent> ring;
+        WakeSignal wake;
+        /** Held by the shard while applying, by the main worker while it reads the portfolio. */
+        std::mutex apply_mutex;
+        /** Main-worker lock requests pending; the shard yields before its next apply. */
+        std::atomic<int> exclusive_waiters{0};
+        std::vector<QueuedEvent> batch;
+        std::jthread thread;
+    };
+
+    /** Push into the lane's ring (waits while full); false if dropped because we stopped. */
+    bool enqueue(EventLane lane, QueuedEvent&& item);
+    bool push(utilities::MpscRing<QueuedEvent>& ring, std::vector<QueuedEvent>* overflow,
+              WakeSignal& wake, QueuedEvent&& item);
+    [[nodiscard]] size_t shard_of(const std::string& portfolio_name) const;
+    /** Portfolio of the strategy that sent orderid; empty when unknown. */
+    [[nodiscard]] std::string portfolio_of_order(const std::string& orderid) const;
+    /** Run fn with the portfolio's shard locked (every shard when portfolio is empty). */
+    template <typename F> void with_shards_locked(const std::string& portfolio_name, F&& fn);
+    void record_dispatch(const std::vector<QueuedEvent>& batch);
+    /** Take the slot's pending snapshot into item.event; false if it was already dropped. */
+    static bool resolve_snapshot(QueuedEvent& item);
+    void run_shard(Shard& shard, const std::stop_token& st);
+    /** Fill batch_ from the highest non-empty lane; false when all lanes are empty. */
+    bool take_batch();
+    [[nodiscard]] bool any_ready() const;
+    /** Replace or merge into the portfolio's pending snapshot; queue a marker if none pending. */
+    void put_snapshot(utilities::SnapshotHandle&& snapshot);
+    ConflationSlot& conflation_slot(const std::string& portfolio_name);
+    /** Spin, then yield, then park on wake until a producer or stop() signals it. */
+    template <typename Ready>
+    void idle_wait(WakeSignal& wake, const Ready& ready, const std::stop_token& st);
     void dispatch_snapshot(const utilities::Event& event);
+    /** Append event to the journal, if any (caller holds the locks it is dispatched under). */
+    void journal_event(const utilities::Event& event, int64_t enqueued_ns);
+    /** Gateway, metrics and strategy-sync timers; run by start(). */
+    void register_timers();
+    /** timers_.add plus a timer-thread rescan; add_timer also flushes due strategies first. */
+    utilities::TimerWheel::TimerId schedule(std::chrono::milliseconds period,
+                                            utilities::TimerWheel::Callback fn);
+    /** Add/re-add/cancel the per-strategy and per-hedge timers to match the engines. */
+    void sync_strategy_timers();
+    /** Parallel timers: run the strategies collected since the last flush as one round. */
+    void flush_strategy_timers();
+    /** Hedge inputs of strategy_name: its portfolio, holding, contracts and active orders. */
+    engines::HedgeParams hedge_params(const std::string& strategy_name);
+    void run_hedging(const std::string& strategy_name);
+    /** Netting mode: one hedge round over every registered strategy. */
+    void run_netted_hedging();
+    /** Save and book a hedge cross or allocated parent fill on its strategy's holding. */
+    uint64_t book_hedge_fill(const engines::HedgeFill& fill);
     void dispatch_timer();
     void dispatch_order(const utilities::Event& event);
     void dispatch_trade(const utilities::Event& event);
     void run(const std::stop_token& st);
     void run_timer(const std::stop_token& st);
-    void process(const utilities::Event& event);
+    void process(const utilities::Event& event, int64_t enqueued_ns);
 
     int interval_ = 1;
-    std::queue<utilities::Event> queue_;
-    std::mutex queue_mutex_;
-    std::condition_variable_any queue_cv_;
+    std::atomic<EventJournalWriter*> journal_{nullptr};
+    /** Every journal ever set (owned here so workers never see one destroyed). */
+    std::vector<std::unique_ptr<EventJournalWriter>> journals_;
+    std::array<std::unique_ptr<Lane>, kEventLaneCount> lanes_;
+    /** Consumer-side batch buffer. */
+    std::vector<QueuedEvent> batch_;
+    std::unordered_map<std::string, std::unique_ptr<ConflationSlot>> conflation_;
+    std::shared_mutex conflation_mutex_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    WakeSignal wake_;
     std::atomic<bool> active_{false};
+
+    std::atomic<uint64_t> enqueued_{0};
+    std::atomic<uint64_t> dispatched_{0};
+    std::atomic<uint64_t> full_waits_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> conflated_{0};
+    std::atomic<int64_t> latency_sum_ns_{0};
+    std::atomic<int64_t> latency_max_ns_{0};
+
+    /** Scheduled timer. */
+    struct TimerEntry {
+        utilities::TimerWheel::TimerId id = 0;
+        std::chrono::milliseconds period{0};
+    };
+    utilities::TimerWheel timers_;
+    /** Worker only: strategy and hedge timers by strategy name (one shared key when netting). */
+    std::unordered_map<std::string, TimerEntry> strategy_timers_;
+    std::unordered_map<std::string, TimerEntry> hedge_timers_;
+    /**
+     * Worker only: strategies whose timer fired and that the next flush runs together. Any other
+     * timer flushes first, so firing order across timers is kept.
+     */
+    std::vector<std::string> due_strategies_;
+    /** Worker only: memory of the Timer being dispatched (metrics logs, hedge intents). */
+    utilities::FrameArena frame_arena_;
+    /** A Timer event is queued and not yet dispatched (at most one in flight). */
+    std::atomic<bool> timer_pending_{false};
+    std::mutex timer_mutex_;
+    std::condition_variable_any timer_cv_;
+    /** A timer was added: the timer thread recomputes its deadline. */
+    bool timer_rescan_ = false;
+    bool timers_registered_ = false;
     std::jthread thread_;
     std::jthread timer_thread_;
 };
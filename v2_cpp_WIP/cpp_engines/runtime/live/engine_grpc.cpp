@@ -2,17 +2,37 @@
 #include "../../core/engine_log.hpp"
 #include "../../strategy/strategy_registry.hpp"
 #include "../../strategy/template.hpp"
+#include "../../utilities/broadcast_hub.hpp"
 #include "../../utilities/event.hpp"
+#include "../../utilities/latency.hpp"
+#include "../../utilities/versioned_store.hpp"
 #include "engine_db_pg.hpp"
 
 #include <cstdlib>
 #include <exception>
 #include <format>
+#include <mutex>
+#include <string_view>
+#include <variant>
+#include <vector>
 
 namespace engines {
 
 namespace {
 
+void fill_latency(::otrader::LatencyHistogramMsg* out, const std::string& name,
+                  const utilities::LatencySummary& s) {
+    out->set_name(name);
+    out->set_count(s.count);
+    out->set_mean_ns(s.mean_ns);
+    out->set_min_ns(s.min_ns);
+    out->set_p50_ns(s.p50_ns);
+    out->set_p90_ns(s.p90_ns);
+    out->set_p99_ns(s.p99_ns);
+    out->set_p999_ns(s.p999_ns);
+    out->set_max_ns(s.max_ns);
+}
+
 auto parse_setting_json(const std::string& s) -> std::unordered_map<std::string, double> {
     std::unordered_map<std::string, double> out;
     if (s.empty() || s == "{}") {
@@ -52,6 +72,223 @@ auto parse_setting_json(const std::string& s) -> std::unordered_map<std::string,
     return out;
 }
 
+/** Values per hub read; written back to back, flushed once per batch. */
+constexpr size_t kStreamBatch = 64;
+
+/** Client metadata "slow-consumer: disconnect" → Disconnect; otherwise skip ahead. */
+auto slow_consumer_policy(const ::grpc::CallbackServerContext& context)
+    -> utilities::SlowSubscriberPolicy {
+    const auto& md = context.client_metadata();
+    const auto it = md.find("slow-consumer");
+    if (it != md.end() && std::string_view(it->second.data(), it->second.size()) == "disconnect") {
+        return utilities::SlowSubscriberPolicy::Disconnect;
+    }
+    return utilities::SlowSubscriberPolicy::DropOldest;
+}
+
+/** Stream that ends at once with status (e.g. engine missing). */
+template <typename Msg> class FinishedStream final : public ::grpc::ServerWriteReactor<Msg> {
+  public:
+    explicit FinishedStream(const ::grpc::Status& status) { this->Finish(status); }
+    void OnDone() override { delete this; }
+};
+
+/**
+ * Server stream with at most one write in flight. pump() (any thread) asks next_locked for the
+ * next message whenever the stream is idle; subclasses call pump() again when data arrives.
+ */
+template <typename Msg> class PumpedWriteReactor : public ::grpc::ServerWriteReactor<Msg> {
+  public:
+    void OnWriteDone(bool ok) override {
+        {
+            std::scoped_lock lock(mutex_);
+            writing_ = false;
+            if (!ok || cancelled_) {
+                finish_locked(::grpc::Status::CANCELLED);
+                return;
+            }
+        }
+        pump();
+    }
+
+    void OnCancel() override {
+        std::scoped_lock lock(mutex_);
+        cancelled_ = true;
+        if (!writing_) {
+            finish_locked(::grpc::Status::CANCELLED);
+        }
+    }
+
+    void OnDone() override {
+        release();
+        delete this;
+    }
+
+  protected:
+    /** Fill msg_ (and options) and return true to write it; false to wait. Under mutex_. */
+    virtual bool next_locked(::grpc::WriteOptions& options) = 0;
+    /** Before delete: drop subscriptions so no further pump() can arrive. */
+    virtual void release() {}
+
+    void pump() {
+        std::scoped_lock lock(mutex_);
+        if (writing_ || finished_) {
+            return;
+        }
+        ::grpc::WriteOptions options;
+        if (!next_locked(options)) {
+            return;
+        }
+        writing_ = true;
+        this->StartWrite(&msg_, options);
+    }
+
+    void finish_locked(const ::grpc::Status& status) {
+        if (!finished_) {
+            finished_ = true;
+            this->Finish(status);
+        }
+    }
+
+    Msg msg_;
+
+  private:
+    std::mutex mutex_;
+    bool writing_ = false;
+    bool cancelled_ = false;
+    bool finished_ = false;
+};
+
+/**
+ * One server stream subscribed to a BroadcastHub. Reads up to kStreamBatch values per turn and
+ * writes them back to back (buffer_hint on all but the last, so gRPC coalesces the batch into one
+ * flush); when caught up it arms the hub and the next publish resumes it.
+ */
+template <typename T, typename Msg> class HubStreamReactor final : public PumpedWriteReactor<Msg> {
+  public:
+    using Fill = void (*)(const T&, Msg&);
+
+    HubStreamReactor(utilities::BroadcastHub<T>& hub, utilities::SlowSubscriberPolicy policy,
+                     Fill fill)
+        : hub_(hub), fill_(fill) {
+        sub_ = hub_.subscribe(policy, [this]() -> void { this->pump(); });
+        this->pump();
+    }
+
+  private:
+    bool next_locked(::grpc::WriteOptions& options) override {
+        while (next_ == batch_.size()) {
+            batch_.clear();
+            next_ = 0;
+            if (!hub_.read(*sub_, batch_, kStreamBatch)) {
+                this->finish_locked(::grpc::Status(::grpc::StatusCode::RESOURCE_EXHAUSTED,
+                                                   "slow consumer: stream buffer overrun"));
+                return false;
+            }
+            if (batch_.empty() && hub_.arm(*sub_)) {
+                return false;
+            }
+        }
+        this->msg_.Clear();
+        fill_(batch_[next_], this->msg_);
+        ++next_;
+        if (next_ < batch_.size()) {
+            options.set_buffer_hint();
+        }
+        return true;
+    }
+
+    void release() override { hub_.unsubscribe(sub_); }
+
+    utilities::BroadcastHub<T>& hub_;
+    Fill fill_;
+    typename utilities::BroadcastHub<T>::SubscriberPtr sub_;
+    std::vector<T> batch_;
+    size_t next_ = 0;
+};
+
+/**
+ * StreamHoldings: woken by live_state commits; each message carries everything changed after the
+ * last sent seq, so changes made while a write is in flight merge into the next one.
+ */
+class HoldingsStreamReactor final : public PumpedWriteReactor<::otrader::HoldingsDelta> {
+  public:
+    HoldingsStreamReactor(MainEngine& main, uint64_t since_seq, bool full_resync)
+        : main_(main), state_(main.live_state()) {
+        // A seq ahead of the store was issued by an earlier process: resync.
+        full_pending_ = full_resync || since_seq == 0 || since_seq > state_.seq();
+        sent_seq_ = full_pending_ ? 0 : since_seq;
+        sub_ = state_.changes().subscribe(utilities::SlowSubscriberPolicy::DropOldest,
+                                          [this]() -> void { pump(); });
+        pump();
+    }
+
+  private:
+    bool next_locked(::grpc::WriteOptions& /*options*/) override {
+        while (true) {
+            wakeups_.clear();
+            state_.changes().read(*sub_, wakeups_, kStreamBatch);
+            if (full_pending_ || state_.seq() != sent_seq_) {
+                break;
+            }
+            if (state_.changes().arm(*sub_)) {
+                return false;
+            }
+        }
+        msg_.Clear();
+        const uint64_t seq = state_.changed_since(
+            sent_seq_, [this](const std::string& key, const LiveStateValue* value) -> void {
+                add_entry(key, value);
+            });
+        msg_.set_seq(seq);
+        msg_.set_full(full_pending_);
+        if (full_pending_) {
+            for (const std::string& name : main_.get_all_portfolio_names()) {
+                msg_.add_portfolios(name);
+            }
+        }
+        sent_seq_ = seq;
+        full_pending_ = false;
+        return true;
+    }
+
+    void add_entry(std::string_view key, const LiveStateValue* value) {
+        if (key.starts_with(MainEngine::kHoldingKeyPrefix)) {
+            const std::string name(key.substr(MainEngine::kHoldingKeyPrefix.size()));
+            if (value == nullptr) {
+                msg_.add_removed_strategies(name);
+            } else if (const auto* bytes = std::get_if<std::string>(value)) {
+                (*msg_.mutable_holdings())[name].ParseFromString(*bytes);
+            }
+            return;
+        }
+        const auto* g = value != nullptr ? std::get_if<utilities::ChainGreeksData>(value) : nullptr;
+        if (g == nullptr) {
+            return;
+        }
+        ::otrader::ChainGreeksMsg* c = msg_.add_chains();
+        c->set_portfolio(g->portfolio);
+        c->set_chain(g->chain);
+        c->set_atm_price(g->atm_price);
+        c->set_atm_iv(g->atm_iv);
+        c->set_skew(g->skew);
+        c->set_days_to_expiry(g->days_to_expiry);
+        c->set_delta(g->delta);
+        c->set_gamma(g->gamma);
+        c->set_theta(g->theta);
+        c->set_vega(g->vega);
+    }
+
+    void release() override { state_.changes().unsubscribe(sub_); }
+
+    MainEngine& main_;
+    utilities::VersionedStore<LiveStateValue>& state_;
+    utilities::BroadcastHub<uint64_t>::SubscriberPtr sub_;
+    std::vector<uint64_t> wakeups_;
+    uint64_t sent_seq_ = 0;
+    bool full_pending_ = true;
+};
+
 } // namespace
 
 GrpcLiveEngineService::GrpcLiveEngineService(MainEngine* main_engine) : main_engine_(main_engine) {}
@@ -75,8 +312,30 @@ auto GrpcLiveEngineService::GetStatus(::grpc::ServerContext* /*context*/,
     if (!running) {
         response->set_detail("engine: stopped; ib: off; md: off");
     } else {
-        response->set_detail(std::format("engine: running; ib: {}; md: {}",
-                                         ib_connected ? "on" : "off", md_running ? "on" : "off"));
+        response->set_detail(std::format("engine: running; ib: {}; md: {}; latency: {}",
+                                         ib_connected ? "on" : "off", md_running ? "on" : "off",
+                                         utilities::LatencyTracer::enabled() ? "on" : "off"));
+    }
+    return ::grpc::Status::OK;
+}
+
+auto GrpcLiveEngineService::GetLatency(::grpc::ServerContext* /*context*/,
+                                       const ::otrader::LatencyRequest* request,
+                                       ::otrader::LatencyReport* response) -> ::grpc::Status {
+    if (response == nullptr) {
+        return ::grpc::Status(::grpc::StatusCode::INTERNAL, "response is null");
+    }
+    utilities::LatencyTracer& tracer = utilities::LatencyTracer::instance();
+    const utilities::LatencyReport report = tracer.report();
+    response->set_enabled(report.enabled);
+    for (const auto& [name, summary] : report.stages) {
+        fill_latency(response->add_stages(), name, summary);
+    }
+    for (const auto& [name, summary] : report.strategies) {
+        fill_latency(response->add_strategies(), name, summary);
+    }
+    if (request != nullptr && request->reset()) {
+        tracer.reset();
     }
     return ::grpc::Status::OK;
 }
@@ -199,69 +458,33 @@ auto GrpcLiveEngineService::StopStrategy(::grpc::ServerContext* /*context*/,
     }
 }
 
-auto GrpcLiveEngineService::StreamLogs(::grpc::ServerContext* context,
-                                       const ::otrader::Empty* /*request*/,
-                                       ::grpc::ServerWriter<::otrader::LogLine>* writer)
-    -> ::grpc::Status {
-    if ((main_engine_ == nullptr) || (writer == nullptr)) {
-        return ::grpc::Status(::grpc::StatusCode::FAILED_PRECONDITION, "main engine is null");
-    }
-    while (!context->IsCancelled()) {
-        utilities::LogData log;
-        if (!main_engine_->pop_log_for_stream(log, 1000)) {
-            continue;
-        }
-        ::otrader::LogLine msg;
-        // JSON log line
-        std::string level_str = engines::level_to_string(log.level);
-        auto escape = [](const std::string& in) -> std::string {
-            std::string out;
-            out.reserve(in.size());
-            for (char c : in) {
-                if (c == '\\' || c == '"') {
-                    out.push_back('\\');
-                }
-                out.push_back(c);
-            }
-            return out;
-        };
-        std::string json = "{";
-        json += R"("src":"live")";
-        json += R"(,"time":")" + escape(log.time) + "\"";
-        json += ",\"level\":" + std::to_string(log.level);
-        json += R"(,"level_str":")" + escape(level_str) + "\"";
-        json += R"(,"gateway":")" + escape(log.gateway_name) + "\"";
-        json += R"(,"msg":")" + escape(log.msg) + "\"";
-        json += "}";
-        msg.set_line(json);
-        if (!writer->Write(msg)) {
-            break;
-        }
+auto GrpcLiveEngineService::StreamLogs(::grpc::CallbackServerContext* context,
+                                       const ::otrader::Empty* /*request*/)
+    -> ::grpc::ServerWriteReactor<::otrader::LogLine>* {
+    if (main_engine_ == nullptr) {
+        return new FinishedStream<::otrader::LogLine>(
+            ::grpc::Status(::grpc::StatusCode::FAILED_PRECONDITION, "main engine is null"));
     }
-    return ::grpc::Status::OK;
+    return new HubStreamReactor<std::string, ::otrader::LogLine>(
+        main_engine_->log_hub(), slow_consumer_policy(*context),
+        [](const std::string& line, ::otrader::LogLine& msg) -> void { msg.set_line(line); });
 }
 
-auto GrpcLiveEngineService::StreamStrategyUpdates(
-    ::grpc::ServerContext* context, const ::otrader::Empty* /*request*/,
-    ::grpc::ServerWriter<::otrader::StrategyUpdate>* writer) -> ::grpc::Status {
-    if ((main_engine_ == nullptr) || (writer == nullptr)) {
-        return ::grpc::Status(::grpc::StatusCode::FAILED_PRECONDITION, "main engine is null");
-    }
-    while (!context->IsCancelled()) {
-        utilities::StrategyUpdateData upd;
-        if (!main_engine_->pop_strategy_update(upd, 1000)) {
-            continue;
-        }
-        ::otrader::StrategyUpdate msg;
-        msg.set_strategy_name(upd.strategy_name);
-        msg.set_class_name(upd.class_name);
-        msg.set_portfolio(upd.portfolio);
-        msg.set_json_payload(upd.json_payload);
-        if (!writer->Write(msg)) {
-            break;
-        }
-    }
-    return ::grpc::Status::OK;
+auto GrpcLiveEngineService::StreamStrategyUpdates(::grpc::CallbackServerContext* context,
+                                                  const ::otrader::Empty* /*request*/)
+    -> ::grpc::ServerWriteReactor<::otrader::StrategyUpdate>* {
+    if (main_engine_ == nullptr) {
+        return new FinishedStream<::otrader::StrategyUpdate>(
+            ::grpc::Status(::grpc::StatusCode::FAILED_PRECONDITION, "main engine is null"));
+    }
+    return new HubStreamReactor<utilities::StrategyUpdateData, ::otrader::StrategyUpdate>(
+        main_engine_->strategy_update_hub(), slow_consumer_policy(*context),
+        [](const utilities::StrategyUpdateData& upd, ::otrader::StrategyUpdate& msg) -> void {
+            msg.set_strategy_name(upd.strategy_name);
+            msg.set_class_name(upd.class_name);
+            msg.set_portfolio(upd.portfolio);
+            msg.set_json_payload(upd.json_payload);
+        });
 }
 
 auto GrpcLiveEngineService::GetOrdersAndTrades(::grpc::ServerContext* /*context*/,
@@ -516,8 +739,8 @@ auto GrpcLiveEngineService::GetStrategyHoldings(::grpc::ServerContext* /*context
         for (const std::string& name :
              main_engine_->option_strategy_engine()->get_strategy_names()) {
             try {
-                std::string json = main_engine_->position_engine()->serialize_holding(name);
-                (*response->mutable_holdings())[name] = json;
+                main_engine_->position_engine()->serialize_holding(
+                    name, (*response->mutable_holdings())[name]);
             } catch (...) {
                 continue;
             }
@@ -528,4 +751,14 @@ auto GrpcLiveEngineService::GetStrategyHoldings(::grpc::ServerContext* /*context
     }
 }
 
+auto GrpcLiveEngineService::StreamHoldings(::grpc::CallbackServerContext* /*context*/,
+                                           const ::otrader::StreamHoldingsRequest* request)
+    -> ::grpc::ServerWriteReactor<::otrader::HoldingsDelta>* {
+    if ((main_engine_ == nullptr) || (request == nullptr)) {
+        return new FinishedStream<::otrader::HoldingsDelta>(
+            ::grpc::Status(::grpc::StatusCode::FAILED_PRECONDITION, "main engine is null"));
+    }
+    return new HoldingsStreamReactor(*main_engine_, request->since_seq(), request->full_resync());
+}
+
 } // namespace engines
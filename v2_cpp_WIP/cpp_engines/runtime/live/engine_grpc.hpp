@@ -8,10 +8,19 @@
 
 namespace engines {
 
+/** Unary RPCs on the sync server; the two event streams on the callback (async) API. */
+using GrpcLiveEngineServiceBase = ::otrader::EngineService::WithCallbackMethod_StreamLogs<
+    ::otrader::EngineService::WithCallbackMethod_StreamStrategyUpdates<
+        ::otrader::EngineService::WithCallbackMethod_StreamHoldings<
+            ::otrader::EngineService::Service>>>;
+
 /**
  * GrpcLiveEngineService: live only, holds MainEngine*; RPC calls MainEngine directly.
+ * StreamLogs / StreamStrategyUpdates hold no server thread: each stream is a reactor with its own
+ * cursor into the MainEngine broadcast hub. Client metadata "slow-consumer: disconnect" ends a
+ * stream that falls a full hub behind (default: skip ahead, drop the oldest lines).
  */
-class GrpcLiveEngineService final : public ::otrader::EngineService::Service {
+class GrpcLiveEngineService final : public GrpcLiveEngineServiceBase {
   public:
     explicit GrpcLiveEngineService(MainEngine* main_engine);
 
@@ -23,6 +32,10 @@ class GrpcLiveEngineService final : public ::otrader::EngineService::Service {
     ListStrategies(::grpc::ServerContext* context, const ::otrader::Empty* request,
                    ::grpc::ServerWriter<::otrader::StrategySummary>* writer) override;
 
+    ::grpc::Status GetLatency(::grpc::ServerContext* context,
+                              const ::otrader::LatencyRequest* request,
+                              ::otrader::LatencyReport* response) override;
+
     // Live control
     ::grpc::Status ConnectGateway(::grpc::ServerContext* context, const ::otrader::Empty* request,
                                   ::otrader::Empty* response) override;
@@ -46,13 +59,13 @@ class GrpcLiveEngineService final : public ::otrader::EngineService::Service {
                                 const ::otrader::StrategyNameRequest* request,
                                 ::otrader::Empty* response) override;
 
-    // Event streams (logs / strategy updates)
-    ::grpc::Status StreamLogs(::grpc::ServerContext* context, const ::otrader::Empty* request,
-                              ::grpc::ServerWriter<::otrader::LogLine>* writer) override;
+    // Event streams (logs / strategy updates), fanned out to every subscriber
+    ::grpc::ServerWriteReactor<::otrader::LogLine>*
+    StreamLogs(::grpc::CallbackServerContext* context, const ::otrader::Empty* request) override;
 
-    ::grpc::Status
-    StreamStrategyUpdates(::grpc::ServerContext* context, const ::otrader::Empty* request,
-                          ::grpc::ServerWriter<::otrader::StrategyUpdate>* writer) override;
+    ::grpc::ServerWriteReactor<::otrader::StrategyUpdate>*
+    StreamStrategyUpdates(::grpc::CallbackServerContext* context,
+                          const ::otrader::Empty* request) override;
 
     ::grpc::Status GetOrdersAndTrades(::grpc::ServerContext* context,
                                       const ::otrader::Empty* request,
@@ -102,6 +115,11 @@ class GrpcLiveEngineService final : public ::otrader::EngineService::Service {
                                        const ::otrader::Empty* request,
                                        ::otrader::StrategyHoldingsResponse* response) override;
 
+    /** Versioned diffs of MainEngine::live_state() after request.since_seq (0/resync = full). */
+    ::grpc::ServerWriteReactor<::otrader::HoldingsDelta>*
+    StreamHoldings(::grpc::CallbackServerContext* context,
+                   const ::otrader::StreamHoldingsRequest* request) override;
+
   private:
     MainEngine* main_engine_; // Non-owning; lifecycle by entry_live_grpc
 };
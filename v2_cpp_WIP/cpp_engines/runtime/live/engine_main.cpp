@@ -2,6 +2,7 @@
 
 #include "engine_main.hpp"
 #include "../../core/engine_option_strategy.hpp"
+#include "../../infra/db/event_journal.hpp"
 #include "../../strategy/strategy_registry.hpp"
 #include "../../utilities/intent.hpp"
 #include "../../utilities/object.hpp"
@@ -14,17 +15,64 @@
 
 namespace engines {
 
-MainEngine::MainEngine() {
-    event_engine_ = std::make_unique<EventEngine>(this, 1);
+namespace {
+
+auto json_escape(const std::string& in) -> std::string {
+    std::string out;
+    out.reserve(in.size());
+    for (char c : in) {
+        if (c == '\\' || c == '"') {
+            out.push_back('\\');
+        }
+        out.push_back(c);
+    }
+    return out;
+}
+
+/** StreamLogs line: {"src":"live","time":..,"level":..,"level_str":..,"gateway":..,"msg":..}. */
+auto log_json_line(const utilities::LogData& log) -> std::string {
+    std::string json = "{";
+    json += R"("src":"live")";
+    json += R"(,"time":")" + json_escape(log.time) + "\"";
+    json += ",\"level\":" + std::to_string(log.level);
+    json += R"(,"level_str":")" + json_escape(level_to_string(log.level)) + "\"";
+    json += R"(,"gateway":")" + json_escape(log.gateway_name) + "\"";
+    json += R"(,"msg":")" + json_escape(log.msg) + "\"";
+    json += "}";
+    return json;
+}
+
+} // namespace
+
+MainEngine::MainEngine(unsigned int event_shards) {
+    // Created up front, not on first use: strategies run on pool threads (parallel timers)
+    // and the event thread reaches these from its first tick.
+    hedge_engine_ = std::make_unique<HedgeEngine>(this);
+    hedge_engine_->set_log_filter(
+        [this](int level) -> bool { return log_engine_ && log_engine_->accepts(level); });
+    combo_builder_engine_ = std::make_unique<ComboBuilderEngine>(this);
+    event_engine_ = std::make_unique<EventEngine>(this, 1, event_shards);
     event_engine_->start();
 
     log_engine_ = std::make_unique<LogEngine>(this);
+    log_engine_->add_sink([this](const utilities::LogData& log) -> void {
+        if (log_hub_.subscriber_count() > 0) {
+            log_hub_.publish(log_json_line(log));
+        }
+    });
     position_engine_ = std::make_unique<PositionEngine>(this);
+    scenario_engine_ = std::make_unique<ScenarioEngine>(this);
     execution_engine_ = std::make_unique<core::ExecutionEngine>(this);
+    execution_engine_->set_risk_check(
+        [this](const std::string& strategy_name, const utilities::OrderRequest& req) -> bool {
+            return scenario_engine_->check_order(strategy_name, req);
+        });
     execution_engine_->set_send_impl(
         [this](const utilities::OrderRequest& req) -> std::string { return append_order(req); });
     execution_engine_->set_cancel_impl(
         [this](const utilities::CancelRequest& req) { ib_gateway_->cancel_order(req); });
+    execution_engine_->set_archive_retention(
+        kExecutionRetention, [this]() -> uint64_t { return db_engine_->persisted_rows(); });
     db_engine_ = std::make_unique<DatabaseEngine>(this);
     market_data_engine_ = std::make_unique<MarketDataEngine>(this);
     ib_gateway_ = std::make_unique<IbGateway>(this);
@@ -61,19 +109,18 @@ MainEngine::MainEngine() {
         return execution_engine_ ? execution_engine_->get_all_active_orders()
                                  : std::vector<utilities::OrderData>{};
     };
-    api.execution.get_strategy_active_orders =
-        [this]() -> const std::unordered_map<std::string, std::set<std::string>>& {
-        static const std::unordered_map<std::string, std::set<std::string>> empty;
-        return execution_engine_ ? execution_engine_->get_strategy_active_orders() : empty;
+    api.execution.for_each_active_order =
+        [this](const std::string& name,
+               const std::function<void(const utilities::OrderData&)>& fn) -> void {
+        if (execution_engine_) {
+            execution_engine_->for_each_active_order(name, fn);
+        }
     };
     api.execution.remove_order_tracking = [this](const std::string& oid) -> void {
         if (execution_engine_) {
             execution_engine_->remove_order_tracking(oid);
         }
     };
-    api.execution.get_active_order_ids = [this]() -> std::unordered_set<std::string>& {
-        return execution_engine_ ? execution_engine_->active_order_ids() : dummy_active_ids_;
-    };
     api.execution.ensure_strategy_key = [this](const std::string& name) -> void {
         if (execution_engine_) {
             execution_engine_->ensure_strategy_key(name);
@@ -120,9 +167,9 @@ MainEngine::MainEngine() {
 
     // Create portfolio, load option→equity, finalize chains
     market_data_engine_->ensure_portfolios_created();
-    db_engine_->load_contracts(
-        [this](const utilities::ContractData& c) -> void {
-            market_data_engine_->process_option(c);
+    db_engine_->load_contracts_bulk(
+        [this](std::vector<utilities::ContractData>&& options) -> void {
+            market_data_engine_->process_options(std::move(options));
         },
         [this](const utilities::ContractData& c) -> void {
             market_data_engine_->process_underlying(c);
@@ -191,17 +238,21 @@ auto MainEngine::get_all_contracts() const -> std::vector<utilities::ContractDat
     return market_data_engine_->get_all_contracts();
 }
 
-void MainEngine::save_trade_data(const std::string& strategy_name,
-                                 const utilities::TradeData& trade) {
-    db_engine_->save_trade_data(strategy_name, trade);
+auto MainEngine::save_trade_data(const std::string& strategy_name,
+                                 const utilities::TradeData& trade) -> uint64_t {
+    return db_engine_->save_trade_data(strategy_name, trade);
 }
 
-void MainEngine::save_order_data(const std::string& strategy_name,
-                                 const utilities::OrderData& order) {
-    db_engine_->save_order_data(strategy_name, order);
+auto MainEngine::save_order_data(const std::string& strategy_name,
+                                 const utilities::OrderData& order) -> uint64_t {
+    return db_engine_->save_order_data(strategy_name, order);
 }
 
-void MainEngine::connect() { ib_gateway_->connect(); }
+void MainEngine::connect() {
+    // The first position timer replays the holding journal; fills must not precede it.
+    holdings_restored_.wait(false);
+    ib_gateway_->connect();
+}
 
 void MainEngine::disconnect() { ib_gateway_->disconnect(); }
 
@@ -228,25 +279,133 @@ auto MainEngine::get_trade(const std::string& tradeid) -> utilities::TradeData*
 }
 
 void MainEngine::on_strategy_event(const utilities::StrategyUpdateData& update) {
-    {
-        std::scoped_lock lock(strategy_updates_mutex_);
-        strategy_updates_.push_back(update);
-        if (strategy_updates_.size() > 1000) {
-            strategy_updates_.pop_front();
+    if (strategy_update_hub_.subscriber_count() > 0) {
+        strategy_update_hub_.publish(update);
+    }
+}
+
+void MainEngine::publish_holdings() {
+    if (live_state_.changes().subscriber_count() == 0 || !option_strategy_engine_ ||
+        !position_engine_) {
+        return;
+    }
+    std::unordered_set<std::string> current;
+    for (const std::string& name : option_strategy_engine_->get_strategy_names()) {
+        live_state_.put(std::string(kHoldingKeyPrefix) + name,
+                        LiveStateValue(std::in_place_index<0>,
+                                       position_engine_->serialize_holding(name)));
+        current.insert(name);
+    }
+    for (const std::string& name : published_strategies_) {
+        if (!current.contains(name)) {
+            live_state_.erase(std::string(kHoldingKeyPrefix) + name);
         }
     }
-    strategy_updates_cv_.notify_one();
+    published_strategies_ = std::move(current);
+    live_state_.commit();
+}
+
+void MainEngine::set_event_journal(const std::string& path) {
+    if (path.empty()) {
+        event_engine_->set_journal(nullptr);
+        return;
+    }
+    auto journal = std::make_unique<EventJournalWriter>(path, event_engine_->timer_tick());
+    if (!journal->is_open()) {
+        MainEngine::write_log("Event journal not created (exists or not writable): " + path,
+                              ERROR);
+        return;
+    }
+    MainEngine::write_log("Event journal: " + path);
+    event_engine_->set_journal(std::move(journal));
 }
 
-auto MainEngine::pop_strategy_update(utilities::StrategyUpdateData& out, int timeout_ms) -> bool {
-    std::unique_lock<std::mutex> lock(strategy_updates_mutex_);
-    if (!strategy_updates_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
-                                       [this]() -> bool { return !strategy_updates_.empty(); })) {
-        return false;
+void MainEngine::set_holding_journal(std::string path) {
+    holding_journal_path_ = std::move(path);
+    holding_journal_.reset();
+    const bool enabled = !holding_journal_path_.empty() && position_engine_;
+    if (position_engine_) {
+        position_engine_->set_change_tracking(enabled);
     }
-    out = std::move(strategy_updates_.front());
-    strategy_updates_.pop_front();
-    return true;
+    holdings_restored_.store(!enabled);
+}
+
+void MainEngine::checkpoint_holdings() {
+    if (holding_journal_path_.empty() || !position_engine_) {
+        return;
+    }
+    journal_buffer_.clear();
+    if (!holding_journal_) {
+        auto journal = std::make_unique<HoldingJournal>(holding_journal_path_);
+        const size_t replayed = position_engine_->replay_journal(journal->read());
+        position_engine_->append_journal_snapshot(journal_buffer_);
+        if (!journal->compact(journal_buffer_)) {
+            MainEngine::write_log("Holding journal not writable: " + holding_journal_path_, ERROR);
+            holding_journal_path_.clear();
+            position_engine_->set_change_tracking(false);
+        } else {
+            holding_journal_ = std::move(journal);
+            MainEngine::write_log(std::format("Holding journal {}: replayed {} records",
+                                              holding_journal_path_, replayed),
+                                  INFO);
+        }
+        holdings_restored_.store(true);
+        holdings_restored_.notify_all();
+        return;
+    }
+    if (position_engine_->drain_journal(journal_buffer_) > 0 &&
+        !holding_journal_->append(journal_buffer_)) {
+        MainEngine::write_log("Holding journal append failed: " + holding_journal_path_, ERROR);
+    }
+    if (holding_journal_->needs_compaction()) {
+        journal_buffer_.clear();
+        position_engine_->append_journal_snapshot(journal_buffer_);
+        if (!holding_journal_->compact(journal_buffer_)) {
+            MainEngine::write_log("Holding journal compaction failed: " + holding_journal_path_,
+                                  ERROR);
+        }
+    }
+}
+
+void MainEngine::publish_chain_greeks(const utilities::PortfolioData& portfolio,
+                                      std::span<const std::string> chains) {
+    if (live_state_.changes().subscriber_count() == 0) {
+        return;
+    }
+    const auto publish = [&](const utilities::ChainData& chain) -> void {
+        utilities::ChainGreeksData g{.portfolio = portfolio.name,
+                                     .chain = chain.chain_symbol,
+                                     .atm_price = chain.atm_price,
+                                     .atm_iv = chain.get_atm_iv().value_or(0.0),
+                                     .skew = chain.get_skew().value_or(0.0),
+                                     .days_to_expiry = chain.days_to_expiry};
+        if (chain.atm_index >= 0) {
+            for (const utilities::OptionData* o :
+                 {chain.strike_calls[chain.atm_index], chain.strike_puts[chain.atm_index]}) {
+                if (o != nullptr) {
+                    g.delta += o->delta();
+                    g.gamma += o->gamma();
+                    g.theta += o->theta();
+                    g.vega += o->vega();
+                }
+            }
+        }
+        live_state_.put(std::string(kChainKeyPrefix) + portfolio.name + "/" + chain.chain_symbol,
+                        LiveStateValue(std::move(g)));
+    };
+    if (chains.empty()) {
+        for (const auto& [_, chain] : portfolio.chains) {
+            publish(*chain);
+        }
+    } else {
+        for (const std::string& key : chains) {
+            auto it = portfolio.chains.find(key);
+            if (it != portfolio.chains.end()) {
+                publish(*it->second);
+            }
+        }
+    }
+    live_state_.commit();
 }
 
 void MainEngine::put_event(const utilities::Event& e) { event_engine_->put_event(e); }
@@ -270,6 +429,9 @@ void MainEngine::close() {
     if (execution_engine_) {
         execution_engine_->close();
     }
+    if (scenario_engine_) {
+        scenario_engine_->close();
+    }
     if (db_engine_) {
         db_engine_->close();
     }
@@ -279,20 +441,9 @@ void MainEngine::close() {
     if (event_engine_) {
         event_engine_->close();
     }
-}
-
-auto MainEngine::hedge_engine() -> HedgeEngine* {
-    if (!hedge_engine_) {
-        hedge_engine_ = std::make_unique<HedgeEngine>(this);
-    }
-    return hedge_engine_.get();
-}
-
-auto MainEngine::combo_builder_engine() -> ComboBuilderEngine* {
-    if (!combo_builder_engine_) {
-        combo_builder_engine_ = std::make_unique<ComboBuilderEngine>(this);
+    if (holding_journal_) {
+        checkpoint_holdings(); // event thread stopped: last trades
     }
-    return combo_builder_engine_.get();
 }
 
 auto MainEngine::get_holding(const std::string& strategy_name) -> utilities::StrategyHolding* {
@@ -326,8 +477,4 @@ void MainEngine::set_log_level(int level) {
 
 auto MainEngine::log_level() const -> int { return log_engine_ ? log_engine_->level() : DISABLED; }
 
-auto MainEngine::pop_log_for_stream(utilities::LogData& out, int timeout_ms) -> bool {
-    return log_engine_ ? log_engine_->pop_log_for_stream(out, timeout_ms) : false;
-}
-
 } // namespace engines
@@ -8,26 +8,43 @@
 #include "../../core/engine_log.hpp"
 #include "../../core/engine_option_strategy.hpp"
 #include "../../core/engine_position.hpp"
+#include "../../core/engine_scenario.hpp"
 #include "../../utilities/base_engine.hpp"
+#include "../../utilities/broadcast_hub.hpp"
 #include "../../utilities/event.hpp"
 #include "../../utilities/object.hpp"
 #include "../../utilities/portfolio.hpp"
+#include "../../utilities/versioned_store.hpp"
 #include "engine_data_tradier.hpp"
 #include "engine_db_pg.hpp"
 #include "engine_event.hpp"
 #include "engine_gateway_ib.hpp"
-#include <condition_variable>
-#include <deque>
+#include "holding_journal.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <memory>
-#include <mutex>
 #include <span>
+#include <string>
+#include <string_view>
+#include <variant>
 #include <unordered_set>
 
 namespace engines {
 
+/** Holdings stream entry: serialized StrategyHoldingMsg or one chain's Greeks. */
+using LiveStateValue = std::variant<std::string, utilities::ChainGreeksData>;
+
 class MainEngine : public utilities::MainEngine {
   public:
-    MainEngine();
+    /** live_state() keys: kHoldingKeyPrefix + strategy, kChainKeyPrefix + portfolio/chain. */
+    static constexpr std::string_view kHoldingKeyPrefix = "holding:";
+    static constexpr std::string_view kChainKeyPrefix = "chain:";
+    /** Terminal orders and trades stay in memory this long, then go once written to the DB. */
+    static constexpr std::chrono::seconds kExecutionRetention = std::chrono::hours(1);
+
+    /** event_shards > 1: parallel snapshot dispatch by portfolio (see EventEngine). */
+    explicit MainEngine(unsigned int event_shards = 1);
     ~MainEngine() override;
 
     EventEngine* event_engine() { return event_engine_.get(); }
@@ -38,8 +55,9 @@ class MainEngine : public utilities::MainEngine {
     core::ExecutionEngine* execution_engine() { return execution_engine_.get(); }
     core::OptionStrategyEngine* option_strategy_engine() { return option_strategy_engine_.get(); }
     PositionEngine* position_engine() { return position_engine_.get(); }
-    HedgeEngine* hedge_engine();
-    ComboBuilderEngine* combo_builder_engine();
+    ScenarioEngine* scenario_engine() { return scenario_engine_.get(); }
+    HedgeEngine* hedge_engine() { return hedge_engine_.get(); }
+    ComboBuilderEngine* combo_builder_engine() { return combo_builder_engine_.get(); }
     utilities::StrategyHolding* get_holding(const std::string& strategy_name);
     const utilities::StrategyHolding* get_holding(const std::string& strategy_name) const;
     void get_or_create_holding(const std::string& strategy_name);
@@ -54,8 +72,9 @@ class MainEngine : public utilities::MainEngine {
     const utilities::ContractData* get_contract(const std::string& symbol) const;
     std::vector<utilities::ContractData> get_all_contracts() const;
 
-    void save_trade_data(const std::string& strategy_name, const utilities::TradeData& trade);
-    void save_order_data(const std::string& strategy_name, const utilities::OrderData& order);
+    /** Queue the row for the DB writer; returns its persist ticket (see DatabaseEngine). */
+    uint64_t save_trade_data(const std::string& strategy_name, const utilities::TradeData& trade);
+    uint64_t save_order_data(const std::string& strategy_name, const utilities::OrderData& order);
 
     void connect();
     void disconnect();
@@ -85,17 +104,54 @@ class MainEngine : public utilities::MainEngine {
     void set_log_level(int level);
     int log_level() const;
 
-    /** Strategy updates queue (gRPC). */
+    /** Strategy updates → every StreamStrategyUpdates subscriber. */
     void on_strategy_event(const utilities::StrategyUpdateData& update);
-    bool pop_strategy_update(utilities::StrategyUpdateData& out, int timeout_ms);
-
-    /** Log queue (gRPC). */
-    bool pop_log_for_stream(utilities::LogData& out, int timeout_ms);
+    utilities::BroadcastHub<utilities::StrategyUpdateData>& strategy_update_hub() {
+        return strategy_update_hub_;
+    }
+    /** Log lines (StreamLogs JSON) → every StreamLogs subscriber. */
+    utilities::BroadcastHub<std::string>& log_hub() { return log_hub_; }
+
+    /** Versioned holdings + chain Greeks for StreamHoldings (updated while subscribed). */
+    utilities::VersionedStore<LiveStateValue>& live_state() { return live_state_; }
+    /** Event thread, after the position timer: re-serialize holdings, version the changed ones. */
+    void publish_holdings();
+    /**
+     * Journal holdings to path: change tracking starts now; the first checkpoint (event thread)
+     * replays the file into the PositionEngine and rewrites it as a snapshot; later ones append
+     * the positions trades changed. connect() waits for that replay, so no live fill lands on
+     * a holding it then replaces. Call before connect(); empty path turns it off.
+     */
+    void set_holding_journal(std::string path);
+    /**
+     * Record the session to a new event journal at path (see EventJournalWriter) for replay
+     * through the backtest engines; an existing file is never overwritten. Call before
+     * connect() so the journal starts with the first snapshot; empty path turns it off.
+     */
+    void set_event_journal(const std::string& path);
+    /** Event thread, after the position timer: append changed positions, compact when due. */
+    void checkpoint_holdings();
+    /** Event thread, after apply_frame: version the changed chains (empty = every chain). */
+    void publish_chain_greeks(const utilities::PortfolioData& portfolio,
+                              std::span<const std::string> chains);
 
   private:
     /** Self-check: strategy count, portfolio name/chains/options. */
     void log_self_check();
 
+    // Declared before the engines: the log thread publishes into log_hub_ until log_engine_ dies.
+    utilities::BroadcastHub<std::string> log_hub_{4096};
+    utilities::BroadcastHub<utilities::StrategyUpdateData> strategy_update_hub_{1024};
+    utilities::VersionedStore<LiveStateValue> live_state_;
+    /** Strategies present in live_state_ (to tombstone removed ones). */
+    std::unordered_set<std::string> published_strategies_;
+    std::string holding_journal_path_;
+    /** Opened (and replayed) by the first checkpoint_holdings. */
+    std::unique_ptr<HoldingJournal> holding_journal_;
+    /** False from set_holding_journal until that first replay; connect() waits on it. */
+    std::atomic<bool> holdings_restored_{true};
+    std::string journal_buffer_;
+
     std::unique_ptr<EventEngine> event_engine_;
     std::unique_ptr<LogEngine> log_engine_;
     std::unique_ptr<DatabaseEngine> db_engine_;
@@ -104,14 +160,10 @@ class MainEngine : public utilities::MainEngine {
     std::unique_ptr<core::ExecutionEngine> execution_engine_;
     std::unique_ptr<core::OptionStrategyEngine> option_strategy_engine_;
     std::unique_ptr<PositionEngine> position_engine_;
+    std::unique_ptr<ScenarioEngine> scenario_engine_;
     std::unique_ptr<HedgeEngine> hedge_engine_;
     std::unique_ptr<ComboBuilderEngine> combo_builder_engine_;
 
-    std::deque<utilities::StrategyUpdateData> strategy_updates_;
-    std::mutex strategy_updates_mutex_;
-    std::condition_variable strategy_updates_cv_;
-
-    std::unordered_set<std::string> dummy_active_ids_;
     bool market_data_running_ = false;
 };
 
@@ -2,6 +2,9 @@
 #include "../core/engine_combo_builder.hpp"
 #include "../core/engine_hedge.hpp"
 #include "../core/engine_option_strategy.hpp"
+#include "../utilities/latency.hpp"
+
+#include <algorithm>
 
 namespace strategy_cpp {
 
@@ -22,6 +25,10 @@ OptionStrategyTemplate::OptionStrategyTemplate(
     if (it != setting.end()) {
         timer_trigger_ = static_cast<int>(it->second);
     }
+    it = setting.find("timer_interval_ms");
+    if (it != setting.end()) {
+        timer_interval_ms_ = static_cast<int>(it->second);
+    }
     write_log("Strategy " + strategy_name_ + " created for portfolio " + portfolio_name_);
 }
 
@@ -41,11 +48,27 @@ void OptionStrategyTemplate::on_timer() {
     if (!started_ || error_) {
         return;
     }
-    timer_cnt_++;
-    if (timer_cnt_ >= timer_trigger_) {
-        timer_cnt_ = 0;
+    if (!utilities::LatencyTracer::enabled()) {
         on_timer_logic();
+        return;
+    }
+    utilities::LatencyTracer& tracer = utilities::LatencyTracer::instance();
+    if (timer_latency_ == nullptr) {
+        timer_latency_ = &tracer.strategy(strategy_name_);
     }
+    const uint64_t start = utilities::trace_now();
+    on_timer_logic();
+    const uint64_t end = utilities::trace_now();
+    tracer.record(utilities::LatencyStage::StrategyTimer, start, end);
+    timer_latency_->record(end > start ? utilities::trace_ticks_to_ns(end - start) : 0);
+}
+
+auto OptionStrategyTemplate::timer_period(std::chrono::milliseconds tick) const
+    -> std::chrono::milliseconds {
+    if (timer_interval_ms_ > 0) {
+        return std::chrono::milliseconds(timer_interval_ms_);
+    }
+    return tick * std::max(timer_trigger_, 1);
 }
 
 void OptionStrategyTemplate::on_order(const utilities::OrderData& order) {
@@ -68,6 +91,11 @@ void OptionStrategyTemplate::subscribe_chains(std::span<const std::string> chain
             chain_map_[sym] = it->second.get();
         }
     }
+    subscribed_chains_.assign(chain_symbols.begin(), chain_symbols.end());
+    // Inside a parallel timer round the other strategies are still running: update at replay.
+    engine_->run_or_defer([engine = engine_, portfolio = portfolio_name_]() -> void {
+        engine->refresh_active_chains(portfolio);
+    });
 }
 
 auto OptionStrategyTemplate::get_chain(const std::string& chain_symbol) const
@@ -108,6 +136,29 @@ auto OptionStrategyTemplate::option_order(
                                      legs, order_type);
 }
 
+auto OptionStrategyTemplate::option_order(utilities::ComboType combo_type,
+                                          std::span<const utilities::OptionData* const> options,
+                                          utilities::Direction direction, double price,
+                                          double volume, utilities::OrderType order_type)
+    -> std::vector<std::string> {
+    auto* cb = engine_->combo_builder_engine();
+    if (cb == nullptr) {
+        return {};
+    }
+    auto get_contract = [this](const std::string& s) -> const utilities::ContractData* {
+        return engine_->get_contract(s);
+    };
+    if (!cb->build(combo_type, options, direction, static_cast<int>(volume), get_contract,
+                   combo_order_)) {
+        write_log("Combo order rejected: " +
+                  std::string(engines::combo_error_name(combo_order_.error)));
+        return {};
+    }
+    return engine_->send_combo_order(strategy_name_, combo_type, *combo_order_.signature,
+                                     direction, price, volume, combo_order_.leg_span(),
+                                     order_type);
+}
+
 void OptionStrategyTemplate::register_hedging(int timer_trigger, int delta_target,
                                               int delta_range) {
     if (engine_ == nullptr) {
@@ -117,7 +168,10 @@ void OptionStrategyTemplate::register_hedging(int timer_trigger, int delta_targe
     if (hedge == nullptr) {
         return;
     }
-    hedge->register_strategy(strategy_name(), timer_trigger, delta_target, delta_range);
+    engine_->run_or_defer([hedge, name = strategy_name_, timer_trigger, delta_target,
+                           delta_range]() {
+        hedge->register_strategy(name, timer_trigger, delta_target, delta_range);
+    });
 }
 
 void OptionStrategyTemplate::unregister_hedging() {
@@ -128,7 +182,7 @@ void OptionStrategyTemplate::unregister_hedging() {
     if (hedge == nullptr) {
         return;
     }
-    hedge->unregister_strategy(strategy_name_);
+    engine_->run_or_defer([hedge, name = strategy_name_]() { hedge->unregister_strategy(name); });
 }
 
 void OptionStrategyTemplate::close_all_strategy_positions() {
@@ -1,7 +1,9 @@
 #pragma once
 
+#include "../core/engine_combo_builder.hpp"
 #include "../utilities/constant.hpp"
 #include "../utilities/portfolio.hpp"
+#include <chrono>
 #include <span>
 
 #include <string>
@@ -12,6 +14,10 @@ namespace core {
 class OptionStrategyEngine;
 }
 
+namespace utilities {
+class LatencyHistogram;
+}
+
 namespace strategy_cpp {
 
 class OptionStrategyTemplate {
@@ -30,10 +36,27 @@ class OptionStrategyTemplate {
     void on_init();
     void on_start();
     void on_stop();
+    /**
+     * Run on_timer_logic when started and not in error (the runtime schedules the calls); timed
+     * per strategy while latency tracing is on.
+     */
     void on_timer();
+    /**
+     * Timer period for a runtime whose base tick is tick: setting "timer_interval_ms" when > 0,
+     * else timer_trigger ticks.
+     */
+    [[nodiscard]] std::chrono::milliseconds timer_period(std::chrono::milliseconds tick) const;
 
+    /**
+     * Chains this strategy reads (replaces the previous set). Once every strategy on the
+     * portfolio has subscribed, only these chains and held ones get IV/Greeks.
+     */
     void subscribe_chains(std::span<const std::string> chain_symbols);
     utilities::ChainData* get_chain(const std::string& chain_symbol) const;
+    /** Chains last passed to subscribe_chains (empty: never subscribed). */
+    [[nodiscard]] const std::vector<std::string>& subscribed_chains() const {
+        return subscribed_chains_;
+    }
 
     std::vector<std::string>
     underlying_order(utilities::Direction direction, double price, double volume = 1.0,
@@ -43,6 +66,15 @@ class OptionStrategyTemplate {
                  const std::unordered_map<std::string, utilities::OptionData*>& option_data,
                  utilities::Direction direction, double price, double volume = 1.0,
                  utilities::OrderType order_type = utilities::OrderType::MARKET);
+    /**
+     * Hot-path combo order: options in combo_template(combo_type) leg order. Legs are built into
+     * a reused buffer and contracts/signature come from the builder's cache.
+     */
+    std::vector<std::string>
+    option_order(utilities::ComboType combo_type,
+                 std::span<const utilities::OptionData* const> options,
+                 utilities::Direction direction, double price, double volume = 1.0,
+                 utilities::OrderType order_type = utilities::OrderType::MARKET);
     void register_hedging(int timer_trigger = 5, int delta_target = 0, int delta_range = 0);
     void unregister_hedging();
 
@@ -69,12 +101,16 @@ class OptionStrategyTemplate {
     utilities::UnderlyingData* underlying_ = nullptr;
     utilities::StrategyHolding* holding_ = nullptr;
     std::unordered_map<std::string, utilities::ChainData*> chain_map_;
+    std::vector<std::string> subscribed_chains_;
     bool inited_ = false;
     bool started_ = false;
     bool error_ = false;
     std::string error_msg_;
     int timer_trigger_ = 1;
-    int timer_cnt_ = 0;
+    int timer_interval_ms_ = 0;
+    engines::ComboOrder combo_order_;
+    /** This strategy's on_timer_logic histogram (first traced timer). */
+    utilities::LatencyHistogram* timer_latency_ = nullptr;
 };
 
 } // namespace strategy_cpp
@@ -1,8 +1,11 @@
 #include "black_scholes.hpp"
+#include "black_scholes_simd.hpp"
 #include "lets_be_rational_api.hpp"
 #include <algorithm>
+#include <bit>
 #include <cctype>
 #include <cmath>
+#include <vector>
 
 namespace utilities {
 
@@ -11,6 +14,9 @@ namespace {
 constexpr double kMinVol = 1e-6;
 constexpr double kMaxVol = 5.0;
 constexpr double kMinT = 1e-6;
+constexpr int kNewtonMaxSteps = 4;
+constexpr double kNewtonTol = 1e-10;
+constexpr double kMinNewtonVega = 1e-8;
 
 auto normal_pdf(double x) -> double {
     static constexpr double inv_sqrt_2pi = 0.3989422804014327;
@@ -31,19 +37,73 @@ auto bs_vega_raw(double s, double k, double t, double r, double sigma) -> double
     return s * normal_pdf(d1) * sqrt_t;
 }
 
+enum class BatchIsa { Scalar, Avx2, Avx512 };
+
+auto detect_batch_isa() -> BatchIsa {
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    if (bs_simd::avx512_built() && __builtin_cpu_supports("avx512f")) {
+        return BatchIsa::Avx512;
+    }
+    if (bs_simd::avx2_built() && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return BatchIsa::Avx2;
+    }
+#endif
+    return BatchIsa::Scalar;
+}
+
+auto batch_isa() -> BatchIsa {
+    static const BatchIsa isa = detect_batch_isa();
+    return isa;
+}
+
+auto same_bits(double a, double b) -> bool {
+    return std::bit_cast<uint64_t>(a) == std::bit_cast<uint64_t>(b);
+}
+
+/** Compacted warm-start lanes; thread_local so apply_frame chunks reuse capacity. */
+struct NewtonScratch {
+    std::vector<size_t> lane;
+    std::vector<double> spot, strike, tau, sigma, target, model, vega, step;
+    std::vector<uint8_t> is_call;
+
+    void clear() {
+        for (auto* v : {&spot, &strike, &tau, &sigma, &target, &model, &vega, &step}) {
+            v->clear();
+        }
+        lane.clear();
+        is_call.clear();
+    }
+};
+
 } // namespace
 
-auto pick_iv_input_price(double bid, double ask, const std::string& mode) -> double {
-    std::string m = mode;
+auto parse_iv_price_mode(std::string_view mode) -> std::optional<IvPriceMode> {
+    std::string m(mode);
     std::ranges::transform(
         m, m.begin(), [](unsigned char c) -> char { return static_cast<char>(std::tolower(c)); });
+    if (m == "mid") {
+        return IvPriceMode::MID;
+    }
     if (m == "bid") {
-        return bid > 0.0 ? bid : 0.0;
+        return IvPriceMode::BID;
     }
     if (m == "ask") {
-        return ask > 0.0 ? ask : 0.0;
+        return IvPriceMode::ASK;
+    }
+    return std::nullopt;
+}
+
+auto pick_iv_input_price(double bid, double ask, const std::string& mode) -> double {
+    switch (parse_iv_price_mode(mode).value_or(IvPriceMode::MID)) {
+        using enum IvPriceMode;
+    case BID:
+        return pick_iv_input_price<BID>(bid, ask);
+    case ASK:
+        return pick_iv_input_price<ASK>(bid, ask);
+    case MID:
+        break;
     }
-    return (bid > 0.0 && ask > 0.0) ? (bid + ask) / 2.0 : (bid > 0.0 ? bid : ask);
+    return pick_iv_input_price<IvPriceMode::MID>(bid, ask);
 }
 
 auto years_to_expiry(std::chrono::system_clock::time_point now,
@@ -84,6 +144,51 @@ auto bs_greeks(bool is_call, double spot, double strike, double time_to_expiry_y
     return g;
 }
 
+void bs_greeks_batch(const BsBatchInput& in, const BsBatchOutput& out) {
+    size_t i = 0;
+    switch (batch_isa()) {
+        using enum BatchIsa;
+    case Avx512:
+        i = bs_simd::greeks_avx512(in, out);
+        break;
+    case Avx2:
+        i = bs_simd::greeks_avx2(in, out);
+        break;
+    case Scalar:
+        break;
+    }
+    bs_simd::greeks_lanes<bs_simd::ScalarLanes>(in, out, i, in.spot.size());
+}
+
+void bs_price_vega_batch(const BsBatchInput& in, std::span<double> price, std::span<double> vega) {
+    size_t i = 0;
+    switch (batch_isa()) {
+        using enum BatchIsa;
+    case Avx512:
+        i = bs_simd::price_vega_avx512(in, price, vega);
+        break;
+    case Avx2:
+        i = bs_simd::price_vega_avx2(in, price, vega);
+        break;
+    case Scalar:
+        break;
+    }
+    bs_simd::price_vega_lanes<bs_simd::ScalarLanes>(in, price, vega, i, in.spot.size());
+}
+
+auto bs_greeks_batch_isa() -> const char* {
+    switch (batch_isa()) {
+        using enum BatchIsa;
+    case Avx512:
+        return "avx512";
+    case Avx2:
+        return "avx2";
+    case Scalar:
+        break;
+    }
+    return "scalar";
+}
+
 auto implied_volatility_from_price(double option_price, double spot, double strike,
                                    double time_to_expiry_years, bool is_call) -> double {
     if (option_price <= 0.0 || spot <= 0.0 || strike <= 0.0 || time_to_expiry_years <= 0.0) {
@@ -98,4 +203,84 @@ auto implied_volatility_from_price(double option_price, double spot, double stri
     return std::min(iv, kMaxVol);
 }
 
+auto implied_volatility_batch(const IvBatchInput& in, std::span<double> iv_out) -> IvBatchStats {
+    IvBatchStats stats;
+    const size_t n = in.price.size();
+    const bool warm = in.prev_price.size() == n && in.prev_spot.size() == n &&
+                      in.prev_iv.size() == n;
+    thread_local NewtonScratch ws;
+    ws.clear();
+
+    for (size_t i = 0; i < n; ++i) {
+        const double px = in.price[i];
+        const double s = in.spot[i];
+        const double k = in.strike[i];
+        const double t = in.tau[i];
+        if (px <= 0.0 || s <= 0.0 || k <= 0.0 || t <= 0.0) {
+            iv_out[i] = 0.0;
+            continue;
+        }
+        const double prev = warm ? in.prev_iv[i] : 0.0;
+        if (prev > 0.0 && same_bits(px, in.prev_price[i]) && same_bits(s, in.prev_spot[i])) {
+            iv_out[i] = prev;
+            ++stats.reused;
+            continue;
+        }
+        if (prev <= 0.0) {
+            iv_out[i] = implied_volatility_from_price(px, s, k, t, in.is_call[i] != 0);
+            ++stats.cold;
+            continue;
+        }
+        ws.lane.push_back(i);
+        ws.spot.push_back(s);
+        ws.strike.push_back(k);
+        ws.tau.push_back(t);
+        ws.sigma.push_back(prev);
+        ws.target.push_back(px);
+        ws.is_call.push_back(in.is_call[i]);
+    }
+
+    const size_t m = ws.lane.size();
+    if (m == 0) {
+        return stats;
+    }
+    ws.model.resize(m);
+    ws.vega.resize(m);
+    ws.step.assign(m, 1.0);
+    // r = 0 to match the LetsBeRational call (spot passed as forward).
+    const BsBatchInput bs{.spot = ws.spot,
+                          .strike = ws.strike,
+                          .tau = ws.tau,
+                          .sigma = ws.sigma,
+                          .is_call = ws.is_call,
+                          .risk_free_rate = 0.0};
+    for (int step = 0; step < kNewtonMaxSteps; ++step) {
+        bs_price_vega_batch(bs, ws.model, ws.vega);
+        bool all_converged = true;
+        for (size_t j = 0; j < m; ++j) {
+            const double vega = std::max(ws.vega[j], kMinNewtonVega);
+            const double d = (ws.model[j] - ws.target[j]) / vega;
+            ws.step[j] = ws.vega[j] < kMinNewtonVega ? 1.0 : std::abs(d);
+            ws.sigma[j] = std::clamp(ws.sigma[j] - d, kMinVol, kMaxVol);
+            all_converged = all_converged && ws.step[j] < kNewtonTol;
+        }
+        if (all_converged) {
+            break;
+        }
+    }
+
+    for (size_t j = 0; j < m; ++j) {
+        const size_t i = ws.lane[j];
+        if (ws.step[j] < kNewtonTol && std::isfinite(ws.sigma[j])) {
+            iv_out[i] = ws.sigma[j];
+            ++stats.warm;
+        } else {
+            iv_out[i] = implied_volatility_from_price(ws.target[j], ws.spot[j], ws.strike[j],
+                                                      ws.tau[j], ws.is_call[j] != 0);
+            ++stats.cold;
+        }
+    }
+    return stats;
+}
+
 } // namespace utilities
@@ -3,8 +3,11 @@
 /** Black–Scholes IV and Greeks (LetsBeRational). */
 
 #include <chrono>
+#include <cstdint>
 #include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 
 namespace utilities {
 
@@ -16,6 +19,27 @@ struct BsGreeks {
     double vega = 0.0;
 };
 
+/** IV input price source; validated once, then a compile-time kernel parameter. */
+enum class IvPriceMode : uint8_t {
+    MID,
+    BID,
+    ASK,
+};
+
+/** Case-insensitive "mid" / "bid" / "ask"; nullopt otherwise. */
+std::optional<IvPriceMode> parse_iv_price_mode(std::string_view mode);
+
+/** Pick IV input price (bid/ask/mid) for a fixed mode. */
+template <IvPriceMode M> constexpr double pick_iv_input_price(double bid, double ask) {
+    if constexpr (M == IvPriceMode::BID) {
+        return bid > 0.0 ? bid : 0.0;
+    } else if constexpr (M == IvPriceMode::ASK) {
+        return ask > 0.0 ? ask : 0.0;
+    } else {
+        return (bid > 0.0 && ask > 0.0) ? (bid + ask) / 2.0 : (bid > 0.0 ? bid : ask);
+    }
+}
+
 /** Pick IV input price (bid/ask/mid). */
 double pick_iv_input_price(double bid, double ask, const std::string& mode);
 
@@ -27,8 +51,71 @@ double years_to_expiry(std::chrono::system_clock::time_point now,
 BsGreeks bs_greeks(bool is_call, double spot, double strike, double time_to_expiry_years,
                    double risk_free_rate, double sigma);
 
+/** SoA inputs for bs_greeks_batch; all spans share one length. is_call: nonzero = call. */
+struct BsBatchInput {
+    std::span<const double> spot;
+    std::span<const double> strike;
+    std::span<const double> tau;
+    std::span<const double> sigma;
+    std::span<const uint8_t> is_call;
+    double risk_free_rate = 0.0;
+};
+
+/** SoA outputs for bs_greeks_batch; same units as BsGreeks. */
+struct BsBatchOutput {
+    std::span<double> delta;
+    std::span<double> gamma;
+    std::span<double> theta;
+    std::span<double> vega;
+};
+
+/**
+ * Batch Greeks (AVX-512 / AVX2 / scalar, picked at runtime). Lanes with a non-positive input get
+ * zeros, like bs_greeks. Polynomial exp/log/N(x); |error| vs bs_greeks < 1e-12 (see
+ * black_scholes_simd.hpp).
+ */
+void bs_greeks_batch(const BsBatchInput& in, const BsBatchOutput& out);
+
+/**
+ * Batch prices plus raw vega (d price / d sigma, not per 1%), same lanes and ISA dispatch as
+ * bs_greeks_batch; price and vega must be as long as in.spot.
+ */
+void bs_price_vega_batch(const BsBatchInput& in, std::span<double> price, std::span<double> vega);
+
+/** ISA used by bs_greeks_batch on this CPU: "avx512", "avx2" or "scalar". */
+const char* bs_greeks_batch_isa();
+
 /** IV from price (LetsBeRational). */
 double implied_volatility_from_price(double option_price, double spot, double strike,
                                      double time_to_expiry_years, bool is_call);
 
+/**
+ * SoA inputs for implied_volatility_batch. prev_* hold the previous frame per lane (same index);
+ * leave them empty for a cold solve. prev_iv <= 0 means "no warm start" for that lane.
+ */
+struct IvBatchInput {
+    std::span<const double> price;
+    std::span<const double> spot;
+    std::span<const double> strike;
+    std::span<const double> tau;
+    std::span<const uint8_t> is_call;
+    std::span<const double> prev_price;
+    std::span<const double> prev_spot;
+    std::span<const double> prev_iv;
+};
+
+/** Lane counts by path taken. */
+struct IvBatchStats {
+    size_t reused = 0; // price and spot bitwise unchanged → prev_iv copied
+    size_t warm = 0;   // Newton from prev_iv converged
+    size_t cold = 0;   // LetsBeRational (no warm start or Newton rejected)
+};
+
+/**
+ * Batch IV, same conventions as implied_volatility_from_price (0 on invalid input). Reuse ignores
+ * tau drift between frames. Warm lanes take vectorized Newton steps on price/vega and fall back
+ * to LetsBeRational unless |last step| < 1e-10 vol within 4 steps. iv_out may alias prev_iv.
+ */
+IvBatchStats implied_volatility_batch(const IvBatchInput& in, std::span<double> iv_out);
+
 } // namespace utilities
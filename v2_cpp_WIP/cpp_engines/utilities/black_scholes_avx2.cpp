@@ -0,0 +1,49 @@
+/** AVX2 + FMA lanes for bs_greeks_batch; built with -mavx2 -mfma (see CMakeLists.txt). */
+
+#include "black_scholes_simd.hpp"
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+namespace utilities::bs_simd {
+
+#if defined(__AVX2__) && defined(__FMA__)
+
+namespace {
+
+struct Avx2Sqrt {
+    template <class V> auto operator()(V v) const -> V {
+        return std::bit_cast<V>(_mm256_sqrt_pd(std::bit_cast<__m256d>(v)));
+    }
+};
+
+} // namespace
+
+auto avx2_built() -> bool { return true; }
+
+auto greeks_avx2(const BsBatchInput& in, const BsBatchOutput& out) -> size_t {
+    return greeks_lanes<VectorLanes<4, Avx2Sqrt>>(in, out, 0, in.spot.size());
+}
+
+auto price_vega_avx2(const BsBatchInput& in, std::span<double> price, std::span<double> vega)
+    -> size_t {
+    return price_vega_lanes<VectorLanes<4, Avx2Sqrt>>(in, price, vega, 0, in.spot.size());
+}
+
+#else
+
+auto avx2_built() -> bool { return false; }
+
+auto greeks_avx2(const BsBatchInput& /*in*/, const BsBatchOutput& /*out*/) -> size_t {
+    return 0;
+}
+
+auto price_vega_avx2(const BsBatchInput& /*in*/, std::span<double> /*price*/,
+                      std::span<double> /*vega*/) -> size_t {
+    return 0;
+}
+
+#endif
+
+} // namespace utilities::bs_simd
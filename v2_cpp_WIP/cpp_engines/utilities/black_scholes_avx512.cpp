@@ -0,0 +1,49 @@
+/** AVX-512F lanes for bs_greeks_batch; built with -mavx512f (see CMakeLists.txt). */
+
+#include "black_scholes_simd.hpp"
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+namespace utilities::bs_simd {
+
+#if defined(__AVX512F__)
+
+namespace {
+
+struct Avx512Sqrt {
+    template <class V> auto operator()(V v) const -> V {
+        return std::bit_cast<V>(_mm512_maskz_sqrt_pd(0xFF, std::bit_cast<__m512d>(v)));
+    }
+};
+
+} // namespace
+
+auto avx512_built() -> bool { return true; }
+
+auto greeks_avx512(const BsBatchInput& in, const BsBatchOutput& out) -> size_t {
+    return greeks_lanes<VectorLanes<8, Avx512Sqrt>>(in, out, 0, in.spot.size());
+}
+
+auto price_vega_avx512(const BsBatchInput& in, std::span<double> price, std::span<double> vega)
+    -> size_t {
+    return price_vega_lanes<VectorLanes<8, Avx512Sqrt>>(in, price, vega, 0, in.spot.size());
+}
+
+#else
+
+auto avx512_built() -> bool { return false; }
+
+auto greeks_avx512(const BsBatchInput& /*in*/, const BsBatchOutput& /*out*/) -> size_t {
+    return 0;
+}
+
+auto price_vega_avx512(const BsBatchInput& /*in*/, std::span<double> /*price*/,
+                      std::span<double> /*vega*/) -> size_t {
+    return 0;
+}
+
+#endif
+
+} // namespace utilities::bs_simd
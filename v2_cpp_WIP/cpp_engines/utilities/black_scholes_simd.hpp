@@ -0,0 +1,306 @@
+#pragma once
+
+/**
+ * Lane-generic Black–Scholes Greeks kernel for bs_greeks_batch (internal; include only from
+ * black_scholes*.cpp). Everything sits in an unnamed namespace so each TU keeps its own copy built
+ * with that TU's ISA flags (no ODR merging of AVX2/AVX-512/scalar instantiations).
+ *
+ * Approximation error bounds (double precision, valid inputs):
+ * - fast_exp: range-reduced degree-12 Taylor, relative error < 4e-16 on [-708, 708].
+ * - fast_log: atanh series on [sqrt(1/2), sqrt(2)), absolute error < 2e-16 for normal x > 0.
+ * - ncdf: Hart (1968) rational form as in West (2005), absolute error < 1e-14.
+ */
+
+#include "black_scholes.hpp"
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace utilities::bs_simd {
+
+/** Defined in black_scholes_{avx2,avx512}.cpp; *_built() is false when the TU lacked the ISA. */
+bool avx2_built();
+bool avx512_built();
+/** Full-width lanes from index 0; returns the first index left for the scalar tail. */
+size_t greeks_avx2(const BsBatchInput& in, const BsBatchOutput& out);
+size_t greeks_avx512(const BsBatchInput& in, const BsBatchOutput& out);
+size_t price_vega_avx2(const BsBatchInput& in, std::span<double> price, std::span<double> vega);
+size_t price_vega_avx512(const BsBatchInput& in, std::span<double> price, std::span<double> vega);
+
+namespace {
+
+/** One lane; also the tail handler for the SIMD paths. */
+struct ScalarLanes {
+    using V = double;
+    using U = uint64_t;
+    static constexpr size_t width = 1;
+
+    static V load(const double* p) { return *p; }
+    static void store(double* p, V v) { *p = v; }
+    static V splat(double x) { return x; }
+    static U splat_u(uint64_t x) { return x; }
+    static V sqrt(V v) { return std::sqrt(v); }
+    static U lt(V a, V b) { return a < b ? ~U{0} : U{0}; }
+    static U load_mask(const uint8_t* p) { return *p != 0 ? ~U{0} : U{0}; }
+};
+
+/** GCC/Clang vector-extension types (vector_size must not be dependent). */
+template <size_t W> struct VectorTypes;
+template <> struct VectorTypes<4> {
+    using V = double __attribute__((vector_size(32)));
+    using U = uint64_t __attribute__((vector_size(32)));
+};
+template <> struct VectorTypes<8> {
+    using V = double __attribute__((vector_size(64)));
+    using U = uint64_t __attribute__((vector_size(64)));
+};
+
+/** W-wide lanes; Sqrt supplies the ISA square root. */
+template <size_t W, class Sqrt> struct VectorLanes {
+    using V = typename VectorTypes<W>::V;
+    using U = typename VectorTypes<W>::U;
+    static constexpr size_t width = W;
+
+    static V load(const double* p) {
+        V v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    static void store(double* p, V v) { std::memcpy(p, &v, sizeof(v)); }
+    static V splat(double x) { return V{} + x; }
+    static U splat_u(uint64_t x) { return U{} + x; }
+    static V sqrt(V v) { return Sqrt{}(v); }
+    static U lt(V a, V b) { return std::bit_cast<U>(a < b); }
+    static U load_mask(const uint8_t* p) {
+        U m{};
+        for (size_t k = 0; k < W; ++k) {
+            m[k] = p[k] != 0 ? ~uint64_t{0} : uint64_t{0};
+        }
+        return m;
+    }
+};
+
+template <class L> auto select(typename L::U m, typename L::V a, typename L::V b) ->
+    typename L::V {
+    using U = typename L::U;
+    const U ua = std::bit_cast<U>(a);
+    const U ub = std::bit_cast<U>(b);
+    return std::bit_cast<typename L::V>((ua & m) | (ub & ~m));
+}
+
+template <class L> auto vmin(typename L::V a, typename L::V b) -> typename L::V {
+    return select<L>(L::lt(a, b), a, b);
+}
+
+template <class L> auto vmax(typename L::V a, typename L::V b) -> typename L::V {
+    return select<L>(L::lt(a, b), b, a);
+}
+
+/** e^x; x clamped to [-708, 708]. */
+template <class L> auto fast_exp(typename L::V x) -> typename L::V {
+    using V = typename L::V;
+    using U = typename L::U;
+    constexpr double kLog2e = 1.4426950408889634;
+    constexpr double kLn2Hi = 0.6931471803691238;
+    constexpr double kLn2Lo = 1.9082149292705877e-10;
+    constexpr double kShifter = 6755399441055744.0; // 1.5 * 2^52: round-to-int via add
+
+    x = vmax<L>(vmin<L>(x, L::splat(708.0)), L::splat(-708.0));
+    V kd = x * kLog2e + kShifter;
+    const U ki = std::bit_cast<U>(kd);
+    kd = kd - kShifter;
+    V r = x - kd * kLn2Hi;
+    r = r - kd * kLn2Lo;
+
+    V p = L::splat(1.0 / 479001600.0);
+    p = p * r + (1.0 / 39916800.0);
+    p = p * r + (1.0 / 3628800.0);
+    p = p * r + (1.0 / 362880.0);
+    p = p * r + (1.0 / 40320.0);
+    p = p * r + (1.0 / 5040.0);
+    p = p * r + (1.0 / 720.0);
+    p = p * r + (1.0 / 120.0);
+    p = p * r + (1.0 / 24.0);
+    p = p * r + (1.0 / 6.0);
+    p = p * r + 0.5;
+    p = p * r + 1.0;
+    p = p * r + 1.0;
+    // Low bits of ki hold round(x * log2e); move them into the exponent field.
+    const U scale = (ki + L::splat_u(1023)) << 52;
+    return p * std::bit_cast<V>(scale);
+}
+
+/** ln(x) for normal, finite x > 0. */
+template <class L> auto fast_log(typename L::V x) -> typename L::V {
+    using V = typename L::V;
+    using U = typename L::U;
+    constexpr double kShifter = 6755399441055744.0;
+    constexpr double kLn2 = 0.6931471805599453;
+    constexpr double kSqrt2 = 1.4142135623730951;
+    constexpr uint64_t kMantissa = 0x000FFFFFFFFFFFFFULL;
+    constexpr uint64_t kOneBits = 0x3FF0000000000000ULL;
+
+    const U bits = std::bit_cast<U>(x);
+    const U biased_exp = bits >> 52;
+    V m = std::bit_cast<V>((bits & L::splat_u(kMantissa)) | L::splat_u(kOneBits));
+    // Exponent to double without int→fp conversion: add into shifter mantissa.
+    V e = std::bit_cast<V>(std::bit_cast<U>(L::splat(kShifter)) + biased_exp) -
+          (kShifter + 1023.0);
+    const U big = L::lt(L::splat(kSqrt2), m);
+    m = select<L>(big, m * 0.5, m);
+    e = select<L>(big, e + 1.0, e);
+
+    const V f = (m - 1.0) / (m + 1.0);
+    const V s = f * f;
+    V p = L::splat(1.0 / 21.0);
+    p = p * s + (1.0 / 19.0);
+    p = p * s + (1.0 / 17.0);
+    p = p * s + (1.0 / 15.0);
+    p = p * s + (1.0 / 13.0);
+    p = p * s + (1.0 / 11.0);
+    p = p * s + (1.0 / 9.0);
+    p = p * s + (1.0 / 7.0);
+    p = p * s + (1.0 / 5.0);
+    p = p * s + (1.0 / 3.0);
+    p = p * s + 1.0;
+    return e * kLn2 + 2.0 * f * p;
+}
+
+/** N(x) and N(-x) from one tail evaluation (Hart 1968). */
+template <class L>
+void ncdf_pair(typename L::V x, typename L::V& n_pos, typename L::V& n_neg) {
+    using V = typename L::V;
+    const V zero = L::splat(0.0);
+    const V ax = vmax<L>(x, zero - x);
+    const V e = fast_exp<L>(-0.5 * ax * ax);
+
+    V b = 3.52624965998911e-02 * ax + 0.700383064443688;
+    b = b * ax + 6.37396220353165;
+    b = b * ax + 33.912866078383;
+    b = b * ax + 112.079291497871;
+    b = b * ax + 221.213596169931;
+    b = b * ax + 220.206867912376;
+    V d = 8.83883476483184e-02 * ax + 1.75566716318264;
+    d = d * ax + 16.064177579207;
+    d = d * ax + 86.7807322029461;
+    d = d * ax + 296.564248779674;
+    d = d * ax + 637.333633378831;
+    d = d * ax + 793.826512519948;
+    d = d * ax + 440.413735824752;
+    const V near_tail = e * b / d;
+
+    V c = ax + 0.65;
+    c = ax + 4.0 / c;
+    c = ax + 3.0 / c;
+    c = ax + 2.0 / c;
+    c = ax + 1.0 / c;
+    const V far_tail = e / c / 2.506628274631;
+
+    V tail = select<L>(L::lt(ax, L::splat(7.07106781186547)), near_tail, far_tail);
+    tail = select<L>(L::lt(L::splat(37.0), ax), zero, tail);
+    const auto positive = L::lt(zero, x);
+    n_pos = select<L>(positive, 1.0 - tail, tail);
+    n_neg = select<L>(positive, tail, 1.0 - tail);
+}
+
+/** Masked per-lane inputs shared by the Greeks and price/vega kernels. */
+template <class L> struct BsLanes {
+    typename L::V s, k, t, sigma, sqrt_t, sig_sqrt_t, d1, d2;
+    typename L::U is_call, valid;
+};
+
+template <class L>
+auto load_bs_lanes(const BsBatchInput& in, size_t i, double r) -> BsLanes<L> {
+    using V = typename L::V;
+    const V zero = L::splat(0.0);
+    const V one = L::splat(1.0);
+    BsLanes<L> x;
+    x.s = L::load(in.spot.data() + i);
+    x.k = L::load(in.strike.data() + i);
+    x.t = L::load(in.tau.data() + i);
+    x.sigma = L::load(in.sigma.data() + i);
+    x.is_call = L::load_mask(in.is_call.data() + i);
+    x.valid = L::lt(zero, x.s) & L::lt(zero, x.k) & L::lt(zero, x.t) & L::lt(zero, x.sigma);
+    // Neutral values keep invalid lanes finite; callers zero their outputs.
+    x.s = select<L>(x.valid, x.s, one);
+    x.k = select<L>(x.valid, x.k, one);
+    x.t = select<L>(x.valid, x.t, one);
+    x.sigma = select<L>(x.valid, x.sigma, one);
+    x.sqrt_t = L::sqrt(x.t);
+    x.sig_sqrt_t = x.sigma * x.sqrt_t;
+    x.d1 = (fast_log<L>(x.s / x.k) + (r + 0.5 * x.sigma * x.sigma) * x.t) / x.sig_sqrt_t;
+    x.d2 = x.d1 - x.sig_sqrt_t;
+    return x;
+}
+
+/** Greeks for full-width lanes in [begin, end); returns the first index not processed. */
+template <class L>
+auto greeks_lanes(const BsBatchInput& in, const BsBatchOutput& out, size_t begin, size_t end)
+    -> size_t {
+    using V = typename L::V;
+    constexpr double kInvSqrt2Pi = 0.3989422804014327;
+    const double r = in.risk_free_rate;
+    const V zero = L::splat(0.0);
+
+    size_t i = begin;
+    for (; i + L::width <= end; i += L::width) {
+        const BsLanes<L> x = load_bs_lanes<L>(in, i, r);
+        const V pdf = kInvSqrt2Pi * fast_exp<L>(-0.5 * x.d1 * x.d1);
+        V n_d1;
+        V n_neg_d1;
+        V n_d2;
+        V n_neg_d2;
+        ncdf_pair<L>(x.d1, n_d1, n_neg_d1);
+        ncdf_pair<L>(x.d2, n_d2, n_neg_d2);
+        const V df = fast_exp<L>(L::splat(-r) * x.t);
+
+        const V delta = select<L>(x.is_call, n_d1, zero - n_neg_d1);
+        const V gamma = pdf / (x.s * x.sig_sqrt_t);
+        const V decay = zero - (x.s * pdf * x.sigma) / (2.0 * x.sqrt_t);
+        const V carry = r * x.k * df;
+        const V theta = select<L>(x.is_call, decay - carry * n_d2, decay + carry * n_neg_d2);
+        const V vega = x.s * pdf * x.sqrt_t;
+
+        L::store(out.delta.data() + i, select<L>(x.valid, delta, zero));
+        L::store(out.gamma.data() + i, select<L>(x.valid, gamma, zero));
+        L::store(out.theta.data() + i, select<L>(x.valid, theta / 365.0, zero));
+        L::store(out.vega.data() + i, select<L>(x.valid, vega / 100.0, zero));
+    }
+    return i;
+}
+
+/** Option price and raw vega (per 1.0 vol) for Newton IV steps. */
+template <class L>
+auto price_vega_lanes(const BsBatchInput& in, std::span<double> price, std::span<double> vega,
+                      size_t begin, size_t end) -> size_t {
+    using V = typename L::V;
+    constexpr double kInvSqrt2Pi = 0.3989422804014327;
+    const double r = in.risk_free_rate;
+    const V zero = L::splat(0.0);
+
+    size_t i = begin;
+    for (; i + L::width <= end; i += L::width) {
+        const BsLanes<L> x = load_bs_lanes<L>(in, i, r);
+        V n_d1;
+        V n_neg_d1;
+        V n_d2;
+        V n_neg_d2;
+        ncdf_pair<L>(x.d1, n_d1, n_neg_d1);
+        ncdf_pair<L>(x.d2, n_d2, n_neg_d2);
+        const V kdf = x.k * fast_exp<L>(L::splat(-r) * x.t);
+        const V call = x.s * n_d1 - kdf * n_d2;
+        const V put = kdf * n_neg_d2 - x.s * n_neg_d1;
+        const V pdf = kInvSqrt2Pi * fast_exp<L>(-0.5 * x.d1 * x.d1);
+
+        L::store(price.data() + i, select<L>(x.valid, select<L>(x.is_call, call, put), zero));
+        L::store(vega.data() + i, select<L>(x.valid, x.s * pdf * x.sqrt_t, zero));
+    }
+    return i;
+}
+
+} // namespace
+
+} // namespace utilities::bs_simd
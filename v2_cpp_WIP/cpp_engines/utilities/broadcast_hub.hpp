@@ -0,0 +1,151 @@
+#pragma once
+
+/**
+ * BroadcastHub: one shared ring of published values, read by any number of subscribers through
+ * their own cursors (every subscriber sees every value). Publishers never wait on readers; a
+ * subscriber that falls a full ring behind either skips ahead or is disconnected (its policy).
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+namespace utilities {
+
+/** What happens to a subscriber whose cursor was overrun by the ring. */
+enum class SlowSubscriberPolicy {
+    DropOldest, ///< Skip to the oldest retained value; skipped count in dropped().
+    Disconnect, ///< Stop delivering; read() returns false.
+};
+
+template <typename T> class BroadcastHub {
+  public:
+    class Subscriber {
+      public:
+        [[nodiscard]] uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+        [[nodiscard]] bool disconnected() const {
+            return disconnected_.load(std::memory_order_relaxed);
+        }
+
+      private:
+        friend class BroadcastHub;
+        SlowSubscriberPolicy policy_ = SlowSubscriberPolicy::DropOldest;
+        uint64_t cursor_ = 0; // next sequence to read (reader thread only)
+        std::atomic<uint64_t> dropped_{0};
+        std::atomic<bool> disconnected_{false};
+        /** Set by arm(); the next publish clears it and calls notify_. */
+        std::atomic<bool> armed_{false};
+        std::mutex notify_mutex_;
+        std::function<void()> notify_;
+    };
+    using SubscriberPtr = std::shared_ptr<Subscriber>;
+
+    explicit BroadcastHub(size_t capacity) : slots_(std::max<size_t>(capacity, 1)) {}
+
+    BroadcastHub(const BroadcastHub&) = delete;
+    BroadcastHub& operator=(const BroadcastHub&) = delete;
+
+    /**
+     * New subscriber starting at the next published value. notify (may be empty) is called on
+     * the publishing thread, once per arm(), when a value arrives.
+     */
+    SubscriberPtr subscribe(SlowSubscriberPolicy policy, std::function<void()> notify = {}) {
+        auto sub = std::make_shared<Subscriber>();
+        sub->policy_ = policy;
+        sub->notify_ = std::move(notify);
+        std::unique_lock lock(mutex_);
+        sub->cursor_ = head_;
+        subscribers_.push_back(sub);
+        subscriber_count_.store(subscribers_.size(), std::memory_order_relaxed);
+        return sub;
+    }
+
+    /** After return, notify is never called again for sub. */
+    void unsubscribe(const SubscriberPtr& sub) {
+        {
+            std::unique_lock lock(mutex_);
+            std::erase(subscribers_, sub);
+            subscriber_count_.store(subscribers_.size(), std::memory_order_relaxed);
+        }
+        std::scoped_lock notify_lock(sub->notify_mutex_);
+        sub->notify_ = nullptr;
+    }
+
+    /** Cheap check so publishers can skip building values nobody reads. */
+    [[nodiscard]] size_t subscriber_count() const {
+        return subscriber_count_.load(std::memory_order_relaxed);
+    }
+
+    void publish(T value) {
+        std::vector<SubscriberPtr> wake;
+        {
+            std::unique_lock lock(mutex_);
+            slots_[head_ % slots_.size()] = std::move(value);
+            ++head_;
+            for (const SubscriberPtr& sub : subscribers_) {
+                if (sub->armed_.exchange(false, std::memory_order_acq_rel)) {
+                    wake.push_back(sub);
+                }
+            }
+        }
+        for (const SubscriberPtr& sub : wake) {
+            std::scoped_lock notify_lock(sub->notify_mutex_);
+            if (sub->notify_) {
+                sub->notify_();
+            }
+        }
+    }
+
+    /**
+     * Reader of sub only: append up to max values after its cursor to out. Returns false once sub
+     * is disconnected (Disconnect policy, overrun).
+     */
+    bool read(Subscriber& sub, std::vector<T>& out, size_t max) {
+        std::shared_lock lock(mutex_);
+        if (sub.disconnected_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        const uint64_t oldest = head_ > slots_.size() ? head_ - slots_.size() : 0;
+        if (sub.cursor_ < oldest) {
+            if (sub.policy_ == SlowSubscriberPolicy::Disconnect) {
+                sub.disconnected_.store(true, std::memory_order_relaxed);
+                return false;
+            }
+            sub.dropped_.fetch_add(oldest - sub.cursor_, std::memory_order_relaxed);
+            sub.cursor_ = oldest;
+        }
+        for (; sub.cursor_ < head_ && max > 0; ++sub.cursor_, --max) {
+            out.push_back(slots_[sub.cursor_ % slots_.size()]);
+        }
+        return true;
+    }
+
+    /**
+     * Reader of sub only: request a notify for the next publish. Returns false (not armed) when
+     * values are already pending, so the caller reads again instead of waiting.
+     */
+    bool arm(Subscriber& sub) {
+        std::shared_lock lock(mutex_);
+        if (sub.cursor_ != head_) {
+            return false;
+        }
+        sub.armed_.store(true, std::memory_order_release);
+        return true;
+    }
+
+  private:
+    mutable std::shared_mutex mutex_;
+    std::vector<T> slots_;
+    uint64_t head_ = 0; // sequence of the next publish
+    std::vector<SubscriberPtr> subscribers_;
+    std::atomic<size_t> subscriber_count_{0};
+};
+
+} // namespace utilities
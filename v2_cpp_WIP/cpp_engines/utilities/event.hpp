@@ -6,6 +6,7 @@
 
 #include "object.hpp"
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <variant>
 
@@ -18,7 +19,23 @@ enum class EventType : uint8_t {
     Snapshot,
 };
 
-using EventPayload = std::variant<std::monostate, OrderData, TradeData, PortfolioSnapshot>;
+/**
+ * Snapshot payload: events share the frame instead of copying its columns. Owning handles come
+ * from share_snapshot (the producer hands the frame over); borrow_snapshot points at a frame its
+ * owner keeps alive through a synchronous dispatch (backtest), with no allocation or refcount.
+ */
+using SnapshotHandle = std::shared_ptr<const PortfolioSnapshot>;
+
+inline SnapshotHandle share_snapshot(PortfolioSnapshot&& snapshot) {
+    return std::make_shared<PortfolioSnapshot>(std::move(snapshot));
+}
+
+/** Non-owning (use_count() == 0); the live EventEngine copies it once before queueing. */
+inline SnapshotHandle borrow_snapshot(const PortfolioSnapshot& snapshot) {
+    return {std::shared_ptr<const void>(), &snapshot};
+}
+
+using EventPayload = std::variant<std::monostate, OrderData, TradeData, SnapshotHandle>;
 
 struct Event {
     EventType type = EventType::Timer;
@@ -26,6 +43,12 @@ struct Event {
 
     Event() = default;
     Event(EventType t, EventPayload p = std::monostate{}) : type(t), data(std::move(p)) {}
+
+    /** Snapshot payload, or nullptr. */
+    [[nodiscard]] const PortfolioSnapshot* snapshot() const {
+        const auto* handle = std::get_if<SnapshotHandle>(&data);
+        return handle != nullptr ? handle->get() : nullptr;
+    }
 };
 
 /**
@@ -39,4 +62,22 @@ struct StrategyUpdateData {
     std::string json_payload;
 };
 
+/** Chain-level Greeks of the live holdings stream (mirrors proto ChainGreeksMsg). */
+struct ChainGreeksData {
+    std::string portfolio;
+    std::string chain;
+    double atm_price = 0.0;
+    double atm_iv = 0.0;
+    /** Call IV / put IV at 25 delta; 0 if unavailable. */
+    double skew = 0.0;
+    int days_to_expiry = 0;
+    /** ATM straddle (call + put at the ATM strike), position-scaled like OptionData. */
+    double delta = 0.0;
+    double gamma = 0.0;
+    double theta = 0.0;
+    double vega = 0.0;
+
+    bool operator==(const ChainGreeksData&) const = default;
+};
+
 } // namespace utilities
@@ -0,0 +1,76 @@
+#pragma once
+
+/**
+ * FrameArena: monotonic memory for containers that live for one Snapshot/Timer cycle (intent
+ * out-vectors of hedging and metrics timers). Allocations bump a pointer in one buffer and are
+ * never freed individually; the event engine calls reset() at the end of each cycle. A cycle that
+ * outgrows the buffer spills to the heap, and the next reset() grows the buffer to that cycle's
+ * total, so steady state is allocation-free. Single-threaded: one arena per dispatching thread.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+namespace utilities {
+
+class FrameArena {
+  public:
+    explicit FrameArena(size_t initial_bytes = size_t{64} << 10)
+        : buffer_(std::make_unique<std::byte[]>(initial_bytes)), capacity_(initial_bytes) {
+        resource_.emplace(buffer_.get(), capacity_, &spill_);
+    }
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    /** Allocator source for std::pmr containers of the current cycle. */
+    std::pmr::memory_resource* resource() { return &*resource_; }
+
+    /** End of cycle: everything allocated from resource() is invalid afterwards. */
+    void reset() {
+        if (spill_.bytes == 0) {
+            resource_->release();
+            return;
+        }
+        // Spilled blocks grow geometrically; their sum bounds the cycle's footprint.
+        const size_t want = capacity_ + spill_.bytes;
+        resource_.reset();
+        spill_.bytes = 0;
+        capacity_ = std::max(want, capacity_ * 2);
+        buffer_ = std::make_unique<std::byte[]>(capacity_);
+        resource_.emplace(buffer_.get(), capacity_, &spill_);
+        ++grown_;
+    }
+
+    [[nodiscard]] size_t capacity() const { return capacity_; }
+    /** Times reset() grew the buffer (should stop after the first few cycles). */
+    [[nodiscard]] size_t grown() const { return grown_; }
+
+  private:
+    /** Heap upstream that counts what the buffer could not hold since the last reset. */
+    struct SpillResource : std::pmr::memory_resource {
+        size_t bytes = 0;
+
+        void* do_allocate(size_t n, size_t align) override {
+            bytes += n;
+            return std::pmr::new_delete_resource()->allocate(n, align);
+        }
+        void do_deallocate(void* p, size_t n, size_t align) override {
+            std::pmr::new_delete_resource()->deallocate(p, n, align);
+        }
+        [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const
+            noexcept override {
+            return this == &other;
+        }
+    };
+
+    std::unique_ptr<std::byte[]> buffer_;
+    size_t capacity_;
+    size_t grown_ = 0;
+    SpillResource spill_;
+    std::optional<std::pmr::monotonic_buffer_resource> resource_;
+};
+
+} // namespace utilities
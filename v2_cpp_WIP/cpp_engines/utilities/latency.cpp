@@ -0,0 +1,204 @@
+#include "latency.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <thread>
+
+namespace utilities {
+
+namespace {
+
+/** ns per TSC tick, measured over a 10 ms sleep (invariant TSC assumed, as on any recent x86). */
+auto ns_per_tick() -> double {
+#if defined(__x86_64__) || defined(_M_X64)
+    static const double rate = []() -> double {
+        const auto t0 = std::chrono::steady_clock::now();
+        const uint64_t c0 = trace_now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        const auto t1 = std::chrono::steady_clock::now();
+        const uint64_t c1 = trace_now();
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+        return c1 > c0 ? static_cast<double>(ns) / static_cast<double>(c1 - c0) : 1.0;
+    }();
+    return rate;
+#else
+    return 1.0;
+#endif
+}
+
+void atomic_min(std::atomic<uint64_t>& target, uint64_t value) {
+    uint64_t seen = target.load(std::memory_order_relaxed);
+    while (value < seen &&
+           !target.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+}
+
+void atomic_max(std::atomic<uint64_t>& target, uint64_t value) {
+    uint64_t seen = target.load(std::memory_order_relaxed);
+    while (value > seen &&
+           !target.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+}
+
+} // namespace
+
+auto to_string(LatencyStage stage) -> const char* {
+    switch (stage) {
+        using enum LatencyStage;
+    case MarketData:
+        return "market_data";
+    case EventQueue:
+        return "event_queue";
+    case ApplyFrame:
+        return "apply_frame";
+    case TickToApply:
+        return "tick_to_apply";
+    case StrategyTimer:
+        return "strategy_timer";
+    case Hedge:
+        return "hedge";
+    case SendOrder:
+        return "send_order";
+    case GatewayQueue:
+        return "gateway_queue";
+    case TickToOrder:
+        return "tick_to_order";
+    }
+    return "unknown";
+}
+
+auto trace_ticks_to_ns(uint64_t ticks) -> uint64_t {
+    return static_cast<uint64_t>(static_cast<double>(ticks) * ns_per_tick());
+}
+
+// -------- LatencyHistogram --------
+
+auto LatencyHistogram::bucket_of(uint64_t ns) noexcept -> size_t {
+    if (ns < 2 * kSub) {
+        return static_cast<size_t>(ns);
+    }
+    // Top kSubBits + 1 bits select the bucket: [mantissa << shift, (mantissa + 1) << shift).
+    const int shift = static_cast<int>(std::bit_width(ns)) - 1 - kSubBits;
+    const auto mantissa = static_cast<size_t>(ns >> shift);
+    return (static_cast<size_t>(shift) + 1) * kSub + (mantissa - kSub);
+}
+
+auto LatencyHistogram::bucket_upper(size_t bucket) noexcept -> uint64_t {
+    if (bucket < 2 * kSub) {
+        return bucket;
+    }
+    const size_t shift = (bucket / kSub) - 1;
+    const uint64_t mantissa = (bucket % kSub) + kSub;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t ns) noexcept {
+    counts_[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(ns, std::memory_order_relaxed);
+    atomic_min(min_, ns);
+    atomic_max(max_, ns);
+}
+
+auto LatencyHistogram::summary() const -> LatencySummary {
+    LatencySummary s;
+    std::array<uint64_t, kBuckets> counts{};
+    for (size_t i = 0; i < kBuckets; ++i) {
+        counts[i] = counts_[i].load(std::memory_order_relaxed);
+        s.count += counts[i];
+    }
+    if (s.count == 0) {
+        return s;
+    }
+    s.min_ns = min_.load(std::memory_order_relaxed);
+    s.max_ns = max_.load(std::memory_order_relaxed);
+    s.mean_ns = static_cast<double>(sum_.load(std::memory_order_relaxed)) /
+                static_cast<double>(std::max<uint64_t>(count_.load(std::memory_order_relaxed), 1));
+
+    const std::array<std::pair<double, uint64_t*>, 4> quantiles{{{0.50, &s.p50_ns},
+                                                                 {0.90, &s.p90_ns},
+                                                                 {0.99, &s.p99_ns},
+                                                                 {0.999, &s.p999_ns}}};
+    size_t q = 0;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets && q < quantiles.size(); ++i) {
+        seen += counts[i];
+        while (q < quantiles.size() &&
+               static_cast<double>(seen) >= quantiles[q].first * static_cast<double>(s.count)) {
+            *quantiles[q].second = std::clamp(bucket_upper(i), s.min_ns, s.max_ns);
+            ++q;
+        }
+    }
+    return s;
+}
+
+void LatencyHistogram::reset() noexcept {
+    for (auto& c : counts_) {
+        c.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    min_.store(UINT64_MAX, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+// -------- LatencyTracer --------
+
+auto LatencyTracer::instance() -> LatencyTracer& {
+    static LatencyTracer tracer;
+    return tracer;
+}
+
+void LatencyTracer::set_enabled(bool enabled) {
+    if (enabled) {
+        (void)ns_per_tick();
+    }
+    enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+void LatencyTracer::record(LatencyStage stage, uint64_t start_ticks, uint64_t end_ticks) noexcept {
+    record_ns(stage, end_ticks > start_ticks ? trace_ticks_to_ns(end_ticks - start_ticks) : 0);
+}
+
+void LatencyTracer::record_ns(LatencyStage stage, uint64_t ns) noexcept {
+    stages_[static_cast<size_t>(stage)].record(ns);
+}
+
+auto LatencyTracer::strategy(const std::string& strategy_name) -> LatencyHistogram& {
+    std::scoped_lock lock(strategies_mutex_);
+    auto& slot = strategies_[strategy_name];
+    if (!slot) {
+        slot = std::make_unique<LatencyHistogram>();
+    }
+    return *slot;
+}
+
+auto LatencyTracer::report() const -> LatencyReport {
+    LatencyReport out;
+    out.enabled = enabled();
+    out.stages.reserve(kLatencyStageCount);
+    for (size_t i = 0; i < kLatencyStageCount; ++i) {
+        out.stages.emplace_back(to_string(static_cast<LatencyStage>(i)), stages_[i].summary());
+    }
+    {
+        std::scoped_lock lock(strategies_mutex_);
+        out.strategies.reserve(strategies_.size());
+        for (const auto& [name, histogram] : strategies_) {
+            out.strategies.emplace_back(name, histogram->summary());
+        }
+    }
+    std::ranges::sort(out.strategies, {}, &std::pair<std::string, LatencySummary>::first);
+    return out;
+}
+
+void LatencyTracer::reset() {
+    for (LatencyHistogram& h : stages_) {
+        h.reset();
+    }
+    std::scoped_lock lock(strategies_mutex_);
+    for (const auto& kv : strategies_) {
+        kv.second->reset();
+    }
+}
+
+} // namespace utilities
@@ -0,0 +1,153 @@
+#pragma once
+
+/**
+ * Live tick-to-order latency tracing. Probes stamp TSC ticks (trace_now) at each hot-path stage
+ * and record the stage duration into a lock-free log-linear histogram (HDR style, 32 sub-buckets
+ * per power of two: <= ~3% relative error). Market data carries its arrival stamp through
+ * PortfolioSnapshot::trace_tsc, the portfolio it was applied to and OrderRequest::trace_tsc, so
+ * the gateway can record arrival → placeOrder of the order it triggered.
+ * Off by default: a disabled probe is one relaxed load and a not-taken branch.
+ */
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <x86intrin.h>
+#endif
+
+namespace utilities {
+
+/** Hot-path stages, in pipeline order. */
+enum class LatencyStage : uint8_t {
+    MarketData,    // chain response (or stream flush) → Snapshot event built and queued
+    EventQueue,    // put → dispatch on the worker (every lane)
+    ApplyFrame,    // PortfolioData::apply_frame of one snapshot
+    TickToApply,   // market data arrival → its snapshot applied
+    StrategyTimer, // one strategy's on_timer_logic
+    Hedge,         // one hedging round (per strategy, or netted)
+    SendOrder,     // ExecutionEngine::send_order (risk check, order build, gateway hand-off)
+    GatewayQueue,  // IbGateway::send_order → placeOrder on the I/O thread
+    TickToOrder,   // market data arrival → placeOrder of an order decided on it
+};
+inline constexpr size_t kLatencyStageCount = 9;
+
+const char* to_string(LatencyStage stage);
+
+/** TSC ticks (rdtsc; steady clock ns where there is no TSC). Compare on one machine only. */
+inline uint64_t trace_now() noexcept {
+#if defined(__x86_64__) || defined(_M_X64)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+#endif
+}
+
+/** Tick delta → ns (TSC rate calibrated once against steady_clock). */
+uint64_t trace_ticks_to_ns(uint64_t ticks);
+
+struct LatencySummary {
+    uint64_t count = 0;
+    uint64_t min_ns = 0;
+    uint64_t max_ns = 0;
+    double mean_ns = 0.0;
+    uint64_t p50_ns = 0;
+    uint64_t p90_ns = 0;
+    uint64_t p99_ns = 0;
+    uint64_t p999_ns = 0;
+};
+
+/** Concurrent record (relaxed atomics); summary() is a consistent-enough read while recording. */
+class LatencyHistogram {
+  public:
+    LatencyHistogram() = default;
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(uint64_t ns) noexcept;
+    [[nodiscard]] LatencySummary summary() const;
+    void reset() noexcept;
+
+  private:
+    static constexpr int kSubBits = 5;
+    static constexpr size_t kSub = size_t{1} << kSubBits;
+    static constexpr size_t kBuckets = (64 - kSubBits + 1) * kSub;
+
+    static size_t bucket_of(uint64_t ns) noexcept;
+    /** Highest value that lands in bucket (what percentiles report). */
+    static uint64_t bucket_upper(size_t bucket) noexcept;
+
+    std::array<std::atomic<uint64_t>, kBuckets> counts_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> min_{UINT64_MAX};
+    std::atomic<uint64_t> max_{0};
+};
+
+struct LatencyReport {
+    bool enabled = false;
+    /** Every stage in LatencyStage order, including empty ones. */
+    std::vector<std::pair<std::string, LatencySummary>> stages;
+    /** strategy name → its on_timer_logic, sorted by name. */
+    std::vector<std::pair<std::string, LatencySummary>> strategies;
+};
+
+/** Process-wide; histograms live as long as the process (pointers stay valid). */
+class LatencyTracer {
+  public:
+    static LatencyTracer& instance();
+
+    [[nodiscard]] static bool enabled() noexcept {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+    /** Enabling calibrates the TSC rate first (~10 ms, once). */
+    static void set_enabled(bool enabled);
+
+    /** end - start ticks into stage; an end before start (cross-core skew) records 0. */
+    void record(LatencyStage stage, uint64_t start_ticks, uint64_t end_ticks) noexcept;
+    void record_ns(LatencyStage stage, uint64_t ns) noexcept;
+    /** on_timer_logic histogram of strategy_name, created on first use. */
+    LatencyHistogram& strategy(const std::string& strategy_name);
+
+    [[nodiscard]] LatencyReport report() const;
+    void reset();
+
+  private:
+    LatencyTracer() = default;
+
+    static inline std::atomic<bool> enabled_{false};
+    std::array<LatencyHistogram, kLatencyStageCount> stages_;
+    mutable std::mutex strategies_mutex_;
+    std::unordered_map<std::string, std::unique_ptr<LatencyHistogram>> strategies_;
+};
+
+/** Records construction → destruction into stage when tracing was on at construction. */
+class LatencyProbe {
+  public:
+    explicit LatencyProbe(LatencyStage stage) noexcept
+        : stage_(stage), start_(LatencyTracer::enabled() ? trace_now() : 0) {}
+    ~LatencyProbe() {
+        if (start_ != 0) {
+            LatencyTracer::instance().record(stage_, start_, trace_now());
+        }
+    }
+    LatencyProbe(const LatencyProbe&) = delete;
+    LatencyProbe& operator=(const LatencyProbe&) = delete;
+
+  private:
+    LatencyStage stage_;
+    uint64_t start_;
+};
+
+} // namespace utilities
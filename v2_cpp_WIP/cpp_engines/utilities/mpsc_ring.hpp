@@ -0,0 +1,108 @@
+#pragma once
+
+/**
+ * MpscRing: bounded lock-free multi-producer / single-consumer ring with preallocated cells
+ * (per-cell sequence numbers). try_push never blocks; the single consumer drains in batches.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+namespace utilities {
+
+/** Spin-wait hint (pause on x86); no-op elsewhere. */
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    _mm_pause();
+#endif
+}
+
+template <typename T> class MpscRing {
+  public:
+    /** capacity rounded up to a power of two (min 2). */
+    explicit MpscRing(size_t capacity)
+        : mask_(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1),
+          cells_(std::make_unique<Cell[]>(mask_ + 1)) {
+        for (size_t i = 0; i <= mask_; ++i) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    /** Any thread; false when full (value untouched). */
+    template <typename U> bool try_push(U&& value) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        while (true) {
+            cell = &cells_[pos & mask_];
+            const size_t seq = cell->seq.load(std::memory_order_acquire);
+            const auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::forward<U>(value);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Consumer only: move up to max ready values into out(T&&); returns how many. */
+    template <typename F> size_t pop_batch(F&& out, size_t max) {
+        size_t n = 0;
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        for (; n < max; ++n, ++pos) {
+            Cell& cell = cells_[pos & mask_];
+            if (cell.seq.load(std::memory_order_acquire) != pos + 1) {
+                break;
+            }
+            out(std::move(cell.value));
+            cell.seq.store(pos + mask_ + 1, std::memory_order_release);
+        }
+        dequeue_pos_.store(pos, std::memory_order_relaxed);
+        return n;
+    }
+
+    /** Consumer only: a value is ready at the head. */
+    [[nodiscard]] bool ready() const {
+        const size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        return cells_[pos & mask_].seq.load(std::memory_order_acquire) == pos + 1;
+    }
+
+    /** Claimed but not yet consumed (approximate under concurrency). */
+    [[nodiscard]] size_t size_approx() const {
+        const size_t enq = enqueue_pos_.load(std::memory_order_relaxed);
+        const size_t deq = dequeue_pos_.load(std::memory_order_relaxed);
+        return enq > deq ? enq - deq : 0;
+    }
+    [[nodiscard]] size_t capacity() const { return mask_ + 1; }
+
+  private:
+    struct alignas(64) Cell {
+        std::atomic<size_t> seq{0};
+        T value{};
+    };
+
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<size_t> dequeue_pos_{0};
+};
+
+} // namespace utilities
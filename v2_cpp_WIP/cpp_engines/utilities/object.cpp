@@ -46,6 +46,28 @@ auto OrderRequest::create_order_data(const std::string& orderid,
     return order;
 }
 
+auto PositionMetrics::operator+=(const PositionMetrics& other) -> PositionMetrics& {
+    current_value += other.current_value;
+    total_cost += other.total_cost;
+    realized_pnl += other.realized_pnl;
+    delta += other.delta;
+    gamma += other.gamma;
+    theta += other.theta;
+    vega += other.vega;
+    return *this;
+}
+
+auto PositionMetrics::operator-=(const PositionMetrics& other) -> PositionMetrics& {
+    current_value -= other.current_value;
+    total_cost -= other.total_cost;
+    realized_pnl -= other.realized_pnl;
+    delta -= other.delta;
+    gamma -= other.gamma;
+    theta -= other.theta;
+    vega -= other.vega;
+    return *this;
+}
+
 auto BasePosition::current_value() const -> double { return quantity * mid_price * multiplier; }
 
 void BasePosition::clear_fields() {
@@ -4,6 +4,7 @@
 
 #include "constant.hpp"
 #include <chrono>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
@@ -74,22 +75,45 @@ struct ChainMarketData : BaseData {
     void add_option(const OptionMarketData& option_data);
 };
 
-/** Portfolio snapshot (option_apply_order). */
+/**
+ * Portfolio snapshot (option_apply_order). Dense: one entry per option. Sparse: bid/ask/last are
+ * updates for the options at slots; every other option keeps its current quote.
+ */
 struct PortfolioSnapshot {
     std::string portfolio_name;
     DateTime datetime{};
     double underlying_bid = 0.0;
     double underlying_ask = 0.0;
     double underlying_last = 0.0;
-    /** Option values (option_apply_order). */
+    /** Displayed underlying size at bid/ask; 0 = unknown. */
+    double underlying_bid_sz = 0.0;
+    double underlying_ask_sz = 0.0;
+    bool sparse = false;
+    /** Sparse only: option_apply_order index of each bid/ask/last entry (later entries win). */
+    std::vector<uint32_t> slots;
+    /** Option values (option_apply_order, or parallel to slots when sparse). */
     std::vector<double> bid;
     std::vector<double> ask;
     std::vector<double> last;
+    /** Displayed size at bid/ask, parallel to bid/ask; empty or 0 = unknown. */
+    std::vector<double> bid_sz;
+    std::vector<double> ask_sz;
     std::vector<double> delta;
     std::vector<double> gamma;
     std::vector<double> theta;
     std::vector<double> vega;
     std::vector<double> iv;
+    /** Dense only: iv/delta/gamma/theta/vega hold precomputed per-unit values, copied as is. */
+    bool has_greeks = false;
+    /**
+     * Chain symbols (e.g. "SPXW_20251024") whose quotes this snapshot carries; empty = all.
+     * apply_frame solves IV/Greeks only for these and leaves other chains' quotes as they are.
+     */
+    std::vector<std::string> chains;
+    /** has_greeks only: sorted chains the Greeks were computed for; empty = all. */
+    std::vector<std::string> greek_chains;
+    /** trace_now() when the data behind it arrived (latency tracing); 0 = untraced. */
+    uint64_t trace_tsc = 0;
 };
 
 // Contract
@@ -177,6 +201,8 @@ struct OrderRequest {
     bool is_combo = false;
     std::optional<std::vector<Leg>> legs;
     std::optional<ComboType> combo_type;
+    /** trace_tsc of the market data the order was decided on (latency tracing); 0 = untraced. */
+    uint64_t trace_tsc = 0;
 
     OrderData create_order_data(const std::string& orderid, const std::string& gateway_name) const;
 };
@@ -191,6 +217,23 @@ struct CancelRequest {
 
 // Position Holding
 
+struct OptionData;
+struct PortfolioData;
+
+/** Metric totals of one position or a whole holding, accumulated in place. */
+struct PositionMetrics {
+    double current_value = 0.0;
+    double total_cost = 0.0;
+    double realized_pnl = 0.0;
+    double delta = 0.0;
+    double gamma = 0.0;
+    double theta = 0.0;
+    double vega = 0.0;
+
+    PositionMetrics& operator+=(const PositionMetrics& other);
+    PositionMetrics& operator-=(const PositionMetrics& other);
+};
+
 struct BasePosition {
     std::string symbol;
     int quantity = 0;
@@ -203,6 +246,9 @@ struct BasePosition {
     double theta = 0.0;
     double vega = 0.0;
     double multiplier = 1.0;
+    /** Market-state handle resolved by PositionEngine; valid while instrument_owner is current. */
+    const OptionData* instrument = nullptr;
+    const PortfolioData* instrument_owner = nullptr;
 
     [[nodiscard]] double current_value() const;
     void clear_fields();
@@ -211,6 +257,11 @@ struct BasePosition {
 struct OptionPositionData : BasePosition {
     std::optional<ComboType> combo_type;
     std::vector<OptionPositionData> legs;
+    /** Incremental valuation: contribution to the holding totals as of frame valued_frame. */
+    PositionMetrics valuation;
+    uint64_t valued_frame = 0;
+    /** Quantity changed (or never valued): revalue on the next metrics update. */
+    bool revalue = true;
 
     OptionPositionData() { multiplier = 100.0; }
     OptionPositionData(const std::string& sym) : BasePosition{sym} { multiplier = 100.0; }
@@ -237,6 +288,10 @@ struct StrategyHolding {
     UnderlyingPositionData underlyingPosition;
     std::unordered_map<std::string, OptionPositionData> optionPositions;
     PortfolioSummary summary;
+    /** Running sum of optionPositions' valuation; rebuilt by a periodic full revalue. */
+    PositionMetrics option_totals;
+    const PortfolioData* valued_portfolio = nullptr;
+    int updates_since_full = 0;
 };
 
 } // namespace utilities
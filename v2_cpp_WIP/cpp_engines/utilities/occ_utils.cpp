@@ -1,14 +1,12 @@
 #include "occ_utils.hpp"
 #include "constant.hpp"
+#include <algorithm>
 #include <array>
+#include <cctype>
+#include <charconv>
 #include <chrono>
-#include <cstdlib>
+#include <cstdio>
 #include <ctime>
-#include <sstream>
-#include <stdexcept>
-#ifdef _WIN32
-#include <windows.h>
-#endif
 
 namespace backtest {
 
@@ -16,46 +14,32 @@ namespace {
 using namespace utilities;
 }
 
-auto parse_occ_symbol(const std::string& symbol)
+auto parse_occ_symbol(std::string_view symbol)
     -> std::tuple<std::optional<Timestamp>, std::optional<double>, std::optional<OptionType>> {
-    if (symbol.size() < 15U) {
+    const std::optional<OccKey> key = parse_occ_key(symbol);
+    if (!key) {
         return {std::nullopt, std::nullopt, std::nullopt};
     }
-    try {
-        int yy = std::stoi(symbol.substr(0, 2));
-        int mm = std::stoi(symbol.substr(2, 2));
-        int dd = std::stoi(symbol.substr(4, 2));
-        int year = (yy < 80) ? (2000 + yy) : (1900 + yy);
-        // Expiry 16:00 ET = 21:00 UTC; build UTC tm and convert to time_t without touching TZ
-        std::tm tm_utc{};
-        tm_utc.tm_year = year - 1900;
-        tm_utc.tm_mon = mm - 1;
-        tm_utc.tm_mday = dd;
-        tm_utc.tm_hour = 21;
-        tm_utc.tm_min = 0;
-        tm_utc.tm_sec = 0;
-        tm_utc.tm_isdst = 0;
-        std::time_t t = 0;
-#ifdef _WIN32
-        t = _mkgmtime(&tm_utc);
-#else
-        t = timegm(&tm_utc);
-#endif
-        if (t == -1) {
-            return {std::nullopt, std::nullopt, std::nullopt};
-        }
-        Timestamp expiry = std::chrono::system_clock::from_time_t(t);
+    return {key->expiry(), key->strike(), key->option_type()};
+}
 
-        char cp = static_cast<char>(std::toupper(static_cast<unsigned char>(symbol[6])));
-        if (cp != 'C' && cp != 'P') {
-            return {std::nullopt, std::nullopt, std::nullopt};
-        }
-        double strike = std::stoi(symbol.substr(7, 8)) / 1000.0;
-        OptionType opt_type = (cp == 'C') ? OptionType::CALL : OptionType::PUT;
-        return {expiry, strike, opt_type};
-    } catch (...) {
-        return {std::nullopt, std::nullopt, std::nullopt};
-    }
+auto occ_standard_symbol(std::string_view underlying, OccKey key, int multiplier)
+    -> std::string {
+    // Suffix "-YYYYMMDD-CALL-<strike>-<multiplier>" is at most ~35 chars.
+    std::array<char, 48> buf{};
+    char* p = buf.data();
+    char* const last = buf.data() + buf.size();
+    *p++ = '-';
+    p = std::to_chars(p, last, key.expiry_yyyymmdd()).ptr;
+    const std::string_view right = key.is_call() ? "-CALL-" : "-PUT-";
+    p = std::ranges::copy(right, p).out;
+    p = std::to_chars(p, last, key.strike_thousandths() / 1000).ptr;
+    *p++ = '-';
+    p = std::to_chars(p, last, multiplier).ptr;
+    std::string out;
+    out.reserve(underlying.size() + static_cast<size_t>(p - buf.data()));
+    out.append(underlying).append(buf.data(), p);
+    return out;
 }
 
 auto infer_underlying_from_filename(const std::string& filename) -> std::string {
@@ -7,17 +7,97 @@
 
 #include "constant.hpp"
 #include <chrono>
+#include <cstdint>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <tuple>
 
 namespace backtest {
 
 using Timestamp = std::chrono::system_clock::time_point;
 
+/**
+ * Parsed OCC contract packed into one integer: expiry YYYYMMDD, then right, then strike in
+ * thousandths. Keys order by expiry first, so one chain is a contiguous run of sorted keys.
+ */
+struct OccKey {
+    static constexpr int kStrikeBits = 27; // 8 OCC strike digits: < 10^8 < 2^27
+    uint64_t packed = 0;
+
+    [[nodiscard]] constexpr uint32_t expiry_yyyymmdd() const {
+        return static_cast<uint32_t>(packed >> (kStrikeBits + 1));
+    }
+    [[nodiscard]] constexpr bool is_call() const { return ((packed >> kStrikeBits) & 1U) != 0; }
+    [[nodiscard]] constexpr uint32_t strike_thousandths() const {
+        return static_cast<uint32_t>(packed & ((uint64_t{1} << kStrikeBits) - 1));
+    }
+    [[nodiscard]] constexpr double strike() const { return strike_thousandths() / 1000.0; }
+    [[nodiscard]] constexpr utilities::OptionType option_type() const {
+        return is_call() ? utilities::OptionType::CALL : utilities::OptionType::PUT;
+    }
+    /** Expiry at 16:00 ET = 21:00 UTC. */
+    [[nodiscard]] constexpr Timestamp expiry() const {
+        const uint32_t d = expiry_yyyymmdd();
+        const std::chrono::year_month_day ymd{std::chrono::year(static_cast<int>(d / 10000)),
+                                              std::chrono::month(d / 100 % 100),
+                                              std::chrono::day(d % 100)};
+        return Timestamp(std::chrono::sys_days(ymd) + std::chrono::hours(21));
+    }
+
+    friend constexpr auto operator<=>(OccKey, OccKey) = default;
+};
+
+/** OccKey of symbol in one pass, no allocation; nullopt if it is not a valid OCC contract. */
+constexpr std::optional<OccKey> parse_occ_key(std::string_view symbol) {
+    if (symbol.size() < 15U) {
+        return std::nullopt;
+    }
+    auto digits = [symbol](size_t pos, size_t n) -> std::optional<uint32_t> {
+        uint32_t v = 0;
+        for (const char c : symbol.substr(pos, n)) {
+            if (c < '0' || c > '9') {
+                return std::nullopt;
+            }
+            v = v * 10 + static_cast<uint32_t>(c - '0');
+        }
+        return v;
+    };
+    const auto yy = digits(0, 2);
+    const auto mm = digits(2, 2);
+    const auto dd = digits(4, 2);
+    const auto strike = digits(7, 8);
+    if (!yy || !mm || !dd || !strike) {
+        return std::nullopt;
+    }
+    const uint32_t year = (*yy < 80) ? (2000 + *yy) : (1900 + *yy);
+    const std::chrono::year_month_day ymd{std::chrono::year(static_cast<int>(year)),
+                                          std::chrono::month(*mm), std::chrono::day(*dd)};
+    if (!ymd.ok()) {
+        return std::nullopt;
+    }
+    const char cp = symbol[6];
+    if (cp != 'C' && cp != 'P' && cp != 'c' && cp != 'p') {
+        return std::nullopt;
+    }
+    const uint64_t date = uint64_t{year} * 10000 + *mm * 100 + *dd;
+    const uint64_t call = (cp == 'C' || cp == 'c') ? 1 : 0;
+    return OccKey{(date << (OccKey::kStrikeBits + 1)) | (call << OccKey::kStrikeBits) | *strike};
+}
+
+static_assert(parse_occ_key("250219C00500000")->expiry_yyyymmdd() == 20250219);
+static_assert(parse_occ_key("250219C00500000")->strike_thousandths() == 500000);
+static_assert(!parse_occ_key("250230P00500000"));
+
 /** Returns (expiry, strike, option_type) or (nullopt, nullopt, nullopt) if invalid. */
 std::tuple<std::optional<Timestamp>, std::optional<double>, std::optional<utilities::OptionType>>
-parse_occ_symbol(const std::string& symbol);
+parse_occ_symbol(std::string_view symbol);
+
+/**
+ * Standard symbol of key: "<underlying>-YYYYMMDD-CALL|PUT-<whole strike>-<multiplier>", built
+ * in one allocation.
+ */
+std::string occ_standard_symbol(std::string_view underlying, OccKey key, int multiplier);
 
 /** Infer underlying from filename: backtest_<UNDERLYING>_<start>_<end>.parquet */
 std::string infer_underlying_from_filename(const std::string& filename);
@@ -1,13 +1,23 @@
 #include "parquet_loader.hpp"
+#include "thread_pool.hpp"
 #include <algorithm>
 #include <array>
 #include <arrow/api.h>
 #include <arrow/io/api.h>
 #include <chrono>
 #include <filesystem>
+#include <fstream>
+#include <functional>
 #include <iterator>
+#include <limits>
+#include <optional>
 #include <parquet/arrow/reader.h>
+#include <parquet/file_reader.h>
+#include <parquet/metadata.h>
+#include <parquet/statistics.h>
 #include <ranges>
+#include <span>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -31,13 +41,239 @@ auto TsToIso(Timestamp ts) -> std::string {
     return buf.data();
 }
 
+/** Columns TimestepFrameColumnar reads besides the time column. */
+constexpr std::array kFrameColumns{"symbol",
+                                   "bid_px",
+                                   "ask_px",
+                                   "bid_sz",
+                                   "ask_sz",
+                                   "underlying_bid_px",
+                                   "underlying_ask_px",
+                                   "underlying_bid_sz",
+                                   "underlying_ask_sz"};
+
+/** [min, max] of the time column in a row group; unbounded when statistics are missing. */
+auto RowGroupTsBounds(const parquet::RowGroupMetaData& rg, int ts_leaf)
+    -> std::pair<int64_t, int64_t> {
+    std::pair<int64_t, int64_t> bounds{std::numeric_limits<int64_t>::min(),
+                                       std::numeric_limits<int64_t>::max()};
+    const std::unique_ptr<parquet::ColumnChunkMetaData> chunk = rg.ColumnChunk(ts_leaf);
+    if (!chunk || !chunk->is_stats_set()) {
+        return bounds;
+    }
+    const std::shared_ptr<parquet::Statistics> stats = chunk->statistics();
+    if (!stats || !stats->HasMinMax() || stats->physical_type() != parquet::Type::INT64) {
+        return bounds;
+    }
+    const auto& typed = static_cast<const parquet::Int64Statistics&>(*stats);
+    return {typed.min(), typed.max()};
+}
+
+/** Distinct symbols of a string or dictionary<string> column and each row's code (-1 = null). */
+struct SymbolCodes {
+    std::vector<std::string_view> symbols;
+    std::vector<int32_t> row_code;
+};
+
+/** Views point into the column buffers, so the table must outlive the result. */
+auto encode_symbols(const Array* arr) -> SymbolCodes {
+    SymbolCodes out;
+    if (arr == nullptr) {
+        return out;
+    }
+    const int64_t n = arr->length();
+    out.row_code.assign(static_cast<size_t>(n), -1);
+    if (arr->type_id() == Type::DICTIONARY) {
+        const auto* dict_arr = static_cast<const DictionaryArray*>(arr);
+        const std::shared_ptr<Array>& dict = dict_arr->dictionary();
+        if (!dict || dict->type_id() != Type::STRING) {
+            return out;
+        }
+        const auto* values = static_cast<const StringArray*>(dict.get());
+        // Codes follow first use so unreferenced dictionary entries never surface.
+        std::vector<int32_t> remap(static_cast<size_t>(values->length()), -1);
+        for (int64_t i = 0; i < n; ++i) {
+            if (arr->IsNull(i)) {
+                continue;
+            }
+            const int64_t v = dict_arr->GetValueIndex(i);
+            int32_t& code = remap[static_cast<size_t>(v)];
+            if (code < 0) {
+                code = static_cast<int32_t>(out.symbols.size());
+                out.symbols.push_back(values->GetView(v));
+            }
+            out.row_code[static_cast<size_t>(i)] = code;
+        }
+        return out;
+    }
+    if (arr->type_id() != Type::STRING) {
+        return out;
+    }
+    const auto* str_arr = static_cast<const StringArray*>(arr);
+    std::unordered_map<std::string_view, int32_t> codes;
+    for (int64_t i = 0; i < n; ++i) {
+        if (arr->IsNull(i)) {
+            continue;
+        }
+        auto [it, inserted] =
+            codes.try_emplace(str_arr->GetView(i), static_cast<int32_t>(out.symbols.size()));
+        if (inserted) {
+            out.symbols.push_back(it->first);
+        }
+        out.row_code[static_cast<size_t>(i)] = it->second;
+    }
+    return out;
+}
+
+/** Header of <file>.tsidx; order then offsets follow as raw int64. */
+struct SortIndexHeader {
+    std::array<char, 8> magic{'O', 'T', 'S', 'I', 'D', 'X', '0', '1'};
+    int64_t source_size = 0;
+    int64_t source_mtime = 0;
+    int64_t row_count = 0;
+    int64_t range_lo = 0;
+    int64_t range_hi = 0;
+    int64_t order_size = 0;
+    int64_t offsets_size = 0;
+};
+
+auto sort_index_header(std::string const& path, int64_t rows, int64_t lo, int64_t hi)
+    -> std::optional<SortIndexHeader> {
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(path, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    const auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    SortIndexHeader h;
+    h.source_size = static_cast<int64_t>(size);
+    h.source_mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+    h.row_count = rows;
+    h.range_lo = lo;
+    h.range_hi = hi;
+    return h;
+}
+
+auto same_source(const SortIndexHeader& a, const SortIndexHeader& b) -> bool {
+    return a.magic == b.magic && a.source_size == b.source_size &&
+           a.source_mtime == b.source_mtime && a.row_count == b.row_count &&
+           a.range_lo == b.range_lo && a.range_hi == b.range_hi;
+}
+
+auto read_sort_index(std::string const& idx_path, const SortIndexHeader& expect,
+                     std::vector<int64_t>& order, std::vector<int64_t>& offsets) -> bool {
+    std::ifstream in(idx_path, std::ios::binary);
+    SortIndexHeader h;
+    if (!in.read(reinterpret_cast<char*>(&h), sizeof(h)) || !same_source(h, expect) ||
+        h.order_size < 0 || h.order_size > h.row_count || h.offsets_size < 1 ||
+        h.offsets_size > h.order_size + 1) {
+        return false;
+    }
+    order.resize(static_cast<size_t>(h.order_size));
+    offsets.resize(static_cast<size_t>(h.offsets_size));
+    const auto order_bytes = static_cast<std::streamsize>(order.size() * sizeof(int64_t));
+    const auto offsets_bytes = static_cast<std::streamsize>(offsets.size() * sizeof(int64_t));
+    // Groups must be non-empty and rows in range, or iteration would index out of bounds.
+    const auto in_table = [&h](int64_t i) { return i >= 0 && i < h.row_count; };
+    const bool valid = in.read(reinterpret_cast<char*>(order.data()), order_bytes) &&
+                       in.read(reinterpret_cast<char*>(offsets.data()), offsets_bytes) &&
+                       offsets.front() == 0 && offsets.back() == h.order_size &&
+                       std::ranges::adjacent_find(offsets, std::greater_equal{}) == offsets.end() &&
+                       std::ranges::all_of(order, in_table);
+    if (!valid) {
+        order.clear();
+        offsets.clear();
+    }
+    return valid;
+}
+
+void write_sort_index(std::string const& idx_path, SortIndexHeader h,
+                      const std::vector<int64_t>& order, const std::vector<int64_t>& offsets) {
+    h.order_size = static_cast<int64_t>(order.size());
+    h.offsets_size = static_cast<int64_t>(offsets.size());
+    // Write-then-rename so a concurrent reader never sees a partial index.
+    const std::string tmp = idx_path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        out.write(reinterpret_cast<const char*>(order.data()),
+                  static_cast<std::streamsize>(order.size() * sizeof(int64_t)));
+        out.write(reinterpret_cast<const char*>(offsets.data()),
+                  static_cast<std::streamsize>(offsets.size() * sizeof(int64_t)));
+        if (!out) {
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, idx_path, ec);
+}
+
 } // namespace
 
+void ArrowParquetLoader::build_time_index(std::string const& resolved_path) {
+    sorted_ = true;
+    sort_order_.clear();
+    group_offsets_.clear();
+    const Array* ts_arr = detail::ColumnChunk0(table_.get(), time_col_index_);
+    if ((ts_arr == nullptr) || ts_arr->type_id() != Type::TIMESTAMP) {
+        return;
+    }
+    const auto* ts = static_cast<const TimestampArray*>(ts_arr);
+    const int64_t n = ts->length();
+    for (int64_t i = 1; i < n; ++i) {
+        if (ts->Value(i) < ts->Value(i - 1)) {
+            sorted_ = false;
+            break;
+        }
+    }
+    if (sorted_) {
+        return;
+    }
+
+    const std::optional<SortIndexHeader> header =
+        persist_sort_index_ ? sort_index_header(resolved_path, n, range_lo_, range_hi_)
+                            : std::nullopt;
+    const std::string idx_path = resolved_path + ".tsidx";
+    if (header && read_sort_index(idx_path, *header, sort_order_, group_offsets_)) {
+        return;
+    }
+
+    sort_order_.reserve(static_cast<size_t>(n));
+    for (int64_t i = 0; i < n; ++i) {
+        const int64_t t = ts->Value(i);
+        if (t >= range_lo_ && t < range_hi_) {
+            sort_order_.push_back(i);
+        }
+    }
+    std::ranges::stable_sort(sort_order_, {}, [ts](int64_t i) { return ts->Value(i); });
+    group_offsets_.push_back(0);
+    for (size_t k = 1; k < sort_order_.size(); ++k) {
+        if (ts->Value(sort_order_[k]) != ts->Value(sort_order_[k - 1])) {
+            group_offsets_.push_back(static_cast<int64_t>(k));
+        }
+    }
+    if (!sort_order_.empty()) {
+        group_offsets_.push_back(static_cast<int64_t>(sort_order_.size()));
+    }
+    if (header) {
+        write_sort_index(idx_path, *header, sort_order_, group_offsets_);
+    }
+}
+
 bool ArrowParquetLoader::load(std::string const& path, std::string const& time_column) {
     meta_.path = path;
     meta_.time_column = time_column;
+    meta_.row_count = 0;
+    meta_.ts_start.clear();
+    meta_.ts_end.clear();
     table_.reset();
     time_col_index_ = -1;
+    row_slots_.clear();
+    range_lo_ = std::numeric_limits<int64_t>::min();
+    range_hi_ = std::numeric_limits<int64_t>::max();
 
     std::string resolved = path;
     if (!std::filesystem::path(path).is_absolute()) {
@@ -62,30 +298,117 @@ bool ArrowParquetLoader::load(std::string const& path, std::string const& time_c
         return false;
     }
     std::unique_ptr<FileReader> reader = std::move(reader_result).ValueOrDie();
+    std::shared_ptr<parquet::FileMetaData> metadata = reader->parquet_reader()->metadata();
+    std::shared_ptr<Schema> file_schema;
+    PARQUET_THROW_NOT_OK(reader->GetSchema(&file_schema));
+
+    // Projection: frame columns only (flat schema, so leaf index == field index).
+    const parquet::SchemaDescriptor* leaves = metadata->schema();
+    const int ts_leaf = leaves->ColumnIndex(time_column);
+    if (ts_leaf < 0) {
+        return false;
+    }
+    std::vector<int> columns{ts_leaf};
+    for (const char* name : kFrameColumns) {
+        const int leaf = leaves->ColumnIndex(name);
+        if (leaf >= 0 && std::ranges::find(columns, leaf) == columns.end()) {
+            columns.push_back(leaf);
+        }
+    }
+
+    // Time-range pushdown: drop row groups whose ts statistics miss [start, end).
+    const std::shared_ptr<Field> ts_field = file_schema->GetFieldByName(time_column);
+    if (ts_field && ts_field->type()->id() == Type::TIMESTAMP) {
+        const auto unit = std::static_pointer_cast<TimestampType>(ts_field->type())->unit();
+        if (range_start_) {
+            range_lo_ = detail::ChronoToArrowTs(*range_start_, unit);
+        }
+        if (range_end_) {
+            range_hi_ = detail::ChronoToArrowTs(*range_end_, unit);
+        }
+    }
+    std::vector<int> row_groups;
+    for (int rg = 0; rg < metadata->num_row_groups(); ++rg) {
+        auto [lo, hi] = RowGroupTsBounds(*metadata->RowGroup(rg), ts_leaf);
+        if (hi >= range_lo_ && lo < range_hi_) {
+            row_groups.push_back(rg);
+        }
+    }
+
+    // Decode row groups in parallel; each task opens its own reader on the shared mapping.
+    std::vector<std::shared_ptr<Table>> parts(row_groups.size());
+    std::vector<arrow::Status> errors(row_groups.size());
+    utilities::ThreadPool::shared().parallel_for(
+        row_groups.size(),
+        [&](size_t begin, size_t end) -> void {
+            std::unique_ptr<FileReader> part_reader;
+            arrow::Status st = FileReader::Make(
+                default_memory_pool(),
+                parquet::ParquetFileReader::Open(infile, parquet::default_reader_properties(),
+                                                 metadata),
+                &part_reader);
+            for (size_t k = begin; k < end; ++k) {
+                errors[k] = st.ok() ? part_reader->ReadRowGroup(row_groups[k], columns, &parts[k])
+                                    : st;
+            }
+        },
+        1);
+    for (const arrow::Status& st : errors) {
+        PARQUET_THROW_NOT_OK(st);
+    }
 
-    // Read table
     std::shared_ptr<Table> table;
-    PARQUET_THROW_NOT_OK(reader->ReadTable(&table));
+    if (parts.empty()) {
+        std::vector<std::shared_ptr<Field>> fields;
+        fields.reserve(columns.size());
+        for (int leaf : columns) {
+            fields.push_back(file_schema->field(leaf));
+        }
+        table = *Table::MakeEmpty(arrow::schema(std::move(fields)));
+    } else {
+        table = *ConcatenateTables(parts);
+    }
+    // One chunk per column: frames and ColumnChunk0 index the whole table.
+    table = *table->CombineChunks(default_memory_pool());
     if (!table) {
         return false;
     }
-    table_ = table;
-
-    meta_.row_count = table_->num_rows();
-    auto* schema = table_->schema().get();
-    time_col_index_ = schema->GetFieldIndex(time_column);
+    time_col_index_ = table->schema()->GetFieldIndex(time_column);
     if (time_col_index_ < 0) {
         return false;
     }
 
-    if (meta_.row_count > 0) {
-        const Array* ts_arr = detail::ColumnChunk0(table_.get(), time_col_index_);
-        if ((ts_arr != nullptr) && ts_arr->type_id() == Type::TIMESTAMP) {
-            const auto* ts = static_cast<const TimestampArray*>(ts_arr);
-            auto ts_type = std::static_pointer_cast<TimestampType>(ts_arr->type());
-            auto unit = ts_type->unit();
-            meta_.ts_start = TsToIso(detail::ArrowTsToChrono(ts->Value(0), unit));
-            meta_.ts_end = TsToIso(detail::ArrowTsToChrono(ts->Value(ts->length() - 1), unit));
+    // Sorted time column: slice to [start, end) so symbols and slots only see in-range rows.
+    const Array* ts_arr = detail::ColumnChunk0(table.get(), time_col_index_);
+    if ((ts_arr != nullptr) && ts_arr->type_id() == Type::TIMESTAMP && ts_arr->null_count() == 0) {
+        const auto* ts = static_cast<const TimestampArray*>(ts_arr);
+        const std::span<const int64_t> values(ts->raw_values(), static_cast<size_t>(ts->length()));
+        if (std::ranges::is_sorted(values)) {
+            const auto first = std::ranges::lower_bound(values, range_lo_) - values.begin();
+            const auto last = std::ranges::lower_bound(values, range_hi_) - values.begin();
+            table = table->Slice(first, last - first);
+        }
+    }
+    table_ = table;
+    meta_.row_count = table_->num_rows();
+    build_time_index(resolved);
+
+    ts_arr = detail::ColumnChunk0(table_.get(), time_col_index_);
+    if (meta_.row_count > 0 && (ts_arr != nullptr) && ts_arr->type_id() == Type::TIMESTAMP) {
+        const auto* ts = static_cast<const TimestampArray*>(ts_arr);
+        const auto unit = std::static_pointer_cast<TimestampType>(ts_arr->type())->unit();
+        int64_t t_min = std::numeric_limits<int64_t>::max();
+        int64_t t_max = std::numeric_limits<int64_t>::min();
+        for (int64_t i = 0; i < ts->length(); ++i) {
+            const int64_t t = ts->Value(i);
+            if (t >= range_lo_ && t < range_hi_) {
+                t_min = std::min(t_min, t);
+                t_max = std::max(t_max, t);
+            }
+        }
+        if (t_min <= t_max) {
+            meta_.ts_start = TsToIso(detail::ArrowTsToChrono(t_min, unit));
+            meta_.ts_end = TsToIso(detail::ArrowTsToChrono(t_max, unit));
         }
     }
     return true;
@@ -101,21 +424,106 @@ void ArrowParquetLoader::collect_symbols(std::unordered_set<std::string>& out) c
     if (col_sym < 0) {
         return;
     }
-    const Array* arr = detail::ColumnChunk0(table_.get(), col_sym);
-    if ((arr == nullptr) || arr->type_id() != Type::STRING || arr->null_count() == arr->length()) {
+    for (std::string_view s : encode_symbols(detail::ColumnChunk0(table_.get(), col_sym)).symbols) {
+        if (!s.empty()) {
+            out.emplace(s);
+        }
+    }
+}
+
+void ArrowParquetLoader::resolve_row_slots(
+    std::function<int32_t(std::string_view)> const& resolve) {
+    row_slots_.clear();
+    if (!table_) {
+        return;
+    }
+    row_slots_.assign(static_cast<size_t>(table_->num_rows()), -1);
+    const int col_sym = table_->schema()->GetFieldIndex("symbol");
+    if (col_sym < 0) {
         return;
     }
-    const auto* str_arr = static_cast<const StringArray*>(arr);
-    const int64_t n = arr->length();
-    for (int64_t i = 0; i < n; ++i) {
-        if (arr->IsNull(i)) {
-            continue;
+    const SymbolCodes codes = encode_symbols(detail::ColumnChunk0(table_.get(), col_sym));
+    std::vector<int32_t> slot_of_code(codes.symbols.size(), -1);
+    for (size_t c = 0; c < codes.symbols.size(); ++c) {
+        if (!codes.symbols[c].empty()) {
+            slot_of_code[c] = resolve(codes.symbols[c]);
         }
-        std::string s = str_arr->GetString(i);
-        if (!s.empty()) {
-            out.insert(std::move(s));
+    }
+    const size_t n = std::min(row_slots_.size(), codes.row_code.size());
+    for (size_t i = 0; i < n; ++i) {
+        const int32_t code = codes.row_code[i];
+        row_slots_[i] = code < 0 ? -1 : slot_of_code[static_cast<size_t>(code)];
+    }
+}
+
+ArrowParquetLoader::FrameCursor::FrameCursor(const ArrowParquetLoader& loader) : loader_(&loader) {
+    const Table* table = loader.table_.get();
+    if (table == nullptr || loader.time_col_index_ < 0) {
+        return;
+    }
+    const Array* ts_arr = detail::ColumnChunk0(table, loader.time_col_index_);
+    if ((ts_arr == nullptr) || ts_arr->type_id() != Type::TIMESTAMP) {
+        return;
+    }
+    ts_ = static_cast<const TimestampArray*>(ts_arr);
+    unit_ = std::static_pointer_cast<TimestampType>(ts_arr->type())->unit();
+    const auto column = [table](const char* name) -> const Array* {
+        const int col = table->schema()->GetFieldIndex(name);
+        return col >= 0 ? detail::ColumnChunk0(table, col) : nullptr;
+    };
+    frame_.arr_sym = column("symbol");
+    frame_.arr_bid_px = column("bid_px");
+    frame_.arr_ask_px = column("ask_px");
+    frame_.arr_bid_sz = column("bid_sz");
+    frame_.arr_ask_sz = column("ask_sz");
+    frame_.arr_underlying_bid_px = column("underlying_bid_px");
+    frame_.arr_underlying_ask_px = column("underlying_ask_px");
+    frame_.arr_underlying_bid_sz = column("underlying_bid_sz");
+    frame_.arr_underlying_ask_sz = column("underlying_ask_sz");
+    frame_.row_slot = std::cmp_equal(loader.row_slots_.size(), table->num_rows())
+                          ? loader.row_slots_.data()
+                          : nullptr;
+}
+
+auto ArrowParquetLoader::FrameCursor::next() -> const TimestepFrameColumnar* {
+    if (ts_ == nullptr) {
+        return nullptr;
+    }
+    const ArrowParquetLoader& l = *loader_;
+    if (l.sorted_) {
+        const int64_t n = ts_->length();
+        while (row_ < n) {
+            const int64_t t_val = ts_->Value(row_);
+            int64_t j = row_ + 1;
+            while (j < n && ts_->Value(j) == t_val) {
+                ++j;
+            }
+            const int64_t i = row_;
+            row_ = j;
+            if (t_val < l.range_lo_ || t_val >= l.range_hi_) {
+                continue;
+            }
+            frame_.timestamp = detail::ArrowTsToChrono(t_val, unit_);
+            frame_.num_rows = j - i;
+            frame_.start_row = i;
+            frame_.row_indices = {};
+            return &frame_;
         }
+        return nullptr;
+    }
+    // Unsorted: linear walk over the load-time argsort (in-range rows only).
+    if (group_ + 1 >= l.group_offsets_.size()) {
+        return nullptr;
     }
+    const std::span<const int64_t> order(l.sort_order_);
+    const auto begin = static_cast<size_t>(l.group_offsets_[group_]);
+    const auto end = static_cast<size_t>(l.group_offsets_[group_ + 1]);
+    ++group_;
+    frame_.timestamp = detail::ArrowTsToChrono(ts_->Value(order[begin]), unit_);
+    frame_.row_indices = order.subspan(begin, end - begin);
+    frame_.num_rows = static_cast<int64_t>(end - begin);
+    frame_.start_row = 0;
+    return &frame_;
 }
 
 auto make_parquet_loader() -> std::unique_ptr<ArrowParquetLoader> {
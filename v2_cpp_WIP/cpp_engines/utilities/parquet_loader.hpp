@@ -4,12 +4,18 @@
 #include <arrow/api.h>
 #include <concepts>
 #include <cstdint>
+#include <functional>
 #include <iterator>
+#include <limits>
 #include <memory>
+#include <optional>
 #include <ranges>
+#include <span>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace backtest {
@@ -25,7 +31,8 @@ struct TimestepFrameColumnar {
     /// When row_indices is empty, logical row r is table row (start_row + r).
     int64_t start_row = 0;
     /// When non-empty, logical row r is table row row_indices[r]; num_rows == row_indices.size().
-    std::vector<int64_t> row_indices;
+    /// Views the loader's sort order, so it is valid only during the callback.
+    std::span<const int64_t> row_indices;
 
     const arrow::Array* arr_sym = nullptr;
     const arrow::Array* arr_bid_px = nullptr;
@@ -36,6 +43,9 @@ struct TimestepFrameColumnar {
     const arrow::Array* arr_underlying_ask_px = nullptr;
     const arrow::Array* arr_underlying_bid_sz = nullptr;
     const arrow::Array* arr_underlying_ask_sz = nullptr;
+    /// Per table row: slot from ArrowParquetLoader::resolve_row_slots (-1 = none); nullptr if
+    /// never resolved.
+    const int32_t* row_slot = nullptr;
 
     /// Logical row index r (0..num_rows-1) -> physical table row index.
     [[nodiscard]] int64_t row_index(int64_t r) const {
@@ -66,6 +76,22 @@ inline auto ArrowTsToChrono(int64_t value, arrow::TimeUnit::type unit) -> Timest
     return Timestamp{d};
 }
 
+inline auto ChronoToArrowTs(Timestamp ts, arrow::TimeUnit::type unit) -> int64_t {
+    using namespace std::chrono;
+    const auto d = ts.time_since_epoch();
+    switch (unit) {
+    case arrow::TimeUnit::SECOND:
+        return duration_cast<seconds>(d).count();
+    case arrow::TimeUnit::MILLI:
+        return duration_cast<milliseconds>(d).count();
+    case arrow::TimeUnit::MICRO:
+        return duration_cast<microseconds>(d).count();
+    case arrow::TimeUnit::NANO:
+    default:
+        return duration_cast<nanoseconds>(d).count();
+    }
+}
+
 inline auto ColumnChunk0(const arrow::Table* table, int col) -> const arrow::Array* {
     auto c = table->column(col);
     return c->num_chunks() > 0 ? c->chunk(0).get() : nullptr;
@@ -92,100 +118,59 @@ concept TimestepFramePredicate =
  * zero-erasure callbacks. */
 class ArrowParquetLoader {
   public:
+    /**
+     * Reads only the frame columns, row groups in parallel, skipping row groups whose time
+     * statistics fall outside the time range; chunks are combined so frames index one array.
+     */
     [[nodiscard]] bool load(std::string const& path, std::string const& time_column = "ts_recv");
+    /**
+     * Persist the unsorted-file argsort as <file>.tsidx and reuse it on later loads of the same
+     * file (size, mtime, row count and time range must match).
+     */
+    void set_persist_sort_index(bool enabled) { persist_sort_index_ = enabled; }
+    /** [start, end) applied by the next load; nullopt = unbounded. */
+    void set_time_range(std::optional<Timestamp> start, std::optional<Timestamp> end) {
+        range_start_ = start;
+        range_end_ = end;
+    }
     [[nodiscard]] DataMeta get_meta() const;
     void collect_symbols(std::unordered_set<std::string>& out) const;
+    /**
+     * Resolve every row's symbol to a slot once (resolve called per distinct symbol; dictionary
+     * entries reused when the column is dictionary-encoded). Exposed to frames as row_slot.
+     */
+    void resolve_row_slots(std::function<int32_t(std::string_view)> const& resolve);
+    [[nodiscard]] std::span<const int32_t> row_slots() const { return row_slots_; }
+
+    /**
+     * Pull-style timestep iteration, for merging several loaders on one clock: next() yields the
+     * following frame. Frames view the loader's arrays, so they stay valid while the loader is
+     * alive and not reloaded; the returned frame itself is reused by the next call.
+     */
+    class FrameCursor {
+      public:
+        explicit FrameCursor(const ArrowParquetLoader& loader);
+        /** Following timestep (in-range rows only), or nullptr when exhausted. */
+        const TimestepFrameColumnar* next();
+
+      private:
+        const ArrowParquetLoader* loader_;
+        const arrow::TimestampArray* ts_ = nullptr;
+        arrow::TimeUnit::type unit_ = arrow::TimeUnit::NANO;
+        TimestepFrameColumnar frame_;
+        /** Sorted: next table row; unsorted: next group of the argsort. */
+        int64_t row_ = 0;
+        size_t group_ = 0;
+    };
 
     /** Iterate (columnar frame) for each timestep. Callback returns false to stop. F is not
      * type-erased. */
     template <typename F>
         requires FramePredicate<F>
     void iter_timesteps(F&& fn) const {
-        if (!table_ || time_col_index_ < 0) {
-            return;
-        }
-        const arrow::Array* ts_arr = detail::ColumnChunk0(table_.get(), time_col_index_);
-        if ((ts_arr == nullptr) || ts_arr->type_id() != arrow::Type::TIMESTAMP) {
-            return;
-        }
-
-        const auto* ts = static_cast<const arrow::TimestampArray*>(ts_arr);
-        auto ts_type = std::static_pointer_cast<arrow::TimestampType>(ts_arr->type());
-        auto unit = ts_type->unit();
-        const int64_t n = table_->num_rows();
-        int col_sym = table_->schema()->GetFieldIndex("symbol");
-        int col_bid = table_->schema()->GetFieldIndex("bid_px");
-        int col_ask = table_->schema()->GetFieldIndex("ask_px");
-        int col_bid_sz = table_->schema()->GetFieldIndex("bid_sz");
-        int col_ask_sz = table_->schema()->GetFieldIndex("ask_sz");
-        int col_ubid = table_->schema()->GetFieldIndex("underlying_bid_px");
-        int col_uask = table_->schema()->GetFieldIndex("underlying_ask_px");
-        int col_ubid_sz = table_->schema()->GetFieldIndex("underlying_bid_sz");
-        int col_uask_sz = table_->schema()->GetFieldIndex("underlying_ask_sz");
-
-        TimestepFrameColumnar frame;
-        frame.arr_sym = col_sym >= 0 ? detail::ColumnChunk0(table_.get(), col_sym) : nullptr;
-        frame.arr_bid_px = col_bid >= 0 ? detail::ColumnChunk0(table_.get(), col_bid) : nullptr;
-        frame.arr_ask_px = col_ask >= 0 ? detail::ColumnChunk0(table_.get(), col_ask) : nullptr;
-        frame.arr_bid_sz =
-            col_bid_sz >= 0 ? detail::ColumnChunk0(table_.get(), col_bid_sz) : nullptr;
-        frame.arr_ask_sz =
-            col_ask_sz >= 0 ? detail::ColumnChunk0(table_.get(), col_ask_sz) : nullptr;
-        frame.arr_underlying_bid_px =
-            col_ubid >= 0 ? detail::ColumnChunk0(table_.get(), col_ubid) : nullptr;
-        frame.arr_underlying_ask_px =
-            col_uask >= 0 ? detail::ColumnChunk0(table_.get(), col_uask) : nullptr;
-        frame.arr_underlying_bid_sz =
-            col_ubid_sz >= 0 ? detail::ColumnChunk0(table_.get(), col_ubid_sz) : nullptr;
-        frame.arr_underlying_ask_sz =
-            col_uask_sz >= 0 ? detail::ColumnChunk0(table_.get(), col_uask_sz) : nullptr;
-
-        bool non_decreasing = true;
-        for (int64_t i = 1; i < n; ++i) {
-            if (ts->Value(i) < ts->Value(i - 1)) {
-                non_decreasing = false;
-                break;
-            }
-        }
-
-        if (non_decreasing) {
-            int64_t i = 0;
-            while (i < n) {
-                const int64_t t_val = ts->Value(i);
-                int64_t j = i + 1;
-                while (j < n && ts->Value(j) == t_val) {
-                    ++j;
-                }
-
-                frame.timestamp = detail::ArrowTsToChrono(t_val, unit);
-                frame.num_rows = j - i;
-                frame.start_row = i;
-                frame.row_indices.clear();
-                if (!std::invoke(fn, frame)) {
-                    break;
-                }
-                i = j;
-            }
-            return;
-        }
-
-        std::unordered_map<int64_t, std::vector<int64_t>> groups;
-        groups.reserve(static_cast<size_t>(n / 4));
-        for (int64_t i = 0; i < n; ++i) {
-            groups[ts->Value(i)].push_back(i);
-        }
-
-        std::vector<int64_t> sorted_ts;
-        sorted_ts.reserve(groups.size());
-        std::ranges::copy(std::views::keys(groups), std::back_inserter(sorted_ts));
-        std::ranges::sort(sorted_ts);
-
-        for (int64_t t_val : sorted_ts) {
-            frame.timestamp = detail::ArrowTsToChrono(t_val, unit);
-            frame.row_indices = groups[t_val];
-            frame.num_rows = static_cast<int64_t>(frame.row_indices.size());
-            frame.start_row = 0;
-            if (!std::invoke(fn, frame)) {
+        FrameCursor cursor(*this);
+        while (const TimestepFrameColumnar* frame = cursor.next()) {
+            if (!std::invoke(fn, *frame)) {
                 break;
             }
         }
@@ -195,6 +180,21 @@ class ArrowParquetLoader {
     DataMeta meta_;
     std::shared_ptr<arrow::Table> table_;
     int time_col_index_ = -1;
+    std::vector<int32_t> row_slots_;
+    /// Time column non-decreasing; otherwise iteration walks sort_order_ by group_offsets_.
+    bool sorted_ = true;
+    /// Stable argsort of in-range rows by time; group g is [group_offsets_[g], [g + 1]).
+    std::vector<int64_t> sort_order_;
+    std::vector<int64_t> group_offsets_;
+    bool persist_sort_index_ = false;
+
+    /** Fill sorted_ / sort_order_ / group_offsets_ for table_ (from path.tsidx if valid). */
+    void build_time_index(std::string const& resolved_path);
+    std::optional<Timestamp> range_start_;
+    std::optional<Timestamp> range_end_;
+    /// Time range of the loaded table in raw time-column units.
+    int64_t range_lo_ = std::numeric_limits<int64_t>::min();
+    int64_t range_hi_ = std::numeric_limits<int64_t>::max();
 };
 
 std::unique_ptr<ArrowParquetLoader> make_parquet_loader();
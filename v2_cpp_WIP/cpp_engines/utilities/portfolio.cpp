@@ -1,29 +1,143 @@
 #include "portfolio.hpp"
 
-#include "black_scholes.hpp"
+#include "thread_pool.hpp"
 #include <algorithm>
 #include <cmath>
 #include <iterator>
+#include <limits>
 #include <math.h>
+#include <mutex>
 #include <ranges>
-#include <sstream>
+#include <string_view>
 #include <thread>
 
 namespace utilities {
 
+namespace {
+
+/** Per-chunk gather buffers for apply_frame; thread_local so pool workers reuse capacity. */
+struct FrameScratch {
+    std::vector<size_t> lane;
+    std::vector<double> spot, strike, tau, px, prev_px, prev_spot, iv, delta, gamma, theta, vega;
+    std::vector<uint8_t> is_call;
+
+    void clear() {
+        for (auto* v : {&spot, &strike, &tau, &px, &prev_px, &prev_spot, &iv, &delta, &gamma,
+                        &theta, &vega}) {
+            v->clear();
+        }
+        lane.clear();
+        is_call.clear();
+    }
+};
+
+auto frame_scratch() -> FrameScratch& {
+    thread_local FrameScratch scratch;
+    return scratch;
+}
+
+/** "ROOT-YYYYMMDD-..." → chain "ROOT_YYYYMMDD". */
+auto chain_symbol_of(std::string_view sym) -> std::string {
+    const size_t dash = sym.find('-');
+    const std::string_view root = sym.substr(0, dash);
+    const std::string_view expiry =
+        dash == std::string_view::npos ? std::string_view{}
+                                       : sym.substr(dash + 1, sym.find('-', dash + 1) - dash - 1);
+    std::string chain_symbol;
+    chain_symbol.reserve(root.size() + 1 + expiry.size());
+    chain_symbol.append(root).append("_").append(expiry);
+    return chain_symbol;
+}
+
+/** covered_slots clip buffer; swapped with the result, so both keep their capacity. */
+auto clip_scratch() -> std::vector<std::pair<size_t, size_t>>& {
+    thread_local std::vector<std::pair<size_t, size_t>> scratch;
+    return scratch;
+}
+
+auto snapshot_spot(const PortfolioSnapshot& snapshot) -> double {
+    const double bid = snapshot.underlying_bid;
+    const double ask = snapshot.underlying_ask;
+    if (bid > 0.0 || ask > 0.0) {
+        return (bid > 0.0 && ask > 0.0) ? 0.5 * (bid + ask) : (bid > 0.0 ? bid : ask);
+    }
+    return snapshot.underlying_last;
+}
+
+/** (first strike >= s, first strike > s) in ascending strikes; SIZE_MAX pair without a spot. */
+auto otm_split(const std::vector<double>& strikes, double s) -> std::pair<size_t, size_t> {
+    if (s <= 0.0) {
+        return {SIZE_MAX, SIZE_MAX};
+    }
+    return {static_cast<size_t>(std::ranges::lower_bound(strikes, s) - strikes.begin()),
+            static_cast<size_t>(std::ranges::upper_bound(strikes, s) - strikes.begin())};
+}
+
+} // namespace
+
 OptionData::OptionData(const ContractData& contract)
-    : symbol(contract.symbol), exchange(contract.exchange), size(contract.size),
-      strike_price(contract.option_strike), chain_index(contract.option_index),
+    : symbol(contract.symbol), symbol_id(intern_symbol(contract.symbol)),
+      exchange(contract.exchange), size(contract.size), strike_price(contract.option_strike),
+      chain_index(contract.option_index),
       option_type(contract.option_type == OptionType::CALL ? 1 : -1),
       option_expiry(contract.option_expiry) {}
 
+auto ChainScope::contains(std::string_view chain_symbol) const -> bool {
+    return all() || std::ranges::binary_search(chains, chain_symbol, std::less<>{});
+}
+
+auto OptionColumns::push_back(double strike_price) -> size_t {
+    for (auto* c : {&bid, &ask, &mid, &iv, &delta, &gamma, &theta, &vega, &tau}) {
+        c->push_back(0.0);
+    }
+    strike.push_back(strike_price);
+    return bid.size() - 1;
+}
+
+void OptionColumns::reserve(size_t n) {
+    for (auto* c : {&bid, &ask, &mid, &iv, &delta, &gamma, &theta, &vega, &strike, &tau}) {
+        c->reserve(n);
+    }
+}
+
+void OptionColumns::permute(const std::vector<size_t>& order) {
+    std::vector<double> tmp(order.size());
+    for (auto* c : {&bid, &ask, &mid, &iv, &delta, &gamma, &theta, &vega, &strike, &tau}) {
+        for (size_t i = 0; i < order.size(); ++i) {
+            tmp[i] = (*c)[order[i]];
+        }
+        c->swap(tmp);
+        tmp.resize(order.size());
+    }
+}
+
+void OptionData::set_quote(double bid, double ask, double mid) {
+    if (columns == nullptr) {
+        return;
+    }
+    columns->bid[slot] = bid;
+    columns->ask[slot] = ask;
+    columns->mid[slot] = mid;
+}
+
+void OptionData::set_greeks(double iv, double delta, double gamma, double theta, double vega) {
+    if (columns == nullptr) {
+        return;
+    }
+    columns->iv[slot] = iv;
+    columns->delta[slot] = delta;
+    columns->gamma[slot] = gamma;
+    columns->theta[slot] = theta;
+    columns->vega[slot] = vega;
+}
+
 void OptionData::set_portfolio(PortfolioData* p) { portfolio = p; }
 void OptionData::set_chain(ChainData* c) { chain = c; }
 void OptionData::set_underlying(UnderlyingData* u) { underlying = u; }
 
 UnderlyingData::UnderlyingData(const ContractData& contract)
-    : symbol(contract.symbol), exchange(contract.exchange), size(contract.size),
-      theo_delta(contract.size) {}
+    : symbol(contract.symbol), symbol_id(intern_symbol(contract.symbol)),
+      exchange(contract.exchange), size(contract.size), theo_delta(contract.size) {}
 
 void UnderlyingData::set_portfolio(PortfolioData* p) { portfolio = p; }
 
@@ -34,6 +148,9 @@ void UnderlyingData::update_underlying_tick(const TickData& tick_data) {
     bid_price = tick_data.bid_price_1;
     ask_price = tick_data.ask_price_1;
     mid_price = (tick_data.bid_price_1 + tick_data.ask_price_1) / 2.0;
+    for (auto& [_, chain] : chains) {
+        chain->refresh_delta_on_spot();
+    }
 }
 
 ChainData::ChainData(std::string chain_symbol_) : chain_symbol(std::move(chain_symbol_)) {}
@@ -55,39 +172,81 @@ void ChainData::add_option(OptionData* option) {
             indexes.push_back(idx);
         }
     }
-    if (days_to_expiry == 0 && option->option_expiry) {
+    if (!expiry && option->option_expiry) {
+        expiry = option->option_expiry;
         // Use portfolio-level DTE reference if available; otherwise fall back to "now".
-        auto ref_now = std::chrono::system_clock::now();
-        if (portfolio != nullptr) {
-            ref_now = portfolio->dte_ref();
-        }
-        auto diff_hours =
-            std::chrono::duration_cast<std::chrono::hours>(*option->option_expiry - ref_now)
-                .count();
-        days_to_expiry = diff_hours > 0 ? static_cast<int>(diff_hours / 24) : 0;
-        time_to_expiry = static_cast<double>(days_to_expiry) / ANNUAL_DAYS;
+        refresh_expiry(portfolio != nullptr ? portfolio->dte_ref()
+                                            : std::chrono::system_clock::now());
     }
 }
 
-void ChainData::sort_indexes() {
-    if (indexes.empty()) {
+void ChainData::refresh_expiry(DateTime now) {
+    if (!expiry) {
         return;
     }
-    try {
-        std::vector<std::pair<double, std::string>> tmp;
-        tmp.reserve(indexes.size());
-        for (const auto& s : indexes) {
-            tmp.emplace_back(std::stod(s), s);
+    tau = years_to_expiry(now, expiry);
+    auto diff_hours = std::chrono::duration_cast<std::chrono::hours>(*expiry - now).count();
+    days_to_expiry = diff_hours > 0 ? static_cast<int>(diff_hours / 24) : 0;
+    time_to_expiry = static_cast<double>(days_to_expiry) / ANNUAL_DAYS;
+}
+
+void ChainData::sort_indexes() {
+    if (!indexes.empty()) {
+        try {
+            std::vector<std::pair<double, std::string>> tmp;
+            tmp.reserve(indexes.size());
+            for (const auto& s : indexes) {
+                tmp.emplace_back(std::stod(s), s);
+            }
+            std::ranges::sort(
+                tmp, [](const auto& a, const auto& b) -> auto { return a.first < b.first; });
+            indexes.clear();
+            for (auto& p : tmp) {
+                indexes.push_back(std::move(p.second));
+            }
+        } catch (...) {
+            std::ranges::sort(indexes);
         }
-        std::ranges::sort(tmp,
-                          [](const auto& a, const auto& b) -> auto { return a.first < b.first; });
-        indexes.clear();
-        for (auto& p : tmp) {
-            indexes.push_back(std::move(p.second));
+    }
+
+    struct StrikeEntry {
+        double strike;
+        OptionData* call;
+        OptionData* put;
+        int pos;
+    };
+    std::vector<StrikeEntry> entries;
+    entries.reserve(indexes.size());
+    for (size_t i = 0; i < indexes.size(); ++i) {
+        auto cit = calls.find(indexes[i]);
+        auto pit = puts.find(indexes[i]);
+        OptionData* call = cit != calls.end() ? cit->second : nullptr;
+        OptionData* put = pit != puts.end() ? pit->second : nullptr;
+        const OptionData* ref = (call != nullptr && call->strike_price) ? call : put;
+        if (ref != nullptr && ref->strike_price) {
+            entries.push_back({*ref->strike_price, call, put, static_cast<int>(i)});
         }
-    } catch (...) {
-        std::ranges::sort(indexes);
     }
+    std::ranges::stable_sort(entries, {}, &StrikeEntry::strike);
+    strikes.clear();
+    strike_calls.clear();
+    strike_puts.clear();
+    strike_index_pos.clear();
+    for (const StrikeEntry& e : entries) {
+        strikes.push_back(e.strike);
+        strike_calls.push_back(e.call);
+        strike_puts.push_back(e.put);
+        strike_index_pos.push_back(e.pos);
+    }
+    atm_index = -1;
+    atm_price = 0;
+}
+
+auto ChainData::atm_index_name() const -> const std::string* {
+    if (atm_index < 0) {
+        return nullptr;
+    }
+    return &indexes[strike_index_pos[atm_index]];
 }
 
 void ChainData::update_option_chain(const ChainMarketData& market_data) {
@@ -98,17 +257,13 @@ void ChainData::update_option_chain(const ChainMarketData& market_data) {
         auto it = options.find(sym);
         if (it != options.end()) {
             OptionData* opt = it->second;
-            opt->bid_price = opt_md.bid_price;
-            opt->ask_price = opt_md.ask_price;
-            opt->mid_price = opt_md.last_price;
-            opt->delta = opt_md.delta * opt->size;
-            opt->gamma = opt_md.gamma * opt->size;
-            opt->theta = opt_md.theta * opt->size;
-            opt->vega = opt_md.vega * opt->size;
-            opt->mid_iv = opt_md.mid_iv;
+            opt->set_quote(opt_md.bid_price, opt_md.ask_price, opt_md.last_price);
+            opt->set_greeks(opt_md.mid_iv, opt_md.delta * opt->size, opt_md.gamma * opt->size,
+                            opt_md.theta * opt->size, opt_md.vega * opt->size);
         }
     }
     calculate_atm_price();
+    refresh_delta_index();
 }
 
 void ChainData::set_underlying(UnderlyingData* u) {
@@ -122,54 +277,37 @@ void ChainData::set_underlying(UnderlyingData* u) {
 void ChainData::set_portfolio(PortfolioData* p) { portfolio = p; }
 
 void ChainData::calculate_atm_price() {
-    std::vector<std::pair<double, std::string>> strike_entries;
-    std::unordered_set<std::string> seen;
-    for (const auto& [idx, opt] : calls) {
-        if (opt->strike_price && seen.insert(idx).second) {
-            strike_entries.emplace_back(*opt->strike_price, idx);
-        }
-    }
-    for (const auto& [idx, opt] : puts) {
-        if (opt->strike_price && seen.insert(idx).second) {
-            strike_entries.emplace_back(*opt->strike_price, idx);
-        }
-    }
-    if (strike_entries.empty()) {
+    if (strikes.empty()) {
         atm_price = 0;
-        atm_index.clear();
+        atm_index = -1;
         return;
     }
-    double underlying_price = (underlying != nullptr) ? underlying->mid_price : 0;
-    double selected_strike = NAN;
-    std::string selected_index;
+    const double underlying_price = (underlying != nullptr) ? underlying->mid_price : 0;
+    size_t slot = strikes.size() / 2;
     if (underlying_price > 0) {
-        auto best = std::ranges::min_element(
-            strike_entries, [underlying_price](const auto& a, const auto& b) -> auto {
-                return std::abs(a.first - underlying_price) < std::abs(b.first - underlying_price);
-            });
-        selected_strike = best->first;
-        selected_index = best->second;
-    } else {
-        std::ranges::sort(strike_entries);
-        size_t mid = strike_entries.size() / 2;
-        selected_strike = strike_entries[mid].first;
-        selected_index = strike_entries[mid].second;
+        // Nearest strike; ties go to the lower one.
+        slot = std::ranges::lower_bound(strikes, underlying_price) - strikes.begin();
+        if (slot == strikes.size() ||
+            (slot > 0 &&
+             underlying_price - strikes[slot - 1] <= strikes[slot] - underlying_price)) {
+            --slot;
+        }
     }
-    atm_price = selected_strike;
-    atm_index = selected_index;
+    atm_price = strikes[slot];
+    atm_index = static_cast<int>(slot);
 }
 
 auto ChainData::get_atm_iv() const -> std::optional<double> {
-    if (atm_index.empty()) {
+    if (atm_index < 0) {
         return std::nullopt;
     }
-    auto cit = calls.find(atm_index);
-    if (cit != calls.end() && cit->second->mid_iv != 0) {
-        return cit->second->mid_iv;
+    const OptionData* call = strike_calls[atm_index];
+    if (call != nullptr && call->mid_iv() != 0) {
+        return call->mid_iv();
     }
-    auto pit = puts.find(atm_index);
-    if (pit != puts.end() && pit->second->mid_iv != 0) {
-        return pit->second->mid_iv;
+    const OptionData* put = strike_puts[atm_index];
+    if (put != nullptr && put->mid_iv() != 0) {
+        return put->mid_iv();
     }
     return std::nullopt;
 }
@@ -179,7 +317,7 @@ auto ChainData::best_iv(const std::unordered_map<std::string, OptionData*>& opti
     double min_diff = 1e30;
     std::optional<double> best;
     for (const auto& [_, opt] : options_map) {
-        if ((opt == nullptr) || opt->mid_iv == 0 || !opt->strike_price ||
+        if ((opt == nullptr) || opt->mid_iv() == 0 || !opt->strike_price ||
             (opt->underlying == nullptr)) {
             continue;
         }
@@ -191,27 +329,93 @@ auto ChainData::best_iv(const std::unordered_map<std::string, OptionData*>& opti
             continue;
         }
         double size = opt->size != 0 ? opt->size : 1.0;
-        double d = opt->delta / size;
+        double d = opt->delta() / size;
         double diff = std::abs(std::abs(d) - target);
         if (diff < min_diff) {
             min_diff = diff;
-            best = opt->mid_iv;
+            best = opt->mid_iv();
         }
     }
     return best;
 }
 
 auto ChainData::get_skew(double delta_target) const -> std::optional<double> {
-    double target = delta_target / 100.0;
-    auto call_iv = best_iv(calls, target);
-    auto put_iv = best_iv(puts, target);
-    if (!call_iv || !put_iv || *put_iv == 0) {
+    const double target = delta_target / 100.0;
+    const OptionData* call = nearest_delta(true, target);
+    const OptionData* put = nearest_delta(false, target);
+    if (call == nullptr || put == nullptr) {
         return std::nullopt;
     }
-    return *call_iv / *put_iv;
+    return call->mid_iv() / put->mid_iv();
 }
 
-PortfolioData::PortfolioData(std::string name_) : name(std::move(name_)) {
+void ChainData::refresh_delta_on_spot() {
+    if (otm_split(strikes, underlying != nullptr ? underlying->mid_price : 0.0) != delta_split) {
+        refresh_delta_index();
+    }
+}
+
+void ChainData::refresh_delta_index() {
+    otm_calls_by_delta.clear();
+    otm_puts_by_delta.clear();
+    const double s = (underlying != nullptr) ? underlying->mid_price : 0.0;
+    delta_split = otm_split(strikes, s);
+    if (s <= 0.0) {
+        return;
+    }
+    // Strikes ascend, so OTM puts are [0, split) and OTM calls are [split, n).
+    const size_t split = delta_split.second;
+    const auto push = [](std::vector<DeltaEntry>& out, OptionData* opt) -> void {
+        if (opt == nullptr || opt->mid_iv() == 0) {
+            return;
+        }
+        const double size = opt->size != 0 ? opt->size : 1.0;
+        out.push_back({std::abs(opt->delta() / size), opt});
+    };
+    for (size_t i = 0; i < strikes.size(); ++i) {
+        if (i >= split) {
+            push(otm_calls_by_delta, strike_calls[i]);
+        } else if (strikes[i] < s) {
+            push(otm_puts_by_delta, strike_puts[i]);
+        }
+    }
+    std::ranges::sort(otm_calls_by_delta, {}, &DeltaEntry::abs_delta);
+    std::ranges::sort(otm_puts_by_delta, {}, &DeltaEntry::abs_delta);
+}
+
+auto ChainData::nearest_delta(bool call, double target) const -> OptionData* {
+    const std::vector<DeltaEntry>& idx = call ? otm_calls_by_delta : otm_puts_by_delta;
+    if (idx.empty()) {
+        return nullptr;
+    }
+    auto it = std::ranges::lower_bound(idx, target, {}, &DeltaEntry::abs_delta);
+    if (it == idx.end() ||
+        (it != idx.begin() && target - std::prev(it)->abs_delta <= it->abs_delta - target)) {
+        --it;
+    }
+    return it->option;
+}
+
+auto ChainData::iv_at_delta(bool call, double target) const -> std::optional<double> {
+    const std::vector<DeltaEntry>& idx = call ? otm_calls_by_delta : otm_puts_by_delta;
+    if (idx.empty()) {
+        return std::nullopt;
+    }
+    auto hi = std::ranges::lower_bound(idx, target, {}, &DeltaEntry::abs_delta);
+    if (hi == idx.begin()) {
+        return hi->option->mid_iv();
+    }
+    if (hi == idx.end()) {
+        return idx.back().option->mid_iv();
+    }
+    const DeltaEntry& lo = *std::prev(hi);
+    const double span = hi->abs_delta - lo.abs_delta;
+    const double w = span > 0.0 ? (target - lo.abs_delta) / span : 0.0;
+    return lo.option->mid_iv() + w * (hi->option->mid_iv() - lo.option->mid_iv());
+}
+
+PortfolioData::PortfolioData(std::string name_, ThreadPool* thread_pool)
+    : name(std::move(name_)), thread_pool_(thread_pool) {
     dte_ref_ = std::chrono::system_clock::now();
 }
 
@@ -221,17 +425,28 @@ void PortfolioData::set_risk_free_rate(double rate) {
     }
 }
 
-void PortfolioData::set_iv_price_mode(std::string mode) {
-    std::ranges::transform(mode, mode.begin(), [](unsigned char c) -> char {
-        return static_cast<char>(std::tolower(c));
-    });
-    if (mode == "mid" || mode == "bid" || mode == "ask") {
-        iv_price_mode_ = std::move(mode);
+void PortfolioData::set_iv_price_mode(const std::string& mode) {
+    if (auto parsed = parse_iv_price_mode(mode)) {
+        iv_price_mode_ = *parsed;
     }
 }
 
 void PortfolioData::set_dte_ref(DateTime ref) { dte_ref_ = ref; }
 
+void PortfolioData::set_greeks_enabled(bool enabled) { greeks_enabled_ = enabled; }
+
+void PortfolioData::set_incremental(bool enabled, double price_epsilon, double tau_epsilon) {
+    incremental_ = enabled;
+    price_epsilon_ = std::isfinite(price_epsilon) ? std::max(0.0, price_epsilon) : 0.0;
+    tau_epsilon_ = std::isfinite(tau_epsilon) ? std::max(0.0, tau_epsilon) : 0.0;
+}
+
+void PortfolioData::set_surface_fit(bool enabled, double liquid_band, double max_spread) {
+    surface_fit_ = enabled;
+    surface_band_ = std::isfinite(liquid_band) ? std::max(0.0, liquid_band) : 0.0;
+    surface_max_spread_ = std::isfinite(max_spread) ? std::max(0.0, max_spread) : 0.0;
+}
+
 void PortfolioData::update_option_chain(const ChainMarketData& market_data) {
     auto it = chains.find(market_data.chain_symbol);
     if (it != chains.end() && it->second) {
@@ -245,96 +460,652 @@ void PortfolioData::update_underlying_tick(const TickData& tick_data) const {
     }
 }
 
+template <IvPriceMode M, bool Greeks, bool Incremental, bool Surface>
+auto PortfolioData::apply_chunk(const QuoteView& quotes, double spot,
+                                std::span<const double> tau_now, size_t start, size_t end,
+                                IvBatchStats& stats) -> size_t {
+    const auto moved = [](double a, double b, double eps) -> bool {
+        return !(std::abs(a - b) <= eps);
+    };
+    double liquid_lo = 0.0;
+    double liquid_hi = 0.0;
+    if constexpr (Surface) {
+        liquid_lo = spot * std::exp(-surface_band_);
+        liquid_hi = spot * std::exp(surface_band_);
+    }
+    // Gather dirty slots into SoA scratch for the batch IV and Greeks kernels.
+    FrameScratch& ws = frame_scratch();
+    ws.clear();
+    for (size_t i = start; i < end; ++i) {
+        const OptionData* opt = option_apply_order_[i];
+        if (opt == nullptr) {
+            continue;
+        }
+        const double bid = quotes.bid[i];
+        const double ask = quotes.ask[i];
+        columns.bid[i] = bid;
+        columns.ask[i] = ask;
+        columns.mid[i] =
+            (bid > 0.0 && ask > 0.0) ? 0.5 * (bid + ask) : (bid > 0.0 ? bid : quotes.last[i]);
+        const double t = tau_now[i];
+        const double k = columns.strike[i];
+        if constexpr (Surface) {
+            // Wings and one-sided or wide quotes are valued from the chain surface instead.
+            const bool liquid = bid > 0.0 && ask >= bid &&
+                                ask - bid <= surface_max_spread_ * 0.5 * (bid + ask) &&
+                                k >= liquid_lo && k <= liquid_hi;
+            surface_slot_[i] = liquid ? 0 : 1;
+            if (!liquid) {
+                continue;
+            }
+        }
+        if constexpr (Incremental) {
+            if (!moved(bid, calc_bid_[i], price_epsilon_) &&
+                !moved(ask, calc_ask_[i], price_epsilon_) &&
+                !moved(spot, calc_spot_[i], price_epsilon_) &&
+                !moved(t, columns.tau[i], tau_epsilon_)) {
+                continue;
+            }
+        }
+        const bool valid = spot > 0.0 && k > 0.0 && t > 0.0;
+        ws.lane.push_back(i);
+        ws.spot.push_back(spot);
+        ws.strike.push_back(k);
+        ws.tau.push_back(t);
+        ws.is_call.push_back(opt->option_type > 0 ? 1 : 0);
+        ws.px.push_back(valid ? pick_iv_input_price<M>(bid, ask) : 0.0);
+        ws.prev_px.push_back(calc_px_[i]);
+        ws.prev_spot.push_back(calc_spot_[i]);
+        ws.iv.push_back(columns.iv[i]);
+        calc_bid_[i] = bid;
+        calc_ask_[i] = ask;
+    }
+    const size_t m = ws.lane.size();
+    stats = implied_volatility_batch({.price = ws.px,
+                                      .spot = ws.spot,
+                                      .strike = ws.strike,
+                                      .tau = ws.tau,
+                                      .is_call = ws.is_call,
+                                      .prev_price = ws.prev_px,
+                                      .prev_spot = ws.prev_spot,
+                                      .prev_iv = ws.iv},
+                                     ws.iv);
+    ws.delta.assign(m, 0.0);
+    ws.gamma.assign(m, 0.0);
+    ws.theta.assign(m, 0.0);
+    ws.vega.assign(m, 0.0);
+    if constexpr (Greeks) {
+        bs_greeks_batch({.spot = ws.spot,
+                         .strike = ws.strike,
+                         .tau = ws.tau,
+                         .sigma = ws.iv,
+                         .is_call = ws.is_call,
+                         .risk_free_rate = risk_free_rate_},
+                        {.delta = ws.delta, .gamma = ws.gamma, .theta = ws.theta, .vega = ws.vega});
+    }
+    for (size_t j = 0; j < m; ++j) {
+        const size_t i = ws.lane[j];
+        const double size = option_apply_order_[i]->size;
+        const double sz = size != 0.0 ? size : 1.0;
+        columns.tau[i] = ws.tau[j];
+        columns.iv[i] = ws.iv[j];
+        columns.delta[i] = ws.delta[j] * sz;
+        columns.gamma[i] = ws.gamma[j] * sz;
+        columns.theta[i] = ws.theta[j] * sz;
+        columns.vega[i] = ws.vega[j] * sz;
+        calc_px_[i] = ws.px[j];
+        calc_spot_[i] = spot;
+    }
+    return m;
+}
+
+template <IvPriceMode M, bool Greeks>
+auto PortfolioData::select_apply_kernel(bool incremental, bool surface) -> ApplyKernel {
+    if (incremental) {
+        return surface ? &PortfolioData::apply_chunk<M, Greeks, true, true>
+                       : &PortfolioData::apply_chunk<M, Greeks, true, false>;
+    }
+    return surface ? &PortfolioData::apply_chunk<M, Greeks, false, true>
+                   : &PortfolioData::apply_chunk<M, Greeks, false, false>;
+}
+
+template <IvPriceMode M>
+auto PortfolioData::select_apply_kernel(bool greeks, bool incremental, bool surface)
+    -> ApplyKernel {
+    return greeks ? select_apply_kernel<M, true>(incremental, surface)
+                  : select_apply_kernel<M, false>(incremental, surface);
+}
+
+auto PortfolioData::select_apply_kernel(IvPriceMode mode, bool greeks, bool incremental,
+                                        bool surface) -> ApplyKernel {
+    switch (mode) {
+        using enum IvPriceMode;
+    case BID:
+        return select_apply_kernel<BID>(greeks, incremental, surface);
+    case ASK:
+        return select_apply_kernel<ASK>(greeks, incremental, surface);
+    case MID:
+        break;
+    }
+    return select_apply_kernel<IvPriceMode::MID>(greeks, incremental, surface);
+}
+
 void PortfolioData::apply_frame(const PortfolioSnapshot& snapshot) {
+    apply_working(snapshot);
+    publish();
+}
+
+auto PortfolioData::pin() const -> MarketView {
+    while (true) {
+        const uint32_t front = front_.load(std::memory_order_seq_cst);
+        const MarketBuffer& buffer = published_[front];
+        buffer.pins.fetch_add(1, std::memory_order_seq_cst);
+        // Still the front: the writer checks pins before it touches a buffer, so this one holds.
+        if (front_.load(std::memory_order_seq_cst) == front) {
+            return MarketView(&buffer);
+        }
+        buffer.pins.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void PortfolioData::publish() {
+    const uint32_t back = 1U - front_.load(std::memory_order_relaxed);
+    MarketBuffer& buffer = published_[back];
+    // Only a reader that pinned it before the last swap can hold it; views are short-lived.
+    while (buffer.pins.load(std::memory_order_seq_cst) != 0) {
+        std::this_thread::yield();
+    }
+    const size_t n = columns.size();
+    if (buffer.columns.size() != n || slot_frame_.size() != n) {
+        buffer.columns = columns;
+    } else {
+        // The back buffer is one frame behind the front: copy what changed since it was current.
+        buffer.columns.tau = columns.tau;
+        for (size_t i = 0; i < n; ++i) {
+            if (slot_frame_[i] <= buffer.frame) {
+                continue;
+            }
+            for (auto field : {&OptionColumns::bid, &OptionColumns::ask, &OptionColumns::mid,
+                               &OptionColumns::iv, &OptionColumns::delta, &OptionColumns::gamma,
+                               &OptionColumns::theta, &OptionColumns::vega,
+                               &OptionColumns::strike}) {
+                (buffer.columns.*field)[i] = (columns.*field)[i];
+            }
+        }
+    }
+    if (underlying) {
+        buffer.underlying_bid = underlying->bid_price;
+        buffer.underlying_ask = underlying->ask_price;
+        buffer.underlying_mid = underlying->mid_price;
+    }
+    buffer.frame = frame_seq_;
+    front_.store(back, std::memory_order_seq_cst);
+}
+
+void PortfolioData::apply_working(const PortfolioSnapshot& snapshot) {
+    adopt_active_chains();
     if (underlying) {
         underlying->bid_price = snapshot.underlying_bid;
         underlying->ask_price = snapshot.underlying_ask;
         underlying->mid_price = snapshot.underlying_last;
     }
     const size_t n = option_apply_order_.size();
-    if (n != snapshot.bid.size()) {
+    if (!snapshot.sparse && n != snapshot.bid.size()) {
+        return;
+    }
+    const double spot = snapshot_spot(snapshot);
+
+    if (columns.size() < n) {
+        return; // finalize_chains not run since the last add_option
+    }
+    QuoteView quotes{.bid = snapshot.bid, .ask = snapshot.ask, .last = snapshot.last};
+    if (snapshot.sparse) {
+        if (!scatter_sparse_quotes(snapshot)) {
+            return;
+        }
+        ++frame_seq_;
+        for (const uint32_t slot : snapshot.slots) {
+            mark_slots(slot, std::min<size_t>(slot + 1, n));
+        }
+        // Scattered columns now hold the full quote state; the kernel reads them back in place.
+        quotes = {.bid = std::span(columns.bid.data(), n),
+                  .ask = std::span(columns.ask.data(), n),
+                  .last = std::span(columns.mid.data(), n)};
+    } else if (snapshot.has_greeks && snapshot.iv.size() == n && greeks_cover_active(snapshot)) {
+        ++frame_seq_;
+        mark_slots(0, n);
+        apply_precomputed_greeks(snapshot);
+        return;
+    } else {
+        ++frame_seq_;
+    }
+    if (calc_px_.size() != n) {
+        // NaN never compares within epsilon, so every slot is dirty on the first frame.
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        calc_bid_.assign(n, nan);
+        calc_ask_.assign(n, nan);
+        calc_spot_.assign(n, nan);
+        calc_px_.assign(n, 0.0);
+    }
+    tau_now_.assign(n, 0.0);
+    const std::span<const double> tau_now(tau_now_);
+    refresh_slot_tau(snapshot.datetime, tau_now_);
+    std::mutex stats_mutex;
+    iv_stats_ = {};
+    recomputed_ = 0;
+
+    if (surface_fit_ && surface_slot_.size() != n) {
+        surface_slot_.assign(n, 0);
+    }
+    const ApplyKernel kernel =
+        select_apply_kernel(iv_price_mode_, greeks_enabled_, incremental_, surface_fit_);
+    ThreadPool& pool = (thread_pool_ != nullptr) ? *thread_pool_ : ThreadPool::shared();
+    covered_slots(snapshot, covered_);
+    if (!active_.all()) {
+        // Inactive chains still take this frame's quotes (fills and marks read them), no IV.
+        clip_to_active(snapshot.sparse ? nullptr : &quotes, covered_);
+    }
+    size_t uncovered_begin = 0;
+    for (const auto& [begin, end] : covered_) {
+        if (spot_refresh_ && greeks_enabled_) {
+            refresh_uncovered(spot, tau_now, uncovered_begin, begin);
+        }
+        mark_slots(begin, end);
+        uncovered_begin = end;
+        pool.parallel_for(end - begin, [&](size_t start, size_t stop) -> void {
+            IvBatchStats st;
+            const size_t m =
+                (this->*kernel)(quotes, spot, tau_now, begin + start, begin + stop, st);
+            std::scoped_lock lk(stats_mutex);
+            iv_stats_.reused += st.reused;
+            iv_stats_.warm += st.warm;
+            iv_stats_.cold += st.cold;
+            recomputed_ += m;
+        });
+    }
+    surface_filled_ = 0;
+    if (surface_fit_) {
+        fit_surfaces(spot, tau_now, covered_);
+    }
+    if (spot_refresh_ && greeks_enabled_) {
+        refresh_uncovered(spot, tau_now, uncovered_begin, n);
+    }
+
+    refresh_chain_indexes();
+}
+
+void PortfolioData::fit_surfaces(double spot, std::span<const double> tau_now,
+                                 std::span<const std::pair<size_t, size_t>> ranges) {
+    if (!(spot > 0.0)) {
+        return;
+    }
+    const size_t n = option_apply_order_.size();
+    FrameScratch& ws = frame_scratch();
+    ws.clear();
+    // Fit points reuse prev_px (ln K/F) and prev_spot (total variance); both unused here.
+    std::vector<double>& fit_k = ws.prev_px;
+    std::vector<double>& fit_w = ws.prev_spot;
+    for (auto& [_, chain] : chains) {
+        if (!chain || chain->slot_begin >= chain->slot_end || chain->slot_end > n ||
+            std::ranges::none_of(ranges, [&chain](const auto& r) -> bool {
+                return r.first <= chain->slot_begin && chain->slot_end <= r.second;
+            })) {
+            continue;
+        }
+        fit_k.clear();
+        fit_w.clear();
+        for (size_t i = chain->slot_begin; i < chain->slot_end; ++i) {
+            const OptionData* opt = option_apply_order_[i];
+            const double t = tau_now[i];
+            const double iv = columns.iv[i];
+            if (opt == nullptr || surface_slot_[i] != 0 || !(iv > 0.0) || !(t > 0.0)) {
+                continue;
+            }
+            const double forward = spot * std::exp(risk_free_rate_ * t);
+            const double strike = columns.strike[i];
+            // One smile: only the out-of-the-money side of each strike.
+            if ((opt->option_type > 0) != (strike >= forward)) {
+                continue;
+            }
+            fit_k.push_back(std::log(strike / forward));
+            fit_w.push_back(iv * iv * t);
+        }
+        const SviParams fitted = fit_svi(fit_k, fit_w, chain->svi);
+        if (fitted.valid) {
+            chain->svi = fitted; // too few liquid strikes: keep the last smile
+        }
+        for (size_t i = chain->slot_begin; i < chain->slot_end; ++i) {
+            const OptionData* opt = option_apply_order_[i];
+            if (opt == nullptr || surface_slot_[i] == 0) {
+                continue;
+            }
+            const double t = tau_now[i];
+            const double strike = columns.strike[i];
+            const double forward = spot * std::exp(risk_free_rate_ * t);
+            ws.lane.push_back(i);
+            ws.spot.push_back(spot);
+            ws.strike.push_back(strike);
+            ws.tau.push_back(t);
+            ws.iv.push_back(chain->svi.valid && strike > 0.0
+                                ? chain->svi.implied_vol(std::log(strike / forward), t)
+                                : 0.0);
+            ws.is_call.push_back(opt->option_type > 0 ? 1 : 0);
+        }
+    }
+    const size_t m = ws.lane.size();
+    ws.delta.assign(m, 0.0);
+    ws.gamma.assign(m, 0.0);
+    ws.theta.assign(m, 0.0);
+    ws.vega.assign(m, 0.0);
+    if (greeks_enabled_) {
+        bs_greeks_batch({.spot = ws.spot,
+                         .strike = ws.strike,
+                         .tau = ws.tau,
+                         .sigma = ws.iv,
+                         .is_call = ws.is_call,
+                         .risk_free_rate = risk_free_rate_},
+                        {.delta = ws.delta, .gamma = ws.gamma, .theta = ws.theta, .vega = ws.vega});
+    }
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    for (size_t j = 0; j < m; ++j) {
+        const size_t i = ws.lane[j];
+        const double size = option_apply_order_[i]->size;
+        const double sz = size != 0.0 ? size : 1.0;
+        columns.tau[i] = ws.tau[j];
+        columns.iv[i] = ws.iv[j];
+        columns.delta[i] = ws.delta[j] * sz;
+        columns.gamma[i] = ws.gamma[j] * sz;
+        columns.theta[i] = ws.theta[j] * sz;
+        columns.vega[i] = ws.vega[j] * sz;
+        // Surface IV is only a warm start: the next liquid quote is always solved exactly.
+        calc_bid_[i] = nan;
+        calc_ask_[i] = nan;
+        calc_px_[i] = 0.0;
+        calc_spot_[i] = spot;
+        surface_filled_ += ws.iv[j] > 0.0 ? 1 : 0;
+    }
+}
+
+void PortfolioData::mark_slots(size_t start, size_t end) {
+    if (slot_frame_.size() != columns.size()) {
+        slot_frame_.assign(columns.size(), frame_seq_);
+        return;
+    }
+    if (start < end && end <= slot_frame_.size()) {
+        std::fill(slot_frame_.begin() + static_cast<std::ptrdiff_t>(start),
+                  slot_frame_.begin() + static_cast<std::ptrdiff_t>(end), frame_seq_);
+    }
+}
+
+void PortfolioData::covered_slots(const PortfolioSnapshot& snapshot,
+                                  std::vector<std::pair<size_t, size_t>>& ranges) const {
+    const size_t n = option_apply_order_.size();
+    ranges.clear();
+    if (snapshot.chains.empty()) {
+        ranges.emplace_back(0, n);
         return;
     }
-    const double spot = (snapshot.underlying_bid > 0.0 || snapshot.underlying_ask > 0.0)
-                            ? ((snapshot.underlying_bid > 0.0 && snapshot.underlying_ask > 0.0)
-                                   ? 0.5 * (snapshot.underlying_bid + snapshot.underlying_ask)
-                                   : (snapshot.underlying_bid > 0.0 ? snapshot.underlying_bid
-                                                                    : snapshot.underlying_ask))
-                            : snapshot.underlying_last;
-
-    std::vector<double> iv_vec(n, 0.0);
-    std::vector<double> delta_vec(n, 0.0);
-    std::vector<double> gamma_vec(n, 0.0);
-    std::vector<double> theta_vec(n, 0.0);
-    std::vector<double> vega_vec(n, 0.0);
-
-    const unsigned int n_workers = std::max(1U, std::thread::hardware_concurrency());
-    const size_t chunk = (n + n_workers - 1) / n_workers;
-    {
-        std::vector<std::jthread> threads;
-        threads.reserve(n_workers);
-        for (unsigned int w = 0; w < n_workers; ++w) {
-            const size_t start = w * chunk;
-            const size_t end = std::min(start + chunk, n);
-            if (start >= end) {
-                break;
+    for (const std::string& symbol : snapshot.chains) {
+        auto it = chains.find(symbol);
+        if (it != chains.end() && it->second && it->second->slot_end <= n &&
+            it->second->slot_begin < it->second->slot_end) {
+            ranges.emplace_back(it->second->slot_begin, it->second->slot_end);
+        }
+    }
+    std::ranges::sort(ranges);
+    // Merge duplicates and neighbours so each range is one parallel_for.
+    size_t out = 0;
+    for (size_t i = 1; i < ranges.size(); ++i) {
+        if (ranges[i].first <= ranges[out].second) {
+            ranges[out].second = std::max(ranges[out].second, ranges[i].second);
+        } else {
+            ranges[++out] = ranges[i];
+        }
+    }
+    ranges.resize(ranges.empty() ? 0 : out + 1);
+}
+
+void PortfolioData::clip_to_active(const QuoteView* quotes,
+                                   std::vector<std::pair<size_t, size_t>>& ranges) {
+    // Both lists are sorted and disjoint: keep what an active chain also covers.
+    std::vector<std::pair<size_t, size_t>>& clipped = clip_scratch();
+    clipped.clear();
+    size_t a = 0;
+    for (const auto& [begin, end] : ranges) {
+        while (a < active_.ranges.size() && active_.ranges[a].second <= begin) {
+            ++a;
+        }
+        size_t pos = begin;
+        for (size_t b = a; b < active_.ranges.size() && active_.ranges[b].first < end; ++b) {
+            const size_t lo = std::max(begin, active_.ranges[b].first);
+            const size_t hi = std::min(end, active_.ranges[b].second);
+            if (quotes != nullptr) {
+                copy_quotes(*quotes, pos, lo);
             }
-            threads.emplace_back([this, &snapshot, spot, start, end, &iv_vec, &delta_vec,
-                                  &gamma_vec, &theta_vec, &vega_vec]() -> void {
-                for (size_t i = start; i < end; ++i) {
-                    OptionData* opt = option_apply_order_[i];
-                    if (opt == nullptr) {
-                        continue;
-                    }
-                    const double bid = snapshot.bid[i];
-                    const double ask = snapshot.ask[i];
-                    const double k = opt->strike_price.value_or(0.0);
-                    const double t = years_to_expiry(snapshot.datetime, opt->option_expiry);
-                    const bool is_call = opt->option_type > 0;
-
-                    if (spot <= 0.0 || k <= 0.0 || t <= 0.0) {
-                        continue;
-                    }
-                    const double px = pick_iv_input_price(bid, ask, iv_price_mode_);
-                    if (px <= 0.0) {
-                        continue;
-                    }
-                    const double iv = implied_volatility_from_price(px, spot, k, t, is_call);
-                    const BsGreeks g = bs_greeks(is_call, spot, k, t, risk_free_rate_, iv);
-                    iv_vec[i] = iv;
-                    delta_vec[i] = g.delta;
-                    gamma_vec[i] = g.gamma;
-                    theta_vec[i] = g.theta;
-                    vega_vec[i] = g.vega;
-                }
-            });
+            clipped.emplace_back(lo, hi);
+            pos = hi;
+        }
+        if (quotes != nullptr) {
+            copy_quotes(*quotes, pos, end);
         }
-        // jthreads join when threads vector is destroyed at end of this block
     }
+    ranges.swap(clipped);
+}
 
+void PortfolioData::copy_quotes(const QuoteView& quotes, size_t start, size_t end) {
+    if (start >= end) {
+        return;
+    }
+    for (size_t i = start; i < end; ++i) {
+        const double bid = quotes.bid[i];
+        const double ask = quotes.ask[i];
+        columns.bid[i] = bid;
+        columns.ask[i] = ask;
+        columns.mid[i] =
+            (bid > 0.0 && ask > 0.0) ? 0.5 * (bid + ask) : (bid > 0.0 ? bid : quotes.last[i]);
+    }
+    mark_slots(start, end);
+}
+
+void PortfolioData::refresh_spot_greeks(double spot, std::span<const double> tau_now,
+                                        size_t start, size_t end) {
+    if (start >= end || !(spot > 0.0)) {
+        return;
+    }
+    FrameScratch& ws = frame_scratch();
+    ws.clear();
+    for (size_t i = start; i < end; ++i) {
+        const OptionData* opt = option_apply_order_[i];
+        if (opt == nullptr || !(columns.iv[i] > 0.0)) {
+            continue;
+        }
+        ws.lane.push_back(i);
+        ws.spot.push_back(spot);
+        ws.strike.push_back(columns.strike[i]);
+        ws.tau.push_back(tau_now[i]);
+        ws.iv.push_back(columns.iv[i]);
+        ws.is_call.push_back(opt->option_type > 0 ? 1 : 0);
+    }
+    const size_t m = ws.lane.size();
+    ws.delta.assign(m, 0.0);
+    ws.gamma.assign(m, 0.0);
+    ws.theta.assign(m, 0.0);
+    ws.vega.assign(m, 0.0);
+    bs_greeks_batch({.spot = ws.spot,
+                     .strike = ws.strike,
+                     .tau = ws.tau,
+                     .sigma = ws.iv,
+                     .is_call = ws.is_call,
+                     .risk_free_rate = risk_free_rate_},
+                    {.delta = ws.delta, .gamma = ws.gamma, .theta = ws.theta, .vega = ws.vega});
+    // calc_* stay at the last IV solve, so the next covering snapshot still sees the spot move.
+    for (size_t j = 0; j < m; ++j) {
+        const size_t i = ws.lane[j];
+        const double size = option_apply_order_[i]->size;
+        const double sz = size != 0.0 ? size : 1.0;
+        columns.tau[i] = ws.tau[j];
+        columns.delta[i] = ws.delta[j] * sz;
+        columns.gamma[i] = ws.gamma[j] * sz;
+        columns.theta[i] = ws.theta[j] * sz;
+        columns.vega[i] = ws.vega[j] * sz;
+    }
+}
+
+void PortfolioData::refresh_uncovered(double spot, std::span<const double> tau_now,
+                                      size_t start, size_t end) {
+    if (active_.all()) {
+        refresh_spot_greeks(spot, tau_now, start, end);
+        mark_slots(start, end);
+        return;
+    }
+    for (const auto& [begin, stop] : active_.ranges) {
+        const size_t lo = std::max(start, begin);
+        const size_t hi = std::min(end, stop);
+        if (lo < hi) {
+            refresh_spot_greeks(spot, tau_now, lo, hi);
+            mark_slots(lo, hi);
+        }
+    }
+}
+
+auto PortfolioData::scatter_sparse_quotes(const PortfolioSnapshot& snapshot) -> bool {
+    const size_t m = snapshot.slots.size();
+    if (snapshot.bid.size() != m || snapshot.ask.size() != m || snapshot.last.size() != m) {
+        return false;
+    }
+    const size_t n = option_apply_order_.size();
+    for (size_t k = 0; k < m; ++k) {
+        const size_t i = snapshot.slots[k];
+        if (i >= n) {
+            continue;
+        }
+        const double bid = snapshot.bid[k];
+        const double ask = snapshot.ask[k];
+        columns.bid[i] = bid;
+        columns.ask[i] = ask;
+        columns.mid[i] =
+            (bid > 0.0 && ask > 0.0) ? 0.5 * (bid + ask) : (bid > 0.0 ? bid : snapshot.last[k]);
+    }
+    return true;
+}
+
+void PortfolioData::apply_precomputed_greeks(const PortfolioSnapshot& snapshot) {
+    const size_t n = option_apply_order_.size();
+    refresh_slot_tau(snapshot.datetime, std::span(columns.tau.data(), n));
     for (size_t i = 0; i < n; ++i) {
-        OptionData* opt = option_apply_order_[i];
+        const OptionData* opt = option_apply_order_[i];
         if (opt == nullptr) {
             continue;
         }
         const double bid = snapshot.bid[i];
         const double ask = snapshot.ask[i];
-        const double last = snapshot.last[i];
-        opt->bid_price = bid;
-        opt->ask_price = ask;
-        opt->mid_price = (bid > 0.0 && ask > 0.0) ? 0.5 * (bid + ask) : (bid > 0.0 ? bid : last);
+        columns.bid[i] = bid;
+        columns.ask[i] = ask;
+        columns.mid[i] =
+            (bid > 0.0 && ask > 0.0) ? 0.5 * (bid + ask) : (bid > 0.0 ? bid : snapshot.last[i]);
         const double sz = opt->size != 0.0 ? opt->size : 1.0;
-        opt->delta = delta_vec[i] * sz;
-        opt->gamma = gamma_vec[i] * sz;
-        opt->theta = theta_vec[i] * sz;
-        opt->vega = vega_vec[i] * sz;
-        opt->mid_iv = iv_vec[i];
+        columns.iv[i] = snapshot.iv[i];
+        columns.delta[i] = snapshot.delta[i] * sz;
+        columns.gamma[i] = snapshot.gamma[i] * sz;
+        columns.theta[i] = snapshot.theta[i] * sz;
+        columns.vega[i] = snapshot.vega[i] * sz;
     }
-    for (auto& [_, chain] : chains) {
-        if (chain) {
-            chain->calculate_atm_price();
+    iv_stats_ = {};
+    recomputed_ = 0;
+    // Live IV state no longer matches the columns; force a full recompute on the next live frame.
+    calc_px_.clear();
+    refresh_chain_indexes();
+}
+
+void PortfolioData::compute_snapshot_greeks(PortfolioSnapshot& snapshot, SnapshotIvWarm& warm,
+                                            const ChainScope* scope) const {
+    const size_t n = option_apply_order_.size();
+    if (snapshot.sparse || n != snapshot.bid.size() || columns.size() < n) {
+        return;
+    }
+    const double spot = snapshot_spot(snapshot);
+    if (warm.iv.size() != n) {
+        warm.px.assign(n, 0.0);
+        warm.spot.assign(n, 0.0);
+        warm.iv.assign(n, 0.0);
+    }
+    const std::pair<size_t, size_t> everything{0, n};
+    const std::span<const std::pair<size_t, size_t>> ranges =
+        (scope != nullptr && !scope->all()) ? std::span(scope->ranges) : std::span(&everything, 1);
+    std::vector<double> spot_vec(n, spot);
+    std::vector<double> px_vec(n, 0.0);
+    std::vector<double> tau_vec(n, 0.0);
+    fill_slot_tau(snapshot.datetime, tau_vec);
+    std::vector<uint8_t> call_vec(n, 0);
+    const auto fill = [&]<IvPriceMode M>() -> void {
+        for (const auto& [begin, end] : ranges) {
+            for (size_t i = begin; i < end; ++i) {
+                const OptionData* opt = option_apply_order_[i];
+                if (opt == nullptr) {
+                    continue;
+                }
+                call_vec[i] = opt->option_type > 0 ? 1 : 0;
+                if (spot > 0.0 && columns.strike[i] > 0.0 && tau_vec[i] > 0.0) {
+                    px_vec[i] = pick_iv_input_price<M>(snapshot.bid[i], snapshot.ask[i]);
+                }
+            }
         }
+    };
+    switch (iv_price_mode_) {
+        using enum IvPriceMode;
+    case BID:
+        fill.template operator()<BID>();
+        break;
+    case ASK:
+        fill.template operator()<ASK>();
+        break;
+    case MID:
+        fill.template operator()<MID>();
+        break;
     }
+    for (auto* v : {&snapshot.iv, &snapshot.delta, &snapshot.gamma, &snapshot.theta,
+                    &snapshot.vega}) {
+        if (ranges.size() == 1 && ranges[0] == everything) {
+            v->resize(n);
+        } else {
+            v->assign(n, 0.0);
+        }
+    }
+    for (const auto& [begin, end] : ranges) {
+        const size_t len = end - begin;
+        const auto in = [begin, len](auto& v) -> auto {
+            return std::span(v).subspan(begin, len);
+        };
+        const std::span<const double> strike(columns.strike.data() + begin, len);
+        const std::span<double> iv = in(snapshot.iv);
+        implied_volatility_batch({.price = in(px_vec),
+                                  .spot = in(spot_vec),
+                                  .strike = strike,
+                                  .tau = in(tau_vec),
+                                  .is_call = in(call_vec),
+                                  .prev_price = in(warm.px),
+                                  .prev_spot = in(warm.spot),
+                                  .prev_iv = in(warm.iv)},
+                                 iv);
+        bs_greeks_batch({.spot = in(spot_vec),
+                         .strike = strike,
+                         .tau = in(tau_vec),
+                         .sigma = iv,
+                         .is_call = in(call_vec),
+                         .risk_free_rate = risk_free_rate_},
+                        {.delta = in(snapshot.delta),
+                         .gamma = in(snapshot.gamma),
+                         .theta = in(snapshot.theta),
+                         .vega = in(snapshot.vega)});
+    }
+    warm.px.swap(px_vec);
+    warm.spot.swap(spot_vec);
+    warm.iv = snapshot.iv;
+    snapshot.greek_chains.clear();
+    if (scope != nullptr && !scope->all()) {
+        snapshot.greek_chains = scope->chains;
+    }
+    snapshot.has_greeks = true;
 }
 
 void PortfolioData::set_underlying(const ContractData& contract) {
@@ -378,33 +1149,86 @@ auto PortfolioData::get_chain_by_expiry(int min_dte, int max_dte) const
     return out;
 }
 
-void PortfolioData::add_option(const ContractData& contract) {
+auto PortfolioData::insert_option(const ContractData& contract) -> OptionData* {
     auto it = options.find(contract.symbol);
     if (it == options.end()) {
         it = options.emplace(contract.symbol, OptionData(contract)).first;
+        it->second.slot = columns.push_back(contract.option_strike.value_or(0.0));
     } else {
+        const size_t slot = it->second.slot;
         it->second = OptionData(contract);
+        it->second.slot = slot;
+        columns.strike[slot] = contract.option_strike.value_or(0.0);
     }
+    it->second.columns = &columns;
     it->second.set_portfolio(this);
     OptionData* opt_ptr = &it->second;
+    if (opt_ptr->symbol_id >= options_by_id_.size()) {
+        options_by_id_.resize(static_cast<size_t>(opt_ptr->symbol_id) + 1, nullptr);
+    }
+    options_by_id_[opt_ptr->symbol_id] = opt_ptr;
+    return opt_ptr;
+}
 
-    std::string underlying_name;
-    std::string expiry_str;
-    std::istringstream iss(contract.symbol);
-    std::getline(iss, underlying_name, '-');
-    std::getline(iss, expiry_str, '-');
-    std::string chain_symbol = underlying_name + "_" + expiry_str;
+void PortfolioData::add_option(const ContractData& contract) {
+    OptionData* opt_ptr = insert_option(contract);
+    get_chain(chain_symbol_of(contract.symbol))->add_option(opt_ptr);
+}
 
-    ChainData* chain = get_chain(chain_symbol);
-    chain->add_option(opt_ptr);
+void PortfolioData::add_chain_options(std::span<const std::vector<ContractData>> groups) {
+    size_t total = 0;
+    for (const auto& group : groups) {
+        total += group.size();
+    }
+    reserve_options(total);
+    // Map and column inserts are serial; chain upkeep below touches only its own chain.
+    std::vector<ChainData*> group_chain(groups.size(), nullptr);
+    std::vector<std::vector<OptionData*>> group_options(groups.size());
+    for (size_t g = 0; g < groups.size(); ++g) {
+        if (groups[g].empty()) {
+            continue;
+        }
+        group_chain[g] = get_chain(chain_symbol_of(groups[g].front().symbol));
+        group_options[g].reserve(groups[g].size());
+        for (const ContractData& contract : groups[g]) {
+            group_options[g].push_back(insert_option(contract));
+        }
+    }
+    ThreadPool& pool = (thread_pool_ != nullptr) ? *thread_pool_ : ThreadPool::shared();
+    pool.parallel_for(
+        groups.size(),
+        [&](size_t begin, size_t end) -> void {
+            for (size_t g = begin; g < end; ++g) {
+                for (OptionData* opt : group_options[g]) {
+                    group_chain[g]->add_option(opt);
+                }
+            }
+        },
+        1);
+}
+
+void PortfolioData::reserve_options(size_t n) {
+    options.reserve(options.size() + n);
+    columns.reserve(columns.size() + n);
 }
 
 void PortfolioData::finalize_chains() {
+    std::vector<ChainData*> to_sort;
+    to_sort.reserve(chains.size());
     for (auto& [_, chain] : chains) {
         if (chain) {
-            chain->sort_indexes();
+            to_sort.push_back(chain.get());
         }
     }
+    ThreadPool& pool = (thread_pool_ != nullptr) ? *thread_pool_ : ThreadPool::shared();
+    pool.parallel_for(
+        to_sort.size(),
+        [&to_sort](size_t begin, size_t end) -> void {
+            for (size_t i = begin; i < end; ++i) {
+                to_sort[i]->sort_indexes();
+            }
+        },
+        8);
     option_apply_order_.clear();
     std::vector<std::string> chain_symbols;
     chain_symbols.reserve(chains.size());
@@ -416,6 +1240,7 @@ void PortfolioData::finalize_chains() {
             continue;
         }
         ChainData* ch = it->second.get();
+        ch->slot_begin = option_apply_order_.size();
         std::vector<OptionData*> opts;
         opts.reserve(ch->options.size());
         std::ranges::copy(ch->options | std::views::values, std::back_inserter(opts));
@@ -424,7 +1249,36 @@ void PortfolioData::finalize_chains() {
         for (OptionData* opt : opts) {
             option_apply_order_.push_back(opt);
         }
+        ch->slot_end = option_apply_order_.size();
+    }
+    // Re-slot columns into apply order; options outside any chain keep trailing slots.
+    std::vector<OptionData*> by_slot(columns.size(), nullptr);
+    for (auto& [_, opt] : options) {
+        by_slot[opt.slot] = &opt;
+    }
+    std::vector<OptionData*> owners = option_apply_order_;
+    for (OptionData* opt : option_apply_order_) {
+        by_slot[opt->slot] = nullptr;
+    }
+    std::ranges::copy_if(by_slot, std::back_inserter(owners),
+                         [](const OptionData* o) -> bool { return o != nullptr; });
+    std::vector<size_t> order(owners.size());
+    std::ranges::transform(owners, order.begin(),
+                           [](const OptionData* o) -> size_t { return o->slot; });
+    columns.permute(order);
+    for (size_t i = 0; i < owners.size(); ++i) {
+        owners[i]->slot = i;
     }
+    // Slots moved: every reader revalues.
+    slot_frame_.assign(columns.size(), ++frame_seq_);
+    calc_bid_.clear();
+    calc_ask_.clear();
+    calc_spot_.clear();
+    calc_px_.clear();
+    adopt_active_chains(true);
+    // Both buffers take the new slot layout.
+    publish();
+    publish();
 }
 
 void PortfolioData::calculate_atm_price() {
@@ -435,4 +1289,109 @@ void PortfolioData::calculate_atm_price() {
     }
 }
 
+void PortfolioData::fill_slot_tau(DateTime now, std::span<double> out) const {
+    std::ranges::fill(out, 0.0);
+    for (const auto& [_, chain] : chains) {
+        if (chain && chain->slot_end <= out.size()) {
+            std::ranges::fill(out.subspan(chain->slot_begin, chain->slot_end - chain->slot_begin),
+                              years_to_expiry(now, chain->expiry));
+        }
+    }
+}
+
+void PortfolioData::refresh_slot_tau(DateTime now, std::span<double> out) {
+    std::ranges::fill(out, 0.0);
+    for (auto& [_, chain] : chains) {
+        if (!chain) {
+            continue;
+        }
+        chain->refresh_expiry(now);
+        if (chain->slot_end <= out.size()) {
+            std::ranges::fill(out.subspan(chain->slot_begin, chain->slot_end - chain->slot_begin),
+                              chain->tau);
+        }
+    }
+}
+
+void PortfolioData::refresh_chain_indexes() {
+    for (auto& [symbol, chain] : chains) {
+        if (chain && active_.contains(symbol)) {
+            chain->calculate_atm_price();
+            chain->refresh_delta_index();
+        }
+    }
+}
+
+void PortfolioData::set_active_chains(std::vector<std::string> chain_symbols) {
+    std::ranges::sort(chain_symbols);
+    const auto [first, last] = std::ranges::unique(chain_symbols);
+    chain_symbols.erase(first, last);
+    std::scoped_lock lock(active_mutex_);
+    if (chain_symbols == requested_chains_) {
+        return;
+    }
+    requested_chains_ = std::move(chain_symbols);
+    active_changed_.store(true, std::memory_order_release);
+}
+
+auto PortfolioData::active_chains() const -> std::vector<std::string> {
+    std::scoped_lock lock(active_mutex_);
+    return requested_chains_;
+}
+
+auto PortfolioData::is_chain_active(std::string_view chain_symbol) const -> bool {
+    std::scoped_lock lock(active_mutex_);
+    return requested_chains_.empty() ||
+           std::ranges::binary_search(requested_chains_, chain_symbol, std::less<>{});
+}
+
+auto PortfolioData::chain_scope(std::vector<std::string> chain_symbols) const -> ChainScope {
+    ChainScope scope;
+    std::ranges::sort(chain_symbols);
+    scope.chains = std::move(chain_symbols);
+    for (const std::string& symbol : scope.chains) {
+        auto it = chains.find(symbol);
+        if (it != chains.end() && it->second &&
+            it->second->slot_begin < it->second->slot_end) {
+            scope.ranges.emplace_back(it->second->slot_begin, it->second->slot_end);
+        }
+    }
+    // Chains are slotted in symbol order, so the ranges are sorted; join neighbours.
+    std::ranges::sort(scope.ranges);
+    size_t out = 0;
+    for (size_t i = 1; i < scope.ranges.size(); ++i) {
+        if (scope.ranges[i].first <= scope.ranges[out].second) {
+            scope.ranges[out].second = std::max(scope.ranges[out].second, scope.ranges[i].second);
+        } else {
+            scope.ranges[++out] = scope.ranges[i];
+        }
+    }
+    scope.ranges.resize(scope.ranges.empty() ? 0 : out + 1);
+    return scope;
+}
+
+void PortfolioData::adopt_active_chains(bool force) {
+    if (!active_changed_.exchange(false, std::memory_order_acq_rel) && !force) {
+        return;
+    }
+    const bool was_all = active_.all();
+    active_ = chain_scope(active_chains());
+    if (!was_all || !active_.all()) {
+        // Chains that join were skipped while inactive: solve them in full on the next frame.
+        calc_px_.clear();
+    }
+}
+
+auto PortfolioData::greeks_cover_active(const PortfolioSnapshot& snapshot) const -> bool {
+    if (snapshot.greek_chains.empty()) {
+        return true;
+    }
+    if (active_.all()) {
+        return false;
+    }
+    return std::ranges::all_of(active_.chains, [&snapshot](const std::string& symbol) -> bool {
+        return std::ranges::binary_search(snapshot.greek_chains, symbol);
+    });
+}
+
 } // namespace utilities
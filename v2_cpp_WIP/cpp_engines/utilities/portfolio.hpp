@@ -2,16 +2,25 @@
 
 /** PortfolioData, ChainData, OptionData, UnderlyingData (from portfolio.py). */
 
+#include "black_scholes.hpp"
 #include "constant.hpp"
 #include "event.hpp"
 #include "object.hpp"
+#include "symbol_table.hpp"
 #include "utility.hpp"
+#include "vol_surface.hpp"
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <span>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace utilities {
@@ -20,16 +29,103 @@ namespace utilities {
 struct PortfolioData;
 struct ChainData;
 struct UnderlyingData;
+class ThreadPool;
 
+/** Contiguous per-option market state; slot = option_apply_order position after finalize_chains. */
+struct OptionColumns {
+    std::vector<double> bid, ask, mid, iv, delta, gamma, theta, vega, strike, tau;
+
+    [[nodiscard]] size_t size() const { return bid.size(); }
+    /** Append a zeroed slot; returns its index. */
+    size_t push_back(double strike_price);
+    void reserve(size_t n);
+    /** Reorder so that new slot i holds old slot order[i]; order must be a permutation. */
+    void permute(const std::vector<size_t>& order);
+};
+
+/** One published frame of market state: option columns plus the underlying quote. */
+struct MarketBuffer {
+    OptionColumns columns;
+    double underlying_bid = 0.0;
+    double underlying_ask = 0.0;
+    double underlying_mid = 0.0;
+    /** PortfolioData::frame_seq() this buffer reflects. */
+    uint64_t frame = 0;
+    /** MarketViews holding this buffer; the writer reuses it only at zero. */
+    mutable std::atomic<uint32_t> pins{0};
+};
+
+/**
+ * Pinned, consistent frame of a portfolio's market state (PortfolioData::pin). Lock-free; the
+ * frame stays unchanged while the view lives, so hold it only for one read pass.
+ */
+class MarketView {
+  public:
+    MarketView() = default;
+    explicit MarketView(const MarketBuffer* buffer) : buffer_(buffer) {}
+    MarketView(MarketView&& other) noexcept : buffer_(std::exchange(other.buffer_, nullptr)) {}
+    MarketView& operator=(MarketView&& other) noexcept {
+        if (this != &other) {
+            release();
+            buffer_ = std::exchange(other.buffer_, nullptr);
+        }
+        return *this;
+    }
+    MarketView(const MarketView&) = delete;
+    MarketView& operator=(const MarketView&) = delete;
+    ~MarketView() { release(); }
+
+    explicit operator bool() const { return buffer_ != nullptr; }
+    [[nodiscard]] uint64_t frame() const { return buffer_->frame; }
+    [[nodiscard]] const OptionColumns& columns() const { return buffer_->columns; }
+    [[nodiscard]] double underlying_bid() const { return buffer_->underlying_bid; }
+    [[nodiscard]] double underlying_ask() const { return buffer_->underlying_ask; }
+    [[nodiscard]] double underlying_mid() const { return buffer_->underlying_mid; }
+    /** Column value at slot; 0 for a slot this frame does not have yet. */
+    [[nodiscard]] double at(const std::vector<double> OptionColumns::* field, size_t slot) const {
+        const std::vector<double>& col = buffer_->columns.*field;
+        return slot < col.size() ? col[slot] : 0.0;
+    }
+
+  private:
+    void release() {
+        if (buffer_ != nullptr) {
+            buffer_->pins.fetch_sub(1, std::memory_order_release);
+            buffer_ = nullptr;
+        }
+    }
+
+    const MarketBuffer* buffer_ = nullptr;
+};
+
+/** IV warm-start state carried across consecutive compute_snapshot_greeks calls. */
+struct SnapshotIvWarm {
+    std::vector<double> px;
+    std::vector<double> spot;
+    std::vector<double> iv;
+};
+
+/** Chains that get IV/Greeks, with their slots (PortfolioData::chain_scope). */
+struct ChainScope {
+    /** Sorted chain symbols; empty = every chain. */
+    std::vector<std::string> chains;
+    /** Merged [begin, end) option_apply_order ranges of the chains the portfolio has. */
+    std::vector<std::pair<size_t, size_t>> ranges;
+
+    [[nodiscard]] bool all() const { return chains.empty(); }
+    [[nodiscard]] bool contains(std::string_view chain_symbol) const;
+};
+
+/** Static contract fields plus a handle (columns, slot) on the SoA market state. */
 struct OptionData {
     std::string symbol;
+    SymbolId symbol_id = kNoSymbol;
     Exchange exchange = Exchange::LOCAL;
     double size = 100.0;
     OptionData() = default;
     explicit OptionData(const ContractData& contract);
-    double bid_price = 0.0;
-    double ask_price = 0.0;
-    double mid_price = 0.0;
+    OptionColumns* columns = nullptr;
+    size_t slot = 0;
     std::optional<TickData> tick;
     PortfolioData* portfolio = nullptr;
 
@@ -39,19 +135,33 @@ struct OptionData {
     std::optional<DateTime> option_expiry;
     UnderlyingData* underlying = nullptr;
     ChainData* chain = nullptr;
-    double delta = 0;
-    double gamma = 0;
-    double theta = 0;
-    double vega = 0;
-    double mid_iv = 0;
+
+    [[nodiscard]] double bid_price() const { return column(&OptionColumns::bid); }
+    [[nodiscard]] double ask_price() const { return column(&OptionColumns::ask); }
+    [[nodiscard]] double mid_price() const { return column(&OptionColumns::mid); }
+    /** Greeks are position-scaled (per-unit * size). */
+    [[nodiscard]] double delta() const { return column(&OptionColumns::delta); }
+    [[nodiscard]] double gamma() const { return column(&OptionColumns::gamma); }
+    [[nodiscard]] double theta() const { return column(&OptionColumns::theta); }
+    [[nodiscard]] double vega() const { return column(&OptionColumns::vega); }
+    [[nodiscard]] double mid_iv() const { return column(&OptionColumns::iv); }
+    [[nodiscard]] double tau() const { return column(&OptionColumns::tau); }
+    void set_quote(double bid, double ask, double mid);
+    void set_greeks(double iv, double delta, double gamma, double theta, double vega);
 
     void set_portfolio(PortfolioData* p);
     void set_chain(ChainData* c);
     void set_underlying(UnderlyingData* u);
+
+  private:
+    [[nodiscard]] double column(const std::vector<double> OptionColumns::* field) const {
+        return columns != nullptr ? (columns->*field)[slot] : 0.0;
+    }
 };
 
 struct UnderlyingData {
     std::string symbol;
+    SymbolId symbol_id = kNoSymbol;
     Exchange exchange = Exchange::LOCAL;
     double size = 1.0;
     double bid_price = 0.0;
@@ -66,6 +176,7 @@ struct UnderlyingData {
     explicit UnderlyingData(const ContractData& contract);
     void set_portfolio(PortfolioData* p);
     void add_chain(ChainData* chain);
+    /** Takes the quote as spot and re-splits each chain's delta index (refresh_delta_on_spot). */
     void update_underlying_tick(const TickData& tick_data);
 };
 
@@ -78,15 +189,38 @@ struct ChainData {
     PortfolioData* portfolio = nullptr;
     std::vector<std::string> indexes;
     std::unordered_set<std::string> index_set;
+    /** Ascending strikes with their call/put (nullptr if absent); rebuilt by sort_indexes. */
+    std::vector<double> strikes;
+    std::vector<OptionData*> strike_calls;
+    std::vector<OptionData*> strike_puts;
+    /** Position in indexes of each strikes entry. */
+    std::vector<int> strike_index_pos;
     double atm_price = 0;
-    std::string atm_index;
+    /** Slot in strikes of the ATM strike; -1 if none. */
+    int atm_index = -1;
+    /** Shared expiry of the chain's options (first option with one). */
+    std::optional<DateTime> expiry;
+    /** Precise years to expiry at the last refresh_expiry; read by apply_frame per slot. */
+    double tau = 0;
     int days_to_expiry = 0;
     double time_to_expiry = 0;
+    /** [slot_begin, slot_end) of this chain in option_apply_order (finalize_chains). */
+    size_t slot_begin = 0;
+    size_t slot_end = 0;
+    /**
+     * Smile fitted to the liquid strikes' total variance over ln(K/F) by apply_frame when the
+     * portfolio's surface fit is on; refitted from the previous params every frame.
+     */
+    SviParams svi;
 
     explicit ChainData(std::string chain_symbol);
+    /** Recompute tau, days_to_expiry and time_to_expiry against now. */
+    void refresh_expiry(DateTime now);
     void add_option(OptionData* option);
-    /** Sort indexes. */
+    /** Sort indexes and rebuild the strike arrays. */
     void sort_indexes();
+    /** indexes entry of the ATM strike; nullptr if none. */
+    [[nodiscard]] const std::string* atm_index_name() const;
     void update_option_chain(const ChainMarketData& market_data);
     void set_underlying(UnderlyingData* u);
     void set_portfolio(PortfolioData* p);
@@ -94,31 +228,160 @@ struct ChainData {
     std::optional<double> get_atm_iv() const;
     static std::optional<double>
     best_iv(const std::unordered_map<std::string, OptionData*>& options_map, double target);
+    /** Call IV / put IV at delta_target (percent); answered from the delta index. */
     std::optional<double> get_skew(double delta_target = 25.0) const;
+
+    /** OTM option with nonzero IV, keyed by per-unit |delta|. */
+    struct DeltaEntry {
+        double abs_delta = 0.0;
+        OptionData* option = nullptr;
+    };
+    /** OTM calls / puts ascending by |delta|; rebuilt by refresh_delta_index. */
+    std::vector<DeltaEntry> otm_calls_by_delta;
+    std::vector<DeltaEntry> otm_puts_by_delta;
+    /** strikes positions of the first strike >= / > spot at the last rebuild (OTM split). */
+    std::pair<size_t, size_t> delta_split{SIZE_MAX, SIZE_MAX};
+    /** Rebuild the delta index from current Greeks (once per apply_frame). */
+    void refresh_delta_index();
+    /**
+     * Underlying tick path: rebuild only when spot crossed a strike since the last rebuild, so
+     * the OTM sides follow spot. Deltas stay those of the last apply_frame until the next one.
+     */
+    void refresh_delta_on_spot();
+    /** OTM call/put whose |delta| is nearest target (0..1); nullptr if none. */
+    [[nodiscard]] OptionData* nearest_delta(bool call, double target) const;
+    /** IV linear in |delta| between the bracketing OTM options; flat beyond the ends. */
+    [[nodiscard]] std::optional<double> iv_at_delta(bool call, double target) const;
 };
 
 struct PortfolioData {
     std::string name;
     std::unordered_map<std::string, OptionData> options;
+    /** SoA market state behind every OptionData in options. */
+    OptionColumns columns;
     std::unordered_map<std::string, std::unique_ptr<ChainData>> chains;
     std::unique_ptr<UnderlyingData> underlying;
     std::string underlying_symbol;
     /** option_apply_order (finalize_chains). */
     std::vector<OptionData*> option_apply_order_;
+    /** options by SymbolId (nullptr: not in this portfolio); sized to the largest id added. */
+    std::vector<OptionData*> options_by_id_;
 
     double risk_free_rate_ = 0.05;
-    std::string iv_price_mode_ = "mid";
+    IvPriceMode iv_price_mode_ = IvPriceMode::MID;
+    /** false → apply_frame solves IV only and leaves Greeks at zero. */
+    bool greeks_enabled_ = true;
     DateTime dte_ref_{};
+    /** Executor for apply_frame IV/Greeks chunks; nullptr → ThreadPool::shared(). */
+    ThreadPool* thread_pool_ = nullptr;
+    /**
+     * Inputs at each slot's last IV/Greeks recompute (dirty check, IV warm start); tau lives
+     * in the columns.
+     */
+    std::vector<double> calc_bid_;
+    std::vector<double> calc_ask_;
+    std::vector<double> calc_spot_;
+    std::vector<double> calc_px_;
+    /** apply_working scratch (slot tau at the frame, covered ranges); capacity kept per frame. */
+    std::vector<double> tau_now_;
+    std::vector<std::pair<size_t, size_t>> covered_;
+    bool incremental_ = false;
+    double price_epsilon_ = 0.0;
+    double tau_epsilon_ = kDefaultTauEpsilon;
+    bool spot_refresh_ = false;
+    IvBatchStats iv_stats_{};
+    size_t recomputed_ = 0;
+    bool surface_fit_ = false;
+    double surface_band_ = 0.15;
+    double surface_max_spread_ = 0.5;
+    /** 1 = the last apply_frame took this slot's IV from the chain surface. */
+    std::vector<uint8_t> surface_slot_;
+    size_t surface_filled_ = 0;
+    /** Frames applied so far; slot_frame_[slot] = frame that last changed that slot. */
+    uint64_t frame_seq_ = 0;
+    std::vector<uint64_t> slot_frame_;
+    /** trace_tsc of the last applied snapshot that carried one (live latency tracing). */
+    uint64_t trace_tsc_ = 0;
 
-    explicit PortfolioData(std::string name);
+    explicit PortfolioData(std::string name, ThreadPool* thread_pool = nullptr);
     void set_risk_free_rate(double rate);
-    void set_iv_price_mode(std::string mode);
+    void set_thread_pool(ThreadPool* pool) { thread_pool_ = pool; }
+    void set_iv_price_mode(const std::string& mode);
+    [[nodiscard]] IvPriceMode iv_price_mode() const { return iv_price_mode_; }
+    void set_greeks_enabled(bool enabled);
     void set_dte_ref(DateTime ref);
+    /**
+     * Default incremental tau tolerance: 5 minutes in years. Tau moves on every frame, so a zero
+     * tolerance would leave every slot dirty and incremental mode would recompute everything.
+     */
+    static constexpr double kDefaultTauEpsilon = 5.0 * 60.0 / (365.25 * 24.0 * 3600.0);
+    /**
+     * Incremental apply_frame: recompute IV/Greeks only where bid, ask or spot moved more than
+     * price_epsilon, or tau more than tau_epsilon (years), since that option's last recompute.
+     */
+    void set_incremental(bool enabled, double price_epsilon = 0.0,
+                         double tau_epsilon = kDefaultTauEpsilon);
+    /**
+     * Chain-scoped snapshots: re-evaluate Greeks of the chains a snapshot does not cover at its
+     * spot, keeping their last IV (no IV solve).
+     */
+    void set_spot_refresh(bool enabled) { spot_refresh_ = enabled; }
+    /**
+     * Surface mode: exact IV only for liquid strikes (two-sided quote, spread <= max_spread of
+     * mid, |ln(K/S)| <= liquid_band); every other strike of a solved chain gets IV and Greeks
+     * from the chain's SVI fit (ChainData::svi) instead of zero Greeks.
+     */
+    void set_surface_fit(bool enabled, double liquid_band = 0.15, double max_spread = 0.5);
     [[nodiscard]] DateTime dte_ref() const { return dte_ref_; }
     void update_option_chain(const ChainMarketData& market_data);
     void update_underlying_tick(const TickData& tick_data) const;
-    /** Apply snapshot: IV/Greeks → underlying + option_apply_order. */
+    /**
+     * Restrict IV/Greeks, spot refresh and ATM / delta-index upkeep to these chains (the union
+     * of the strategies' subscriptions and held positions); the others keep their quotes and
+     * last Greeks. Empty = every chain (the default). Any thread; the next apply_frame takes it.
+     */
+    void set_active_chains(std::vector<std::string> chain_symbols);
+    /** Chains last passed to set_active_chains, sorted (empty = every chain). */
+    [[nodiscard]] std::vector<std::string> active_chains() const;
+    [[nodiscard]] bool is_chain_active(std::string_view chain_symbol) const;
+    /** chain_symbols against the current slot layout (symbols the portfolio lacks get no range). */
+    [[nodiscard]] ChainScope chain_scope(std::vector<std::string> chain_symbols) const;
+    /**
+     * Apply snapshot (dense or sparse): IV/Greeks → underlying + option_apply_order. With
+     * snapshot.chains set only those chains are solved (see set_spot_refresh for the rest), and
+     * only the active ones (set_active_chains).
+     * The result is then published for pin().
+     */
     void apply_frame(const PortfolioSnapshot& snapshot);
+    /**
+     * Last published frame, for readers on other threads than the one applying frames. Writers
+     * fill the other of two buffers and swap atomically; a reader pins the front one without
+     * locking and always sees a whole frame. OptionData accessors read the writer's state.
+     */
+    [[nodiscard]] MarketView pin() const;
+    /**
+     * Fill snapshot iv/delta/gamma/theta/vega (per unit) and set has_greeks; serial, no portfolio
+     * state touched, so callers may run it for many snapshots in parallel (one warm per thread).
+     * With a scope only its ranges are solved (the rest get zeros) and snapshot.greek_chains
+     * records it. Dense snapshots only; sparse ones are left as is.
+     */
+    void compute_snapshot_greeks(PortfolioSnapshot& snapshot, SnapshotIvWarm& warm,
+                                 const ChainScope* scope = nullptr) const;
+    /** IV paths taken by the last apply_frame (reused / warm Newton / cold). */
+    [[nodiscard]] const IvBatchStats& last_iv_stats() const { return iv_stats_; }
+    /** Options whose IV/Greeks the last apply_frame recomputed (all when not incremental). */
+    [[nodiscard]] size_t last_recomputed() const { return recomputed_; }
+    /** Options the last apply_frame valued from a chain surface (surface mode). */
+    [[nodiscard]] size_t last_surface_filled() const { return surface_filled_; }
+    /**
+     * Dirty tracking for consumers of the market state: frame_seq() advances on every applied
+     * frame (and on finalize_chains); slot_frame(slot) is the last frame that may have changed the
+     * slot's quote or Greeks. A reader that saw frame F only needs slots with slot_frame > F.
+     */
+    [[nodiscard]] uint64_t frame_seq() const { return frame_seq_; }
+    [[nodiscard]] uint64_t slot_frame(size_t slot) const {
+        return slot < slot_frame_.size() ? slot_frame_[slot] : frame_seq_;
+    }
     /** Order used by snapshot (chain_symbol sort, then option symbol sort per chain). */
     [[nodiscard]] const std::vector<OptionData*>& option_apply_order() const {
         return option_apply_order_;
@@ -127,9 +390,99 @@ struct PortfolioData {
     ChainData* get_chain(const std::string& chain_symbol);
     std::vector<std::string> get_chain_by_expiry(int min_dte, int max_dte) const;
     void add_option(const ContractData& contract);
+    /**
+     * add_option for contracts grouped by chain (one chain per group, no chain in two groups):
+     * options are inserted serially, then the chains take their groups in parallel.
+     */
+    void add_chain_options(std::span<const std::vector<ContractData>> groups);
+    /** Option of this portfolio by interned id; nullptr if absent. */
+    [[nodiscard]] OptionData* find_option(SymbolId id) const {
+        return id < options_by_id_.size() ? options_by_id_[id] : nullptr;
+    }
+    /** String edge of find_option: resolves symbol through the shared SymbolTable. */
+    [[nodiscard]] OptionData* find_option(std::string_view symbol) const {
+        return find_option(find_symbol(symbol));
+    }
+    /** Capacity for n more options ahead of a bulk add_option run. */
+    void reserve_options(size_t n);
     /** Sort chain indexes. */
     void finalize_chains();
     void calculate_atm_price();
+    /** Per-slot tau at now from the chain expiries (options without a chain get 0). */
+    void fill_slot_tau(DateTime now, std::span<double> out) const;
+    /** Per-chain ATM strike and delta index refresh after new Greeks (active chains only). */
+    void refresh_chain_indexes();
+
+  private:
+    /** options / columns / id index part of add_option (no chain). */
+    OptionData* insert_option(const ContractData& contract);
+    void apply_working(const PortfolioSnapshot& snapshot);
+    /** Bring the back buffer up to the working state (dirty slots only) and make it the front. */
+    void publish();
+
+    std::array<MarketBuffer, 2> published_{};
+    std::atomic<uint32_t> front_{0};
+
+    /** set_active_chains request; the applying thread adopts it as active_. */
+    mutable std::mutex active_mutex_;
+    std::vector<std::string> requested_chains_;
+    std::atomic<bool> active_changed_{false};
+    ChainScope active_;
+    /** Take a pending set_active_chains (or rebuild active_ after the slots moved). */
+    void adopt_active_chains(bool force = false);
+    /** Snapshot Greeks cover every active chain (precomputed for a wide enough scope). */
+    [[nodiscard]] bool greeks_cover_active(const PortfolioSnapshot& snapshot) const;
+
+    /** Dense per-slot quotes read by apply_chunk (snapshot vectors, or columns after a scatter). */
+    struct QuoteView {
+        std::span<const double> bid, ask, last;
+    };
+    using ApplyKernel = size_t (PortfolioData::*)(const QuoteView&, double,
+                                                  std::span<const double>, size_t, size_t,
+                                                  IvBatchStats&);
+    /** apply_frame chunk [start, end); config is compile-time so the loop has no mode branches. */
+    template <IvPriceMode M, bool Greeks, bool Incremental, bool Surface>
+    size_t apply_chunk(const QuoteView& quotes, double spot,
+                       std::span<const double> tau_now, size_t start, size_t end,
+                       IvBatchStats& stats);
+    template <IvPriceMode M, bool Greeks>
+    static ApplyKernel select_apply_kernel(bool incremental, bool surface);
+    template <IvPriceMode M>
+    static ApplyKernel select_apply_kernel(bool greeks, bool incremental, bool surface);
+    static ApplyKernel select_apply_kernel(IvPriceMode mode, bool greeks, bool incremental,
+                                           bool surface);
+    /**
+     * Surface mode, after the kernels: refit the SVI of each chain inside ranges from its liquid
+     * strikes, then value the strikes the kernels left to the surface.
+     */
+    void fit_surfaces(double spot, std::span<const double> tau_now,
+                      std::span<const std::pair<size_t, size_t>> ranges);
+    /**
+     * Merged [begin, end) slot ranges of snapshot.chains into out (cleared); all of
+     * option_apply_order if empty.
+     */
+    void covered_slots(const PortfolioSnapshot& snapshot,
+                       std::vector<std::pair<size_t, size_t>>& out) const;
+    /** Greeks of [start, end) at spot from the current IV (spot-only refresh). */
+    void refresh_spot_greeks(double spot, std::span<const double> tau_now, size_t start,
+                             size_t end);
+    /**
+     * Keep the active part of ranges (sorted, disjoint); with quotes the inactive part takes
+     * them into the columns (no IV/Greeks).
+     */
+    void clip_to_active(const QuoteView* quotes, std::vector<std::pair<size_t, size_t>>& ranges);
+    /** bid/ask/mid of [start, end) from quotes; marks the slots. */
+    void copy_quotes(const QuoteView& quotes, size_t start, size_t end);
+    /** refresh_spot_greeks and mark_slots on the active part of [start, end). */
+    void refresh_uncovered(double spot, std::span<const double> tau_now, size_t start,
+                           size_t end);
+    /** Write sparse snapshot updates into columns bid/ask/mid; false if its sizes mismatch. */
+    bool scatter_sparse_quotes(const PortfolioSnapshot& snapshot);
+    void apply_precomputed_greeks(const PortfolioSnapshot& snapshot);
+    /** refresh_expiry on every chain, then fill out per slot from the cached chain tau. */
+    void refresh_slot_tau(DateTime now, std::span<double> out);
+    /** Stamp [start, end) with the current frame_seq_. */
+    void mark_slots(size_t start, size_t end);
 };
 
 } // namespace utilities
@@ -0,0 +1,58 @@
+#pragma once
+
+/**
+ * RecentIdSet: "seen before?" for string ids (trade ids, exec ids) over a bounded window. Ids are
+ * interned as 64-bit hashes into two generations; when the current generation is full it becomes
+ * the previous one and the older is dropped, so memory stays at about 2 x capacity hashes and an
+ * id is remembered for at least capacity later inserts.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <unordered_set>
+
+namespace utilities {
+
+class RecentIdSet {
+  public:
+    explicit RecentIdSet(size_t capacity) : capacity_(std::max<size_t>(capacity, 1)) {
+        current_.reserve(capacity_);
+    }
+
+    /** Record id; false when it was already seen within the window. */
+    bool insert(std::string_view id) {
+        const uint64_t key = intern(id);
+        if (current_.contains(key) || previous_.contains(key)) {
+            return false;
+        }
+        if (current_.size() >= capacity_) {
+            previous_.swap(current_);
+            current_.clear();
+            ++generation_;
+        }
+        current_.insert(key);
+        return true;
+    }
+
+    [[nodiscard]] bool contains(std::string_view id) const {
+        const uint64_t key = intern(id);
+        return current_.contains(key) || previous_.contains(key);
+    }
+
+    [[nodiscard]] size_t size() const { return current_.size() + previous_.size(); }
+    /** Generations retired so far. */
+    [[nodiscard]] uint64_t generation() const { return generation_; }
+
+  private:
+    static uint64_t intern(std::string_view id) { return std::hash<std::string_view>{}(id); }
+
+    size_t capacity_;
+    std::unordered_set<uint64_t> current_;
+    std::unordered_set<uint64_t> previous_;
+    uint64_t generation_ = 0;
+};
+
+} // namespace utilities
@@ -0,0 +1,47 @@
+#include "symbol_table.hpp"
+
+#include <mutex>
+
+namespace utilities {
+
+auto SymbolTable::intern(std::string_view symbol) -> SymbolId {
+    {
+        std::shared_lock lock(mutex_);
+        auto it = index_.find(symbol);
+        if (it != index_.end()) {
+            return it->second;
+        }
+    }
+    std::unique_lock lock(mutex_);
+    auto it = index_.find(symbol);
+    if (it != index_.end()) {
+        return it->second; // interned by another thread in between
+    }
+    const auto id = static_cast<SymbolId>(names_.size());
+    const std::string& stored = names_.emplace_back(symbol);
+    index_.emplace(stored, id);
+    return id;
+}
+
+auto SymbolTable::find(std::string_view symbol) const -> SymbolId {
+    std::shared_lock lock(mutex_);
+    auto it = index_.find(symbol);
+    return it != index_.end() ? it->second : kNoSymbol;
+}
+
+auto SymbolTable::name(SymbolId id) const -> std::string_view {
+    std::shared_lock lock(mutex_);
+    return id < names_.size() ? std::string_view(names_[id]) : std::string_view{};
+}
+
+auto SymbolTable::size() const -> size_t {
+    std::shared_lock lock(mutex_);
+    return names_.size();
+}
+
+auto SymbolTable::shared() -> SymbolTable& {
+    static SymbolTable table;
+    return table;
+}
+
+} // namespace utilities
@@ -0,0 +1,52 @@
+#pragma once
+
+/**
+ * SymbolTable: process-wide interning of contract symbols to dense integer ids. An id is handed
+ * out once per distinct symbol (at contract load) and never reused, so engines can key hot-path
+ * state by SymbolId and turn strings into ids only at the gateway, DB and file edges.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace utilities {
+
+using SymbolId = uint32_t;
+inline constexpr SymbolId kNoSymbol = UINT32_MAX;
+
+class SymbolTable {
+  public:
+    SymbolTable() = default;
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    /** Id of symbol, assigning the next one on first sight. */
+    SymbolId intern(std::string_view symbol);
+    /** Id of an interned symbol; kNoSymbol if never interned (no allocation either way). */
+    [[nodiscard]] SymbolId find(std::string_view symbol) const;
+    /** Interned text of id; empty for kNoSymbol or an unknown id. View stays valid for life. */
+    [[nodiscard]] std::string_view name(SymbolId id) const;
+    [[nodiscard]] size_t size() const;
+
+    /** Table shared by every engine in the process. */
+    static SymbolTable& shared();
+
+  private:
+    mutable std::shared_mutex mutex_;
+    /** Deque: stable storage for the views used as index keys. */
+    std::deque<std::string> names_;
+    std::unordered_map<std::string_view, SymbolId> index_;
+};
+
+inline SymbolId intern_symbol(std::string_view symbol) {
+    return SymbolTable::shared().intern(symbol);
+}
+inline SymbolId find_symbol(std::string_view symbol) { return SymbolTable::shared().find(symbol); }
+inline std::string_view symbol_name(SymbolId id) { return SymbolTable::shared().name(id); }
+
+} // namespace utilities
@@ -0,0 +1,177 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace utilities {
+
+namespace {
+
+struct SharedConfig {
+    std::mutex mtx;
+    unsigned int n_workers = 0;
+    bool pin_to_cores = false;
+    bool created = false;
+};
+
+auto shared_config() -> SharedConfig& {
+    static SharedConfig cfg;
+    return cfg;
+}
+
+void pin_current_thread(unsigned int worker_id) {
+#if defined(__linux__)
+    const unsigned int n_cores = std::max(1U, std::thread::hardware_concurrency());
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(worker_id % n_cores, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)worker_id;
+#endif
+}
+
+/** Per-call state; shared_ptr so helpers dequeued after completion never touch a dead frame. */
+struct ForState {
+    const std::function<void(size_t, size_t)>* body = nullptr;
+    size_t n = 0;
+    size_t chunk = 0;
+    size_t n_chunks = 0;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    std::mutex mtx;
+    std::condition_variable cv;
+    /** First exception thrown by a chunk (under mtx); the rest of the chunks are skipped. */
+    std::exception_ptr error;
+    std::atomic<bool> failed{false};
+
+    /**
+     * Claim and run chunks until none remain. Every claimed chunk counts as done, thrown or
+     * skipped, so the caller's wait (and its body) outlives every chunk that reads body.
+     */
+    void drain() {
+        for (size_t c = next.fetch_add(1); c < n_chunks; c = next.fetch_add(1)) {
+            if (!failed.load(std::memory_order_relaxed)) {
+                const size_t begin = c * chunk;
+                try {
+                    (*body)(begin, std::min(begin + chunk, n));
+                } catch (...) {
+                    std::scoped_lock lk(mtx);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                    failed.store(true, std::memory_order_relaxed);
+                }
+            }
+            if (done.fetch_add(1) + 1 == n_chunks) {
+                std::scoped_lock lk(mtx);
+                cv.notify_all();
+            }
+        }
+    }
+};
+
+} // namespace
+
+ThreadPool::ThreadPool(unsigned int n_workers, bool pin_to_cores) : pin_to_cores_(pin_to_cores) {
+    if (n_workers == 0) {
+        n_workers = std::max(1U, std::thread::hardware_concurrency());
+    }
+    workers_.reserve(n_workers);
+    for (unsigned int i = 0; i < n_workers; ++i) {
+        workers_.emplace_back([this, i](std::stop_token st) { run(st, i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    for (auto& w : workers_) {
+        w.request_stop();
+    }
+    cv_.notify_all();
+    workers_.clear(); // join before mutex_/cv_ are destroyed
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::scoped_lock lk(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+}
+
+void ThreadPool::parallel_for(size_t n, const std::function<void(size_t, size_t)>& body,
+                              size_t min_chunk) {
+    if (n == 0) {
+        return;
+    }
+    const size_t lanes = workers_.size() + 1; // workers + caller
+    const size_t chunk = std::max(std::max<size_t>(1, min_chunk), (n + lanes - 1) / lanes);
+    const size_t n_chunks = (n + chunk - 1) / chunk;
+    if (n_chunks == 1) {
+        body(0, n);
+        return;
+    }
+
+    auto state = std::make_shared<ForState>();
+    state->body = &body;
+    state->n = n;
+    state->chunk = chunk;
+    state->n_chunks = n_chunks;
+    for (size_t i = 0; i + 1 < n_chunks && i < workers_.size(); ++i) {
+        submit([state]() { state->drain(); });
+    }
+    state->drain();
+
+    std::unique_lock lk(state->mtx);
+    state->cv.wait(lk, [&state]() -> bool { return state->done.load() == state->n_chunks; });
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+void ThreadPool::run(const std::stop_token& st, unsigned int worker_id) {
+    if (pin_to_cores_) {
+        pin_current_thread(worker_id);
+    }
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock lk(mutex_);
+            if (!cv_.wait(lk, st, [this]() -> bool { return !tasks_.empty(); })) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+auto ThreadPool::shared() -> ThreadPool& {
+    static const std::unique_ptr<ThreadPool> pool = []() -> std::unique_ptr<ThreadPool> {
+        SharedConfig& cfg = shared_config();
+        std::scoped_lock lk(cfg.mtx);
+        cfg.created = true;
+        return std::make_unique<ThreadPool>(cfg.n_workers, cfg.pin_to_cores);
+    }();
+    return *pool;
+}
+
+auto ThreadPool::configure_shared(unsigned int n_workers, bool pin_to_cores) -> bool {
+    SharedConfig& cfg = shared_config();
+    std::scoped_lock lk(cfg.mtx);
+    if (cfg.created) {
+        return false;
+    }
+    cfg.n_workers = n_workers;
+    cfg.pin_to_cores = pin_to_cores;
+    return true;
+}
+
+} // namespace utilities
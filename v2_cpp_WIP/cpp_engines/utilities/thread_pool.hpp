@@ -0,0 +1,57 @@
+#pragma once
+
+/**
+ * ThreadPool: long-lived workers shared by apply_frame (IV/Greeks chunks) and the backtest
+ * multi-file runner. parallel_for lets the caller run chunks too, so nested use never deadlocks.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace utilities {
+
+class ThreadPool {
+  public:
+    /** n_workers = 0 → hardware_concurrency; pin_to_cores: worker i bound to core i (Linux). */
+    explicit ThreadPool(unsigned int n_workers = 0, bool pin_to_cores = false);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /** Fire-and-forget task. */
+    void submit(std::function<void()> task);
+
+    /**
+     * Split [0, n) into chunks of at least min_chunk; blocks until all chunks ran. If a chunk
+     * throws, the chunks not yet started are skipped and the first exception is rethrown on the
+     * caller once no chunk is running.
+     */
+    void parallel_for(size_t n, const std::function<void(size_t begin, size_t end)>& body,
+                      size_t min_chunk = 64);
+
+    [[nodiscard]] unsigned int size() const { return static_cast<unsigned int>(workers_.size()); }
+
+    /** Process-wide pool; created on first use with the configure_shared settings. */
+    static ThreadPool& shared();
+    /** Set shared pool size/pinning; returns false once shared() has been created. */
+    static bool configure_shared(unsigned int n_workers, bool pin_to_cores);
+
+  private:
+    void run(const std::stop_token& st, unsigned int worker_id);
+
+    std::vector<std::jthread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable_any cv_;
+    bool pin_to_cores_ = false;
+};
+
+} // namespace utilities
@@ -0,0 +1,223 @@
+#include "timer_wheel.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+namespace utilities {
+
+namespace {
+
+constexpr uint64_t kSlotMask = (uint64_t{1} << 8) - 1;
+
+/** First set bit at or after from; 256 when none. */
+template <typename Bitmap> auto next_set(const Bitmap& bits, size_t from) -> size_t {
+    for (size_t w = from / 64; w < bits.size(); ++w) {
+        uint64_t word = bits[w];
+        if (w == from / 64) {
+            word &= ~uint64_t{0} << (from % 64);
+        }
+        if (word != 0) {
+            return (w * 64) + static_cast<size_t>(std::countr_zero(word));
+        }
+    }
+    return bits.size() * 64;
+}
+
+} // namespace
+
+auto TimerWheel::add(std::chrono::milliseconds period, Callback fn) -> TimerId {
+    std::scoped_lock lock(mutex_);
+    uint32_t index = 0;
+    if (!free_.empty()) {
+        index = free_.back();
+        free_.pop_back();
+    } else {
+        index = static_cast<uint32_t>(timers_.size());
+        timers_.emplace_back();
+    }
+    Timer& t = timers_[index];
+    t.period = static_cast<uint64_t>(std::max<int64_t>(period.count(), 1));
+    t.order = next_order_++;
+    t.active = true;
+    t.fn = std::move(fn);
+    ++live_;
+    // Before the first advance now_ is 0, i.e. the origin-to-be.
+    t.deadline = ((now_ / t.period) + 1) * t.period;
+    insert(index);
+    return (static_cast<TimerId>(t.generation) << 32) | index;
+}
+
+auto TimerWheel::cancel(TimerId id) -> bool {
+    std::scoped_lock lock(mutex_);
+    if (!alive(id)) {
+        return false;
+    }
+    Timer& t = timers_[static_cast<uint32_t>(id)];
+    // Slots keep the index until they are processed; the bumped generation marks it stale.
+    t.active = false;
+    t.fn = nullptr;
+    ++t.generation;
+    --live_;
+    return true;
+}
+
+auto TimerWheel::alive(TimerId id) const -> bool {
+    const auto index = static_cast<uint32_t>(id);
+    return index < timers_.size() && timers_[index].active &&
+           timers_[index].generation == static_cast<uint32_t>(id >> 32);
+}
+
+void TimerWheel::insert(uint32_t index) {
+    const uint64_t deadline = timers_[index].deadline;
+    if (deadline <= now_) {
+        ready_.push_back(index);
+        return;
+    }
+    // Level = highest 8-bit digit in which deadline and now_ differ.
+    const int level = (std::bit_width(deadline ^ now_) - 1) / kSlotBits;
+    if (level >= kLevels) {
+        far_.push_back(index);
+        return;
+    }
+    const size_t slot = (deadline >> (level * kSlotBits)) & kSlotMask;
+    slots_[level][slot].push_back(index);
+    occupied_[level][slot / 64] |= uint64_t{1} << (slot % 64);
+}
+
+auto TimerWheel::next_tick() const -> std::optional<uint64_t> {
+    std::optional<uint64_t> best;
+    for (int level = 0; level < kLevels; ++level) {
+        const int shift = level * kSlotBits;
+        const size_t digit = (now_ >> shift) & kSlotMask;
+        const size_t slot = next_set(occupied_[level], digit + 1);
+        if (slot < kSlots) {
+            const uint64_t block = (now_ >> (shift + kSlotBits)) << (shift + kSlotBits);
+            const uint64_t tick = block | (static_cast<uint64_t>(slot) << shift);
+            best = best ? std::min(*best, tick) : tick;
+        }
+    }
+    if (!far_.empty()) {
+        const uint64_t wrap = ((now_ >> (kLevels * kSlotBits)) + 1) << (kLevels * kSlotBits);
+        best = best ? std::min(*best, wrap) : wrap;
+    }
+    return best;
+}
+
+void TimerWheel::cascade(int level) {
+    const size_t slot = (now_ >> (level * kSlotBits)) & kSlotMask;
+    if ((occupied_[level][slot / 64] & (uint64_t{1} << (slot % 64))) == 0) {
+        return;
+    }
+    occupied_[level][slot / 64] &= ~(uint64_t{1} << (slot % 64));
+    std::vector<uint32_t> moved = std::move(slots_[level][slot]);
+    slots_[level][slot].clear();
+    for (uint32_t index : moved) {
+        insert(index);
+    }
+}
+
+void TimerWheel::collect(std::vector<uint32_t>& due, std::vector<uint32_t>& bucket) {
+    std::vector<uint32_t> items = std::move(bucket);
+    bucket.clear();
+    for (uint32_t index : items) {
+        // A cancelled timer's index sits in exactly one bucket; reuse it once that is drained.
+        if (timers_[index].active) {
+            due.push_back(index);
+        } else {
+            free_.push_back(index);
+        }
+    }
+}
+
+auto TimerWheel::advance(std::chrono::milliseconds now) -> size_t {
+    struct Fire {
+        uint64_t deadline;
+        uint64_t order;
+        TimerId id;
+        Callback fn;
+    };
+    std::vector<Fire> fire;
+    {
+        std::scoped_lock lock(mutex_);
+        if (!origin_) {
+            origin_ = now.count();
+        }
+        const int64_t rel = now.count() - *origin_;
+        const uint64_t to = rel > 0 ? static_cast<uint64_t>(rel) : 0;
+        std::vector<uint32_t> due;
+        collect(due, ready_);
+        while (true) {
+            const std::optional<uint64_t> tick = next_tick();
+            if (!tick || *tick > to) {
+                break;
+            }
+            now_ = *tick;
+            if ((now_ & ((uint64_t{1} << (kLevels * kSlotBits)) - 1)) == 0) {
+                std::vector<uint32_t> far = std::move(far_);
+                far_.clear();
+                for (uint32_t index : far) {
+                    insert(index);
+                }
+            }
+            for (int level = kLevels - 1; level > 0; --level) {
+                if ((now_ & ((uint64_t{1} << (level * kSlotBits)) - 1)) == 0) {
+                    cascade(level);
+                }
+            }
+            const size_t slot = now_ & kSlotMask;
+            occupied_[0][slot / 64] &= ~(uint64_t{1} << (slot % 64));
+            collect(due, slots_[0][slot]);
+            collect(due, ready_);
+        }
+        now_ = std::max(now_, to);
+        for (uint32_t index : due) {
+            Timer& t = timers_[index];
+            fire.push_back({.deadline = t.deadline,
+                            .order = t.order,
+                            .id = (static_cast<TimerId>(t.generation) << 32) | index,
+                            .fn = t.fn});
+            // Next period strictly after now: a late advance skips missed periods.
+            const uint64_t behind = now_ >= t.deadline ? (now_ - t.deadline) / t.period : 0;
+            t.deadline += (behind + 1) * t.period;
+            insert(index);
+        }
+    }
+    std::ranges::sort(fire, [](const Fire& a, const Fire& b) -> bool {
+        return a.deadline != b.deadline ? a.deadline < b.deadline : a.order < b.order;
+    });
+    size_t fired = 0;
+    for (const Fire& f : fire) {
+        {
+            std::scoped_lock lock(mutex_);
+            if (!alive(f.id)) {
+                continue; // cancelled by an earlier callback
+            }
+        }
+        f.fn();
+        ++fired;
+    }
+    return fired;
+}
+
+auto TimerWheel::next_due() const -> std::optional<std::chrono::milliseconds> {
+    std::scoped_lock lock(mutex_);
+    if (live_ == 0) {
+        return std::nullopt;
+    }
+    if (!origin_ || !ready_.empty()) {
+        return std::chrono::milliseconds::min();
+    }
+    const std::optional<uint64_t> tick = next_tick();
+    if (!tick) {
+        return std::nullopt;
+    }
+    return std::chrono::milliseconds(*origin_ + static_cast<int64_t>(*tick));
+}
+
+auto TimerWheel::size() const -> size_t {
+    std::scoped_lock lock(mutex_);
+    return live_;
+}
+
+} // namespace utilities
@@ -0,0 +1,85 @@
+#pragma once
+
+/**
+ * TimerWheel: hierarchical timing wheel (4 levels x 256 slots, 1 ms resolution) for periodic
+ * callbacks. Time is whatever clock the runtime advances it with (wall time live, bar time in
+ * backtest); advance() fires only the timers that came due, in deadline then registration order.
+ * Each timer fires at most once per advance(): a runtime that fell behind skips missed periods
+ * instead of bursting.
+ */
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace utilities {
+
+class TimerWheel {
+  public:
+    using TimerId = uint64_t;
+    using Callback = std::function<void()>;
+
+    TimerWheel() = default;
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    /**
+     * Periodic callback (period >= 1 ms), due at every multiple of period after the origin (the
+     * first advance()); the first run is one period after the origin or the current wheel time.
+     */
+    TimerId add(std::chrono::milliseconds period, Callback fn);
+    /** False if id is unknown or already cancelled. */
+    bool cancel(TimerId id);
+
+    /** Run callbacks due at or before now on this thread; the first call sets the origin. */
+    size_t advance(std::chrono::milliseconds now);
+
+    /** Earliest time a timer may be due (never later than the real deadline); nullopt if none. */
+    [[nodiscard]] std::optional<std::chrono::milliseconds> next_due() const;
+    [[nodiscard]] size_t size() const;
+
+  private:
+    static constexpr int kLevels = 4;
+    static constexpr int kSlotBits = 8;
+    static constexpr size_t kSlots = size_t{1} << kSlotBits;
+
+    struct Timer {
+        uint64_t deadline = 0; // ms since origin
+        uint64_t period = 1;
+        uint64_t order = 0; // registration sequence (tie-break)
+        uint32_t generation = 0;
+        bool active = false;
+        Callback fn;
+    };
+    using Bitmap = std::array<uint64_t, kSlots / 64>;
+
+    void insert(uint32_t index);
+    /** Tick of the next slot to process; nullopt when nothing is scheduled. */
+    [[nodiscard]] std::optional<uint64_t> next_tick() const;
+    /** Move the timers of level's slot at now_ down the wheel (or to ready_). */
+    void cascade(int level);
+    /** Move active timers of bucket to due; free the cancelled ones. */
+    void collect(std::vector<uint32_t>& due, std::vector<uint32_t>& bucket);
+    [[nodiscard]] bool alive(TimerId id) const;
+
+    mutable std::mutex mutex_;
+    std::vector<Timer> timers_;
+    std::vector<uint32_t> free_;
+    std::array<std::array<std::vector<uint32_t>, kSlots>, kLevels> slots_{};
+    std::array<Bitmap, kLevels> occupied_{};
+    /** Deadlines beyond the top level (re-inserted at each top-level wrap). */
+    std::vector<uint32_t> far_;
+    /** Deadline <= now_: fired by the next advance. */
+    std::vector<uint32_t> ready_;
+    std::optional<int64_t> origin_;
+    uint64_t now_ = 0;
+    uint64_t next_order_ = 0;
+    size_t live_ = 0;
+};
+
+} // namespace utilities
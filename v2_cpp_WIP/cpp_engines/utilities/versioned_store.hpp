@@ -0,0 +1,99 @@
+#pragma once
+
+/**
+ * VersionedStore: keyed values stamped with a store-wide sequence number. put() bumps the
+ * sequence only when the value actually changed, so a reader holding sequence S asks for "what
+ * changed after S" and gets exactly the changed keys (removals as tombstones). commit() wakes
+ * subscribers of changes() once per batch of puts.
+ */
+
+#include "broadcast_hub.hpp"
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace utilities {
+
+template <typename T> class VersionedStore {
+  public:
+    VersionedStore() = default;
+    VersionedStore(const VersionedStore&) = delete;
+    VersionedStore& operator=(const VersionedStore&) = delete;
+
+    /** Store value under key; false (no new version) when it equals the current value. */
+    bool put(const std::string& key, T value) {
+        std::scoped_lock lock(mutex_);
+        auto [it, inserted] = entries_.try_emplace(key);
+        if (!inserted && it->second.value.has_value() && *it->second.value == value) {
+            return false;
+        }
+        it->second.value = std::move(value);
+        it->second.version = ++seq_;
+        return true;
+    }
+
+    /** Tombstone key (reported as removed to readers behind this version). */
+    bool erase(const std::string& key) {
+        std::scoped_lock lock(mutex_);
+        auto it = entries_.find(key);
+        if (it == entries_.end() || !it->second.value.has_value()) {
+            return false;
+        }
+        it->second.value.reset();
+        it->second.version = ++seq_;
+        return true;
+    }
+
+    /** Publish the current sequence to changes() if anything changed since the last commit. */
+    void commit() {
+        uint64_t seq = 0;
+        {
+            std::scoped_lock lock(mutex_);
+            if (seq_ == committed_) {
+                return;
+            }
+            committed_ = seq = seq_;
+        }
+        changes_.publish(seq);
+    }
+
+    [[nodiscard]] uint64_t seq() const {
+        std::scoped_lock lock(mutex_);
+        return seq_;
+    }
+
+    /**
+     * f(key, const T* value) for every key changed after since (value nullptr = removed); since 0
+     * lists live values only (full snapshot). Returns the sequence the result is current at.
+     */
+    template <typename F> uint64_t changed_since(uint64_t since, F&& f) const {
+        std::scoped_lock lock(mutex_);
+        for (const auto& [key, entry] : entries_) {
+            if (entry.version <= since || (since == 0 && !entry.value.has_value())) {
+                continue;
+            }
+            f(key, entry.value.has_value() ? &*entry.value : nullptr);
+        }
+        return seq_;
+    }
+
+    /** Committed sequence numbers; subscribe to be woken on change. */
+    BroadcastHub<uint64_t>& changes() { return changes_; }
+
+  private:
+    struct Entry {
+        uint64_t version = 0;
+        std::optional<T> value;
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    uint64_t seq_ = 0;
+    uint64_t committed_ = 0;
+    BroadcastHub<uint64_t> changes_{64};
+};
+
+} // namespace utilities
@@ -0,0 +1,179 @@
+#include "vol_surface.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace utilities {
+
+namespace {
+
+constexpr double kMinSigma = 1e-4;
+constexpr double kMaxSigma = 5.0;
+constexpr int kColdIterations = 200;
+constexpr int kWarmIterations = 40;
+/** Simplex diameter (in m and ln sigma) at which the search stops. */
+constexpr double kSimplexTolerance = 1e-7;
+
+/** Linear part of the fit in the (m, sigma) frame: w ~ a + d * y + c * sqrt(y^2 + 1). */
+struct InnerFit {
+    double a = 0.0;
+    double d = 0.0;
+    double c = 0.0;
+    double sse = 0.0;
+};
+
+/** Least-squares (a, d, c) at (m, s), clamped to b >= 0, |rho| <= 1 and w >= 0. */
+auto solve_inner(std::span<const double> k, std::span<const double> w, double m, double s)
+    -> InnerFit {
+    const auto n = static_cast<double>(k.size());
+    double sy = 0, sz = 0, syy = 0, syz = 0, szz = 0, sw = 0, swy = 0, swz = 0;
+    for (size_t i = 0; i < k.size(); ++i) {
+        const double y = (k[i] - m) / s;
+        const double z = std::sqrt((y * y) + 1.0);
+        sy += y;
+        sz += z;
+        syy += y * y;
+        syz += y * z;
+        szz += z * z;
+        sw += w[i];
+        swy += w[i] * y;
+        swz += w[i] * z;
+    }
+    // Cramer's rule on the 3x3 normal equations [n sy sz; sy syy syz; sz syz szz].
+    const auto det3 = [](double a11, double a12, double a13, double a21, double a22, double a23,
+                         double a31, double a32, double a33) -> double {
+        return (a11 * ((a22 * a33) - (a23 * a32))) - (a12 * ((a21 * a33) - (a23 * a31))) +
+               (a13 * ((a21 * a32) - (a22 * a31)));
+    };
+    const double det = det3(n, sy, sz, sy, syy, syz, sz, syz, szz);
+    InnerFit fit;
+    if (std::abs(det) > 1e-14 * std::max(1.0, n * syy * szz)) {
+        fit.a = det3(sw, sy, sz, swy, syy, syz, swz, syz, szz) / det;
+        fit.d = det3(n, sw, sz, sy, swy, syz, sz, swz, szz) / det;
+        fit.c = det3(n, sy, sw, sy, syy, swy, sz, syz, swz) / det;
+    }
+    fit.c = std::max(fit.c, 0.0);
+    fit.d = std::clamp(fit.d, -fit.c, fit.c);
+    fit.a = (sw - (fit.d * sy) - (fit.c * sz)) / n;
+    // Smallest w is a + sqrt(c^2 - d^2): keep the smile non-negative.
+    fit.a = std::max(fit.a, -std::sqrt((fit.c * fit.c) - (fit.d * fit.d)));
+    for (size_t i = 0; i < k.size(); ++i) {
+        const double y = (k[i] - m) / s;
+        const double r = fit.a + (fit.d * y) + (fit.c * std::sqrt((y * y) + 1.0)) - w[i];
+        fit.sse += r * r;
+    }
+    return fit;
+}
+
+} // namespace
+
+auto SviParams::total_variance(double k) const -> double {
+    const double x = k - m;
+    return a + (b * ((rho * x) + std::sqrt((x * x) + (sigma * sigma))));
+}
+
+auto SviParams::implied_vol(double k, double tau) const -> double {
+    if (!(tau > 0.0)) {
+        return 0.0;
+    }
+    const double var = total_variance(k);
+    return var > 0.0 ? std::sqrt(var / tau) : 0.0;
+}
+
+auto fit_svi(std::span<const double> k, std::span<const double> w, const SviParams& warm)
+    -> SviParams {
+    SviParams out;
+    if (k.size() < kMinSviPoints || k.size() != w.size()) {
+        return out;
+    }
+    const auto [k_min, k_max] = std::ranges::minmax(k);
+    const double m_lo = k_min - 1.0;
+    const double m_hi = k_max + 1.0;
+    using Point = std::array<double, 2>; // (m, ln sigma)
+    const auto clamp_point = [&](Point p) -> Point {
+        return {std::clamp(p[0], m_lo, m_hi),
+                std::clamp(p[1], std::log(kMinSigma), std::log(kMaxSigma))};
+    };
+    const auto objective = [&](const Point& p) -> double {
+        return solve_inner(k, w, p[0], std::exp(p[1])).sse;
+    };
+
+    Point start{};
+    double step_m = 0.1;
+    double step_s = 0.5;
+    int iterations = kColdIterations;
+    if (warm.valid && warm.sigma > 0.0) {
+        start = {warm.m, std::log(warm.sigma)};
+        step_m = 0.02;
+        step_s = 0.1;
+        iterations = kWarmIterations;
+    } else {
+        // Cold: centre on the smile's lowest point.
+        const auto lowest = std::ranges::min_element(w) - w.begin();
+        start = {k[static_cast<size_t>(lowest)], std::log(0.1)};
+    }
+    std::array<Point, 3> simplex{clamp_point(start), clamp_point({start[0] + step_m, start[1]}),
+                                 clamp_point({start[0], start[1] + step_s})};
+    std::array<double, 3> f{};
+    for (size_t i = 0; i < 3; ++i) {
+        f[i] = objective(simplex[i]);
+    }
+    const auto lerp = [&](const Point& from, const Point& to, double t) -> Point {
+        return clamp_point({from[0] + (t * (to[0] - from[0])), from[1] + (t * (to[1] - from[1]))});
+    };
+    for (int it = 0; it < iterations; ++it) {
+        std::array<size_t, 3> order{0, 1, 2};
+        std::ranges::sort(order, [&f](size_t x, size_t y) -> bool { return f[x] < f[y]; });
+        simplex = {simplex[order[0]], simplex[order[1]], simplex[order[2]]};
+        f = {f[order[0]], f[order[1]], f[order[2]]};
+        const double diameter =
+            std::max(std::hypot(simplex[1][0] - simplex[0][0], simplex[1][1] - simplex[0][1]),
+                     std::hypot(simplex[2][0] - simplex[0][0], simplex[2][1] - simplex[0][1]));
+        if (diameter < kSimplexTolerance) {
+            break;
+        }
+        const Point centroid{0.5 * (simplex[0][0] + simplex[1][0]),
+                             0.5 * (simplex[0][1] + simplex[1][1])};
+        const Point reflected = lerp(centroid, simplex[2], -1.0);
+        const double fr = objective(reflected);
+        if (fr < f[0]) {
+            const Point expanded = lerp(centroid, simplex[2], -2.0);
+            const double fe = objective(expanded);
+            simplex[2] = fe < fr ? expanded : reflected;
+            f[2] = std::min(fe, fr);
+        } else if (fr < f[1]) {
+            simplex[2] = reflected;
+            f[2] = fr;
+        } else {
+            const Point contracted = fr < f[2] ? lerp(centroid, reflected, 0.5)
+                                               : lerp(centroid, simplex[2], 0.5);
+            const double fc = objective(contracted);
+            if (fc < std::min(fr, f[2])) {
+                simplex[2] = contracted;
+                f[2] = fc;
+            } else {
+                for (size_t i = 1; i < 3; ++i) {
+                    simplex[i] = lerp(simplex[0], simplex[i], 0.5);
+                    f[i] = objective(simplex[i]);
+                }
+            }
+        }
+    }
+    const size_t best = static_cast<size_t>(std::ranges::min_element(f) - f.begin());
+    const double m = simplex[best][0];
+    const double s = std::exp(simplex[best][1]);
+    const InnerFit inner = solve_inner(k, w, m, s);
+    if (!std::isfinite(inner.sse)) {
+        return out;
+    }
+    out.a = inner.a;
+    out.b = inner.c / s;
+    out.rho = inner.c > 0.0 ? inner.d / inner.c : 0.0;
+    out.m = m;
+    out.sigma = s;
+    out.valid = true;
+    return out;
+}
+
+} // namespace utilities
@@ -0,0 +1,39 @@
+#pragma once
+
+/**
+ * Raw SVI smile w(k) = a + b * (rho * (k - m) + sqrt((k - m)^2 + sigma^2)), with w the total
+ * implied variance iv^2 * tau and k = ln(K / F). fit_svi uses the quasi-explicit split: for fixed
+ * (m, sigma) the rest is a 3x3 linear least-squares solve, and Nelder-Mead searches (m, sigma),
+ * starting from the previous frame's fit when there is one.
+ */
+
+#include <cstddef>
+#include <span>
+
+namespace utilities {
+
+struct SviParams {
+    double a = 0.0;
+    double b = 0.0;
+    double rho = 0.0;
+    double m = 0.0;
+    double sigma = 0.1;
+    /** False: never fitted, or the last fit had too few points (other fields meaningless). */
+    bool valid = false;
+
+    [[nodiscard]] double total_variance(double k) const;
+    /** sqrt(w(k) / tau); 0 for tau <= 0 or a negative w. */
+    [[nodiscard]] double implied_vol(double k, double tau) const;
+};
+
+/** Fewest (k, w) points fit_svi accepts. */
+inline constexpr size_t kMinSviPoints = 5;
+
+/**
+ * Least-squares SVI fit of w over k (same length). A valid warm narrows the search to its
+ * neighbourhood (a frame-to-frame refit); otherwise the search starts cold. Result valid=false
+ * when there are fewer than kMinSviPoints points or no finite fit.
+ */
+SviParams fit_svi(std::span<const double> k, std::span<const double> w, const SviParams& warm);
+
+} // namespace utilities